@@ -77,6 +77,10 @@
 #define OMX_TizoniaIndexParamChromecastSession       OMX_IndexVendorStartUnused + 21 /**< reference: OMX_TIZONIA_PARAM_CHROMECASTSESSIONTYPE */
 #define OMX_TizoniaIndexParamAudioPlexSession        OMX_IndexVendorStartUnused + 22 /**< reference: OMX_TIZONIA_AUDIO_PARAM_PLEXSESSIONTYPE */
 #define OMX_TizoniaIndexParamAudioPlexPlaylist       OMX_IndexVendorStartUnused + 23 /**< reference: OMX_TIZONIA_AUDIO_PARAM_PLEXPLAYLISTTYPE */
+#define OMX_TizoniaIndexConfigAudioRendererBuffering OMX_IndexVendorStartUnused + 24 /**< reference: OMX_TIZONIA_AUDIO_CONFIG_RENDERERBUFFERINGTYPE */
+#define OMX_TizoniaIndexConfigAudioLoudness          OMX_IndexVendorStartUnused + 25 /**< reference: OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE */
+#define OMX_TizoniaIndexConfigAudioEqualizer         OMX_IndexVendorStartUnused + 26 /**< reference: OMX_TIZONIA_AUDIO_CONFIG_EQUALIZERTYPE */
+#define OMX_TizoniaIndexParamAudioEncoderOutputs     OMX_IndexVendorStartUnused + 27 /**< reference: OMX_TIZONIA_AUDIO_PARAM_ENCODEROUTPUTSTYPE */
 
 /**
  * OMX_AUDIO_CODINGTYPE extensions
@@ -547,4 +551,114 @@ typedef struct OMX_TIZONIA_AUDIO_PARAM_PLEXPLAYLISTTYPE {
     OMX_U8 cPlaylistName[OMX_MAX_STRINGNAME_SIZE];
 } OMX_TIZONIA_AUDIO_PARAM_PLEXPLAYLISTTYPE;
 
+/**
+ * Audio renderer components
+ */
+
+/**
+ * Device buffer sizing of a pcm audio renderer. Times are in microseconds; a
+ * value of zero selects the component's default. The sizes actually in use
+ * may differ from the requested ones, depending on what the device
+ * supports. Changes take effect the next time the component transitions to
+ * OMX_StateExecuting. The resulting output latency is reported through
+ * OMX_IndexConfigTimeRenderingDelay.
+ */
+
+typedef struct OMX_TIZONIA_AUDIO_CONFIG_RENDERERBUFFERINGTYPE {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+    OMX_U32 nBufferTime;         /**< Overall device buffer time (us) */
+    OMX_U32 nPeriodTime;         /**< Device period time (us) */
+} OMX_TIZONIA_AUDIO_CONFIG_RENDERERBUFFERINGTYPE;
+
+/**
+ * Loudness normalisation of the stream being rendered by a pcm audio
+ * renderer. Levels are in millibels (1/100 dB); loudness is in 1/100 LU.
+ *
+ * The client sets the normalisation gain (e.g. from ReplayGain tags or from
+ * a previous analysis) before the stream starts; the gain is reduced if
+ * needed so that nPeak stays below full scale. When no gain is known, the
+ * client may instead request that the stream's loudness is measured (EBU
+ * R128) while it is rendered; the results are read back with GetConfig once
+ * the stream has ended. The measurement is discarded when the port is
+ * flushed (e.g. after a seek).
+ */
+
+typedef struct OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+    OMX_S32 nGain;               /**< Normalisation gain (mB). Default: 0 */
+    OMX_S32 nPeak;               /**< Peak level of the stream (mB, relative
+                                      to full scale). Default: 0 */
+    OMX_BOOL bAnalyse;           /**< Measure the stream. Default: OMX_FALSE */
+    OMX_S32 nLoudness;           /**< Read-only: integrated loudness
+                                      (1/100 LUFS) */
+    OMX_S32 nTruePeak;           /**< Read-only: true-peak level (mB) */
+    OMX_U32 nMeasured;           /**< Read-only: duration measured (ms);
+                                      zero if nothing was measured */
+} OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE;
+
+/**
+ * Audio processor components
+ */
+
+/**
+ * Parametric equalizer: a cascade of second-order filters, applied to all
+ * the channels of the stream. Changes take effect while the stream plays;
+ * the filters move to their new settings over a few milliseconds, so that
+ * they can be adjusted without clicks.
+ */
+
+#define OMX_TIZONIA_AUDIO_MAX_EQ_BANDS 10
+
+typedef enum OMX_TIZONIA_AUDIO_EQFILTERTYPE {
+    OMX_AUDIO_EqFilterPeaking = 0, /**< Boost or cut around nFrequency */
+    OMX_AUDIO_EqFilterLowShelf,    /**< Boost or cut below nFrequency */
+    OMX_AUDIO_EqFilterHighShelf,   /**< Boost or cut above nFrequency */
+    OMX_AUDIO_EqFilterLowPass,     /**< 12dB/octave low-pass; nGain is ignored */
+    OMX_AUDIO_EqFilterHighPass,    /**< 12dB/octave high-pass; nGain is ignored */
+    OMX_AUDIO_EqFilterKhronosExtensions = 0x6F000000, /**< Reserved region for introducing Khronos Standard Extensions */
+    OMX_AUDIO_EqFilterVendorStartUnused = 0x7F000000, /**< Reserved region for introducing Vendor Extensions */
+    OMX_AUDIO_EqFilterMax = 0x7FFFFFFF
+} OMX_TIZONIA_AUDIO_EQFILTERTYPE;
+
+typedef struct OMX_TIZONIA_AUDIO_EQBANDTYPE {
+    OMX_TIZONIA_AUDIO_EQFILTERTYPE eFilter;
+    OMX_BOOL bEnable;            /**< Default: OMX_FALSE */
+    OMX_U32 nFrequency;          /**< Centre or corner frequency (Hz) */
+    OMX_S32 nGain;               /**< Boost or cut (mB) */
+    OMX_U32 nQ;                  /**< Quality factor, in hundredths (e.g. 71
+                                      for a Butterworth response) */
+} OMX_TIZONIA_AUDIO_EQBANDTYPE;
+
+typedef struct OMX_TIZONIA_AUDIO_CONFIG_EQUALIZERTYPE {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+    OMX_BOOL bEnable;            /**< Default: OMX_TRUE */
+    OMX_U32 nBands;              /**< Bands in use. Default: 0 */
+    OMX_TIZONIA_AUDIO_EQBANDTYPE sBands[OMX_TIZONIA_AUDIO_MAX_EQ_BANDS];
+} OMX_TIZONIA_AUDIO_CONFIG_EQUALIZERTYPE;
+
+/**
+ * Audio encoder components
+ */
+
+/**
+ * The number of output ports in use on an encoder that can produce several
+ * encodings of the same input at once (e.g. one per bitrate). Output ports
+ * are numbered from the first output port upwards; those beyond nOutputs
+ * are disabled. Only settable in OMX_StateLoaded. Each encoding is then
+ * configured on its own output port (e.g. through OMX_IndexParamAudioMp3).
+ */
+
+typedef struct OMX_TIZONIA_AUDIO_PARAM_ENCODEROUTPUTSTYPE {
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nOutputs;            /**< Output ports in use. Default: 1 */
+    OMX_U32 nMaxOutputs;         /**< Read-only: output ports available */
+} OMX_TIZONIA_AUDIO_PARAM_ENCODEROUTPUTSTYPE;
+
 #endif /* OMX_TizoniaExt_h */
@@ -34,6 +34,7 @@
 
 #include <tizplatform.h>
 
+#include "tizscheduler.h"
 #include "tizutils.h"
 #include "tizpcmport.h"
 #include "tizpcmport_decls.h"
@@ -156,6 +157,8 @@ pcmport_ctor (void * ap_obj, va_list * app)
     tiz_port_register_index (p_obj, OMX_IndexConfigAudioVolume));
   tiz_check_omx_ret_null (
     tiz_port_register_index (p_obj, OMX_IndexConfigAudioMute));
+  tiz_check_omx_ret_null (
+    tiz_port_register_index (p_obj, OMX_TizoniaIndexConfigAudioLoudness));
 
   /* Initialize the OMX_AUDIO_PARAM_PCMMODETYPE structure */
   if ((p_pcmmode = va_arg (*app, OMX_AUDIO_PARAM_PCMMODETYPE *)))
@@ -188,6 +191,10 @@ pcmport_ctor (void * ap_obj, va_list * app)
       p_obj->mute_ = *p_mute;
     }
 
+  /* No normalisation, and no measurements */
+  TIZ_INIT_OMX_STRUCT (p_obj->loudness_);
+  p_obj->loudness_.bAnalyse = OMX_FALSE;
+
   /* TODO: Extract this from the va_list */
   p_base->portdef_.eDomain = OMX_PortDomainAudio;
   /* NOTE: MIME type is gone in 1.2 */
@@ -325,6 +332,17 @@ pcmport_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
 
       default:
         {
+          if (OMX_TizoniaIndexConfigAudioLoudness == a_index)
+            {
+              OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE * p_loudness = ap_struct;
+              *p_loudness = p_obj->loudness_;
+              p_loudness->nPortIndex = tiz_port_index (ap_obj);
+              /* Only the processor knows about the measurements, if it
+                 takes any */
+              (void) tiz_api_GetConfig (tiz_get_prc (ap_hdl), ap_hdl, a_index,
+                                        ap_struct);
+              break;
+            }
           /* Try the parent's indexes */
           return super_GetConfig (typeOf (ap_obj, "tizpcmport"), ap_obj, ap_hdl,
                                   a_index, ap_struct);
@@ -382,6 +400,16 @@ pcmport_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
 
       default:
         {
+          if (OMX_TizoniaIndexConfigAudioLoudness == a_index)
+            {
+              /* The measurement fields are read-only */
+              const OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE * p_loudness
+                = (OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE *) ap_struct;
+              p_obj->loudness_.nGain = p_loudness->nGain;
+              p_obj->loudness_.nPeak = p_loudness->nPeak;
+              p_obj->loudness_.bAnalyse = p_loudness->bAnalyse;
+              break;
+            }
           /* Try the parent's indexes */
           rc = super_SetConfig (typeOf (ap_obj, "tizpcmport"), ap_obj, ap_hdl,
                                 a_index, ap_struct);
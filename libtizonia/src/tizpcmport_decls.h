@@ -33,6 +33,8 @@
 extern "C" {
 #endif
 
+#include <OMX_TizoniaExt.h>
+
 #include "tizaudioport_decls.h"
 
 typedef struct tiz_pcmport tiz_pcmport_t;
@@ -43,6 +45,7 @@ struct tiz_pcmport
   OMX_AUDIO_PARAM_PCMMODETYPE pcmmode_;
   OMX_AUDIO_CONFIG_VOLUMETYPE volume_;
   OMX_AUDIO_CONFIG_MUTETYPE mute_;
+  OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE loudness_;
 };
 
 typedef struct tiz_pcmport_class tiz_pcmport_class_t;
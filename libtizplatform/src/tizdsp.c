@@ -0,0 +1,2772 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizdsp.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia Platform - PCM processing kernels
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <OMX_Types.h>
+
+#include "tizplatform.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TIZ_DSP_X86
+#include <immintrin.h>
+#define TIZ_DSP_TARGET(isa) __attribute__ ((target (isa)))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define TIZ_DSP_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.platform.dsp"
+#endif
+
+#define TIZ_DSP_S16_SCALE 32768.0f
+#define TIZ_DSP_S24_SCALE 8388608.0f
+#define TIZ_DSP_S32_SCALE 2147483648.0
+#define TIZ_DSP_DITHER_SEED 0x9e3779b9
+#define TIZ_DSP_RESAMPLER_MAX_PHASES 1024
+#define TIZ_DSP_RESAMPLER_BLOCK_FRAMES 1024
+#define TIZ_DSP_LOUDNESS_MAX_CHANNELS 8
+#define TIZ_DSP_LOUDNESS_OVERSAMPLING 4
+#define TIZ_DSP_LOUDNESS_TP_TAPS 16
+#define TIZ_DSP_LOUDNESS_CHUNK_FRAMES 256
+#define TIZ_DSP_LOUDNESS_MIN_LUFS -70.0
+#define TIZ_DSP_LOUDNESS_MAX_LUFS 30.0
+#define TIZ_DSP_LOUDNESS_BINS_PER_LU 10
+#define TIZ_DSP_EQ_MAX_CHANNELS 8
+#define TIZ_DSP_EQ_MAX_SECTIONS 16
+#define TIZ_DSP_EQ_MAX_FIR_TAPS 4096
+#define TIZ_DSP_EQ_BLOCK_FRAMES 64
+
+/* The kernels that have SIMD implementations */
+typedef struct dsp_kernels dsp_kernels_t;
+struct dsp_kernels
+{
+  tiz_dsp_simd_t simd;
+  void (*gain_s16) (int16_t *, const size_t, const float);
+  void (*gain_s16_q12) (int16_t *, const size_t, const int16_t);
+  void (*gain_f32) (float *, const size_t, const float);
+  void (*s16_to_f32) (float *, const int16_t *, const size_t);
+  void (*f32_to_s16) (int16_t *, const float *, const size_t);
+  void (*fixed_to_s16) (int16_t *, const int32_t *, const size_t,
+                        const unsigned int);
+  void (*interleave2_s16) (int16_t *, const int16_t *, const int16_t *,
+                           const size_t);
+  void (*interleave2_f32) (float *, const float *, const float *,
+                           const size_t);
+  void (*deinterleave2_f32) (float *, float *, const float *, const size_t);
+  void (*bswap16) (uint16_t *, const size_t);
+  void (*bswap32) (uint32_t *, const size_t);
+  float (*dot_f32) (const float *, const float *, const size_t);
+  void (*mix_f32) (float *, const float *, const size_t, const float);
+  void (*biquad4_f32) (float *, const size_t, const float *, float *);
+  void (*interleave2_s32_to_s16) (int16_t *, const int32_t *, const int32_t *,
+                                  const size_t);
+};
+
+static pthread_once_t g_dsp_once = PTHREAD_ONCE_INIT;
+static const dsp_kernels_t * gp_dsp = NULL;
+
+/*
+ * Portable kernels. These also process the tails left by the SIMD kernels,
+ * and they produce exactly the same results.
+ */
+
+static inline int16_t
+float_to_s16 (float a_value)
+{
+  if (a_value < -32768.0f)
+    {
+      a_value = -32768.0f;
+    }
+  else if (a_value > 32767.0f)
+    {
+      a_value = 32767.0f;
+    }
+  return (int16_t) lrintf (a_value);
+}
+
+static inline int16_t
+s32_to_s16_sat (const int32_t a_value)
+{
+  return (a_value > 32767) ? 32767 : ((a_value < -32768) ? -32768 : a_value);
+}
+
+static void
+gain_s16_c (int16_t * ap_samples, const size_t a_nsamples, const float a_gain)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_samples[i] = float_to_s16 (ap_samples[i] * a_gain);
+    }
+}
+
+static void
+gain_s16_q12_c (int16_t * ap_samples, const size_t a_nsamples,
+                const int16_t a_gain_q12)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      const int32_t v = (int32_t) ap_samples[i] * a_gain_q12;
+      ap_samples[i] = s32_to_s16_sat ((v + 2048) >> 12);
+    }
+}
+
+static void
+gain_f32_c (float * ap_samples, const size_t a_nsamples, const float a_gain)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_samples[i] *= a_gain;
+    }
+}
+
+static void
+s16_to_f32_c (float * ap_dst, const int16_t * ap_src, const size_t a_nsamples)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_dst[i] = ap_src[i] * (1.0f / TIZ_DSP_S16_SCALE);
+    }
+}
+
+static void
+f32_to_s16_c (int16_t * ap_dst, const float * ap_src, const size_t a_nsamples)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_dst[i] = float_to_s16 (ap_src[i] * TIZ_DSP_S16_SCALE);
+    }
+}
+
+static void
+fixed_to_s16_c (int16_t * ap_dst, const int32_t * ap_src,
+                const size_t a_nsamples, const unsigned int a_fracbits)
+{
+  /* Round half up without overflowing: (((x >> (n - 1)) + 1) >> 1) */
+  const unsigned int shift = a_fracbits - 16;
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_dst[i] = s32_to_s16_sat (((ap_src[i] >> shift) + 1) >> 1);
+    }
+}
+
+static void
+interleave2_s16_c (int16_t * ap_dst, const int16_t * ap_l,
+                   const int16_t * ap_r, const size_t a_nframes)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      ap_dst[2 * i] = ap_l[i];
+      ap_dst[2 * i + 1] = ap_r[i];
+    }
+}
+
+static void
+interleave2_s32_to_s16_c (int16_t * ap_dst, const int32_t * ap_l,
+                          const int32_t * ap_r, const size_t a_nframes)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      ap_dst[2 * i] = s32_to_s16_sat (ap_l[i]);
+      ap_dst[2 * i + 1] = s32_to_s16_sat (ap_r[i]);
+    }
+}
+
+static void
+interleave2_f32_c (float * ap_dst, const float * ap_l, const float * ap_r,
+                   const size_t a_nframes)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      ap_dst[2 * i] = ap_l[i];
+      ap_dst[2 * i + 1] = ap_r[i];
+    }
+}
+
+static void
+deinterleave2_f32_c (float * ap_l, float * ap_r, const float * ap_src,
+                     const size_t a_nframes)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i)
+    {
+      ap_l[i] = ap_src[2 * i];
+      ap_r[i] = ap_src[2 * i + 1];
+    }
+}
+
+static void
+bswap16_c (uint16_t * ap_samples, const size_t a_nsamples)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_samples[i] = (uint16_t) ((ap_samples[i] << 8) | (ap_samples[i] >> 8));
+    }
+}
+
+static void
+bswap32_c (uint32_t * ap_samples, const size_t a_nsamples)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      const uint32_t v = ap_samples[i];
+      ap_samples[i] = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000)
+                      | (v << 24);
+    }
+}
+
+/* The vector lengths are a multiple of 8. Eight partial sums are kept, and
+   reduced in the same order as the SIMD implementations do, so the results
+   only differ if the compiler contracts multiplies and adds */
+static float
+dot_f32_c (const float * ap_a, const float * ap_b, const size_t a_len)
+{
+  float s[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+  size_t i = 0;
+  size_t j = 0;
+  for (i = 0; i < a_len; i += 8)
+    {
+      for (j = 0; j < 8; ++j)
+        {
+          s[j] += ap_a[i + j] * ap_b[i + j];
+        }
+    }
+  for (j = 0; j < 4; ++j)
+    {
+      s[j] += s[j + 4];
+    }
+  return (s[0] + s[2]) + (s[1] + s[3]);
+}
+
+static void
+mix_f32_c (float * ap_dst, const float * ap_src, const size_t a_nsamples,
+           const float a_gain)
+{
+  size_t i = 0;
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_dst[i] += ap_src[i] * a_gain;
+    }
+}
+
+/* One transposed direct form II section, run on frames of four channels.
+   ap_c holds b0, b1, b2, a1 and a2; ap_z holds the four channels' first
+   state variables, followed by their second ones */
+static void
+biquad4_f32_c (float * ap_x, const size_t a_nframes, const float * ap_c,
+               float * ap_z)
+{
+  size_t i = 0;
+  size_t j = 0;
+  for (i = 0; i < a_nframes; ++i, ap_x += 4)
+    {
+      for (j = 0; j < 4; ++j)
+        {
+          const float x = ap_x[j];
+          const float y = ap_c[0] * x + ap_z[j];
+          ap_z[j] = (ap_c[1] * x - ap_c[3] * y) + ap_z[4 + j];
+          ap_z[4 + j] = ap_c[2] * x - ap_c[4] * y;
+          ap_x[j] = y;
+        }
+    }
+}
+
+static const dsp_kernels_t g_dsp_c = {
+  TIZ_DSP_SIMD_NONE,  gain_s16_c,        gain_s16_q12_c,
+  gain_f32_c,         s16_to_f32_c,      f32_to_s16_c,
+  fixed_to_s16_c,     interleave2_s16_c, interleave2_f32_c,
+  deinterleave2_f32_c, bswap16_c,        bswap32_c,
+  dot_f32_c,          mix_f32_c,         biquad4_f32_c,
+  interleave2_s32_to_s16_c
+};
+
+#ifdef TIZ_DSP_X86
+
+/*
+ * SSE2 kernels
+ */
+
+TIZ_DSP_TARGET ("sse2")
+static inline __m128i
+sse2_f32_to_s16 (__m128 a_lo, __m128 a_hi)
+{
+  /* Clamp first, so that out of range values don't turn into INT_MIN */
+  const __m128 max = _mm_set1_ps (32767.0f);
+  const __m128 min = _mm_set1_ps (-32768.0f);
+  a_lo = _mm_max_ps (_mm_min_ps (a_lo, max), min);
+  a_hi = _mm_max_ps (_mm_min_ps (a_hi, max), min);
+  return _mm_packs_epi32 (_mm_cvtps_epi32 (a_lo), _mm_cvtps_epi32 (a_hi));
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+gain_s16_sse2 (int16_t * ap_samples, const size_t a_nsamples,
+               const float a_gain)
+{
+  const __m128 gain = _mm_set1_ps (a_gain);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m128i v = _mm_loadu_si128 ((const __m128i *) (ap_samples + i));
+      const __m128i lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16);
+      const __m128i hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16);
+      _mm_storeu_si128 (
+        (__m128i *) (ap_samples + i),
+        sse2_f32_to_s16 (_mm_mul_ps (_mm_cvtepi32_ps (lo), gain),
+                         _mm_mul_ps (_mm_cvtepi32_ps (hi), gain)));
+    }
+  gain_s16_c (ap_samples + i, a_nsamples - i, a_gain);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+gain_s16_q12_sse2 (int16_t * ap_samples, const size_t a_nsamples,
+                   const int16_t a_gain_q12)
+{
+  const __m128i gain = _mm_set1_epi16 (a_gain_q12);
+  const __m128i round = _mm_set1_epi32 (2048);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m128i v = _mm_loadu_si128 ((const __m128i *) (ap_samples + i));
+      const __m128i plo = _mm_mullo_epi16 (v, gain);
+      const __m128i phi = _mm_mulhi_epi16 (v, gain);
+      __m128i lo = _mm_unpacklo_epi16 (plo, phi);
+      __m128i hi = _mm_unpackhi_epi16 (plo, phi);
+      lo = _mm_srai_epi32 (_mm_add_epi32 (lo, round), 12);
+      hi = _mm_srai_epi32 (_mm_add_epi32 (hi, round), 12);
+      _mm_storeu_si128 ((__m128i *) (ap_samples + i),
+                        _mm_packs_epi32 (lo, hi));
+    }
+  gain_s16_q12_c (ap_samples + i, a_nsamples - i, a_gain_q12);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+gain_f32_sse2 (float * ap_samples, const size_t a_nsamples, const float a_gain)
+{
+  const __m128 gain = _mm_set1_ps (a_gain);
+  size_t i = 0;
+  for (; i + 4 <= a_nsamples; i += 4)
+    {
+      _mm_storeu_ps (ap_samples + i,
+                     _mm_mul_ps (_mm_loadu_ps (ap_samples + i), gain));
+    }
+  gain_f32_c (ap_samples + i, a_nsamples - i, a_gain);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+s16_to_f32_sse2 (float * ap_dst, const int16_t * ap_src,
+                 const size_t a_nsamples)
+{
+  const __m128 scale = _mm_set1_ps (1.0f / TIZ_DSP_S16_SCALE);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m128i v = _mm_loadu_si128 ((const __m128i *) (ap_src + i));
+      const __m128i lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16);
+      const __m128i hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (v, v), 16);
+      _mm_storeu_ps (ap_dst + i, _mm_mul_ps (_mm_cvtepi32_ps (lo), scale));
+      _mm_storeu_ps (ap_dst + i + 4, _mm_mul_ps (_mm_cvtepi32_ps (hi), scale));
+    }
+  s16_to_f32_c (ap_dst + i, ap_src + i, a_nsamples - i);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+f32_to_s16_sse2 (int16_t * ap_dst, const float * ap_src,
+                 const size_t a_nsamples)
+{
+  const __m128 scale = _mm_set1_ps (TIZ_DSP_S16_SCALE);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      _mm_storeu_si128 (
+        (__m128i *) (ap_dst + i),
+        sse2_f32_to_s16 (_mm_mul_ps (_mm_loadu_ps (ap_src + i), scale),
+                         _mm_mul_ps (_mm_loadu_ps (ap_src + i + 4), scale)));
+    }
+  f32_to_s16_c (ap_dst + i, ap_src + i, a_nsamples - i);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+fixed_to_s16_sse2 (int16_t * ap_dst, const int32_t * ap_src,
+                   const size_t a_nsamples, const unsigned int a_fracbits)
+{
+  const __m128i shift = _mm_cvtsi32_si128 (a_fracbits - 16);
+  const __m128i one = _mm_set1_epi32 (1);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      __m128i lo = _mm_loadu_si128 ((const __m128i *) (ap_src + i));
+      __m128i hi = _mm_loadu_si128 ((const __m128i *) (ap_src + i + 4));
+      lo = _mm_srai_epi32 (_mm_add_epi32 (_mm_sra_epi32 (lo, shift), one), 1);
+      hi = _mm_srai_epi32 (_mm_add_epi32 (_mm_sra_epi32 (hi, shift), one), 1);
+      _mm_storeu_si128 ((__m128i *) (ap_dst + i), _mm_packs_epi32 (lo, hi));
+    }
+  fixed_to_s16_c (ap_dst + i, ap_src + i, a_nsamples - i, a_fracbits);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+interleave2_s16_sse2 (int16_t * ap_dst, const int16_t * ap_l,
+                      const int16_t * ap_r, const size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nframes; i += 8)
+    {
+      const __m128i l = _mm_loadu_si128 ((const __m128i *) (ap_l + i));
+      const __m128i r = _mm_loadu_si128 ((const __m128i *) (ap_r + i));
+      _mm_storeu_si128 ((__m128i *) (ap_dst + 2 * i),
+                        _mm_unpacklo_epi16 (l, r));
+      _mm_storeu_si128 ((__m128i *) (ap_dst + 2 * i + 8),
+                        _mm_unpackhi_epi16 (l, r));
+    }
+  interleave2_s16_c (ap_dst + 2 * i, ap_l + i, ap_r + i, a_nframes - i);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+interleave2_s32_to_s16_sse2 (int16_t * ap_dst, const int32_t * ap_l,
+                             const int32_t * ap_r, const size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nframes; i += 8)
+    {
+      const __m128i l
+        = _mm_packs_epi32 (_mm_loadu_si128 ((const __m128i *) (ap_l + i)),
+                           _mm_loadu_si128 ((const __m128i *) (ap_l + i + 4)));
+      const __m128i r
+        = _mm_packs_epi32 (_mm_loadu_si128 ((const __m128i *) (ap_r + i)),
+                           _mm_loadu_si128 ((const __m128i *) (ap_r + i + 4)));
+      _mm_storeu_si128 ((__m128i *) (ap_dst + 2 * i),
+                        _mm_unpacklo_epi16 (l, r));
+      _mm_storeu_si128 ((__m128i *) (ap_dst + 2 * i + 8),
+                        _mm_unpackhi_epi16 (l, r));
+    }
+  interleave2_s32_to_s16_c (ap_dst + 2 * i, ap_l + i, ap_r + i,
+                            a_nframes - i);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+interleave2_f32_sse2 (float * ap_dst, const float * ap_l, const float * ap_r,
+                      const size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_nframes; i += 4)
+    {
+      const __m128 l = _mm_loadu_ps (ap_l + i);
+      const __m128 r = _mm_loadu_ps (ap_r + i);
+      _mm_storeu_ps (ap_dst + 2 * i, _mm_unpacklo_ps (l, r));
+      _mm_storeu_ps (ap_dst + 2 * i + 4, _mm_unpackhi_ps (l, r));
+    }
+  interleave2_f32_c (ap_dst + 2 * i, ap_l + i, ap_r + i, a_nframes - i);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+deinterleave2_f32_sse2 (float * ap_l, float * ap_r, const float * ap_src,
+                        const size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_nframes; i += 4)
+    {
+      const __m128 a = _mm_loadu_ps (ap_src + 2 * i);
+      const __m128 b = _mm_loadu_ps (ap_src + 2 * i + 4);
+      _mm_storeu_ps (ap_l + i, _mm_shuffle_ps (a, b, _MM_SHUFFLE (2, 0, 2, 0)));
+      _mm_storeu_ps (ap_r + i, _mm_shuffle_ps (a, b, _MM_SHUFFLE (3, 1, 3, 1)));
+    }
+  deinterleave2_f32_c (ap_l + i, ap_r + i, ap_src + 2 * i, a_nframes - i);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+bswap16_sse2 (uint16_t * ap_samples, const size_t a_nsamples)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m128i v = _mm_loadu_si128 ((const __m128i *) (ap_samples + i));
+      _mm_storeu_si128 ((__m128i *) (ap_samples + i),
+                        _mm_or_si128 (_mm_slli_epi16 (v, 8),
+                                      _mm_srli_epi16 (v, 8)));
+    }
+  bswap16_c (ap_samples + i, a_nsamples - i);
+}
+
+TIZ_DSP_TARGET ("sse2")
+static inline float
+sse2_hsum (const __m128 a_v)
+{
+  const __m128 v = _mm_add_ps (a_v, _mm_movehl_ps (a_v, a_v));
+  return _mm_cvtss_f32 (_mm_add_ss (v, _mm_shuffle_ps (v, v, 1)));
+}
+
+TIZ_DSP_TARGET ("sse2")
+static float
+dot_f32_sse2 (const float * ap_a, const float * ap_b, const size_t a_len)
+{
+  __m128 acc0 = _mm_setzero_ps ();
+  __m128 acc1 = _mm_setzero_ps ();
+  size_t i = 0;
+  for (i = 0; i < a_len; i += 8)
+    {
+      acc0 = _mm_add_ps (acc0, _mm_mul_ps (_mm_loadu_ps (ap_a + i),
+                                           _mm_loadu_ps (ap_b + i)));
+      acc1 = _mm_add_ps (acc1, _mm_mul_ps (_mm_loadu_ps (ap_a + i + 4),
+                                           _mm_loadu_ps (ap_b + i + 4)));
+    }
+  return sse2_hsum (_mm_add_ps (acc0, acc1));
+}
+
+TIZ_DSP_TARGET ("sse2")
+static void
+mix_f32_sse2 (float * ap_dst, const float * ap_src, const size_t a_nsamples,
+              const float a_gain)
+{
+  const __m128 gain = _mm_set1_ps (a_gain);
+  size_t i = 0;
+  for (; i + 4 <= a_nsamples; i += 4)
+    {
+      _mm_storeu_ps (ap_dst + i,
+                     _mm_add_ps (_mm_loadu_ps (ap_dst + i),
+                                 _mm_mul_ps (_mm_loadu_ps (ap_src + i), gain)));
+    }
+  mix_f32_c (ap_dst + i, ap_src + i, a_nsamples - i, a_gain);
+}
+
+/* The four channels of a frame fill one register; the recursion runs along
+   the frames */
+TIZ_DSP_TARGET ("sse2")
+static void
+biquad4_f32_sse2 (float * ap_x, const size_t a_nframes, const float * ap_c,
+                  float * ap_z)
+{
+  const __m128 b0 = _mm_set1_ps (ap_c[0]);
+  const __m128 b1 = _mm_set1_ps (ap_c[1]);
+  const __m128 b2 = _mm_set1_ps (ap_c[2]);
+  const __m128 a1 = _mm_set1_ps (ap_c[3]);
+  const __m128 a2 = _mm_set1_ps (ap_c[4]);
+  __m128 z1 = _mm_loadu_ps (ap_z);
+  __m128 z2 = _mm_loadu_ps (ap_z + 4);
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i, ap_x += 4)
+    {
+      const __m128 x = _mm_loadu_ps (ap_x);
+      const __m128 y = _mm_add_ps (_mm_mul_ps (b0, x), z1);
+      z1 = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (b1, x), _mm_mul_ps (a1, y)),
+                       z2);
+      z2 = _mm_sub_ps (_mm_mul_ps (b2, x), _mm_mul_ps (a2, y));
+      _mm_storeu_ps (ap_x, y);
+    }
+  _mm_storeu_ps (ap_z, z1);
+  _mm_storeu_ps (ap_z + 4, z2);
+}
+
+static const dsp_kernels_t g_dsp_sse2 = {
+  TIZ_DSP_SIMD_SSE2,      gain_s16_sse2,        gain_s16_q12_sse2,
+  gain_f32_sse2,          s16_to_f32_sse2,      f32_to_s16_sse2,
+  fixed_to_s16_sse2,      interleave2_s16_sse2, interleave2_f32_sse2,
+  deinterleave2_f32_sse2, bswap16_sse2,         bswap32_c,
+  dot_f32_sse2,           mix_f32_sse2,         biquad4_f32_sse2,
+  interleave2_s32_to_s16_sse2
+};
+
+/*
+ * AVX2 kernels. 256-bit packs operate on each 128-bit lane separately, hence
+ * the 64-bit permutations that restore the sample order.
+ */
+
+TIZ_DSP_TARGET ("avx2")
+static inline __m256i
+avx2_f32_to_s16 (__m256 a_lo, __m256 a_hi)
+{
+  const __m256 max = _mm256_set1_ps (32767.0f);
+  const __m256 min = _mm256_set1_ps (-32768.0f);
+  a_lo = _mm256_max_ps (_mm256_min_ps (a_lo, max), min);
+  a_hi = _mm256_max_ps (_mm256_min_ps (a_hi, max), min);
+  return _mm256_permute4x64_epi64 (
+    _mm256_packs_epi32 (_mm256_cvtps_epi32 (a_lo), _mm256_cvtps_epi32 (a_hi)),
+    _MM_SHUFFLE (3, 1, 2, 0));
+}
+
+TIZ_DSP_TARGET ("avx2")
+static void
+gain_s16_avx2 (int16_t * ap_samples, const size_t a_nsamples,
+               const float a_gain)
+{
+  const __m256 gain = _mm256_set1_ps (a_gain);
+  size_t i = 0;
+  for (; i + 16 <= a_nsamples; i += 16)
+    {
+      const __m256i lo = _mm256_cvtepi16_epi32 (
+        _mm_loadu_si128 ((const __m128i *) (ap_samples + i)));
+      const __m256i hi = _mm256_cvtepi16_epi32 (
+        _mm_loadu_si128 ((const __m128i *) (ap_samples + i + 8)));
+      _mm256_storeu_si256 (
+        (__m256i *) (ap_samples + i),
+        avx2_f32_to_s16 (_mm256_mul_ps (_mm256_cvtepi32_ps (lo), gain),
+                         _mm256_mul_ps (_mm256_cvtepi32_ps (hi), gain)));
+    }
+  gain_s16_sse2 (ap_samples + i, a_nsamples - i, a_gain);
+}
+
+TIZ_DSP_TARGET ("avx2")
+static void
+gain_s16_q12_avx2 (int16_t * ap_samples, const size_t a_nsamples,
+                   const int16_t a_gain_q12)
+{
+  const __m256i gain = _mm256_set1_epi16 (a_gain_q12);
+  const __m256i round = _mm256_set1_epi32 (2048);
+  size_t i = 0;
+  for (; i + 16 <= a_nsamples; i += 16)
+    {
+      const __m256i v
+        = _mm256_loadu_si256 ((const __m256i *) (ap_samples + i));
+      const __m256i plo = _mm256_mullo_epi16 (v, gain);
+      const __m256i phi = _mm256_mulhi_epi16 (v, gain);
+      __m256i lo = _mm256_unpacklo_epi16 (plo, phi);
+      __m256i hi = _mm256_unpackhi_epi16 (plo, phi);
+      lo = _mm256_srai_epi32 (_mm256_add_epi32 (lo, round), 12);
+      hi = _mm256_srai_epi32 (_mm256_add_epi32 (hi, round), 12);
+      /* unpack and pack are both per lane, so the order is preserved */
+      _mm256_storeu_si256 ((__m256i *) (ap_samples + i),
+                           _mm256_packs_epi32 (lo, hi));
+    }
+  gain_s16_q12_sse2 (ap_samples + i, a_nsamples - i, a_gain_q12);
+}
+
+TIZ_DSP_TARGET ("avx2")
+static void
+gain_f32_avx2 (float * ap_samples, const size_t a_nsamples, const float a_gain)
+{
+  const __m256 gain = _mm256_set1_ps (a_gain);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      _mm256_storeu_ps (ap_samples + i,
+                        _mm256_mul_ps (_mm256_loadu_ps (ap_samples + i), gain));
+    }
+  gain_f32_c (ap_samples + i, a_nsamples - i, a_gain);
+}
+
+TIZ_DSP_TARGET ("avx2")
+static void
+s16_to_f32_avx2 (float * ap_dst, const int16_t * ap_src,
+                 const size_t a_nsamples)
+{
+  const __m256 scale = _mm256_set1_ps (1.0f / TIZ_DSP_S16_SCALE);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m256i v = _mm256_cvtepi16_epi32 (
+        _mm_loadu_si128 ((const __m128i *) (ap_src + i)));
+      _mm256_storeu_ps (ap_dst + i,
+                        _mm256_mul_ps (_mm256_cvtepi32_ps (v), scale));
+    }
+  s16_to_f32_c (ap_dst + i, ap_src + i, a_nsamples - i);
+}
+
+TIZ_DSP_TARGET ("avx2")
+static void
+f32_to_s16_avx2 (int16_t * ap_dst, const float * ap_src,
+                 const size_t a_nsamples)
+{
+  const __m256 scale = _mm256_set1_ps (TIZ_DSP_S16_SCALE);
+  size_t i = 0;
+  for (; i + 16 <= a_nsamples; i += 16)
+    {
+      _mm256_storeu_si256 (
+        (__m256i *) (ap_dst + i),
+        avx2_f32_to_s16 (
+          _mm256_mul_ps (_mm256_loadu_ps (ap_src + i), scale),
+          _mm256_mul_ps (_mm256_loadu_ps (ap_src + i + 8), scale)));
+    }
+  f32_to_s16_sse2 (ap_dst + i, ap_src + i, a_nsamples - i);
+}
+
+TIZ_DSP_TARGET ("avx2")
+static void
+fixed_to_s16_avx2 (int16_t * ap_dst, const int32_t * ap_src,
+                   const size_t a_nsamples, const unsigned int a_fracbits)
+{
+  const __m128i shift = _mm_cvtsi32_si128 (a_fracbits - 16);
+  const __m256i one = _mm256_set1_epi32 (1);
+  size_t i = 0;
+  for (; i + 16 <= a_nsamples; i += 16)
+    {
+      __m256i lo = _mm256_loadu_si256 ((const __m256i *) (ap_src + i));
+      __m256i hi = _mm256_loadu_si256 ((const __m256i *) (ap_src + i + 8));
+      lo = _mm256_srai_epi32 (
+        _mm256_add_epi32 (_mm256_sra_epi32 (lo, shift), one), 1);
+      hi = _mm256_srai_epi32 (
+        _mm256_add_epi32 (_mm256_sra_epi32 (hi, shift), one), 1);
+      _mm256_storeu_si256 (
+        (__m256i *) (ap_dst + i),
+        _mm256_permute4x64_epi64 (_mm256_packs_epi32 (lo, hi),
+                                  _MM_SHUFFLE (3, 1, 2, 0)));
+    }
+  fixed_to_s16_sse2 (ap_dst + i, ap_src + i, a_nsamples - i, a_fracbits);
+}
+
+TIZ_DSP_TARGET ("avx2")
+static void
+bswap16_avx2 (uint16_t * ap_samples, const size_t a_nsamples)
+{
+  const __m256i mask = _mm256_setr_epi8 (
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7,
+    6, 9, 8, 11, 10, 13, 12, 15, 14);
+  size_t i = 0;
+  for (; i + 16 <= a_nsamples; i += 16)
+    {
+      const __m256i v
+        = _mm256_loadu_si256 ((const __m256i *) (ap_samples + i));
+      _mm256_storeu_si256 ((__m256i *) (ap_samples + i),
+                           _mm256_shuffle_epi8 (v, mask));
+    }
+  bswap16_sse2 (ap_samples + i, a_nsamples - i);
+}
+
+TIZ_DSP_TARGET ("avx2")
+static void
+bswap32_avx2 (uint32_t * ap_samples, const size_t a_nsamples)
+{
+  const __m256i mask = _mm256_setr_epi8 (
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5,
+    4, 11, 10, 9, 8, 15, 14, 13, 12);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const __m256i v
+        = _mm256_loadu_si256 ((const __m256i *) (ap_samples + i));
+      _mm256_storeu_si256 ((__m256i *) (ap_samples + i),
+                           _mm256_shuffle_epi8 (v, mask));
+    }
+  bswap32_c (ap_samples + i, a_nsamples - i);
+}
+
+TIZ_DSP_TARGET ("avx2")
+static float
+dot_f32_avx2 (const float * ap_a, const float * ap_b, const size_t a_len)
+{
+  __m256 acc = _mm256_setzero_ps ();
+  size_t i = 0;
+  for (i = 0; i < a_len; i += 8)
+    {
+      acc = _mm256_add_ps (acc, _mm256_mul_ps (_mm256_loadu_ps (ap_a + i),
+                                               _mm256_loadu_ps (ap_b + i)));
+    }
+  return sse2_hsum (_mm_add_ps (_mm256_castps256_ps128 (acc),
+                                _mm256_extractf128_ps (acc, 1)));
+}
+
+TIZ_DSP_TARGET ("avx2")
+static void
+mix_f32_avx2 (float * ap_dst, const float * ap_src, const size_t a_nsamples,
+              const float a_gain)
+{
+  const __m256 gain = _mm256_set1_ps (a_gain);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      _mm256_storeu_ps (
+        ap_dst + i, _mm256_add_ps (_mm256_loadu_ps (ap_dst + i),
+                                   _mm256_mul_ps (_mm256_loadu_ps (ap_src + i),
+                                                  gain)));
+    }
+  mix_f32_c (ap_dst + i, ap_src + i, a_nsamples - i, a_gain);
+}
+
+static const dsp_kernels_t g_dsp_avx2 = {
+  TIZ_DSP_SIMD_AVX2,      gain_s16_avx2,        gain_s16_q12_avx2,
+  gain_f32_avx2,          s16_to_f32_avx2,      f32_to_s16_avx2,
+  fixed_to_s16_avx2,      interleave2_s16_sse2, interleave2_f32_sse2,
+  deinterleave2_f32_sse2, bswap16_avx2,         bswap32_avx2,
+  dot_f32_avx2,           mix_f32_avx2,         biquad4_f32_sse2,
+  interleave2_s32_to_s16_sse2
+};
+
+#endif /* TIZ_DSP_X86 */
+
+#ifdef TIZ_DSP_NEON
+
+/*
+ * NEON kernels
+ */
+
+static inline int16x8_t
+neon_f32_to_s16 (const float32x4_t a_lo, const float32x4_t a_hi)
+{
+  /* vcvtnq rounds to nearest even, like lrintf; vqmovn saturates */
+  return vcombine_s16 (vqmovn_s32 (vcvtnq_s32_f32 (a_lo)),
+                       vqmovn_s32 (vcvtnq_s32_f32 (a_hi)));
+}
+
+static void
+gain_s16_neon (int16_t * ap_samples, const size_t a_nsamples,
+               const float a_gain)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const int16x8_t v = vld1q_s16 (ap_samples + i);
+      const float32x4_t lo = vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (v)));
+      const float32x4_t hi = vcvtq_f32_s32 (vmovl_s16 (vget_high_s16 (v)));
+      vst1q_s16 (ap_samples + i, neon_f32_to_s16 (vmulq_n_f32 (lo, a_gain),
+                                                  vmulq_n_f32 (hi, a_gain)));
+    }
+  gain_s16_c (ap_samples + i, a_nsamples - i, a_gain);
+}
+
+static void
+gain_s16_q12_neon (int16_t * ap_samples, const size_t a_nsamples,
+                   const int16_t a_gain_q12)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const int16x8_t v = vld1q_s16 (ap_samples + i);
+      const int32x4_t lo = vmull_n_s16 (vget_low_s16 (v), a_gain_q12);
+      const int32x4_t hi = vmull_n_s16 (vget_high_s16 (v), a_gain_q12);
+      vst1q_s16 (ap_samples + i,
+                 vcombine_s16 (vqmovn_s32 (vrshrq_n_s32 (lo, 12)),
+                               vqmovn_s32 (vrshrq_n_s32 (hi, 12))));
+    }
+  gain_s16_q12_c (ap_samples + i, a_nsamples - i, a_gain_q12);
+}
+
+static void
+gain_f32_neon (float * ap_samples, const size_t a_nsamples, const float a_gain)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_nsamples; i += 4)
+    {
+      vst1q_f32 (ap_samples + i, vmulq_n_f32 (vld1q_f32 (ap_samples + i),
+                                              a_gain));
+    }
+  gain_f32_c (ap_samples + i, a_nsamples - i, a_gain);
+}
+
+static void
+s16_to_f32_neon (float * ap_dst, const int16_t * ap_src,
+                 const size_t a_nsamples)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const int16x8_t v = vld1q_s16 (ap_src + i);
+      vst1q_f32 (ap_dst + i,
+                 vmulq_n_f32 (vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (v))),
+                              1.0f / TIZ_DSP_S16_SCALE));
+      vst1q_f32 (ap_dst + i + 4,
+                 vmulq_n_f32 (vcvtq_f32_s32 (vmovl_s16 (vget_high_s16 (v))),
+                              1.0f / TIZ_DSP_S16_SCALE));
+    }
+  s16_to_f32_c (ap_dst + i, ap_src + i, a_nsamples - i);
+}
+
+static void
+f32_to_s16_neon (int16_t * ap_dst, const float * ap_src,
+                 const size_t a_nsamples)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      vst1q_s16 (ap_dst + i,
+                 neon_f32_to_s16 (
+                   vmulq_n_f32 (vld1q_f32 (ap_src + i), TIZ_DSP_S16_SCALE),
+                   vmulq_n_f32 (vld1q_f32 (ap_src + i + 4),
+                                TIZ_DSP_S16_SCALE)));
+    }
+  f32_to_s16_c (ap_dst + i, ap_src + i, a_nsamples - i);
+}
+
+static void
+fixed_to_s16_neon (int16_t * ap_dst, const int32_t * ap_src,
+                   const size_t a_nsamples, const unsigned int a_fracbits)
+{
+  /* A rounding shift right by (fracbits - 15), i.e. round half up */
+  const int32x4_t shift = vdupq_n_s32 (15 - (int) a_fracbits);
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      const int32x4_t lo = vrshlq_s32 (vld1q_s32 (ap_src + i), shift);
+      const int32x4_t hi = vrshlq_s32 (vld1q_s32 (ap_src + i + 4), shift);
+      vst1q_s16 (ap_dst + i, vcombine_s16 (vqmovn_s32 (lo), vqmovn_s32 (hi)));
+    }
+  fixed_to_s16_c (ap_dst + i, ap_src + i, a_nsamples - i, a_fracbits);
+}
+
+static void
+interleave2_s16_neon (int16_t * ap_dst, const int16_t * ap_l,
+                      const int16_t * ap_r, const size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nframes; i += 8)
+    {
+      int16x8x2_t v;
+      v.val[0] = vld1q_s16 (ap_l + i);
+      v.val[1] = vld1q_s16 (ap_r + i);
+      vst2q_s16 (ap_dst + 2 * i, v);
+    }
+  interleave2_s16_c (ap_dst + 2 * i, ap_l + i, ap_r + i, a_nframes - i);
+}
+
+static void
+interleave2_s32_to_s16_neon (int16_t * ap_dst, const int32_t * ap_l,
+                             const int32_t * ap_r, const size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nframes; i += 8)
+    {
+      int16x8x2_t v;
+      v.val[0] = vcombine_s16 (vqmovn_s32 (vld1q_s32 (ap_l + i)),
+                               vqmovn_s32 (vld1q_s32 (ap_l + i + 4)));
+      v.val[1] = vcombine_s16 (vqmovn_s32 (vld1q_s32 (ap_r + i)),
+                               vqmovn_s32 (vld1q_s32 (ap_r + i + 4)));
+      vst2q_s16 (ap_dst + 2 * i, v);
+    }
+  interleave2_s32_to_s16_c (ap_dst + 2 * i, ap_l + i, ap_r + i,
+                            a_nframes - i);
+}
+
+static void
+interleave2_f32_neon (float * ap_dst, const float * ap_l, const float * ap_r,
+                      const size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_nframes; i += 4)
+    {
+      float32x4x2_t v;
+      v.val[0] = vld1q_f32 (ap_l + i);
+      v.val[1] = vld1q_f32 (ap_r + i);
+      vst2q_f32 (ap_dst + 2 * i, v);
+    }
+  interleave2_f32_c (ap_dst + 2 * i, ap_l + i, ap_r + i, a_nframes - i);
+}
+
+static void
+deinterleave2_f32_neon (float * ap_l, float * ap_r, const float * ap_src,
+                        const size_t a_nframes)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_nframes; i += 4)
+    {
+      const float32x4x2_t v = vld2q_f32 (ap_src + 2 * i);
+      vst1q_f32 (ap_l + i, v.val[0]);
+      vst1q_f32 (ap_r + i, v.val[1]);
+    }
+  deinterleave2_f32_c (ap_l + i, ap_r + i, ap_src + 2 * i, a_nframes - i);
+}
+
+static void
+bswap16_neon (uint16_t * ap_samples, const size_t a_nsamples)
+{
+  size_t i = 0;
+  for (; i + 8 <= a_nsamples; i += 8)
+    {
+      vst1q_u16 (ap_samples + i, vreinterpretq_u16_u8 (vrev16q_u8 (
+                                   vreinterpretq_u8_u16 (
+                                     vld1q_u16 (ap_samples + i)))));
+    }
+  bswap16_c (ap_samples + i, a_nsamples - i);
+}
+
+static void
+bswap32_neon (uint32_t * ap_samples, const size_t a_nsamples)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_nsamples; i += 4)
+    {
+      vst1q_u32 (ap_samples + i, vreinterpretq_u32_u8 (vrev32q_u8 (
+                                   vreinterpretq_u8_u32 (
+                                     vld1q_u32 (ap_samples + i)))));
+    }
+  bswap32_c (ap_samples + i, a_nsamples - i);
+}
+
+static float
+dot_f32_neon (const float * ap_a, const float * ap_b, const size_t a_len)
+{
+  float32x4_t acc0 = vdupq_n_f32 (0.0f);
+  float32x4_t acc1 = vdupq_n_f32 (0.0f);
+  float32x2_t v;
+  size_t i = 0;
+  for (i = 0; i < a_len; i += 8)
+    {
+      acc0 = vaddq_f32 (acc0,
+                        vmulq_f32 (vld1q_f32 (ap_a + i), vld1q_f32 (ap_b + i)));
+      acc1 = vaddq_f32 (acc1, vmulq_f32 (vld1q_f32 (ap_a + i + 4),
+                                         vld1q_f32 (ap_b + i + 4)));
+    }
+  acc0 = vaddq_f32 (acc0, acc1);
+  v = vadd_f32 (vget_low_f32 (acc0), vget_high_f32 (acc0));
+  return vget_lane_f32 (v, 0) + vget_lane_f32 (v, 1);
+}
+
+static void
+mix_f32_neon (float * ap_dst, const float * ap_src, const size_t a_nsamples,
+              const float a_gain)
+{
+  size_t i = 0;
+  for (; i + 4 <= a_nsamples; i += 4)
+    {
+      vst1q_f32 (ap_dst + i, vmlaq_n_f32 (vld1q_f32 (ap_dst + i),
+                                          vld1q_f32 (ap_src + i), a_gain));
+    }
+  mix_f32_c (ap_dst + i, ap_src + i, a_nsamples - i, a_gain);
+}
+
+static void
+biquad4_f32_neon (float * ap_x, const size_t a_nframes, const float * ap_c,
+                  float * ap_z)
+{
+  const float32x4_t b0 = vdupq_n_f32 (ap_c[0]);
+  const float32x4_t b1 = vdupq_n_f32 (ap_c[1]);
+  const float32x4_t b2 = vdupq_n_f32 (ap_c[2]);
+  const float32x4_t a1 = vdupq_n_f32 (ap_c[3]);
+  const float32x4_t a2 = vdupq_n_f32 (ap_c[4]);
+  float32x4_t z1 = vld1q_f32 (ap_z);
+  float32x4_t z2 = vld1q_f32 (ap_z + 4);
+  size_t i = 0;
+  for (i = 0; i < a_nframes; ++i, ap_x += 4)
+    {
+      const float32x4_t x = vld1q_f32 (ap_x);
+      const float32x4_t y = vaddq_f32 (vmulq_f32 (b0, x), z1);
+      z1 = vaddq_f32 (vsubq_f32 (vmulq_f32 (b1, x), vmulq_f32 (a1, y)), z2);
+      z2 = vsubq_f32 (vmulq_f32 (b2, x), vmulq_f32 (a2, y));
+      vst1q_f32 (ap_x, y);
+    }
+  vst1q_f32 (ap_z, z1);
+  vst1q_f32 (ap_z + 4, z2);
+}
+
+static const dsp_kernels_t g_dsp_neon = {
+  TIZ_DSP_SIMD_NEON,      gain_s16_neon,        gain_s16_q12_neon,
+  gain_f32_neon,          s16_to_f32_neon,      f32_to_s16_neon,
+  fixed_to_s16_neon,      interleave2_s16_neon, interleave2_f32_neon,
+  deinterleave2_f32_neon, bswap16_neon,         bswap32_neon,
+  dot_f32_neon,           mix_f32_neon,         biquad4_f32_neon,
+  interleave2_s32_to_s16_neon
+};
+
+#endif /* TIZ_DSP_NEON */
+
+static const dsp_kernels_t *
+lookup_kernels (const tiz_dsp_simd_t a_simd)
+{
+  const dsp_kernels_t * p_kernels = &g_dsp_c;
+#ifdef TIZ_DSP_X86
+  __builtin_cpu_init ();
+  if (TIZ_DSP_SIMD_AVX2 == a_simd && __builtin_cpu_supports ("avx2"))
+    {
+      p_kernels = &g_dsp_avx2;
+    }
+  else if ((TIZ_DSP_SIMD_AVX2 == a_simd || TIZ_DSP_SIMD_SSE2 == a_simd)
+           && __builtin_cpu_supports ("sse2"))
+    {
+      p_kernels = &g_dsp_sse2;
+    }
+#endif
+#ifdef TIZ_DSP_NEON
+  if (TIZ_DSP_SIMD_NEON == a_simd)
+    {
+      p_kernels = &g_dsp_neon;
+    }
+#endif
+  return p_kernels;
+}
+
+static void
+init_kernels (void)
+{
+#if defined(TIZ_DSP_X86)
+  gp_dsp = lookup_kernels (TIZ_DSP_SIMD_AVX2);
+#elif defined(TIZ_DSP_NEON)
+  gp_dsp = lookup_kernels (TIZ_DSP_SIMD_NEON);
+#else
+  gp_dsp = lookup_kernels (TIZ_DSP_SIMD_NONE);
+#endif
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Using [%s] kernels",
+           tiz_dsp_simd_to_str (gp_dsp->simd));
+}
+
+static inline const dsp_kernels_t *
+kernels (void)
+{
+  (void) pthread_once (&g_dsp_once, init_kernels);
+  assert (gp_dsp);
+  return gp_dsp;
+}
+
+/* TPDF noise in the (-1, 1) range, from two uniform variates */
+static inline float
+tpdf_noise (uint32_t * ap_state)
+{
+  uint32_t x = *ap_state;
+  float u1 = 0.0f;
+  float u2 = 0.0f;
+  if (0 == x)
+    {
+      x = TIZ_DSP_DITHER_SEED;
+    }
+  /* xorshift32 */
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  u1 = (x >> 8) * (1.0f / 16777216.0f);
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  u2 = (x >> 8) * (1.0f / 16777216.0f);
+  *ap_state = x;
+  return u1 + u2 - 1.0f;
+}
+
+tiz_dsp_simd_t
+tiz_dsp_simd (void)
+{
+  return kernels ()->simd;
+}
+
+tiz_dsp_simd_t
+tiz_dsp_set_simd (const tiz_dsp_simd_t a_simd)
+{
+  (void) kernels ();
+  gp_dsp = lookup_kernels (a_simd);
+  return gp_dsp->simd;
+}
+
+const char *
+tiz_dsp_simd_to_str (const tiz_dsp_simd_t a_simd)
+{
+  switch (a_simd)
+    {
+      case TIZ_DSP_SIMD_SSE2:
+        return "SSE2";
+      case TIZ_DSP_SIMD_AVX2:
+        return "AVX2";
+      case TIZ_DSP_SIMD_NEON:
+        return "NEON";
+      case TIZ_DSP_SIMD_NONE:
+      default:
+        break;
+    };
+  return "C";
+}
+
+float
+tiz_dsp_db_to_gain (const float a_db)
+{
+  return powf (10.0f, a_db / 20.0f);
+}
+
+void
+tiz_dsp_gain_s16 (int16_t * ap_samples, const size_t a_nsamples,
+                  const float a_gain)
+{
+  assert (ap_samples || !a_nsamples);
+  kernels ()->gain_s16 (ap_samples, a_nsamples, a_gain);
+}
+
+void
+tiz_dsp_gain_s16_q12 (int16_t * ap_samples, const size_t a_nsamples,
+                      const int16_t a_gain_q12)
+{
+  assert (ap_samples || !a_nsamples);
+  kernels ()->gain_s16_q12 (ap_samples, a_nsamples, a_gain_q12);
+}
+
+void
+tiz_dsp_gain_f32 (float * ap_samples, const size_t a_nsamples,
+                  const float a_gain)
+{
+  assert (ap_samples || !a_nsamples);
+  kernels ()->gain_f32 (ap_samples, a_nsamples, a_gain);
+}
+
+void
+tiz_dsp_s16_to_f32 (float * ap_dst, const int16_t * ap_src,
+                    const size_t a_nsamples)
+{
+  assert ((ap_dst && ap_src) || !a_nsamples);
+  kernels ()->s16_to_f32 (ap_dst, ap_src, a_nsamples);
+}
+
+void
+tiz_dsp_s24_to_f32 (float * ap_dst, const uint8_t * ap_src,
+                    const size_t a_nsamples)
+{
+  size_t i = 0;
+  assert ((ap_dst && ap_src) || !a_nsamples);
+  for (i = 0; i < a_nsamples; ++i, ap_src += 3)
+    {
+      /* Place the sample in the upper 24 bits to sign-extend it */
+      const int32_t v = (int32_t) (((uint32_t) ap_src[0] << 8)
+                                   | ((uint32_t) ap_src[1] << 16)
+                                   | ((uint32_t) ap_src[2] << 24));
+      ap_dst[i] = (v >> 8) * (1.0f / TIZ_DSP_S24_SCALE);
+    }
+}
+
+void
+tiz_dsp_s32_to_f32 (float * ap_dst, const int32_t * ap_src,
+                    const size_t a_nsamples)
+{
+  size_t i = 0;
+  assert ((ap_dst && ap_src) || !a_nsamples);
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      ap_dst[i] = (float) (ap_src[i] * (1.0 / TIZ_DSP_S32_SCALE));
+    }
+}
+
+void
+tiz_dsp_f32_to_s16 (int16_t * ap_dst, const float * ap_src,
+                    const size_t a_nsamples, uint32_t * ap_dither)
+{
+  assert ((ap_dst && ap_src) || !a_nsamples);
+  if (!ap_dither)
+    {
+      kernels ()->f32_to_s16 (ap_dst, ap_src, a_nsamples);
+    }
+  else
+    {
+      size_t i = 0;
+      for (i = 0; i < a_nsamples; ++i)
+        {
+          ap_dst[i] = float_to_s16 (ap_src[i] * TIZ_DSP_S16_SCALE
+                                    + tpdf_noise (ap_dither));
+        }
+    }
+}
+
+void
+tiz_dsp_f32_to_s24 (uint8_t * ap_dst, const float * ap_src,
+                    const size_t a_nsamples, uint32_t * ap_dither)
+{
+  size_t i = 0;
+  assert ((ap_dst && ap_src) || !a_nsamples);
+  for (i = 0; i < a_nsamples; ++i, ap_dst += 3)
+    {
+      float f = ap_src[i] * TIZ_DSP_S24_SCALE;
+      int32_t v = 0;
+      if (ap_dither)
+        {
+          f += tpdf_noise (ap_dither);
+        }
+      if (f < -TIZ_DSP_S24_SCALE)
+        {
+          f = -TIZ_DSP_S24_SCALE;
+        }
+      else if (f > TIZ_DSP_S24_SCALE - 1.0f)
+        {
+          f = TIZ_DSP_S24_SCALE - 1.0f;
+        }
+      v = (int32_t) lrintf (f);
+      ap_dst[0] = (uint8_t) (v & 0xff);
+      ap_dst[1] = (uint8_t) ((v >> 8) & 0xff);
+      ap_dst[2] = (uint8_t) ((v >> 16) & 0xff);
+    }
+}
+
+void
+tiz_dsp_f32_to_s32 (int32_t * ap_dst, const float * ap_src,
+                    const size_t a_nsamples)
+{
+  size_t i = 0;
+  assert ((ap_dst && ap_src) || !a_nsamples);
+  for (i = 0; i < a_nsamples; ++i)
+    {
+      double d = ap_src[i] * TIZ_DSP_S32_SCALE;
+      if (d < -TIZ_DSP_S32_SCALE)
+        {
+          d = -TIZ_DSP_S32_SCALE;
+        }
+      else if (d > TIZ_DSP_S32_SCALE - 1.0)
+        {
+          d = TIZ_DSP_S32_SCALE - 1.0;
+        }
+      ap_dst[i] = (int32_t) lrint (d);
+    }
+}
+
+void
+tiz_dsp_fixed_to_s16 (int16_t * ap_dst, const int32_t * ap_src,
+                      const size_t a_nsamples, const unsigned int a_fracbits)
+{
+  assert ((ap_dst && ap_src) || !a_nsamples);
+  assert (a_fracbits >= 16 && a_fracbits <= 30);
+  kernels ()->fixed_to_s16 (ap_dst, ap_src, a_nsamples, a_fracbits);
+}
+
+void
+tiz_dsp_interleave_s16 (int16_t * ap_dst, const int16_t * const * app_src,
+                        const size_t a_nchannels, const size_t a_nframes)
+{
+  assert (ap_dst || !a_nframes);
+  assert (app_src);
+  if (2 == a_nchannels)
+    {
+      kernels ()->interleave2_s16 (ap_dst, app_src[0], app_src[1], a_nframes);
+    }
+  else
+    {
+      size_t i = 0, c = 0;
+      for (i = 0; i < a_nframes; ++i)
+        {
+          for (c = 0; c < a_nchannels; ++c)
+            {
+              *(ap_dst++) = app_src[c][i];
+            }
+        }
+    }
+}
+
+void
+tiz_dsp_interleave_s32_to_s16 (int16_t * ap_dst,
+                               const int32_t * const * app_src,
+                               const size_t a_nchannels, const size_t a_nframes)
+{
+  assert (ap_dst || !a_nframes);
+  assert (app_src);
+  if (2 == a_nchannels)
+    {
+      kernels ()->interleave2_s32_to_s16 (ap_dst, app_src[0], app_src[1],
+                                          a_nframes);
+    }
+  else
+    {
+      size_t i = 0, c = 0;
+      for (i = 0; i < a_nframes; ++i)
+        {
+          for (c = 0; c < a_nchannels; ++c)
+            {
+              *(ap_dst++) = s32_to_s16_sat (app_src[c][i]);
+            }
+        }
+    }
+}
+
+void
+tiz_dsp_interleave_s32_to_s24 (uint8_t * ap_dst,
+                               const int32_t * const * app_src,
+                               const size_t a_nchannels, const size_t a_nframes)
+{
+  size_t i = 0, c = 0;
+  assert (ap_dst || !a_nframes);
+  assert (app_src);
+  for (i = 0; i < a_nframes; ++i)
+    {
+      for (c = 0; c < a_nchannels; ++c)
+        {
+          int32_t v = app_src[c][i];
+          v = (v > 8388607) ? 8388607 : ((v < -8388608) ? -8388608 : v);
+          *(ap_dst++) = (uint8_t) (v & 0xff);
+          *(ap_dst++) = (uint8_t) ((v >> 8) & 0xff);
+          *(ap_dst++) = (uint8_t) ((v >> 16) & 0xff);
+        }
+    }
+}
+
+void
+tiz_dsp_interleave_f32 (float * ap_dst, const float * const * app_src,
+                        const size_t a_nchannels, const size_t a_nframes)
+{
+  assert (ap_dst || !a_nframes);
+  assert (app_src);
+  if (2 == a_nchannels)
+    {
+      kernels ()->interleave2_f32 (ap_dst, app_src[0], app_src[1], a_nframes);
+    }
+  else
+    {
+      size_t i = 0, c = 0;
+      for (i = 0; i < a_nframes; ++i)
+        {
+          for (c = 0; c < a_nchannels; ++c)
+            {
+              *(ap_dst++) = app_src[c][i];
+            }
+        }
+    }
+}
+
+void
+tiz_dsp_deinterleave_f32 (float * const * app_dst, const float * ap_src,
+                          const size_t a_nchannels, const size_t a_nframes)
+{
+  assert (app_dst);
+  assert (ap_src || !a_nframes);
+  if (2 == a_nchannels)
+    {
+      kernels ()->deinterleave2_f32 (app_dst[0], app_dst[1], ap_src,
+                                     a_nframes);
+    }
+  else
+    {
+      size_t i = 0, c = 0;
+      for (i = 0; i < a_nframes; ++i)
+        {
+          for (c = 0; c < a_nchannels; ++c)
+            {
+              app_dst[c][i] = *(ap_src++);
+            }
+        }
+    }
+}
+
+void
+tiz_dsp_remix_f32 (float * ap_dst, const size_t a_dst_channels,
+                   const float * ap_src, const size_t a_src_channels,
+                   const size_t a_nframes)
+{
+  size_t i = 0, c = 0;
+
+  assert ((ap_dst && ap_src) || !a_nframes);
+  assert (a_dst_channels > 0);
+  assert (a_src_channels > 0);
+
+  if (a_dst_channels == a_src_channels)
+    {
+      memcpy (ap_dst, ap_src, a_nframes * a_src_channels * sizeof (float));
+    }
+  else if (1 == a_src_channels)
+    {
+      for (i = 0; i < a_nframes; ++i)
+        {
+          for (c = 0; c < a_dst_channels; ++c)
+            {
+              *(ap_dst++) = ap_src[i];
+            }
+        }
+    }
+  else if (1 == a_dst_channels)
+    {
+      const float scale = 1.0f / a_src_channels;
+      for (i = 0; i < a_nframes; ++i, ap_src += a_src_channels)
+        {
+          float sum = 0.0f;
+          for (c = 0; c < a_src_channels; ++c)
+            {
+              sum += ap_src[c];
+            }
+          ap_dst[i] = sum * scale;
+        }
+    }
+  else if (2 == a_dst_channels)
+    {
+      /* FL FR FC LFE BL BR SL SR */
+      const float m3db = 0.70710678f;
+      const float centre = a_src_channels > 2 ? m3db : 0.0f;
+      const size_t nsurround = a_src_channels > 4 ? (a_src_channels - 4) / 2 : 0;
+      const float scale = 1.0f / (1.0f + centre + nsurround * m3db);
+      for (i = 0; i < a_nframes; ++i, ap_src += a_src_channels)
+        {
+          float l = ap_src[0];
+          float r = ap_src[1];
+          size_t s = 0;
+          if (a_src_channels > 2)
+            {
+              l += ap_src[2] * centre;
+              r += ap_src[2] * centre;
+            }
+          for (s = 0; s < nsurround; ++s)
+            {
+              l += ap_src[4 + 2 * s] * m3db;
+              r += ap_src[5 + 2 * s] * m3db;
+            }
+          *(ap_dst++) = l * scale;
+          *(ap_dst++) = r * scale;
+        }
+    }
+  else
+    {
+      for (i = 0; i < a_nframes; ++i, ap_src += a_src_channels)
+        {
+          for (c = 0; c < a_dst_channels; ++c)
+            {
+              *(ap_dst++) = c < a_src_channels ? ap_src[c] : 0.0f;
+            }
+        }
+    }
+}
+
+void
+tiz_dsp_bswap16 (void * ap_samples, const size_t a_nsamples)
+{
+  assert (ap_samples || !a_nsamples);
+  kernels ()->bswap16 ((uint16_t *) ap_samples, a_nsamples);
+}
+
+void
+tiz_dsp_bswap32 (void * ap_samples, const size_t a_nsamples)
+{
+  assert (ap_samples || !a_nsamples);
+  kernels ()->bswap32 ((uint32_t *) ap_samples, a_nsamples);
+}
+
+void
+tiz_dsp_fader_init (tiz_dsp_fader_t * ap_fader, const float a_gain)
+{
+  assert (ap_fader);
+  ap_fader->gain = a_gain;
+  ap_fader->target = a_gain;
+  ap_fader->step = 0.0f;
+  ap_fader->remaining = 0;
+}
+
+void
+tiz_dsp_fader_ramp (tiz_dsp_fader_t * ap_fader, const float a_target,
+                    const size_t a_nframes)
+{
+  assert (ap_fader);
+  ap_fader->target = a_target;
+  if (0 == a_nframes || ap_fader->gain == a_target)
+    {
+      ap_fader->gain = a_target;
+      ap_fader->step = 0.0f;
+      ap_fader->remaining = 0;
+    }
+  else
+    {
+      ap_fader->step = (a_target - ap_fader->gain) / (float) a_nframes;
+      ap_fader->remaining = a_nframes;
+    }
+}
+
+bool
+tiz_dsp_fader_is_unity (const tiz_dsp_fader_t * ap_fader)
+{
+  assert (ap_fader);
+  return (0 == ap_fader->remaining && 1.0f == ap_fader->gain);
+}
+
+/* Advances the ramp in progress over at most a_nframes, and returns the
+   number of frames that it covered. The per-frame gain is computed from the
+   start of the segment so that rounding errors don't accumulate. */
+static size_t
+fader_ramp_frames (tiz_dsp_fader_t * ap_fader, const size_t a_nframes,
+                   float * ap_start)
+{
+  const size_t nframes
+    = a_nframes < ap_fader->remaining ? a_nframes : ap_fader->remaining;
+  *ap_start = ap_fader->gain;
+  ap_fader->remaining -= nframes;
+  ap_fader->gain = (0 == ap_fader->remaining)
+                     ? ap_fader->target
+                     : ap_fader->gain + ap_fader->step * (float) nframes;
+  return nframes;
+}
+
+void
+tiz_dsp_fader_s16 (tiz_dsp_fader_t * ap_fader, int16_t * ap_samples,
+                   const size_t a_nchannels, const size_t a_nframes)
+{
+  float start = 0.0f;
+  size_t nramp = 0;
+  size_t f = 0;
+  size_t c = 0;
+
+  assert (ap_fader);
+  assert (ap_samples || !a_nframes);
+
+  nramp = fader_ramp_frames (ap_fader, a_nframes, &start);
+  for (f = 0; f < nramp; ++f)
+    {
+      const float gain = start + ap_fader->step * (float) f;
+      for (c = 0; c < a_nchannels; ++c, ++ap_samples)
+        {
+          *ap_samples = float_to_s16 (*ap_samples * gain);
+        }
+    }
+
+  /* The rest of the buffer gets the steady gain */
+  if (0.0f == ap_fader->gain)
+    {
+      memset (ap_samples, 0, (a_nframes - nramp) * a_nchannels
+                               * sizeof (int16_t));
+    }
+  else if (1.0f != ap_fader->gain)
+    {
+      tiz_dsp_gain_s16 (ap_samples, (a_nframes - nramp) * a_nchannels,
+                        ap_fader->gain);
+    }
+}
+
+void
+tiz_dsp_fader_f32 (tiz_dsp_fader_t * ap_fader, float * ap_samples,
+                   const size_t a_nchannels, const size_t a_nframes)
+{
+  float start = 0.0f;
+  size_t nramp = 0;
+  size_t f = 0;
+  size_t c = 0;
+
+  assert (ap_fader);
+  assert (ap_samples || !a_nframes);
+
+  nramp = fader_ramp_frames (ap_fader, a_nframes, &start);
+  for (f = 0; f < nramp; ++f)
+    {
+      const float gain = start + ap_fader->step * (float) f;
+      for (c = 0; c < a_nchannels; ++c, ++ap_samples)
+        {
+          *ap_samples *= gain;
+        }
+    }
+
+  if (0.0f == ap_fader->gain)
+    {
+      memset (ap_samples, 0, (a_nframes - nramp) * a_nchannels
+                               * sizeof (float));
+    }
+  else if (1.0f != ap_fader->gain)
+    {
+      tiz_dsp_gain_f32 (ap_samples, (a_nframes - nramp) * a_nchannels,
+                        ap_fader->gain);
+    }
+}
+
+float
+tiz_dsp_dot_f32 (const float * ap_a, const float * ap_b, const size_t a_len)
+{
+  assert ((ap_a && ap_b) || !a_len);
+  assert (0 == a_len % 8);
+  return kernels ()->dot_f32 (ap_a, ap_b, a_len);
+}
+
+void
+tiz_dsp_mix_f32 (float * ap_dst, const float * ap_src, const size_t a_nsamples,
+                 const float a_gain)
+{
+  assert ((ap_dst && ap_src) || !a_nsamples);
+  kernels ()->mix_f32 (ap_dst, ap_src, a_nsamples, a_gain);
+}
+
+/*
+ * Sample rate converter
+ */
+
+struct tiz_dsp_resampler
+{
+  size_t nchannels;
+  size_t up;           /* L: interpolation factor */
+  size_t down;         /* M: decimation factor */
+  size_t int_step;     /* M / L */
+  size_t frac_step;    /* M % L */
+  size_t ntaps;        /* per phase, a multiple of 8 */
+  float * p_bank;      /* up * ntaps coefficients */
+  float * p_hist;      /* nchannels planes of capacity frames */
+  float ** pp_planes;  /* write positions into each plane */
+  size_t capacity;     /* frames per plane */
+  size_t hist_len;     /* valid frames per plane */
+  size_t pos;          /* index of the next output's first input frame */
+  size_t phase;        /* filter to use for the next output frame */
+};
+
+static size_t
+gcd (size_t a, size_t b)
+{
+  while (b)
+    {
+      const size_t t = a % b;
+      a = b;
+      b = t;
+    }
+  return a;
+}
+
+/* Zeroth-order modified Bessel function of the first kind */
+static double
+bessel_i0 (const double a_x)
+{
+  double sum = 1.0;
+  double term = 1.0;
+  int k = 1;
+  for (k = 1; k < 50 && term > sum * 1e-12; ++k)
+    {
+      term *= (a_x / (2.0 * k)) * (a_x / (2.0 * k));
+      sum += term;
+    }
+  return sum;
+}
+
+/* Fills the bank of 'up' filters. Filter p produces the output frame that
+   lies p/up input frames after the centre of its taps. The cut-off is
+   placed at the lower of the two Nyquist frequencies, slightly rolled-off,
+   and each filter is normalised to unity gain at DC. */
+/* Computes a bank of a_nphases Kaiser-windowed sinc filters of a_ntaps taps
+   each, where filter p interpolates at p / a_nphases of the way between two
+   input frames. Each filter is normalised to unity gain at DC. */
+static void
+compute_polyphase_bank (float * ap_bank, const size_t a_nphases,
+                        const size_t a_ntaps, const double a_cutoff,
+                        const double a_beta)
+{
+  const double half = (double) a_ntaps / 2.0;
+  const double i0_beta = bessel_i0 (a_beta);
+  size_t p = 0;
+  size_t k = 0;
+
+  for (p = 0; p < a_nphases; ++p)
+    {
+      float * p_taps = ap_bank + p * a_ntaps;
+      double sum = 0.0;
+      for (k = 0; k < a_ntaps; ++k)
+        {
+          const double d
+            = ((double) k - (half - 1.0)) - (double) p / (double) a_nphases;
+          const double x = d / half;
+          const double arg = M_PI * a_cutoff * d;
+          const double sinc = fabs (arg) < 1e-9 ? 1.0 : sin (arg) / arg;
+          const double window
+            = fabs (x) >= 1.0 ? 0.0
+                              : bessel_i0 (a_beta * sqrt (1.0 - x * x)) / i0_beta;
+          p_taps[k] = (float) (a_cutoff * sinc * window);
+          sum += p_taps[k];
+        }
+      for (k = 0; k < a_ntaps && sum != 0.0; ++k)
+        {
+          p_taps[k] = (float) (p_taps[k] / sum);
+        }
+    }
+}
+
+static void
+compute_filter_bank (tiz_dsp_resampler_t * ap_rs, const double a_rolloff,
+                     const double a_beta)
+{
+  const double cutoff
+    = a_rolloff * (ap_rs->up < ap_rs->down
+                     ? (double) ap_rs->up / (double) ap_rs->down
+                     : 1.0);
+  compute_polyphase_bank (ap_rs->p_bank, ap_rs->up, ap_rs->ntaps, cutoff,
+                          a_beta);
+}
+
+OMX_ERRORTYPE
+tiz_dsp_resampler_init (tiz_dsp_resampler_ptr_t * app_rs,
+                        const uint32_t a_in_rate, const uint32_t a_out_rate,
+                        const size_t a_nchannels,
+                        const tiz_dsp_resampler_quality_t a_quality)
+{
+  tiz_dsp_resampler_t * p_rs = NULL;
+  size_t g = 0;
+  double rolloff = 0.0;
+  double beta = 0.0;
+
+  assert (app_rs);
+
+  if (0 == a_in_rate || 0 == a_out_rate || 0 == a_nchannels)
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  g = gcd (a_in_rate, a_out_rate);
+  if (a_out_rate / g > TIZ_DSP_RESAMPLER_MAX_PHASES)
+    {
+      return OMX_ErrorUnsupportedSetting;
+    }
+
+  if (!(p_rs = tiz_mem_calloc (1, sizeof (tiz_dsp_resampler_t))))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_rs->nchannels = a_nchannels;
+  p_rs->up = a_out_rate / g;
+  p_rs->down = a_in_rate / g;
+  p_rs->int_step = p_rs->down / p_rs->up;
+  p_rs->frac_step = p_rs->down % p_rs->up;
+
+  switch (a_quality)
+    {
+      case TIZ_DSP_RESAMPLER_QUALITY_LOW:
+        {
+          p_rs->ntaps = 16;
+          rolloff = 0.85;
+          beta = 5.0;
+        }
+        break;
+      case TIZ_DSP_RESAMPLER_QUALITY_HIGH:
+        {
+          p_rs->ntaps = 64;
+          rolloff = 0.95;
+          beta = 9.0;
+        }
+        break;
+      case TIZ_DSP_RESAMPLER_QUALITY_MEDIUM:
+      default:
+        {
+          p_rs->ntaps = 32;
+          rolloff = 0.91;
+          beta = 7.0;
+        }
+        break;
+    };
+
+  /* Room for the filter's span plus a block of new input */
+  p_rs->capacity = p_rs->ntaps + p_rs->int_step + TIZ_DSP_RESAMPLER_BLOCK_FRAMES;
+  p_rs->p_bank = tiz_mem_alloc (p_rs->up * p_rs->ntaps * sizeof (float));
+  p_rs->p_hist
+    = tiz_mem_alloc (p_rs->capacity * a_nchannels * sizeof (float));
+  p_rs->pp_planes = tiz_mem_alloc (a_nchannels * sizeof (float *));
+
+  if (!p_rs->p_bank || !p_rs->p_hist || !p_rs->pp_planes)
+    {
+      tiz_dsp_resampler_destroy (p_rs);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  compute_filter_bank (p_rs, rolloff, beta);
+  tiz_dsp_resampler_reset (p_rs);
+
+  *app_rs = p_rs;
+  return OMX_ErrorNone;
+}
+
+void
+tiz_dsp_resampler_destroy (tiz_dsp_resampler_t * ap_rs)
+{
+  if (ap_rs)
+    {
+      tiz_mem_free (ap_rs->p_bank);
+      tiz_mem_free (ap_rs->p_hist);
+      tiz_mem_free (ap_rs->pp_planes);
+      tiz_mem_free (ap_rs);
+    }
+}
+
+void
+tiz_dsp_resampler_reset (tiz_dsp_resampler_t * ap_rs)
+{
+  assert (ap_rs);
+  /* Prime the history with silence, so that the first output frame is
+     centred on the first input frame */
+  memset (ap_rs->p_hist, 0,
+          ap_rs->capacity * ap_rs->nchannels * sizeof (float));
+  ap_rs->hist_len = ap_rs->ntaps / 2 - 1;
+  ap_rs->pos = 0;
+  ap_rs->phase = 0;
+}
+
+size_t
+tiz_dsp_resampler_delay (const tiz_dsp_resampler_t * ap_rs)
+{
+  assert (ap_rs);
+  if (ap_rs->up == ap_rs->down)
+    {
+      return 0;
+    }
+  return ((ap_rs->hist_len - ap_rs->pos) * ap_rs->up) / ap_rs->down;
+}
+
+/* Appends up to a_nframes interleaved frames to the history planes */
+static size_t
+resampler_append (tiz_dsp_resampler_t * ap_rs, const float * ap_in,
+                  const size_t a_nframes)
+{
+  const size_t nframes
+    = MIN (a_nframes, ap_rs->capacity - ap_rs->hist_len);
+  size_t c = 0;
+  for (c = 0; c < ap_rs->nchannels; ++c)
+    {
+      ap_rs->pp_planes[c]
+        = ap_rs->p_hist + c * ap_rs->capacity + ap_rs->hist_len;
+    }
+  tiz_dsp_deinterleave_f32 (ap_rs->pp_planes, ap_in, ap_rs->nchannels,
+                            nframes);
+  ap_rs->hist_len += nframes;
+  return nframes;
+}
+
+/* Drops the history that no future output frame depends on */
+static void
+resampler_compact (tiz_dsp_resampler_t * ap_rs)
+{
+  const size_t drop = MIN (ap_rs->pos, ap_rs->hist_len);
+  size_t c = 0;
+  if (drop > 0)
+    {
+      for (c = 0; c < ap_rs->nchannels; ++c)
+        {
+          float * p_plane = ap_rs->p_hist + c * ap_rs->capacity;
+          memmove (p_plane, p_plane + drop,
+                   (ap_rs->hist_len - drop) * sizeof (float));
+        }
+      ap_rs->hist_len -= drop;
+      ap_rs->pos -= drop;
+    }
+}
+
+size_t
+tiz_dsp_resampler_process (tiz_dsp_resampler_t * ap_rs, const float * ap_in,
+                           size_t * ap_in_frames, float * ap_out,
+                           const size_t a_out_frames)
+{
+  const size_t nchannels = ap_rs ? ap_rs->nchannels : 0;
+  size_t consumed = 0;
+  size_t produced = 0;
+
+  assert (ap_rs);
+  assert (ap_in_frames);
+  assert (ap_in || !*ap_in_frames);
+  assert (ap_out || !a_out_frames);
+
+  if (ap_rs->up == ap_rs->down)
+    {
+      /* Same rate, nothing to do but copy */
+      produced = MIN (*ap_in_frames, a_out_frames);
+      memcpy (ap_out, ap_in, produced * nchannels * sizeof (float));
+      *ap_in_frames = produced;
+      return produced;
+    }
+
+  for (;;)
+    {
+      const size_t appended
+        = resampler_append (ap_rs, ap_in + consumed * nchannels,
+                            *ap_in_frames - consumed);
+      size_t made = 0;
+      consumed += appended;
+
+      while (produced < a_out_frames
+             && ap_rs->pos + ap_rs->ntaps <= ap_rs->hist_len)
+        {
+          const float * p_taps = ap_rs->p_bank + ap_rs->phase * ap_rs->ntaps;
+          const float * p_hist = ap_rs->p_hist + ap_rs->pos;
+          size_t c = 0;
+          for (c = 0; c < nchannels; ++c, p_hist += ap_rs->capacity)
+            {
+              *(ap_out++) = kernels ()->dot_f32 (p_hist, p_taps, ap_rs->ntaps);
+            }
+          /* Advance by M/L input frames, without divisions */
+          ap_rs->pos += ap_rs->int_step;
+          ap_rs->phase += ap_rs->frac_step;
+          if (ap_rs->phase >= ap_rs->up)
+            {
+              ap_rs->phase -= ap_rs->up;
+              ++ap_rs->pos;
+            }
+          ++produced;
+          ++made;
+        }
+
+      resampler_compact (ap_rs);
+
+      if (0 == appended && 0 == made)
+        {
+          break;
+        }
+    }
+
+  *ap_in_frames = consumed;
+  return produced;
+}
+
+/*
+ * EBU R128 / ITU-R BS.1770 loudness meter
+ */
+
+#define TIZ_DSP_LOUDNESS_NBINS                                      \
+  ((size_t) ((TIZ_DSP_LOUDNESS_MAX_LUFS - TIZ_DSP_LOUDNESS_MIN_LUFS) \
+             * TIZ_DSP_LOUDNESS_BINS_PER_LU))
+
+typedef struct loudness_biquad loudness_biquad_t;
+struct loudness_biquad
+{
+  double b0, b1, b2, a1, a2;
+};
+
+struct tiz_dsp_loudness
+{
+  size_t nchannels;
+  size_t step_frames;  /* 100ms, i.e. a quarter of a gating block */
+  loudness_biquad_t shelf;
+  loudness_biquad_t highpass;
+  double weights[TIZ_DSP_LOUDNESS_MAX_CHANNELS];
+  double state[TIZ_DSP_LOUDNESS_MAX_CHANNELS][4]; /* K-filter histories */
+  double step_energy;  /* weighted sum of squares in the current step */
+  size_t step_pos;     /* frames in the current step */
+  double steps[4];     /* energies of the last four steps */
+  size_t nsteps;
+  size_t * p_counts;   /* gating blocks, by loudness */
+  double * p_energies; /* the sum of their mean energies */
+  float bank[TIZ_DSP_LOUDNESS_OVERSAMPLING * TIZ_DSP_LOUDNESS_TP_TAPS];
+  /* Each channel's history is stored twice, so that the last
+     TIZ_DSP_LOUDNESS_TP_TAPS samples are always contiguous */
+  float tp_hist[TIZ_DSP_LOUDNESS_MAX_CHANNELS][2 * TIZ_DSP_LOUDNESS_TP_TAPS];
+  size_t tp_pos;
+  float peak;
+  uint64_t frames;
+};
+
+/* The two stages of the K-weighting filter, for any sampling rate (see ITU-R
+   BS.1770-4, and the bilinear transform of its analog prototypes) */
+static void
+loudness_k_filter (tiz_dsp_loudness_t * ap_lm, const double a_rate)
+{
+  double f0 = 1681.974450955533;
+  double q = 0.7071752369554196;
+  double k = tan (M_PI * f0 / a_rate);
+  const double vh = pow (10.0, 3.999843853973347 / 20.0);
+  const double vb = pow (vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+
+  ap_lm->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+  ap_lm->shelf.b1 = 2.0 * (k * k - vh) / a0;
+  ap_lm->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+  ap_lm->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+  ap_lm->shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = tan (M_PI * f0 / a_rate);
+  a0 = 1.0 + k / q + k * k;
+  ap_lm->highpass.b0 = 1.0;
+  ap_lm->highpass.b1 = -2.0;
+  ap_lm->highpass.b2 = 1.0;
+  ap_lm->highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+  ap_lm->highpass.a2 = (1.0 - k / q + k * k) / a0;
+}
+
+/* Direct form II; ap_z holds the filter's two state variables */
+static inline double
+loudness_biquad (const loudness_biquad_t * ap_bq, double * ap_z,
+                 const double a_x)
+{
+  const double w = a_x - ap_bq->a1 * ap_z[0] - ap_bq->a2 * ap_z[1];
+  const double y = ap_bq->b0 * w + ap_bq->b1 * ap_z[0] + ap_bq->b2 * ap_z[1];
+  ap_z[1] = ap_z[0];
+  ap_z[0] = w;
+  return y;
+}
+
+/* Stores a completed gating block (400ms, overlapping the previous one by
+   75%) if it is above the absolute gate */
+static void
+loudness_add_block (tiz_dsp_loudness_t * ap_lm, const double a_energy)
+{
+  const double lufs = -0.691 + 10.0 * log10 (a_energy);
+  if (a_energy > 0.0 && lufs >= TIZ_DSP_LOUDNESS_MIN_LUFS)
+    {
+      size_t bin = (size_t) ((lufs - TIZ_DSP_LOUDNESS_MIN_LUFS)
+                             * TIZ_DSP_LOUDNESS_BINS_PER_LU);
+      if (bin >= TIZ_DSP_LOUDNESS_NBINS)
+        {
+          bin = TIZ_DSP_LOUDNESS_NBINS - 1;
+        }
+      ++(ap_lm->p_counts[bin]);
+      ap_lm->p_energies[bin] += a_energy;
+    }
+}
+
+static void
+loudness_end_step (tiz_dsp_loudness_t * ap_lm)
+{
+  ap_lm->steps[ap_lm->nsteps % 4] = ap_lm->step_energy;
+  ++(ap_lm->nsteps);
+  ap_lm->step_energy = 0.0;
+  ap_lm->step_pos = 0;
+  if (ap_lm->nsteps >= 4)
+    {
+      loudness_add_block (ap_lm, (ap_lm->steps[0] + ap_lm->steps[1]
+                                  + ap_lm->steps[2] + ap_lm->steps[3])
+                                   / (4.0 * (double) ap_lm->step_frames));
+    }
+}
+
+static void
+loudness_frames (tiz_dsp_loudness_t * ap_lm, const float * ap_samples,
+                 const size_t a_nframes)
+{
+  const size_t nchannels = ap_lm->nchannels;
+  size_t f = 0;
+  size_t c = 0;
+  size_t p = 0;
+
+  for (f = 0; f < a_nframes; ++f, ap_samples += nchannels)
+    {
+      const size_t pos = ap_lm->tp_pos;
+      double energy = 0.0;
+      for (c = 0; c < nchannels; ++c)
+        {
+          const float x = ap_samples[c];
+          float * p_hist = ap_lm->tp_hist[c];
+          const double k
+            = loudness_biquad (&(ap_lm->highpass), ap_lm->state[c] + 2,
+                               loudness_biquad (&(ap_lm->shelf),
+                                                ap_lm->state[c], x));
+          energy += ap_lm->weights[c] * k * k;
+
+          /* True peak: the sample itself, and the points in between it and
+             the previous sample, interpolated at 4x the sampling rate */
+          p_hist[pos] = x;
+          p_hist[pos + TIZ_DSP_LOUDNESS_TP_TAPS] = x;
+          for (p = 1; p < TIZ_DSP_LOUDNESS_OVERSAMPLING; ++p)
+            {
+              const float y = fabsf (kernels ()->dot_f32 (
+                p_hist + pos + 1, ap_lm->bank + p * TIZ_DSP_LOUDNESS_TP_TAPS,
+                TIZ_DSP_LOUDNESS_TP_TAPS));
+              if (y > ap_lm->peak)
+                {
+                  ap_lm->peak = y;
+                }
+            }
+          if (fabsf (x) > ap_lm->peak)
+            {
+              ap_lm->peak = fabsf (x);
+            }
+        }
+      ap_lm->tp_pos = (pos + 1) % TIZ_DSP_LOUDNESS_TP_TAPS;
+      ap_lm->step_energy += energy;
+      if (++(ap_lm->step_pos) == ap_lm->step_frames)
+        {
+          loudness_end_step (ap_lm);
+        }
+    }
+  ap_lm->frames += a_nframes;
+}
+
+OMX_ERRORTYPE
+tiz_dsp_loudness_init (tiz_dsp_loudness_ptr_t * app_lm, const uint32_t a_rate,
+                       const size_t a_nchannels)
+{
+  tiz_dsp_loudness_t * p_lm = NULL;
+  size_t c = 0;
+
+  assert (app_lm);
+
+  if (a_rate < 8000 || 0 == a_nchannels
+      || a_nchannels > TIZ_DSP_LOUDNESS_MAX_CHANNELS)
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (!(p_lm = tiz_mem_calloc (1, sizeof (tiz_dsp_loudness_t))))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_lm->p_counts = tiz_mem_calloc (TIZ_DSP_LOUDNESS_NBINS, sizeof (size_t));
+  p_lm->p_energies = tiz_mem_calloc (TIZ_DSP_LOUDNESS_NBINS, sizeof (double));
+  if (!p_lm->p_counts || !p_lm->p_energies)
+    {
+      tiz_dsp_loudness_destroy (p_lm);
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_lm->nchannels = a_nchannels;
+  p_lm->step_frames = a_rate / 10;
+  loudness_k_filter (p_lm, (double) a_rate);
+
+  /* Channel weights, for the usual quad (L R Ls Rs), 5.0 (L R C Ls Rs) and
+     5.1 (L R C LFE Ls Rs) layouts: surround channels count 1.5dB more, and
+     the LFE channel is ignored */
+  for (c = 0; c < a_nchannels; ++c)
+    {
+      p_lm->weights[c] = 1.0;
+    }
+  if (4 == a_nchannels || 5 == a_nchannels || 6 == a_nchannels)
+    {
+      p_lm->weights[a_nchannels - 2] = 1.41;
+      p_lm->weights[a_nchannels - 1] = 1.41;
+      if (6 == a_nchannels)
+        {
+          p_lm->weights[3] = 0.0;
+        }
+    }
+
+  /* The interpolator's bandwidth covers the whole of the original band */
+  compute_polyphase_bank (p_lm->bank, TIZ_DSP_LOUDNESS_OVERSAMPLING,
+                          TIZ_DSP_LOUDNESS_TP_TAPS, 0.95, 7.0);
+
+  tiz_dsp_loudness_reset (p_lm);
+  *app_lm = p_lm;
+  return OMX_ErrorNone;
+}
+
+void
+tiz_dsp_loudness_destroy (tiz_dsp_loudness_t * ap_lm)
+{
+  if (ap_lm)
+    {
+      tiz_mem_free (ap_lm->p_counts);
+      tiz_mem_free (ap_lm->p_energies);
+      tiz_mem_free (ap_lm);
+    }
+}
+
+void
+tiz_dsp_loudness_reset (tiz_dsp_loudness_t * ap_lm)
+{
+  assert (ap_lm);
+  memset (ap_lm->state, 0, sizeof (ap_lm->state));
+  memset (ap_lm->tp_hist, 0, sizeof (ap_lm->tp_hist));
+  memset (ap_lm->steps, 0, sizeof (ap_lm->steps));
+  memset (ap_lm->p_counts, 0, TIZ_DSP_LOUDNESS_NBINS * sizeof (size_t));
+  memset (ap_lm->p_energies, 0, TIZ_DSP_LOUDNESS_NBINS * sizeof (double));
+  ap_lm->step_energy = 0.0;
+  ap_lm->step_pos = 0;
+  ap_lm->nsteps = 0;
+  ap_lm->tp_pos = 0;
+  ap_lm->peak = 0.0f;
+  ap_lm->frames = 0;
+}
+
+void
+tiz_dsp_loudness_f32 (tiz_dsp_loudness_t * ap_lm, const float * ap_samples,
+                      const size_t a_nframes)
+{
+  assert (ap_lm);
+  assert (ap_samples || !a_nframes);
+  loudness_frames (ap_lm, ap_samples, a_nframes);
+}
+
+void
+tiz_dsp_loudness_s16 (tiz_dsp_loudness_t * ap_lm, const int16_t * ap_samples,
+                      const size_t a_nframes)
+{
+  float chunk[TIZ_DSP_LOUDNESS_CHUNK_FRAMES * TIZ_DSP_LOUDNESS_MAX_CHANNELS];
+  size_t done = 0;
+
+  assert (ap_lm);
+  assert (ap_samples || !a_nframes);
+
+  while (done < a_nframes)
+    {
+      const size_t n = MIN (a_nframes - done, TIZ_DSP_LOUDNESS_CHUNK_FRAMES);
+      tiz_dsp_s16_to_f32 (chunk, ap_samples + done * ap_lm->nchannels,
+                          n * ap_lm->nchannels);
+      loudness_frames (ap_lm, chunk, n);
+      done += n;
+    }
+}
+
+float
+tiz_dsp_loudness_integrated (const tiz_dsp_loudness_t * ap_lm)
+{
+  double energy = 0.0;
+  size_t count = 0;
+  size_t first = 0;
+  size_t b = 0;
+  double gate = 0.0;
+
+  assert (ap_lm);
+
+  /* Mean of the blocks above the absolute gate... */
+  for (b = 0; b < TIZ_DSP_LOUDNESS_NBINS; ++b)
+    {
+      energy += ap_lm->p_energies[b];
+      count += ap_lm->p_counts[b];
+    }
+  if (0 == count)
+    {
+      return -HUGE_VALF;
+    }
+
+  /* ... sets the relative gate, 10 LU below it */
+  gate = -0.691 + 10.0 * log10 (energy / (double) count) - 10.0;
+  if (gate > TIZ_DSP_LOUDNESS_MIN_LUFS)
+    {
+      first = (size_t) ceil ((gate - TIZ_DSP_LOUDNESS_MIN_LUFS)
+                             * TIZ_DSP_LOUDNESS_BINS_PER_LU);
+    }
+
+  energy = 0.0;
+  count = 0;
+  for (b = first; b < TIZ_DSP_LOUDNESS_NBINS; ++b)
+    {
+      energy += ap_lm->p_energies[b];
+      count += ap_lm->p_counts[b];
+    }
+  if (0 == count)
+    {
+      return -HUGE_VALF;
+    }
+
+  return (float) (-0.691 + 10.0 * log10 (energy / (double) count));
+}
+
+float
+tiz_dsp_loudness_true_peak (const tiz_dsp_loudness_t * ap_lm)
+{
+  assert (ap_lm);
+  return ap_lm->peak;
+}
+
+uint64_t
+tiz_dsp_loudness_frames (const tiz_dsp_loudness_t * ap_lm)
+{
+  assert (ap_lm);
+  return ap_lm->frames;
+}
+
+/*
+ * Equalizer
+ */
+
+#define TIZ_DSP_EQ_MAX_GROUPS ((TIZ_DSP_EQ_MAX_CHANNELS + 3) / 4)
+
+static const float g_eq_identity[5] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+struct tiz_dsp_eq
+{
+  size_t nchannels;
+  size_t nsections;        /* sections being run */
+  size_t target_nsections; /* sections left once the ramp is over */
+  float coeffs[TIZ_DSP_EQ_MAX_SECTIONS][5];
+  float targets[TIZ_DSP_EQ_MAX_SECTIONS][5];
+  float steps[TIZ_DSP_EQ_MAX_SECTIONS][5];
+  size_t ramp_blocks;      /* coefficient updates left */
+  float state[TIZ_DSP_EQ_MAX_GROUPS][TIZ_DSP_EQ_MAX_SECTIONS][8];
+  float block[TIZ_DSP_EQ_BLOCK_FRAMES * 4];
+  float * p_fir_taps;      /* reversed, and zero-padded to a multiple of 8 */
+  /* Each channel's history is stored twice, so that the last fir_len
+     samples are always contiguous */
+  float * p_fir_hist;
+  size_t fir_len;
+  size_t fir_pos;
+};
+
+OMX_ERRORTYPE
+tiz_dsp_biquad_design (tiz_dsp_biquad_t * ap_bq,
+                       const tiz_dsp_biquad_type_t a_type,
+                       const uint32_t a_rate, const float a_freq,
+                       const float a_q, const float a_gain_db)
+{
+  double w0 = 0.0;
+  double cw = 0.0;
+  double alpha = 0.0;
+  double a = 0.0;
+  double sa = 0.0;
+  double b[3];
+  double a0 = 0.0, a1 = 0.0, a2 = 0.0;
+
+  assert (ap_bq);
+
+  if (0 == a_rate || !(a_freq > 0.0f) || !(a_freq < a_rate / 2.0f)
+      || !(a_q > 0.0f) || !isfinite (a_gain_db))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  w0 = 2.0 * M_PI * a_freq / a_rate;
+  cw = cos (w0);
+  alpha = sin (w0) / (2.0 * a_q);
+  a = pow (10.0, a_gain_db / 40.0);
+  sa = 2.0 * sqrt (a) * alpha;
+
+  switch (a_type)
+    {
+      case TIZ_DSP_BIQUAD_PEAKING:
+        {
+          b[0] = 1.0 + alpha * a;
+          b[1] = -2.0 * cw;
+          b[2] = 1.0 - alpha * a;
+          a0 = 1.0 + alpha / a;
+          a1 = -2.0 * cw;
+          a2 = 1.0 - alpha / a;
+        }
+        break;
+      case TIZ_DSP_BIQUAD_LOW_SHELF:
+        {
+          b[0] = a * ((a + 1.0) - (a - 1.0) * cw + sa);
+          b[1] = 2.0 * a * ((a - 1.0) - (a + 1.0) * cw);
+          b[2] = a * ((a + 1.0) - (a - 1.0) * cw - sa);
+          a0 = (a + 1.0) + (a - 1.0) * cw + sa;
+          a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cw);
+          a2 = (a + 1.0) + (a - 1.0) * cw - sa;
+        }
+        break;
+      case TIZ_DSP_BIQUAD_HIGH_SHELF:
+        {
+          b[0] = a * ((a + 1.0) + (a - 1.0) * cw + sa);
+          b[1] = -2.0 * a * ((a - 1.0) + (a + 1.0) * cw);
+          b[2] = a * ((a + 1.0) + (a - 1.0) * cw - sa);
+          a0 = (a + 1.0) - (a - 1.0) * cw + sa;
+          a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cw);
+          a2 = (a + 1.0) - (a - 1.0) * cw - sa;
+        }
+        break;
+      case TIZ_DSP_BIQUAD_LOW_PASS:
+        {
+          b[0] = b[2] = (1.0 - cw) / 2.0;
+          b[1] = 1.0 - cw;
+          a0 = 1.0 + alpha;
+          a1 = -2.0 * cw;
+          a2 = 1.0 - alpha;
+        }
+        break;
+      case TIZ_DSP_BIQUAD_HIGH_PASS:
+        {
+          b[0] = b[2] = (1.0 + cw) / 2.0;
+          b[1] = -(1.0 + cw);
+          a0 = 1.0 + alpha;
+          a1 = -2.0 * cw;
+          a2 = 1.0 - alpha;
+        }
+        break;
+      default:
+        {
+          return OMX_ErrorBadParameter;
+        }
+    };
+
+  ap_bq->b0 = (float) (b[0] / a0);
+  ap_bq->b1 = (float) (b[1] / a0);
+  ap_bq->b2 = (float) (b[2] / a0);
+  ap_bq->a1 = (float) (a1 / a0);
+  ap_bq->a2 = (float) (a2 / a0);
+  return OMX_ErrorNone;
+}
+
+/* The sections that are no longer needed have reached the identity; their
+   histories are cleared, so that they start afresh if they are reused */
+static void
+eq_end_ramp (tiz_dsp_eq_t * ap_eq)
+{
+  size_t g = 0;
+  size_t s = 0;
+  memcpy (ap_eq->coeffs, ap_eq->targets, sizeof (ap_eq->coeffs));
+  for (g = 0; g < TIZ_DSP_EQ_MAX_GROUPS; ++g)
+    {
+      for (s = ap_eq->target_nsections; s < TIZ_DSP_EQ_MAX_SECTIONS; ++s)
+        {
+          memset (ap_eq->state[g][s], 0, sizeof (ap_eq->state[g][s]));
+        }
+    }
+  ap_eq->nsections = ap_eq->target_nsections;
+  ap_eq->ramp_blocks = 0;
+}
+
+/* Coefficients move linearly, once per block. The set of stable (a1, a2)
+   pairs is convex, so every intermediate section is stable too */
+static void
+eq_step_ramp (tiz_dsp_eq_t * ap_eq)
+{
+  size_t s = 0;
+  size_t k = 0;
+  if (ap_eq->ramp_blocks > 1)
+    {
+      for (s = 0; s < ap_eq->nsections; ++s)
+        {
+          for (k = 0; k < 5; ++k)
+            {
+              ap_eq->coeffs[s][k] += ap_eq->steps[s][k];
+            }
+        }
+      --(ap_eq->ramp_blocks);
+    }
+  else if (1 == ap_eq->ramp_blocks)
+    {
+      eq_end_ramp (ap_eq);
+    }
+}
+
+static void
+eq_biquads (tiz_dsp_eq_t * ap_eq, float * ap_samples, const size_t a_nframes)
+{
+  const size_t nchannels = ap_eq->nchannels;
+  float * p_block = ap_eq->block;
+  size_t c0 = 0;
+  size_t f = 0;
+  size_t c = 0;
+  size_t s = 0;
+
+  for (c0 = 0; c0 < nchannels; c0 += 4)
+    {
+      const size_t n = MIN (nchannels - c0, 4);
+      const float * p_src = ap_samples + c0;
+      float * p_dst = ap_samples + c0;
+      memset (p_block, 0, a_nframes * 4 * sizeof (float));
+      for (f = 0; f < a_nframes; ++f, p_src += nchannels)
+        {
+          for (c = 0; c < n; ++c)
+            {
+              p_block[f * 4 + c] = p_src[c];
+            }
+        }
+      for (s = 0; s < ap_eq->nsections; ++s)
+        {
+          kernels ()->biquad4_f32 (p_block, a_nframes, ap_eq->coeffs[s],
+                                   ap_eq->state[c0 / 4][s]);
+        }
+      for (f = 0; f < a_nframes; ++f, p_dst += nchannels)
+        {
+          for (c = 0; c < n; ++c)
+            {
+              p_dst[c] = p_block[f * 4 + c];
+            }
+        }
+    }
+}
+
+static void
+eq_fir (tiz_dsp_eq_t * ap_eq, float * ap_samples, const size_t a_nframes)
+{
+  const size_t nchannels = ap_eq->nchannels;
+  const size_t len = ap_eq->fir_len;
+  size_t f = 0;
+  size_t c = 0;
+
+  for (f = 0; f < a_nframes; ++f, ap_samples += nchannels)
+    {
+      const size_t pos = ap_eq->fir_pos;
+      for (c = 0; c < nchannels; ++c)
+        {
+          float * p_hist = ap_eq->p_fir_hist + c * 2 * len;
+          p_hist[pos] = ap_samples[c];
+          p_hist[pos + len] = ap_samples[c];
+          ap_samples[c]
+            = kernels ()->dot_f32 (p_hist + pos + 1, ap_eq->p_fir_taps, len);
+        }
+      ap_eq->fir_pos = (pos + 1) % len;
+    }
+}
+
+OMX_ERRORTYPE
+tiz_dsp_eq_init (tiz_dsp_eq_ptr_t * app_eq, const size_t a_nchannels)
+{
+  tiz_dsp_eq_t * p_eq = NULL;
+
+  assert (app_eq);
+
+  if (0 == a_nchannels || a_nchannels > TIZ_DSP_EQ_MAX_CHANNELS)
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (!(p_eq = tiz_mem_calloc (1, sizeof (tiz_dsp_eq_t))))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  p_eq->nchannels = a_nchannels;
+  *app_eq = p_eq;
+  return OMX_ErrorNone;
+}
+
+void
+tiz_dsp_eq_destroy (tiz_dsp_eq_t * ap_eq)
+{
+  if (ap_eq)
+    {
+      tiz_mem_free (ap_eq->p_fir_taps);
+      tiz_mem_free (ap_eq->p_fir_hist);
+      tiz_mem_free (ap_eq);
+    }
+}
+
+void
+tiz_dsp_eq_reset (tiz_dsp_eq_t * ap_eq)
+{
+  assert (ap_eq);
+  memset (ap_eq->state, 0, sizeof (ap_eq->state));
+  if (ap_eq->p_fir_hist)
+    {
+      memset (ap_eq->p_fir_hist, 0,
+              ap_eq->nchannels * 2 * ap_eq->fir_len * sizeof (float));
+    }
+  ap_eq->fir_pos = 0;
+}
+
+OMX_ERRORTYPE
+tiz_dsp_eq_set_biquads (tiz_dsp_eq_t * ap_eq,
+                        const tiz_dsp_biquad_t * ap_sections,
+                        const size_t a_nsections, const size_t a_ramp_frames)
+{
+  const size_t nblocks = (a_ramp_frames + TIZ_DSP_EQ_BLOCK_FRAMES - 1)
+                         / TIZ_DSP_EQ_BLOCK_FRAMES;
+  size_t s = 0;
+  size_t k = 0;
+
+  assert (ap_eq);
+
+  if (a_nsections > TIZ_DSP_EQ_MAX_SECTIONS || (a_nsections && !ap_sections))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  /* New sections start from the identity, and the ones that go away end
+     there */
+  for (s = ap_eq->nsections; s < a_nsections; ++s)
+    {
+      memcpy (ap_eq->coeffs[s], g_eq_identity, sizeof (g_eq_identity));
+    }
+  for (s = 0; s < TIZ_DSP_EQ_MAX_SECTIONS; ++s)
+    {
+      if (s < a_nsections)
+        {
+          ap_eq->targets[s][0] = ap_sections[s].b0;
+          ap_eq->targets[s][1] = ap_sections[s].b1;
+          ap_eq->targets[s][2] = ap_sections[s].b2;
+          ap_eq->targets[s][3] = ap_sections[s].a1;
+          ap_eq->targets[s][4] = ap_sections[s].a2;
+        }
+      else
+        {
+          memcpy (ap_eq->targets[s], g_eq_identity, sizeof (g_eq_identity));
+        }
+    }
+
+  ap_eq->target_nsections = a_nsections;
+  ap_eq->nsections = MAX (ap_eq->nsections, a_nsections);
+
+  if (0 == nblocks)
+    {
+      eq_end_ramp (ap_eq);
+    }
+  else
+    {
+      for (s = 0; s < ap_eq->nsections; ++s)
+        {
+          for (k = 0; k < 5; ++k)
+            {
+              ap_eq->steps[s][k]
+                = (ap_eq->targets[s][k] - ap_eq->coeffs[s][k]) / nblocks;
+            }
+        }
+      ap_eq->ramp_blocks = nblocks;
+    }
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz_dsp_eq_set_fir (tiz_dsp_eq_t * ap_eq, const float * ap_taps,
+                    const size_t a_ntaps)
+{
+  const size_t len = (a_ntaps + 7) & ~((size_t) 7);
+  float * p_taps = NULL;
+  float * p_hist = NULL;
+  size_t i = 0;
+
+  assert (ap_eq);
+
+  if (a_ntaps > TIZ_DSP_EQ_MAX_FIR_TAPS || (a_ntaps && !ap_taps))
+    {
+      return OMX_ErrorBadParameter;
+    }
+
+  if (a_ntaps)
+    {
+      p_taps = tiz_mem_calloc (len, sizeof (float));
+      p_hist = tiz_mem_calloc (ap_eq->nchannels * 2 * len, sizeof (float));
+      if (!p_taps || !p_hist)
+        {
+          tiz_mem_free (p_taps);
+          tiz_mem_free (p_hist);
+          return OMX_ErrorInsufficientResources;
+        }
+      for (i = 0; i < a_ntaps; ++i)
+        {
+          p_taps[len - 1 - i] = ap_taps[i];
+        }
+    }
+
+  tiz_mem_free (ap_eq->p_fir_taps);
+  tiz_mem_free (ap_eq->p_fir_hist);
+  ap_eq->p_fir_taps = p_taps;
+  ap_eq->p_fir_hist = p_hist;
+  ap_eq->fir_len = len;
+  ap_eq->fir_pos = 0;
+  return OMX_ErrorNone;
+}
+
+void
+tiz_dsp_eq_process_f32 (tiz_dsp_eq_t * ap_eq, float * ap_samples,
+                        const size_t a_nframes)
+{
+  size_t done = 0;
+  size_t g = 0;
+  size_t s = 0;
+  size_t k = 0;
+
+  assert (ap_eq);
+  assert (ap_samples || !a_nframes);
+
+  while (done < a_nframes && ap_eq->nsections > 0)
+    {
+      const size_t n = MIN (a_nframes - done, TIZ_DSP_EQ_BLOCK_FRAMES);
+      eq_step_ramp (ap_eq);
+      eq_biquads (ap_eq, ap_samples + done * ap_eq->nchannels, n);
+      done += n;
+    }
+
+  /* Decaying histories would otherwise end up as denormals */
+  for (g = 0; g < TIZ_DSP_EQ_MAX_GROUPS; ++g)
+    {
+      for (s = 0; s < ap_eq->nsections; ++s)
+        {
+          for (k = 0; k < 8; ++k)
+            {
+              if (fabsf (ap_eq->state[g][s][k]) < 1e-20f)
+                {
+                  ap_eq->state[g][s][k] = 0.0f;
+                }
+            }
+        }
+    }
+
+  if (ap_eq->p_fir_taps)
+    {
+      eq_fir (ap_eq, ap_samples, a_nframes);
+    }
+}
+
+bool
+tiz_dsp_eq_bypassed (const tiz_dsp_eq_t * ap_eq)
+{
+  assert (ap_eq);
+  return 0 == ap_eq->nsections && !ap_eq->p_fir_taps;
+}
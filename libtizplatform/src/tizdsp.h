@@ -0,0 +1,732 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizdsp.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia Platform - PCM processing kernels
+ *
+ *
+ */
+
+#ifndef TIZDSP_H
+#define TIZDSP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+* @defgroup tizdsp PCM sample processing kernels.
+*
+* Gain, sample format conversion, channel (de)interleaving, channel mapping
+* and byte swapping routines for PCM audio. The hot kernels have SSE2, AVX2
+* and NEON implementations; the best one supported by the CPU is selected at
+* run time, the first time any of these functions is used.
+*
+* Unless otherwise noted, sample counts are total samples (i.e. frames times
+* channels), float samples are in the [-1.0, 1.0) range, and 24-bit samples
+* are packed, little-endian, three bytes per sample. Source and destination
+* buffers must not overlap, except for the in-place functions. Samples use
+* fixed-width integer types, as OMX_S32 and OMX_U32 are not 32 bits wide on
+* every platform.
+*
+* @ingroup libtizplatform
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <OMX_Core.h>
+
+/**
+ * SIMD instruction set extensions that may be used by the kernels.
+ * @ingroup tizdsp
+ */
+typedef enum tiz_dsp_simd
+{
+  TIZ_DSP_SIMD_NONE = 0, /** Portable C implementation */
+  TIZ_DSP_SIMD_SSE2,     /** x86 SSE2 */
+  TIZ_DSP_SIMD_AVX2,     /** x86 AVX2 */
+  TIZ_DSP_SIMD_NEON      /** ARM Advanced SIMD (aarch64) */
+} tiz_dsp_simd_t;
+
+/**
+ * Retrieve the instruction set extension currently in use.
+ *
+ * @ingroup tizdsp
+ * @return The SIMD level selected for this CPU.
+ */
+tiz_dsp_simd_t
+tiz_dsp_simd (void);
+
+/**
+ * Select a different instruction set extension. Useful for testing and
+ * benchmarking; normally the best one is selected automatically. This
+ * function is not thread-safe with respect to the kernels.
+ *
+ * @ingroup tizdsp
+ * @param a_simd The requested SIMD level.
+ * @return The SIMD level actually in use, which is TIZ_DSP_SIMD_NONE if the
+ * requested extension is not supported by this CPU.
+ */
+tiz_dsp_simd_t
+tiz_dsp_set_simd (const tiz_dsp_simd_t a_simd);
+
+/**
+ * Get a printable name for a SIMD level.
+ *
+ * @ingroup tizdsp
+ * @param a_simd The SIMD level.
+ * @return A null-terminated string.
+ */
+const char *
+tiz_dsp_simd_to_str (const tiz_dsp_simd_t a_simd);
+
+/**
+ * Convert a gain value expressed in decibels to a linear gain factor.
+ *
+ * @ingroup tizdsp
+ */
+float
+tiz_dsp_db_to_gain (const float a_db);
+
+/**
+ * Apply a gain factor to 16-bit samples, in place, with saturation.
+ *
+ * @ingroup tizdsp
+ * @param ap_samples The samples.
+ * @param a_nsamples The number of samples.
+ * @param a_gain Linear gain factor.
+ */
+void
+tiz_dsp_gain_s16 (int16_t * ap_samples, const size_t a_nsamples,
+                  const float a_gain);
+
+/**
+ * Apply a fixed-point gain factor to 16-bit samples, in place, with
+ * saturation.
+ *
+ * @ingroup tizdsp
+ * @param ap_samples The samples.
+ * @param a_nsamples The number of samples.
+ * @param a_gain_q12 Linear gain factor in Q3.12 format (i.e. 4096 is unity
+ * gain, and the maximum is just under 8.0).
+ */
+void
+tiz_dsp_gain_s16_q12 (int16_t * ap_samples, const size_t a_nsamples,
+                      const int16_t a_gain_q12);
+
+/**
+ * Apply a gain factor to float samples, in place. The result is not clipped.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_gain_f32 (float * ap_samples, const size_t a_nsamples,
+                  const float a_gain);
+
+/**
+ * Convert 16-bit samples to float.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_s16_to_f32 (float * ap_dst, const int16_t * ap_src,
+                    const size_t a_nsamples);
+
+/**
+ * Convert packed 24-bit samples to float.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_s24_to_f32 (float * ap_dst, const uint8_t * ap_src,
+                    const size_t a_nsamples);
+
+/**
+ * Convert 32-bit samples to float.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_s32_to_f32 (float * ap_dst, const int32_t * ap_src,
+                    const size_t a_nsamples);
+
+/**
+ * Convert float samples to 16-bit, with saturation and optional TPDF
+ * dither.
+ *
+ * @ingroup tizdsp
+ * @param ap_dst The destination buffer.
+ * @param ap_src The source buffer.
+ * @param a_nsamples The number of samples.
+ * @param ap_dither The state of the dither noise generator (any non-zero
+ * value can be used as a seed), or NULL to disable dither.
+ */
+void
+tiz_dsp_f32_to_s16 (int16_t * ap_dst, const float * ap_src,
+                    const size_t a_nsamples, uint32_t * ap_dither);
+
+/**
+ * Convert float samples to packed 24-bit, with saturation and optional TPDF
+ * dither.
+ *
+ * @ingroup tizdsp
+ * @see tiz_dsp_f32_to_s16
+ */
+void
+tiz_dsp_f32_to_s24 (uint8_t * ap_dst, const float * ap_src,
+                    const size_t a_nsamples, uint32_t * ap_dither);
+
+/**
+ * Convert float samples to 32-bit, with saturation.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_f32_to_s32 (int32_t * ap_dst, const float * ap_src,
+                    const size_t a_nsamples);
+
+/**
+ * Convert fixed-point samples (e.g. libmad's mad_fixed_t) to 16-bit, with
+ * rounding and saturation.
+ *
+ * @ingroup tizdsp
+ * @param ap_dst The destination buffer.
+ * @param ap_src The source buffer.
+ * @param a_nsamples The number of samples.
+ * @param a_fracbits The number of fractional bits in the source samples
+ * (between 16 and 30).
+ */
+void
+tiz_dsp_fixed_to_s16 (int16_t * ap_dst, const int32_t * ap_src,
+                      const size_t a_nsamples, const unsigned int a_fracbits);
+
+/**
+ * Interleave planar 16-bit samples. The same source plane may be used for
+ * several channels (e.g. to output mono as stereo).
+ *
+ * @ingroup tizdsp
+ * @param ap_dst The destination buffer (a_nchannels * a_nframes samples).
+ * @param app_src An array of a_nchannels planes of a_nframes samples.
+ * @param a_nchannels The number of channels.
+ * @param a_nframes The number of frames.
+ */
+void
+tiz_dsp_interleave_s16 (int16_t * ap_dst, const int16_t * const * app_src,
+                        const size_t a_nchannels, const size_t a_nframes);
+
+/**
+ * Interleave planar 32-bit samples that hold 16-bit values (e.g. libFLAC's
+ * output), with saturation.
+ *
+ * @ingroup tizdsp
+ * @see tiz_dsp_interleave_s16
+ */
+void
+tiz_dsp_interleave_s32_to_s16 (int16_t * ap_dst,
+                               const int32_t * const * app_src,
+                               const size_t a_nchannels, const size_t a_nframes);
+
+/**
+ * Interleave planar 32-bit samples that hold 24-bit values into packed
+ * little-endian 24-bit samples, with saturation.
+ *
+ * @ingroup tizdsp
+ * @see tiz_dsp_interleave_s16
+ */
+void
+tiz_dsp_interleave_s32_to_s24 (uint8_t * ap_dst,
+                               const int32_t * const * app_src,
+                               const size_t a_nchannels, const size_t a_nframes);
+
+/**
+ * Interleave planar float samples.
+ *
+ * @ingroup tizdsp
+ * @see tiz_dsp_interleave_s16
+ */
+void
+tiz_dsp_interleave_f32 (float * ap_dst, const float * const * app_src,
+                        const size_t a_nchannels, const size_t a_nframes);
+
+/**
+ * De-interleave float samples into planes.
+ *
+ * @ingroup tizdsp
+ * @param app_dst An array of a_nchannels planes of a_nframes samples.
+ * @param ap_src The source buffer (a_nchannels * a_nframes samples).
+ * @param a_nchannels The number of channels.
+ * @param a_nframes The number of frames.
+ */
+void
+tiz_dsp_deinterleave_f32 (float * const * app_dst, const float * ap_src,
+                          const size_t a_nchannels, const size_t a_nframes);
+
+/**
+ * Convert interleaved float samples from one channel count to another.
+ *
+ * Mono is copied to every output channel. Down-mixes to mono average all
+ * input channels. Down-mixes to stereo assume the WAVE channel order (FL,
+ * FR, FC, LFE, BL, BR, ...), fold centre and surround channels into the
+ * front pair at -3dB, drop the LFE channel, and are normalised to avoid
+ * clipping. Otherwise, channels are copied in order, and any extra output
+ * channels are silenced.
+ *
+ * @ingroup tizdsp
+ * @param ap_dst The destination buffer (a_dst_channels * a_nframes samples).
+ * @param a_dst_channels The number of output channels.
+ * @param ap_src The source buffer (a_src_channels * a_nframes samples).
+ * @param a_src_channels The number of input channels.
+ * @param a_nframes The number of frames.
+ */
+void
+tiz_dsp_remix_f32 (float * ap_dst, const size_t a_dst_channels,
+                   const float * ap_src, const size_t a_src_channels,
+                   const size_t a_nframes);
+
+/**
+ * Swap the byte order of 16-bit samples, in place.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_bswap16 (void * ap_samples, const size_t a_nsamples);
+
+/**
+ * Swap the byte order of 32-bit samples, in place.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_bswap32 (void * ap_samples, const size_t a_nsamples);
+
+/**
+ * A software gain stage that moves linearly from one gain to another over a
+ * number of frames, one frame at a time. Used for volume changes, mute and
+ * pause/resume fades that don't depend on the availability of a mixer
+ * control, nor on the granularity of a timer.
+ *
+ * @ingroup tizdsp
+ */
+typedef struct tiz_dsp_fader tiz_dsp_fader_t;
+struct tiz_dsp_fader
+{
+  float gain;       /** The gain applied to the next frame */
+  float target;     /** The gain at the end of the current ramp */
+  float step;       /** The per-frame gain increment */
+  size_t remaining; /** Frames left in the current ramp */
+};
+
+/**
+ * Initialise a fader, with no ramp in progress.
+ *
+ * @ingroup tizdsp
+ * @param ap_fader The fader.
+ * @param a_gain The initial linear gain.
+ */
+void
+tiz_dsp_fader_init (tiz_dsp_fader_t * ap_fader, const float a_gain);
+
+/**
+ * Start a new ramp from the fader's current gain. A ramp in progress is
+ * replaced by the new one, without discontinuity.
+ *
+ * @ingroup tizdsp
+ * @param ap_fader The fader.
+ * @param a_target The linear gain to reach.
+ * @param a_nframes The length of the ramp in frames (zero to change the gain
+ * immediately).
+ */
+void
+tiz_dsp_fader_ramp (tiz_dsp_fader_t * ap_fader, const float a_target,
+                    const size_t a_nframes);
+
+/**
+ * Whether the fader would leave the samples untouched (i.e. unity gain and
+ * no ramp in progress).
+ *
+ * @ingroup tizdsp
+ */
+bool
+tiz_dsp_fader_is_unity (const tiz_dsp_fader_t * ap_fader);
+
+/**
+ * Apply the fader to interleaved 16-bit samples, in place, with saturation,
+ * and advance it by a_nframes.
+ *
+ * @ingroup tizdsp
+ * @param ap_fader The fader.
+ * @param ap_samples The samples (a_nchannels * a_nframes).
+ * @param a_nchannels The number of channels.
+ * @param a_nframes The number of frames.
+ */
+void
+tiz_dsp_fader_s16 (tiz_dsp_fader_t * ap_fader, int16_t * ap_samples,
+                   const size_t a_nchannels, const size_t a_nframes);
+
+/**
+ * Apply the fader to interleaved float samples, in place.
+ *
+ * @ingroup tizdsp
+ * @see tiz_dsp_fader_s16
+ */
+void
+tiz_dsp_fader_f32 (tiz_dsp_fader_t * ap_fader, float * ap_samples,
+                   const size_t a_nchannels, const size_t a_nframes);
+
+/**
+ * Compute the dot product of two float vectors.
+ *
+ * @ingroup tizdsp
+ * @param ap_a The first vector.
+ * @param ap_b The second vector.
+ * @param a_len The length of the vectors, which must be a multiple of 8.
+ * @return The dot product.
+ */
+float
+tiz_dsp_dot_f32 (const float * ap_a, const float * ap_b, const size_t a_len);
+
+/**
+ * Scale float samples and add them to a mix buffer, i.e. dst += src * gain.
+ * The sums are not clipped.
+ *
+ * @ingroup tizdsp
+ * @param ap_dst The mix buffer.
+ * @param ap_src The samples to add.
+ * @param a_nsamples The number of samples.
+ * @param a_gain The linear gain applied to the source samples.
+ */
+void
+tiz_dsp_mix_f32 (float * ap_dst, const float * ap_src, const size_t a_nsamples,
+                 const float a_gain);
+
+/**
+ * Sample rate converter quality presets. Higher presets use longer filters,
+ * i.e. a sharper transition band and more stop band attenuation, at a
+ * higher CPU cost.
+ * @ingroup tizdsp
+ */
+typedef enum tiz_dsp_resampler_quality
+{
+  TIZ_DSP_RESAMPLER_QUALITY_LOW = 0, /** 16 taps per phase */
+  TIZ_DSP_RESAMPLER_QUALITY_MEDIUM,  /** 32 taps per phase */
+  TIZ_DSP_RESAMPLER_QUALITY_HIGH     /** 64 taps per phase */
+} tiz_dsp_resampler_quality_t;
+
+/**
+ * Polyphase windowed-sinc sample rate converter.
+ *
+ * The conversion ratio is reduced to its lowest terms, L/M, and a bank of L
+ * Kaiser-windowed sinc filters is computed up front; each output frame is
+ * then a single dot product per channel. Integer ratios need a single filter
+ * (decimation) or one per output frame of each input frame (interpolation),
+ * and equal rates are a plain copy.
+ *
+ * @ingroup tizdsp
+ */
+typedef struct tiz_dsp_resampler tiz_dsp_resampler_t;
+typedef /*@null@ */ tiz_dsp_resampler_t * tiz_dsp_resampler_ptr_t;
+
+/**
+ * Create a sample rate converter.
+ *
+ * @ingroup tizdsp
+ * @param app_rs A pointer to the resampler that will be created.
+ * @param a_in_rate The input sampling rate.
+ * @param a_out_rate The output sampling rate.
+ * @param a_nchannels The number of channels.
+ * @param a_quality The quality preset.
+ * @return OMX_ErrorNone on success, OMX_ErrorInsufficientResources on OOM,
+ * or OMX_ErrorUnsupportedSetting if the ratio between the two rates is not
+ * supported.
+ */
+OMX_ERRORTYPE
+tiz_dsp_resampler_init (tiz_dsp_resampler_ptr_t * app_rs,
+                        const uint32_t a_in_rate, const uint32_t a_out_rate,
+                        const size_t a_nchannels,
+                        const tiz_dsp_resampler_quality_t a_quality);
+
+/**
+ * Destroy a sample rate converter.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_resampler_destroy (tiz_dsp_resampler_t * ap_rs);
+
+/**
+ * Discard the converter's history, e.g. after a seek.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_resampler_reset (tiz_dsp_resampler_t * ap_rs);
+
+/**
+ * Convert interleaved float samples.
+ *
+ * @ingroup tizdsp
+ * @param ap_rs The resampler.
+ * @param ap_in The input frames.
+ * @param ap_in_frames On input, the number of frames available; on output,
+ * the number of frames consumed.
+ * @param ap_out The output buffer.
+ * @param a_out_frames The capacity of the output buffer, in frames.
+ * @return The number of frames produced.
+ */
+size_t
+tiz_dsp_resampler_process (tiz_dsp_resampler_t * ap_rs, const float * ap_in,
+                           size_t * ap_in_frames, float * ap_out,
+                           const size_t a_out_frames);
+
+/**
+ * Return the number of frames buffered inside the converter, i.e. the
+ * filter's delay, expressed in output frames.
+ *
+ * @ingroup tizdsp
+ */
+size_t
+tiz_dsp_resampler_delay (const tiz_dsp_resampler_t * ap_rs);
+
+/**
+ * EBU R128 loudness meter.
+ *
+ * Measures the integrated loudness (ITU-R BS.1770-4, K-weighted and gated)
+ * and the true-peak level (4x oversampled) of a stream, one buffer at a
+ * time. The gating blocks are kept in a histogram of 0.1 LU bins, so the
+ * memory used does not depend on the length of the stream.
+ *
+ * @ingroup tizdsp
+ */
+typedef struct tiz_dsp_loudness tiz_dsp_loudness_t;
+typedef /*@null@ */ tiz_dsp_loudness_t * tiz_dsp_loudness_ptr_t;
+
+/**
+ * Create a loudness meter.
+ *
+ * @ingroup tizdsp
+ * @param app_lm A pointer to the meter that will be created.
+ * @param a_rate The sampling rate.
+ * @param a_nchannels The number of channels (up to 8).
+ * @return OMX_ErrorNone on success, OMX_ErrorInsufficientResources on OOM,
+ * or OMX_ErrorBadParameter.
+ */
+OMX_ERRORTYPE
+tiz_dsp_loudness_init (tiz_dsp_loudness_ptr_t * app_lm, const uint32_t a_rate,
+                       const size_t a_nchannels);
+
+/**
+ * Destroy a loudness meter.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_loudness_destroy (tiz_dsp_loudness_t * ap_lm);
+
+/**
+ * Discard all measurements, e.g. before a new stream.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_loudness_reset (tiz_dsp_loudness_t * ap_lm);
+
+/**
+ * Measure interleaved 16-bit frames.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_loudness_s16 (tiz_dsp_loudness_t * ap_lm, const int16_t * ap_samples,
+                      const size_t a_nframes);
+
+/**
+ * Measure interleaved float frames.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_loudness_f32 (tiz_dsp_loudness_t * ap_lm, const float * ap_samples,
+                      const size_t a_nframes);
+
+/**
+ * Return the integrated loudness of the frames measured so far.
+ *
+ * @ingroup tizdsp
+ * @return The loudness in LUFS, or -HUGE_VALF if no 400ms block was louder
+ * than the absolute gate (-70 LUFS).
+ */
+float
+tiz_dsp_loudness_integrated (const tiz_dsp_loudness_t * ap_lm);
+
+/**
+ * Return the true-peak level of the frames measured so far.
+ *
+ * @ingroup tizdsp
+ * @return The linear peak (1.0 is full scale).
+ */
+float
+tiz_dsp_loudness_true_peak (const tiz_dsp_loudness_t * ap_lm);
+
+/**
+ * Return the number of frames measured since the last reset.
+ *
+ * @ingroup tizdsp
+ */
+uint64_t
+tiz_dsp_loudness_frames (const tiz_dsp_loudness_t * ap_lm);
+
+/**
+ * Biquad filter shapes (see R. Bristow-Johnson's "Audio EQ Cookbook").
+ * @ingroup tizdsp
+ */
+typedef enum tiz_dsp_biquad_type
+{
+  TIZ_DSP_BIQUAD_PEAKING = 0, /** Boost or cut around a centre frequency */
+  TIZ_DSP_BIQUAD_LOW_SHELF,   /** Boost or cut below a corner frequency */
+  TIZ_DSP_BIQUAD_HIGH_SHELF,  /** Boost or cut above a corner frequency */
+  TIZ_DSP_BIQUAD_LOW_PASS,    /** 12dB/octave low-pass */
+  TIZ_DSP_BIQUAD_HIGH_PASS    /** 12dB/octave high-pass */
+} tiz_dsp_biquad_type_t;
+
+/**
+ * The coefficients of a second-order section, normalised so that a0 is 1.
+ * @ingroup tizdsp
+ */
+typedef struct tiz_dsp_biquad tiz_dsp_biquad_t;
+struct tiz_dsp_biquad
+{
+  float b0, b1, b2, a1, a2;
+};
+
+/**
+ * Compute the coefficients of a biquad filter.
+ *
+ * @ingroup tizdsp
+ * @param ap_bq The coefficients.
+ * @param a_type The filter's shape.
+ * @param a_rate The sampling rate.
+ * @param a_freq The centre or corner frequency, in Hz, below a_rate / 2.
+ * @param a_q The quality factor (e.g. 0.707 for a Butterworth response).
+ * @param a_gain_db The boost or cut (peaking and shelf filters only).
+ * @return OMX_ErrorNone on success, or OMX_ErrorBadParameter.
+ */
+OMX_ERRORTYPE
+tiz_dsp_biquad_design (tiz_dsp_biquad_t * ap_bq,
+                       const tiz_dsp_biquad_type_t a_type,
+                       const uint32_t a_rate, const float a_freq,
+                       const float a_q, const float a_gain_db);
+
+/**
+ * Equalizer: a cascade of up to 16 biquad sections, followed by an optional
+ * FIR filter of up to 4096 taps (e.g. a room correction filter).
+ *
+ * The sections run on groups of four channels at once. New coefficients are
+ * reached gradually, so they can be changed while a stream plays.
+ *
+ * @ingroup tizdsp
+ */
+typedef struct tiz_dsp_eq tiz_dsp_eq_t;
+typedef /*@null@ */ tiz_dsp_eq_t * tiz_dsp_eq_ptr_t;
+
+/**
+ * Create an equalizer, with no filters.
+ *
+ * @ingroup tizdsp
+ * @param app_eq A pointer to the equalizer that will be created.
+ * @param a_nchannels The number of channels (up to 8).
+ * @return OMX_ErrorNone on success, OMX_ErrorInsufficientResources on OOM,
+ * or OMX_ErrorBadParameter.
+ */
+OMX_ERRORTYPE
+tiz_dsp_eq_init (tiz_dsp_eq_ptr_t * app_eq, const size_t a_nchannels);
+
+/**
+ * Destroy an equalizer.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_eq_destroy (tiz_dsp_eq_t * ap_eq);
+
+/**
+ * Discard the filters' histories, e.g. after a seek.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_eq_reset (tiz_dsp_eq_t * ap_eq);
+
+/**
+ * Replace the biquad cascade.
+ *
+ * @ingroup tizdsp
+ * @param ap_eq The equalizer.
+ * @param ap_sections The new sections (NULL to remove them all).
+ * @param a_nsections The number of sections.
+ * @param a_ramp_frames The number of frames over which the coefficients
+ * move from the old values to the new ones (0 to switch at once).
+ * @return OMX_ErrorNone on success, or OMX_ErrorBadParameter.
+ */
+OMX_ERRORTYPE
+tiz_dsp_eq_set_biquads (tiz_dsp_eq_t * ap_eq,
+                        const tiz_dsp_biquad_t * ap_sections,
+                        const size_t a_nsections, const size_t a_ramp_frames);
+
+/**
+ * Replace the FIR filter. The filter's history is discarded.
+ *
+ * @ingroup tizdsp
+ * @param ap_eq The equalizer.
+ * @param ap_taps The filter's impulse response (NULL to remove it).
+ * @param a_ntaps The number of taps.
+ * @return OMX_ErrorNone on success, OMX_ErrorInsufficientResources on OOM,
+ * or OMX_ErrorBadParameter.
+ */
+OMX_ERRORTYPE
+tiz_dsp_eq_set_fir (tiz_dsp_eq_t * ap_eq, const float * ap_taps,
+                    const size_t a_ntaps);
+
+/**
+ * Filter interleaved float frames, in place.
+ *
+ * @ingroup tizdsp
+ */
+void
+tiz_dsp_eq_process_f32 (tiz_dsp_eq_t * ap_eq, float * ap_samples,
+                        const size_t a_nframes);
+
+/**
+ * Whether the equalizer currently leaves the samples unchanged, i.e. it has
+ * no sections (and is not ramping any out) and no FIR filter.
+ *
+ * @ingroup tizdsp
+ */
+bool
+tiz_dsp_eq_bypassed (const tiz_dsp_eq_t * ap_eq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIZDSP_H */
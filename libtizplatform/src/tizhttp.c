@@ -393,3 +393,10 @@ tiz_http_parser_get_method (tiz_http_parser_t * ap_parser)
   assert (ap_parser);
   return http_method_str (((http_parser *) ap_parser)->method);
 }
+
+bool
+tiz_http_parser_should_keep_alive (tiz_http_parser_t * ap_parser)
+{
+  assert (ap_parser);
+  return 0 != http_should_keep_alive ((http_parser *) ap_parser);
+}
@@ -33,6 +33,8 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+
 #include <OMX_Core.h>
 #include <OMX_Types.h>
 
@@ -61,6 +63,10 @@ const char *
 tiz_http_parser_get_url (tiz_http_parser_t * ap_parser);
 const char *
 tiz_http_parser_get_method (tiz_http_parser_t * ap_parser);
+/* Whether the connection may be kept open after the message just parsed,
+   as per its HTTP version and Connection header */
+bool
+tiz_http_parser_should_keep_alive (tiz_http_parser_t * ap_parser);
 /* Return a string name of the last parser error */
 const char *
 tiz_http_parser_errno_name (tiz_http_parser_t * ap_parser);
@@ -659,6 +659,14 @@ static const tiz_idx_str_t tiz_idx_to_str_tbl[] = {
    (const OMX_STRING) "OMX_TizoniaIndexParamAudioPlexSession"},
   {OMX_TizoniaIndexParamAudioPlexPlaylist,
    (const OMX_STRING) "OMX_TizoniaIndexParamAudioPlexPlaylist"},
+  {OMX_TizoniaIndexConfigAudioRendererBuffering,
+   (const OMX_STRING) "OMX_TizoniaIndexConfigAudioRendererBuffering"},
+  {OMX_TizoniaIndexConfigAudioLoudness,
+   (const OMX_STRING) "OMX_TizoniaIndexConfigAudioLoudness"},
+  {OMX_TizoniaIndexConfigAudioEqualizer,
+   (const OMX_STRING) "OMX_TizoniaIndexConfigAudioEqualizer"},
+  {OMX_TizoniaIndexParamAudioEncoderOutputs,
+   (const OMX_STRING) "OMX_TizoniaIndexParamAudioEncoderOutputs"},
   {OMX_IndexKhronosExtensions, (const OMX_STRING) "OMX_IndexKhronosExtensions"},
   {OMX_IndexVendorStartUnused, (const OMX_STRING) "OMX_IndexVendorStartUnused"},
   {OMX_IndexMax, (const OMX_STRING) "OMX_IndexMax"}};
@@ -56,6 +56,7 @@
 #include "tizprintf.h"
 #include "tizshufflelst.h"
 #include "tizurltransfer.h"
+#include "tizdsp.h"
 
 /** @} */
 
@@ -191,6 +191,38 @@ tiz_thread_setname (tiz_thread_t * ap_thread, const OMX_STRING a_name)
   return rc;
 }
 
+OMX_ERRORTYPE
+tiz_thread_set_rt_priority (OMX_S32 a_priority)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  struct sched_param param;
+  int policy = SCHED_OTHER;
+  int error = 0;
+
+  param.sched_priority = 0;
+  if (a_priority > 0)
+    {
+      const int min = sched_get_priority_min (SCHED_FIFO);
+      const int max = sched_get_priority_max (SCHED_FIFO);
+      policy = SCHED_FIFO;
+      param.sched_priority
+        = a_priority < min ? min : (a_priority > max ? max : a_priority);
+    }
+
+  if (PTHREAD_SUCCESS
+      != (error = pthread_setschedparam (pthread_self (), policy, &param)))
+    {
+      TIZ_LOG (TIZ_PRIORITY_NOTICE,
+               "Could not set the thread's scheduling policy to [%s] "
+               "priority [%d] (%s).",
+               SCHED_FIFO == policy ? "SCHED_FIFO" : "SCHED_OTHER",
+               param.sched_priority, strerror (error));
+      rc = OMX_ErrorUndefined;
+    }
+
+  return rc;
+}
+
 OMX_S32
 tiz_sleep (OMX_U32 usec)
 {
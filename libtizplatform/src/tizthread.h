@@ -104,6 +104,21 @@ tiz_thread_exit (OMX_PTR a_status);
 OMX_S32
 tiz_thread_id (void);
 
+/**
+ * Switch the calling thread to the real-time FIFO scheduling policy, or back
+ * to the default time-sharing policy.
+ *
+ * @ingroup tizthread
+ *
+ * @param a_priority The SCHED_FIFO priority (clamped to the range supported
+ * by the system), or 0 to revert to SCHED_OTHER.
+ *
+ * @return OMX_ErrorNone if success, OMX_ErrorUndefined otherwise (e.g. if
+ * the process lacks the privileges to use real-time scheduling).
+ */
+OMX_ERRORTYPE
+tiz_thread_set_rt_priority (OMX_S32 a_priority);
+
 /**
  * Sleep for the specified number of micro seconds.
  *
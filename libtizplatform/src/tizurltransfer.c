@@ -177,6 +177,7 @@ static const httpsrc_curl_state_id_str_t httpsrc_curl_state_id_str_tbl[]
 struct tiz_urltrans
 {
   void * p_parent_;                        /* not owned */
+  void * p_cbacks_arg_;                    /* not owned */
   OMX_STRING p_comp_name_;                 /* not owned */
   OMX_PARAM_CONTENTURITYPE * p_uri_param_; /* not owned */
   size_t store_bytes_;
@@ -616,7 +617,8 @@ send_from_internal_buffer (tiz_urltrans_t * p_trans)
 
   while (
     (nbytes_available = tiz_buffer_available (p_trans->p_store_)) > 0
-    && (p_out = p_trans->buffer_cbacks_.pf_buf_emptied (p_trans->p_parent_))
+    && (p_out
+        = p_trans->buffer_cbacks_.pf_buf_emptied (p_trans->p_cbacks_arg_))
          != NULL)
     {
       int nbytes_copied = copy_to_omx_buffer (
@@ -625,7 +627,7 @@ send_from_internal_buffer (tiz_urltrans_t * p_trans)
         "Releasing buffer with size [%u] available [%u].",
         (unsigned int) p_out->nFilledLen,
         tiz_buffer_available (p_trans->p_store_) - nbytes_copied);
-      p_trans->buffer_cbacks_.pf_buf_filled (p_out, p_trans->p_parent_);
+      p_trans->buffer_cbacks_.pf_buf_filled (p_out, p_trans->p_cbacks_arg_);
       (void) tiz_buffer_advance (p_trans->p_store_, nbytes_copied);
       p_out = NULL;
     }
@@ -649,7 +651,7 @@ report_connection_lost_event (tiz_urltrans_t * ap_trans)
   set_curl_state (ap_trans, ECurlStateStopped);
   send_from_internal_buffer (ap_trans);
   auto_reconnect
-    = ap_trans->info_cbacks_.pf_connection_lost (ap_trans->p_parent_);
+    = ap_trans->info_cbacks_.pf_connection_lost (ap_trans->p_cbacks_arg_);
   reset_initial_buffer_size (ap_trans);
   if (auto_reconnect)
     {
@@ -676,7 +678,7 @@ curl_header_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
   assert (p_trans->info_cbacks_.pf_header_avail);
   URLTRANS_LOG_CBACK_START (p_trans);
   stop_reconnect_timer_watcher (p_trans);
-  p_trans->info_cbacks_.pf_header_avail (p_trans->p_parent_, ptr, nbytes);
+  p_trans->info_cbacks_.pf_header_avail (p_trans->p_cbacks_arg_, ptr, nbytes);
   URLTRANS_LOG_CBACK_END (p_trans);
   return nbytes;
 }
@@ -701,7 +703,8 @@ curl_write_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
       set_curl_state (p_trans, ECurlStateTransfering);
       OMX_BUFFERHEADERTYPE * p_out = NULL;
 
-      if (p_trans->info_cbacks_.pf_data_avail (p_trans->p_parent_, ptr, nbytes))
+      if (p_trans->info_cbacks_.pf_data_avail (p_trans->p_cbacks_arg_, ptr,
+                                               nbytes))
         {
           /* Stop the watchers */
           stop_io_watcher (p_trans);
@@ -724,14 +727,14 @@ curl_write_cback (void * ptr, size_t size, size_t nmemb, void * userdata)
 
               while (nbytes > 0
                      && (p_out = p_trans->buffer_cbacks_.pf_buf_emptied (
-                           p_trans->p_parent_))
+                           p_trans->p_cbacks_arg_))
                           != NULL)
                 {
                   int nbytes_copied = copy_to_omx_buffer (p_out, ptr, nbytes);
                   TIZ_PRINTF_DBG_CYN ("Releasing buffer with size [%u]",
                                       (unsigned int) p_out->nFilledLen);
-                  p_trans->buffer_cbacks_.pf_buf_filled (p_out,
-                                                         p_trans->p_parent_);
+                  p_trans->buffer_cbacks_.pf_buf_filled (
+                    p_out, p_trans->p_cbacks_arg_);
                   nbytes -= nbytes_copied;
                   ptr += nbytes_copied;
                 }
@@ -1074,6 +1077,7 @@ tiz_urltrans_init (tiz_urltrans_ptr_t * app_trans, void * ap_parent,
       if (p_trans)
         {
           p_trans->p_parent_ = ap_parent;       /* Not owned */
+          p_trans->p_cbacks_arg_ = ap_parent;   /* Not owned */
           p_trans->p_comp_name_ = ap_comp_name; /* Not owned */
           p_trans->p_uri_param_ = ap_uri_param; /* Not owned */
           p_trans->store_bytes_ = a_store_bytes;
@@ -1158,6 +1162,25 @@ end:
   return;
 }
 
+void
+tiz_urltrans_set_cbacks (tiz_urltrans_t * ap_trans, void * ap_arg,
+                         const tiz_urltrans_buffer_cbacks_t a_buffer_cbacks,
+                         const tiz_urltrans_info_cbacks_t a_info_cbacks)
+{
+  assert (ap_trans);
+  assert (a_buffer_cbacks.pf_buf_filled);
+  assert (a_buffer_cbacks.pf_buf_emptied);
+  assert (a_info_cbacks.pf_header_avail);
+  assert (a_info_cbacks.pf_data_avail);
+  assert (a_info_cbacks.pf_connection_lost);
+  assert (ap_arg);
+  URLTRANS_LOG_API_START (ap_trans);
+  ap_trans->p_cbacks_arg_ = ap_arg;
+  ap_trans->buffer_cbacks_ = a_buffer_cbacks;
+  ap_trans->info_cbacks_ = a_info_cbacks;
+  URLTRANS_LOG_API_END (ap_trans);
+}
+
 void
 tiz_urltrans_set_connect_timeout (tiz_urltrans_t * ap_trans,
                                   const long a_connect_timeout)
@@ -299,6 +299,27 @@ void
 tiz_urltrans_set_uri (tiz_urltrans_t * ap_trans,
                       OMX_PARAM_CONTENTURITYPE * ap_uri_param);
 
+/**
+ * Replace the buffer and informational callbacks of an existing URL file
+ * transfer object. This allows a processor to keep a second transfer running
+ * (e.g. to pre-roll the next item in a playlist) and later promote it to be
+ * the main transfer without interrupting the connection.
+ *
+ * @param ap_trans The URL file transfer object.
+ *
+ * @param ap_arg The argument that the buffer and informational callbacks
+ * receive from now on (the io and timer callbacks keep receiving the
+ * parent object).
+ *
+ * @param a_buffer_cbacks Buffer callbacks registration structure.
+ *
+ * @param a_info_cbacks Informational callbacks registration structure.
+ */
+void
+tiz_urltrans_set_cbacks (tiz_urltrans_t * ap_trans, void * ap_arg,
+                         const tiz_urltrans_buffer_cbacks_t a_buffer_cbacks,
+                         const tiz_urltrans_info_cbacks_t a_info_cbacks);
+
 void
 tiz_urltrans_set_connect_timeout (tiz_urltrans_t * ap_trans,
                                   const long a_connect_timeout);
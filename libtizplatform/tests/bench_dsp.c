@@ -0,0 +1,274 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_dsp.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  PCM processing kernels benchmark
+ *
+ * Runs each kernel over one second's worth of 48KHz stereo samples, many
+ * times, with each of the available SIMD implementations, and prints the
+ * throughput in millions of samples per second.
+ *
+ * Usage: bench_dsp [iterations]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/tizplatform.h"
+
+#define BENCH_DSP_NFRAMES 48000
+#define BENCH_DSP_NSAMPLES (BENCH_DSP_NFRAMES * 2)
+#define BENCH_DSP_DEFAULT_ITERATIONS 500
+
+static int16_t g_s16[BENCH_DSP_NSAMPLES];
+static int16_t g_s16_out[BENCH_DSP_NSAMPLES];
+static int32_t g_s32[BENCH_DSP_NSAMPLES];
+static float g_f32[BENCH_DSP_NSAMPLES];
+static float g_f32_out[BENCH_DSP_NSAMPLES];
+static uint8_t g_s24[BENCH_DSP_NSAMPLES * 3];
+static uint32_t g_dither = 1;
+static int g_toggle = 0;
+static tiz_dsp_eq_t * gp_eq = NULL;
+
+typedef void (*bench_dsp_kernel_f) (void);
+
+/* In-place gains alternate between attenuation and amplification, so that
+   the samples don't decay into denormals over the iterations */
+static float
+next_gain (void)
+{
+  g_toggle = !g_toggle;
+  return g_toggle ? 0.7f : 1.0f / 0.7f;
+}
+
+static void
+bench_gain_s16 (void)
+{
+  tiz_dsp_gain_s16 (g_s16, BENCH_DSP_NSAMPLES, next_gain ());
+}
+
+static void
+bench_gain_s16_q12 (void)
+{
+  tiz_dsp_gain_s16_q12 (g_s16, BENCH_DSP_NSAMPLES,
+                        (int16_t) (next_gain () * 4096));
+}
+
+static void
+bench_gain_f32 (void)
+{
+  tiz_dsp_gain_f32 (g_f32, BENCH_DSP_NSAMPLES, next_gain ());
+}
+
+static void
+bench_s16_to_f32 (void)
+{
+  tiz_dsp_s16_to_f32 (g_f32_out, g_s16, BENCH_DSP_NSAMPLES);
+}
+
+static void
+bench_f32_to_s16 (void)
+{
+  tiz_dsp_f32_to_s16 (g_s16_out, g_f32, BENCH_DSP_NSAMPLES, NULL);
+}
+
+static void
+bench_f32_to_s16_dither (void)
+{
+  tiz_dsp_f32_to_s16 (g_s16_out, g_f32, BENCH_DSP_NSAMPLES, &g_dither);
+}
+
+static void
+bench_f32_to_s24 (void)
+{
+  tiz_dsp_f32_to_s24 (g_s24, g_f32, BENCH_DSP_NSAMPLES, NULL);
+}
+
+static void
+bench_fixed_to_s16 (void)
+{
+  tiz_dsp_fixed_to_s16 (g_s16_out, g_s32, BENCH_DSP_NSAMPLES, 28);
+}
+
+static void
+bench_interleave_s16 (void)
+{
+  const int16_t * planes[2] = {g_s16, g_s16 + BENCH_DSP_NFRAMES};
+  tiz_dsp_interleave_s16 (g_s16_out, planes, 2, BENCH_DSP_NFRAMES);
+}
+
+static void
+bench_interleave_s32_to_s16 (void)
+{
+  const int32_t * planes[2] = {g_s32, g_s32 + BENCH_DSP_NFRAMES};
+  tiz_dsp_interleave_s32_to_s16 (g_s16_out, planes, 2, BENCH_DSP_NFRAMES);
+}
+
+static void
+bench_deinterleave_f32 (void)
+{
+  float * planes[2] = {g_f32_out, g_f32_out + BENCH_DSP_NFRAMES};
+  tiz_dsp_deinterleave_f32 (planes, g_f32, 2, BENCH_DSP_NFRAMES);
+}
+
+static void
+bench_bswap16 (void)
+{
+  tiz_dsp_bswap16 (g_s16, BENCH_DSP_NSAMPLES);
+}
+
+static void
+bench_bswap32 (void)
+{
+  tiz_dsp_bswap32 (g_s32, BENCH_DSP_NSAMPLES);
+}
+
+static void
+bench_dot_f32 (void)
+{
+  g_f32_out[0] = tiz_dsp_dot_f32 (g_f32, g_f32 + BENCH_DSP_NFRAMES,
+                                  BENCH_DSP_NFRAMES);
+}
+
+static void
+bench_mix_f32 (void)
+{
+  tiz_dsp_mix_f32 (g_f32_out, g_f32, BENCH_DSP_NSAMPLES, next_gain () * 0.5f);
+}
+
+static void
+bench_eq_f32 (void)
+{
+  memcpy (g_f32_out, g_f32, sizeof (g_f32_out));
+  tiz_dsp_eq_process_f32 (gp_eq, g_f32_out, BENCH_DSP_NFRAMES);
+}
+
+static const struct
+{
+  const char * p_name;
+  bench_dsp_kernel_f pf_kernel;
+} g_kernels[] = {
+  {"gain_s16", bench_gain_s16},
+  {"gain_s16_q12", bench_gain_s16_q12},
+  {"gain_f32", bench_gain_f32},
+  {"s16_to_f32", bench_s16_to_f32},
+  {"f32_to_s16", bench_f32_to_s16},
+  {"f32_to_s16 (dither)", bench_f32_to_s16_dither},
+  {"f32_to_s24", bench_f32_to_s24},
+  {"fixed_to_s16", bench_fixed_to_s16},
+  {"interleave_s16", bench_interleave_s16},
+  {"interleave_s32_to_s16", bench_interleave_s32_to_s16},
+  {"deinterleave_f32", bench_deinterleave_f32},
+  {"bswap16", bench_bswap16},
+  {"bswap32", bench_bswap32},
+  {"dot_f32", bench_dot_f32},
+  {"mix_f32", bench_mix_f32},
+  {"eq_f32 (4 sections)", bench_eq_f32},
+};
+
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main (int argc, char ** argv)
+{
+  const tiz_dsp_simd_t levels[] = {TIZ_DSP_SIMD_NONE, TIZ_DSP_SIMD_SSE2,
+                                   TIZ_DSP_SIMD_AVX2, TIZ_DSP_SIMD_NEON};
+  const size_t nlevels = sizeof (levels) / sizeof (levels[0]);
+  const size_t nkernels = sizeof (g_kernels) / sizeof (g_kernels[0]);
+  int iterations = argc > 1 ? atoi (argv[1]) : BENCH_DSP_DEFAULT_ITERATIONS;
+  tiz_dsp_biquad_t sections[4];
+  size_t k = 0, l = 0;
+  int i = 0;
+
+  if (iterations <= 0)
+    {
+      iterations = BENCH_DSP_DEFAULT_ITERATIONS;
+    }
+
+  srand (1);
+  for (i = 0; i < BENCH_DSP_NSAMPLES; ++i)
+    {
+      g_s16[i] = (int16_t) (rand () - RAND_MAX / 2);
+      g_s32[i] = (int32_t) ((rand () << 1) ^ rand ());
+      g_f32[i] = (rand () / (float) RAND_MAX) - 0.5f;
+    }
+
+  for (k = 0; k < 4; ++k)
+    {
+      tiz_dsp_biquad_design (&sections[k], TIZ_DSP_BIQUAD_PEAKING, 48000,
+                             100.0f * (k + 1) * (k + 1), 1.0f, 3.0f);
+    }
+  if (OMX_ErrorNone != tiz_dsp_eq_init (&gp_eq, 2)
+      || OMX_ErrorNone != tiz_dsp_eq_set_biquads (gp_eq, sections, 4, 0))
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf ("%-22s", "Msamples/s");
+  for (l = 0; l < nlevels; ++l)
+    {
+      if (levels[l] == tiz_dsp_set_simd (levels[l]))
+        {
+          printf ("%10s", tiz_dsp_simd_to_str (levels[l]));
+        }
+    }
+  printf ("\n");
+
+  for (k = 0; k < nkernels; ++k)
+    {
+      printf ("%-22s", g_kernels[k].p_name);
+      for (l = 0; l < nlevels; ++l)
+        {
+          double start = 0;
+          double elapsed = 0;
+          if (levels[l] != tiz_dsp_set_simd (levels[l]))
+            {
+              continue;
+            }
+          /* Warm up */
+          g_kernels[k].pf_kernel ();
+          start = now ();
+          for (i = 0; i < iterations; ++i)
+            {
+              g_kernels[k].pf_kernel ();
+            }
+          elapsed = now () - start;
+          printf ("%10.1f", elapsed > 0
+                              ? (double) BENCH_DSP_NSAMPLES * iterations
+                                  / elapsed / 1e6
+                              : 0.0);
+        }
+      printf ("\n");
+    }
+
+  tiz_dsp_eq_destroy (gp_eq);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,619 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_dsp.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  PCM processing kernels unit tests
+ *
+ *
+ */
+
+#include <math.h>
+#include <string.h>
+
+/* Not a multiple of any vector width, to exercise the tails */
+#define DSP_TEST_NSAMPLES 1037
+
+static const tiz_dsp_simd_t g_dsp_simd_levels[]
+  = {TIZ_DSP_SIMD_SSE2, TIZ_DSP_SIMD_AVX2, TIZ_DSP_SIMD_NEON};
+
+static void
+dsp_fill_random (int16_t * ap_s16, int32_t * ap_s32, float * ap_f32)
+{
+  int i = 0;
+  srand (1);
+  for (i = 0; i < DSP_TEST_NSAMPLES; ++i)
+    {
+      ap_s16[i] = (int16_t) (rand () - RAND_MAX / 2);
+      ap_s32[i] = (int32_t) (((uint32_t) rand () << 1) ^ (uint32_t) rand ());
+      /* Some of these are out of range, to check the saturation */
+      ap_f32[i] = ((rand () / (float) RAND_MAX) - 0.5f) * 2.5f;
+    }
+}
+
+START_TEST (test_dsp_gain_and_saturation)
+{
+  int16_t s16[4] = {32767, -32768, 100, -100};
+  float f32[2] = {0.5f, -0.25f};
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_gain_and_saturation - begin");
+
+  tiz_dsp_gain_s16 (s16, 4, 2.0f);
+  fail_if (s16[0] != 32767);
+  fail_if (s16[1] != -32768);
+  fail_if (s16[2] != 200);
+  fail_if (s16[3] != -200);
+
+  /* 0.5 in Q3.12 */
+  tiz_dsp_gain_s16_q12 (s16, 4, 2048);
+  fail_if (s16[0] != 16384);
+  fail_if (s16[1] != -16384);
+  fail_if (s16[2] != 100);
+  fail_if (s16[3] != -100);
+
+  tiz_dsp_gain_f32 (f32, 2, 4.0f);
+  fail_if (f32[0] != 2.0f);
+  fail_if (f32[1] != -1.0f);
+
+  fail_if (fabsf (tiz_dsp_db_to_gain (-6.0f) - 0.501187f) > 1e-5f);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_gain_and_saturation - end");
+}
+END_TEST
+
+START_TEST (test_dsp_format_conversion)
+{
+  int16_t s16[3] = {-32768, 0, 16384};
+  float f32[3];
+  int32_t s32[3];
+  uint8_t s24[9];
+  int16_t out[3];
+  int32_t fixed[3] = {0x10000000, -0x10000000, 0x08000000}; /* 1, -1, .5 */
+  uint32_t dither = 1;
+  float zeros[64];
+  int16_t dithered[64];
+  int i = 0;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_format_conversion - begin");
+
+  tiz_dsp_s16_to_f32 (f32, s16, 3);
+  fail_if (f32[0] != -1.0f);
+  fail_if (f32[1] != 0.0f);
+  fail_if (f32[2] != 0.5f);
+
+  tiz_dsp_f32_to_s16 (out, f32, 3, NULL);
+  fail_if (0 != memcmp (out, s16, sizeof (s16)));
+
+  tiz_dsp_f32_to_s24 (s24, f32, 3, NULL);
+  fail_if (s24[0] != 0x00 || s24[1] != 0x00 || s24[2] != 0x80);
+  fail_if (s24[6] != 0x00 || s24[7] != 0x00 || s24[8] != 0x40);
+  tiz_dsp_s24_to_f32 (f32, s24, 3);
+  fail_if (f32[0] != -1.0f || f32[1] != 0.0f || f32[2] != 0.5f);
+
+  tiz_dsp_f32_to_s32 (s32, f32, 3);
+  fail_if (s32[0] != INT32_MIN || s32[1] != 0 || s32[2] != 0x40000000);
+  tiz_dsp_s32_to_f32 (f32, s32, 3);
+  fail_if (f32[0] != -1.0f || f32[1] != 0.0f || f32[2] != 0.5f);
+
+  /* libmad's format: 28 fractional bits */
+  tiz_dsp_fixed_to_s16 (out, fixed, 3, 28);
+  fail_if (out[0] != 32767 || out[1] != -32768 || out[2] != 16384);
+
+  /* Dither on silence must stay within one LSB */
+  memset (zeros, 0, sizeof (zeros));
+  tiz_dsp_f32_to_s16 (dithered, zeros, 64, &dither);
+  for (i = 0; i < 64; ++i)
+    {
+      fail_if (dithered[i] < -1 || dithered[i] > 1);
+    }
+  fail_if (1 == dither);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_format_conversion - end");
+}
+END_TEST
+
+START_TEST (test_dsp_channels_and_byte_order)
+{
+  const int16_t left[3] = {1, 2, 3};
+  const int16_t right[3] = {-1, -2, -3};
+  const int16_t * planes[2] = {left, right};
+  const int16_t expected[6] = {1, -1, 2, -2, 3, -3};
+  int16_t ilv[6];
+  const int32_t wide_left[2] = {40000, -8388609};
+  const int32_t wide_right[2] = {-40000, 0x123456};
+  const int32_t * wide_planes[2] = {wide_left, wide_right};
+  uint8_t s24[6 * 3];
+  const float src[4] = {0.1f, 0.2f, 0.3f, 0.4f};
+  float l[2], r[2];
+  float * dst_planes[2] = {l, r};
+  const float surround[6] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+  float stereo[2];
+  float mono[1];
+  uint16_t u16 = 0x1234;
+  uint32_t u32 = 0x12345678;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_channels_and_byte_order - begin");
+
+  tiz_dsp_interleave_s16 (ilv, planes, 2, 3);
+  fail_if (0 != memcmp (ilv, expected, sizeof (expected)));
+
+  tiz_dsp_interleave_s32_to_s16 (ilv, wide_planes, 2, 2);
+  fail_if (ilv[0] != 32767 || ilv[1] != -32768);
+  fail_if (ilv[2] != -32768 || ilv[3] != 32767);
+
+  tiz_dsp_interleave_s32_to_s24 (s24, wide_planes, 2, 2);
+  fail_if (s24[0] != 0x40 || s24[1] != 0x9c || s24[2] != 0x00);
+  fail_if (s24[6] != 0x00 || s24[7] != 0x00 || s24[8] != 0x80);
+  fail_if (s24[9] != 0x56 || s24[10] != 0x34 || s24[11] != 0x12);
+
+  tiz_dsp_deinterleave_f32 (dst_planes, src, 2, 2);
+  fail_if (l[0] != 0.1f || l[1] != 0.3f || r[0] != 0.2f || r[1] != 0.4f);
+
+  /* A full-scale 5.1 frame must not clip when folded down to stereo */
+  tiz_dsp_remix_f32 (stereo, 2, surround, 6, 1);
+  fail_if (fabsf (stereo[0] - 1.0f) > 1e-6f);
+  fail_if (fabsf (stereo[1] - 1.0f) > 1e-6f);
+
+  tiz_dsp_remix_f32 (mono, 1, src, 2, 1);
+  fail_if (fabsf (mono[0] - 0.15f) > 1e-6f);
+
+  tiz_dsp_remix_f32 (stereo, 2, src, 1, 1);
+  fail_if (stereo[0] != 0.1f || stereo[1] != 0.1f);
+
+  tiz_dsp_bswap16 (&u16, 1);
+  fail_if (u16 != 0x3412);
+  tiz_dsp_bswap32 (&u32, 1);
+  fail_if (u32 != 0x78563412);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_channels_and_byte_order - end");
+}
+END_TEST
+
+START_TEST (test_dsp_simd_matches_c)
+{
+  int16_t s16[DSP_TEST_NSAMPLES];
+  int32_t s32[DSP_TEST_NSAMPLES];
+  float f32[DSP_TEST_NSAMPLES];
+  int16_t ref[DSP_TEST_NSAMPLES];
+  int16_t out[DSP_TEST_NSAMPLES];
+  float fref[DSP_TEST_NSAMPLES];
+  float fout[DSP_TEST_NSAMPLES];
+  const tiz_dsp_simd_t orig = tiz_dsp_simd ();
+  size_t i = 0;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_simd_matches_c - begin");
+
+  dsp_fill_random (s16, s32, f32);
+
+  for (i = 0; i < sizeof (g_dsp_simd_levels) / sizeof (g_dsp_simd_levels[0]);
+       ++i)
+    {
+      const int16_t * planes[2] = {s16, s16 + DSP_TEST_NSAMPLES / 2};
+      const int32_t * wide_planes[2] = {s32, s32 + DSP_TEST_NSAMPLES / 2};
+      if (g_dsp_simd_levels[i] != tiz_dsp_set_simd (g_dsp_simd_levels[i]))
+        {
+          continue;
+        }
+
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "checking [%s]",
+               tiz_dsp_simd_to_str (g_dsp_simd_levels[i]));
+
+#define DSP_CHECK_S16(call)                          \
+  do                                                 \
+    {                                                \
+      memcpy (ref, s16, sizeof (ref));               \
+      memcpy (out, s16, sizeof (out));               \
+      tiz_dsp_set_simd (TIZ_DSP_SIMD_NONE);          \
+      {                                              \
+        int16_t * p_buf = ref;                       \
+        call;                                        \
+      }                                              \
+      tiz_dsp_set_simd (g_dsp_simd_levels[i]);       \
+      {                                              \
+        int16_t * p_buf = out;                       \
+        call;                                        \
+      }                                              \
+      fail_if (0 != memcmp (ref, out, sizeof (ref))); \
+    }                                                \
+  while (0)
+
+      DSP_CHECK_S16 (tiz_dsp_gain_s16 (p_buf, DSP_TEST_NSAMPLES, 1.7f));
+      DSP_CHECK_S16 (tiz_dsp_gain_s16_q12 (p_buf, DSP_TEST_NSAMPLES, 6000));
+      DSP_CHECK_S16 (tiz_dsp_f32_to_s16 (p_buf, f32, DSP_TEST_NSAMPLES, NULL));
+      DSP_CHECK_S16 (tiz_dsp_fixed_to_s16 (p_buf, s32, DSP_TEST_NSAMPLES, 28));
+      DSP_CHECK_S16 (tiz_dsp_bswap16 (p_buf, DSP_TEST_NSAMPLES));
+      DSP_CHECK_S16 (tiz_dsp_bswap32 (p_buf, DSP_TEST_NSAMPLES / 2));
+      DSP_CHECK_S16 (
+        tiz_dsp_interleave_s16 (p_buf, planes, 2, DSP_TEST_NSAMPLES / 2));
+      DSP_CHECK_S16 (tiz_dsp_interleave_s32_to_s16 (p_buf, wide_planes, 2,
+                                                    DSP_TEST_NSAMPLES / 2));
+
+#undef DSP_CHECK_S16
+
+      tiz_dsp_set_simd (TIZ_DSP_SIMD_NONE);
+      fref[0] = tiz_dsp_dot_f32 (f32, f32 + 512, 512);
+      tiz_dsp_set_simd (g_dsp_simd_levels[i]);
+      fail_if (fabsf (fref[0] - tiz_dsp_dot_f32 (f32, f32 + 512, 512))
+               > 1e-4f * fabsf (fref[0]));
+
+      {
+        size_t j = 0;
+        memcpy (fref, f32, sizeof (fref));
+        memcpy (fout, f32, sizeof (fout));
+        tiz_dsp_set_simd (TIZ_DSP_SIMD_NONE);
+        tiz_dsp_mix_f32 (fref, f32 + 3, DSP_TEST_NSAMPLES - 3, 0.3f);
+        tiz_dsp_set_simd (g_dsp_simd_levels[i]);
+        tiz_dsp_mix_f32 (fout, f32 + 3, DSP_TEST_NSAMPLES - 3, 0.3f);
+        for (j = 0; j < DSP_TEST_NSAMPLES; ++j)
+          {
+            fail_if (fabsf (fref[j] - fout[j]) > 1e-6f);
+          }
+      }
+
+      tiz_dsp_set_simd (TIZ_DSP_SIMD_NONE);
+      tiz_dsp_s16_to_f32 (fref, s16, DSP_TEST_NSAMPLES);
+      tiz_dsp_set_simd (g_dsp_simd_levels[i]);
+      tiz_dsp_s16_to_f32 (fout, s16, DSP_TEST_NSAMPLES);
+      fail_if (0 != memcmp (fref, fout, sizeof (fref)));
+
+      {
+        float * planes_out[2] = {fout, fout + DSP_TEST_NSAMPLES / 2};
+        const float * planes_in[2] = {fout, fout + DSP_TEST_NSAMPLES / 2};
+        tiz_dsp_deinterleave_f32 (planes_out, f32, 2, DSP_TEST_NSAMPLES / 2);
+        tiz_dsp_interleave_f32 (fref, planes_in, 2, DSP_TEST_NSAMPLES / 2);
+        fail_if (0 != memcmp (fref, f32, (DSP_TEST_NSAMPLES / 2) * 2
+                                           * sizeof (float)));
+      }
+    }
+
+  tiz_dsp_set_simd (orig);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_simd_matches_c - end");
+}
+END_TEST
+
+START_TEST (test_dsp_fader)
+{
+  tiz_dsp_fader_t fader;
+  int16_t s16[8];
+  float f32[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  int i = 0;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_fader - begin");
+
+  tiz_dsp_fader_init (&fader, 1.0f);
+  fail_if (!tiz_dsp_fader_is_unity (&fader));
+
+  /* Fade out a stereo buffer over four frames, split across two calls */
+  for (i = 0; i < 8; ++i)
+    {
+      s16[i] = 1000;
+    }
+  tiz_dsp_fader_ramp (&fader, 0.0f, 4);
+  fail_if (tiz_dsp_fader_is_unity (&fader));
+  tiz_dsp_fader_s16 (&fader, s16, 2, 1);
+  tiz_dsp_fader_s16 (&fader, s16 + 2, 2, 3);
+  fail_if (s16[0] != 1000 || s16[1] != 1000);
+  fail_if (s16[2] != 750 || s16[3] != 750);
+  fail_if (s16[4] != 500 || s16[6] != 250 || s16[7] != 250);
+  fail_if (fader.gain != 0.0f || fader.remaining != 0);
+
+  /* Once the ramp is complete, the target gain applies to every frame */
+  tiz_dsp_fader_s16 (&fader, s16, 2, 4);
+  for (i = 0; i < 8; ++i)
+    {
+      fail_if (s16[i] != 0);
+    }
+
+  /* Fade back in; the ramp ends past the end of the buffer */
+  tiz_dsp_fader_ramp (&fader, 1.0f, 8);
+  tiz_dsp_fader_f32 (&fader, f32, 1, 4);
+  fail_if (f32[0] != 0.0f || f32[1] != 0.125f || f32[3] != 0.375f);
+  fail_if (fader.gain != 0.5f || fader.remaining != 4);
+
+  /* Changing the gain immediately */
+  tiz_dsp_fader_ramp (&fader, 1.0f, 0);
+  fail_if (!tiz_dsp_fader_is_unity (&fader));
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_fader - end");
+}
+END_TEST
+
+START_TEST (test_dsp_resampler)
+{
+  tiz_dsp_resampler_t * p_rs = NULL;
+  float in[2 * 4410];
+  float out[2 * 4800 + 64];
+  float dc[1000];
+  float dc_out[2000];
+  size_t in_frames = 0;
+  size_t out_frames = 0;
+  float peak = 0.0f;
+  size_t i = 0;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_resampler - begin");
+
+  /* An unreasonable ratio is rejected */
+  fail_if (OMX_ErrorUnsupportedSetting
+           != tiz_dsp_resampler_init (&p_rs, 44100, 48001, 2,
+                                      TIZ_DSP_RESAMPLER_QUALITY_MEDIUM));
+
+  /* 100ms of a stereo 1KHz tone, from 44.1KHz to 48KHz */
+  for (i = 0; i < 4410; ++i)
+    {
+      in[2 * i] = in[2 * i + 1] = 0.5f * sinf (2.0f * M_PI * 1000.0f * i
+                                               / 44100.0f);
+    }
+  fail_if (OMX_ErrorNone
+           != tiz_dsp_resampler_init (&p_rs, 44100, 48000, 2,
+                                      TIZ_DSP_RESAMPLER_QUALITY_HIGH));
+  /* In two halves, to exercise the history */
+  in_frames = 2205;
+  out_frames = tiz_dsp_resampler_process (p_rs, in, &in_frames, out, 4864);
+  fail_if (2205 != in_frames);
+  in_frames = 2205;
+  out_frames += tiz_dsp_resampler_process (p_rs, in + 2 * 2205, &in_frames,
+                                           out + 2 * out_frames,
+                                           4864 - out_frames);
+  fail_if (2205 != in_frames);
+  /* All but the filter's look-ahead is converted */
+  fail_if (out_frames > 4800 || out_frames < 4800 - 64);
+  /* The amplitude is preserved, away from the start-up transient */
+  for (i = 200; i < out_frames; ++i)
+    {
+      peak = MAX (peak, fabsf (out[2 * i]));
+      fail_if (out[2 * i] != out[2 * i + 1]);
+    }
+  fail_if (fabsf (peak - 0.5f) > 0.01f);
+  tiz_dsp_resampler_destroy (p_rs);
+
+  /* An integer ratio, with DC in and out */
+  for (i = 0; i < 1000; ++i)
+    {
+      dc[i] = 0.25f;
+    }
+  fail_if (OMX_ErrorNone
+           != tiz_dsp_resampler_init (&p_rs, 44100, 88200, 1,
+                                      TIZ_DSP_RESAMPLER_QUALITY_LOW));
+  in_frames = 1000;
+  out_frames = tiz_dsp_resampler_process (p_rs, dc, &in_frames, dc_out, 2000);
+  fail_if (1000 != in_frames);
+  fail_if (out_frames < 2000 - 32);
+  for (i = 32; i < out_frames; ++i)
+    {
+      fail_if (fabsf (dc_out[i] - 0.25f) > 1e-4f);
+    }
+  /* A full output buffer stops the conversion; the input that was taken is
+     converted by the next call */
+  tiz_dsp_resampler_reset (p_rs);
+  in_frames = 1000;
+  out_frames = tiz_dsp_resampler_process (p_rs, dc, &in_frames, dc_out, 10);
+  fail_if (10 != out_frames);
+  fail_if (0 == tiz_dsp_resampler_delay (p_rs));
+  in_frames = 0;
+  out_frames += tiz_dsp_resampler_process (p_rs, NULL, &in_frames, dc_out,
+                                           2000);
+  fail_if (out_frames < 2000 - 32);
+  tiz_dsp_resampler_destroy (p_rs);
+
+  /* Equal rates are a plain copy */
+  fail_if (OMX_ErrorNone
+           != tiz_dsp_resampler_init (&p_rs, 48000, 48000, 2,
+                                      TIZ_DSP_RESAMPLER_QUALITY_LOW));
+  in_frames = 100;
+  fail_if (100 != tiz_dsp_resampler_process (p_rs, in, &in_frames, out, 200));
+  fail_if (0 != memcmp (in, out, 200 * sizeof (float)));
+  fail_if (0 != tiz_dsp_resampler_delay (p_rs));
+  tiz_dsp_resampler_destroy (p_rs);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_resampler - end");
+}
+END_TEST
+
+START_TEST (test_dsp_loudness)
+{
+  tiz_dsp_loudness_t * p_lm = NULL;
+  static float tone[2 * 48000];
+  static int16_t s16[2 * 48000];
+  float silence[2 * 480];
+  int i = 0;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_loudness - begin");
+
+  fail_if (OMX_ErrorNone != tiz_dsp_loudness_init (&p_lm, 48000, 2));
+  fail_if (tiz_dsp_loudness_integrated (p_lm) != -HUGE_VALF);
+
+  /* A 997Hz stereo tone, 20dB below full scale, measures -20 LUFS */
+  for (i = 0; i < 48000; ++i)
+    {
+      tone[2 * i] = tone[2 * i + 1]
+        = 0.1f * (float) sin (2.0 * M_PI * 997.0 * i / 48000.0);
+    }
+  for (i = 0; i < 5; ++i)
+    {
+      tiz_dsp_loudness_f32 (p_lm, tone, 48000);
+    }
+  fail_if (fabsf (tiz_dsp_loudness_integrated (p_lm) + 20.0f) > 0.05f);
+  fail_if (fabsf (tiz_dsp_loudness_true_peak (p_lm) - 0.1f) > 0.001f);
+  fail_if (tiz_dsp_loudness_frames (p_lm) != 5 * 48000);
+
+  /* Silence is gated out; only the three blocks that straddle the end of
+     the tone lower the result, by about 0.13 LU */
+  memset (silence, 0, sizeof (silence));
+  for (i = 0; i < 500; ++i)
+    {
+      tiz_dsp_loudness_f32 (p_lm, silence, 480);
+    }
+  fail_if (fabsf (tiz_dsp_loudness_integrated (p_lm) + 20.13f) > 0.05f);
+
+  /* The same tone as 16-bit samples */
+  tiz_dsp_loudness_reset (p_lm);
+  for (i = 0; i < 2 * 48000; ++i)
+    {
+      s16[i] = (int16_t) (tone[i] * 32767.0f);
+    }
+  for (i = 0; i < 5; ++i)
+    {
+      tiz_dsp_loudness_s16 (p_lm, s16, 48000);
+    }
+  fail_if (fabsf (tiz_dsp_loudness_integrated (p_lm) + 20.0f) > 0.05f);
+
+  /* A quarter-rate tone sampled 45 degrees off its peaks: the samples stay
+     3dB below the true peak */
+  tiz_dsp_loudness_reset (p_lm);
+  for (i = 0; i < 48000; ++i)
+    {
+      tone[2 * i] = tone[2 * i + 1]
+        = 0.5f * (float) sin (M_PI / 2.0 * i + M_PI / 4.0);
+    }
+  tiz_dsp_loudness_f32 (p_lm, tone, 48000);
+  fail_if (fabsf (tiz_dsp_loudness_true_peak (p_lm) - 0.5f) > 0.01f);
+
+  tiz_dsp_loudness_destroy (p_lm);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_loudness - end");
+}
+END_TEST
+
+START_TEST (test_dsp_eq)
+{
+  tiz_dsp_eq_t * p_eq = NULL;
+  tiz_dsp_biquad_t bq;
+  static float buf[3 * 4800];
+  static float ref[3 * 4800];
+  const float fir[3] = {0.0f, 0.0f, 0.5f};
+  const tiz_dsp_simd_t orig = tiz_dsp_simd ();
+  float peak = 0.0f;
+  size_t i = 0;
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_eq - begin");
+
+  fail_if (OMX_ErrorBadParameter
+           != tiz_dsp_biquad_design (&bq, TIZ_DSP_BIQUAD_PEAKING, 48000,
+                                     30000.0f, 1.0f, 6.0f));
+  fail_if (OMX_ErrorBadParameter != tiz_dsp_eq_init (&p_eq, 9));
+  fail_if (OMX_ErrorNone != tiz_dsp_eq_init (&p_eq, 3));
+  fail_if (!tiz_dsp_eq_bypassed (p_eq));
+
+#define DSP_EQ_TONE(freq)                                         \
+  do                                                              \
+    {                                                             \
+      for (i = 0; i < 3 * 4800; ++i)                              \
+        {                                                         \
+          buf[i] = 0.25f                                          \
+                   * (float) sin (2.0 * M_PI * (freq) * (i / 3)   \
+                                  / 48000.0);                     \
+        }                                                         \
+      tiz_dsp_eq_reset (p_eq);                                    \
+      tiz_dsp_eq_process_f32 (p_eq, buf, 4800);                   \
+      peak = 0.0f;                                                \
+      for (i = 3 * 2400; i < 3 * 4800; ++i)                       \
+        {                                                         \
+          peak = MAX (peak, fabsf (buf[i]));                      \
+        }                                                         \
+    }                                                             \
+  while (0)
+
+  /* A 6dB boost doubles the amplitude at the centre frequency */
+  fail_if (OMX_ErrorNone
+           != tiz_dsp_biquad_design (&bq, TIZ_DSP_BIQUAD_PEAKING, 48000,
+                                     1000.0f, 1.0f, 6.0f));
+  fail_if (OMX_ErrorNone != tiz_dsp_eq_set_biquads (p_eq, &bq, 1, 0));
+  fail_if (tiz_dsp_eq_bypassed (p_eq));
+  DSP_EQ_TONE (1000.0);
+  fail_if (fabsf (peak - 0.25f * 1.995f) > 0.005f);
+
+  /* A 1KHz low-pass filter: 10KHz is 40dB down */
+  fail_if (OMX_ErrorNone
+           != tiz_dsp_biquad_design (&bq, TIZ_DSP_BIQUAD_LOW_PASS, 48000,
+                                     1000.0f, 0.707f, 0.0f));
+  fail_if (OMX_ErrorNone != tiz_dsp_eq_set_biquads (p_eq, &bq, 1, 0));
+  DSP_EQ_TONE (10000.0);
+  fail_if (peak > 0.25f * 0.02f);
+
+  /* Going back to flat, gradually, while the tone plays */
+  fail_if (OMX_ErrorNone != tiz_dsp_eq_set_biquads (p_eq, NULL, 0, 2400));
+  DSP_EQ_TONE (10000.0);
+  fail_if (fabsf (peak - 0.25f) > 0.001f);
+  for (i = 0; i < 3 * 4800; ++i)
+    {
+      fail_if (!isfinite (buf[i]) || fabsf (buf[i]) > 0.26f);
+    }
+  fail_if (!tiz_dsp_eq_bypassed (p_eq));
+
+  /* The FIR stage: a two frame delay, at half the gain */
+  fail_if (OMX_ErrorNone != tiz_dsp_eq_set_fir (p_eq, fir, 3));
+  for (i = 0; i < 3 * 4800; ++i)
+    {
+      ref[i] = buf[i] = (float) (i % 97) / 97.0f;
+    }
+  tiz_dsp_eq_process_f32 (p_eq, buf, 1000);
+  tiz_dsp_eq_process_f32 (p_eq, buf + 3 * 1000, 3800);
+  for (i = 0; i < 3 * 4800; ++i)
+    {
+      fail_if (fabsf (buf[i] - (i < 6 ? 0.0f : 0.5f * ref[i - 6])) > 1e-6f);
+    }
+  fail_if (OMX_ErrorNone != tiz_dsp_eq_set_fir (p_eq, NULL, 0));
+
+  /* The SIMD sections match the C ones */
+  fail_if (OMX_ErrorNone
+           != tiz_dsp_biquad_design (&bq, TIZ_DSP_BIQUAD_HIGH_SHELF, 48000,
+                                     4000.0f, 0.707f, -4.5f));
+  for (i = 0; i < sizeof (g_dsp_simd_levels) / sizeof (g_dsp_simd_levels[0]);
+       ++i)
+    {
+      size_t j = 0;
+      if (g_dsp_simd_levels[i] != tiz_dsp_set_simd (g_dsp_simd_levels[i]))
+        {
+          continue;
+        }
+      for (j = 0; j < 3 * 4800; ++j)
+        {
+          ref[j] = buf[j] = (float) ((j * 7919) % 1000) / 1000.0f - 0.5f;
+        }
+      tiz_dsp_set_simd (TIZ_DSP_SIMD_NONE);
+      tiz_dsp_eq_set_biquads (p_eq, &bq, 1, 0);
+      tiz_dsp_eq_reset (p_eq);
+      tiz_dsp_eq_process_f32 (p_eq, ref, 4800);
+      tiz_dsp_set_simd (g_dsp_simd_levels[i]);
+      tiz_dsp_eq_reset (p_eq);
+      tiz_dsp_eq_process_f32 (p_eq, buf, 4800);
+      for (j = 0; j < 3 * 4800; ++j)
+        {
+          fail_if (fabsf (ref[j] - buf[j]) > 1e-6f);
+        }
+    }
+
+#undef DSP_EQ_TONE
+
+  tiz_dsp_set_simd (orig);
+  tiz_dsp_eq_destroy (p_eq);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "test_dsp_eq - end");
+}
+END_TEST
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
@@ -80,6 +80,38 @@ START_TEST (test_http_parser_request_test)
 }
 END_TEST
 
+START_TEST (test_http_parser_keep_alive_test)
+{
+  static const struct
+  {
+    const char *p_req;
+    bool keep_alive;
+  } reqs[] = {
+    { "GET /a.mp3 HTTP/1.1\r\nHost: osoton:8000\r\n\r\n", true },
+    { "GET /a.mp3 HTTP/1.1\r\nConnection: close\r\n\r\n", false },
+    { "GET /a.mp3 HTTP/1.0\r\n\r\n", false },
+    { "GET /a.mp3 HTTP/1.0\r\nConnection: keep-alive\r\n\r\n", true },
+  };
+  size_t i = 0;
+
+  for (i = 0; i < sizeof (reqs) / sizeof (reqs[0]); ++i)
+    {
+      tiz_http_parser_t *p_http_parser = NULL;
+      int req_len = strlen (reqs[i].p_req);
+
+      fail_if (OMX_ErrorNone
+               != tiz_http_parser_init (&p_http_parser,
+                                        ETIZHttpParserTypeRequest));
+      fail_if (req_len
+               != tiz_http_parser_parse (p_http_parser, reqs[i].p_req,
+                                         req_len));
+      fail_if (reqs[i].keep_alive
+               != tiz_http_parser_should_keep_alive (p_http_parser));
+      tiz_http_parser_destroy (p_http_parser);
+    }
+}
+END_TEST
+
 /* Local Variables: */
 /* c-default-style: gnu */
 /* fill-column: 79 */
@@ -51,6 +51,7 @@
 #include "./check_event.c"
 #include "./check_http_parser.c"
 #include "./check_map.c"
+#include "./check_dsp.c"
 
 #define EVENT_API_TEST_TIMEOUT 100
 
@@ -205,6 +206,7 @@ platform_http_parser_suite (void)
   /* http parser API test cases */
   tc_http = tcase_create ("http parser API");
   tcase_add_test (tc_http, test_http_parser_request_test);
+  tcase_add_test (tc_http, test_http_parser_keep_alive_test);
   suite_add_tcase (s, tc_http);
 
   return s;
@@ -227,6 +229,27 @@ platform_map_suite (void)
 
 }
 
+Suite *
+platform_dsp_suite (void)
+{
+  TCase  *tc_dsp;
+  Suite *s = suite_create ("dsp");
+
+  /* PCM processing kernels test cases */
+  tc_dsp = tcase_create ("dsp API");
+  tcase_add_test (tc_dsp, test_dsp_gain_and_saturation);
+  tcase_add_test (tc_dsp, test_dsp_format_conversion);
+  tcase_add_test (tc_dsp, test_dsp_channels_and_byte_order);
+  tcase_add_test (tc_dsp, test_dsp_simd_matches_c);
+  tcase_add_test (tc_dsp, test_dsp_fader);
+  tcase_add_test (tc_dsp, test_dsp_resampler);
+  tcase_add_test (tc_dsp, test_dsp_loudness);
+  tcase_add_test (tc_dsp, test_dsp_eq);
+  suite_add_tcase (s, tc_dsp);
+
+  return s;
+}
+
 int
 main (void)
 {
@@ -246,6 +269,7 @@ main (void)
   srunner_add_suite (sr, platform_soa_suite ());
   srunner_add_suite (sr, platform_http_parser_suite ());
   srunner_add_suite (sr, platform_map_suite ());
+  srunner_add_suite (sr, platform_dsp_suite ());
 /*   srunner_add_suite (sr, platform_event_suite ()); */
   srunner_run_all (sr, CK_VERBOSE);
   number_failed = srunner_ntests_failed (sr);
@@ -30,10 +30,13 @@
 #include <config.h>
 #endif
 
+#include <tizplatform.h>
+
 #include "tizgraph.hpp"
 #include "tizgraphfsm.hpp"
 #include "tizgraphcmd.hpp"
 #include "tizgraphops.hpp"
+#include "tizgraphutil.hpp"
 
 #include "tizdecgraph.hpp"
 
@@ -51,7 +54,8 @@ graph::decoder::decoder (const std::string &graph_name)
   : graph::graph (graph_name),
     fsm_ (new fsm (boost::msm::back::states_
                    << tiz::graph::fsm::configuring (&p_ops_)
-                   << tiz::graph::fsm::skipping (&p_ops_),
+                   << tiz::graph::fsm::skipping (&p_ops_)
+                   << tiz::graph::fsm::seeking (&p_ops_),
                    &p_ops_))
 {
 }
@@ -100,6 +104,21 @@ bool graph::decoder::dispatch_cmd (const tiz::graph::cmd *p_cmd)
   return p_cmd->kill_thread ();
 }
 
+// Adds the pcm renderer at the end of the graph. If the audio device only
+// plays some sample rates natively (see util::get_output_sample_rates), the
+// sample rate converter goes in front of it.
+void graph::decoder::add_pcm_renderer (omx_comp_name_lst_t &comp_list,
+                                       omx_comp_role_lst_t &role_list)
+{
+  if (!tiz::graph::util::get_output_sample_rates ().empty ())
+  {
+    comp_list.push_back ("OMX.Aratelia.audio_processor.resampler");
+    role_list.push_back ("audio_processor.resampler");
+  }
+  comp_list.push_back (tiz::graph::util::get_default_pcm_renderer ());
+  role_list.push_back ("audio_renderer.pcm");
+}
+
 //
 // decops
 //
@@ -126,3 +145,41 @@ bool graph::decops::is_disabled_evt_required () const
   // disabled in the graph. See comment in do_disable_comp_ports.
   return false;
 }
+
+/**
+ * Sets the pcm settings of the stream on the renderer's input port. When the
+ * graph has a sample rate converter, these go to the converter's input
+ * instead, and the renderer gets them at the rate that the device plays
+ * (which is the stream's own rate if the device supports it, in which case
+ * the converter lets the stream through untouched).
+ */
+OMX_ERRORTYPE graph::decops::set_renderer_pcm_mode (
+    boost::function< void(OMX_AUDIO_PARAM_PCMMODETYPE &pcmmode) > getter)
+{
+  const int renderer_index = handles_.size () - 1;
+  assert (renderer_index > 0);
+
+  if (role_lst_[renderer_index - 1].compare ("audio_processor.resampler") != 0)
+  {
+    return util::set_pcm_mode (handles_[renderer_index], 0, getter);
+  }
+
+  const OMX_HANDLETYPE resampler = handles_[renderer_index - 1];
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmtype;
+  TIZ_INIT_OMX_PORT_STRUCT (pcmtype, 0);
+  getter (pcmtype);
+
+  pcmtype.nPortIndex = 0;
+  tiz_check_omx (OMX_SetParameter (resampler, OMX_IndexParamAudioPcm, &pcmtype));
+
+  const OMX_U32 stream_rate = pcmtype.nSamplingRate;
+  pcmtype.nSamplingRate = util::get_output_sample_rate (stream_rate);
+  TIZ_LOG (TIZ_PRIORITY_NOTICE, "Stream rate [%u] -> output rate [%u]",
+           (unsigned)stream_rate, (unsigned)pcmtype.nSamplingRate);
+  pcmtype.nPortIndex = 1;
+  tiz_check_omx (OMX_SetParameter (resampler, OMX_IndexParamAudioPcm, &pcmtype));
+
+  pcmtype.nPortIndex = 0;
+  return OMX_SetParameter (handles_[renderer_index], OMX_IndexParamAudioPcm,
+                           &pcmtype);
+}
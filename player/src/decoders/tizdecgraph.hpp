@@ -30,6 +30,9 @@
 #define TIZDECGRAPH_HPP
 
 #include <boost/any.hpp>
+#include <boost/function.hpp>
+
+#include <OMX_Audio.h>
 
 #include "tizgraph.hpp"
 #include "tizgraphops.hpp"
@@ -50,6 +53,8 @@ namespace tiz
 
     protected:
       bool dispatch_cmd (const tiz::graph::cmd *p_cmd);
+      static void add_pcm_renderer (omx_comp_name_lst_t &comp_list,
+                                    omx_comp_role_lst_t &role_list);
 
     protected:
       boost::any fsm_;
@@ -64,6 +69,10 @@ namespace tiz
     public:
       void do_disable_comp_ports (const int comp_id, const int port_id);
       bool is_disabled_evt_required () const;
+
+    protected:
+      OMX_ERRORTYPE set_renderer_pcm_mode (
+          boost::function< void(OMX_AUDIO_PARAM_PCMMODETYPE &pcmmode) > getter);
     };
 
   }  // namespace graph
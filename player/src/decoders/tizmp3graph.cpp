@@ -62,12 +62,12 @@ graph::ops *graph::mp3decoder::do_init ()
   omx_comp_name_lst_t comp_list;
   comp_list.push_back ("OMX.Aratelia.file_reader.binary");
   comp_list.push_back ("OMX.Aratelia.audio_decoder.mp3");
-  comp_list.push_back (tiz::graph::util::get_default_pcm_renderer ());
 
   omx_comp_role_lst_t role_list;
   role_list.push_back ("audio_reader.binary");
   role_list.push_back ("audio_decoder.mp3");
-  role_list.push_back ("audio_renderer.pcm");
+
+  add_pcm_renderer (comp_list, role_list);
 
   return new mp3decops (this, comp_list, role_list);
 }
@@ -119,8 +119,7 @@ void graph::mp3decops::do_configure ()
     G_OPS_BAIL_IF_ERROR (rc, "Unable to transfer OMX_IndexParamAudioPcm");
 
     G_OPS_BAIL_IF_ERROR (
-        tiz::graph::util::set_pcm_mode (
-            handles_[2], 0,
+        set_renderer_pcm_mode (
             boost::bind (&tiz::graph::mp3decops::get_pcm_codec_info, this, _1)),
         "Unable to set OMX_IndexParamAudioPcm");
   }
@@ -62,12 +62,12 @@ graph::ops *graph::mpegdecoder::do_init ()
   omx_comp_name_lst_t comp_list;
   comp_list.push_back ("OMX.Aratelia.file_reader.binary");
   comp_list.push_back ("OMX.Aratelia.audio_decoder.mpeg");
-  comp_list.push_back (tiz::graph::util::get_default_pcm_renderer ());
 
   omx_comp_role_lst_t role_list;
   role_list.push_back ("audio_reader.binary");
   role_list.push_back ("audio_decoder.mp2");
-  role_list.push_back ("audio_renderer.pcm");
+
+  add_pcm_renderer (comp_list, role_list);
 
   return new mpegdecops (this, comp_list, role_list);
 }
@@ -102,8 +102,7 @@ void graph::mpegdecops::do_configure ()
       util::set_content_uri (handles_[0], probe_ptr_->get_uri ()),
       "Unable to set OMX_IndexParamContentURI");
   G_OPS_BAIL_IF_ERROR (
-      tiz::graph::util::set_pcm_mode (
-          handles_[2], 0,
+      set_renderer_pcm_mode (
           boost::bind (&tiz::probe::get_pcm_codec_info, probe_ptr_, _1)),
       "Unable to set OMX_IndexParamAudioPcm");
 }
@@ -63,12 +63,12 @@ graph::ops *graph::oggflacdecoder::do_init ()
   omx_comp_name_lst_t comp_list;
   comp_list.push_back ("OMX.Aratelia.container_demuxer.ogg");
   comp_list.push_back ("OMX.Aratelia.audio_decoder.flac");
-  comp_list.push_back (tiz::graph::util::get_default_pcm_renderer ());
 
   omx_comp_role_lst_t role_list;
   role_list.push_back ("source.container_demuxer.ogg");
   role_list.push_back ("audio_decoder.flac");
-  role_list.push_back ("audio_renderer.pcm");
+
+  add_pcm_renderer (comp_list, role_list);
 
   return new oggflacdecops (this, comp_list, role_list);
 }
@@ -124,8 +124,7 @@ void graph::oggflacdecops::do_configure ()
       util::set_content_uri (handles_[0], probe_ptr_->get_uri ()),
       "Unable to set OMX_IndexParamContentURI");
   G_OPS_BAIL_IF_ERROR (
-      tiz::graph::util::set_pcm_mode (
-          handles_[2], 0,
+      set_renderer_pcm_mode (
           boost::bind (&tiz::probe::get_pcm_codec_info, probe_ptr_, _1)),
       "Unable to set OMX_IndexParamAudioPcm");
 }
@@ -134,19 +134,3 @@ void graph::oggopusdecops::get_pcm_codec_info (OMX_AUDIO_PARAM_PCMMODETYPE &pcmt
   pcmtype.nBitPerSample = decoder_pcmtype.nBitPerSample;
   pcmtype.nSamplingRate = 48000; //decoder_pcmtype.nSamplingRate;
 }
-
-bool
-graph::oggopusdecops::probe_stream_hook ()
-{
-  if (probe_ptr_)
-    {
-      OMX_AUDIO_PARAM_PCMMODETYPE pcmtype;
-      probe_ptr_->get_pcm_codec_info (pcmtype);
-      // Ammend the bits per sample value, as the ogg opus decoder produces 32 bit
-      // per sample output
-      // TODO: Remove this hack
-      pcmtype.nBitPerSample = 32;
-      probe_ptr_->set_pcm_codec_info (pcmtype);
-    }
-  return true;
-}
@@ -59,10 +59,6 @@ namespace tiz
       void do_configure ();
       void get_pcm_codec_info (OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype);
 
-    private:
-      // re-implemented from the base class
-      bool probe_stream_hook ();
-
     private:
       bool need_port_settings_changed_evt_;
     };
@@ -53,26 +53,38 @@ namespace graph = tiz::graph;
 //
 // httpserver
 //
-graph::httpserver::httpserver ()
+graph::httpserver::httpserver (const std::vector< int > &transcode_bitrates)
   : graph::graph ("httpservgraph"),
     fsm_ (boost::msm::back::states_
           << tiz::graph::hsfsm::fsm::configuring (&p_ops_)
           << tiz::graph::hsfsm::fsm::skipping (&p_ops_),
-          &p_ops_)
+          &p_ops_),
+    transcode_bitrates_ (transcode_bitrates)
 {
 }
 
 graph::ops *graph::httpserver::do_init ()
 {
   omx_comp_name_lst_t comp_list;
-  comp_list.push_back ("OMX.Aratelia.audio_metadata_eraser.mp3");
-  comp_list.push_back ("OMX.Aratelia.audio_renderer.http");
-
   omx_comp_role_lst_t role_list;
+
+  comp_list.push_back ("OMX.Aratelia.audio_metadata_eraser.mp3");
   role_list.push_back ("audio_metadata_eraser.mp3");
+
+  if (!transcode_bitrates_.empty ())
+  {
+    // The decoder and the encoder are shared by all the bitrates; each
+    // encoder output port feeds one of the renderer's mount points.
+    comp_list.push_back ("OMX.Aratelia.audio_decoder.mpeg");
+    role_list.push_back ("audio_decoder.mp3");
+    comp_list.push_back ("OMX.Aratelia.audio_encoder.mp3");
+    role_list.push_back ("audio_encoder.mp3");
+  }
+
+  comp_list.push_back ("OMX.Aratelia.audio_renderer.http");
   role_list.push_back ("audio_renderer.http");
 
-  return new httpservops (this, comp_list, role_list);
+  return new httpservops (this, comp_list, role_list, transcode_bitrates_);
 }
 
 bool graph::httpserver::dispatch_cmd (const tiz::graph::cmd *p_cmd)
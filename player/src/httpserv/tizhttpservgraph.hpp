@@ -29,6 +29,8 @@
 #ifndef TIZHTTPSERVGRAPH_HPP
 #define TIZHTTPSERVGRAPH_HPP
 
+#include <vector>
+
 #include "tizgraph.hpp"
 #include "tizhttpservgraphfsm.hpp"
 
@@ -44,7 +46,10 @@ namespace tiz
     {
 
     public:
-      httpserver ();
+      // With transcode bitrates, the media is decoded and re-encoded once per
+      // bitrate, instead of being streamed as it is.
+      explicit httpserver (
+          const std::vector< int > &transcode_bitrates = std::vector< int > ());
 
     protected:
       ops *do_init ();
@@ -52,6 +57,7 @@ namespace tiz
 
     protected:
       hsfsm::fsm fsm_;
+      const std::vector< int > transcode_bitrates_;
     };
   }  // namespace graph
 }  // namespace tiz
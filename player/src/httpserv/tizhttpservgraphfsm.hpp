@@ -105,6 +105,28 @@ namespace tiz
         }
       };
 
+      // Only the first mount point's EOS ends the track; with more than one,
+      // the others' are of no interest
+      struct is_end_of_track_eos
+      {
+        template <class EVT, class FSM, class SourceState, class TargetState>
+        bool operator()(EVT const & evt, FSM & fsm, SourceState & source, TargetState & target)
+        {
+          bool rc = false;
+          if (fsm.pp_ops_ && *(fsm.pp_ops_))
+            {
+              // This is a httpservops-specific guard
+              httpservops* p_ops = dynamic_cast<httpservops*>(*(fsm.pp_ops_));
+              if (p_ops)
+                {
+                  rc = p_ops->is_end_of_track_eos (evt.handle_, evt.port_);
+                }
+            }
+          TIZ_LOG (TIZ_PRIORITY_TRACE, " is_end_of_track_eos [%s]", rc ? "YES" : "NO");
+          return rc;
+        }
+      };
+
     // Concrete FSM implementation
     struct fsm_ : public boost::msm::front::state_machine_def<fsm_>
     {
@@ -415,6 +437,7 @@ namespace tiz
                    ::exit_pt
                    <configuring_
                     ::conf_exit>   , tg::configured_evt  , tg::executing   , tg::do_ack_execd                                          >,
+        bmf::Row < configuring     , tg::omx_eos_evt     , bmf::none       , bmf::none                                                 >,
         bmf::Row < configuring
                    ::exit_pt
                    <configuring_
@@ -428,8 +451,11 @@ namespace tiz
         bmf::Row < tg::executing   , tg::unload_evt      , tg::exe2idle    , tg::do_exe2idle                                       >,
         bmf::Row < tg::executing   , tg::omx_err_evt     , skipping        , bmf::none                                                 >,
         bmf::Row < tg::executing   , tg::omx_err_evt     , skipping        , tg::do_record_fatal_error       , tg::is_fatal_error      >,
-        bmf::Row < tg::executing   , tg::omx_eos_evt     , skipping        , bmf::none                       , tg::is_last_eos         >,
+        bmf::Row < tg::executing   , tg::omx_eos_evt     , skipping        , bmf::none                       , is_end_of_track_eos     >,
+        bmf::Row < tg::executing   , tg::omx_eos_evt     , bmf::none       , bmf::none                       , bmf::euml::Not_<
+                                                                                                                 is_end_of_track_eos >  >,
         //    +---+----------------+---------------------+-----------------+---------------------------------+--------------------------+
+        bmf::Row < skipping        , tg::omx_eos_evt     , bmf::none       , bmf::none                                                 >,
         bmf::Row < skipping
                    ::exit_pt
                    <skipping_
@@ -61,12 +61,43 @@ namespace
 //
 graph::httpservops::httpservops (graph *p_graph,
                                  const omx_comp_name_lst_t &comp_lst,
-                                 const omx_comp_role_lst_t &role_lst)
+                                 const omx_comp_role_lst_t &role_lst,
+                                 const std::vector< int > &transcode_bitrates)
   : tiz::graph::ops (p_graph, comp_lst, role_lst),
-    is_initial_configuration_ (true)
+    is_initial_configuration_ (true),
+    transcode_bitrates_ (transcode_bitrates),
+    transcode_rate_ (0),
+    transcode_channels_ (0)
 {
 }
 
+void graph::httpservops::do_setup ()
+{
+  if (is_transcoding ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        configure_encoder_outputs (),
+        "Unable to set OMX_TizoniaIndexParamAudioEncoderOutputs (the "
+        "renderer needs one MP3 mount point per transcode bitrate)");
+  }
+  tiz::graph::ops::do_setup ();
+  if (is_transcoding () && last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (setup_output_tunnels (),
+                         "Unable to setup the encoder's output tunnels.");
+  }
+}
+
+void graph::httpservops::do_tear_down_tunnels ()
+{
+  if (is_transcoding ())
+  {
+    G_OPS_BAIL_IF_ERROR (tear_down_output_tunnels (),
+                         "Unable to tear down the encoder's output tunnels.");
+  }
+  tiz::graph::ops::do_tear_down_tunnels ();
+}
+
 void graph::httpservops::do_probe ()
 {
   G_OPS_BAIL_IF_ERROR (
@@ -95,6 +126,62 @@ void graph::httpservops::do_mute ()
   // No-op. This is to disable mute in this graph
 }
 
+void graph::httpservops::do_loaded2idle_comp (const int comp_id)
+{
+  if (!is_transcoding () || 0 != comp_id)
+  {
+    tiz::graph::ops::do_loaded2idle_comp (comp_id);
+  }
+  else if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        transition_tunnel (0, OMX_StateIdle, OMX_StateLoaded),
+        "Unable to transition the source from Loaded->Idle");
+  }
+}
+
+void graph::httpservops::do_idle2exe_comp (const int comp_id)
+{
+  if (!is_transcoding () || 0 != comp_id)
+  {
+    tiz::graph::ops::do_idle2exe_comp (comp_id);
+  }
+  else if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        transition_tunnel (0, OMX_StateExecuting, OMX_StateIdle),
+        "Unable to transition the source from Idle->Exe");
+  }
+}
+
+void graph::httpservops::do_exe2idle_comp (const int comp_id)
+{
+  if (!is_transcoding () || 0 != comp_id)
+  {
+    tiz::graph::ops::do_exe2idle_comp (comp_id);
+  }
+  else if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        transition_tunnel (0, OMX_StateIdle, OMX_StateExecuting),
+        "Unable to transition the source from Exe->Idle");
+  }
+}
+
+void graph::httpservops::do_idle2loaded_comp (const int comp_id)
+{
+  if (!is_transcoding () || 0 != comp_id)
+  {
+    tiz::graph::ops::do_idle2loaded_comp (comp_id);
+  }
+  else if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        transition_tunnel (0, OMX_StateLoaded, OMX_StateIdle),
+        "Unable to transition the source from Idle->Loaded");
+  }
+}
+
 void graph::httpservops::do_configure_server ()
 {
   G_OPS_BAIL_IF_ERROR (configure_server (),
@@ -112,6 +199,8 @@ void graph::httpservops::do_configure_stream ()
   G_OPS_BAIL_IF_ERROR (
       tiz::graph::util::set_content_uri (handles_[0], probe_ptr_->get_uri ()),
       "Unable to set OMX_IndexParamContentURI");
+  // This is either the renderer's or, when transcoding, the decoder's input
+  // port
   bool need_port_settings_changed_evt = false;  // not needed here
   G_OPS_BAIL_IF_ERROR (
       tiz::graph::util::set_mp3_type (
@@ -119,6 +208,11 @@ void graph::httpservops::do_configure_stream ()
           boost::bind (&tiz::graph::httpservops::get_mp3_codec_info, this, _1),
           need_port_settings_changed_evt),
       "Unable to set OMX_IndexParamAudioMp3");
+  if (is_transcoding () && is_initial_configuration_)
+  {
+    G_OPS_BAIL_IF_ERROR (configure_transcoding (),
+                         "Unable to configure the mp3 encoder.");
+  }
   G_OPS_BAIL_IF_ERROR (configure_stream_metadata (),
                        "Unable to set OMX_TizoniaIndexConfigIcecastMetadata");
 }
@@ -136,6 +230,32 @@ void graph::httpservops::do_flag_initial_config_done ()
   is_initial_configuration_ = false;
 }
 
+bool graph::httpservops::is_end_of_track_eos (const OMX_HANDLETYPE handle,
+                                              const OMX_U32 port) const
+{
+  // When transcoding, every mount point sees the end of the track; the first
+  // one stands for all of them.
+  return is_last_component (handle) && 0 == port;
+}
+
+bool graph::httpservops::is_transcoding () const
+{
+  return !transcode_bitrates_.empty ();
+}
+
+int graph::httpservops::renderer_index () const
+{
+  return handles_.size () - 1;
+}
+
+int graph::httpservops::source_tunnel (const int tunnel_id) const
+{
+  // When transcoding, the tunnel that is switched between tracks is the one
+  // from the decoder to the encoder; the encoder and the renderer stay
+  // up.
+  return (is_transcoding () && 0 == tunnel_id) ? 1 : tunnel_id;
+}
+
 OMX_ERRORTYPE
 graph::httpservops::configure_server ()
 {
@@ -144,42 +264,62 @@ graph::httpservops::configure_server ()
   httpsrv.nVersion.nVersion = OMX_VERSION;
 
   tiz_check_omx (OMX_GetParameter (
-      handles_[1],
+      handles_[renderer_index ()],
       static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamHttpServer), &httpsrv));
 
   tizhttpservconfig_ptr_t srv_config
       = boost::dynamic_pointer_cast< httpservconfig >(config_);
   assert (srv_config);
   httpsrv.nListeningPort = srv_config->get_port ();
-  httpsrv.nMaxClients = 1;  // the http renderer component supports only one
-  // client, for now
+  // nMaxClients: keep the renderer's default (see tizonia.conf)
 
   return OMX_SetParameter (
-      handles_[1],
+      handles_[renderer_index ()],
       static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamHttpServer), &httpsrv);
 }
 
 OMX_ERRORTYPE
 graph::httpservops::configure_station ()
+{
+  const OMX_U32 nmounts = is_transcoding () ? transcode_bitrates_.size () : 1;
+  for (OMX_U32 i = 0; i < nmounts; ++i)
+  {
+    tiz_check_omx (configure_mount (i));
+  }
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+graph::httpservops::configure_mount (const OMX_U32 port_id)
 {
   OMX_TIZONIA_ICECASTMOUNTPOINTTYPE mount;
   mount.nSize = sizeof(OMX_TIZONIA_ICECASTMOUNTPOINTTYPE);
   mount.nVersion.nVersion = OMX_VERSION;
-  mount.nPortIndex = 0;
+  mount.nPortIndex = port_id;
 
   tizhttpservconfig_ptr_t srv_config
       = boost::dynamic_pointer_cast< httpservconfig >(config_);
   assert (srv_config);
 
+  // The mount point's path is the one configured in the renderer
   tiz_check_omx (OMX_GetParameter (
-      handles_[1],
+      handles_[renderer_index ()],
       static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamIcecastMountpoint),
       &mount));
 
-  snprintf ((char *)mount.cMountName, sizeof(mount.cMountName), "/");
-  snprintf ((char *)mount.cStationName, sizeof(mount.cStationName),
-            "%s (%s:%ld)", srv_config->get_station_name ().c_str (),
-            srv_config->get_host_name ().c_str (), srv_config->get_port ());
+  if (is_transcoding ())
+  {
+    snprintf ((char *)mount.cStationName, sizeof(mount.cStationName),
+              "%s (%s:%ld) [%d kbps]", srv_config->get_station_name ().c_str (),
+              srv_config->get_host_name ().c_str (), srv_config->get_port (),
+              transcode_bitrates_[port_id]);
+  }
+  else
+  {
+    snprintf ((char *)mount.cStationName, sizeof(mount.cStationName),
+              "%s (%s:%ld)", srv_config->get_station_name ().c_str (),
+              srv_config->get_host_name ().c_str (), srv_config->get_port ());
+  }
   snprintf ((char *)mount.cStationDescription,
             sizeof(mount.cStationDescription),
             "Tizonia Streaming Server");
@@ -195,9 +335,8 @@ graph::httpservops::configure_station ()
            mount.nIcyMetadataPeriod);
 
   mount.eEncoding = OMX_AUDIO_CodingMP3;
-  mount.nMaxClients = 1;
   return OMX_SetParameter (
-      handles_[1],
+      handles_[renderer_index ()],
       static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamIcecastMountpoint),
       &mount);
 }
@@ -217,8 +356,9 @@ graph::httpservops::configure_stream_metadata ()
   }
   else
   {
+    const OMX_U32 nmounts
+        = is_transcoding () ? transcode_bitrates_.size () : 1;
     p_metadata->nVersion.nVersion = OMX_VERSION;
-    p_metadata->nPortIndex = 0;
 
     // Obtain the stream title
     std::string stream_title = probe_ptr_->get_stream_title ();
@@ -231,9 +371,14 @@ graph::httpservops::configure_stream_metadata ()
     TIZ_LOG (TIZ_PRIORITY_TRACE, "p_metadata->cStreamTitle [%s]...",
              p_metadata->cStreamTitle);
 
-    rc = OMX_SetConfig (handles_[1], static_cast< OMX_INDEXTYPE >(
-                                         OMX_TizoniaIndexConfigIcecastMetadata),
-                        p_metadata);
+    for (OMX_U32 i = 0; i < nmounts && OMX_ErrorNone == rc; ++i)
+    {
+      p_metadata->nPortIndex = i;
+      rc = OMX_SetConfig (
+          handles_[renderer_index ()],
+          static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexConfigIcecastMetadata),
+          p_metadata);
+    }
 
     tiz_mem_free (p_metadata);
     p_metadata = NULL;
@@ -242,6 +387,123 @@ graph::httpservops::configure_stream_metadata ()
   return rc;
 }
 
+// The encoder's input takes the decoder's PCM, and each of its outputs is
+// encoded at one of the bitrates, which the matching mount point is told
+// about.
+OMX_ERRORTYPE
+graph::httpservops::configure_transcoding ()
+{
+  const int encoder_index = renderer_index () - 1;
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmtype;
+  TIZ_INIT_OMX_PORT_STRUCT (pcmtype, 0);
+  probe_ptr_->get_pcm_codec_info (pcmtype);
+  transcode_rate_ = pcmtype.nSamplingRate;
+  transcode_channels_ = pcmtype.nChannels;
+
+  tiz_check_omx (tiz::graph::util::set_pcm_mode (
+      handles_[encoder_index], 0,
+      boost::bind (&tiz::probe::get_pcm_codec_info, probe_ptr_, _1)));
+
+  for (OMX_U32 i = 0; i < transcode_bitrates_.size (); ++i)
+  {
+    bool need_port_settings_changed_evt = false;  // not needed here
+    boost::function< void(OMX_AUDIO_PARAM_MP3TYPE &) > getter = boost::bind (
+        &tiz::graph::httpservops::get_transcoded_mp3_info, this,
+        transcode_bitrates_[i], _1);
+    tiz_check_omx (tiz::graph::util::set_mp3_type (
+        handles_[encoder_index], i + 1, getter,
+        need_port_settings_changed_evt));
+    tiz_check_omx (tiz::graph::util::set_mp3_type (
+        handles_[renderer_index ()], i, getter,
+        need_port_settings_changed_evt));
+  }
+  return OMX_ErrorNone;
+}
+
+// One encoder output per bitrate, each one tunneled to its own mount point,
+// so the renderer must have exactly as many MP3 mount points
+OMX_ERRORTYPE
+graph::httpservops::configure_encoder_outputs ()
+{
+  const int encoder_index = renderer_index () - 1;
+  const OMX_U32 noutputs = transcode_bitrates_.size ();
+
+  OMX_PORT_PARAM_TYPE port_param;
+  TIZ_INIT_OMX_STRUCT (port_param);
+  tiz_check_omx (OMX_GetParameter (handles_[renderer_index ()],
+                                   OMX_IndexParamAudioInit, &port_param));
+  if (port_param.nPorts != noutputs)
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR,
+             "[%u] transcode bitrates, but [%u] mount points configured",
+             noutputs, port_param.nPorts);
+    return OMX_ErrorBadParameter;
+  }
+
+  for (OMX_U32 i = 0; i < noutputs; ++i)
+  {
+    OMX_PARAM_PORTDEFINITIONTYPE port_def;
+    TIZ_INIT_OMX_PORT_STRUCT (port_def, i);
+    tiz_check_omx (OMX_GetParameter (handles_[renderer_index ()],
+                                     OMX_IndexParamPortDefinition, &port_def));
+    if (OMX_AUDIO_CodingMP3 != port_def.format.audio.eEncoding)
+    {
+      TIZ_LOG (TIZ_PRIORITY_ERROR, "mount point [%u] is not MP3", i);
+      return OMX_ErrorBadParameter;
+    }
+  }
+
+  OMX_TIZONIA_AUDIO_PARAM_ENCODEROUTPUTSTYPE outputs;
+  TIZ_INIT_OMX_STRUCT (outputs);
+  tiz_check_omx (OMX_GetParameter (
+      handles_[encoder_index],
+      static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamAudioEncoderOutputs),
+      &outputs));
+  outputs.nOutputs = noutputs;
+  return OMX_SetParameter (
+      handles_[encoder_index],
+      static_cast< OMX_INDEXTYPE >(OMX_TizoniaIndexParamAudioEncoderOutputs),
+      &outputs);
+}
+
+// The chain set up by the base class ends at the encoder's first output;
+// the others are tunneled here.
+OMX_ERRORTYPE
+graph::httpservops::setup_output_tunnels ()
+{
+  const int encoder_index = renderer_index () - 1;
+  OMX_PARAM_BUFFERSUPPLIERTYPE supplier;
+  TIZ_INIT_OMX_PORT_STRUCT (supplier, 0);
+  supplier.eBufferSupplier = OMX_BufferSupplyInput;
+
+  for (OMX_U32 i = 1; i < transcode_bitrates_.size (); ++i)
+  {
+    supplier.nPortIndex = i + 1;
+    tiz_check_omx (OMX_SetParameter (handles_[encoder_index],
+                                     OMX_IndexParamCompBufferSupplier,
+                                     &supplier));
+    supplier.nPortIndex = i;
+    tiz_check_omx (OMX_SetParameter (handles_[renderer_index ()],
+                                     OMX_IndexParamCompBufferSupplier,
+                                     &supplier));
+    tiz_check_omx (OMX_SetupTunnel (handles_[encoder_index], i + 1,
+                                    handles_[renderer_index ()], i));
+  }
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+graph::httpservops::tear_down_output_tunnels ()
+{
+  const int encoder_index = renderer_index () - 1;
+  for (OMX_U32 i = 1; i < transcode_bitrates_.size (); ++i)
+  {
+    tiz_check_omx (OMX_TeardownTunnel (handles_[encoder_index], i + 1,
+                                       handles_[renderer_index ()], i));
+  }
+  return OMX_ErrorNone;
+}
+
 OMX_ERRORTYPE
 graph::httpservops::switch_tunnel (const int tunnel_id,
     const OMX_COMMANDTYPE to_disabled_or_enabled)
@@ -251,27 +513,26 @@ graph::httpservops::switch_tunnel (const int tunnel_id,
   assert (to_disabled_or_enabled == OMX_CommandPortDisable
           || to_disabled_or_enabled == OMX_CommandPortEnable);
 
+  const int tid = source_tunnel (tunnel_id);
   if (to_disabled_or_enabled == OMX_CommandPortDisable)
   {
-    rc = tiz::graph::util::disable_tunnel (handles_, tunnel_id);
+    rc = tiz::graph::util::disable_tunnel (handles_, tid);
   }
   else
   {
-    rc = tiz::graph::util::enable_tunnel (handles_, tunnel_id);
+    rc = tiz::graph::util::enable_tunnel (handles_, tid);
   }
 
   if (OMX_ErrorNone == rc)
   {
     clear_expected_port_transitions ();
-    const int file_reader_index = 0;
-    const int file_reader_input_port = 0;
-    add_expected_port_transition (handles_[file_reader_index],
-                                  file_reader_input_port,
+    // The tunnel goes from the output port of one component (port 0 on the
+    // source) to the input port of the next one
+    const int output_port = (0 == tid ? 0 : 1);
+    add_expected_port_transition (handles_[tid], output_port,
                                   to_disabled_or_enabled);
-    const int http_renderer_index = 1;
-    const int http_renderer_input_port = 0;
-    add_expected_port_transition (handles_[http_renderer_index],
-                                  http_renderer_input_port,
+    const int input_port = 0;
+    add_expected_port_transition (handles_[tid + 1], input_port,
                                   to_disabled_or_enabled);
   }
   return rc;
@@ -293,6 +554,22 @@ void graph::httpservops::get_mp3_codec_info (OMX_AUDIO_PARAM_MP3TYPE &mp3type)
     }
 }
 
+void graph::httpservops::get_transcoded_mp3_info (
+    const int bitrate_kbps, OMX_AUDIO_PARAM_MP3TYPE &mp3type)
+{
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmtype;
+  TIZ_INIT_OMX_PORT_STRUCT (pcmtype, 0);
+  probe_ptr_->get_pcm_codec_info (pcmtype);
+  mp3type.nChannels = pcmtype.nChannels;
+  mp3type.nBitRate = bitrate_kbps * 1000;
+  mp3type.nSampleRate = pcmtype.nSamplingRate;
+  mp3type.nAudioBandWidth = 0;
+  mp3type.eChannelMode = (1 == pcmtype.nChannels
+                              ? OMX_AUDIO_ChannelModeMono
+                              : OMX_AUDIO_ChannelModeJointStereo);
+  mp3type.eFormat = OMX_AUDIO_MP3StreamFormatMP1Layer3;
+}
+
 bool graph::httpservops::probe_stream_hook ()
 {
   bool rc = false;
@@ -329,6 +606,17 @@ bool graph::httpservops::probe_stream_hook ()
                        probe_ptr_->is_cbr_stream () ? "CBR" : "VBR")
         != bitrate_types.end ();
     }
+
+    // The encoders stay up from one track to the next, so their format
+    // can't change
+    if (is_transcoding () && transcode_rate_ > 0)
+    {
+      OMX_AUDIO_PARAM_PCMMODETYPE pcmtype;
+      TIZ_INIT_OMX_PORT_STRUCT (pcmtype, 0);
+      probe_ptr_->get_pcm_codec_info (pcmtype);
+      rc &= (pcmtype.nSamplingRate == transcode_rate_
+             && pcmtype.nChannels == transcode_channels_);
+    }
   }
 
   TIZ_LOG (TIZ_PRIORITY_TRACE, "return () [%s]...", rc ? "YES" : "NO");
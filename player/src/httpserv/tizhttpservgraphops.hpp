@@ -29,6 +29,8 @@
 #ifndef TIZHTTPSERVOPS_HPP
 #define TIZHTTPSERVOPS_HPP
 
+#include <vector>
+
 #include "tizgraphops.hpp"
 
 namespace tiz
@@ -41,35 +43,61 @@ namespace tiz
     {
     public:
       httpservops (graph *p_graph, const omx_comp_name_lst_t &comp_lst,
-                   const omx_comp_role_lst_t &role_lst);
+                   const omx_comp_role_lst_t &role_lst,
+                   const std::vector< int > &transcode_bitrates);
 
     public:
+      void do_setup ();
+      void do_tear_down_tunnels ();
       void do_probe ();
       void do_exe2pause ();
       void do_pause2exe ();
       void do_volume (const int step);
       void do_mute ();
 
+      // When transcoding, the component 0 transitions cycle the whole source
+      // segment, i.e. the metadata eraser and the decoder.
+      void do_loaded2idle_comp (const int comp_id);
+      void do_idle2exe_comp (const int comp_id);
+      void do_exe2idle_comp (const int comp_id);
+      void do_idle2loaded_comp (const int comp_id);
+
       void do_configure_server ();
       void do_configure_station ();
       void do_configure_stream ();
       bool is_initial_configuration () const;
       void do_flag_initial_config_done ();
+      bool is_end_of_track_eos (const OMX_HANDLETYPE handle,
+                                const OMX_U32 port) const;
 
     private:
+      bool is_transcoding () const;
+      int renderer_index () const;
+      int source_tunnel (const int tunnel_id) const;
       OMX_ERRORTYPE configure_server ();
       OMX_ERRORTYPE configure_station ();
+      OMX_ERRORTYPE configure_mount (const OMX_U32 port_id);
       OMX_ERRORTYPE configure_stream_metadata ();
+      OMX_ERRORTYPE configure_transcoding ();
+      OMX_ERRORTYPE configure_encoder_outputs ();
+      OMX_ERRORTYPE setup_output_tunnels ();
+      OMX_ERRORTYPE tear_down_output_tunnels ();
       OMX_ERRORTYPE switch_tunnel (const int tunnel_id,
           const OMX_COMMANDTYPE to_disabled_or_enabled);
 
     private:
       void get_mp3_codec_info (OMX_AUDIO_PARAM_MP3TYPE &mp3type);
+      void get_transcoded_mp3_info (const int bitrate_kbps,
+                                    OMX_AUDIO_PARAM_MP3TYPE &mp3type);
       // re-implemented from the base class
       bool probe_stream_hook ();
 
     private:
       bool is_initial_configuration_;
+      const std::vector< int > transcode_bitrates_;
+      // The encoders are set up for the first track's format
+      OMX_U32 transcode_rate_;
+      OMX_U32 transcode_channels_;
     };
   }  // namespace graph
 }  // namespace tiz
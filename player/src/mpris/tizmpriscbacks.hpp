@@ -46,6 +46,8 @@ namespace tiz
     public:
       typedef boost::function< OMX_ERRORTYPE() > cback_func_t;
       typedef boost::function< OMX_ERRORTYPE(double) > cback_vol_func_t;
+      typedef boost::function< OMX_ERRORTYPE(OMX_TICKS, bool) >
+          cback_seek_func_t;
 
     public:
       mpris_callbacks (cback_func_t play,
@@ -55,7 +57,8 @@ namespace tiz
                        cback_func_t playpause,
                        cback_func_t stop,
                        cback_func_t quit,
-                       cback_vol_func_t volume)
+                       cback_vol_func_t volume,
+                       cback_seek_func_t seek)
         :
         play_ (play),
         next_ (next),
@@ -64,7 +67,8 @@ namespace tiz
         playpause_ (playpause),
         stop_ (stop),
         quit_ (quit),
-        volume_ (volume)
+        volume_ (volume),
+        seek_ (seek)
       {}
 
     public:
@@ -76,6 +80,7 @@ namespace tiz
       cback_func_t stop_;
       cback_func_t quit_;
       cback_vol_func_t volume_;
+      cback_seek_func_t seek_;
     };
 
     typedef class mpris_callbacks mpris_callbacks_t;
@@ -153,13 +153,17 @@ void control::mprisif::Play ()
 
 void control::mprisif::Seek (const int64_t &Offset)
 {
-  // No-op for now
+  // MPRIS offsets are in microseconds, same as OMX_TICKS
+  const bool is_relative = true;
+  cbacks_.seek_ (Offset, is_relative);
 }
 
 void control::mprisif::SetPosition (const ::Tiz::DBus::Path &TrackId,
                                     const int64_t &Position)
 {
-  // No-op for now
+  // Only the current track can be seeked into, so TrackId is ignored
+  const bool is_relative = false;
+  cbacks_.seek_ (Position, is_relative);
 }
 
 void control::mprisif::OpenUri (const std::string &Uri)
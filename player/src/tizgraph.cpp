@@ -167,9 +167,10 @@ graph::graph::pause ()
 }
 
 OMX_ERRORTYPE
-graph::graph::seek ()
+graph::graph::seek (const OMX_TICKS position, const bool is_relative)
 {
-  return post_cmd (new tiz::graph::cmd (tiz::graph::seek_evt ()));
+  return post_cmd (
+      new tiz::graph::cmd (tiz::graph::seek_evt (position, is_relative)));
 }
 
 OMX_ERRORTYPE
@@ -248,6 +249,15 @@ void graph::graph::omx_evt (const omx_event_info &evt_info)
       post_cmd (new tiz::graph::cmd (tiz::graph::omx_port_enabled_evt (
           evt_info.component_, evt_info.ndata2_, error)));
     }
+    else if (evt_info.event_ == OMX_EventCmdComplete
+             && static_cast< OMX_COMMANDTYPE > (evt_info.ndata1_)
+                    == OMX_CommandFlush)
+    {
+      OMX_ERRORTYPE error
+          = static_cast< OMX_ERRORTYPE > (*((int *)&((evt_info.pEventData_))));
+      post_cmd (new tiz::graph::cmd (tiz::graph::omx_port_flushed_evt (
+          evt_info.component_, evt_info.ndata2_, error)));
+    }
     else if (evt_info.event_ == OMX_EventError)
     {
       post_cmd (new tiz::graph::cmd (tiz::graph::omx_err_evt (
@@ -440,6 +450,19 @@ void graph::graph::progress_display_stop ()
   }
 }
 
+// Moves the progress display to a new position (e.g. after a seek)
+void graph::graph::progress_display_set (unsigned long elapsed)
+{
+  if (p_progress_)
+  {
+    if (elapsed < p_progress_->count ())
+    {
+      p_progress_->restart (p_progress_->expected_count ());
+    }
+    (*p_progress_) += (elapsed - p_progress_->count ());
+  }
+}
+
 std::string graph::graph::get_graph_name () const
 {
   return graph_name_;
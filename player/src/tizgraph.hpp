@@ -74,7 +74,7 @@ namespace tiz
       OMX_ERRORTYPE execute (const tizgraphconfig_ptr_t config
                              = tizgraphconfig_ptr_t ());
       OMX_ERRORTYPE pause ();
-      OMX_ERRORTYPE seek ();
+      OMX_ERRORTYPE seek (const OMX_TICKS position, const bool is_relative);
       OMX_ERRORTYPE skip (const int jump);
       OMX_ERRORTYPE volume_step (const int step);
       OMX_ERRORTYPE volume (const double vol);
@@ -110,6 +110,7 @@ namespace tiz
       void progress_display_pause();
       void progress_display_resume();
       void progress_display_stop();
+      void progress_display_set(unsigned long elapsed);
 
       std::string get_graph_name () const;
 
@@ -88,6 +88,7 @@ namespace tiz
               else INJECT_EVENT (skip_evt)
                 else INJECT_EVENT (skipped_evt)
                   else INJECT_EVENT (seek_evt)
+                  else INJECT_EVENT (seeked_evt)
                     else INJECT_EVENT (volume_step_evt)
                       else INJECT_EVENT (volume_evt)
                         else INJECT_EVENT (mute_evt)
@@ -98,6 +99,7 @@ namespace tiz
                                   else INJECT_EVENT (unload_evt)
                                     else INJECT_EVENT (omx_port_disabled_evt)
                                       else INJECT_EVENT (omx_port_enabled_evt)
+                                      else INJECT_EVENT (omx_port_flushed_evt)
                                         else INJECT_EVENT (omx_port_settings_evt)
                                          else INJECT_EVENT (omx_index_setting_evt)
                                            else INJECT_EVENT (omx_format_detected_evt)
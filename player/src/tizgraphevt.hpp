@@ -103,8 +103,27 @@ namespace tiz
       }
     };
 
+    // Make this state convertible from any state (this event exits a
+    // sub-machine)
+    struct seeked_evt
+    {
+      seeked_evt ()
+      {
+      }
+      template < class Event >
+      seeked_evt (Event const &)
+      {
+      }
+    };
+
     struct seek_evt
     {
+      seek_evt (const OMX_TICKS position, const bool is_relative)
+        : position_ (position), is_relative_ (is_relative)
+      {
+      }
+      const OMX_TICKS position_;
+      const bool is_relative_;
     };
 
     struct volume_step_evt
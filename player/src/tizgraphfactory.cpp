@@ -45,6 +45,7 @@
 #include "decoders/tizpcmgraph.hpp"
 #include "decoders/tizmpeggraph.hpp"
 #include "tizprobe.hpp"
+#include "tizprobecache.hpp"
 #include "tizgraphfactory.hpp"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
@@ -56,8 +57,7 @@ namespace graph = tiz::graph;
 
 tizgraph_ptr_t graph::factory::create_graph (const std::string &uri)
 {
-  tizprobe_ptr_t p = boost::make_shared< tiz::probe >(uri,
-                                                      /* quiet = */ true);
+  tizprobe_ptr_t p = tiz::probecache::obtain (uri);
   tizgraph_ptr_t null_ptr;
   TIZ_LOG (TIZ_PRIORITY_DEBUG, "uri : %s", uri.c_str ());
   TIZ_LOG (TIZ_PRIORITY_DEBUG, "domain : %s",
@@ -120,8 +120,7 @@ tizgraph_ptr_t graph::factory::create_graph (const std::string &uri)
 
 std::string graph::factory::coding_type (const std::string &uri)
 {
-  tizprobe_ptr_t p = boost::make_shared< tiz::probe >(uri,
-                                                      /* quiet = */ true);
+  tizprobe_ptr_t p = tiz::probecache::obtain (uri);
   tizgraph_ptr_t null_ptr;
   TIZ_LOG (TIZ_PRIORITY_DEBUG, "uri : %s", uri.c_str ());
   TIZ_LOG (TIZ_PRIORITY_DEBUG, "domain : %s",
@@ -73,6 +73,7 @@ namespace tiz
                                                "configuring",
                                                "executing",
                                                "skipping",
+                                               "seeking",
                                                "exe2pause",
                                                "pause",
                                                "pause2exe",
@@ -274,6 +275,120 @@ namespace tiz
       // typedef boost::msm::back::state_machine<skipping_, boost::msm::back::mpl_graph_fsm_check> skipping;
       typedef boost::msm::back::state_machine<skipping_> skipping;
 
+      /* 'seeking' is a submachine */
+      struct seeking_ : public boost::msm::front::state_machine_def<seeking_>
+      {
+        // no need for exception handling
+        typedef int no_exception_thrown;
+
+        // data members
+        ops ** pp_ops_;
+
+        seeking_()
+          :
+          pp_ops_(NULL)
+        {}
+        seeking_(ops **pp_ops)
+          :
+          pp_ops_(pp_ops)
+        {
+          assert (pp_ops);
+        }
+
+        // submachine states
+        struct to_pause : public boost::msm::front::state<>
+        {
+          template <class Event,class FSM>
+          void on_entry(Event const & evt, FSM & fsm)
+          {
+            G_FSM_LOG();
+            if (fsm.pp_ops_ && *(fsm.pp_ops_))
+              {
+                (*(fsm.pp_ops_))->do_exe2pause_graph ();
+              }
+          }
+          template <class Event,class FSM>
+          void on_exit(Event const & evt, FSM & fsm) {G_FSM_LOG();}
+          OMX_STATETYPE target_omx_state () const
+          {
+            return OMX_StatePause;
+          }
+        };
+
+        struct flushing : public boost::msm::front::state<>
+        {
+          template <class Event,class FSM>
+          void on_entry(Event const & evt, FSM & fsm) {G_FSM_LOG();}
+          template <class Event,class FSM>
+          void on_exit(Event const & evt, FSM & fsm) {G_FSM_LOG();}
+        };
+
+        struct to_exe : public boost::msm::front::state<>
+        {
+          template <class Event,class FSM>
+          void on_entry(Event const & evt, FSM & fsm) {G_FSM_LOG();}
+          template <class Event,class FSM>
+          void on_exit(Event const & evt, FSM & fsm) {G_FSM_LOG();}
+          OMX_STATETYPE target_omx_state () const
+          {
+            return OMX_StateExecuting;
+          }
+        };
+
+        struct seek_exit : public boost::msm::front::exit_pseudo_state<seeked_evt>
+        {
+          template <class Event,class FSM>
+          void on_entry(Event const & evt, FSM & fsm) {G_FSM_LOG();}
+        };
+
+        // the initial state. Must be defined
+        typedef to_pause initial_state;
+
+        // transition actions
+
+        // guard conditions
+
+        // Transition table for seeking: the whole graph is paused and
+        // flushed before the source is repositioned, so that nothing from
+        // the old position reaches the renderer.
+        struct transition_table : boost::mpl::vector<
+          //                       Start             Event                  Next                   Action                           Guard
+          //    +-----------------+------------------+----------------------+----------------------+--------------------------------+---------------------------+
+          boost::msm::front::Row < to_pause          , omx_trans_evt        , flushing             , do_flush_graph                 , is_trans_complete         >,
+          boost::msm::front::Row < flushing          , omx_port_flushed_evt , to_exe               , boost::msm::front::ActionSequence_<
+                                                                                                     boost::mpl::vector<
+                                                                                                       do_seek,
+                                                                                                       do_pause2exe_graph> >    , is_port_flushing_complete >,
+          boost::msm::front::Row < to_exe            , omx_trans_evt        , seek_exit            , boost::msm::front::none        , is_trans_complete         >
+          //    +-----------------+------------------+----------------------+----------------------+--------------------------------+---------------------------+
+          > {};
+
+        // Commands and end of stream notifications that arrive while the
+        // seek is under way are kept, whatever the sub-state, and carried out
+        // once the graph is executing again (see seek_exit in the graph fsm).
+        struct internal_transition_table : boost::mpl::vector<
+          //                            Event            Action                     Guard
+          //    +----------------------+----------------+--------------------------+---------------------------+
+          boost::msm::front::Internal < pause_evt      , do_queue_pause           , boost::msm::front::none   >,
+          boost::msm::front::Internal < skip_evt       , do_queue_skip            , boost::msm::front::none   >,
+          boost::msm::front::Internal < stop_evt       , do_queue_stop            , boost::msm::front::none   >,
+          boost::msm::front::Internal < unload_evt     , do_queue_unload          , boost::msm::front::none   >,
+          boost::msm::front::Internal < omx_eos_evt    , do_queue_eos             , is_last_eos               >
+          //    +----------------------+----------------+--------------------------+---------------------------+
+          > {};
+
+        // Replaces the default no-transition response.
+        template <class FSM,class Event>
+        void no_transition(Event const& e, FSM&,int state)
+        {
+          TIZ_LOG (TIZ_PRIORITY_ERROR, "no transition from state %d on event %s",
+                   state, typeid(e).name());
+        }
+
+      };
+      // typedef boost::msm::back::state_machine<seeking_, boost::msm::back::mpl_graph_fsm_check> seeking;
+      typedef boost::msm::back::state_machine<seeking_> seeking;
+
       // The initial state of the SM. Must be defined
       typedef boost::mpl::vector<inited, AllOk> initial_state;
 
@@ -317,7 +432,12 @@ namespace tiz
                                                                                                do_destroy_graph> > , is_end_of_play       >,
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
         boost::msm::front::Row < executing   , skip_evt        , skipping                , do_store_skip                                  >,
-        boost::msm::front::Row < executing   , seek_evt        , boost::msm::front::none , do_seek                                        >,
+        boost::msm::front::Row < executing   , seek_evt        , seeking                 , boost::msm::front::ActionSequence_<
+                                                                                             boost::mpl::vector<
+                                                                                               do_store_seek,
+                                                                                               do_pause_progress_display> > , is_seekable          >,
+        boost::msm::front::Row < executing   , seek_evt        , boost::msm::front::none , boost::msm::front::none , boost::msm::front::euml::Not_<
+                                                                                                                       is_seekable>         >,
         boost::msm::front::Row < executing   , volume_step_evt , boost::msm::front::none , do_volume_step                                 >,
         boost::msm::front::Row < executing   , volume_evt      , boost::msm::front::none , do_volume                                      >,
         boost::msm::front::Row < executing   , mute_evt        , boost::msm::front::none , do_mute                                        >,
@@ -329,7 +449,7 @@ namespace tiz
         boost::msm::front::Row < executing   , unload_evt      , exe2idle                , do_exe2idle                                >,
         boost::msm::front::Row < executing   , omx_err_evt     , skipping                , boost::msm::front::none                        >,
         boost::msm::front::Row < executing   , omx_err_evt     , skipping                , do_record_fatal_error   , is_fatal_error       >,
-        boost::msm::front::Row < executing   , omx_eos_evt     , skipping                , boost::msm::front::none , is_last_eos          >,
+        boost::msm::front::Row < executing   , omx_eos_evt     , skipping                , do_retrieve_loudness    , is_last_eos          >,
         boost::msm::front::Row < executing   , timer_evt       , boost::msm::front::none , do_increase_progress_display                   >,
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
         boost::msm::front::Row < skipping
@@ -354,6 +474,18 @@ namespace tiz
                                   ::skip_exit>, skipped_evt    , configuring             , do_stop_progress_display , boost::msm::front::euml::Not_<
                                                                                                                        is_end_of_play>   >,
         //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
+        boost::msm::front::Row < seeking     , seek_evt        , boost::msm::front::none , do_queue_seek                                  >,
+        boost::msm::front::Row < seeking     , timer_evt       , boost::msm::front::none , boost::msm::front::none                        >,
+        boost::msm::front::Row < seeking     , omx_err_evt     , skipping                , boost::msm::front::none                        >,
+        boost::msm::front::Row < seeking     , omx_err_evt     , skipping                , do_record_fatal_error   , is_fatal_error       >,
+        boost::msm::front::Row < seeking
+                                 ::exit_pt
+                                 <seeking_
+                                  ::seek_exit>, seeked_evt     , executing               , boost::msm::front::ActionSequence_<
+                                                                                             boost::mpl::vector<
+                                                                                               do_end_seek,
+                                                                                               do_resume_progress_display> >              >,
+        //    +------------------------------+-----------------+-------------------------+-------------------------+----------------------+
         boost::msm::front::Row < exe2pause   , omx_trans_evt   , pause                   , boost::msm::front::ActionSequence_<
                                                                                              boost::mpl::vector<
                                                                                                do_ack_paused,
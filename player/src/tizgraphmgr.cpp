@@ -195,6 +195,13 @@ graphmgr::mgr::rwd ()
   return post_cmd (new graphmgr::cmd (graphmgr::rwd_evt ()));
 }
 
+OMX_ERRORTYPE
+graphmgr::mgr::seek (const OMX_TICKS position, const bool is_relative)
+{
+  return post_cmd (
+      new graphmgr::cmd (graphmgr::seek_evt (position, is_relative)));
+}
+
 OMX_ERRORTYPE
 graphmgr::mgr::volume_step (const int step)
 {
@@ -319,7 +326,8 @@ graphmgr::mgr::start_mpris (const graphmgr_capabilities_t &graphmgr_caps)
         boost::bind (&tiz::graphmgr::mgr::pause, this),
         boost::bind (&tiz::graphmgr::mgr::stop, this),
         boost::bind (&tiz::graphmgr::mgr::quit, this),
-        boost::bind (&tiz::graphmgr::mgr::volume, this, _1));
+        boost::bind (&tiz::graphmgr::mgr::volume, this, _1),
+        boost::bind (&tiz::graphmgr::mgr::seek, this, _1, _2));
 
     control::mpris_mediaplayer2_props_t props (
         graphmgr_caps.can_quit_, graphmgr_caps.can_raise_,
@@ -131,7 +131,7 @@ namespace tiz
       OMX_ERRORTYPE prev ();
 
       /**
-       * NOT IMPLEMENTED YET
+       * Skip forward 10 seconds within the current item in the playlist.
        *
        * @pre init() has been called on this manager.
        *
@@ -141,7 +141,7 @@ namespace tiz
       OMX_ERRORTYPE fwd ();
 
       /**
-       * NOT IMPLEMENTED YET
+       * Skip back 10 seconds within the current item in the playlist.
        *
        * @pre init() has been called on this manager.
        *
@@ -150,6 +150,19 @@ namespace tiz
        */
       OMX_ERRORTYPE rwd ();
 
+      /**
+       * Change the playback position within the current item in the playlist.
+       *
+       * @pre init() has been called on this manager.
+       *
+       * @param position The new position, in microseconds, or the offset from
+       * the current position if @a is_relative is true.
+       *
+       * @return OMX_ErrorInsuficientResources if OOM. OMX_ErrorNone in case of
+       * success.
+       */
+      OMX_ERRORTYPE seek (const OMX_TICKS position, const bool is_relative);
+
       /**
        * Increments or decrements the volume by steps.
        *
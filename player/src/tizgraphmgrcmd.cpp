@@ -82,6 +82,7 @@ void graphmgr::cmd::inject (fsm& machine) const
     else INJECT_EVENT (prev_evt)
       else INJECT_EVENT (fwd_evt)
         else INJECT_EVENT (rwd_evt)
+        else INJECT_EVENT (seek_evt)
           else INJECT_EVENT (vol_up_evt)
             else INJECT_EVENT (vol_down_evt)
               else INJECT_EVENT (vol_evt)
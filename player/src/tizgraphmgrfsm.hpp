@@ -83,6 +83,15 @@ namespace tiz
     struct prev_evt {};
     struct fwd_evt {};
     struct rwd_evt {};
+    struct seek_evt
+    {
+      seek_evt (const OMX_TICKS position, const bool is_relative)
+      : position_ (position), is_relative_ (is_relative)
+      {
+      }
+      const OMX_TICKS position_;
+      const bool is_relative_;
+    };
     struct vol_up_evt {};
     struct vol_down_evt {};
     struct vol_evt
@@ -195,14 +204,14 @@ namespace tiz
         // submachine states
         struct loading_graph : public boost::msm::front::state<>
         {
-          typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt, stop_evt, quit_evt> deferred_events;
+          typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, seek_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt, stop_evt, quit_evt> deferred_events;
           template <class Event,class FSM>
           void on_entry(Event const&, FSM& fsm) {GMGR_FSM_LOG ();}
         };
 
         struct starting_exit : public boost::msm::front::exit_pseudo_state<graph_execd_evt>
         {
-          typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt, stop_evt, quit_evt> deferred_events;
+          typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, seek_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt, stop_evt, quit_evt> deferred_events;
           template <class Event,class FSM>
           void on_entry(Event const&,FSM& ) {GMGR_FSM_LOG ();}
         };
@@ -259,7 +268,7 @@ namespace tiz
 
         struct restarting_exit : public boost::msm::front::exit_pseudo_state<graph_unlded_evt>
         {
-          typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt, stop_evt, quit_evt> deferred_events;
+          typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, seek_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt, stop_evt, quit_evt> deferred_events;
           template <class Event,class FSM>
           void on_entry(Event const&,FSM& ) {GMGR_FSM_LOG ();}
         };
@@ -400,7 +409,7 @@ namespace tiz
 
       struct executing_graph : public boost::msm::front::state<>
       {
-        typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt, stop_evt, quit_evt> deferred_events;
+        typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, seek_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt, stop_evt, quit_evt> deferred_events;
         template <class Event,class FSM>
         void on_entry(Event const&,FSM& ) {GMGR_FSM_LOG ();}
       };
@@ -446,7 +455,7 @@ namespace tiz
 
       struct unloading_graph : public boost::msm::front::state<>
       {
-        typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt> deferred_events;
+        typedef boost::mpl::vector<next_evt, prev_evt, fwd_evt, rwd_evt, seek_evt, vol_up_evt, vol_down_evt, vol_evt, mute_evt, pause_evt> deferred_events;
         template <class Event,class FSM>
         void on_entry(Event const&, FSM& fsm) {GMGR_FSM_LOG ();}
       };
@@ -546,6 +555,19 @@ namespace tiz
         }
       };
 
+      struct do_seek
+      {
+        template <class FSM,class EVT,class SourceState,class TargetState>
+        void operator()(EVT const& evt, FSM& fsm, SourceState& , TargetState& )
+        {
+          GMGR_FSM_LOG ();
+          if (fsm.pp_ops_ && *(fsm.pp_ops_))
+            {
+              (*(fsm.pp_ops_))->do_seek (evt.position_, evt.is_relative_);
+            }
+        }
+      };
+
       struct do_vol_up
       {
         template <class FSM,class EVT,class SourceState,class TargetState>
@@ -762,6 +784,7 @@ namespace tiz
         bmf::Row < running               , prev_evt         , bmf::none   , do_prev                                     >,
         bmf::Row < running               , fwd_evt          , bmf::none   , do_fwd                                      >,
         bmf::Row < running               , rwd_evt          , bmf::none   , do_rwd                                      >,
+        bmf::Row < running               , seek_evt         , bmf::none   , do_seek                                     >,
         bmf::Row < running               , vol_up_evt       , bmf::none   , do_vol_up                                   >,
         bmf::Row < running               , vol_down_evt     , bmf::none   , do_vol_down                                 >,
         bmf::Row < running               , vol_evt          , bmf::none   , do_vol                                      >,
@@ -49,6 +49,12 @@
 namespace graphmgr = tiz::graphmgr;
 namespace control = tiz::control;
 
+namespace
+{
+  // The step used by fwd/rwd, in microseconds
+  const OMX_TICKS SEEK_STEP_TICKS = 10 * OMX_TICKS_PER_SECOND;
+}
+
 //
 // ops
 //
@@ -251,12 +257,23 @@ void graphmgr::ops::do_prev ()
 
 void graphmgr::ops::do_fwd ()
 {
-  // TODO:
+  GMGR_OPS_BAIL_IF_ERROR (
+      p_managed_graph_, p_managed_graph_->seek (SEEK_STEP_TICKS, true),
+      "Unable to seek forward.");
 }
 
 void graphmgr::ops::do_rwd ()
 {
-  // TODO:
+  GMGR_OPS_BAIL_IF_ERROR (
+      p_managed_graph_, p_managed_graph_->seek (-SEEK_STEP_TICKS, true),
+      "Unable to seek backwards.");
+}
+
+void graphmgr::ops::do_seek (const OMX_TICKS position, const bool is_relative)
+{
+  GMGR_OPS_BAIL_IF_ERROR (p_managed_graph_,
+                          p_managed_graph_->seek (position, is_relative),
+                          "Unable to seek.");
 }
 
 void graphmgr::ops::do_vol_up ()
@@ -96,6 +96,7 @@ namespace tiz
       virtual void do_prev ();
       virtual void do_fwd ();
       virtual void do_rwd ();
+      virtual void do_seek (const OMX_TICKS position, const bool is_relative);
       virtual void do_vol_up ();
       virtual void do_vol_down ();
       virtual void do_vol (const double vol);
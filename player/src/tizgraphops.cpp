@@ -30,6 +30,7 @@
 #endif
 
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <vector>
@@ -42,6 +43,8 @@
 #include <boost/mem_fn.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/system/error_code.hpp>
 
 #include <tizplatform.h>
 #include <tizmacros.h>
@@ -52,6 +55,8 @@
 #include "tizgraphutil.hpp"
 #include "tizgraphcback.hpp"
 #include "tizgraphops.hpp"
+#include "tizprobecache.hpp"
+#include "tizloudnesscache.hpp"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
 #undef TIZ_LOG_CATEGORY_NAME
@@ -80,6 +85,20 @@ graph::ops::ops (graph *p_graph, const omx_comp_name_lst_t &comp_lst,
     metadata_ (),
     volume_ (80),
     duration_ (0),
+    elapsed_ (0),
+    seek_target_ (0),
+    queued_seek_ (0),
+    queued_seek_relative_ (false),
+    seek_queued_ (false),
+    seek_landed_ (false),
+    queued_cmd_ (QUEUED_NONE),
+    queued_jump_ (SKIP_DEFAULT_VALUE),
+    eos_queued_ (false),
+    queued_eos_handle_ (NULL),
+    queued_eos_port_ (0),
+    queued_eos_flags_ (0),
+    replaygain_ (util::get_replaygain_mode ()),
+    measuring_loudness_ (false),
     error_code_ (OMX_ErrorNone),
     error_msg_ ()
 {
@@ -440,9 +459,251 @@ void graph::ops::do_idle2loaded_comp (const int comp_id)
   }
 }
 
+/**
+ * Stores the target of a seek as an absolute media time. Relative seeks are
+ * taken from the position being heard, which lags the source's read position
+ * by whatever is buffered along the graph.
+ *
+ * @param position The target position (or offset, if relative) in
+ * microseconds.
+ *
+ * @param is_relative If true, @a position is an offset from the current
+ * position.
+ */
+void graph::ops::do_store_seek (const OMX_TICKS position,
+                                const bool is_relative)
+{
+  seek_target_ = is_relative ? rendered_position () + position : position;
+  if (seek_target_ < 0)
+  {
+    seek_target_ = 0;
+  }
+  seek_queued_ = false;
+  seek_landed_ = false;
+  queued_cmd_ = QUEUED_NONE;
+  queued_jump_ = SKIP_DEFAULT_VALUE;
+  eos_queued_ = false;
+}
+
+// Seeks requested while another one is under way are merged, and carried out
+// once it completes.
+void graph::ops::do_queue_seek (const OMX_TICKS position,
+                                const bool is_relative)
+{
+  if (seek_queued_ && is_relative && queued_seek_relative_)
+  {
+    queued_seek_ += position;
+  }
+  else
+  {
+    queued_seek_ = position;
+    queued_seek_relative_ = is_relative;
+  }
+  seek_queued_ = true;
+}
+
+// A second pause request cancels the first one, as it would have resumed
+// playback.
+void graph::ops::do_queue_pause ()
+{
+  if (QUEUED_PAUSE == queued_cmd_)
+  {
+    queued_cmd_ = QUEUED_NONE;
+  }
+  else if (QUEUED_NONE == queued_cmd_)
+  {
+    queued_cmd_ = QUEUED_PAUSE;
+  }
+}
+
+void graph::ops::do_queue_skip (const int jump)
+{
+  if (QUEUED_SKIP == queued_cmd_)
+  {
+    queued_jump_ += jump;
+  }
+  else if (queued_cmd_ < QUEUED_SKIP)
+  {
+    queued_cmd_ = QUEUED_SKIP;
+    queued_jump_ = jump;
+  }
+}
+
+void graph::ops::do_queue_stop ()
+{
+  if (queued_cmd_ < QUEUED_STOP)
+  {
+    queued_cmd_ = QUEUED_STOP;
+  }
+}
+
+void graph::ops::do_queue_unload ()
+{
+  queued_cmd_ = QUEUED_UNLOAD;
+}
+
+// The renderer may reach the end of the stream just before the graph is
+// paused. Whether that end of stream still stands depends on the seek having
+// moved the source, so it is only decided once the seek completes.
+void graph::ops::do_queue_eos (const OMX_HANDLETYPE handle, const OMX_U32 port,
+                               const OMX_U32 flags)
+{
+  eos_queued_ = true;
+  queued_eos_handle_ = handle;
+  queued_eos_port_ = port;
+  queued_eos_flags_ = flags;
+}
+
+void graph::ops::do_exe2pause_graph ()
+{
+  if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        util::transition_all (handles_, OMX_StatePause, OMX_StateExecuting),
+        "Unable to transition graph from Exe->Pause");
+    record_expected_transitions (OMX_StatePause);
+  }
+}
+
+// Flushes both ends of every tunnel, so that no data from the old position is
+// left anywhere in the graph.
+void graph::ops::do_flush_graph ()
+{
+  if (last_op_succeeded ())
+  {
+    const int nhandles = handles_.size ();
+    clear_expected_port_transitions ();
+    for (int i = 0; i < nhandles - 1; ++i)
+    {
+      // See util::setup_tunnels
+      add_expected_port_transition (handles_[i], i == 0 ? 0 : 1,
+                                    OMX_CommandFlush);
+      add_expected_port_transition (handles_[i + 1], 0, OMX_CommandFlush);
+    }
+    for (int i = 0; i < nhandles - 1; ++i)
+    {
+      G_OPS_BAIL_IF_ERROR (OMX_SendCommand (handles_[i], OMX_CommandFlush,
+                                            i == 0 ? 0 : 1, NULL),
+                           "Unable to flush the graph");
+      G_OPS_BAIL_IF_ERROR (
+          OMX_SendCommand (handles_[i + 1], OMX_CommandFlush, 0, NULL),
+          "Unable to flush the graph");
+    }
+  }
+}
+
+/**
+ * Default implementation of do_seek () operation. Once the graph is paused
+ * and flushed, it changes the media time position of the first element of
+ * the graph, and tells the renderer where the stream now starts.
+ */
 void graph::ops::do_seek ()
 {
-  // TODO
+  if (last_op_succeeded ())
+  {
+    assert (!handles_.empty ());
+    OMX_TICKS landed = seek_target_;
+    OMX_ERRORTYPE rc
+        = util::set_time_position (handles_[0], OMX_ALL, seek_target_);
+    if (OMX_ErrorNone != rc)
+    {
+      // Playback simply resumes where it was; this is not fatal
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "Seek not performed [%s]",
+               tiz_err_to_str (rc));
+      return;
+    }
+    seek_landed_ = true;
+    // The source may land a little before the target (e.g. on a frame
+    // boundary)
+    (void)util::get_time_position (handles_[0], OMX_ALL, landed);
+    // Not every renderer reports its position; this is not an error
+    OMX_U32 input_port = 0;
+    rc = util::set_time_position (handles_[handles_.size () - 1], input_port,
+                                  landed);
+    TIZ_LOG (TIZ_PRIORITY_TRACE, "target [%lld us] landed [%lld us] : [%s]",
+             (long long)seek_target_, (long long)landed, tiz_err_to_str (rc));
+  }
+}
+
+void graph::ops::do_pause2exe_graph ()
+{
+  if (last_op_succeeded ())
+  {
+    G_OPS_BAIL_IF_ERROR (
+        util::transition_all (handles_, OMX_StateExecuting, OMX_StatePause),
+        "Unable to transition graph from Pause->Exe");
+    record_expected_transitions (OMX_StateExecuting);
+  }
+}
+
+// Brings the elapsed time and the progress display in line with the position
+// now being heard, and carries out any seek requested in the meantime.
+void graph::ops::do_end_seek ()
+{
+  OMX_TICKS position = seek_target_;
+  if (!handles_.empty ())
+  {
+    (void)util::get_time_position (handles_[handles_.size () - 1], 0,
+                                   position);
+  }
+  elapsed_ = position > 0 ? static_cast< unsigned long > (position / 1000000)
+                          : 0;
+  if (p_graph_)
+  {
+    p_graph_->progress_display_set (elapsed_);
+  }
+  // The renderer discards its measurement when flushed; don't wait for it
+  measuring_loudness_ = false;
+  if (p_graph_)
+  {
+    replay_queued_cmds ();
+  }
+}
+
+// Carries out, in order, whatever arrived while the seek was under way. Stop,
+// unload and skip supersede anything else; a pending end of stream is only
+// honoured if the source was not moved, otherwise the source will signal it
+// again when it gets there.
+void graph::ops::replay_queued_cmds ()
+{
+  const queued_cmd_t cmd = queued_cmd_;
+  const bool replay_eos = eos_queued_ && !seek_landed_;
+  queued_cmd_ = QUEUED_NONE;
+  eos_queued_ = false;
+
+  switch (cmd)
+  {
+    case QUEUED_UNLOAD:
+      seek_queued_ = false;
+      p_graph_->unload ();
+      break;
+    case QUEUED_STOP:
+      seek_queued_ = false;
+      (void)p_graph_->stop ();
+      break;
+    case QUEUED_SKIP:
+      seek_queued_ = false;
+      (void)p_graph_->skip (queued_jump_);
+      break;
+    default:
+      if (replay_eos)
+      {
+        seek_queued_ = false;
+        p_graph_->omx_evt (omx_event_info (
+            queued_eos_handle_, OMX_EventBufferFlag, queued_eos_port_,
+            queued_eos_flags_, NULL));
+      }
+      if (seek_queued_)
+      {
+        seek_queued_ = false;
+        (void)p_graph_->seek (queued_seek_, queued_seek_relative_);
+      }
+      if (QUEUED_PAUSE == cmd)
+      {
+        (void)p_graph_->pause ();
+      }
+      break;
+  };
 }
 
 void graph::ops::do_skip ()
@@ -597,6 +858,36 @@ void graph::ops::do_retrieve_metadata ()
   // To be overriden in child classes when needed.
 }
 
+// Called when the renderer reaches the end of the stream. A track that was
+// measured from start to end gets its loudness and true peak cached, so that
+// it is normalised from the first sample the next time it is played.
+void graph::ops::do_retrieve_loudness ()
+{
+  if (!measuring_loudness_ || handles_.empty () || !playlist_)
+  {
+    return;
+  }
+  measuring_loudness_ = false;
+
+  OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE loudness;
+  OMX_U32 input_port = 0;
+  if (OMX_ErrorNone
+      == util::get_loudness (handles_[handles_.size () - 1], input_port,
+                             loudness))
+  {
+    // Anything less than most of the track, e.g. after a seek, is not
+    // representative
+    TIZ_LOG (TIZ_PRIORITY_TRACE, "loudness [%d LUFS/100] measured [%u ms]",
+             (int)loudness.nLoudness, (unsigned)loudness.nMeasured);
+    if (duration_ > 0 && loudness.nMeasured >= duration_ * 900)
+    {
+      tiz::loudnesscache::store (playlist_->get_current_uri (),
+                                 loudness.nLoudness / 100.0,
+                                 loudness.nTruePeak / 100.0);
+    }
+  }
+}
+
 void graph::ops::do_reset_internal_error ()
 {
   error_code_ = OMX_ErrorNone;
@@ -636,6 +927,7 @@ graph::ops::do_start_progress_display()
   if (last_op_succeeded () && p_graph_)
   {
     p_graph_->progress_display_start (duration_);
+    elapsed_ = 0;
   }
 }
 
@@ -645,6 +937,7 @@ graph::ops::do_increase_progress_display(void *ap_arg1, const unsigned int a_id)
   if (last_op_succeeded () && p_graph_)
   {
     p_graph_->progress_display_increase ();
+    ++elapsed_;
   }
 }
 
@@ -716,6 +1009,16 @@ bool graph::ops::is_skip_allowed () const
   return true;
 }
 
+// Only sources that report a media time can seek (e.g. local files, but not
+// network streams)
+bool graph::ops::is_seekable () const
+{
+  OMX_TICKS position = 0;
+  return !handles_.empty ()
+         && OMX_ErrorNone
+                == util::get_time_position (handles_[0], OMX_ALL, position);
+}
+
 OMX_ERRORTYPE
 graph::ops::internal_error () const
 {
@@ -805,6 +1108,12 @@ bool graph::ops::is_port_enabling_complete (const OMX_HANDLETYPE handle,
   return is_port_transition_complete (handle, port_id, OMX_CommandPortEnable);
 }
 
+bool graph::ops::is_port_flushing_complete (const OMX_HANDLETYPE handle,
+                                            const OMX_U32 port_id)
+{
+  return is_port_transition_complete (handle, port_id, OMX_CommandFlush);
+}
+
 bool graph::ops::last_op_succeeded () const
 {
 #ifdef _DEBUG
@@ -955,8 +1264,10 @@ graph::ops::probe_stream (const OMX_PORTDOMAINTYPE omx_domain,
 
   // Probe a new uri
   probe_ptr_.reset ();
-  const bool quiet_probing = true;
-  probe_ptr_ = boost::make_shared< tiz::probe >(uri, quiet_probing);
+  probe_ptr_ = tiz::probecache::obtain (uri);
+
+  // ... and the ones that follow, in the background
+  prefetch_probes ();
 
   if (probe_ptr_)
   {
@@ -1018,6 +1329,8 @@ graph::ops::probe_stream (const OMX_PORTDOMAINTYPE omx_domain,
         do_ack_metadata ();
       }
 
+      apply_loudness ();
+
       // Everything went well..
       rc = OMX_ErrorNone;
     }
@@ -1026,6 +1339,32 @@ graph::ops::probe_stream (const OMX_PORTDOMAINTYPE omx_domain,
   return rc;
 }
 
+/**
+ * Schedules the background probing of the playlist items that follow the
+ * current one, so that they are ready to play when their turn comes.
+ */
+void graph::ops::prefetch_probes ()
+{
+  const int prefetch_count = 3;
+  const uri_lst_t &uri_list = playlist_->get_uri_list ();
+  const int list_size = playlist_->size ();
+  uri_lst_t upcoming;
+  for (int i = 1; i <= prefetch_count && i < list_size; ++i)
+  {
+    int index = playlist_->current_index () + i;
+    if (index >= list_size)
+    {
+      if (!playlist_->loop_playback ())
+      {
+        break;
+      }
+      index %= list_size;
+    }
+    upcoming.push_back (uri_list[index]);
+  }
+  tiz::probecache::prefetch (upcoming);
+}
+
 bool graph::ops::probe_stream_hook ()
 {
   // Default implementation. To be overriden by derived classes to do
@@ -1179,6 +1518,78 @@ void graph::ops::store_last_track_duration(const char * p_value)
   }
 }
 
+// The media time of the sample being heard, as reported by the renderer.
+// Renderers that don't report it are taken to be where the progress display
+// is.
+OMX_TICKS graph::ops::rendered_position () const
+{
+  OMX_TICKS position = static_cast< OMX_TICKS > (elapsed_) * 1000000;
+  if (!handles_.empty ())
+  {
+    (void)util::get_time_position (handles_[handles_.size () - 1], 0,
+                                   position);
+  }
+  return position;
+}
+
+// Sets the renderer's normalisation gain for the track about to be played,
+// from its ReplayGain tags, or else from a previous measurement. Local files
+// with neither are measured while they play.
+void graph::ops::apply_loudness ()
+{
+  measuring_loudness_ = false;
+  if (replaygain_.compare ("off") == 0 || handles_.empty () || !probe_ptr_)
+  {
+    return;
+  }
+
+  const std::string &uri = playlist_->get_current_uri ();
+  double gain_db = 0;
+  double peak_db = 0;
+  double peak = 0;
+  bool normalise = true;
+  bool analyse = false;
+  double loudness = 0;
+  if (probe_ptr_->replay_gain (replaygain_.compare ("album") == 0, gain_db,
+                               peak)
+      || probe_ptr_->replay_gain (false, gain_db, peak))
+  {
+    // An unknown peak is assumed to be at full scale
+    peak_db = peak > 0 ? 20 * log10 (peak) : 0;
+  }
+  else if (tiz::loudnesscache::lookup (uri, loudness, peak_db))
+  {
+    gain_db = LOUDNESS_REFERENCE_LUFS - loudness;
+  }
+  else
+  {
+    boost::system::error_code ec;
+    analyse = boost::filesystem::is_regular_file (uri, ec);
+    normalise = false;
+  }
+
+  // There is no limiter after the renderer's gain stage, so the gain is
+  // capped at the headroom left below the true peak ceiling. ReplayGain
+  // peaks are sample peaks, which the signal may exceed between samples;
+  // the ceiling's margin covers that too.
+  if (normalise && gain_db > LOUDNESS_MAX_TRUE_PEAK_DBTP - peak_db)
+  {
+    TIZ_LOG (TIZ_PRIORITY_TRACE, "gain [%.2f dB] capped to [%.2f dB]", gain_db,
+             LOUDNESS_MAX_TRUE_PEAK_DBTP - peak_db);
+    gain_db = LOUDNESS_MAX_TRUE_PEAK_DBTP - peak_db;
+  }
+
+  OMX_U32 input_port = 0;
+  // Not every renderer supports normalisation; this is not an error
+  const OMX_ERRORTYPE rc
+      = util::apply_loudness (handles_[handles_.size () - 1], input_port,
+                              gain_db, peak_db, analyse);
+  measuring_loudness_ = (OMX_ErrorNone == rc && analyse);
+  TIZ_LOG (TIZ_PRIORITY_TRACE,
+           "gain [%.2f dB] peak [%.2f dB] analyse [%s] : [%s]", gain_db,
+           peak_db, analyse ? "YES" : "NO", tiz_err_to_str (rc));
+}
+
 graph::cbackhandler &graph::ops::get_cback_handler () const
 {
   return p_graph_->cback_handler_;
@@ -86,6 +86,22 @@ namespace tiz
     {
     public:
       static const int SKIP_DEFAULT_VALUE = 1;
+      // Commands received while a seek is under way, in increasing order of
+      // precedence; only the strongest one is carried out once it completes
+      enum queued_cmd_t
+      {
+        QUEUED_NONE,
+        QUEUED_PAUSE,
+        QUEUED_SKIP,
+        QUEUED_STOP,
+        QUEUED_UNLOAD
+      };
+      // Tracks are normalised to this loudness (LUFS), ReplayGain 2.0's
+      // reference level
+      static const int LOUDNESS_REFERENCE_LUFS = -18;
+      // Normalised tracks' peaks are kept below this level (dBTP), EBU
+      // R128's maximum true peak
+      static const int LOUDNESS_MAX_TRUE_PEAK_DBTP = -1;
 
     public:
       ops (graph *p_graph, const omx_comp_name_lst_t &comp_lst,
@@ -131,7 +147,21 @@ namespace tiz
       virtual void do_exe2idle_comp (const int comp_id);
       virtual void do_idle2loaded ();
       virtual void do_idle2loaded_comp (const int comp_id);
+      virtual void do_store_seek (const OMX_TICKS position,
+                                  const bool is_relative);
+      virtual void do_queue_seek (const OMX_TICKS position,
+                                  const bool is_relative);
+      virtual void do_queue_pause ();
+      virtual void do_queue_skip (const int jump);
+      virtual void do_queue_stop ();
+      virtual void do_queue_unload ();
+      virtual void do_queue_eos (const OMX_HANDLETYPE handle, const OMX_U32 port,
+                                 const OMX_U32 flags);
+      virtual void do_exe2pause_graph ();
+      virtual void do_flush_graph ();
       virtual void do_seek ();
+      virtual void do_pause2exe_graph ();
+      virtual void do_end_seek ();
       virtual void do_skip ();
       virtual void do_store_skip (const int jump);
       virtual void do_volume_step (const int step);
@@ -147,6 +177,7 @@ namespace tiz
       virtual void do_record_destination (
           const OMX_STATETYPE destination_state);
       virtual void do_retrieve_metadata ();
+      virtual void do_retrieve_loudness ();
       virtual void do_reset_internal_error ();
       virtual void do_record_fatal_error (const OMX_HANDLETYPE handle,
                                           const OMX_ERRORTYPE error,
@@ -166,6 +197,7 @@ namespace tiz
                                       const OMX_U32 port_id,
                                       const OMX_INDEXTYPE index_id) const;
       virtual bool is_skip_allowed () const;
+      virtual bool is_seekable () const;
 
       OMX_ERRORTYPE internal_error () const;
       std::string internal_error_msg () const;
@@ -182,6 +214,8 @@ namespace tiz
                                        const OMX_U32 port_id);
       bool is_port_enabling_complete (const OMX_HANDLETYPE handle,
                                       const OMX_U32 port_id);
+      bool is_port_flushing_complete (const OMX_HANDLETYPE handle,
+                                      const OMX_U32 port_id);
       bool last_op_succeeded () const;
       bool is_end_of_play () const;
       bool is_probing_result_ok () const;
@@ -216,6 +250,7 @@ namespace tiz
           stream_info_dump_func_t stream_info_dump_f, const bool quiet = false);
 
       virtual bool probe_stream_hook ();
+      void prefetch_probes ();
       virtual OMX_ERRORTYPE transition_source (const OMX_STATETYPE to_state);
       virtual OMX_ERRORTYPE transition_comp (const int comp_id,
                                              const OMX_STATETYPE to_state);
@@ -231,6 +266,9 @@ namespace tiz
                                                 = true);
 
       virtual void store_last_track_duration(const char * p_value);
+      virtual OMX_TICKS rendered_position () const;
+      virtual void replay_queued_cmds ();
+      virtual void apply_loudness ();
 
       cbackhandler &get_cback_handler () const;
 
@@ -250,6 +288,20 @@ namespace tiz
       track_metadata_map_t metadata_;
       int volume_;
       unsigned long duration_;
+      unsigned long elapsed_;
+      OMX_TICKS seek_target_;
+      OMX_TICKS queued_seek_;
+      bool queued_seek_relative_;
+      bool seek_queued_;
+      bool seek_landed_;
+      queued_cmd_t queued_cmd_;
+      int queued_jump_;
+      bool eos_queued_;
+      OMX_HANDLETYPE queued_eos_handle_;
+      OMX_U32 queued_eos_port_;
+      OMX_U32 queued_eos_flags_;
+      std::string replaygain_;
+      bool measuring_loudness_;
       OMX_ERRORTYPE error_code_;
       std::string error_msg_;
     };
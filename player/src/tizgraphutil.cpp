@@ -29,6 +29,9 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+
+#include <algorithm>
 #include <boost/foreach.hpp>
 #include <string>
 
@@ -540,6 +543,55 @@ graph::util::apply_mute (const OMX_HANDLETYPE handle, const OMX_U32 pid)
   return rc;
 }
 
+OMX_ERRORTYPE
+graph::util::apply_loudness (const OMX_HANDLETYPE handle, const OMX_U32 pid,
+                             const double gain_db, const double peak_db,
+                             const bool analyse)
+{
+  OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE loudness;
+  TIZ_INIT_OMX_PORT_STRUCT (loudness, pid);
+  loudness.nGain = static_cast< OMX_S32 > (gain_db * 100);
+  loudness.nPeak = static_cast< OMX_S32 > (peak_db * 100);
+  loudness.bAnalyse = analyse ? OMX_TRUE : OMX_FALSE;
+  return OMX_SetConfig (
+      handle,
+      static_cast< OMX_INDEXTYPE > (OMX_TizoniaIndexConfigAudioLoudness),
+      &loudness);
+}
+
+OMX_ERRORTYPE
+graph::util::get_loudness (const OMX_HANDLETYPE handle, const OMX_U32 pid,
+                           OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE &loudness)
+{
+  TIZ_INIT_OMX_PORT_STRUCT (loudness, pid);
+  return OMX_GetConfig (
+      handle,
+      static_cast< OMX_INDEXTYPE > (OMX_TizoniaIndexConfigAudioLoudness),
+      &loudness);
+}
+
+OMX_ERRORTYPE
+graph::util::get_time_position (const OMX_HANDLETYPE handle,
+                                const OMX_U32 pid, OMX_TICKS &position)
+{
+  OMX_TIME_CONFIG_TIMESTAMPTYPE timestamp;
+  TIZ_INIT_OMX_PORT_STRUCT (timestamp, pid);
+  tiz_check_omx (
+      OMX_GetConfig (handle, OMX_IndexConfigTimePosition, &timestamp));
+  position = timestamp.nTimestamp;
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+graph::util::set_time_position (const OMX_HANDLETYPE handle,
+                                const OMX_U32 pid, const OMX_TICKS position)
+{
+  OMX_TIME_CONFIG_TIMESTAMPTYPE timestamp;
+  TIZ_INIT_OMX_PORT_STRUCT (timestamp, pid);
+  timestamp.nTimestamp = position;
+  return OMX_SetConfig (handle, OMX_IndexConfigTimePosition, &timestamp);
+}
+
 OMX_ERRORTYPE
 graph::util::apply_playlist_jump (const OMX_HANDLETYPE handle,
                                   const OMX_S32 jump)
@@ -1072,6 +1124,79 @@ bool graph::util::is_mpris_enabled ()
   return is_enabled;
 }
 
+bool graph::util::is_media_library_index_enabled ()
+{
+  bool is_enabled = false;
+  const char *p_medialib_enabled
+      = tiz_rcfile_get_value ("tizonia", "media-library-index");
+  if (p_medialib_enabled)
+  {
+    std::string medialib_enabled_str;
+    medialib_enabled_str.assign (p_medialib_enabled);
+    if (medialib_enabled_str.compare ("true") == 0)
+    {
+      is_enabled = true;
+    }
+  }
+  return is_enabled;
+}
+
+// One of "off" (the default), "track" or "album"
+std::string graph::util::get_replaygain_mode ()
+{
+  std::string mode ("off");
+  const char *p_mode = tiz_rcfile_get_value ("tizonia", "replaygain");
+  if (p_mode)
+  {
+    const std::string mode_str (p_mode);
+    if (mode_str.compare ("track") == 0 || mode_str.compare ("album") == 0)
+    {
+      mode = mode_str;
+    }
+  }
+  return mode;
+}
+
+// The rates the audio device plays natively, e.g. "48000,96000". Empty if
+// the player is not to convert the rate of any stream.
+std::vector< OMX_U32 > graph::util::get_output_sample_rates ()
+{
+  std::vector< OMX_U32 > rates;
+  const char *p_rates = tiz_rcfile_get_value ("tizonia", "output-sample-rates");
+  while (p_rates && *p_rates)
+  {
+    char *p_end = NULL;
+    const unsigned long rate = strtoul (p_rates, &p_end, 10);
+    if (p_end == p_rates)
+    {
+      // Skip the separator
+      ++p_rates;
+      continue;
+    }
+    if (rate > 0)
+    {
+      rates.push_back (rate);
+    }
+    p_rates = p_end;
+  }
+  return rates;
+}
+
+// Returns the rate that a stream at @a stream_rate must be converted to, i.e.
+// @a stream_rate itself if the device plays it natively (or if no rates are
+// configured), or else the device's preferred rate, i.e. the first one
+// configured.
+OMX_U32 graph::util::get_output_sample_rate (const OMX_U32 stream_rate)
+{
+  const std::vector< OMX_U32 > rates (get_output_sample_rates ());
+  if (rates.empty ()
+      || std::find (rates.begin (), rates.end (), stream_rate) != rates.end ())
+  {
+    return stream_rate;
+  }
+  return rates[0];
+}
+
 void graph::util::copy_omx_string (
     OMX_U8 *p_dest, const std::string &omx_string,
     const size_t max_length /*  = OMX_MAX_STRINGNAME_SIZE */
@@ -30,6 +30,7 @@
 #define TIZGRAPHUTIL_HPP
 
 #include <string>
+#include <vector>
 
 #include <boost/function.hpp>
 
@@ -117,9 +118,27 @@ namespace tiz
       static OMX_ERRORTYPE apply_mute (const OMX_HANDLETYPE handle,
                                        const OMX_U32 pid);
 
+      static OMX_ERRORTYPE apply_loudness (const OMX_HANDLETYPE handle,
+                                           const OMX_U32 pid,
+                                           const double gain_db,
+                                           const double peak_db,
+                                           const bool analyse);
+
+      static OMX_ERRORTYPE get_loudness (
+          const OMX_HANDLETYPE handle, const OMX_U32 pid,
+          OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE &loudness);
+
       static OMX_ERRORTYPE apply_playlist_jump (const OMX_HANDLETYPE handle,
                                                 const OMX_S32 jump);
 
+      static OMX_ERRORTYPE get_time_position (const OMX_HANDLETYPE handle,
+                                              const OMX_U32 pid,
+                                              OMX_TICKS &position);
+
+      static OMX_ERRORTYPE set_time_position (const OMX_HANDLETYPE handle,
+                                              const OMX_U32 pid,
+                                              const OMX_TICKS position);
+
       static OMX_ERRORTYPE disable_port (const OMX_HANDLETYPE handle,
                                          const OMX_U32 port_id);
       static OMX_ERRORTYPE enable_port (const OMX_HANDLETYPE handle,
@@ -238,6 +257,14 @@ namespace tiz
 
       static bool is_mpris_enabled ();
 
+      static bool is_media_library_index_enabled ();
+
+      static std::string get_replaygain_mode ();
+
+      static std::vector< OMX_U32 > get_output_sample_rates ();
+
+      static OMX_U32 get_output_sample_rate (const OMX_U32 stream_rate);
+
       static void copy_omx_string (OMX_U8 *p_dest,
                                    const std::string &omx_string,
                                    const size_t max_length
@@ -0,0 +1,263 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file   tizloudnesscache.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  On-disk cache of loudness measurements of local media files
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <tizplatform.h>
+
+#include "tizmedialib.hpp"
+#include "tizloudnesscache.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.loudnesscache"
+#endif
+
+#define LOUDNESSCACHE_MAGIC "TIZLOUD"
+#define LOUDNESSCACHE_VERSION 1
+
+namespace  // unnamed namespace
+{
+  struct record
+  {
+    record ()
+      : size_ (0), mtime_sec_ (0), mtime_nsec_ (0), loudness_ (0), true_peak_ (0)
+    {
+    }
+    long long size_;
+    long long mtime_sec_;
+    long long mtime_nsec_;
+    double loudness_;
+    double true_peak_;
+  };
+
+  bool stat_file (const std::string &uri, record &rec)
+  {
+    struct stat st;
+    if (0 != stat (uri.c_str (), &st) || !S_ISREG (st.st_mode))
+    {
+      return false;
+    }
+    rec.size_ = st.st_size;
+    rec.mtime_sec_ = st.st_mtim.tv_sec;
+    rec.mtime_nsec_ = st.st_mtim.tv_nsec;
+    return true;
+  }
+
+  // The store is a text file with a header line, and then one line per file:
+  // size, mtime (sec, nsec), loudness, true peak and the path, which takes up
+  // the rest of the line.
+  class cache
+  {
+  public:
+    cache ()
+      : path_ ((boost::filesystem::path (tiz::medialib::default_index_path ())
+                    .parent_path ()
+                / "loudness.db")
+                   .string ()),
+        records_ (),
+        mutex_ (),
+        loaded_ (false),
+        inited_ (false)
+    {
+      inited_ = (OMX_ErrorNone == tiz_mutex_init (&mutex_));
+    }
+
+    ~cache ()
+    {
+      if (inited_)
+      {
+        (void)tiz_mutex_destroy (&mutex_);
+      }
+    }
+
+    bool lookup (const std::string &uri, double &loudness, double &true_peak)
+    {
+      bool found = false;
+      record current;
+      if (inited_ && stat_file (uri, current))
+      {
+        tiz_mutex_lock (&mutex_);
+        load ();
+        record_map_t::const_iterator it = records_.find (uri);
+        if (it != records_.end () && it->second.size_ == current.size_
+            && it->second.mtime_sec_ == current.mtime_sec_
+            && it->second.mtime_nsec_ == current.mtime_nsec_)
+        {
+          loudness = it->second.loudness_;
+          true_peak = it->second.true_peak_;
+          found = true;
+        }
+        tiz_mutex_unlock (&mutex_);
+      }
+      return found;
+    }
+
+    void store (const std::string &uri, const double loudness,
+                const double true_peak)
+    {
+      record rec;
+      if (inited_ && uri.find ('\n') == std::string::npos
+          && stat_file (uri, rec))
+      {
+        rec.loudness_ = loudness;
+        rec.true_peak_ = true_peak;
+        tiz_mutex_lock (&mutex_);
+        load ();
+        records_[uri] = rec;
+        save ();
+        tiz_mutex_unlock (&mutex_);
+      }
+    }
+
+  private:
+    typedef std::map< std::string, record > record_map_t;
+
+  private:
+    // Must be called with the mutex held
+    void load ()
+    {
+      if (loaded_)
+      {
+        return;
+      }
+      loaded_ = true;
+
+      std::ifstream in (path_.c_str ());
+      std::string line;
+      int version = 0;
+      if (!std::getline (in, line)
+          || 1 != sscanf (line.c_str (), LOUDNESSCACHE_MAGIC " %d", &version)
+          || LOUDNESSCACHE_VERSION != version)
+      {
+        TIZ_LOG (TIZ_PRIORITY_NOTICE, "No loudness measurements at [%s]",
+                 path_.c_str ());
+        return;
+      }
+
+      while (std::getline (in, line))
+      {
+        std::istringstream fields (line);
+        record rec;
+        std::string uri;
+        if (fields >> rec.size_ >> rec.mtime_sec_ >> rec.mtime_nsec_
+            >> rec.loudness_ >> rec.true_peak_)
+        {
+          fields.get ();  // the separator
+          if (std::getline (fields, uri) && !uri.empty ())
+          {
+            records_[uri] = rec;
+          }
+        }
+      }
+      TIZ_LOG (TIZ_PRIORITY_NOTICE, "[%s] : %u files measured",
+               path_.c_str (), (unsigned)records_.size ());
+    }
+
+    // Must be called with the mutex held
+    void save ()
+    {
+      boost::system::error_code ec;
+      boost::filesystem::create_directories (
+          boost::filesystem::path (path_).parent_path (), ec);
+
+      // Write a new file and rename it, so that a reader never sees a
+      // partially written store
+      const std::string tmp_path (path_ + ".tmp");
+      std::ofstream out (tmp_path.c_str (), std::ios::out | std::ios::trunc);
+      if (!out)
+      {
+        TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to write [%s]",
+                 tmp_path.c_str ());
+        return;
+      }
+
+      out << LOUDNESSCACHE_MAGIC << " " << LOUDNESSCACHE_VERSION << "\n";
+      out.precision (4);
+      out << std::fixed;
+      for (record_map_t::const_iterator it = records_.begin ();
+           it != records_.end (); ++it)
+      {
+        const record &rec = it->second;
+        out << rec.size_ << " " << rec.mtime_sec_ << " " << rec.mtime_nsec_
+            << " " << rec.loudness_ << " " << rec.true_peak_ << " "
+            << it->first << "\n";
+      }
+      out.close ();
+
+      if (!out || 0 != rename (tmp_path.c_str (), path_.c_str ()))
+      {
+        TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to write [%s]", path_.c_str ());
+        (void)unlink (tmp_path.c_str ());
+      }
+    }
+
+  private:
+    const std::string path_;
+    record_map_t records_;
+    tiz_mutex_t mutex_;
+    bool loaded_;
+    bool inited_;
+  };
+
+  cache &the_cache ()
+  {
+    static cache c;
+    return c;
+  }
+}  // unnamed namespace
+
+//
+// loudnesscache
+//
+bool tiz::loudnesscache::lookup (const std::string &uri, double &loudness,
+                                 double &true_peak)
+{
+  return the_cache ().lookup (uri, loudness, true_peak);
+}
+
+void tiz::loudnesscache::store (const std::string &uri, const double loudness,
+                                const double true_peak)
+{
+  the_cache ().store (uri, loudness, true_peak);
+}
@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file   tizloudnesscache.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  On-disk cache of loudness measurements of local media files
+ *
+ *
+ */
+
+#ifndef TIZLOUDNESSCACHE_HPP
+#define TIZLOUDNESSCACHE_HPP
+
+#include <string>
+
+namespace tiz
+{
+  /**
+   * A persistent store of the EBU R128 measurements taken by the renderer
+   * while playing local files. Entries are keyed by path, size and
+   * modification time, so a file that changes is measured again. The
+   * store lives next to the media library index.
+   */
+  class loudnesscache
+  {
+
+  public:
+    /**
+     * Retrieves the measurements of @a uri.
+     *
+     * @param loudness The integrated loudness, in LUFS.
+     * @param true_peak The true-peak level, in dBTP.
+     *
+     * @return true if @a uri has been measured, and hasn't changed since.
+     */
+    static bool lookup (const std::string &uri, double &loudness,
+                        double &true_peak);
+
+    /**
+     * Records the measurements of @a uri, and writes the store to disk.
+     */
+    static void store (const std::string &uri, const double loudness,
+                       const double true_peak);
+  };
+}  // namespace tiz
+
+#endif  // TIZLOUDNESSCACHE_HPP
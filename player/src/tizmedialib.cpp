@@ -0,0 +1,1210 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizmedialib.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Persistent index of local media directories and files
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <tizplatform.h>
+
+#include "tizmedialib.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.medialib"
+#endif
+
+#define MEDIALIB_MAGIC "TIZMLIB"
+#define MEDIALIB_MAGIC_LEN 8
+#define MEDIALIB_VERSION 2
+#define MEDIALIB_SCAN_THREADS 8
+
+namespace  // unnamed namespace
+{
+  // The index file is laid out as follows:
+  //
+  //   file_header | dir_slot[ndirs] | entry_slot[nentries]
+  //               | probe_slot[nprobes] | heap
+  //
+  // Strings (paths, entry names) and the serialized probe results live in
+  // the heap. Dir and probe slots are sorted by path, and the entries of a
+  // directory by name, in the same order as std::string's (i.e. memcmp's).
+  struct file_header
+  {
+    char magic_[MEDIALIB_MAGIC_LEN];
+    uint32_t version_;
+    uint32_t ndirs_;
+    uint32_t nentries_;
+    uint32_t nprobes_;
+    uint64_t dirs_off_;
+    uint64_t entries_off_;
+    uint64_t probes_off_;
+    uint64_t heap_off_;
+    uint64_t heap_len_;
+  };
+
+  struct dir_slot
+  {
+    uint64_t key_off_;
+    uint32_t key_len_;
+    uint32_t nentries_;
+    uint64_t first_entry_;
+    int64_t mtime_sec_;
+    int64_t mtime_nsec_;
+  };
+
+  struct entry_slot
+  {
+    uint64_t key_off_;
+    uint32_t key_len_;
+    uint32_t is_dir_;
+  };
+
+  struct probe_slot
+  {
+    uint64_t key_off_;
+    uint32_t key_len_;
+    uint32_t data_len_;
+    uint64_t data_off_;
+    int64_t size_;
+    int64_t mtime_sec_;
+    int64_t mtime_nsec_;
+  };
+
+  template < typename T >
+  T slot_at (const char *p_slots, const size_t index)
+  {
+    // The mapped file gives no alignment guarantees
+    T slot;
+    memcpy (&slot, p_slots + index * sizeof (T), sizeof (T));
+    return slot;
+  }
+
+  template < typename T >
+  int compare_key (const char *p_heap, const T &slot, const std::string &key)
+  {
+    const size_t len = std::min< size_t > (slot.key_len_, key.size ());
+    const int rc = memcmp (p_heap + slot.key_off_, key.data (), len);
+    if (0 != rc)
+    {
+      return rc;
+    }
+    return (slot.key_len_ < key.size ()) ? -1
+                                          : (slot.key_len_ > key.size ()) ? 1
+                                                                          : 0;
+  }
+
+  // Binary search over a table of slots sorted by key; returns the index of
+  // the slot, or -1 if not found
+  template < typename T >
+  long find_slot (const char *p_slots, const size_t nslots,
+                  const char *p_heap, const std::string &key)
+  {
+    size_t lo = 0;
+    size_t hi = nslots;
+    while (lo < hi)
+    {
+      const size_t mid = lo + (hi - lo) / 2;
+      const int rc = compare_key (p_heap, slot_at< T > (p_slots, mid), key);
+      if (0 == rc)
+      {
+        return mid;
+      }
+      if (rc < 0)
+      {
+        lo = mid + 1;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+    return -1;
+  }
+
+  bool in_range (const uint64_t off, const uint64_t len, const uint64_t max)
+  {
+    return off <= max && len <= max - off;
+  }
+
+  // A read-only view of a mapped index file
+  class index_view
+  {
+  public:
+    index_view (const char *p_data, const size_t len)
+      : p_data_ (p_data), len_ (len), header_ ()
+    {
+      if (p_data_ && len_ >= sizeof (header_))
+      {
+        memcpy (&header_, p_data_, sizeof (header_));
+      }
+      else
+      {
+        p_data_ = NULL;
+      }
+    }
+
+    // Checks the file's structure, so that the other methods don't have to
+    bool validate () const
+    {
+      if (!p_data_ || 0 != memcmp (header_.magic_, MEDIALIB_MAGIC,
+                                   MEDIALIB_MAGIC_LEN)
+          || MEDIALIB_VERSION != header_.version_
+          || !in_range (header_.dirs_off_,
+                        (uint64_t)header_.ndirs_ * sizeof (dir_slot), len_)
+          || !in_range (header_.entries_off_,
+                        (uint64_t)header_.nentries_ * sizeof (entry_slot),
+                        len_)
+          || !in_range (header_.probes_off_,
+                        (uint64_t)header_.nprobes_ * sizeof (probe_slot),
+                        len_)
+          || !in_range (header_.heap_off_, header_.heap_len_, len_))
+      {
+        return false;
+      }
+
+      for (uint32_t i = 0; i < header_.ndirs_; ++i)
+      {
+        const dir_slot slot = dir_at (i);
+        if (!in_range (slot.key_off_, slot.key_len_, header_.heap_len_)
+            || !in_range (slot.first_entry_, slot.nentries_,
+                          header_.nentries_))
+        {
+          return false;
+        }
+      }
+      for (uint32_t i = 0; i < header_.nentries_; ++i)
+      {
+        const entry_slot slot = entry_at (i);
+        if (!in_range (slot.key_off_, slot.key_len_, header_.heap_len_))
+        {
+          return false;
+        }
+      }
+      for (uint32_t i = 0; i < header_.nprobes_; ++i)
+      {
+        const probe_slot slot = probe_at (i);
+        if (!in_range (slot.key_off_, slot.key_len_, header_.heap_len_)
+            || !in_range (slot.data_off_, slot.data_len_, header_.heap_len_))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    size_t ndirs () const
+    {
+      return p_data_ ? header_.ndirs_ : 0;
+    }
+
+    size_t nprobes () const
+    {
+      return p_data_ ? header_.nprobes_ : 0;
+    }
+
+    dir_slot dir_at (const size_t index) const
+    {
+      return slot_at< dir_slot > (p_data_ + header_.dirs_off_, index);
+    }
+
+    entry_slot entry_at (const size_t index) const
+    {
+      return slot_at< entry_slot > (p_data_ + header_.entries_off_, index);
+    }
+
+    probe_slot probe_at (const size_t index) const
+    {
+      return slot_at< probe_slot > (p_data_ + header_.probes_off_, index);
+    }
+
+    long find_dir (const std::string &path) const
+    {
+      return p_data_ ? find_slot< dir_slot > (p_data_ + header_.dirs_off_,
+                                              header_.ndirs_, heap (), path)
+                     : -1;
+    }
+
+    long find_probe (const std::string &path) const
+    {
+      return p_data_
+                 ? find_slot< probe_slot > (p_data_ + header_.probes_off_,
+                                            header_.nprobes_, heap (), path)
+                 : -1;
+    }
+
+    template < typename T >
+    std::string key (const T &slot) const
+    {
+      return std::string (heap () + slot.key_off_, slot.key_len_);
+    }
+
+    std::string data (const probe_slot &slot) const
+    {
+      return std::string (heap () + slot.data_off_, slot.data_len_);
+    }
+
+  private:
+    const char *heap () const
+    {
+      return p_data_ + header_.heap_off_;
+    }
+
+  private:
+    const char *p_data_;
+    const size_t len_;
+    file_header header_;
+  };
+
+  // Builds a new index file; records must be added in key order
+  class index_writer
+  {
+  public:
+    index_writer () : heap_ (), dirs_ (), entries_ (), probes_ ()
+    {
+    }
+
+    void add_dir (const std::string &path, const long long mtime_sec,
+                  const long long mtime_nsec)
+    {
+      dir_slot slot;
+      slot.key_off_ = add_str (path);
+      slot.key_len_ = path.size ();
+      slot.nentries_ = 0;
+      slot.first_entry_ = entries_.size ();
+      slot.mtime_sec_ = mtime_sec;
+      slot.mtime_nsec_ = mtime_nsec;
+      dirs_.push_back (slot);
+    }
+
+    // Adds an entry to the last directory added
+    void add_entry (const std::string &name, const bool is_dir)
+    {
+      assert (!dirs_.empty ());
+      entry_slot slot;
+      slot.key_off_ = add_str (name);
+      slot.key_len_ = name.size ();
+      slot.is_dir_ = is_dir ? 1 : 0;
+      entries_.push_back (slot);
+      ++(dirs_.back ().nentries_);
+    }
+
+    void add_probe (const std::string &path, const long long size,
+                    const long long mtime_sec, const long long mtime_nsec,
+                    const std::string &data)
+    {
+      probe_slot slot;
+      slot.key_off_ = add_str (path);
+      slot.key_len_ = path.size ();
+      slot.data_off_ = add_str (data);
+      slot.data_len_ = data.size ();
+      slot.size_ = size;
+      slot.mtime_sec_ = mtime_sec;
+      slot.mtime_nsec_ = mtime_nsec;
+      probes_.push_back (slot);
+    }
+
+    size_t ndirs () const
+    {
+      return dirs_.size ();
+    }
+
+    size_t nprobes () const
+    {
+      return probes_.size ();
+    }
+
+    // Whether the directory @a dir has been added, and if so, whether it has
+    // an entry called @a name of the given type
+    bool find_entry (const std::string &dir, const std::string &name,
+                     const bool is_dir, bool &dir_found) const
+    {
+      const long dir_idx = find_slot< dir_slot > (
+          reinterpret_cast< const char * > (dirs_.data ()), dirs_.size (),
+          heap_.data (), dir);
+      dir_found = (dir_idx >= 0);
+      if (!dir_found)
+      {
+        return false;
+      }
+      const dir_slot &slot = dirs_[dir_idx];
+      const long entry_idx = find_slot< entry_slot > (
+          reinterpret_cast< const char * > (&entries_[slot.first_entry_]),
+          slot.nentries_, heap_.data (), name);
+      return entry_idx >= 0
+             && (entries_[slot.first_entry_ + entry_idx].is_dir_ != 0)
+                    == is_dir;
+    }
+
+    bool write (const std::string &path) const
+    {
+      file_header header;
+      memset (&header, 0, sizeof (header));
+      memcpy (header.magic_, MEDIALIB_MAGIC, MEDIALIB_MAGIC_LEN);
+      header.version_ = MEDIALIB_VERSION;
+      header.ndirs_ = dirs_.size ();
+      header.nentries_ = entries_.size ();
+      header.nprobes_ = probes_.size ();
+      header.dirs_off_ = sizeof (header);
+      header.entries_off_ = header.dirs_off_ + dirs_.size () * sizeof (dir_slot);
+      header.probes_off_
+          = header.entries_off_ + entries_.size () * sizeof (entry_slot);
+      header.heap_off_
+          = header.probes_off_ + probes_.size () * sizeof (probe_slot);
+      header.heap_len_ = heap_.size ();
+
+      std::ofstream out (path.c_str (),
+                         std::ios::out | std::ios::binary | std::ios::trunc);
+      out.write (reinterpret_cast< const char * > (&header), sizeof (header));
+      write_table (out, dirs_);
+      write_table (out, entries_);
+      write_table (out, probes_);
+      out.write (heap_.data (), heap_.size ());
+      out.close ();
+      return !!out;
+    }
+
+  private:
+    uint64_t add_str (const std::string &str)
+    {
+      const uint64_t off = heap_.size ();
+      heap_.append (str);
+      return off;
+    }
+
+    template < typename T >
+    static void write_table (std::ofstream &out, const std::vector< T > &table)
+    {
+      if (!table.empty ())
+      {
+        out.write (reinterpret_cast< const char * > (table.data ()),
+                   table.size () * sizeof (T));
+      }
+    }
+
+  private:
+    std::string heap_;
+    std::vector< dir_slot > dirs_;
+    std::vector< entry_slot > entries_;
+    std::vector< probe_slot > probes_;
+  };
+
+  // Probe results are serialized as a sequence of length-prefixed fields.
+  // The length of a fixed-size field must match its type's size when read
+  // back, so that a record written by a build with different OpenMAX IL
+  // structures is discarded rather than misread.
+  template < typename T >
+  void put (std::string &buf, const T &value)
+  {
+    const uint32_t len = sizeof (T);
+    buf.append (reinterpret_cast< const char * > (&len), sizeof (len));
+    buf.append (reinterpret_cast< const char * > (&value), sizeof (T));
+  }
+
+  void put (std::string &buf, const std::string &str)
+  {
+    const uint32_t len = str.size ();
+    buf.append (reinterpret_cast< const char * > (&len), sizeof (len));
+    buf.append (str);
+  }
+
+  // A bounds-checked reader of serialized probe results
+  class reader
+  {
+  public:
+    reader (const std::string &data) : data_ (data), pos_ (0)
+    {
+    }
+
+    template < typename T >
+    bool get (T &value)
+    {
+      uint32_t len = 0;
+      if (!get_len (len) || sizeof (T) != len)
+      {
+        return false;
+      }
+      memcpy (&value, data_.data () + pos_, sizeof (T));
+      pos_ += sizeof (T);
+      return true;
+    }
+
+    bool get (std::string &str)
+    {
+      uint32_t len = 0;
+      if (!get_len (len))
+      {
+        return false;
+      }
+      str.assign (data_, pos_, len);
+      pos_ += len;
+      return true;
+    }
+
+    bool at_end () const
+    {
+      return pos_ == data_.size ();
+    }
+
+  private:
+    bool get_len (uint32_t &len)
+    {
+      if (data_.size () - pos_ < sizeof (len))
+      {
+        return false;
+      }
+      memcpy (&len, data_.data () + pos_, sizeof (len));
+      pos_ += sizeof (len);
+      return len <= data_.size () - pos_;
+    }
+
+  private:
+    const std::string &data_;
+    size_t pos_;
+  };
+
+  std::string serialize_info (const tiz::probe::info &info)
+  {
+    const tiz::probe::tags &tags = info.tags_;
+    std::string buf;
+    put (buf, info.domain_);
+    put (buf, info.audio_coding_type_);
+    put (buf, info.video_coding_type_);
+    put (buf, info.container_type_);
+    put (buf, info.pcmtype_);
+    put (buf, info.mp2type_);
+    put (buf, info.mp3type_);
+    put (buf, info.opustype_);
+    put (buf, info.flactype_);
+    put (buf, info.vorbistype_);
+    put (buf, info.aactype_);
+    put (buf, info.vp8type_);
+    put (buf, info.stream_title_);
+    put (buf, info.stream_genre_);
+    put (buf, info.stream_is_cbr_);
+    put (buf, tags.title_);
+    put (buf, tags.artist_);
+    put (buf, tags.album_);
+    put (buf, tags.comment_);
+    put (buf, tags.genre_);
+    put (buf, tags.year_);
+    put (buf, tags.track_);
+    put (buf, tags.length_secs_);
+    put (buf, tags.has_track_gain_);
+    put (buf, tags.track_gain_db_);
+    put (buf, tags.track_peak_);
+    put (buf, tags.has_album_gain_);
+    put (buf, tags.album_gain_db_);
+    put (buf, tags.album_peak_);
+    return buf;
+  }
+
+  bool deserialize_info (const std::string &data, tiz::probe::info &info)
+  {
+    tiz::probe::tags &tags = info.tags_;
+    reader rd (data);
+    return rd.get (info.domain_) && rd.get (info.audio_coding_type_)
+           && rd.get (info.video_coding_type_) && rd.get (info.container_type_)
+           && rd.get (info.pcmtype_) && rd.get (info.mp2type_)
+           && rd.get (info.mp3type_) && rd.get (info.opustype_)
+           && rd.get (info.flactype_) && rd.get (info.vorbistype_)
+           && rd.get (info.aactype_) && rd.get (info.vp8type_)
+           && rd.get (info.stream_title_) && rd.get (info.stream_genre_)
+           && rd.get (info.stream_is_cbr_) && rd.get (tags.title_)
+           && rd.get (tags.artist_) && rd.get (tags.album_)
+           && rd.get (tags.comment_) && rd.get (tags.genre_)
+           && rd.get (tags.year_) && rd.get (tags.track_)
+           && rd.get (tags.length_secs_) && rd.get (tags.has_track_gain_)
+           && rd.get (tags.track_gain_db_) && rd.get (tags.track_peak_)
+           && rd.get (tags.has_album_gain_) && rd.get (tags.album_gain_db_)
+           && rd.get (tags.album_peak_) && rd.at_end ();
+  }
+
+  // Splits @a path into its parent directory and its last component
+  bool split_path (const std::string &path, std::string &parent,
+                   std::string &name)
+  {
+    const std::string::size_type pos = path.rfind ('/');
+    if (std::string::npos == pos || pos + 1 == path.size ())
+    {
+      return false;
+    }
+    parent.assign (path, 0, pos > 0 ? pos : 1);
+    name.assign (path, pos + 1, std::string::npos);
+    return true;
+  }
+
+  bool is_dir (const std::string &path)
+  {
+    struct stat st;
+    return (0 == stat (path.c_str (), &st) && S_ISDIR (st.st_mode));
+  }
+
+  bool stat_file (const std::string &path, struct stat &st)
+  {
+    return (0 == stat (path.c_str (), &st) && S_ISREG (st.st_mode));
+  }
+
+  bool is_dir_entry (const std::string &dir, const struct dirent *p_dirent)
+  {
+#ifdef _DIRENT_HAVE_D_TYPE
+    if (DT_UNKNOWN != p_dirent->d_type)
+    {
+      // Symbolic links are not followed, as with recursive_directory_iterator
+      return DT_DIR == p_dirent->d_type;
+    }
+#endif
+    struct stat st;
+    const std::string path (dir + "/" + p_dirent->d_name);
+    return (0 == lstat (path.c_str (), &st) && S_ISDIR (st.st_mode));
+  }
+}  // unnamed namespace
+
+//
+// medialib
+//
+tiz::medialib::medialib (const std::string &index_path)
+  : index_path_ (index_path),
+    p_map_ (NULL),
+    map_len_ (0),
+    changed_dirs_ (),
+    removed_dirs_ (),
+    seen_dirs_ (),
+    changed_probes_ (),
+    dirty_ (false),
+    inited_ (false),
+    mutex_ ()
+{
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "Constructing [%s]...", index_path_.c_str ());
+  inited_ = (OMX_ErrorNone == tiz_mutex_init (&mutex_));
+}
+
+tiz::medialib::~medialib ()
+{
+  unmap_index ();
+  if (inited_)
+  {
+    (void)tiz_mutex_destroy (&mutex_);
+  }
+}
+
+void tiz::medialib::load ()
+{
+  lock ();
+  unmap_index ();
+  changed_dirs_.clear ();
+  removed_dirs_.clear ();
+  changed_probes_.clear ();
+  dirty_ = false;
+  map_index ();
+  unlock ();
+}
+
+OMX_ERRORTYPE
+tiz::medialib::save ()
+{
+  if (index_path_.empty ())
+  {
+    return OMX_ErrorNone;
+  }
+
+  lock ();
+
+  const index_view view (p_map_, map_len_);
+  index_writer writer;
+  std::set< std::string > dropped_dirs;
+  size_t dropped_probes = 0;
+  std::string parent;
+  std::string name;
+
+  // Merge the mapped directory records with the ones changed in this run.
+  // Parents sort before their sub-directories, so by the time a directory is
+  // visited, its parent's record has already been kept or dropped.
+  dir_map_t::const_iterator changed = changed_dirs_.begin ();
+  size_t mapped = 0;
+  while (mapped < view.ndirs () || changed != changed_dirs_.end ())
+  {
+    std::string path;
+    dir_record record;
+    const dir_slot slot = (mapped < view.ndirs () ? view.dir_at (mapped)
+                                                  : dir_slot ());
+    const std::string mapped_path (mapped < view.ndirs () ? view.key (slot)
+                                                          : std::string ());
+    if (changed != changed_dirs_.end ()
+        && (mapped == view.ndirs () || changed->first <= mapped_path))
+    {
+      if (mapped < view.ndirs () && changed->first == mapped_path)
+      {
+        ++mapped;
+      }
+      path = changed->first;
+      record = changed->second;
+      ++changed;
+    }
+    else
+    {
+      ++mapped;
+      if (removed_dirs_.count (mapped_path))
+      {
+        dropped_dirs.insert (mapped_path);
+        continue;
+      }
+      path = mapped_path;
+      record.mtime_sec_ = slot.mtime_sec_;
+      record.mtime_nsec_ = slot.mtime_nsec_;
+      for (uint32_t i = 0; i < slot.nentries_; ++i)
+      {
+        const entry_slot e = view.entry_at (slot.first_entry_ + i);
+        record.entries_.push_back (entry (view.key (e), e.is_dir_ != 0));
+      }
+    }
+
+    // A sub-directory is kept if its parent is kept and still lists it; a
+    // top-level directory, if it still exists
+    bool parent_found = false;
+    const bool has_parent = split_path (path, parent, name);
+    const bool listed
+        = has_parent && writer.find_entry (parent, name, true, parent_found);
+    bool keep = listed;
+    if (!parent_found)
+    {
+      keep = (!has_parent || !dropped_dirs.count (parent))
+             && (seen_dirs_.count (path) || is_dir (path));
+    }
+
+    if (!keep)
+    {
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] : pruned", path.c_str ());
+      dropped_dirs.insert (path);
+      continue;
+    }
+
+    writer.add_dir (path, record.mtime_sec_, record.mtime_nsec_);
+    for (std::vector< entry >::const_iterator e = record.entries_.begin ();
+         e != record.entries_.end (); ++e)
+    {
+      writer.add_entry (e->name_, e->is_dir_);
+    }
+  }
+
+  // Same for the probe records; a file's record is kept if its directory is
+  // kept and still lists it, or, if its directory is not indexed, if the
+  // file still exists
+  probe_map_t::const_iterator changed_probe = changed_probes_.begin ();
+  mapped = 0;
+  while (mapped < view.nprobes () || changed_probe != changed_probes_.end ())
+  {
+    std::string path;
+    probe_record record;
+    const probe_slot slot = (mapped < view.nprobes () ? view.probe_at (mapped)
+                                                      : probe_slot ());
+    const std::string mapped_path (mapped < view.nprobes () ? view.key (slot)
+                                                            : std::string ());
+    if (changed_probe != changed_probes_.end ()
+        && (mapped == view.nprobes () || changed_probe->first <= mapped_path))
+    {
+      if (mapped < view.nprobes () && changed_probe->first == mapped_path)
+      {
+        ++mapped;
+      }
+      path = changed_probe->first;
+      record = changed_probe->second;
+      ++changed_probe;
+    }
+    else
+    {
+      ++mapped;
+      path = mapped_path;
+      record.size_ = slot.size_;
+      record.mtime_sec_ = slot.mtime_sec_;
+      record.mtime_nsec_ = slot.mtime_nsec_;
+      record.data_ = view.data (slot);
+    }
+
+    bool keep = false;
+    bool dir_found = false;
+    if (split_path (path, parent, name))
+    {
+      keep = writer.find_entry (parent, name, false, dir_found);
+      if (!dir_found && !dropped_dirs.count (parent))
+      {
+        struct stat st;
+        keep = stat_file (path, st);
+      }
+    }
+
+    if (!keep)
+    {
+      ++dropped_probes;
+      continue;
+    }
+
+    writer.add_probe (path, record.size_, record.mtime_sec_,
+                      record.mtime_nsec_, record.data_);
+  }
+
+  if (!dirty_ && dropped_dirs.empty () && 0 == dropped_probes)
+  {
+    unlock ();
+    return OMX_ErrorNone;
+  }
+
+  boost::system::error_code ec;
+  boost::filesystem::create_directories (
+      boost::filesystem::path (index_path_).parent_path (), ec);
+
+  // Write a new file and rename it, so that a reader never sees a partially
+  // written index. The old file stays mapped until then.
+  const std::string tmp_path (index_path_ + ".tmp");
+  if (!writer.write (tmp_path)
+      || 0 != rename (tmp_path.c_str (), index_path_.c_str ()))
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR, "Unable to write [%s]",
+             index_path_.c_str ());
+    (void)unlink (tmp_path.c_str ());
+    unlock ();
+    return OMX_ErrorInsufficientResources;
+  }
+
+  TIZ_LOG (TIZ_PRIORITY_NOTICE,
+           "[%s] : %u directories, %u files indexed (%u directories, %u files "
+           "pruned)",
+           index_path_.c_str (), (unsigned)writer.ndirs (),
+           (unsigned)writer.nprobes (), (unsigned)dropped_dirs.size (),
+           (unsigned)dropped_probes);
+
+  unmap_index ();
+  changed_dirs_.clear ();
+  removed_dirs_.clear ();
+  changed_probes_.clear ();
+  dirty_ = false;
+  map_index ();
+  unlock ();
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+tiz::medialib::list_dir (const std::string &dir, const bool recurse,
+                         uri_lst_t &uri_list)
+{
+  scan_ctx ctx (this, dir, recurse);
+  std::vector< tiz_thread_t > threads (MEDIALIB_SCAN_THREADS);
+  size_t nthreads = 0;
+
+  tiz_check_omx_ret_oom (tiz_mutex_init (&ctx.mutex_));
+  if (OMX_ErrorNone != tiz_cond_init (&ctx.cond_))
+  {
+    (void)tiz_mutex_destroy (&ctx.mutex_);
+    return OMX_ErrorInsufficientResources;
+  }
+
+  // Directories are listed concurrently so that the latency of each stat and
+  // readdir on a network filesystem overlaps with the others
+  for (; nthreads < threads.size (); ++nthreads)
+  {
+    if (OMX_ErrorNone != tiz_thread_create (&threads[nthreads], 0, 0,
+                                            scan_thread_func, &ctx))
+    {
+      break;
+    }
+  }
+
+  if (0 == nthreads)
+  {
+    // Scan in the calling thread instead
+    (void)scan_thread_func (&ctx);
+  }
+
+  for (size_t i = 0; i < nthreads; ++i)
+  {
+    (void)tiz_thread_join (&threads[i], NULL);
+  }
+
+  (void)tiz_cond_destroy (&ctx.cond_);
+  (void)tiz_mutex_destroy (&ctx.mutex_);
+
+  if (!ctx.root_ok_)
+  {
+    return OMX_ErrorContentURIError;
+  }
+
+  uri_list.insert (uri_list.end (), ctx.files_.begin (), ctx.files_.end ());
+  return OMX_ErrorNone;
+}
+
+std::string tiz::medialib::default_index_path ()
+{
+  std::string cache_dir;
+  const char *p_xdg_cache = getenv ("XDG_CACHE_HOME");
+  const char *p_home = getenv ("HOME");
+  if (p_xdg_cache && *p_xdg_cache)
+  {
+    cache_dir.assign (p_xdg_cache);
+  }
+  else if (p_home)
+  {
+    cache_dir.assign (p_home).append ("/.cache");
+  }
+  else
+  {
+    cache_dir.assign ("/tmp");
+  }
+  return cache_dir.append ("/tizonia/medialib.idx");
+}
+
+void *tiz::medialib::scan_thread_func (void *p_arg)
+{
+  scan_ctx *p_ctx = static_cast< scan_ctx * > (p_arg);
+  assert (p_ctx);
+
+  tiz_mutex_lock (&p_ctx->mutex_);
+  while (true)
+  {
+    while (p_ctx->pending_.empty () && p_ctx->busy_ > 0)
+    {
+      tiz_cond_wait (&p_ctx->cond_, &p_ctx->mutex_);
+    }
+
+    if (p_ctx->pending_.empty ())
+    {
+      // Nothing left to scan, and nobody scanning: we are done
+      tiz_cond_broadcast (&p_ctx->cond_);
+      break;
+    }
+
+    const std::string dir (p_ctx->pending_.front ());
+    p_ctx->pending_.pop_front ();
+    ++(p_ctx->busy_);
+
+    std::vector< entry > entries;
+    const bool found = p_ctx->p_lib_->lookup (*p_ctx, dir, entries);
+
+    --(p_ctx->busy_);
+    if (dir == p_ctx->root_)
+    {
+      p_ctx->root_ok_ = found;
+    }
+
+    for (std::vector< entry >::const_iterator it = entries.begin ();
+         it != entries.end (); ++it)
+    {
+      const std::string path (dir + "/" + it->name_);
+      if (!it->is_dir_)
+      {
+        p_ctx->files_.push_back (path);
+      }
+      else if (p_ctx->recurse_)
+      {
+        p_ctx->pending_.push_back (path);
+      }
+    }
+    tiz_cond_broadcast (&p_ctx->cond_);
+  }
+  tiz_mutex_unlock (&p_ctx->mutex_);
+
+  return NULL;
+}
+
+bool tiz::medialib::lookup_probe (const std::string &uri, probe::info &info)
+{
+  struct stat st;
+  if (index_path_.empty () || !stat_file (uri, st))
+  {
+    return false;
+  }
+
+  probe_record record;
+  lock ();
+  const bool found = find_probe (uri, record);
+  unlock ();
+
+  return found && record.size_ == st.st_size
+         && record.mtime_sec_ == st.st_mtim.tv_sec
+         && record.mtime_nsec_ == st.st_mtim.tv_nsec
+         && deserialize_info (record.data_, info);
+}
+
+void tiz::medialib::store_probe (const std::string &uri,
+                                 const probe::info &info)
+{
+  struct stat st;
+  if (index_path_.empty () || !stat_file (uri, st))
+  {
+    return;
+  }
+
+  probe_record record;
+  record.size_ = st.st_size;
+  record.mtime_sec_ = st.st_mtim.tv_sec;
+  record.mtime_nsec_ = st.st_mtim.tv_nsec;
+  record.data_ = serialize_info (info);
+
+  lock ();
+  changed_probes_[uri] = record;
+  dirty_ = true;
+  unlock ();
+}
+
+bool tiz::medialib::lookup (scan_ctx &ctx, const std::string &dir,
+                            std::vector< entry > &entries)
+{
+  // Called with the scan mutex held; it is released around the filesystem
+  // accesses
+  struct stat st;
+  tiz_mutex_unlock (&ctx.mutex_);
+  const bool found = (0 == stat (dir.c_str (), &st) && S_ISDIR (st.st_mode));
+  tiz_mutex_lock (&ctx.mutex_);
+
+  const long long mtime_sec = found ? st.st_mtim.tv_sec : 0;
+  const long long mtime_nsec = found ? st.st_mtim.tv_nsec : 0;
+  dir_record record;
+
+  lock ();
+  const bool indexed = find_dir (dir, record);
+  if (!found)
+  {
+    if (indexed)
+    {
+      changed_dirs_.erase (dir);
+      removed_dirs_.insert (dir);
+      dirty_ = true;
+    }
+    unlock ();
+    return false;
+  }
+  seen_dirs_.insert (dir);
+  unlock ();
+
+  if (indexed && record.mtime_sec_ == mtime_sec
+      && record.mtime_nsec_ == mtime_nsec)
+  {
+    entries.swap (record.entries_);
+    return true;
+  }
+
+  record = dir_record ();
+  tiz_mutex_unlock (&ctx.mutex_);
+  const bool refreshed = refresh (dir, mtime_sec, mtime_nsec, record);
+  tiz_mutex_lock (&ctx.mutex_);
+
+  if (!refreshed)
+  {
+    return false;
+  }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] : %u entries (re)indexed", dir.c_str (),
+           (unsigned)record.entries_.size ());
+  entries = record.entries_;
+  lock ();
+  changed_dirs_[dir] = record;
+  removed_dirs_.erase (dir);
+  dirty_ = true;
+  unlock ();
+  return true;
+}
+
+bool tiz::medialib::refresh (const std::string &dir, const long long mtime_sec,
+                             const long long mtime_nsec, dir_record &record)
+{
+  DIR *p_dir = opendir (dir.c_str ());
+  if (!p_dir)
+  {
+    return false;
+  }
+
+  struct dirent *p_dirent = NULL;
+  while ((p_dirent = readdir (p_dir)))
+  {
+    if (0 == strcmp (p_dirent->d_name, ".")
+        || 0 == strcmp (p_dirent->d_name, ".."))
+    {
+      continue;
+    }
+    record.entries_.push_back (
+        entry (p_dirent->d_name, is_dir_entry (dir, p_dirent)));
+  }
+  closedir (p_dir);
+
+  // Sorted, so that the index can be searched by name
+  std::sort (record.entries_.begin (), record.entries_.end ());
+  record.mtime_sec_ = mtime_sec;
+  record.mtime_nsec_ = mtime_nsec;
+  return true;
+}
+
+void tiz::medialib::lock ()
+{
+  if (inited_)
+  {
+    tiz_mutex_lock (&mutex_);
+  }
+}
+
+void tiz::medialib::unlock ()
+{
+  if (inited_)
+  {
+    tiz_mutex_unlock (&mutex_);
+  }
+}
+
+void tiz::medialib::map_index ()
+{
+  struct stat st;
+  void *p_map = MAP_FAILED;
+  int fd = -1;
+
+  assert (!p_map_);
+
+  if (index_path_.empty ())
+  {
+    return;
+  }
+
+  if ((fd = open (index_path_.c_str (), O_RDONLY)) < 0)
+  {
+    TIZ_LOG (TIZ_PRIORITY_NOTICE, "No media library index at [%s]",
+             index_path_.c_str ());
+    return;
+  }
+
+  if (0 == fstat (fd, &st) && st.st_size > 0)
+  {
+    p_map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  // The mapping stays valid after the descriptor is closed
+  close (fd);
+
+  if (MAP_FAILED == p_map)
+  {
+    return;
+  }
+
+  const index_view view (static_cast< const char * > (p_map), st.st_size);
+  if (!view.validate ())
+  {
+    TIZ_LOG (TIZ_PRIORITY_ERROR, "Discarding invalid media library index [%s]",
+             index_path_.c_str ());
+    munmap (p_map, st.st_size);
+    dirty_ = true;
+    return;
+  }
+
+  p_map_ = static_cast< const char * > (p_map);
+  map_len_ = st.st_size;
+  TIZ_LOG (TIZ_PRIORITY_NOTICE, "[%s] : %u directories, %u files indexed",
+           index_path_.c_str (), (unsigned)view.ndirs (),
+           (unsigned)view.nprobes ());
+}
+
+void tiz::medialib::unmap_index ()
+{
+  if (p_map_)
+  {
+    munmap (const_cast< char * > (p_map_), map_len_);
+    p_map_ = NULL;
+    map_len_ = 0;
+  }
+}
+
+bool tiz::medialib::find_dir (const std::string &dir,
+                              dir_record &record) const
+{
+  if (removed_dirs_.count (dir))
+  {
+    return false;
+  }
+
+  dir_map_t::const_iterator it = changed_dirs_.find (dir);
+  if (it != changed_dirs_.end ())
+  {
+    record = it->second;
+    return true;
+  }
+
+  const index_view view (p_map_, map_len_);
+  const long index = view.find_dir (dir);
+  if (index < 0)
+  {
+    return false;
+  }
+
+  const dir_slot slot = view.dir_at (index);
+  record.mtime_sec_ = slot.mtime_sec_;
+  record.mtime_nsec_ = slot.mtime_nsec_;
+  record.entries_.clear ();
+  record.entries_.reserve (slot.nentries_);
+  for (uint32_t i = 0; i < slot.nentries_; ++i)
+  {
+    const entry_slot e = view.entry_at (slot.first_entry_ + i);
+    record.entries_.push_back (entry (view.key (e), e.is_dir_ != 0));
+  }
+  return true;
+}
+
+bool tiz::medialib::find_probe (const std::string &uri,
+                                probe_record &record) const
+{
+  probe_map_t::const_iterator it = changed_probes_.find (uri);
+  if (it != changed_probes_.end ())
+  {
+    record = it->second;
+    return true;
+  }
+
+  const index_view view (p_map_, map_len_);
+  const long index = view.find_probe (uri);
+  if (index < 0)
+  {
+    return false;
+  }
+
+  const probe_slot slot = view.probe_at (index);
+  record.size_ = slot.size_;
+  record.mtime_sec_ = slot.mtime_sec_;
+  record.mtime_nsec_ = slot.mtime_nsec_;
+  record.data_ = view.data (slot);
+  return true;
+}
@@ -0,0 +1,223 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizmedialib.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Persistent index of local media directories and files
+ *
+ *
+ */
+
+#ifndef TIZMEDIALIB_HPP
+#define TIZMEDIALIB_HPP
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <OMX_Core.h>
+#include <tizplatform.h>
+
+#include "tizgraphtypes.hpp"
+#include "tizprobe.hpp"
+
+namespace tiz
+{
+  /**
+   * An on-disk index of the contents of the local media directories, and of
+   * the results of probing the files in them.
+   *
+   * Each indexed directory is stored with its modification time and the list
+   * of its entries. A directory is only read again when its modification
+   * time has changed (i.e. when entries have been added, removed or renamed
+   * in it), so listing a large, mostly unchanged library costs one stat per
+   * directory instead of one readdir and one stat per file. Directories are
+   * listed by a pool of threads, to hide the latency of network filesystems.
+   *
+   * Probe results (see tiz::probe::info) are stored keyed by path, size and
+   * modification time, so that an unchanged file is not opened again to find
+   * out its codec parameters and tags.
+   *
+   * The index file is memory-mapped, and looked up in place: its records are
+   * kept sorted by path in fixed-size slots, and found by binary search.
+   * Records added or changed during a run are kept in memory until the next
+   * save, which writes a new file with both. Records of directories that no
+   * longer exist (and of the files in them) are dropped on save.
+   */
+  class medialib
+  {
+
+  public:
+    /**
+     * @param index_path The index file. If empty, the index is kept in memory
+     * only, and just the concurrent directory listing is used.
+     */
+    explicit medialib (const std::string &index_path);
+    ~medialib ();
+
+    /**
+     * Maps the index file. A missing or corrupt index file is not an error;
+     * the library simply starts empty.
+     */
+    void load ();
+
+    /**
+     * Writes the index back to disk, if it was modified since it was loaded
+     * or if any of its directories has been removed.
+     *
+     * @return OMX_ErrorNone on success, or OMX_ErrorInsufficientResources if
+     * the index file could not be written.
+     */
+    OMX_ERRORTYPE save ();
+
+    /**
+     * Appends to @a uri_list the files found in @a dir (and its
+     * sub-directories if @a recurse is true), refreshing the index where
+     * needed.
+     *
+     * @return OMX_ErrorNone on success, or OMX_ErrorContentURIError if @a
+     * dir could not be read.
+     */
+    OMX_ERRORTYPE list_dir (const std::string &dir, const bool recurse,
+                            uri_lst_t &uri_list);
+
+    /**
+     * Retrieves the stored probe results of @a uri.
+     *
+     * @return true if there is a record for @a uri, and the file's size and
+     * modification time have not changed since it was stored.
+     */
+    bool lookup_probe (const std::string &uri, probe::info &info);
+
+    /**
+     * Stores the probe results of @a uri, keyed by its current size and
+     * modification time.
+     */
+    void store_probe (const std::string &uri, const probe::info &info);
+
+    /**
+     * The default location of the index: $XDG_CACHE_HOME/tizonia or
+     * $HOME/.cache/tizonia.
+     */
+    static std::string default_index_path ();
+
+  private:
+    struct entry
+    {
+      entry () : name_ (), is_dir_ (false)
+      {
+      }
+      entry (const std::string &name, const bool is_dir)
+        : name_ (name), is_dir_ (is_dir)
+      {
+      }
+      bool operator<(const entry &other) const
+      {
+        return name_ < other.name_;
+      }
+      std::string name_;
+      bool is_dir_;
+    };
+
+    struct dir_record
+    {
+      dir_record () : mtime_sec_ (0), mtime_nsec_ (0), entries_ ()
+      {
+      }
+      long long mtime_sec_;
+      long long mtime_nsec_;
+      std::vector< entry > entries_;  // sorted by name
+    };
+
+    struct probe_record
+    {
+      probe_record () : size_ (0), mtime_sec_ (0), mtime_nsec_ (0), data_ ()
+      {
+      }
+      long long size_;
+      long long mtime_sec_;
+      long long mtime_nsec_;
+      std::string data_;  // the serialized probe::info
+    };
+
+    typedef std::map< std::string, dir_record > dir_map_t;
+    typedef std::map< std::string, probe_record > probe_map_t;
+
+    // State shared by the scanning threads of a list_dir operation
+    struct scan_ctx
+    {
+      scan_ctx (medialib *p_lib, const std::string &root, const bool recurse)
+        : p_lib_ (p_lib),
+          root_ (root),
+          recurse_ (recurse),
+          root_ok_ (false),
+          pending_ (1, root),
+          busy_ (0),
+          files_ (),
+          mutex_ (),
+          cond_ ()
+      {
+      }
+      medialib *p_lib_;
+      const std::string root_;
+      const bool recurse_;
+      bool root_ok_;
+      std::deque< std::string > pending_;
+      int busy_;
+      uri_lst_t files_;
+      tiz_mutex_t mutex_;
+      tiz_cond_t cond_;
+    };
+
+  private:
+    static void *scan_thread_func (void *p_arg);
+    bool lookup (scan_ctx &ctx, const std::string &dir,
+                 std::vector< entry > &entries);
+    bool refresh (const std::string &dir, const long long mtime_sec,
+                  const long long mtime_nsec, dir_record &record);
+    void lock ();
+    void unlock ();
+    void map_index ();
+    void unmap_index ();
+    bool find_dir (const std::string &dir, dir_record &record) const;
+    bool find_probe (const std::string &uri, probe_record &record) const;
+
+  private:
+    std::string index_path_;
+    const char *p_map_;
+    size_t map_len_;
+    dir_map_t changed_dirs_;
+    std::set< std::string > removed_dirs_;
+    std::set< std::string > seen_dirs_;
+    probe_map_t changed_probes_;
+    bool dirty_;
+    bool inited_;
+    tiz_mutex_t mutex_;
+  };
+
+  typedef boost::shared_ptr< medialib > medialib_ptr_t;
+}  // namespace tiz
+
+#endif  // TIZMEDIALIB_HPP
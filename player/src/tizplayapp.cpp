@@ -63,7 +63,10 @@
 #include "tizdaemon.hpp"
 #include "tizgraphmgr.hpp"
 #include "tizgraphtypes.hpp"
+#include "tizgraphutil.hpp"
+#include "tizmedialib.hpp"
 #include "tizomxutil.hpp"
+#include "tizprobecache.hpp"
 #include <decoders/tizdecgraphmgr.hpp>
 #include <httpclnt/tizhttpclntmgr.hpp>
 #include <httpserv/tizhttpservconfig.hpp>
@@ -247,6 +250,30 @@ namespace
     return outcome;
   }
 
+  tiz::medialib_ptr_t obtain_media_library ()
+  {
+    // Without a persistent index, the media library is still used for its
+    // concurrent directory listing
+    tiz::medialib_ptr_t medialib = boost::make_shared< tiz::medialib > (
+        tiz::graph::util::is_media_library_index_enabled ()
+            ? tiz::medialib::default_index_path ()
+            : std::string ());
+    medialib->load ();
+    // Probe results of local files are kept in the index as well
+    tiz::probecache::set_media_library (medialib);
+    return medialib;
+  }
+
+  void release_media_library (const tiz::medialib_ptr_t &medialib)
+  {
+    // Probes made during playback are saved too
+    tiz::probecache::set_media_library (tiz::medialib_ptr_t ());
+    if (medialib)
+    {
+      (void)medialib->save ();
+    }
+  }
+
   ETIZPlayUserInput player_wait_for_user_input (
       tiz::graphmgr::mgr_ptr_t mgr_ptr)
   {
@@ -268,23 +295,19 @@ namespace
             return ETIZPlayUserQuit;
 
           case 68:  // key left
-            // seek
-            // printf ("Seek (left key) - not implemented\n");
+            mgr_ptr->rwd ();
             break;
 
           case 67:  // key right
-            // seek
-            // printf ("Seek (right key) - not implemented\n");
+            mgr_ptr->fwd ();
             break;
 
           case 65:  // key up
-            // seek
-            // printf ("Seek (up key) - not implemented\n");
+            mgr_ptr->seek (60 * OMX_TICKS_PER_SECOND, true);
             break;
 
           case 66:  // key down
-            // seek
-            // printf ("Seek (down key) - not implemented\n");
+            mgr_ptr->seek (-60 * OMX_TICKS_PER_SECOND, true);
             break;
 
           case ' ':
@@ -729,15 +752,21 @@ tiz::playapp::decode_local ()
   extension_list.insert (".aif");
 
   // Create a playlist
+  tiz::medialib_ptr_t medialib = obtain_media_library ();
   BOOST_FOREACH (std::string uri, uri_list)
   {
-    if (!tizplaylist_t::assemble_play_list (
-            uri, shuffle, recurse, extension_list, file_list, error_msg))
+    if (!tizplaylist_t::assemble_play_list (uri, shuffle, recurse,
+                                            extension_list, file_list,
+                                            error_msg, medialib))
     {
       TIZ_PRINTF_RED ("%s (%s).\n", error_msg.c_str (), uri.c_str ());
       player_exit_failure ();
     }
   }
+  if (medialib)
+  {
+    (void)medialib->save ();
+  }
 
   (void)daemonize_if_requested ();
 
@@ -761,6 +790,7 @@ tiz::playapp::decode_local ()
 
   p_mgr->quit ();
   p_mgr->deinit ();
+  release_media_library (medialib);
 
   return rc;
 }
@@ -778,6 +808,8 @@ tiz::playapp::serve_stream ()
   const std::vector< int > &sampling_rate_list = popts_.sampling_rate_list ();
   const std::string &bitrates = popts_.bitrates ();
   const std::vector< std::string > &bitrate_list = popts_.bitrate_list ();
+  const std::vector< int > &transcode_bitrate_list
+      = popts_.transcode_bitrate_list ();
   const std::string &station_name = popts_.station_name ();
   const std::string &station_genre = popts_.station_genre ();
 
@@ -791,15 +823,21 @@ tiz::playapp::serve_stream ()
   extension_list.insert (".mp3");
 
   // Create a playlist
+  tiz::medialib_ptr_t medialib = obtain_media_library ();
   BOOST_FOREACH (std::string uri, uri_list)
   {
-    if (!tizplaylist_t::assemble_play_list (
-            uri, shuffle, recurse, extension_list, file_list, error_msg))
+    if (!tizplaylist_t::assemble_play_list (uri, shuffle, recurse,
+                                            extension_list, file_list,
+                                            error_msg, medialib))
     {
       TIZ_PRINTF_RED ("%s (%s).\n", error_msg.c_str (), uri.c_str ());
       player_exit_failure ();
     }
   }
+  if (medialib)
+  {
+    (void)medialib->save ();
+  }
 
   (void)daemonize_if_requested ();
 
@@ -822,6 +860,17 @@ tiz::playapp::serve_stream ()
     fprintf (stdout, "[%s]: Streaming media with bitrate modes [%s].\n",
              station_name.c_str (), bitrates.c_str ());
   }
+
+  if (!transcode_bitrate_list.empty ())
+  {
+    fprintf (stdout, "[%s]: Transcoding to MP3 at [",
+             station_name.c_str ());
+    for (size_t i = 0; i < transcode_bitrate_list.size (); ++i)
+    {
+      fprintf (stdout, "%s%d", i > 0 ? "," : "", transcode_bitrate_list[i]);
+    }
+    fprintf (stdout, "] kbps.\n");
+  }
   fprintf (stdout, "\n");
 
   tizplaylist_ptr_t playlist
@@ -838,7 +887,8 @@ tiz::playapp::serve_stream ()
   tizgraphconfig_ptr_t config
       = boost::make_shared< tiz::graph::httpservconfig > (
           playlist, hostname, ip_address, port, sampling_rate_list,
-          bitrate_list, station_name, station_genre, icy_metadata);
+          bitrate_list, station_name, station_genre, icy_metadata,
+          transcode_bitrate_list);
 
   // Instantiate the http streaming manager
   tiz::graphmgr::mgr_ptr_t p_mgr
@@ -854,6 +904,7 @@ tiz::playapp::serve_stream ()
 
   p_mgr->quit ();
   p_mgr->deinit ();
+  release_media_library (medialib);
 
   return rc;
 }
@@ -67,7 +67,7 @@ namespace  // unnamed namespace
 
   OMX_ERRORTYPE
   process_base_uri (const std::string &uri, uri_lst_t &uri_list,
-                    bool recurse = false)
+                    bool recurse, const tiz::medialib_ptr_t &medialib)
   {
     if (boost::filesystem::exists (uri)
         && boost::filesystem::is_regular_file (uri))
@@ -79,7 +79,17 @@ namespace  // unnamed namespace
     if (boost::filesystem::exists (uri)
         && boost::filesystem::is_directory (uri))
     {
-      if (!recurse)
+      if (medialib)
+      {
+        const size_t prev_size = uri_list.size ();
+        if (OMX_ErrorNone != medialib->list_dir (uri, recurse, uri_list)
+            || uri_list.size () == prev_size)
+        {
+          return OMX_ErrorContentURIError;
+        }
+        return OMX_ErrorNone;
+      }
+      else if (!recurse)
       {
         std::for_each (boost::filesystem::directory_iterator (
                            boost::filesystem::path (uri)),
@@ -185,7 +195,8 @@ tiz::playlist::playlist (const playlist &copy_from)
 bool tiz::playlist::assemble_play_list (
     const std::string &base_uri, const bool shuffle_playlist,
     const bool recurse, const file_extension_lst_t &extension_list,
-    uri_lst_t &uri_list, std::string &error_msg)
+    uri_lst_t &uri_list, std::string &error_msg,
+    const medialib_ptr_t &medialib /* = medialib_ptr_t () */)
 {
   bool list_assembled = false;
   file_extension_lst_t extension_list_filtered;
@@ -207,7 +218,8 @@ bool tiz::playlist::assemble_play_list (
       goto end;
     }
 
-    if (OMX_ErrorNone != process_base_uri (canonical_base_uri, uri_list, recurse))
+    if (OMX_ErrorNone != process_base_uri (canonical_base_uri, uri_list, recurse,
+                                           medialib))
     {
       error_msg.assign ("File not found.");
       goto end;
@@ -30,6 +30,7 @@
 #define TIZPLAYLIST_HPP
 
 #include "tizgraphtypes.hpp"
+#include "tizmedialib.hpp"
 
 namespace tiz
 {
@@ -52,7 +53,8 @@ namespace tiz
                                     const bool shuffle_playlist,
                                     const bool recurse,
                                     const file_extension_lst_t &extension_list,
-                                    uri_lst_t &file_list, std::string &error_msg);
+                                    uri_lst_t &file_list, std::string &error_msg,
+                                    const medialib_ptr_t &medialib = medialib_ptr_t ());
 
     void skip (const int jump);
     playlist obtain_next_sub_playlist (const list_direction_t up_or_down);
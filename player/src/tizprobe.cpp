@@ -30,8 +30,14 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+
 #include <string>
 
+#include <fileref.h>
+#include <tag.h>
+#include <tpropertymap.h>
+
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/filesystem.hpp>
@@ -44,6 +50,7 @@
 #include <tizplatform.h>
 
 #include "tizprobe.hpp"
+#include "tizsniffer.hpp"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
 #undef TIZ_LOG_CATEGORY_NAME
@@ -235,6 +242,119 @@ namespace  // unnamed
     }
     return container_format;
   }
+
+  std::string tag_str (const TagLib::String &str)
+  {
+    return str.stripWhiteSpace ().to8Bit ();
+  }
+
+  bool read_replay_gain (const TagLib::PropertyMap &props,
+                         const std::string &prefix, double &gain_db,
+                         double &peak)
+  {
+    TagLib::PropertyMap::ConstIterator gain_it
+        = props.find (TagLib::String (prefix + "GAIN"));
+    if (gain_it == props.end () || gain_it->second.isEmpty ())
+    {
+      return false;
+    }
+
+    // e.g. "-6.54 dB"
+    const std::string gain_str (gain_it->second.front ().to8Bit ());
+    char *p_end = NULL;
+    gain_db = strtod (gain_str.c_str (), &p_end);
+    if (p_end == gain_str.c_str ())
+    {
+      return false;
+    }
+
+    peak = 0;
+    TagLib::PropertyMap::ConstIterator peak_it
+        = props.find (TagLib::String (prefix + "PEAK"));
+    if (peak_it != props.end () && !peak_it->second.isEmpty ())
+    {
+      peak = strtod (peak_it->second.front ().to8Bit ().c_str (), NULL);
+    }
+    return true;
+  }
+
+  // The FileRef is only used here, so a probe doesn't keep the file open
+  void read_tags (const std::string &uri, tiz::probe::tags &tags)
+  {
+    TagLib::FileRef file_ref (uri.c_str ());
+    if (file_ref.isNull ())
+    {
+      return;
+    }
+
+    if (file_ref.tag ())
+    {
+      TagLib::Tag *p_tag = file_ref.tag ();
+      tags.title_ = tag_str (p_tag->title ());
+      tags.artist_ = tag_str (p_tag->artist ());
+      tags.album_ = tag_str (p_tag->album ());
+      tags.comment_ = tag_str (p_tag->comment ());
+      tags.genre_ = tag_str (p_tag->genre ());
+      tags.year_ = p_tag->year ();
+      tags.track_ = p_tag->track ();
+    }
+
+    if (file_ref.audioProperties ())
+    {
+      tags.length_secs_ = file_ref.audioProperties ()->length ();
+    }
+
+    if (file_ref.file ())
+    {
+      // TagLib maps Vorbis comments, APE items, ID3v2 TXXX frames and MP4
+      // atoms to the same property names
+      const TagLib::PropertyMap props = file_ref.file ()->properties ();
+      tags.has_track_gain_
+          = read_replay_gain (props, "REPLAYGAIN_TRACK_", tags.track_gain_db_,
+                              tags.track_peak_);
+      tags.has_album_gain_
+          = read_replay_gain (props, "REPLAYGAIN_ALBUM_", tags.album_gain_db_,
+                              tags.album_peak_);
+    }
+  }
+}
+
+tiz::probe::tags::tags ()
+  : title_ (),
+    artist_ (),
+    album_ (),
+    comment_ (),
+    genre_ (),
+    year_ (0),
+    track_ (0),
+    length_secs_ (-1),
+    has_track_gain_ (false),
+    track_gain_db_ (0),
+    track_peak_ (0),
+    has_album_gain_ (false),
+    album_gain_db_ (0),
+    album_peak_ (0)
+{
+}
+
+tiz::probe::info::info ()
+  : domain_ (OMX_PortDomainMax),
+    audio_coding_type_ (OMX_AUDIO_CodingUnused),
+    video_coding_type_ (OMX_VIDEO_CodingUnused),
+    container_type_ (OMX_FORMATMax),
+    pcmtype_ (),
+    mp2type_ (),
+    mp3type_ (),
+    opustype_ (),
+    flactype_ (),
+    vorbistype_ (),
+    aactype_ (),
+    vp8type_ (),
+    stream_title_ (),
+    stream_genre_ (),
+    stream_is_cbr_ (false),
+    tags_ ()
+{
 }
 
 tiz::probe::probe (const std::string &uri, const bool quiet)
@@ -252,10 +372,11 @@ tiz::probe::probe (const std::string &uri, const bool quiet)
     vorbistype_ (),
     aactype_ (),
     vp8type_ (),
-    meta_file_ (uri.c_str ()),
+    tags_ (),
     stream_title_ (),
     stream_genre_ (),
-    stream_is_cbr_ (false)
+    stream_is_cbr_ (false),
+    probed_ (false)
 {
   // Defaults are the same as in the standard pcm renderer
   pcmtype_.nSize = sizeof(OMX_AUDIO_PARAM_PCMMODETYPE);
@@ -357,6 +478,59 @@ tiz::probe::probe (const std::string &uri, const bool quiet)
   vp8type_.eLevel = OMX_VIDEO_VP8Level_Version0;
   vp8type_.nDCTPartitions = 0; /* 1 DCP partitiion */
   vp8type_.bErrorResilientMode = OMX_FALSE;
+
+  read_tags (uri_, tags_);
+}
+
+tiz::probe::probe (const std::string &uri, const info &probed,
+                   const bool quiet)
+  : uri_ (uri),
+    quiet_ (quiet),
+    domain_ (probed.domain_),
+    audio_coding_type_ (probed.audio_coding_type_),
+    video_coding_type_ (probed.video_coding_type_),
+    container_type_ (probed.container_type_),
+    pcmtype_ (probed.pcmtype_),
+    mp2type_ (probed.mp2type_),
+    mp3type_ (probed.mp3type_),
+    opustype_ (probed.opustype_),
+    flactype_ (probed.flactype_),
+    vorbistype_ (probed.vorbistype_),
+    aactype_ (probed.aactype_),
+    vp8type_ (probed.vp8type_),
+    tags_ (probed.tags_),
+    stream_title_ (probed.stream_title_),
+    stream_genre_ (probed.stream_genre_),
+    stream_is_cbr_ (probed.stream_is_cbr_),
+    probed_ (true)
+{
+}
+
+tiz::probe::info tiz::probe::get_info ()
+{
+  if (!probed_)
+  {
+    probe_stream ();
+  }
+
+  info probed;
+  probed.domain_ = domain_;
+  probed.audio_coding_type_ = audio_coding_type_;
+  probed.video_coding_type_ = video_coding_type_;
+  probed.container_type_ = container_type_;
+  probed.pcmtype_ = pcmtype_;
+  probed.mp2type_ = mp2type_;
+  probed.mp3type_ = mp3type_;
+  probed.opustype_ = opustype_;
+  probed.flactype_ = flactype_;
+  probed.vorbistype_ = vorbistype_;
+  probed.aactype_ = aactype_;
+  probed.vp8type_ = vp8type_;
+  probed.stream_title_ = stream_title_;
+  probed.stream_genre_ = stream_genre_;
+  probed.stream_is_cbr_ = stream_is_cbr_;
+  probed.tags_ = tags_;
+  return probed;
 }
 
 std::string tiz::probe::get_uri () const
@@ -367,7 +541,7 @@ std::string tiz::probe::get_uri () const
 OMX_PORTDOMAINTYPE
 tiz::probe::get_omx_domain ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -378,7 +552,7 @@ tiz::probe::get_omx_domain ()
 OMX_AUDIO_CODINGTYPE
 tiz::probe::get_audio_coding_type ()
 {
-  if (OMX_AUDIO_CodingUnused == audio_coding_type_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -388,7 +562,7 @@ tiz::probe::get_audio_coding_type ()
 OMX_VIDEO_CODINGTYPE
 tiz::probe::get_video_coding_type ()
 {
-  if (OMX_VIDEO_CodingUnused == video_coding_type_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -398,7 +572,7 @@ tiz::probe::get_video_coding_type ()
 OMX_MEDIACONTAINER_FORMATTYPE
 tiz::probe::get_container_type ()
 {
-  if (OMX_FORMATMax == container_type_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -407,6 +581,26 @@ tiz::probe::get_container_type ()
 
 void tiz::probe::probe_stream ()
 {
+  probed_ = true;
+
+  // Try the native header parsers first; MediaInfo is only needed for the
+  // files that these don't recognise.
+  tiz::sniffer::stream_info info;
+  if (tiz::sniffer::sniff (uri_, info))
+  {
+    container_type_ = info.container_;
+    stream_is_cbr_ = info.is_cbr_;
+    obtain_tagged_title_and_genre ();
+
+    TIZ_PRINTF_DBG_RED ("uri [%s] codec_id [%0x] (sniffed)\n", uri_.c_str (),
+                        info.codec_);
+
+    set_codec_info (info.codec_, info.samplerate_, info.bitrate_,
+                    info.nchannels_, info.bitdepth_, info.endianness_,
+                    info.sign_);
+    return;
+  }
+
   MediaInfoLib::MediaInfo mi;
 
   if (open_media (uri_, mi))
@@ -434,47 +628,8 @@ void tiz::probe::probe_stream ()
     obtain_stream_properties (mi, samplerate, bitrate, nchannels, bitdepth,
                               endianness, sign, stream_is_cbr_);
 
-    if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingMP2)
-    {
-      set_mp2_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingMP3)
-    {
-      set_mp3_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingAAC)
-    {
-      set_aac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                          sign);
-    }
-    else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingFLAC)
-    {
-      set_flac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                           sign);
-    }
-    else if (codec_id == OMX_AUDIO_CodingVORBIS)
-    {
-      set_vorbis_codec_info (samplerate, bitrate, nchannels, bitdepth,
-                             endianness, sign);
-    }
-    else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingOPUS)
-    {
-      set_opus_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
-                           sign);
-    }
-    else if (is_pcm_codec (codec_id))
-    {
-      domain_ = OMX_PortDomainAudio;
-      audio_coding_type_
-          = static_cast< OMX_AUDIO_CODINGTYPE >(OMX_AUDIO_CodingPCM);
-      pcmtype_.nSamplingRate = samplerate;
-      pcmtype_.nChannels = nchannels;
-      pcmtype_.nBitPerSample = bitdepth;
-      pcmtype_.eEndian = endianness;
-      pcmtype_.eNumData = sign;
-    }
+    set_codec_info (codec_id, samplerate, bitrate, nchannels, bitdepth,
+                    endianness, sign);
 
     mi.Close ();
   }
@@ -484,6 +639,86 @@ void tiz::probe::probe_stream ()
   }
 }
 
+void tiz::probe::obtain_tagged_title_and_genre ()
+{
+  // Same format as the one obtained from MediaInfo
+  const std::string &album = tags_.album_;
+  const std::string &title = tags_.title_;
+
+  stream_title_.assign (tags_.artist_);
+  if (!album.empty ())
+  {
+    stream_title_.append (" - ");
+    stream_title_.append (album);
+  }
+
+  if (!title.empty ())
+  {
+    stream_title_.append (" - ");
+    stream_title_.append (title);
+  }
+  stream_genre_.assign (tags_.genre_);
+
+  if (!quiet_)
+  {
+    if (stream_title_.empty ())
+    {
+      stream_title_.assign (uri_);
+    }
+    boost::replace_all (stream_title_, "_", " ");
+  }
+}
+
+void tiz::probe::set_codec_info (const OMX_AUDIO_CODINGTYPE codec_id,
+                                 const OMX_U32 samplerate,
+                                 const OMX_U32 bitrate, const OMX_U32 nchannels,
+                                 const OMX_U32 bitdepth,
+                                 const OMX_ENDIANTYPE endianness,
+                                 const OMX_NUMERICALDATATYPE sign)
+{
+  if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingMP2)
+  {
+    set_mp2_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingMP3)
+  {
+    set_mp3_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingAAC)
+  {
+    set_aac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                        sign);
+  }
+  else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingFLAC)
+  {
+    set_flac_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                         sign);
+  }
+  else if (codec_id == OMX_AUDIO_CodingVORBIS)
+  {
+    set_vorbis_codec_info (samplerate, bitrate, nchannels, bitdepth,
+                           endianness, sign);
+  }
+  else if (codec_id == (OMX_AUDIO_CODINGTYPE)OMX_AUDIO_CodingOPUS)
+  {
+    set_opus_codec_info (samplerate, bitrate, nchannels, bitdepth, endianness,
+                         sign);
+  }
+  else if (is_pcm_codec (codec_id))
+  {
+    domain_ = OMX_PortDomainAudio;
+    audio_coding_type_
+        = static_cast< OMX_AUDIO_CODINGTYPE >(OMX_AUDIO_CodingPCM);
+    pcmtype_.nSamplingRate = samplerate;
+    pcmtype_.nChannels = nchannels;
+    pcmtype_.nBitPerSample = bitdepth;
+    pcmtype_.eEndian = endianness;
+    pcmtype_.eNumData = sign;
+  }
+}
+
 void tiz::probe::set_mp2_codec_info (const OMX_U32 samplerate,
                                      const OMX_U32 bitrate,
                                      const OMX_U32 nchannels,
@@ -628,7 +863,7 @@ void tiz::probe::set_vorbis_codec_info (const OMX_U32 samplerate,
 
 void tiz::probe::get_pcm_codec_info (OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype)
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -640,15 +875,9 @@ void tiz::probe::get_pcm_codec_info (OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype)
   return;
 }
 
-void tiz::probe::set_pcm_codec_info (const OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype)
-{
-  pcmtype_ = pcmtype;
-  return;
-}
-
 void tiz::probe::get_mp2_codec_info (OMX_TIZONIA_AUDIO_PARAM_MP2TYPE &mp2type)
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -658,7 +887,7 @@ void tiz::probe::get_mp2_codec_info (OMX_TIZONIA_AUDIO_PARAM_MP2TYPE &mp2type)
 
 void tiz::probe::get_mp3_codec_info (OMX_AUDIO_PARAM_MP3TYPE &mp3type)
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -668,7 +897,7 @@ void tiz::probe::get_mp3_codec_info (OMX_AUDIO_PARAM_MP3TYPE &mp3type)
 
 void tiz::probe::get_aac_codec_info (OMX_AUDIO_PARAM_AACPROFILETYPE &aactype)
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -679,7 +908,7 @@ void tiz::probe::get_aac_codec_info (OMX_AUDIO_PARAM_AACPROFILETYPE &aactype)
 void tiz::probe::get_opus_codec_info (
     OMX_TIZONIA_AUDIO_PARAM_OPUSTYPE &opustype)
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -691,7 +920,7 @@ void tiz::probe::get_opus_codec_info (
 void tiz::probe::get_flac_codec_info (
     OMX_TIZONIA_AUDIO_PARAM_FLACTYPE &flactype)
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -701,7 +930,7 @@ void tiz::probe::get_flac_codec_info (
 
 void tiz::probe::get_vorbis_codec_info (OMX_AUDIO_PARAM_VORBISTYPE &vorbistype)
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -711,7 +940,7 @@ void tiz::probe::get_vorbis_codec_info (OMX_AUDIO_PARAM_VORBISTYPE &vorbistype)
 
 void tiz::probe::get_vp8_codec_info (OMX_VIDEO_PARAM_VP8TYPE &vp8type)
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -721,21 +950,23 @@ void tiz::probe::get_vp8_codec_info (OMX_VIDEO_PARAM_VP8TYPE &vp8type)
 
 std::string tiz::probe::get_stream_title ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
   if (stream_title_.empty ())
   {
-    stream_title_.assign (uri_.c_str ());
-    boost::replace_all (stream_title_, "_", " ");
+    // Not stored, so that a probed object is never modified again
+    std::string title (uri_);
+    boost::replace_all (title, "_", " ");
+    return title;
   }
   return stream_title_;
 }
 
 std::string tiz::probe::get_stream_genre ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -744,83 +975,56 @@ std::string tiz::probe::get_stream_genre ()
 
 bool tiz::probe::is_cbr_stream ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
   return stream_is_cbr_;
 }
 
-std::string tiz::probe::retrieve_meta_data_str (
-    TagLib::String (TagLib::Tag::*TagFunction)() const) const
-{
-  assert (TagFunction);
-  if (!meta_file_.isNull () && meta_file_.tag ())
-  {
-    TagLib::Tag *tag = meta_file_.tag ();
-    return (tag->*TagFunction)().stripWhiteSpace ().to8Bit ();
-  }
-  return std::string ();
-}
-
-unsigned int tiz::probe::retrieve_meta_data_uint (
-    TagLib::uint (TagLib::Tag::*TagFunction)() const) const
-{
-  assert (TagFunction);
-  if (!meta_file_.isNull () && meta_file_.tag ())
-  {
-    TagLib::Tag *tag = meta_file_.tag ();
-    return (tag->*TagFunction)();
-  }
-  return 0;
-}
-
 std::string tiz::probe::title () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::title);
+  return tags_.title_;
 }
 
 std::string tiz::probe::artist () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::artist);
+  return tags_.artist_;
 }
 
 std::string tiz::probe::album () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::album);
+  return tags_.album_;
 }
 
 std::string tiz::probe::year () const
 {
-  return boost::lexical_cast< std::string >(
-      retrieve_meta_data_uint (&TagLib::Tag::year));
+  return boost::lexical_cast< std::string >(tags_.year_);
 }
 
 std::string tiz::probe::comment () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::comment);
+  return tags_.comment_;
 }
 
 std::string tiz::probe::track () const
 {
-  return boost::lexical_cast< std::string >(
-      retrieve_meta_data_uint (&TagLib::Tag::track));
+  return boost::lexical_cast< std::string >(tags_.track_);
 }
 
 std::string tiz::probe::genre () const
 {
-  return retrieve_meta_data_str (&TagLib::Tag::genre);
+  return tags_.genre_;
 }
 
 std::string tiz::probe::stream_length () const
 {
   std::string length_str;
 
-  if (!meta_file_.isNull () && meta_file_.audioProperties ())
+  if (tags_.length_secs_ >= 0)
   {
-    TagLib::AudioProperties *properties = meta_file_.audioProperties ();
-    int seconds = properties->length () % 60;
-    int minutes = (properties->length () - seconds) / 60;
+    int seconds = tags_.length_secs_ % 60;
+    int minutes = (tags_.length_secs_ - seconds) / 60;
     int hours = 0;
     if (minutes >= 60)
     {
@@ -850,9 +1054,21 @@ std::string tiz::probe::stream_length () const
   return length_str;
 }
 
+bool tiz::probe::replay_gain (const bool album, double &gain_db,
+                              double &peak) const
+{
+  if (album ? !tags_.has_album_gain_ : !tags_.has_track_gain_)
+  {
+    return false;
+  }
+  gain_db = album ? tags_.album_gain_db_ : tags_.track_gain_db_;
+  peak = album ? tags_.album_peak_ : tags_.track_peak_;
+  return true;
+}
+
 void tiz::probe::dump_pcm_info ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -866,7 +1082,7 @@ void tiz::probe::dump_pcm_info ()
 
 void tiz::probe::dump_mp3_info ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -878,7 +1094,7 @@ void tiz::probe::dump_mp3_info ()
 
 void tiz::probe::dump_mp2_and_pcm_info ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -892,7 +1108,7 @@ void tiz::probe::dump_mp2_and_pcm_info ()
 
 void tiz::probe::dump_mp3_and_pcm_info ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -906,7 +1122,7 @@ void tiz::probe::dump_mp3_and_pcm_info ()
 
 void tiz::probe::dump_aac_and_pcm_info ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
@@ -920,7 +1136,7 @@ void tiz::probe::dump_aac_and_pcm_info ()
 
 void tiz::probe::dump_stream_metadata ()
 {
-  if (OMX_PortDomainMax == domain_)
+  if (!probed_)
   {
     probe_stream ();
   }
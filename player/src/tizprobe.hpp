@@ -32,9 +32,6 @@
 #include <string>
 #include <boost/shared_ptr.hpp>
 
-#include <fileref.h>
-#include <tag.h>
-
 #include <OMX_Core.h>
 #include <OMX_Component.h>
 #include <OMX_Audio.h>
@@ -43,11 +40,75 @@
 
 namespace tiz
 {
+  /**
+   * The tags are read on construction, and the stream is probed the first
+   * time any of its other properties is asked for. After that, no method
+   * modifies the object, so a probe can be shared by several threads (see
+   * tiz::probecache).
+   */
   class probe
   {
 
+  public:
+    /**
+     * The file's tags and length, as read by TagLib.
+     */
+    struct tags
+    {
+      tags ();
+      std::string title_;
+      std::string artist_;
+      std::string album_;
+      std::string comment_;
+      std::string genre_;
+      unsigned int year_;
+      unsigned int track_;
+      int length_secs_;  // -1 if unknown
+      bool has_track_gain_;
+      double track_gain_db_;
+      double track_peak_;
+      bool has_album_gain_;
+      double album_gain_db_;
+      double album_peak_;
+    };
+
+    /**
+     * Everything that probing a file finds out. tiz::medialib keeps it on
+     * disk, so that an unchanged file doesn't have to be opened again.
+     */
+    struct info
+    {
+      info ();
+      OMX_PORTDOMAINTYPE domain_;
+      OMX_AUDIO_CODINGTYPE audio_coding_type_;
+      OMX_VIDEO_CODINGTYPE video_coding_type_;
+      OMX_MEDIACONTAINER_FORMATTYPE container_type_;
+      OMX_AUDIO_PARAM_PCMMODETYPE pcmtype_;
+      OMX_TIZONIA_AUDIO_PARAM_MP2TYPE mp2type_;
+      OMX_AUDIO_PARAM_MP3TYPE mp3type_;
+      OMX_TIZONIA_AUDIO_PARAM_OPUSTYPE opustype_;
+      OMX_TIZONIA_AUDIO_PARAM_FLACTYPE flactype_;
+      OMX_AUDIO_PARAM_VORBISTYPE vorbistype_;
+      OMX_AUDIO_PARAM_AACPROFILETYPE aactype_;
+      OMX_VIDEO_PARAM_VP8TYPE vp8type_;
+      std::string stream_title_;
+      std::string stream_genre_;
+      bool stream_is_cbr_;
+      tags tags_;
+    };
+
   public:
     probe (const std::string &uri, const bool quiet = false);
+    /**
+     * Re-creates an already probed object, without opening @a uri.
+     */
+    probe (const std::string &uri, const info &probed,
+           const bool quiet = false);
+
+    /**
+     * Probes the stream, if not done yet, and returns the results.
+     */
+    info get_info ();
 
     std::string get_uri () const;
     OMX_PORTDOMAINTYPE get_omx_domain ();
@@ -56,7 +117,6 @@ namespace tiz
     OMX_MEDIACONTAINER_FORMATTYPE get_container_type ();
 
     void get_pcm_codec_info (OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype);
-    void set_pcm_codec_info (const OMX_AUDIO_PARAM_PCMMODETYPE &pcmtype);
     void get_mp2_codec_info (OMX_TIZONIA_AUDIO_PARAM_MP2TYPE &mp2type);
     void get_mp3_codec_info (OMX_AUDIO_PARAM_MP3TYPE &mp3type);
     void get_aac_codec_info (OMX_AUDIO_PARAM_AACPROFILETYPE &aactype);
@@ -83,6 +143,10 @@ namespace tiz
     /* Duration */
     std::string stream_length () const;
 
+    /* ReplayGain information: the gain in dB and the linear peak. Returns
+       false if the stream isn't tagged with it. */
+    bool replay_gain (const bool album, double &gain_db, double &peak) const;
+
     void dump_pcm_info ();
     void dump_mp3_info ();
     void dump_mp2_and_pcm_info ();
@@ -92,6 +156,12 @@ namespace tiz
 
   private:
     void probe_stream ();
+    void obtain_tagged_title_and_genre ();
+    void set_codec_info (const OMX_AUDIO_CODINGTYPE codec_id,
+                         const OMX_U32 samplerate, const OMX_U32 bitrate,
+                         const OMX_U32 nchannels, const OMX_U32 bitdepth,
+                         const OMX_ENDIANTYPE endianness,
+                         const OMX_NUMERICALDATATYPE sign);
     void set_mp2_codec_info (const OMX_U32 samplerate, const OMX_U32 bitrate,
                              const OMX_U32 nchannels, const OMX_U32 bitdepth,
                              const OMX_ENDIANTYPE endianness,
@@ -116,10 +186,6 @@ namespace tiz
                                 const OMX_U32 nchannels, const OMX_U32 bitdepth,
                                 const OMX_ENDIANTYPE endianness,
                                 const OMX_NUMERICALDATATYPE sign);
-    std::string retrieve_meta_data_str (
-        TagLib::String (TagLib::Tag::*TagFunction)() const) const;
-    unsigned int retrieve_meta_data_uint (
-        TagLib::uint (TagLib::Tag::*TagFunction)() const) const;
 
   private:
     std::string uri_;
@@ -137,10 +203,11 @@ namespace tiz
     OMX_AUDIO_PARAM_VORBISTYPE vorbistype_;
     OMX_AUDIO_PARAM_AACPROFILETYPE aactype_;
     OMX_VIDEO_PARAM_VP8TYPE vp8type_;
-    TagLib::FileRef meta_file_;
+    tags tags_;
     std::string stream_title_;
     std::string stream_genre_;
     bool stream_is_cbr_;
+    bool probed_;
   };
 }  // namespace tiz
 
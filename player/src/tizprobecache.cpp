@@ -0,0 +1,372 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizprobecache.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Cache of probed local media files, with background probing
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <sys/stat.h>
+
+#include <deque>
+#include <map>
+#include <set>
+
+#include <boost/make_shared.hpp>
+
+#include <tizplatform.h>
+
+#include "tizprobe.hpp"
+#include "tizprobecache.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.probecache"
+#endif
+
+#define PROBECACHE_CAPACITY 16
+#define PROBECACHE_THREADS 1
+
+namespace  // unnamed namespace
+{
+  struct file_key
+  {
+    file_key () : size_ (0), mtime_sec_ (0), mtime_nsec_ (0)
+    {
+    }
+    bool operator==(const file_key &other) const
+    {
+      return size_ == other.size_ && mtime_sec_ == other.mtime_sec_
+             && mtime_nsec_ == other.mtime_nsec_;
+    }
+    long long size_;
+    long long mtime_sec_;
+    long long mtime_nsec_;
+  };
+
+  bool stat_file (const std::string &uri, file_key &key)
+  {
+    struct stat st;
+    if (0 != stat (uri.c_str (), &st) || !S_ISREG (st.st_mode))
+    {
+      return false;
+    }
+    key.size_ = st.st_size;
+    key.mtime_sec_ = st.st_mtim.tv_sec;
+    key.mtime_nsec_ = st.st_mtim.tv_nsec;
+    return true;
+  }
+
+  // Probing a file runs TagLib and, for the formats that the sniffer doesn't
+  // recognise, MediaInfo. Probes are made one at a time, whether by the
+  // background thread or by a player thread, so neither is ever called
+  // concurrently. A probe reads the file's tags on construction, and keeps
+  // no TagLib objects around.
+  tiz_mutex_t *probe_mutex ()
+  {
+    static tiz_mutex_t mutex;
+    static const bool inited = (OMX_ErrorNone == tiz_mutex_init (&mutex));
+    return inited ? &mutex : NULL;
+  }
+
+  // Guarded by the probe mutex
+  tiz::medialib_ptr_t &media_library ()
+  {
+    static tiz::medialib_ptr_t medialib;
+    return medialib;
+  }
+
+  tizprobe_ptr_t probe_file (const std::string &uri)
+  {
+    tiz_mutex_t *p_mutex = probe_mutex ();
+    if (p_mutex)
+    {
+      tiz_mutex_lock (p_mutex);
+    }
+    const tiz::medialib_ptr_t &medialib = media_library ();
+    tiz::probe::info info;
+    tizprobe_ptr_t probe;
+    if (medialib && medialib->lookup_probe (uri, info))
+    {
+      TIZ_LOG (TIZ_PRIORITY_TRACE, "media library hit [%s]", uri.c_str ());
+      probe = boost::make_shared< tiz::probe > (uri, info, /* quiet = */ true);
+    }
+    else
+    {
+      probe = boost::make_shared< tiz::probe > (uri, /* quiet = */ true);
+      // Probing is lazy; this forces it now
+      const tiz::probe::info probed (probe->get_info ());
+      if (medialib)
+      {
+        medialib->store_probe (uri, probed);
+      }
+    }
+    if (p_mutex)
+    {
+      tiz_mutex_unlock (p_mutex);
+    }
+    return probe;
+  }
+
+  class cache
+  {
+  public:
+    cache ()
+      : entries_ (),
+        tick_ (0),
+        queue_ (),
+        in_flight_ (),
+        mutex_ (),
+        cond_ (),
+        threads_ (),
+        nthreads_ (0),
+        stop_ (false),
+        inited_ (false)
+    {
+      inited_ = (OMX_ErrorNone == tiz_mutex_init (&mutex_));
+      if (inited_ && OMX_ErrorNone != tiz_cond_init (&cond_))
+      {
+        (void)tiz_mutex_destroy (&mutex_);
+        inited_ = false;
+      }
+    }
+
+    ~cache ()
+    {
+      if (inited_)
+      {
+        tiz_mutex_lock (&mutex_);
+        stop_ = true;
+        queue_.clear ();
+        tiz_cond_broadcast (&cond_);
+        tiz_mutex_unlock (&mutex_);
+        for (int i = 0; i < nthreads_; ++i)
+        {
+          (void)tiz_thread_join (&threads_[i], NULL);
+        }
+        (void)tiz_cond_destroy (&cond_);
+        (void)tiz_mutex_destroy (&mutex_);
+      }
+    }
+
+    tizprobe_ptr_t obtain (const std::string &uri)
+    {
+      file_key key;
+      if (!inited_ || !stat_file (uri, key))
+      {
+        return probe_file (uri);
+      }
+
+      tiz_mutex_lock (&mutex_);
+      // If a background thread is already probing this file, wait for it
+      // instead of probing it twice
+      while (in_flight_.count (uri))
+      {
+        tiz_cond_wait (&cond_, &mutex_);
+      }
+      tizprobe_ptr_t cached = lookup (uri, key);
+      tiz_mutex_unlock (&mutex_);
+
+      if (!cached)
+      {
+        cached = probe_file (uri);
+        tiz_mutex_lock (&mutex_);
+        store (uri, key, cached);
+        tiz_mutex_unlock (&mutex_);
+      }
+      else
+      {
+        TIZ_LOG (TIZ_PRIORITY_TRACE, "cache hit [%s]", uri.c_str ());
+      }
+
+      return cached;
+    }
+
+    void prefetch (const uri_lst_t &uri_list)
+    {
+      if (!inited_)
+      {
+        return;
+      }
+
+      tiz_mutex_lock (&mutex_);
+      queue_.assign (uri_list.begin (), uri_list.end ());
+      while (nthreads_ < PROBECACHE_THREADS
+             && OMX_ErrorNone == tiz_thread_create (&threads_[nthreads_], 0,
+                                                    0, thread_func, this))
+      {
+        ++nthreads_;
+      }
+      tiz_cond_broadcast (&cond_);
+      tiz_mutex_unlock (&mutex_);
+    }
+
+  private:
+    struct entry
+    {
+      entry () : key_ (), probe_ (), last_used_ (0)
+      {
+      }
+      file_key key_;
+      tizprobe_ptr_t probe_;
+      unsigned long last_used_;
+    };
+    typedef std::map< std::string, entry > entry_map_t;
+
+  private:
+    static void *thread_func (void *p_arg)
+    {
+      cache *p_cache = static_cast< cache * > (p_arg);
+      assert (p_cache);
+      p_cache->run ();
+      return NULL;
+    }
+
+    void run ()
+    {
+      tiz_mutex_lock (&mutex_);
+      while (!stop_)
+      {
+        if (queue_.empty ())
+        {
+          tiz_cond_wait (&cond_, &mutex_);
+          continue;
+        }
+
+        const std::string uri (queue_.front ());
+        queue_.pop_front ();
+
+        if (in_flight_.count (uri) || entries_.count (uri))
+        {
+          // Already cached entries are validated when they are obtained
+          continue;
+        }
+
+        in_flight_.insert (uri);
+        tiz_mutex_unlock (&mutex_);
+        file_key key;
+        tizprobe_ptr_t probe;
+        if (stat_file (uri, key))
+        {
+          probe = probe_file (uri);
+        }
+        tiz_mutex_lock (&mutex_);
+        if (probe)
+        {
+          TIZ_LOG (TIZ_PRIORITY_TRACE, "pre-probed [%s]", uri.c_str ());
+          store (uri, key, probe);
+        }
+        in_flight_.erase (uri);
+        tiz_cond_broadcast (&cond_);
+      }
+      tiz_mutex_unlock (&mutex_);
+    }
+
+    // Must be called with the mutex held
+    tizprobe_ptr_t lookup (const std::string &uri, const file_key &key)
+    {
+      tizprobe_ptr_t probe;
+      entry_map_t::iterator it = entries_.find (uri);
+      if (it != entries_.end () && it->second.key_ == key)
+      {
+        it->second.last_used_ = ++tick_;
+        probe = it->second.probe_;
+      }
+      return probe;
+    }
+
+    // Must be called with the mutex held
+    void store (const std::string &uri, const file_key &key,
+                const tizprobe_ptr_t &probe)
+    {
+      if (entries_.size () >= PROBECACHE_CAPACITY && !entries_.count (uri))
+      {
+        // Evict the least recently used entry
+        entry_map_t::iterator lru = entries_.begin ();
+        for (entry_map_t::iterator it = entries_.begin ();
+             it != entries_.end (); ++it)
+        {
+          if (it->second.last_used_ < lru->second.last_used_)
+          {
+            lru = it;
+          }
+        }
+        entries_.erase (lru);
+      }
+      entry &e = entries_[uri];
+      e.key_ = key;
+      e.probe_ = probe;
+      e.last_used_ = ++tick_;
+    }
+
+  private:
+    entry_map_t entries_;
+    unsigned long tick_;
+    std::deque< std::string > queue_;
+    std::set< std::string > in_flight_;
+    tiz_mutex_t mutex_;
+    tiz_cond_t cond_;
+    tiz_thread_t threads_[PROBECACHE_THREADS];
+    int nthreads_;
+    bool stop_;
+    bool inited_;
+  };
+
+  cache &the_cache ()
+  {
+    static cache c;
+    return c;
+  }
+}  // unnamed namespace
+
+//
+// probecache
+//
+tizprobe_ptr_t tiz::probecache::obtain (const std::string &uri)
+{
+  return the_cache ().obtain (uri);
+}
+
+void tiz::probecache::prefetch (const uri_lst_t &uri_list)
+{
+  the_cache ().prefetch (uri_list);
+}
+
+void tiz::probecache::set_media_library (const medialib_ptr_t &medialib)
+{
+  tiz_mutex_t *p_mutex = probe_mutex ();
+  if (p_mutex)
+  {
+    tiz_mutex_lock (p_mutex);
+  }
+  media_library () = medialib;
+  if (p_mutex)
+  {
+    tiz_mutex_unlock (p_mutex);
+  }
+}
@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizprobecache.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Cache of probed local media files, with background probing
+ *
+ *
+ */
+
+#ifndef TIZPROBECACHE_HPP
+#define TIZPROBECACHE_HPP
+
+#include <string>
+
+#include "tizgraphtypes.hpp"
+#include "tizmedialib.hpp"
+
+namespace tiz
+{
+  /**
+   * A bounded cache of tiz::probe objects for local files, keyed by path, size
+   * and modification time. Upcoming playlist entries can be probed in the
+   * background, so that by the time a track starts, its probe is ready.
+   */
+  class probecache
+  {
+
+  public:
+    /**
+     * Returns a (quiet) probe object for @a uri. The probe is taken from the
+     * cache if available, or probed in the calling thread otherwise. The
+     * object is shared with the cache and with any other caller that asks
+     * for the same file; tiz::probe doesn't change once probed.
+     */
+    static tizprobe_ptr_t obtain (const std::string &uri);
+
+    /**
+     * Schedules the probing of @a uri_list in the background. Any entries
+     * scheduled by a previous call that have not been probed yet are
+     * discarded.
+     */
+    static void prefetch (const uri_lst_t &uri_list);
+
+    /**
+     * Sets the media library where probe results are kept across runs. Files
+     * with a stored, up-to-date record are not opened to be probed again.
+     */
+    static void set_media_library (const medialib_ptr_t &medialib);
+  };
+}  // namespace tiz
+
+#endif  // TIZPROBECACHE_HPP
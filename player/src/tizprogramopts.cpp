@@ -71,6 +71,8 @@ namespace
 {
   const int TIZ_STREAMING_SERVER_DEFAULT_PORT = 8010;
   const int TIZ_MAX_BITRATE_MODES = 2;
+  // One per output port of the mp3 encoder
+  const int TIZ_MAX_TRANSCODE_BITRATES = 4;
 
   struct program_option_is_defaulted
   {
@@ -146,6 +148,28 @@ namespace
     return rc;
   }
 
+  bool is_valid_transcode_bitrate_list (
+      const std::vector< std::string > &rate_strings, std::vector< int > &rates)
+  {
+    bool rc = true;
+    rates.clear ();
+    for (unsigned int i = 0; i < rate_strings.size () && rc; ++i)
+    {
+      try
+      {
+        rates.push_back (boost::lexical_cast< int > (rate_strings[i]));
+        rc = (rates[i] >= 8 && rates[i] <= 320);
+      }
+      catch (const boost::bad_lexical_cast &)
+      {
+        rc = false;
+      }
+    }
+    rc &= !rates.empty ();
+    rc &= (rates.size () <= TIZ_MAX_TRANSCODE_BITRATES);
+    return rc;
+  }
+
   bool omx_conflicting_options (const po::variables_map &vm, const char *opt1,
                                 const char *opt2)
   {
@@ -291,6 +315,8 @@ tiz::programopts::programopts (int argc, char *argv[])
     bitrate_list_ (),
     sampling_rates_ (),
     sampling_rate_list_ (),
+    transcode_bitrates_ (),
+    transcode_bitrate_list_ (),
     uri_list_ (),
     spotify_user_ (),
     spotify_pass_ (),
@@ -568,6 +594,11 @@ void tiz::programopts::print_usage_examples () const
   printf ("    * Streams files from the '~/Music' directory.\n");
   printf ("    * File formats currently supported for streaming: mp3.\n");
   printf ("    * Sampling rates other than [44100,4800] are ignored.\n");
+  printf ("\n tizonia --transcode=192,64 --stream ~/Music\n\n");
+  printf ("    * Streams files from the '~/Music' directory at 192 and 64 "
+          "kbps.\n");
+  printf ("    * Each bitrate is served from its own mount point (see "
+          "tizonia.conf).\n");
   printf ("\n");
 }
 
@@ -657,6 +688,11 @@ const std::vector< int > &tiz::programopts::sampling_rate_list () const
   return sampling_rate_list_;
 }
 
+const std::vector< int > &tiz::programopts::transcode_bitrate_list () const
+{
+  return transcode_bitrate_list_;
+}
+
 const std::vector< std::string > &tiz::programopts::uri_list () const
 {
   return uri_list_;
@@ -1276,6 +1312,14 @@ void tiz::programopts::init_streaming_server_options ()
        "of sampling rates. Only media with these rates will in the "
        "playlist. Default: any.")
       /* TIZ_CLASS_COMMENT: */
+      ("transcode", po::value (&transcode_bitrates_),
+       "A comma-separated list "
+       /* TIZ_CLASS_COMMENT: */
+       "of up to 4 MP3 bitrates in kbps (e.g. '192,64'). The media is "
+       "decoded once and re-encoded at each bitrate, each one served from "
+       "its own mount point. Default: none, the files are streamed as they "
+       "are.")
+      /* TIZ_CLASS_COMMENT: */
       ;
 
   // Give a default value to the bitrate list
@@ -1286,7 +1330,7 @@ void tiz::programopts::init_streaming_server_options ()
   all_streaming_server_options_
       = boost::assign::list_of ("server") ("port") ("station-name") (
             "station-genre") ("no-icy-metadata") ("bitrate-modes") (
-            "sampling-rates")
+            "sampling-rates") ("transcode")
             .convert_to_container< std::vector< std::string > > ();
 }
 
@@ -1765,6 +1809,7 @@ int tiz::programopts::consume_streaming_server_options (bool &done,
     PO_RETURN_IF_FAIL (validate_port_argument (msg));
     PO_RETURN_IF_FAIL (validate_bitrates_argument (msg));
     PO_RETURN_IF_FAIL (validate_sampling_rates_argument (msg));
+    PO_RETURN_IF_FAIL (validate_transcode_argument (msg));
     rc = consume_input_file_uris_option ();
     if (EXIT_SUCCESS == rc)
     {
@@ -2593,6 +2638,28 @@ bool tiz::programopts::validate_sampling_rates_argument (std::string &msg)
   return rc;
 }
 
+bool tiz::programopts::validate_transcode_argument (std::string &msg)
+{
+  bool rc = true;
+  if (vm_.count ("transcode"))
+  {
+    std::vector< std::string > bitrate_str_list;
+    boost::split (bitrate_str_list, transcode_bitrates_,
+                  boost::is_any_of (","));
+    if (!is_valid_transcode_bitrate_list (bitrate_str_list,
+                                          transcode_bitrate_list_))
+    {
+      rc = false;
+      std::ostringstream oss;
+      oss << "Invalid argument : " << transcode_bitrates_ << "\n"
+          << "Valid values : up to " << TIZ_MAX_TRANSCODE_BITRATES
+          << " bitrates, in kbps, between 8 and 320.";
+      msg.assign (oss.str ());
+    }
+  }
+  return rc;
+}
+
 void tiz::programopts::register_consume_function (const consume_mem_fn_t cf)
 {
   consume_functions_.push_back (boost::bind (boost::mem_fn (cf), this, _1, _2));
@@ -74,6 +74,7 @@ namespace tiz
     const std::vector< std::string > &bitrate_list () const;
     const std::string &sampling_rates () const;
     const std::vector< int > &sampling_rate_list () const;
+    const std::vector< int > &transcode_bitrate_list () const;
     const std::vector< std::string > &uri_list () const;
     const std::string &spotify_user () const;
     const std::string &spotify_password () const;
@@ -150,6 +151,7 @@ namespace tiz
     bool validate_port_argument (std::string &msg) const;
     bool validate_bitrates_argument (std::string &msg);
     bool validate_sampling_rates_argument (std::string &msg);
+    bool validate_transcode_argument (std::string &msg);
 
     int call_handler (const option_handlers_map_t::const_iterator &handler_it);
 
@@ -193,6 +195,8 @@ namespace tiz
     std::vector< std::string > bitrate_list_;
     std::string sampling_rates_;
     std::vector< int > sampling_rate_list_;
+    std::string transcode_bitrates_;
+    std::vector< int > transcode_bitrate_list_;
     std::vector< std::string > uri_list_;
     std::string spotify_user_;
     std::string spotify_pass_;
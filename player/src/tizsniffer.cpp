@@ -0,0 +1,504 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizsniffer.cpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lightweight audio file header parser
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <vector>
+
+#include <tizplatform.h>
+
+#include "tizsniffer.hpp"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.play.sniffer"
+#endif
+
+// The amount of data read after any ID3v2 tag
+#define SNIFFER_HEAD_SIZE (16 * 1024)
+
+namespace  // unnamed namespace
+{
+  typedef std::vector< uint8_t > buffer_t;
+
+  uint32_t be16 (const uint8_t *p)
+  {
+    return (p[0] << 8) | p[1];
+  }
+
+  uint32_t be32 (const uint8_t *p)
+  {
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+  }
+
+  uint32_t le16 (const uint8_t *p)
+  {
+    return p[0] | (p[1] << 8);
+  }
+
+  uint32_t le32 (const uint8_t *p)
+  {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  bool read_head (const std::string &uri, buffer_t &head, long long &file_size)
+  {
+    FILE *p_file = fopen (uri.c_str (), "rb");
+    struct stat st;
+    uint8_t id3[10];
+    long start = 0;
+    bool outcome = false;
+
+    if (!p_file)
+    {
+      return false;
+    }
+
+    if (0 == fstat (fileno (p_file), &st) && S_ISREG (st.st_mode))
+    {
+      file_size = st.st_size;
+      // Skip an ID3v2 tag, which may be large when it holds pictures
+      if (sizeof (id3) == fread (id3, 1, sizeof (id3), p_file)
+          && 0 == memcmp (id3, "ID3", 3))
+      {
+        start = 10 + ((id3[6] & 0x7f) << 21) + ((id3[7] & 0x7f) << 14)
+                + ((id3[8] & 0x7f) << 7) + (id3[9] & 0x7f)
+                + ((id3[5] & 0x10) ? 10 : 0);
+      }
+
+      if (0 == fseek (p_file, start, SEEK_SET))
+      {
+        head.resize (SNIFFER_HEAD_SIZE);
+        head.resize (fread (&head[0], 1, head.size (), p_file));
+        file_size -= start;
+        outcome = head.size () >= 64;
+      }
+    }
+
+    fclose (p_file);
+    return outcome;
+  }
+
+  //
+  // FLAC STREAMINFO (without the metadata block header)
+  //
+  bool parse_streaminfo (const uint8_t *p, const size_t len,
+                         const long long file_size,
+                         tiz::sniffer::stream_info &info)
+  {
+    if (len < 18)
+    {
+      return false;
+    }
+    const uint32_t samplerate = (p[10] << 12) | (p[11] << 4) | (p[12] >> 4);
+    const uint64_t total_samples = ((uint64_t)(p[13] & 0x0f) << 32)
+                                   | be32 (p + 14);
+    if (0 == samplerate)
+    {
+      return false;
+    }
+    info.codec_ = static_cast< OMX_AUDIO_CODINGTYPE > (OMX_AUDIO_CodingFLAC);
+    info.samplerate_ = samplerate;
+    info.nchannels_ = ((p[12] >> 1) & 0x07) + 1;
+    info.bitdepth_ = (((p[12] & 0x01) << 4) | (p[13] >> 4)) + 1;
+    if (total_samples)
+    {
+      info.bitrate_ = (OMX_U32) (file_size * 8 * samplerate / total_samples);
+    }
+    return true;
+  }
+
+  bool sniff_flac (const buffer_t &head, const long long file_size,
+                   tiz::sniffer::stream_info &info)
+  {
+    // "fLaC" followed by the STREAMINFO block, which must come first
+    if (head.size () < 8 + 34 || 0 != memcmp (&head[0], "fLaC", 4)
+        || 0 != (head[4] & 0x7f))
+    {
+      return false;
+    }
+    info.container_ = OMX_FORMAT_RAW;
+    return parse_streaminfo (&head[8], head.size () - 8, file_size, info);
+  }
+
+  //
+  // Ogg: the first packet of the first page identifies the codec
+  //
+  bool sniff_ogg (const buffer_t &head, const long long file_size,
+                  tiz::sniffer::stream_info &info)
+  {
+    if (head.size () < 27 || 0 != memcmp (&head[0], "OggS", 4))
+    {
+      return false;
+    }
+
+    const size_t nsegs = head[26];
+    const size_t data_start = 27 + nsegs;
+    if (head.size () < data_start + 64)
+    {
+      return false;
+    }
+
+    const uint8_t *p = &head[data_start];
+    info.container_ = OMX_FORMAT_OGG;
+    if (0 == memcmp (p, "\x01vorbis", 7))
+    {
+      info.codec_ = OMX_AUDIO_CodingVORBIS;
+      info.nchannels_ = p[11];
+      info.samplerate_ = le32 (p + 12);
+      info.bitrate_ = le32 (p + 20);  // nominal bitrate
+      return info.samplerate_ > 0 && info.nchannels_ > 0;
+    }
+    else if (0 == memcmp (p, "OpusHead", 8))
+    {
+      info.codec_ = static_cast< OMX_AUDIO_CODINGTYPE > (OMX_AUDIO_CodingOPUS);
+      info.nchannels_ = p[9];
+      // This is the sampling rate of the original input; Opus always decodes
+      // at 48 KHz
+      info.samplerate_ = le32 (p + 12) ? le32 (p + 12) : 48000;
+      return info.nchannels_ > 0;
+    }
+    else if (0 == memcmp (p, "\x7f" "FLAC", 5) && 0 == memcmp (p + 9, "fLaC", 4)
+             && 0 == (p[13] & 0x7f))
+    {
+      return parse_streaminfo (p + 17, head.size () - data_start - 17,
+                               file_size, info);
+    }
+    return false;
+  }
+
+  //
+  // RIFF/WAVE and AIFF
+  //
+  bool sniff_wav (const buffer_t &head, const long long,
+                  tiz::sniffer::stream_info &info)
+  {
+    if (head.size () < 12 || 0 != memcmp (&head[0], "RIFF", 4)
+        || 0 != memcmp (&head[8], "WAVE", 4))
+    {
+      return false;
+    }
+
+    size_t pos = 12;
+    while (pos + 8 <= head.size ())
+    {
+      const uint32_t chunk_size = le32 (&head[pos + 4]);
+      if (0 == memcmp (&head[pos], "fmt ", 4))
+      {
+        if (chunk_size < 16 || pos + 8 + 16 > head.size ())
+        {
+          return false;
+        }
+        const uint8_t *p = &head[pos + 8];
+        const uint32_t format_tag = le16 (p);
+        const bool is_extensible = (0xfffe == format_tag);
+        if (!(1 == format_tag
+              || (is_extensible && chunk_size >= 40
+                  && pos + 8 + 26 <= head.size () && 1 == le16 (p + 24))))
+        {
+          // Only linear PCM is recognised here
+          return false;
+        }
+        info.codec_ = OMX_AUDIO_CodingPCM;
+        info.nchannels_ = le16 (p + 2);
+        info.samplerate_ = le32 (p + 4);
+        info.bitrate_ = le32 (p + 8) * 8;
+        info.bitdepth_ = le16 (p + 14);
+        info.endianness_ = OMX_EndianLittle;
+        info.sign_ = (8 == info.bitdepth_ ? OMX_NumericalDataUnsigned
+                                           : OMX_NumericalDataSigned);
+        info.is_cbr_ = true;
+        return info.nchannels_ > 0 && info.samplerate_ > 0;
+      }
+      pos += 8 + chunk_size + (chunk_size & 1);
+    }
+    return false;
+  }
+
+  bool sniff_aiff (const buffer_t &head, const long long,
+                   tiz::sniffer::stream_info &info)
+  {
+    if (head.size () < 12 || 0 != memcmp (&head[0], "FORM", 4)
+        || 0 != memcmp (&head[8], "AIFF", 4))
+    {
+      return false;
+    }
+
+    size_t pos = 12;
+    while (pos + 8 <= head.size ())
+    {
+      const uint32_t chunk_size = be32 (&head[pos + 4]);
+      if (0 == memcmp (&head[pos], "COMM", 4))
+      {
+        if (chunk_size < 18 || pos + 8 + 18 > head.size ())
+        {
+          return false;
+        }
+        const uint8_t *p = &head[pos + 8];
+        // The sample rate is an 80-bit IEEE 754 extended precision number
+        const int exponent = ((p[8] & 0x7f) << 8 | p[9]) - 16383;
+        const uint32_t mantissa_hi = be32 (p + 10);
+        info.codec_ = OMX_AUDIO_CodingPCM;
+        info.nchannels_ = be16 (p);
+        info.bitdepth_ = be16 (p + 6);
+        info.samplerate_ = (OMX_U32)ldexp ((double)mantissa_hi, exponent - 31);
+        info.bitrate_ = info.samplerate_ * info.nchannels_ * info.bitdepth_;
+        info.endianness_ = OMX_EndianBig;
+        info.sign_ = OMX_NumericalDataSigned;
+        info.is_cbr_ = true;
+        return info.nchannels_ > 0 && info.samplerate_ > 0;
+      }
+      pos += 8 + chunk_size + (chunk_size & 1);
+    }
+    return false;
+  }
+
+  //
+  // ADTS AAC
+  //
+  bool parse_adts_header (const uint8_t *p, uint32_t &samplerate,
+                          uint32_t &nchannels, uint32_t &frame_len)
+  {
+    static const uint32_t rates[]
+        = {96000, 88200, 64000, 48000, 44100, 32000, 24000,
+           22050, 16000, 12000, 11025, 8000,  7350};
+    // 12-bit sync word and layer 0
+    if (0xff != p[0] || 0xf0 != (p[1] & 0xf6))
+    {
+      return false;
+    }
+    const uint32_t rate_idx = (p[2] >> 2) & 0x0f;
+    if (rate_idx >= sizeof (rates) / sizeof (rates[0]))
+    {
+      return false;
+    }
+    samplerate = rates[rate_idx];
+    nchannels = ((p[2] & 0x01) << 2) | (p[3] >> 6);
+    frame_len = ((p[3] & 0x03) << 11) | (p[4] << 3) | (p[5] >> 5);
+    return frame_len >= 7;
+  }
+
+  bool sniff_adts (const buffer_t &head, const long long,
+                   tiz::sniffer::stream_info &info)
+  {
+    uint32_t samplerate = 0, nchannels = 0, frame_len = 0;
+    uint32_t samplerate2 = 0, nchannels2 = 0, frame_len2 = 0;
+    if (!parse_adts_header (&head[0], samplerate, nchannels, frame_len)
+        || frame_len + 7 > head.size ()
+        || !parse_adts_header (&head[frame_len], samplerate2, nchannels2,
+                               frame_len2)
+        || samplerate != samplerate2 || nchannels != nchannels2)
+    {
+      return false;
+    }
+    info.codec_ = OMX_AUDIO_CodingAAC;
+    info.samplerate_ = samplerate;
+    // Channel configuration 0 means that it is signalled in-band
+    info.nchannels_ = nchannels ? nchannels : 2;
+    // An estimate, from the size of the first frame (1024 samples)
+    info.bitrate_ = frame_len * 8 * samplerate / 1024;
+    return true;
+  }
+
+  //
+  // MPEG audio layer II and III
+  //
+  struct mpa_header
+  {
+    int version_;  // 1: MPEG-1, 2: MPEG-2, 3: MPEG-2.5
+    int layer_;
+    uint32_t bitrate_;
+    uint32_t samplerate_;
+    uint32_t nchannels_;
+    uint32_t samples_per_frame_;
+    uint32_t frame_len_;
+  };
+
+  bool parse_mpa_header (const uint8_t *p, mpa_header &hdr)
+  {
+    static const uint16_t v1_l2_rates[]
+        = {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384};
+    static const uint16_t v1_l3_rates[]
+        = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+    static const uint16_t v2_rates[]
+        = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160};
+    static const uint32_t samplerates[3][3] = {{44100, 48000, 32000},
+                                               {22050, 24000, 16000},
+                                               {11025, 12000, 8000}};
+
+    if (0xff != p[0] || 0xe0 != (p[1] & 0xe0))
+    {
+      return false;
+    }
+    const int version_bits = (p[1] >> 3) & 0x03;
+    const int layer_bits = (p[1] >> 1) & 0x03;
+    const int rate_idx = p[2] >> 4;
+    const int sr_idx = (p[2] >> 2) & 0x03;
+    // Reserved values, free format, and layer I are not handled here
+    if (1 == version_bits || 0 == layer_bits || 3 == layer_bits
+        || 0 == rate_idx || 15 == rate_idx || 3 == sr_idx)
+    {
+      return false;
+    }
+
+    hdr.version_ = (3 == version_bits ? 1 : (2 == version_bits ? 2 : 3));
+    hdr.layer_ = 4 - layer_bits;
+    const uint16_t *p_rates
+        = (1 == hdr.version_ ? (2 == hdr.layer_ ? v1_l2_rates : v1_l3_rates)
+                             : v2_rates);
+    hdr.bitrate_ = p_rates[rate_idx] * 1000;
+    hdr.samplerate_ = samplerates[hdr.version_ - 1][sr_idx];
+    hdr.nchannels_ = (3 == (p[3] >> 6)) ? 1 : 2;
+    hdr.samples_per_frame_
+        = (3 == hdr.layer_ && 1 != hdr.version_) ? 576 : 1152;
+    hdr.frame_len_ = hdr.samples_per_frame_ / 8 * hdr.bitrate_
+                         / hdr.samplerate_
+                     + ((p[2] >> 1) & 0x01);
+    return true;
+  }
+
+  bool sniff_mpa (const buffer_t &head, const long long file_size,
+                  tiz::sniffer::stream_info &info)
+  {
+    mpa_header hdr, next;
+    size_t pos = 0;
+
+    // Look for two consecutive, consistent frame headers
+    for (; pos + 4 <= head.size (); ++pos)
+    {
+      if (parse_mpa_header (&head[pos], hdr)
+          && pos + hdr.frame_len_ + 4 <= head.size ()
+          && parse_mpa_header (&head[pos + hdr.frame_len_], next)
+          && hdr.version_ == next.version_ && hdr.layer_ == next.layer_
+          && hdr.samplerate_ == next.samplerate_)
+      {
+        break;
+      }
+    }
+
+    if (pos + 4 > head.size ()
+        || (2 == hdr.layer_ && 1 != hdr.version_))
+    {
+      return false;
+    }
+
+    info.codec_ = (2 == hdr.layer_ ? static_cast< OMX_AUDIO_CODINGTYPE > (
+                                         OMX_AUDIO_CodingMP2)
+                                   : OMX_AUDIO_CodingMP3);
+    info.samplerate_ = hdr.samplerate_;
+    info.nchannels_ = hdr.nchannels_;
+    info.bitrate_ = hdr.bitrate_;
+    info.is_cbr_ = true;
+
+    // A Xing/Info header follows the side information of the first frame; a
+    // VBRI header always comes 32 bytes after the frame header.
+    const size_t side_info
+        = (1 == hdr.version_ ? (2 == hdr.nchannels_ ? 32 : 17)
+                             : (2 == hdr.nchannels_ ? 17 : 9));
+    const size_t xing_pos = pos + 4 + side_info;
+    const size_t vbri_pos = pos + 4 + 32;
+    uint32_t nframes = 0;
+    uint32_t nbytes = 0;
+    if (xing_pos + 16 <= head.size ()
+        && (0 == memcmp (&head[xing_pos], "Xing", 4)
+            || 0 == memcmp (&head[xing_pos], "Info", 4)))
+    {
+      const uint32_t flags = be32 (&head[xing_pos + 4]);
+      size_t field = xing_pos + 8;
+      if (flags & 0x01)
+      {
+        nframes = be32 (&head[field]);
+        field += 4;
+      }
+      if ((flags & 0x02) && field + 4 <= head.size ())
+      {
+        nbytes = be32 (&head[field]);
+      }
+      info.is_cbr_ = (0 == memcmp (&head[xing_pos], "Info", 4));
+    }
+    else if (vbri_pos + 18 <= head.size ()
+             && 0 == memcmp (&head[vbri_pos], "VBRI", 4))
+    {
+      nbytes = be32 (&head[vbri_pos + 10]);
+      nframes = be32 (&head[vbri_pos + 14]);
+      info.is_cbr_ = false;
+    }
+
+    if (!info.is_cbr_ && nframes > 0)
+    {
+      // Average bitrate
+      const double duration
+          = (double)nframes * hdr.samples_per_frame_ / hdr.samplerate_;
+      const double nbits = 8.0 * (nbytes ? nbytes : file_size - pos);
+      info.bitrate_ = (OMX_U32) (nbits / duration);
+    }
+    return true;
+  }
+}  // unnamed namespace
+
+//
+// sniffer
+//
+bool tiz::sniffer::sniff (const std::string &uri, stream_info &info)
+{
+  typedef bool (*sniff_func_t) (const buffer_t &, const long long,
+                                stream_info &);
+  // Formats with a distinctive signature go first; MPEG audio frames may be
+  // preceded by junk, so that is the last resort
+  static const sniff_func_t sniffers[] = {sniff_flac, sniff_ogg,  sniff_wav,
+                                          sniff_aiff, sniff_adts, sniff_mpa};
+  buffer_t head;
+  long long file_size = 0;
+  bool found = false;
+
+  if (read_head (uri, head, file_size))
+  {
+    for (size_t i = 0; !found && i < sizeof (sniffers) / sizeof (sniffers[0]);
+         ++i)
+    {
+      // A sniffer may leave its output half-filled when it gives up
+      stream_info candidate;
+      if ((found = sniffers[i](head, file_size, candidate)))
+      {
+        info = candidate;
+      }
+    }
+  }
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE, "[%s] : %s", uri.c_str (),
+           found ? "recognised" : "not recognised");
+  return found;
+}
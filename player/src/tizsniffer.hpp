@@ -0,0 +1,85 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   tizsniffer.hpp
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Lightweight audio file header parser
+ *
+ *
+ */
+
+#ifndef TIZSNIFFER_HPP
+#define TIZSNIFFER_HPP
+
+#include <string>
+
+#include <OMX_Core.h>
+#include <OMX_Audio.h>
+#include <OMX_Component.h>
+#include <OMX_TizoniaExt.h>
+
+namespace tiz
+{
+  /**
+   * Identifies the codec and stream properties of a local audio file by
+   * parsing only its first few kilobytes. The following are recognised: MPEG
+   * audio layer II/III (with Xing/Info or VBRI headers), ADTS AAC, FLAC, Ogg
+   * (Vorbis, Opus and FLAC), RIFF/WAVE and AIFF.
+   */
+  class sniffer
+  {
+
+  public:
+    struct stream_info
+    {
+      stream_info ()
+        : container_ (OMX_FORMAT_RAW),
+          codec_ (OMX_AUDIO_CodingUnused),
+          samplerate_ (48000),
+          bitrate_ (0),
+          nchannels_ (2),
+          bitdepth_ (16),
+          endianness_ (OMX_EndianLittle),
+          sign_ (OMX_NumericalDataSigned),
+          is_cbr_ (false)
+      {
+      }
+      OMX_MEDIACONTAINER_FORMATTYPE container_;
+      OMX_AUDIO_CODINGTYPE codec_;
+      OMX_U32 samplerate_;
+      OMX_U32 bitrate_;
+      OMX_U32 nchannels_;
+      OMX_U32 bitdepth_;
+      OMX_ENDIANTYPE endianness_;
+      OMX_NUMERICALDATATYPE sign_;
+      bool is_cbr_;
+    };
+
+  public:
+    /**
+     * @return true if the file was recognised and @a info filled in, false
+     * if the file needs a full probe.
+     */
+    static bool sniff (const std::string &uri, stream_info &info);
+  };
+}  // namespace tiz
+
+#endif  // TIZSNIFFER_HPP
@@ -469,14 +469,15 @@ static OMX_ERRORTYPE transform_buffer (aacdec_prc_t *ap_prc)
 
       if ((ap_prc->aac_info_.error == 0) && (ap_prc->aac_info_.samples > 0))
         {
-          int i = 0;
-          char *p_data = (char *)(p_out->pBuffer + p_out->nOffset);
-          for (i = 0; i < ap_prc->aac_info_.samples; ++i)
-            {
-              p_data[i * 2] = (char)(p_sample_buf[i] & 0xFF);
-              p_data[i * 2 + 1] = (char)((p_sample_buf[i] >> 8) & 0xFF);
-            }
-          p_out->nFilledLen = ap_prc->aac_info_.samples * ap_prc->channels_ * 1;
+          /* FAAD's samples are interleaved, in host byte order; the output
+             port's are little-endian */
+          const size_t nbytes = ap_prc->aac_info_.samples * sizeof (int16_t);
+          OMX_U8 *p_data = p_out->pBuffer + p_out->nOffset;
+          memcpy (p_data, p_sample_buf, nbytes);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+          tiz_dsp_bswap16 (p_data, ap_prc->aac_info_.samples);
+#endif
+          p_out->nFilledLen = nbytes;
         }
       else if (ap_prc->aac_info_.error != 0)
         {
@@ -646,6 +647,27 @@ static OMX_ERRORTYPE aacdec_prc_buffers_ready (const void *ap_prc)
   return rc;
 }
 
+static OMX_ERRORTYPE aacdec_prc_port_flush (const void *ap_prc, OMX_U32 a_pid)
+{
+  aacdec_prc_t *p_prc = (aacdec_prc_t *)ap_prc;
+  assert (p_prc);
+  if (OMX_ALL == a_pid || ARATELIA_AAC_DECODER_INPUT_PORT_INDEX == a_pid)
+    {
+      /* Drop the buffered input and the decoder's overlap state, so that
+         decoding resumes cleanly on the next frame (e.g. after a seek) */
+      if (p_prc->p_store_)
+        {
+          tiz_buffer_clear (p_prc->p_store_);
+        }
+      if (p_prc->first_buffer_read_ && p_prc->p_aac_dec_)
+        {
+          NeAACDecPostSeekReset (p_prc->p_aac_dec_, 0);
+        }
+      tiz_filter_prc_update_eos_flag (p_prc, false);
+    }
+  return tiz_filter_prc_release_header (p_prc, a_pid);
+}
+
 static OMX_ERRORTYPE aacdec_prc_port_enable (const void *ap_prc, OMX_U32 a_pid)
 {
   aacdec_prc_t *p_prc = (aacdec_prc_t *)ap_prc;
@@ -720,6 +742,8 @@ void *aacdec_prc_init (void *ap_tos, void *ap_hdl)
        /* TIZ_CLASS_COMMENT: */
        tiz_prc_port_enable, aacdec_prc_port_enable,
        /* TIZ_CLASS_COMMENT: */
+       tiz_prc_port_flush, aacdec_prc_port_flush,
+       /* TIZ_CLASS_COMMENT: */
        tiz_prc_port_disable, aacdec_prc_port_disable,
        /* TIZ_CLASS_COMMENT: stop value */
        0);
@@ -139,8 +139,10 @@ instantiate_other_port (OMX_HANDLETYPE ap_hdl)
 static OMX_PTR
 instantiate_config_port (OMX_HANDLETYPE ap_hdl)
 {
-  /* Instantiate the config port */
-  return factory_new (tiz_get_type (ap_hdl, "tizuricfgport"),
+  /* Instantiate the config port. The demuxer config port adds
+     OMX_IndexConfigTimePosition and OMX_IndexConfigTimeSeekMode to the indexes
+     handled by the uri config port. */
+  return factory_new (tiz_get_type (ap_hdl, "tizdemuxercfgport"),
                       NULL, /* this port does not take options */
                       ARATELIA_FILE_READER_COMPONENT_NAME, file_reader_version);
 }
@@ -0,0 +1,1034 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   frindex.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Binary file reader's time-to-byte seek index
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <tizplatform.h>
+#include <tizutils.h>
+
+#include "frindex.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.file_reader.index"
+#endif
+
+/* How far past the stream headers to look for the first frame */
+#define FR_INDEX_MAX_SYNC_SEARCH (64 * 1024)
+/* How many frames are averaged to estimate the length of a frame */
+#define FR_INDEX_CALIBRATION_FRAMES 64
+/* How far past an estimated offset to look for a frame boundary; enough for
+ * a few of the largest ADTS frames */
+#define FR_INDEX_RESYNC_WINDOW (32 * 1024)
+#define FR_INDEX_INITIAL_POINTS 256
+/* Large enough for the first MPEG audio frame's Xing or VBRI header */
+#define FR_INDEX_FIRST_FRAME_PEEK 192
+
+typedef enum fr_index_format
+{
+  EFrIndexFormatUnknown = 0,
+  EFrIndexFormatMpegAudio,
+  EFrIndexFormatAdts,
+  EFrIndexFormatFlac,
+  EFrIndexFormatWav
+} fr_index_format_t;
+
+typedef enum fr_index_mode
+{
+  /* No entries; offsets are estimated from the average frame length and
+   * the stream is resynchronised on the next frame header */
+  EFrIndexModeResync = 0,
+  /* Entries are frame boundaries, but frames can't be walked (FLAC) */
+  EFrIndexModeSeekPoints,
+  /* Entries sample a time/offset curve that must be interpolated */
+  EFrIndexModeInterpolate
+} fr_index_mode_t;
+
+typedef struct fr_index_point fr_index_point_t;
+struct fr_index_point
+{
+  OMX_U64 sample_;
+  long offset_;
+};
+
+typedef struct fr_index_frame fr_index_frame_t;
+struct fr_index_frame
+{
+  OMX_U32 length_;
+  OMX_U32 samples_;
+  OMX_U32 sample_rate_;
+};
+
+struct fr_index
+{
+  OMX_HANDLETYPE p_hdl_;
+  FILE * p_file_;
+  fr_index_format_t format_;
+  fr_index_mode_t mode_;
+  long data_start_;
+  long data_end_;
+  OMX_U32 sample_rate_;
+  OMX_U32 block_align_;
+  OMX_U64 total_samples_;
+  fr_index_point_t * p_points_;
+  size_t num_points_;
+  size_t max_points_;
+  double frame_bytes_;
+  OMX_U32 frame_samples_;
+};
+
+static const OMX_U16 mpa_bitrates[2][3][15] = {
+  {/* MPEG-1 layers I, II and III */
+   {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+   {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+   {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320}},
+  {/* MPEG-2 and MPEG-2.5 layers I, II and III */
+   {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+   {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+   {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}}};
+
+static const OMX_U32 mpa_sample_rates[3][3] = {{44100, 48000, 32000},
+                                                {22050, 24000, 16000},
+                                                {11025, 12000, 8000}};
+
+static const OMX_U32 adts_sample_rates[13]
+  = {96000, 88200, 64000, 48000, 44100, 32000, 24000,
+     22050, 16000, 12000, 11025, 8000,  7350};
+
+static inline OMX_U32
+be16 (const OMX_U8 * ap_data)
+{
+  return ((OMX_U32) ap_data[0] << 8) | ap_data[1];
+}
+
+static inline OMX_U32
+be32 (const OMX_U8 * ap_data)
+{
+  return ((OMX_U32) ap_data[0] << 24) | ((OMX_U32) ap_data[1] << 16)
+         | ((OMX_U32) ap_data[2] << 8) | ap_data[3];
+}
+
+static inline OMX_U64
+be64 (const OMX_U8 * ap_data)
+{
+  return ((OMX_U64) be32 (ap_data) << 32) | be32 (ap_data + 4);
+}
+
+static inline OMX_U32
+le16 (const OMX_U8 * ap_data)
+{
+  return ((OMX_U32) ap_data[1] << 8) | ap_data[0];
+}
+
+static inline OMX_U32
+le32 (const OMX_U8 * ap_data)
+{
+  return ((OMX_U32) ap_data[3] << 24) | ((OMX_U32) ap_data[2] << 16)
+         | ((OMX_U32) ap_data[1] << 8) | ap_data[0];
+}
+
+static inline OMX_TICKS
+samples_to_time (const fr_index_t * ap_idx, const OMX_U64 a_samples)
+{
+  assert (ap_idx);
+  assert (ap_idx->sample_rate_ > 0);
+  return (OMX_TICKS) (a_samples * OMX_TICKS_PER_SECOND
+                      / ap_idx->sample_rate_);
+}
+
+static inline OMX_U64
+time_to_samples (const fr_index_t * ap_idx, const OMX_TICKS a_time)
+{
+  assert (ap_idx);
+  return a_time <= 0 ? 0 : ((OMX_U64) a_time * ap_idx->sample_rate_
+                            / OMX_TICKS_PER_SECOND);
+}
+
+static bool
+read_at (fr_index_t * ap_idx, const long a_offset, OMX_U8 * ap_buf,
+         const size_t a_len)
+{
+  assert (ap_idx);
+  assert (ap_buf);
+  return (0 == fseek (ap_idx->p_file_, a_offset, SEEK_SET)
+          && a_len == fread (ap_buf, 1, a_len, ap_idx->p_file_));
+}
+
+static OMX_ERRORTYPE
+add_point (fr_index_t * ap_idx, const OMX_U64 a_sample, const long a_offset)
+{
+  assert (ap_idx);
+  if (ap_idx->num_points_ == ap_idx->max_points_)
+    {
+      const size_t max_points = ap_idx->max_points_ > 0
+                                  ? ap_idx->max_points_ * 2
+                                  : FR_INDEX_INITIAL_POINTS;
+      fr_index_point_t * p_points = tiz_mem_realloc (
+        ap_idx->p_points_, max_points * sizeof (fr_index_point_t));
+      tiz_check_null_ret_oom (p_points);
+      ap_idx->p_points_ = p_points;
+      ap_idx->max_points_ = max_points;
+    }
+  ap_idx->p_points_[ap_idx->num_points_].sample_ = a_sample;
+  ap_idx->p_points_[ap_idx->num_points_].offset_ = a_offset;
+  ap_idx->num_points_++;
+  return OMX_ErrorNone;
+}
+
+/* Returns the last entry whose sample is not greater than a_sample */
+static size_t
+find_point_by_sample (const fr_index_t * ap_idx, const OMX_U64 a_sample)
+{
+  size_t lo = 0;
+  size_t hi = 0;
+  assert (ap_idx);
+  assert (ap_idx->num_points_ > 0);
+  hi = ap_idx->num_points_ - 1;
+  while (lo < hi)
+    {
+      const size_t mid = lo + (hi - lo + 1) / 2;
+      if (ap_idx->p_points_[mid].sample_ <= a_sample)
+        {
+          lo = mid;
+        }
+      else
+        {
+          hi = mid - 1;
+        }
+    }
+  return lo;
+}
+
+/* Returns the last entry whose offset is not greater than a_offset */
+static size_t
+find_point_by_offset (const fr_index_t * ap_idx, const long a_offset)
+{
+  size_t lo = 0;
+  size_t hi = 0;
+  assert (ap_idx);
+  assert (ap_idx->num_points_ > 0);
+  hi = ap_idx->num_points_ - 1;
+  while (lo < hi)
+    {
+      const size_t mid = lo + (hi - lo + 1) / 2;
+      if (ap_idx->p_points_[mid].offset_ <= a_offset)
+        {
+          lo = mid;
+        }
+      else
+        {
+          hi = mid - 1;
+        }
+    }
+  return lo;
+}
+
+static bool
+parse_mpa_header (const OMX_U8 * ap_hdr, fr_index_frame_t * ap_frame)
+{
+  /* version: 0 = MPEG-2.5, 1 = reserved, 2 = MPEG-2, 3 = MPEG-1 */
+  const OMX_U32 version = (ap_hdr[1] >> 3) & 0x03;
+  /* layer: 1 = I, 2 = II, 3 = III, 4 = reserved */
+  const OMX_U32 layer = 4 - ((ap_hdr[1] >> 1) & 0x03);
+  const OMX_U32 br_idx = ap_hdr[2] >> 4;
+  const OMX_U32 sr_idx = (ap_hdr[2] >> 2) & 0x03;
+  const OMX_U32 padding = (ap_hdr[2] >> 1) & 0x01;
+  OMX_U32 lsf = 0;
+  OMX_U32 bitrate = 0;
+
+  assert (ap_frame);
+
+  if (0xFF != ap_hdr[0] || 0xE0 != (ap_hdr[1] & 0xE0) || 1 == version
+      || 4 == layer || 0 == br_idx || 15 == br_idx || 3 == sr_idx)
+    {
+      return false;
+    }
+
+  lsf = (3 == version) ? 0 : 1;
+  bitrate = mpa_bitrates[lsf][layer - 1][br_idx] * 1000;
+  ap_frame->sample_rate_
+    = mpa_sample_rates[3 == version ? 0 : (2 == version ? 1 : 2)][sr_idx];
+
+  if (1 == layer)
+    {
+      ap_frame->samples_ = 384;
+      ap_frame->length_
+        = (12 * bitrate / ap_frame->sample_rate_ + padding) * 4;
+    }
+  else
+    {
+      ap_frame->samples_ = (3 == layer && lsf) ? 576 : 1152;
+      ap_frame->length_
+        = ap_frame->samples_ / 8 * bitrate / ap_frame->sample_rate_ + padding;
+    }
+
+  return true;
+}
+
+static bool
+parse_adts_header (const OMX_U8 * ap_hdr, fr_index_frame_t * ap_frame)
+{
+  const OMX_U32 sr_idx = (ap_hdr[2] >> 2) & 0x0F;
+
+  assert (ap_frame);
+
+  if (0xFF != ap_hdr[0] || 0xF0 != (ap_hdr[1] & 0xF6) || sr_idx >= 13)
+    {
+      return false;
+    }
+
+  ap_frame->length_ = ((OMX_U32) (ap_hdr[3] & 0x03) << 11)
+                      | ((OMX_U32) ap_hdr[4] << 3) | (ap_hdr[5] >> 5);
+  ap_frame->samples_ = 1024 * ((ap_hdr[6] & 0x03) + 1);
+  ap_frame->sample_rate_ = adts_sample_rates[sr_idx];
+
+  /* 7 bytes is the size of the ADTS header without CRC */
+  return ap_frame->length_ >= 7;
+}
+
+static bool
+parse_frame_header (const fr_index_format_t a_format, const OMX_U8 * ap_hdr,
+                    fr_index_frame_t * ap_frame)
+{
+  if (EFrIndexFormatMpegAudio == a_format)
+    {
+      return parse_mpa_header (ap_hdr, ap_frame);
+    }
+  else if (EFrIndexFormatAdts == a_format)
+    {
+      return parse_adts_header (ap_hdr, ap_frame);
+    }
+  return false;
+}
+
+static long
+skip_id3v2_tags (fr_index_t * ap_idx)
+{
+  OMX_U8 hdr[10];
+  long offset = 0;
+  assert (ap_idx);
+  while (read_at (ap_idx, offset, hdr, sizeof (hdr))
+         && 0 == memcmp (hdr, "ID3", 3))
+    {
+      /* Tag size is a 28-bit synchsafe integer. Add 10 bytes for the header
+       * and another 10 if there is a footer */
+      offset += 10
+                + (((long) (hdr[6] & 0x7F) << 21) | ((hdr[7] & 0x7F) << 14)
+                   | ((hdr[8] & 0x7F) << 7) | (hdr[9] & 0x7F))
+                + ((hdr[5] & 0x10) ? 10 : 0);
+    }
+  return offset;
+}
+
+/* Search for two consecutive MPEG audio or ADTS frames, to avoid being fooled
+ * by false syncs. */
+static bool
+find_first_frame (fr_index_t * ap_idx, const long a_start,
+                  long * ap_frame_offset, fr_index_frame_t * ap_frame)
+{
+  const fr_index_format_t formats[]
+    = {EFrIndexFormatMpegAudio, EFrIndexFormatAdts};
+  OMX_U8 * p_buf = NULL;
+  size_t len = 0;
+  size_t i = 0;
+  size_t j = 0;
+  bool found = false;
+
+  assert (ap_idx);
+  assert (ap_frame_offset);
+  assert (ap_frame);
+
+  if (!(p_buf = tiz_mem_alloc (FR_INDEX_MAX_SYNC_SEARCH)))
+    {
+      return false;
+    }
+
+  if (0 == fseek (ap_idx->p_file_, a_start, SEEK_SET))
+    {
+      len = fread (p_buf, 1, FR_INDEX_MAX_SYNC_SEARCH, ap_idx->p_file_);
+    }
+
+  for (i = 0; !found && i + 7 <= len; ++i)
+    {
+      for (j = 0; !found && j < sizeof (formats) / sizeof (formats[0]); ++j)
+        {
+          fr_index_frame_t next;
+          if (parse_frame_header (formats[j], p_buf + i, ap_frame)
+              && (i + ap_frame->length_ + 7 > len
+                  || (parse_frame_header (formats[j],
+                                          p_buf + i + ap_frame->length_, &next)
+                      && next.sample_rate_ == ap_frame->sample_rate_)))
+            {
+              ap_idx->format_ = formats[j];
+              *ap_frame_offset = a_start + (long) i;
+              found = true;
+            }
+        }
+    }
+
+  tiz_mem_free (p_buf);
+  return found;
+}
+
+/* Averages the length of the first frames of the stream. This is exact for
+ * CBR streams, which is what most MPEG audio files without a Xing or VBRI
+ * header are. */
+static OMX_ERRORTYPE
+calibrate_frame_stream (fr_index_t * ap_idx, const fr_index_frame_t * ap_first)
+{
+  OMX_U8 * p_buf = NULL;
+  size_t len = 0;
+  size_t pos = 0;
+  OMX_U32 frames = 0;
+  fr_index_frame_t frame;
+
+  assert (ap_idx);
+  assert (ap_first);
+
+  tiz_check_null_ret_oom ((p_buf = tiz_mem_alloc (FR_INDEX_MAX_SYNC_SEARCH)));
+  if (0 == fseek (ap_idx->p_file_, ap_idx->data_start_, SEEK_SET))
+    {
+      len = fread (p_buf, 1, FR_INDEX_MAX_SYNC_SEARCH, ap_idx->p_file_);
+    }
+
+  while (frames < FR_INDEX_CALIBRATION_FRAMES && pos + 7 <= len
+         && parse_frame_header (ap_idx->format_, p_buf + pos, &frame)
+         && frame.sample_rate_ == ap_idx->sample_rate_
+         && pos + frame.length_ <= len)
+    {
+      pos += frame.length_;
+      frames++;
+    }
+  tiz_mem_free (p_buf);
+
+  ap_idx->frame_samples_ = ap_first->samples_;
+  ap_idx->frame_bytes_
+    = frames > 0 ? (double) pos / frames : (double) ap_first->length_;
+  ap_idx->total_samples_
+    = (OMX_U64) ((ap_idx->data_end_ - ap_idx->data_start_)
+                 / ap_idx->frame_bytes_)
+      * ap_idx->frame_samples_;
+
+  TIZ_DEBUG (ap_idx->p_hdl_,
+             "Frame stream : average frame [%.2f bytes] samples [%llu]",
+             ap_idx->frame_bytes_,
+             (unsigned long long) ap_idx->total_samples_);
+  return OMX_ErrorNone;
+}
+
+/* Finds the first frame boundary at or after a_offset, confirmed by the
+ * header of the frame that follows it (or by the end of the data). Only a
+ * small window of the file is read. */
+static bool
+resync_frame (fr_index_t * ap_idx, const long a_offset, long * ap_frame_offset)
+{
+  OMX_U8 * p_buf = NULL;
+  size_t len = 0;
+  size_t i = 0;
+  bool found = false;
+
+  assert (ap_idx);
+  assert (ap_frame_offset);
+
+  if (!(p_buf = tiz_mem_alloc (FR_INDEX_RESYNC_WINDOW)))
+    {
+      return false;
+    }
+
+  if (0 == fseek (ap_idx->p_file_, a_offset, SEEK_SET))
+    {
+      len = fread (p_buf, 1, FR_INDEX_RESYNC_WINDOW, ap_idx->p_file_);
+    }
+
+  for (i = 0; !found && i + 7 <= len; ++i)
+    {
+      fr_index_frame_t frame;
+      fr_index_frame_t next;
+      if (parse_frame_header (ap_idx->format_, p_buf + i, &frame)
+          && frame.sample_rate_ == ap_idx->sample_rate_
+          && (a_offset + (long) (i + frame.length_) >= ap_idx->data_end_
+              || (i + frame.length_ + 7 <= len
+                  && parse_frame_header (ap_idx->format_,
+                                         p_buf + i + frame.length_, &next)
+                  && next.sample_rate_ == ap_idx->sample_rate_)))
+        {
+          *ap_frame_offset = a_offset + (long) i;
+          found = true;
+        }
+    }
+
+  tiz_mem_free (p_buf);
+  return found;
+}
+
+/* The sample at which the frame that starts at a_offset begins */
+static OMX_U64
+frame_offset_to_sample (const fr_index_t * ap_idx, const long a_offset)
+{
+  assert (ap_idx);
+  assert (ap_idx->frame_bytes_ > 0);
+  if (a_offset <= ap_idx->data_start_)
+    {
+      return 0;
+    }
+  return (OMX_U64) ((a_offset - ap_idx->data_start_) / ap_idx->frame_bytes_
+                    + 0.5)
+         * ap_idx->frame_samples_;
+}
+
+static OMX_ERRORTYPE
+init_mpa_toc (fr_index_t * ap_idx, const OMX_U8 * ap_toc,
+              const OMX_U32 a_frames, const OMX_U32 a_samples_per_frame,
+              const long a_bytes)
+{
+  OMX_U32 i = 0;
+  assert (ap_idx);
+  ap_idx->mode_ = EFrIndexModeInterpolate;
+  ap_idx->total_samples_ = (OMX_U64) a_frames * a_samples_per_frame;
+  if (ap_toc)
+    {
+      for (i = 0; i < 100; ++i)
+        {
+          tiz_check_omx (add_point (
+            ap_idx, ap_idx->total_samples_ * i / 100,
+            ap_idx->data_start_ + (long) ((double) ap_toc[i] * a_bytes / 256)));
+        }
+    }
+  else
+    {
+      tiz_check_omx (add_point (ap_idx, 0, ap_idx->data_start_));
+    }
+  return add_point (ap_idx, ap_idx->total_samples_,
+                    ap_idx->data_start_ + a_bytes);
+}
+
+static OMX_ERRORTYPE
+init_mpa_vbri (fr_index_t * ap_idx, const OMX_U8 * ap_vbri,
+               const OMX_U32 a_samples_per_frame, const long a_vbri_offset)
+{
+  const long bytes = be32 (ap_vbri + 10);
+  const OMX_U32 frames = be32 (ap_vbri + 14);
+  const OMX_U32 entries = be16 (ap_vbri + 18);
+  const OMX_U32 scale = be16 (ap_vbri + 20);
+  const OMX_U32 entry_size = be16 (ap_vbri + 22);
+  const OMX_U32 frames_per_entry = be16 (ap_vbri + 24);
+  OMX_U8 * p_table = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  long offset = ap_idx->data_start_;
+  OMX_U32 i = 0;
+
+  if (0 == entries || 0 == entry_size || entry_size > 4)
+    {
+      return init_mpa_toc (ap_idx, NULL, frames, a_samples_per_frame, bytes);
+    }
+
+  tiz_check_null_ret_oom ((p_table = tiz_mem_alloc (entries * entry_size)));
+  if (!read_at (ap_idx, a_vbri_offset + 26, p_table, entries * entry_size))
+    {
+      tiz_mem_free (p_table);
+      return init_mpa_toc (ap_idx, NULL, frames, a_samples_per_frame, bytes);
+    }
+
+  ap_idx->mode_ = EFrIndexModeInterpolate;
+  ap_idx->total_samples_ = (OMX_U64) frames * a_samples_per_frame;
+  for (i = 0; i < entries && OMX_ErrorNone == rc; ++i)
+    {
+      const OMX_U8 * p_entry = p_table + i * entry_size;
+      OMX_U32 entry = 0;
+      OMX_U32 k = 0;
+      rc = add_point (
+        ap_idx, (OMX_U64) i * frames_per_entry * a_samples_per_frame, offset);
+      for (k = 0; k < entry_size; ++k)
+        {
+          entry = (entry << 8) | p_entry[k];
+        }
+      offset += (long) entry * scale;
+    }
+  tiz_mem_free (p_table);
+  tiz_check_omx (rc);
+
+  return add_point (ap_idx, ap_idx->total_samples_,
+                    ap_idx->data_start_ + bytes);
+}
+
+static OMX_ERRORTYPE
+init_frame_stream (fr_index_t * ap_idx, const long a_start)
+{
+  fr_index_frame_t frame;
+  OMX_U8 peek[FR_INDEX_FIRST_FRAME_PEEK];
+  long frame_offset = 0;
+
+  assert (ap_idx);
+
+  if (!find_first_frame (ap_idx, a_start, &frame_offset, &frame))
+    {
+      return OMX_ErrorFormatNotDetected;
+    }
+
+  ap_idx->sample_rate_ = frame.sample_rate_;
+
+  memset (peek, 0, sizeof (peek));
+  if (EFrIndexFormatMpegAudio == ap_idx->format_
+      && read_at (ap_idx, frame_offset, peek, sizeof (peek)))
+    {
+      const bool is_mpeg1 = (3 == ((peek[1] >> 3) & 0x03));
+      const bool is_mono = (3 == (peek[3] >> 6));
+      const size_t xing = is_mpeg1 ? (is_mono ? 21 : 36) : (is_mono ? 13 : 21);
+
+      if (0 == memcmp (peek + xing, "Xing", 4)
+          || 0 == memcmp (peek + xing, "Info", 4))
+        {
+          const OMX_U32 flags = be32 (peek + xing + 4);
+          const OMX_U8 * p_field = peek + xing + 8;
+          OMX_U32 frames = 0;
+          long bytes = ap_idx->data_end_ - frame_offset - frame.length_;
+          const OMX_U8 * p_toc = NULL;
+
+          /* The Xing frame does not carry audio */
+          ap_idx->data_start_ = frame_offset + frame.length_;
+          if (flags & 0x1)
+            {
+              frames = be32 (p_field);
+              p_field += 4;
+            }
+          if (flags & 0x2)
+            {
+              bytes = be32 (p_field);
+              p_field += 4;
+            }
+          if (flags & 0x4)
+            {
+              p_toc = p_field;
+            }
+          if (frames > 0)
+            {
+              TIZ_DEBUG (ap_idx->p_hdl_, "Xing header : frames [%u] toc [%s]",
+                         (unsigned) frames, p_toc ? "YES" : "NO");
+              return init_mpa_toc (ap_idx, p_toc, frames, frame.samples_,
+                                   bytes);
+            }
+        }
+      else if (0 == memcmp (peek + 36, "VBRI", 4))
+        {
+          TIZ_DEBUG (ap_idx->p_hdl_, "VBRI header found");
+          ap_idx->data_start_ = frame_offset + frame.length_;
+          return init_mpa_vbri (ap_idx, peek + 36, frame.samples_,
+                                frame_offset + 36);
+        }
+    }
+
+  /* No table of contents available; seeks estimate the offset from the
+   * average frame length and resync on the next frame header, so that their
+   * cost does not depend on the size of the file */
+  ap_idx->mode_ = EFrIndexModeResync;
+  ap_idx->data_start_ = frame_offset;
+  return calibrate_frame_stream (ap_idx, &frame);
+}
+
+static OMX_ERRORTYPE
+init_flac (fr_index_t * ap_idx, const long a_start)
+{
+  OMX_U8 hdr[4];
+  OMX_U8 info[18];
+  long offset = a_start + 4; /* skip the "fLaC" marker */
+  long seektable_offset = 0;
+  OMX_U32 seektable_len = 0;
+  bool is_last = false;
+
+  assert (ap_idx);
+
+  while (!is_last)
+    {
+      OMX_U32 type = 0;
+      OMX_U32 len = 0;
+      if (!read_at (ap_idx, offset, hdr, sizeof (hdr)))
+        {
+          return OMX_ErrorFormatNotDetected;
+        }
+      is_last = (hdr[0] & 0x80) != 0;
+      type = hdr[0] & 0x7F;
+      len = ((OMX_U32) hdr[1] << 16) | ((OMX_U32) hdr[2] << 8) | hdr[3];
+      if (0 == type && len >= sizeof (info)
+          && read_at (ap_idx, offset + 4, info, sizeof (info)))
+        {
+          /* STREAMINFO */
+          ap_idx->sample_rate_ = ((OMX_U32) info[10] << 12)
+                                 | ((OMX_U32) info[11] << 4) | (info[12] >> 4);
+          ap_idx->total_samples_
+            = ((OMX_U64) (info[13] & 0x0F) << 32) | be32 (info + 14);
+        }
+      else if (3 == type)
+        {
+          /* SEEKTABLE */
+          seektable_offset = offset + 4;
+          seektable_len = len;
+        }
+      offset += 4 + (long) len;
+    }
+
+  if (0 == ap_idx->sample_rate_)
+    {
+      return OMX_ErrorFormatNotDetected;
+    }
+
+  ap_idx->data_start_ = offset;
+  tiz_check_omx (add_point (ap_idx, 0, ap_idx->data_start_));
+
+  if (seektable_len >= 18)
+    {
+      OMX_U8 * p_table = NULL;
+      OMX_ERRORTYPE rc = OMX_ErrorNone;
+      OMX_U32 i = 0;
+      tiz_check_null_ret_oom ((p_table = tiz_mem_alloc (seektable_len)));
+      if (read_at (ap_idx, seektable_offset, p_table, seektable_len))
+        {
+          for (i = 0; i + 18 <= seektable_len && OMX_ErrorNone == rc; i += 18)
+            {
+              const OMX_U64 sample = be64 (p_table + i);
+              const OMX_U64 sample_offset = be64 (p_table + i + 8);
+              /* Skip placeholders and out-of-order points */
+              if (sample != 0xFFFFFFFFFFFFFFFFULL
+                  && sample > ap_idx->p_points_[ap_idx->num_points_ - 1].sample_)
+                {
+                  rc = add_point (ap_idx, sample,
+                                  ap_idx->data_start_ + (long) sample_offset);
+                }
+            }
+        }
+      tiz_mem_free (p_table);
+      tiz_check_omx (rc);
+    }
+
+  if (ap_idx->num_points_ > 1)
+    {
+      ap_idx->mode_ = EFrIndexModeSeekPoints;
+    }
+  else if (ap_idx->total_samples_ > 0)
+    {
+      /* No SEEKTABLE; the FLAC decoder will re-sync on the next frame */
+      ap_idx->mode_ = EFrIndexModeInterpolate;
+      tiz_check_omx (
+        add_point (ap_idx, ap_idx->total_samples_, ap_idx->data_end_));
+    }
+  else
+    {
+      return OMX_ErrorFormatNotDetected;
+    }
+
+  TIZ_DEBUG (ap_idx->p_hdl_, "FLAC : seek points [%u] total samples [%llu]",
+             (unsigned) ap_idx->num_points_,
+             (unsigned long long) ap_idx->total_samples_);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+init_wav (fr_index_t * ap_idx, const long a_start)
+{
+  OMX_U8 chunk[8];
+  OMX_U8 fmt[16];
+  long offset = a_start + 12; /* skip the RIFF header */
+
+  assert (ap_idx);
+
+  while (read_at (ap_idx, offset, chunk, sizeof (chunk)))
+    {
+      const OMX_U32 size = le32 (chunk + 4);
+      if (0 == memcmp (chunk, "fmt ", 4) && size >= sizeof (fmt)
+          && read_at (ap_idx, offset + 8, fmt, sizeof (fmt)))
+        {
+          ap_idx->sample_rate_ = le32 (fmt + 4);
+          ap_idx->block_align_ = le16 (fmt + 12);
+        }
+      else if (0 == memcmp (chunk, "data", 4))
+        {
+          ap_idx->data_start_ = offset + 8;
+          if ((long) size < ap_idx->data_end_ - ap_idx->data_start_)
+            {
+              ap_idx->data_end_ = ap_idx->data_start_ + (long) size;
+            }
+          break;
+        }
+      offset += 8 + (long) size + (size & 1);
+    }
+
+  if (0 == ap_idx->sample_rate_ || 0 == ap_idx->block_align_
+      || 0 == ap_idx->data_start_)
+    {
+      return OMX_ErrorFormatNotDetected;
+    }
+
+  ap_idx->mode_ = EFrIndexModeInterpolate;
+  ap_idx->total_samples_
+    = (ap_idx->data_end_ - ap_idx->data_start_) / ap_idx->block_align_;
+  tiz_check_omx (add_point (ap_idx, 0, ap_idx->data_start_));
+  return add_point (ap_idx, ap_idx->total_samples_,
+                    ap_idx->data_start_
+                      + (long) (ap_idx->total_samples_ * ap_idx->block_align_));
+}
+
+static OMX_ERRORTYPE
+detect_format (fr_index_t * ap_idx)
+{
+  OMX_U8 magic[12];
+  long start = 0;
+
+  assert (ap_idx);
+
+  start = skip_id3v2_tags (ap_idx);
+  if (read_at (ap_idx, start, magic, sizeof (magic)))
+    {
+      if (0 == memcmp (magic, "fLaC", 4))
+        {
+          ap_idx->format_ = EFrIndexFormatFlac;
+          return init_flac (ap_idx, start);
+        }
+      else if (0 == memcmp (magic, "RIFF", 4)
+               && 0 == memcmp (magic + 8, "WAVE", 4))
+        {
+          ap_idx->format_ = EFrIndexFormatWav;
+          return init_wav (ap_idx, start);
+        }
+    }
+
+  return init_frame_stream (ap_idx, start);
+}
+
+/* Find the frame that contains a_sample by estimating its offset, backing
+ * off by one frame to absorb the estimation error, resynchronising on the next
+ * frame header and, if a_accurate, walking the few frames that separate it
+ * from the target. */
+static void
+resync_time_to_offset (fr_index_t * ap_idx, const OMX_U64 a_sample,
+                       const bool a_accurate, long * ap_offset,
+                       OMX_U64 * ap_sample)
+{
+  long estimate = 0;
+  long offset = 0;
+  OMX_U64 sample = 0;
+
+  assert (ap_idx);
+  assert (ap_offset);
+  assert (ap_sample);
+
+  estimate = ap_idx->data_start_
+             + (long) (((double) (a_sample / ap_idx->frame_samples_) - 1)
+                       * ap_idx->frame_bytes_);
+  if (estimate < ap_idx->data_start_)
+    {
+      estimate = ap_idx->data_start_;
+    }
+
+  if (!resync_frame (ap_idx, estimate, &offset))
+    {
+      /* Probably past the last frame; the decoder will find out */
+      *ap_offset = estimate;
+      *ap_sample = frame_offset_to_sample (ap_idx, estimate);
+      return;
+    }
+
+  sample = frame_offset_to_sample (ap_idx, offset);
+  if (a_accurate)
+    {
+      OMX_U8 hdr[7];
+      fr_index_frame_t frame;
+      while (read_at (ap_idx, offset, hdr, sizeof (hdr))
+             && parse_frame_header (ap_idx->format_, hdr, &frame)
+             && sample + frame.samples_ <= a_sample)
+        {
+          offset += frame.length_;
+          sample += frame.samples_;
+        }
+    }
+
+  *ap_offset = offset;
+  *ap_sample = sample;
+}
+
+OMX_ERRORTYPE
+fr_index_init (fr_index_ptr_t * app_idx, OMX_HANDLETYPE ap_hdl,
+               const char * ap_path)
+{
+  fr_index_t * p_idx = NULL;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (app_idx);
+  assert (ap_path);
+
+  tiz_check_null_ret_oom ((p_idx = tiz_mem_calloc (1, sizeof (fr_index_t))));
+  p_idx->p_hdl_ = ap_hdl;
+
+  if (!(p_idx->p_file_ = fopen (ap_path, "r")))
+    {
+      TIZ_ERROR (ap_hdl, "Error opening file from URI (%s)", strerror (errno));
+      tiz_mem_free (p_idx);
+      return OMX_ErrorContentURIError;
+    }
+
+  if (0 == fseek (p_idx->p_file_, 0, SEEK_END))
+    {
+      p_idx->data_end_ = ftell (p_idx->p_file_);
+    }
+
+  if (OMX_ErrorNone != (rc = detect_format (p_idx)))
+    {
+      TIZ_NOTICE (ap_hdl, "[%s] : Stream is not seekable",
+                  tiz_err_to_str (rc));
+      fr_index_destroy (p_idx);
+      p_idx = NULL;
+    }
+
+  *app_idx = p_idx;
+  return rc;
+}
+
+void
+fr_index_destroy (fr_index_t * ap_idx)
+{
+  if (ap_idx)
+    {
+      if (ap_idx->p_file_)
+        {
+          (void) fclose (ap_idx->p_file_);
+        }
+      tiz_mem_free (ap_idx->p_points_);
+      tiz_mem_free (ap_idx);
+    }
+}
+
+OMX_ERRORTYPE
+fr_index_time_to_offset (fr_index_t * ap_idx, OMX_TICKS a_time,
+                         bool a_accurate, long * ap_offset,
+                         OMX_TICKS * ap_actual_time)
+{
+  OMX_U64 target = 0;
+  OMX_U64 sample = 0;
+  long offset = 0;
+  size_t i = 0;
+
+  assert (ap_idx);
+  assert (ap_offset);
+  assert (ap_actual_time);
+
+  target = time_to_samples (ap_idx, a_time);
+
+  if (ap_idx->total_samples_ > 0 && target > ap_idx->total_samples_)
+    {
+      target = ap_idx->total_samples_;
+    }
+
+  if (EFrIndexModeResync == ap_idx->mode_)
+    {
+      resync_time_to_offset (ap_idx, target, a_accurate, &offset, &sample);
+      *ap_offset = offset;
+      *ap_actual_time = samples_to_time (ap_idx, sample);
+      TIZ_DEBUG (ap_idx->p_hdl_,
+                 "time [%lld] -> offset [%ld] (actual time [%lld] resync)",
+                 (long long) a_time, offset, (long long) *ap_actual_time);
+      return OMX_ErrorNone;
+    }
+
+  i = find_point_by_sample (ap_idx, target);
+  sample = ap_idx->p_points_[i].sample_;
+  offset = ap_idx->p_points_[i].offset_;
+
+  if (EFrIndexModeInterpolate == ap_idx->mode_
+      && i + 1 < ap_idx->num_points_)
+    {
+      const fr_index_point_t * p_next = &(ap_idx->p_points_[i + 1]);
+      if (p_next->sample_ > sample)
+        {
+          offset += (long) ((double) (p_next->offset_ - offset)
+                            * (target - sample) / (p_next->sample_ - sample));
+          sample = target;
+        }
+      if (ap_idx->block_align_ > 0)
+        {
+          /* Keep PCM frames intact */
+          sample = (offset - ap_idx->data_start_) / ap_idx->block_align_;
+          offset = ap_idx->data_start_ + (long) (sample * ap_idx->block_align_);
+        }
+    }
+  *ap_offset = offset;
+  *ap_actual_time = samples_to_time (ap_idx, sample);
+
+  TIZ_DEBUG (ap_idx->p_hdl_,
+             "time [%lld] -> offset [%ld] (actual time [%lld] entry [%u])",
+             (long long) a_time, offset, (long long) *ap_actual_time,
+             (unsigned) i);
+
+  return OMX_ErrorNone;
+}
+
+OMX_TICKS
+fr_index_offset_to_time (fr_index_t * ap_idx, long a_offset)
+{
+  const fr_index_point_t * p_point = NULL;
+  size_t i = 0;
+  OMX_U64 sample = 0;
+
+  assert (ap_idx);
+
+  if (EFrIndexModeResync == ap_idx->mode_)
+    {
+      sample = a_offset <= ap_idx->data_start_
+                 ? 0
+                 : (OMX_U64) ((a_offset - ap_idx->data_start_)
+                              / ap_idx->frame_bytes_ * ap_idx->frame_samples_);
+      if (sample > ap_idx->total_samples_)
+        {
+          sample = ap_idx->total_samples_;
+        }
+      return samples_to_time (ap_idx, sample);
+    }
+
+  i = find_point_by_offset (ap_idx, a_offset);
+  p_point = &(ap_idx->p_points_[i]);
+  sample = p_point->sample_;
+
+  if (a_offset > p_point->offset_ && i + 1 < ap_idx->num_points_)
+    {
+      const fr_index_point_t * p_next = &(ap_idx->p_points_[i + 1]);
+      sample += (OMX_U64) ((double) (p_next->sample_ - p_point->sample_)
+                           * (a_offset - p_point->offset_)
+                           / (p_next->offset_ - p_point->offset_));
+    }
+
+  if (ap_idx->total_samples_ > 0 && sample > ap_idx->total_samples_)
+    {
+      sample = ap_idx->total_samples_;
+    }
+
+  return samples_to_time (ap_idx, sample);
+}
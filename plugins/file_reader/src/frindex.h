@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   frindex.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Binary file reader's time-to-byte seek index
+ *
+ *
+ */
+
+#ifndef FRINDEX_H
+#define FRINDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+/**
+ * An index that maps media time to byte offsets within an audio file. The
+ * following formats are recognised: MPEG audio (Xing/Info or VBRI tables of
+ * contents, or else an estimate from the average frame length followed by a
+ * resync on the next frame header), ADTS AAC (average frame length and
+ * resync), FLAC (STREAMINFO and SEEKTABLE) and RIFF/WAVE.
+ *
+ * The index uses its own file handle, so it never disturbs the reader's
+ * file position.
+ */
+typedef struct fr_index fr_index_t;
+typedef /*@null@ */ fr_index_t * fr_index_ptr_t;
+
+/**
+ * Creates a seek index for the file at the given path. Only the stream
+ * headers, and at most the first few frames, are parsed.
+ *
+ * @return OMX_ErrorNone on success, OMX_ErrorInsufficientResources if OOM,
+ * OMX_ErrorContentURIError if the file could not be opened, or
+ * OMX_ErrorFormatNotDetected if the stream is not seekable.
+ */
+OMX_ERRORTYPE
+fr_index_init (fr_index_ptr_t * app_idx, OMX_HANDLETYPE ap_hdl,
+               const char * ap_path);
+
+void
+fr_index_destroy (fr_index_t * ap_idx);
+
+/**
+ * Find the byte offset from where the stream must be read to resume playback
+ * at @a a_time.
+ *
+ * @param a_accurate If true, the offset is refined to the boundary of the
+ * frame that contains @a a_time, when the format allows it. Otherwise the
+ * closest preceding index entry is used.
+ *
+ * @param ap_actual_time Receives the media time that corresponds to the
+ * returned offset.
+ */
+OMX_ERRORTYPE
+fr_index_time_to_offset (fr_index_t * ap_idx, OMX_TICKS a_time,
+                         bool a_accurate, long * ap_offset,
+                         OMX_TICKS * ap_actual_time);
+
+/**
+ * Estimate the media time that corresponds to a byte offset in the file.
+ */
+OMX_TICKS
+fr_index_offset_to_time (fr_index_t * ap_idx, long a_offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRINDEX_H */
@@ -74,6 +74,14 @@ delete_uri (fr_prc_t * ap_prc)
   ap_prc->p_uri_param_ = NULL;
 }
 
+static inline void
+delete_index (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  fr_index_destroy (ap_prc->p_index_);
+  ap_prc->p_index_ = NULL;
+}
+
 static inline void
 reset_stream_parameters (fr_prc_t * ap_prc)
 {
@@ -169,6 +177,74 @@ read_into_buffer (const void * ap_obj, OMX_BUFFERHEADERTYPE * p_hdr)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+obtain_index (fr_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (!ap_prc->p_index_)
+    {
+      if (!ap_prc->p_file_ || !ap_prc->p_uri_param_)
+        {
+          return OMX_ErrorIncorrectStateOperation;
+        }
+      /* The index is only created when it is first needed, so that playback
+       * start-up is not delayed by it */
+      tiz_check_omx (fr_index_init (
+        &(ap_prc->p_index_), handleOf (ap_prc),
+        (const char *) ap_prc->p_uri_param_->contentURI));
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+get_time_position (fr_prc_t * ap_prc, OMX_TIME_CONFIG_TIMESTAMPTYPE * ap_pos)
+{
+  long offset = 0;
+  assert (ap_prc);
+  assert (ap_pos);
+  tiz_check_omx (obtain_index (ap_prc));
+  if ((offset = ftell (ap_prc->p_file_)) < 0)
+    {
+      TIZ_ERROR (handleOf (ap_prc), "Unable to obtain the file position (%s)",
+                 strerror (errno));
+      return OMX_ErrorUndefined;
+    }
+  ap_pos->nTimestamp = fr_index_offset_to_time (ap_prc->p_index_, offset);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+set_time_position (fr_prc_t * ap_prc,
+                   const OMX_TIME_CONFIG_TIMESTAMPTYPE * ap_pos)
+{
+  OMX_TICKS actual_time = 0;
+  long offset = 0;
+
+  assert (ap_prc);
+  assert (ap_pos);
+
+  tiz_check_omx (obtain_index (ap_prc));
+  tiz_check_omx (fr_index_time_to_offset (
+    ap_prc->p_index_, ap_pos->nTimestamp,
+    OMX_TIME_SeekModeAccurate == ap_prc->seek_mode_, &offset, &actual_time));
+
+  if (0 != fseek (ap_prc->p_file_, offset, SEEK_SET))
+    {
+      TIZ_ERROR (handleOf (ap_prc), "Unable to seek to offset [%ld] (%s)",
+                 offset, strerror (errno));
+      return OMX_ErrorUndefined;
+    }
+
+  TIZ_NOTICE (handleOf (ap_prc),
+              "Seek to [%lld] us : offset [%ld] actual time [%lld] us",
+              (long long) ap_pos->nTimestamp, offset, (long long) actual_time);
+
+  /* Reading resumes from the new position; the downstream components are
+   * expected to be flushed by the IL client. */
+  ap_prc->eos_ = false;
+  return OMX_ErrorNone;
+}
+
 /*
  * frprc
  */
@@ -180,6 +256,8 @@ fr_prc_ctor (void * ap_obj, va_list * app)
   assert (p_prc);
   p_prc->p_file_ = NULL;
   p_prc->p_uri_param_ = NULL;
+  p_prc->p_index_ = NULL;
+  p_prc->seek_mode_ = OMX_TIME_SeekModeAccurate;
   reset_stream_parameters (p_prc);
   return p_prc;
 }
@@ -220,6 +298,7 @@ fr_prc_allocate_resources (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
 static OMX_ERRORTYPE
 fr_prc_deallocate_resources (void * ap_obj)
 {
+  delete_index (ap_obj);
   close_file (ap_obj);
   delete_uri (ap_obj);
   return OMX_ErrorNone;
@@ -277,6 +356,88 @@ fr_prc_buffers_ready (const void * ap_obj)
   return OMX_ErrorNone;
 }
 
+/*
+ * from tiz_api
+ */
+
+static OMX_ERRORTYPE
+fr_prc_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                  OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  fr_prc_t * p_prc = (fr_prc_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (p_prc);
+  assert (ap_struct);
+
+  switch (a_index)
+    {
+      case OMX_IndexConfigTimePosition:
+        {
+          rc = get_time_position (p_prc, ap_struct);
+        }
+        break;
+
+      case OMX_IndexConfigTimeSeekMode:
+        {
+          OMX_TIME_CONFIG_SEEKMODETYPE * p_seek_mode = ap_struct;
+          p_seek_mode->eType = p_prc->seek_mode_;
+        }
+        break;
+
+      default:
+        {
+          rc = super_GetConfig (typeOf (ap_obj, "frprc"), ap_obj, ap_hdl,
+                                a_index, ap_struct);
+        }
+    };
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+fr_prc_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                  OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  fr_prc_t * p_prc = (fr_prc_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (p_prc);
+  assert (ap_struct);
+
+  switch (a_index)
+    {
+      case OMX_IndexConfigTimePosition:
+        {
+          rc = set_time_position (p_prc, ap_struct);
+        }
+        break;
+
+      case OMX_IndexConfigTimeSeekMode:
+        {
+          const OMX_TIME_CONFIG_SEEKMODETYPE * p_seek_mode = ap_struct;
+          if (OMX_TIME_SeekModeFast != p_seek_mode->eType
+              && OMX_TIME_SeekModeAccurate != p_seek_mode->eType)
+            {
+              rc = OMX_ErrorBadParameter;
+            }
+          else
+            {
+              p_prc->seek_mode_ = p_seek_mode->eType;
+            }
+        }
+        break;
+
+      default:
+        {
+          rc = super_SetConfig (typeOf (ap_obj, "frprc"), ap_obj, ap_hdl,
+                                a_index, ap_struct);
+        }
+    };
+
+  return rc;
+}
+
 /*
  * fr_prc_class
  */
@@ -335,6 +496,10 @@ fr_prc_init (void * ap_tos, void * ap_hdl)
      tiz_srv_stop_and_return, fr_prc_stop_and_return,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_buffers_ready, fr_prc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_GetConfig, fr_prc_GetConfig,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_SetConfig, fr_prc_SetConfig,
      /* TIZ_CLASS_COMMENT: stop value */
      0);
 
@@ -37,6 +37,8 @@ extern "C" {
 
 #include <tizprc_decls.h>
 
+#include "frindex.h"
+
 typedef struct fr_prc fr_prc_t;
 struct fr_prc
 {
@@ -46,6 +48,8 @@ struct fr_prc
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   OMX_U32 counter_;
   bool eos_;
+  fr_index_t * p_index_;
+  OMX_TIME_SEEKMODETYPE seek_mode_;
 };
 
 typedef struct fr_prc_class fr_prc_class_t;
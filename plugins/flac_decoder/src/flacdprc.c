@@ -440,45 +440,6 @@ write_pcm_block_8 (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
     }
 }
 
-static void
-write_pcm_block_16 (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
-                    const unsigned int a_nsamples,
-                    const unsigned int a_nchannels)
-{
-  size_t i = 0;
-  size_t j = 0;
-  for (i = 0; i < a_nsamples; i += 2, ++j)
-    {
-      FLAC__int16 * out = (FLAC__int16 *) (ap_to) + i;
-      int k;
-      for (k = 0; k < a_nchannels; ++k)
-        {
-          out[k] = (FLAC__int16) ap_buffer[k][j];
-        }
-    }
-}
-
-static void
-write_pcm_block_24 (uint8_t * ap_to, const FLAC__int32 * const ap_buffer[],
-                    const unsigned int a_nsamples,
-                    const unsigned int a_nchannels)
-{
-  size_t i = 0;
-  size_t j = 0;
-  for (i = 0; i < a_nsamples; i += 2, ++j)
-    {
-      unsigned char * out = (unsigned char *) (ap_to) + (i * 3);
-      int k;
-      for (k = 0; k < a_nchannels; ++k)
-        {
-          unsigned long word32 = (unsigned long) ap_buffer[k][j];
-          *out++ = (unsigned char) (word32 >> 0);
-          *out++ = (unsigned char) (word32 >> 8);
-          *out++ = (unsigned char) (word32 >> 16);
-        }
-    }
-}
-
 static FLAC__StreamDecoderWriteStatus
 write_cb (const FLAC__StreamDecoder * ap_decoder, const FLAC__Frame * ap_frame,
           const FLAC__int32 * const ap_buffer[], void * ap_client_data)
@@ -517,6 +478,7 @@ write_cb (const FLAC__StreamDecoder * ap_decoder, const FLAC__Frame * ap_frame,
       if (nsamples * (p_prc->bps_ / 8) > p_out->nAllocLen)
         {
           nsamples = p_out->nAllocLen / (p_prc->bps_ / 8);
+          nsamples -= nsamples % p_prc->channels_;
         }
       assert (nsamples <= p_out->nAllocLen);
 
@@ -533,14 +495,18 @@ write_cb (const FLAC__StreamDecoder * ap_decoder, const FLAC__Frame * ap_frame,
               break;
             case 16:
               {
-                write_pcm_block_16 (p_to, ap_buffer, nsamples,
-                                    ap_frame->header.channels);
+                tiz_dsp_interleave_s32_to_s16 (
+                  (int16_t *) p_to, (const int32_t * const *) ap_buffer,
+                  ap_frame->header.channels,
+                  nsamples / ap_frame->header.channels);
               }
               break;
             case 24:
               {
-                write_pcm_block_24 (p_to, ap_buffer, nsamples,
-                                    ap_frame->header.channels);
+                tiz_dsp_interleave_s32_to_s24 (
+                  p_to, (const int32_t * const *) ap_buffer,
+                  ap_frame->header.channels,
+                  nsamples / ap_frame->header.channels);
               }
               break;
             default:
@@ -738,6 +704,30 @@ flacd_prc_buffers_ready (const void * ap_obj)
   return transform_stream (ap_obj);
 }
 
+static OMX_ERRORTYPE
+flacd_prc_port_flush (const void * ap_obj, OMX_U32 a_pid)
+{
+  flacd_prc_t * p_prc = (flacd_prc_t *) ap_obj;
+  assert (p_prc);
+  if ((OMX_ALL == a_pid || ARATELIA_FLAC_DECODER_INPUT_PORT_INDEX == a_pid)
+      && p_prc->p_flac_dec_)
+    {
+      const FLAC__StreamDecoderState state
+        = FLAC__stream_decoder_get_state (p_prc->p_flac_dec_);
+      /* Once the metadata has been processed, drop any buffered input and let
+       * the decoder look for the next frame sync (e.g. after a seek) */
+      if (FLAC__STREAM_DECODER_SEARCH_FOR_FRAME_SYNC == state
+          || FLAC__STREAM_DECODER_READ_FRAME == state
+          || FLAC__STREAM_DECODER_END_OF_STREAM == state)
+        {
+          p_prc->store_offset_ = 0;
+          p_prc->eos_ = false;
+          (void) FLAC__stream_decoder_flush (p_prc->p_flac_dec_);
+        }
+    }
+  return release_all_headers (p_prc, a_pid);
+}
+
 /*
  * flacd_prc_class
  */
@@ -797,6 +787,8 @@ flacd_prc_init (void * ap_tos, void * ap_hdl)
      tiz_srv_transfer_and_process, flacd_prc_transfer_and_process,
      /* TIZ_CLASS_COMMENT: */
      tiz_srv_stop_and_return, flacd_prc_stop_and_return,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_flush, flacd_prc_port_flush,
      /* TIZ_CLASS_COMMENT: stop value */
      0);
 
@@ -31,7 +31,11 @@
 #endif
 
 #include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #include <OMX_Core.h>
 #include <OMX_Component.h>
@@ -44,6 +48,7 @@
 
 #include "httprprc.h"
 #include "httprmp3port.h"
+#include "httpropusport.h"
 #include "httprcfgport.h"
 #include "httpr.h"
 
@@ -63,8 +68,90 @@
 
 static OMX_VERSIONTYPE http_renderer_version = {{1, 0, 0, 0}};
 
+/* A mount point, as given in the 'mounts' key of tizonia.conf */
+typedef struct httpr_mount_spec httpr_mount_spec_t;
+struct httpr_mount_spec
+{
+  char name[OMX_MAX_STRINGNAME_SIZE];
+  OMX_AUDIO_CODINGTYPE encoding;
+};
+
+static bool
+parse_mount (char * ap_item, httpr_mount_spec_t * ap_spec)
+{
+  char * p_save = NULL;
+  char * p_name = strtok_r (ap_item, ":", &p_save);
+  char * p_codec = strtok_r (NULL, ":", &p_save);
+
+  assert (ap_spec);
+
+  while (p_name && ' ' == *p_name)
+    {
+      ++p_name;
+    }
+  if (!p_name || '/' != *p_name)
+    {
+      return false;
+    }
+
+  snprintf (ap_spec->name, sizeof (ap_spec->name), "%s", p_name);
+  ap_spec->encoding = OMX_AUDIO_CodingMP3;
+  if (p_codec && 0 == strncasecmp (p_codec, "opus", strlen ("opus")))
+    {
+      ap_spec->encoding = (OMX_AUDIO_CODINGTYPE) OMX_AUDIO_CodingOPUS;
+    }
+  else if (p_codec && 0 != strncasecmp (p_codec, "mp3", strlen ("mp3")))
+    {
+      return false;
+    }
+  return true;
+}
+
+/* Without the 'mounts' key, there is a single MP3 mount point at '/' */
+static OMX_U32
+read_mounts (httpr_mount_spec_t * ap_specs)
+{
+  const char * p_value
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_renderer.http.mounts");
+  char * p_mounts = NULL;
+  char * p_save = NULL;
+  char * p_item = NULL;
+  OMX_U32 nmounts = 0;
+
+  assert (ap_specs);
+
+  if (p_value && (p_mounts = strdup (p_value)))
+    {
+      for (p_item = strtok_r (p_mounts, ",", &p_save);
+           p_item && nmounts < ICE_MAX_MOUNTS;
+           p_item = strtok_r (NULL, ",", &p_save))
+        {
+          if (parse_mount (p_item, &(ap_specs[nmounts])))
+            {
+              ++nmounts;
+            }
+          else
+            {
+              TIZ_LOG (TIZ_PRIORITY_ERROR, "Ignoring invalid mount [%s]",
+                       p_item);
+            }
+        }
+      free (p_mounts);
+    }
+
+  if (0 == nmounts)
+    {
+      snprintf (ap_specs[0].name, sizeof (ap_specs[0].name), "/");
+      ap_specs[0].encoding = OMX_AUDIO_CodingMP3;
+      nmounts = 1;
+    }
+  return nmounts;
+}
+
 static OMX_PTR
-instantiate_mp3_port (OMX_HANDLETYPE ap_hdl)
+instantiate_mp3_port (OMX_HANDLETYPE ap_hdl, const OMX_U32 a_pid,
+                      const char * ap_mount_name)
 {
   OMX_AUDIO_PARAM_MP3TYPE mp3type;
   OMX_AUDIO_CODINGTYPE encodings[] = {OMX_AUDIO_CodingMP3, OMX_AUDIO_CodingMax};
@@ -76,13 +163,13 @@ instantiate_mp3_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_HTTP_RENDERER_PORT_NONCONTIGUOUS,
     ARATELIA_HTTP_RENDERER_PORT_ALIGNMENT,
     ARATELIA_HTTP_RENDERER_PORT_SUPPLIERPREF,
-    {ARATELIA_HTTP_RENDERER_PORT_INDEX, NULL, NULL, NULL},
+    {a_pid, NULL, NULL, NULL},
     0 /* Master port */
   };
 
   mp3type.nSize = sizeof (OMX_AUDIO_PARAM_MP3TYPE);
   mp3type.nVersion.nVersion = OMX_VERSION;
-  mp3type.nPortIndex = ARATELIA_HTTP_RENDERER_PORT_INDEX;
+  mp3type.nPortIndex = a_pid;
   mp3type.nChannels = 2;
   mp3type.nBitRate = 128000;
   mp3type.nSampleRate = 44100;
@@ -91,7 +178,81 @@ instantiate_mp3_port (OMX_HANDLETYPE ap_hdl)
   mp3type.eFormat = OMX_AUDIO_MP3StreamFormatMP1Layer3;
 
   return factory_new (tiz_get_type (ap_hdl, "httprmp3port"), &mp3_port_opts,
-                      &encodings, &mp3type);
+                      &encodings, &mp3type, ap_mount_name);
+}
+
+static OMX_PTR
+instantiate_opus_port (OMX_HANDLETYPE ap_hdl, const OMX_U32 a_pid,
+                       const char * ap_mount_name)
+{
+  OMX_TIZONIA_AUDIO_PARAM_OPUSTYPE opustype;
+  OMX_AUDIO_CODINGTYPE encodings[]
+    = {(OMX_AUDIO_CODINGTYPE) OMX_AUDIO_CodingOPUS, OMX_AUDIO_CodingMax};
+  tiz_port_options_t opus_port_opts = {
+    OMX_PortDomainAudio,
+    OMX_DirInput,
+    ARATELIA_HTTP_RENDERER_PORT_MIN_BUF_COUNT,
+    ARATELIA_HTTP_RENDERER_PORT_MIN_BUF_SIZE,
+    ARATELIA_HTTP_RENDERER_PORT_NONCONTIGUOUS,
+    ARATELIA_HTTP_RENDERER_PORT_ALIGNMENT,
+    ARATELIA_HTTP_RENDERER_PORT_SUPPLIERPREF,
+    {a_pid, NULL, NULL, NULL},
+    0 /* Master port */
+  };
+
+  opustype.nSize = sizeof (OMX_TIZONIA_AUDIO_PARAM_OPUSTYPE);
+  opustype.nVersion.nVersion = OMX_VERSION;
+  opustype.nPortIndex = a_pid;
+  opustype.nChannels = 2;
+  opustype.nBitRate = 128;
+  opustype.nSampleRate = 48000;
+  opustype.nFrameDuration = 20;
+  opustype.nEncoderComplexity = 0;
+  opustype.bPacketLossResilience = OMX_FALSE;
+  opustype.bForwardErrorCorrection = OMX_FALSE;
+  opustype.bDtx = OMX_FALSE;
+  opustype.eChannelMode = OMX_AUDIO_ChannelModeStereo;
+  opustype.eFormat = OMX_AUDIO_OPUSStreamFormatVBR;
+
+  return factory_new (tiz_get_type (ap_hdl, "httpropusport"), &opus_port_opts,
+                      &encodings, &opustype, ap_mount_name);
+}
+
+static OMX_PTR
+instantiate_port (OMX_HANDLETYPE ap_hdl, const OMX_U32 a_pid)
+{
+  httpr_mount_spec_t specs[ICE_MAX_MOUNTS];
+  OMX_U32 nmounts = read_mounts (specs);
+  assert (a_pid < nmounts);
+  (void) nmounts;
+  return (OMX_AUDIO_CodingMP3 == specs[a_pid].encoding
+            ? instantiate_mp3_port (ap_hdl, a_pid, specs[a_pid].name)
+            : instantiate_opus_port (ap_hdl, a_pid, specs[a_pid].name));
+}
+
+/* The role factory's port hooks don't take the port index */
+static OMX_PTR
+instantiate_port_0 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_port (ap_hdl, 0);
+}
+
+static OMX_PTR
+instantiate_port_1 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_port (ap_hdl, 1);
+}
+
+static OMX_PTR
+instantiate_port_2 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_port (ap_hdl, 2);
+}
+
+static OMX_PTR
+instantiate_port_3 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_port (ap_hdl, 3);
 }
 
 static OMX_PTR
@@ -116,14 +277,20 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
   const tiz_role_factory_t * rf_list[] = {&role_factory};
   tiz_type_factory_t httprprc_type;
   tiz_type_factory_t httprmp3port_type;
+  tiz_type_factory_t httpropusport_type;
   tiz_type_factory_t httprcfgport_type;
   const tiz_type_factory_t * tf_list[]
-    = {&httprprc_type, &httprmp3port_type, &httprcfgport_type};
+    = {&httprprc_type, &httprmp3port_type, &httpropusport_type,
+       &httprcfgport_type};
+  httpr_mount_spec_t specs[ICE_MAX_MOUNTS];
 
   strcpy ((OMX_STRING) role_factory.role, ARATELIA_HTTP_RENDERER_DEFAULT_ROLE);
   role_factory.pf_cport = instantiate_config_port;
-  role_factory.pf_port[0] = instantiate_mp3_port;
-  role_factory.nports = 1;
+  role_factory.pf_port[0] = instantiate_port_0;
+  role_factory.pf_port[1] = instantiate_port_1;
+  role_factory.pf_port[2] = instantiate_port_2;
+  role_factory.pf_port[3] = instantiate_port_3;
+  role_factory.nports = read_mounts (specs);
   role_factory.pf_proc = instantiate_processor;
 
   strcpy ((OMX_STRING) httprprc_type.class_name, "httprprc_class");
@@ -136,6 +303,11 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
   strcpy ((OMX_STRING) httprmp3port_type.object_name, "httprmp3port");
   httprmp3port_type.pf_object_init = httpr_mp3port_init;
 
+  strcpy ((OMX_STRING) httpropusport_type.class_name, "httpropusport_class");
+  httpropusport_type.pf_class_init = httpr_opusport_class_init;
+  strcpy ((OMX_STRING) httpropusport_type.object_name, "httpropusport");
+  httpropusport_type.pf_object_init = httpr_opusport_init;
+
   strcpy ((OMX_STRING) httprcfgport_type.class_name, "httprcfgport_class");
   httprcfgport_type.pf_class_init = httpr_cfgport_class_init;
   strcpy ((OMX_STRING) httprcfgport_type.object_name, "httprcfgport");
@@ -145,8 +317,9 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
   tiz_check_omx (
     tiz_comp_init (ap_hdl, ARATELIA_HTTP_RENDERER_COMPONENT_NAME));
 
-  /* Register the "httprprc", "httprmp3port" and "httprcfgport" classes */
-  tiz_check_omx (tiz_comp_register_types (ap_hdl, tf_list, 3));
+  /* Register the "httprprc", "httprmp3port", "httpropusport" and
+     "httprcfgport" classes */
+  tiz_check_omx (tiz_comp_register_types (ap_hdl, tf_list, 4));
 
   /* Register this component's role */
   tiz_check_omx (tiz_comp_register_roles (ap_hdl, rf_list, 1));
@@ -49,10 +49,31 @@ extern "C" {
 #define ARATELIA_HTTP_RENDERER_DEFAULT_HTTP_SERVER_PORT 8010
 
 #define ICE_DEFAULT_METADATA_INTERVAL 16000
+#define ICE_MIN_METADATA_INTERVAL 1024
+#define ICE_MAX_METADATA_INTERVAL 65536
 #define ICE_INITIAL_BURST_SIZE 128000
 #define ICE_MAX_CLIENTS_PER_MOUNTPOINT 10
+#define ICE_DEFAULT_MAX_CLIENTS 256
 #define ICE_DEFAULT_HEADER_TIMEOUT 10
-#define ICE_LISTEN_QUEUE 5
+#define ICE_LISTEN_QUEUE 128
+#define ICE_RING_CHUNK_SIZE ARATELIA_HTTP_RENDERER_PORT_MIN_BUF_SIZE
+#define ICE_DEFAULT_RING_SIZE_KB 512
+#define ICE_MAX_IOVECS 16
+#define ICE_NOTSENT_LOWAT (32 * 1024)
+#define ICE_ZEROCOPY_MIN_BYTES (16 * 1024) /* Smaller sends are just copied */
+#define ICE_ZEROCOPY_MAX_INFLIGHT 32
+#define ICE_MP3_SAMPLES_PER_FRAME 1152
+#define ICE_PACING_FRAMES_PER_TICK 2 /* About 50ms at 44.1KHz */
+#define ICE_PACING_HEADROOM_PERCENT 10 /* For non-MP3, e.g. VBR Ogg Opus */
+#define ICE_MAX_MOUNTS 4
+#define ICE_HLS_DEFAULT_SEGMENTS 6
+#define ICE_HLS_MAX_SEGMENTS 30 /* The playlist must fit in a listener's buffer */
+#define ICE_HLS_MAX_SEGMENT_SECONDS 30
+#define ICE_HLS_ID3_TAG_SIZE 73 /* ID3v2.4 header plus the PRIV timestamp frame */
+#define ICE_KEEPALIVE_TIMEOUT 15 /* Seconds an idle persistent connection is kept */
+#define ICE_KEEPALIVE_MAX_REQUESTS 100
+#define ICE_SENDFILE_MAX_BYTES (1024 * 1024) /* Per writable event */
+#define ICE_STATUS_MAX_LISTENERS 1000 /* Listed one by one in the status report */
 #define ICE_MIN_BURST_SIZE 1400
 #define ICE_MEDIUM_BURST_SIZE 2800 /* Not used for now */
 #define ICE_MAX_BURST_SIZE 4200    /* Not used for now */
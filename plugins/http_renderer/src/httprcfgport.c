@@ -31,6 +31,7 @@
 #endif
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 
@@ -45,6 +46,16 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.http_renderer.cfgport"
 #endif
 
+static OMX_U32
+get_max_clients (void)
+{
+  const char * p_value
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_renderer.http.max_clients");
+  return (p_value && atoi (p_value) > 0) ? (OMX_U32) atoi (p_value)
+                                         : ICE_DEFAULT_MAX_CLIENTS;
+}
+
 /*
  * httprcfgport class
  */
@@ -62,7 +73,7 @@ httpr_cfgport_ctor (void * ap_obj, va_list * app)
   p_obj->http_conf_.nVersion.nVersion = OMX_VERSION;
   p_obj->http_conf_.nListeningPort
     = ARATELIA_HTTP_RENDERER_DEFAULT_HTTP_SERVER_PORT;
-  p_obj->http_conf_.nMaxClients = 5;
+  p_obj->http_conf_.nMaxClients = get_max_clients ();
 
   return p_obj;
 }
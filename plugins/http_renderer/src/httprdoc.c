@@ -0,0 +1,165 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   httprdoc.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief Tizonia - HTTP renderer's document root functions
+ *
+ * Request paths are percent-decoded and appended to the document root, and
+ * paths with ".." segments are turned away straight away. That alone
+ * doesn't keep a request inside the document root, as any symlink under it
+ * may point elsewhere, so the file that was actually opened is resolved
+ * and checked against the root too.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "httprdoc.h"
+
+/* The resolved path of an open file. On Linux, the descriptor's own link
+   is read, so that what is checked is what was opened. */
+static bool
+doc_resolve_fd (const int a_fd, const char * ap_path, char * ap_resolved)
+{
+#ifdef __linux__
+  char link[64];
+  ssize_t len = 0;
+  snprintf (link, sizeof (link), "/proc/self/fd/%d", a_fd);
+  if ((len = readlink (link, ap_resolved, PATH_MAX - 1)) > 0
+      && '/' == ap_resolved[0])
+    {
+      ap_resolved[len] = '\0';
+      return true;
+    }
+#endif
+  return NULL != realpath (ap_path, ap_resolved);
+}
+
+static bool
+doc_is_beneath (const char * ap_docroot, const char * ap_resolved)
+{
+  const size_t root_len = strlen (ap_docroot);
+  if (1 == root_len && '/' == ap_docroot[0])
+    {
+      return true;
+    }
+  return 0 == strncmp (ap_resolved, ap_docroot, root_len)
+         && '/' == ap_resolved[root_len];
+}
+
+char *
+httpr_doc_canonical_root (const char * ap_docroot)
+{
+  struct stat st;
+  char * p_root = NULL;
+
+  if (!ap_docroot || '\0' == ap_docroot[0])
+    {
+      return NULL;
+    }
+  if ((p_root = realpath (ap_docroot, NULL))
+      && (0 != stat (p_root, &st) || !S_ISDIR (st.st_mode)))
+    {
+      free (p_root);
+      p_root = NULL;
+    }
+  return p_root;
+}
+
+int
+httpr_doc_open (const char * ap_docroot, const char * ap_url,
+                struct stat * ap_st, char * ap_path, const size_t a_path_len)
+{
+  char resolved[PATH_MAX];
+  const size_t url_len = strcspn (ap_url, "?#");
+  const char * p_seg = NULL;
+  size_t len = 0;
+  size_t i = 0;
+  int fd = -1;
+
+  assert (ap_url);
+  assert (ap_st);
+  assert (ap_path);
+
+  if (!ap_docroot || url_len < 2 || '/' != ap_url[0])
+    {
+      return -1;
+    }
+
+  len = snprintf (ap_path, a_path_len, "%s", ap_docroot);
+  for (i = 0; i < url_len && len < a_path_len - 1; ++i)
+    {
+      char c = ap_url[i];
+      if ('%' == c && i + 2 < url_len && isxdigit ((unsigned char) ap_url[i + 1])
+          && isxdigit ((unsigned char) ap_url[i + 2]))
+        {
+          char hex[3] = { ap_url[i + 1], ap_url[i + 2], '\0' };
+          c = (char) strtol (hex, NULL, 16);
+          i += 2;
+        }
+      if ('\0' == c)
+        {
+          return -1;
+        }
+      ap_path[len++] = c;
+    }
+  if (i < url_len)
+    {
+      /* Too long */
+      return -1;
+    }
+  ap_path[len] = '\0';
+
+  for (p_seg = strstr (ap_path, "/.."); p_seg; p_seg = strstr (p_seg + 1, "/.."))
+    {
+      if ('/' == p_seg[3] || '\0' == p_seg[3])
+        {
+          return -1;
+        }
+    }
+
+  /* Non-blocking, so that a FIFO can't hold the server up */
+  if ((fd = open (ap_path, O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK)) < 0)
+    {
+      return -1;
+    }
+  if (0 != fstat (fd, ap_st) || !S_ISREG (ap_st->st_mode)
+      || !doc_resolve_fd (fd, ap_path, resolved)
+      || !doc_is_beneath (ap_docroot, resolved))
+    {
+      close (fd);
+      return -1;
+    }
+  return fd;
+}
@@ -0,0 +1,57 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   httprdoc.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief Tizonia - HTTP renderer's document root functions
+ *
+ *
+ */
+
+#ifndef HTTPRDOC_H
+#define HTTPRDOC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+/* Returns the canonical form of a document root: absolute, free of
+   symlinks and with no trailing slash. NULL if it isn't an existing
+   directory. The result is released with free(). */
+char *
+httpr_doc_canonical_root (const char * ap_docroot);
+
+/* Opens the regular file that a request URL maps to under a canonical
+   document root, and leaves its path in ap_path. Returns -1 if the URL is
+   malformed or too long, or if the file doesn't exist, isn't a regular file
+   or, once symlinks are resolved, lies outside the document root. */
+int
+httpr_doc_open (const char * ap_docroot, const char * ap_url,
+                struct stat * ap_st, char * ap_path, const size_t a_path_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTPRDOC_H */
@@ -54,8 +54,12 @@ httpr_mp3port_ctor (void * ap_obj, va_list * app)
 {
   httpr_mp3port_t * p_obj
     = super_ctor (typeOf (ap_obj, "httprmp3port"), ap_obj, app);
+  const char * p_mount_name = NULL;
   assert (p_obj);
 
+  /* The mount point's path follows the tizmp3port arguments */
+  p_mount_name = va_arg (*app, const char *);
+
   tiz_port_register_index (p_obj, OMX_TizoniaIndexParamIcecastMountpoint);
   tiz_port_register_index (p_obj, OMX_TizoniaIndexConfigIcecastMetadata);
 
@@ -64,7 +68,8 @@ httpr_mp3port_ctor (void * ap_obj, va_list * app)
   p_obj->mountpoint_.nPortIndex = 0;
 
   snprintf ((char *) p_obj->mountpoint_.cMountName,
-            sizeof (p_obj->mountpoint_.cMountName), "/");
+            sizeof (p_obj->mountpoint_.cMountName), "%s",
+            p_mount_name ? p_mount_name : "/");
   snprintf ((char *) p_obj->mountpoint_.cStationName,
             sizeof (p_obj->mountpoint_.cStationName), "Tizonia Radio!");
   snprintf ((char *) p_obj->mountpoint_.cStationDescription,
@@ -114,6 +119,8 @@ httpr_mp3port_GetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
     {
       memcpy (ap_struct, &(p_obj->mountpoint_),
               sizeof (OMX_TIZONIA_ICECASTMOUNTPOINTTYPE));
+      ((OMX_TIZONIA_ICECASTMOUNTPOINTTYPE *) ap_struct)->nPortIndex
+        = tiz_port_index (ap_obj);
     }
   else
     {
@@ -140,6 +147,9 @@ httpr_mp3port_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
     {
       memcpy (&(p_obj->mountpoint_), ap_struct,
               sizeof (OMX_TIZONIA_ICECASTMOUNTPOINTTYPE));
+      /* The encoding is the port's own */
+      p_obj->mountpoint_.eEncoding = OMX_AUDIO_CodingMP3;
+      p_obj->mountpoint_.cMountName[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
       p_obj->mountpoint_.cStationName[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
       p_obj->mountpoint_.cStationDescription[OMX_MAX_STRINGNAME_SIZE - 1]
         = '\0';
@@ -0,0 +1,336 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   httpropusport.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief Tizonia - Http renderer's specialised opus port
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <string.h>
+#include <limits.h>
+
+#include <tizplatform.h>
+
+#include "httpr.h"
+#include "httpropusport.h"
+#include "httpropusport_decls.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.http_renderer.opusport"
+#endif
+
+/*
+ * httpropusport class
+ */
+
+static void *
+httpr_opusport_ctor (void * ap_obj, va_list * app)
+{
+  httpr_opusport_t * p_obj
+    = super_ctor (typeOf (ap_obj, "httpropusport"), ap_obj, app);
+  const char * p_mount_name = NULL;
+  assert (p_obj);
+
+  /* The mount point's path follows the tizopusport arguments */
+  p_mount_name = va_arg (*app, const char *);
+
+  tiz_port_register_index (p_obj, OMX_TizoniaIndexParamIcecastMountpoint);
+  tiz_port_register_index (p_obj, OMX_TizoniaIndexConfigIcecastMetadata);
+
+  p_obj->mountpoint_.nSize = sizeof (OMX_TIZONIA_ICECASTMOUNTPOINTTYPE);
+  p_obj->mountpoint_.nVersion.nVersion = OMX_VERSION;
+  p_obj->mountpoint_.nPortIndex = 0;
+
+  snprintf ((char *) p_obj->mountpoint_.cMountName,
+            sizeof (p_obj->mountpoint_.cMountName), "%s",
+            p_mount_name ? p_mount_name : "/");
+  snprintf ((char *) p_obj->mountpoint_.cStationName,
+            sizeof (p_obj->mountpoint_.cStationName), "Tizonia Radio!");
+  snprintf ((char *) p_obj->mountpoint_.cStationDescription,
+            sizeof (p_obj->mountpoint_.cStationDescription),
+            "Cool Radio Station");
+  snprintf ((char *) p_obj->mountpoint_.cStationGenre,
+            sizeof (p_obj->mountpoint_.cStationGenre), "Some punchy genre");
+  snprintf ((char *) p_obj->mountpoint_.cStationUrl,
+            sizeof (p_obj->mountpoint_.cStationUrl), "http://tizonia.org");
+
+  p_obj->mountpoint_.eEncoding = (OMX_AUDIO_CODINGTYPE) OMX_AUDIO_CodingOPUS;
+  /* ICY metadata can't be interleaved with an Ogg stream */
+  p_obj->mountpoint_.nIcyMetadataPeriod = 0;
+  p_obj->mountpoint_.bBurstOnConnect = OMX_TRUE;
+  p_obj->mountpoint_.nInitialBurstSize = ICE_INITIAL_BURST_SIZE;
+  p_obj->mountpoint_.nMaxClients = ICE_MAX_CLIENTS_PER_MOUNTPOINT;
+
+  p_obj->p_stream_title_ = NULL;
+
+  return p_obj;
+}
+
+static void *
+httpr_opusport_dtor (void * ap_obj)
+{
+  httpr_opusport_t * p_obj = ap_obj;
+  assert (p_obj);
+  tiz_mem_free (p_obj->p_stream_title_);
+  return super_dtor (typeOf (ap_obj, "httpropusport"), ap_obj);
+}
+
+/*
+ * from tiz_api
+ */
+
+static OMX_ERRORTYPE
+httpr_opusport_GetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                            OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  const httpr_opusport_t * p_obj = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "[%s]...", tiz_idx_to_str (a_index));
+
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexParamIcecastMountpoint == a_index)
+    {
+      memcpy (ap_struct, &(p_obj->mountpoint_),
+              sizeof (OMX_TIZONIA_ICECASTMOUNTPOINTTYPE));
+      ((OMX_TIZONIA_ICECASTMOUNTPOINTTYPE *) ap_struct)->nPortIndex
+        = tiz_port_index (ap_obj);
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_GetParameter (typeOf (ap_obj, "httpropusport"), ap_obj, ap_hdl,
+                               a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+httpr_opusport_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                            OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  httpr_opusport_t * p_obj = (httpr_opusport_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "[%s]...", tiz_idx_to_str (a_index));
+
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexParamIcecastMountpoint == a_index)
+    {
+      memcpy (&(p_obj->mountpoint_), ap_struct,
+              sizeof (OMX_TIZONIA_ICECASTMOUNTPOINTTYPE));
+      /* The encoding is the port's own */
+      p_obj->mountpoint_.eEncoding
+        = (OMX_AUDIO_CODINGTYPE) OMX_AUDIO_CodingOPUS;
+      p_obj->mountpoint_.cMountName[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
+      p_obj->mountpoint_.cStationName[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
+      p_obj->mountpoint_.cStationDescription[OMX_MAX_STRINGNAME_SIZE - 1]
+        = '\0';
+      p_obj->mountpoint_.cStationGenre[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
+      p_obj->mountpoint_.cStationUrl[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
+      TIZ_TRACE (ap_hdl, "Station Name [%s]...",
+                 p_obj->mountpoint_.cStationName);
+    }
+  else
+    {
+      /* Try the parent's indexes */
+      rc = super_SetParameter (typeOf (ap_obj, "httpropusport"), ap_obj, ap_hdl,
+                               a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+httpr_opusport_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                         OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  const httpr_opusport_t * p_obj = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "[%s]...", tiz_idx_to_str (a_index));
+
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexConfigIcecastMetadata == a_index)
+    {
+      OMX_TIZONIA_ICECASTMETADATATYPE * p_metadata
+        = (OMX_TIZONIA_ICECASTMETADATATYPE *) ap_struct;
+
+      p_metadata->nVersion.nVersion = OMX_VERSION;
+
+      if (p_obj->p_stream_title_)
+        {
+          OMX_U32 metadata_buf_size = p_metadata->nSize - sizeof (OMX_U32)
+                                      - sizeof (OMX_VERSIONTYPE)
+                                      - sizeof (OMX_U32);
+          OMX_U32 stream_title_len = strnlen (
+            p_obj->p_stream_title_, OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
+
+          assert (stream_title_len < OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
+          if (metadata_buf_size < (stream_title_len + 1)
+              && metadata_buf_size < OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE)
+            {
+              rc = OMX_ErrorBadParameter;
+            }
+          else
+            {
+              strncpy ((char *) p_metadata->cStreamTitle,
+                       p_obj->p_stream_title_, stream_title_len);
+              p_metadata->cStreamTitle[stream_title_len] = '\0';
+            }
+        }
+      else
+        {
+          p_metadata->cStreamTitle[0] = '\0';
+        }
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_GetConfig (typeOf (ap_obj, "httpropusport"), ap_obj, ap_hdl,
+                            a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+httpr_opusport_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                         OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  httpr_opusport_t * p_obj = (httpr_opusport_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "[%s]...", tiz_idx_to_str (a_index));
+
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexConfigIcecastMetadata == a_index)
+    {
+      OMX_TIZONIA_ICECASTMETADATATYPE * p_metadata
+        = (OMX_TIZONIA_ICECASTMETADATATYPE *) ap_struct;
+      OMX_U32 stream_title_len
+        = strnlen ((char *) p_metadata->cStreamTitle,
+                   OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE + 1);
+      if (stream_title_len > OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE)
+        {
+          rc = OMX_ErrorBadParameter;
+        }
+      else
+        {
+          TIZ_TRACE (ap_hdl, "stream_title_len [%d] Stream title [%s]...",
+                     stream_title_len, p_metadata->cStreamTitle);
+
+          tiz_mem_free (p_obj->p_stream_title_);
+          p_obj->p_stream_title_ = tiz_mem_calloc (1, stream_title_len + 1);
+          if (p_obj->p_stream_title_)
+            {
+              strncpy (p_obj->p_stream_title_,
+                       (char *) p_metadata->cStreamTitle, stream_title_len);
+              p_obj->p_stream_title_[stream_title_len] = '\0';
+            }
+
+          TIZ_TRACE (ap_hdl, "stream_title_len [%d] Stream title [%s]...",
+                     stream_title_len, p_obj->p_stream_title_);
+        }
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_SetConfig (typeOf (ap_obj, "httpropusport"), ap_obj, ap_hdl,
+                            a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+/*
+ * httpr_opusport_class
+ */
+
+static void *
+httpr_opusport_class_ctor (void * ap_obj, va_list * app)
+{
+  /* NOTE: Class methods might be added in the future. None for now. */
+  return super_ctor (typeOf (ap_obj, "httpropusport_class"), ap_obj, app);
+}
+
+/*
+ * initialization
+ */
+
+void *
+httpr_opusport_class_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizopusport = tiz_get_type (ap_hdl, "tizopusport");
+  void * httpropusport_class = factory_new
+    /* TIZ_CLASS_COMMENT: class type, class name, parent, size */
+    (classOf (tizopusport), "httpropusport_class", classOf (tizopusport),
+     sizeof (httpr_opusport_class_t),
+     /* TIZ_CLASS_COMMENT: */
+     ap_tos, ap_hdl,
+     /* TIZ_CLASS_COMMENT: class constructor */
+     ctor, httpr_opusport_class_ctor,
+     /* TIZ_CLASS_COMMENT: stop value*/
+     0);
+  return httpropusport_class;
+}
+
+void *
+httpr_opusport_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizopusport = tiz_get_type (ap_hdl, "tizopusport");
+  void * httpropusport_class = tiz_get_type (ap_hdl, "httpropusport_class");
+  TIZ_LOG_CLASS (httpropusport_class);
+  void * httpropusport = factory_new
+    /* TIZ_CLASS_COMMENT: class type, class name, parent, size */
+    (httpropusport_class, "httpropusport", tizopusport, sizeof (httpr_opusport_t),
+     /* TIZ_CLASS_COMMENT: */
+     ap_tos, ap_hdl,
+     /* TIZ_CLASS_COMMENT: class constructor */
+     ctor, httpr_opusport_ctor,
+     /* TIZ_CLASS_COMMENT: class destructor */
+     dtor, httpr_opusport_dtor,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_GetParameter, httpr_opusport_GetParameter,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_SetParameter, httpr_opusport_SetParameter,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_GetConfig, httpr_opusport_GetConfig,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_SetConfig, httpr_opusport_SetConfig,
+     /* TIZ_CLASS_COMMENT: stop value*/
+     0);
+
+  return httpropusport;
+}
@@ -33,6 +33,8 @@
 #endif
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <OMX_Core.h>
 
@@ -50,40 +52,115 @@ static OMX_ERRORTYPE
 httpr_prc_config_change (const void * ap_prc, OMX_U32 a_pid,
                          OMX_INDEXTYPE a_config_idx);
 
+static OMX_U32
+get_ring_size (void)
+{
+  const char * p_value
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_renderer.http.ring_size_kb");
+  return ((p_value && atoi (p_value) > 0) ? (OMX_U32) atoi (p_value)
+                                          : ICE_DEFAULT_RING_SIZE_KB)
+         * 1024;
+}
+
+static httpr_srv_slow_policy_t
+get_slow_listener_policy (void)
+{
+  const char * p_value = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    "OMX.Aratelia.audio_renderer.http.slow_listener_policy");
+  return (p_value && 0 == strncmp (p_value, "drop", strlen ("drop")))
+           ? EHttprSrvSlowPolicyDrop
+           : EHttprSrvSlowPolicySkip;
+}
+
+static bool
+get_zerocopy (void)
+{
+  const char * p_value
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_renderer.http.zerocopy");
+  return (p_value && 0 == strncmp (p_value, "true", strlen ("true")));
+}
+
+static OMX_U32
+get_hls_segment_seconds (void)
+{
+  const char * p_value = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    "OMX.Aratelia.audio_renderer.http.hls_segment_seconds");
+  return (p_value && atoi (p_value) > 0) ? (OMX_U32) atoi (p_value) : 0;
+}
+
+static OMX_U32
+get_hls_segments (void)
+{
+  const char * p_value
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_renderer.http.hls_segments");
+  return (p_value && atoi (p_value) > 0) ? (OMX_U32) atoi (p_value)
+                                         : ICE_HLS_DEFAULT_SEGMENTS;
+}
+
+static const char *
+get_document_root (void)
+{
+  return tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    "OMX.Aratelia.audio_renderer.http.document_root");
+}
+
+static OMX_U32
+get_limit (const char * ap_key)
+{
+  const char * p_value
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION, ap_key);
+  return (p_value && atoi (p_value) > 0) ? (OMX_U32) atoi (p_value) : 0;
+}
+
+static const char *
+get_status_path (void)
+{
+  return tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                               "OMX.Aratelia.audio_renderer.http.status_path");
+}
+
 static void
-release_buffers (httpr_prc_t * ap_prc)
+release_buffers (httpr_prc_t * ap_prc, const OMX_U32 a_pid)
 {
   assert (ap_prc);
+  assert (a_pid < ICE_MAX_MOUNTS);
 
-  if (ap_prc->p_server_ && ap_prc->p_inhdr_)
+  if (ap_prc->p_server_ && ap_prc->p_inhdr_[a_pid])
     {
-      httpr_srv_release_buffers (ap_prc->p_server_);
+      httpr_srv_release_buffers (ap_prc->p_server_, a_pid);
     }
-  assert (NULL == ap_prc->p_inhdr_);
+  assert (NULL == ap_prc->p_inhdr_[a_pid]);
 }
 
 static OMX_BUFFERHEADERTYPE *
-buffer_needed (void * ap_arg)
+buffer_needed (OMX_U32 a_pid, void * ap_arg)
 {
   httpr_prc_t * p_prc = ap_arg;
   OMX_BUFFERHEADERTYPE * p_hdr = NULL;
   assert (p_prc);
+  assert (a_pid < p_prc->nports_);
 
-  if (!p_prc->port_disabled_)
+  if (!p_prc->port_disabled_[a_pid])
     {
-      if (!p_prc->p_inhdr_)
+      if (!p_prc->p_inhdr_[a_pid])
         {
-          (void) tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)),
-                                       ARATELIA_HTTP_RENDERER_PORT_INDEX, 0,
-                                       &p_prc->p_inhdr_);
-          if (p_prc->p_inhdr_)
+          (void) tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)), a_pid, 0,
+                                       &p_prc->p_inhdr_[a_pid]);
+          if (p_prc->p_inhdr_[a_pid])
             {
               TIZ_TRACE (handleOf (p_prc),
-                         "Claimed HEADER [%p]...nFilledLen [%d]",
-                         p_prc->p_inhdr_, p_prc->p_inhdr_->nFilledLen);
+                         "Claimed HEADER [%p] pid [%u]...nFilledLen [%d]",
+                         p_prc->p_inhdr_[a_pid], (unsigned int) a_pid,
+                         p_prc->p_inhdr_[a_pid]->nFilledLen);
             }
         }
-      p_hdr = p_prc->p_inhdr_;
+      p_hdr = p_prc->p_inhdr_[a_pid];
     }
 
   /*   p_prc->awaiting_buffers_ = p_hdr ? false : true; */
@@ -91,49 +168,33 @@ buffer_needed (void * ap_arg)
 }
 
 static void
-buffer_emptied (OMX_BUFFERHEADERTYPE * ap_hdr, void * ap_arg)
+buffer_emptied (OMX_BUFFERHEADERTYPE * ap_hdr, OMX_U32 a_pid, void * ap_arg)
 {
   httpr_prc_t * p_prc = ap_arg;
 
   assert (p_prc);
   assert (ap_hdr);
-  assert (p_prc->p_inhdr_ == ap_hdr);
+  assert (a_pid < p_prc->nports_);
+  assert (p_prc->p_inhdr_[a_pid] == ap_hdr);
   assert (ap_hdr->nFilledLen == 0);
 
   ap_hdr->nOffset = 0;
-  TIZ_TRACE (handleOf (p_prc), "HEADER [%p]", ap_hdr);
+  TIZ_TRACE (handleOf (p_prc), "HEADER [%p] pid [%u]", ap_hdr,
+             (unsigned int) a_pid);
 
   if ((ap_hdr->nFlags & OMX_BUFFERFLAG_EOS) != 0)
     {
       TIZ_TRACE (handleOf (p_prc), "OMX_BUFFERFLAG_EOS in HEADER [%p]", ap_hdr);
-      tiz_srv_issue_event ((OMX_PTR) p_prc, OMX_EventBufferFlag,
-                           ARATELIA_HTTP_RENDERER_PORT_INDEX, ap_hdr->nFlags,
-                           NULL);
+      tiz_srv_issue_event ((OMX_PTR) p_prc, OMX_EventBufferFlag, a_pid,
+                           ap_hdr->nFlags, NULL);
     }
 
-  tiz_krn_release_buffer (tiz_get_krn (handleOf (p_prc)),
-                          ARATELIA_HTTP_RENDERER_PORT_INDEX, ap_hdr);
-  p_prc->p_inhdr_ = NULL;
-}
-
-static inline OMX_ERRORTYPE
-retrieve_mp3_settings (const void * ap_prc,
-                       OMX_AUDIO_PARAM_MP3TYPE * ap_mp3type)
-{
-  const httpr_prc_t * p_prc = ap_prc;
-  assert (ap_prc);
-  assert (ap_mp3type);
-
-  /* Retrieve the mp3 settings from the input port */
-  TIZ_INIT_OMX_PORT_STRUCT (*ap_mp3type, ARATELIA_HTTP_RENDERER_PORT_INDEX);
-  tiz_check_omx (tiz_api_GetParameter (tiz_get_krn (handleOf (p_prc)),
-                                           handleOf (p_prc),
-                                           OMX_IndexParamAudioMp3, ap_mp3type));
-  return OMX_ErrorNone;
+  tiz_krn_release_buffer (tiz_get_krn (handleOf (p_prc)), a_pid, ap_hdr);
+  p_prc->p_inhdr_[a_pid] = NULL;
 }
 
 static inline OMX_ERRORTYPE
-retrieve_mountpoint_settings (const void * ap_prc,
+retrieve_mountpoint_settings (const void * ap_prc, const OMX_U32 a_pid,
                               OMX_TIZONIA_ICECASTMOUNTPOINTTYPE * ap_mountpoint)
 {
   const httpr_prc_t * p_prc = ap_prc;
@@ -141,13 +202,76 @@ retrieve_mountpoint_settings (const void * ap_prc,
   assert (ap_mountpoint);
 
   /* Retrieve the mountpoint settings from the input port */
-  TIZ_INIT_OMX_PORT_STRUCT (*ap_mountpoint, ARATELIA_HTTP_RENDERER_PORT_INDEX);
+  TIZ_INIT_OMX_PORT_STRUCT (*ap_mountpoint, a_pid);
   tiz_check_omx (tiz_api_GetParameter (
     tiz_get_krn (handleOf (p_prc)), handleOf (p_prc),
     OMX_TizoniaIndexParamIcecastMountpoint, ap_mountpoint));
   return OMX_ErrorNone;
 }
 
+/* The input port's encoding is that of its mount point */
+static OMX_ERRORTYPE
+update_audio_settings (const void * ap_prc, const OMX_U32 a_pid,
+                       const OMX_AUDIO_CODINGTYPE a_encoding)
+{
+  const httpr_prc_t * p_prc = ap_prc;
+  assert (p_prc);
+
+  if (OMX_AUDIO_CodingMP3 == a_encoding)
+    {
+      OMX_AUDIO_PARAM_MP3TYPE mp3type;
+      TIZ_INIT_OMX_PORT_STRUCT (mp3type, a_pid);
+      tiz_check_omx (tiz_api_GetParameter (tiz_get_krn (handleOf (p_prc)),
+                                           handleOf (p_prc),
+                                           OMX_IndexParamAudioMp3, &mp3type));
+      httpr_srv_set_audio_settings (p_prc->p_server_, a_pid, a_encoding,
+                                    mp3type.nBitRate, mp3type.nChannels,
+                                    mp3type.nSampleRate);
+    }
+  else
+    {
+      OMX_TIZONIA_AUDIO_PARAM_OPUSTYPE opustype;
+      assert (OMX_AUDIO_CodingOPUS == a_encoding);
+      TIZ_INIT_OMX_PORT_STRUCT (opustype, a_pid);
+      tiz_check_omx (tiz_api_GetParameter (
+        tiz_get_krn (handleOf (p_prc)), handleOf (p_prc),
+        OMX_TizoniaIndexParamAudioOpus, &opustype));
+      /* The Opus bitrate is given in kbps */
+      httpr_srv_set_audio_settings (p_prc->p_server_, a_pid, a_encoding,
+                                    opustype.nBitRate * 1000,
+                                    opustype.nChannels, opustype.nSampleRate);
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+update_mountpoint (httpr_prc_t * ap_prc, const OMX_U32 a_pid)
+{
+  OMX_TIZONIA_ICECASTMOUNTPOINTTYPE * p_mountpoint = NULL;
+  assert (ap_prc);
+  assert (a_pid < ap_prc->nports_);
+
+  /* Obtain mount point and station-related information */
+  p_mountpoint = &(ap_prc->mountpoint_[a_pid]);
+  tiz_check_omx (retrieve_mountpoint_settings (ap_prc, a_pid, p_mountpoint));
+
+  tiz_check_omx (
+    update_audio_settings (ap_prc, a_pid, p_mountpoint->eEncoding));
+
+  httpr_srv_set_mountpoint_settings (
+    ap_prc->p_server_, a_pid, p_mountpoint->cMountName,
+    p_mountpoint->cStationName, p_mountpoint->cStationDescription,
+    p_mountpoint->cStationGenre, p_mountpoint->cStationUrl,
+    p_mountpoint->nIcyMetadataPeriod,
+    (p_mountpoint->bBurstOnConnect == OMX_TRUE
+       ? p_mountpoint->nInitialBurstSize
+       : 0),
+    p_mountpoint->nMaxClients);
+
+  return httpr_prc_config_change (ap_prc, a_pid,
+                                  OMX_TizoniaIndexConfigIcecastMetadata);
+}
+
 /*
  * httprprc
  */
@@ -158,9 +282,10 @@ httpr_prc_ctor (void * ap_prc, va_list * app)
   httpr_prc_t * p_prc = super_ctor (typeOf (ap_prc, "httprprc"), ap_prc, app);
   assert (p_prc);
   p_prc->mount_name_ = NULL;
-  p_prc->port_disabled_ = false;
+  p_prc->nports_ = 1;
   p_prc->p_server_ = NULL;
-  p_prc->p_inhdr_ = NULL;
+  tiz_mem_set (p_prc->port_disabled_, 0, sizeof (p_prc->port_disabled_));
+  tiz_mem_set (p_prc->p_inhdr_, 0, sizeof (p_prc->p_inhdr_));
   return p_prc;
 }
 
@@ -178,15 +303,23 @@ static OMX_ERRORTYPE
 httpr_prc_allocate_resources (void * ap_prc, OMX_U32 a_pid)
 {
   httpr_prc_t * p_prc = ap_prc;
+  OMX_PORT_PARAM_TYPE port_param;
   assert (p_prc);
 
+  /* There is a mount point for each of the input ports */
+  TIZ_INIT_OMX_STRUCT (port_param);
+  tiz_check_omx (tiz_api_GetParameter (tiz_get_krn (handleOf (p_prc)),
+                                       handleOf (p_prc),
+                                       OMX_IndexParamAudioInit, &port_param));
+  p_prc->nports_ = MAX (1, MIN (port_param.nPorts, ICE_MAX_MOUNTS));
+
   /* Retrieve http server configuration from the component's config port */
   TIZ_INIT_OMX_STRUCT (p_prc->server_info_);
   tiz_check_omx (tiz_api_GetParameter (
     tiz_get_krn (handleOf (p_prc)), handleOf (p_prc),
     OMX_TizoniaIndexParamHttpServer, &p_prc->server_info_));
 
-  return httpr_srv_init (
+  tiz_check_omx (httpr_srv_init (
     &(p_prc->p_server_), p_prc, p_prc->server_info_.cBindAddress, /* if this is
                                                             * null, the
                                                             * server will
@@ -194,7 +327,24 @@ httpr_prc_allocate_resources (void * ap_prc, OMX_U32 a_pid)
                                                             * all
                                                             * interfaces. */
     p_prc->server_info_.nListeningPort, p_prc->server_info_.nMaxClients,
-    buffer_emptied, buffer_needed, p_prc);
+    p_prc->nports_, buffer_emptied, buffer_needed, p_prc, get_ring_size (),
+    get_slow_listener_policy ()));
+
+  httpr_srv_set_zerocopy (p_prc->p_server_, get_zerocopy ());
+  tiz_check_omx (httpr_srv_set_hls (p_prc->p_server_,
+                                    get_hls_segment_seconds (),
+                                    get_hls_segments ()));
+  tiz_check_omx (
+    httpr_srv_set_document_root (p_prc->p_server_, get_document_root ()));
+  httpr_srv_set_limits (
+    p_prc->p_server_,
+    get_limit ("OMX.Aratelia.audio_renderer.http.max_listener_lag_ms"),
+    get_limit ("OMX.Aratelia.audio_renderer.http.max_listener_lag_kb") * 1024,
+    get_limit ("OMX.Aratelia.audio_renderer.http.max_memory_kb"),
+    get_limit ("OMX.Aratelia.audio_renderer.http.max_accepts_per_sec"));
+  tiz_check_omx (
+    httpr_srv_set_status_path (p_prc->p_server_, get_status_path ()));
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
@@ -211,33 +361,14 @@ static OMX_ERRORTYPE
 httpr_prc_prepare_to_transfer (void * ap_prc, OMX_U32 a_pid)
 {
   httpr_prc_t * p_prc = ap_prc;
+  OMX_U32 pid = 0;
 
   assert (p_prc);
 
-  /* Obtain mp3 settings from port */
-  tiz_check_omx (retrieve_mp3_settings (ap_prc, &(p_prc->mp3type_)));
-
-  httpr_srv_set_mp3_settings (p_prc->p_server_, p_prc->mp3type_.nBitRate,
-                              p_prc->mp3type_.nChannels,
-                              p_prc->mp3type_.nSampleRate);
-
-  /* Obtain mount point and station-related information */
-  tiz_check_omx (
-    retrieve_mountpoint_settings (ap_prc, &(p_prc->mountpoint_)));
-
-  httpr_srv_set_mountpoint_settings (
-    p_prc->p_server_, p_prc->mountpoint_.cMountName,
-    p_prc->mountpoint_.cStationName, p_prc->mountpoint_.cStationDescription,
-    p_prc->mountpoint_.cStationGenre, p_prc->mountpoint_.cStationUrl,
-    p_prc->mountpoint_.nIcyMetadataPeriod,
-    (p_prc->mountpoint_.bBurstOnConnect == OMX_TRUE
-       ? p_prc->mountpoint_.nInitialBurstSize
-       : 0),
-    p_prc->mountpoint_.nMaxClients);
-
-  tiz_check_omx (
-    httpr_prc_config_change (p_prc, ARATELIA_HTTP_RENDERER_PORT_INDEX,
-                             OMX_TizoniaIndexConfigIcecastMetadata));
+  for (pid = 0; pid < p_prc->nports_; ++pid)
+    {
+      tiz_check_omx (update_mountpoint (p_prc, pid));
+    }
 
   return httpr_srv_start (p_prc->p_server_);
 }
@@ -253,9 +384,13 @@ httpr_prc_stop_and_return (void * ap_prc)
 {
   httpr_prc_t * p_prc = ap_prc;
   OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_U32 pid = 0;
   assert (p_prc);
   rc = httpr_srv_stop (p_prc->p_server_);
-  release_buffers (p_prc);
+  for (pid = 0; pid < p_prc->nports_; ++pid)
+    {
+      release_buffers (p_prc, pid);
+    }
   return rc;
 }
 
@@ -299,7 +434,7 @@ httpr_prc_timer_ready (void * ap_prc, tiz_event_timer_t * ap_ev_timer,
   assert (p_prc);
   if (p_prc->p_server_)
     {
-      rc = httpr_srv_timer_event (p_prc->p_server_);
+      rc = httpr_srv_timer_event (p_prc->p_server_, ap_ev_timer);
     }
   return rc;
 }
@@ -308,19 +443,19 @@ static OMX_ERRORTYPE
 httpr_prc_port_enable (const void * ap_prc, OMX_U32 a_pid)
 {
   httpr_prc_t * p_prc = (httpr_prc_t *) ap_prc;
+  OMX_U32 pid = 0;
 
   assert (ap_prc);
-  assert (ARATELIA_HTTP_RENDERER_PORT_INDEX == a_pid);
-
-  p_prc->port_disabled_ = false;
+  assert (OMX_ALL == a_pid || a_pid < p_prc->nports_);
 
-  tiz_check_omx (retrieve_mp3_settings (p_prc, &(p_prc->mp3type_)));
-  httpr_srv_set_mp3_settings (p_prc->p_server_, p_prc->mp3type_.nBitRate,
-                              p_prc->mp3type_.nChannels,
-                              p_prc->mp3type_.nSampleRate);
-  tiz_check_omx (
-    httpr_prc_config_change (p_prc, ARATELIA_HTTP_RENDERER_PORT_INDEX,
-                             OMX_TizoniaIndexConfigIcecastMetadata));
+  for (pid = 0; pid < p_prc->nports_; ++pid)
+    {
+      if (OMX_ALL == a_pid || pid == a_pid)
+        {
+          p_prc->port_disabled_[pid] = false;
+          tiz_check_omx (update_mountpoint (p_prc, pid));
+        }
+    }
   return OMX_ErrorNone;
 }
 
@@ -328,8 +463,18 @@ static OMX_ERRORTYPE
 httpr_prc_port_disable (const void * ap_prc, OMX_U32 a_pid)
 {
   httpr_prc_t * p_prc = (httpr_prc_t *) ap_prc;
-  p_prc->port_disabled_ = true;
-  release_buffers (p_prc);
+  OMX_U32 pid = 0;
+
+  assert (ap_prc);
+
+  for (pid = 0; pid < p_prc->nports_; ++pid)
+    {
+      if (OMX_ALL == a_pid || pid == a_pid)
+        {
+          p_prc->port_disabled_[pid] = true;
+          release_buffers (p_prc, pid);
+        }
+    }
   return OMX_ErrorNone;
 }
 
@@ -343,7 +488,7 @@ httpr_prc_config_change (const void * ap_prc, const OMX_U32 a_pid,
   assert (ap_prc);
 
   if (p_prc->p_server_ && OMX_TizoniaIndexConfigIcecastMetadata == a_config_idx
-      && ARATELIA_HTTP_RENDERER_PORT_INDEX == a_pid)
+      && a_pid < p_prc->nports_)
     {
       OMX_TIZONIA_ICECASTMETADATATYPE * p_metadata
         = (OMX_TIZONIA_ICECASTMETADATATYPE *) tiz_mem_calloc (
@@ -353,7 +498,7 @@ httpr_prc_config_change (const void * ap_prc, const OMX_U32 a_pid,
       tiz_check_null_ret_oom (p_metadata);
 
       /* Retrieve the updated icecast metadata from the input port */
-      TIZ_INIT_OMX_PORT_STRUCT (*p_metadata, ARATELIA_HTTP_RENDERER_PORT_INDEX);
+      TIZ_INIT_OMX_PORT_STRUCT (*p_metadata, a_pid);
       p_metadata->nSize = sizeof (OMX_TIZONIA_ICECASTMETADATATYPE)
                           + OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE;
 
@@ -369,7 +514,7 @@ httpr_prc_config_change (const void * ap_prc, const OMX_U32 a_pid,
         }
       else
         {
-          httpr_srv_set_stream_title (p_prc->p_server_,
+          httpr_srv_set_stream_title (p_prc->p_server_, a_pid,
                                       p_metadata->cStreamTitle);
         }
 
@@ -40,6 +40,7 @@ extern "C" {
 
 #include <tizprc_decls.h>
 
+#include "httpr.h"
 #include "httprsrv.h"
 
 typedef struct httpr_prc httpr_prc_t;
@@ -48,13 +49,13 @@ struct httpr_prc
   /* Object */
   const tiz_prc_t _;
   OMX_STRING mount_name_;
-  bool port_disabled_;
+  OMX_U32 nports_; /* One mount point per input port */
+  bool port_disabled_[ICE_MAX_MOUNTS];
   int lstn_sockfd_;
   httpr_server_t * p_server_;
-  OMX_BUFFERHEADERTYPE * p_inhdr_;
-  OMX_AUDIO_PARAM_MP3TYPE mp3type_;
+  OMX_BUFFERHEADERTYPE * p_inhdr_[ICE_MAX_MOUNTS];
   OMX_TIZONIA_HTTPSERVERTYPE server_info_;
-  OMX_TIZONIA_ICECASTMOUNTPOINTTYPE mountpoint_;
+  OMX_TIZONIA_ICECASTMOUNTPOINTTYPE mountpoint_[ICE_MAX_MOUNTS];
 };
 
 typedef struct httpr_prc_class httpr_prc_class_t;
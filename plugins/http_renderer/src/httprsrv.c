@@ -23,10 +23,6 @@
  *
  * @brief Tizonia - HTTP renderer's networking functions
  *
- * NOTE: This is work in progress!!!!
- *
- * TODO: Better flow control
- *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -34,7 +30,10 @@
 #endif
 
 #include <assert.h>
+#include <ctype.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -43,9 +42,18 @@
 #include <sys/socket.h>
 #include <netdb.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
+#include <limits.h>
 #include <time.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <sys/sendfile.h>
+#define ICE_HAVE_SENDFILE 1
+#endif
 
 #include <tizplatform.h>
 #include <tizutils.h>
@@ -53,6 +61,7 @@
 #include <OMX_TizoniaExt.h>
 
 #include "httpr.h"
+#include "httprdoc.h"
 #include "httprsrv.h"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
@@ -66,21 +75,121 @@
 #define ICE_RENDERER_MAX_ADDR_LEN 46
 #endif
 
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) \
+  && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define ICE_HAVE_ZEROCOPY 1
+#endif
+
 typedef struct httpr_connection httpr_connection_t;
 typedef struct httpr_listener httpr_listener_t;
 typedef struct httpr_listener_buffer httpr_listener_buffer_t;
 typedef struct httpr_mount httpr_mount_t;
+typedef struct httpr_chunk httpr_chunk_t;
+typedef struct httpr_ring httpr_ring_t;
+typedef struct httpr_zc_send httpr_zc_send_t;
+typedef struct httpr_icy_block httpr_icy_block_t;
+typedef struct httpr_hls_segment httpr_hls_segment_t;
+typedef struct httpr_hls httpr_hls_t;
+typedef struct httpr_stats httpr_stats_t;
+typedef struct httpr_strbuf httpr_strbuf_t;
 
 struct httpr_listener_buffer
 {
   unsigned int len;
-  unsigned int metadata_offset;
-  unsigned int metadata_bytes;
+  unsigned int offset;
+  char * p_data;
+};
+
+/* The ring chunks pinned by a MSG_ZEROCOPY send until the kernel reports
+   its completion */
+struct httpr_zc_send
+{
+  uint64_t first;
+  uint64_t last;
+  bool done;
+};
+
+/* An encoded ICY metadata block, shared by every listener that has it
+   pending. Encoded once per stream title. */
+struct httpr_icy_block
+{
+  OMX_U32 refs;
+  OMX_U32 len;
+  uint32_t gen; /* Stream title generation */
+  char data[];
+};
+
+/* A finished HLS segment, shared by every listener downloading it */
+struct httpr_hls_segment
+{
+  OMX_U32 refs;
+  uint64_t seq;
+  double duration; /* Seconds */
+  OMX_U32 len;
+  OMX_U8 data[];
+};
+
+struct httpr_hls
+{
+  char base[OMX_MAX_STRINGNAME_SIZE]; /* e.g. '/hi' for '/hi.m3u8' */
+  httpr_hls_segment_t ** pp_segments; /* The last few, by sequence number */
+  uint64_t next_seq;  /* Sequence number of the segment being built */
+  OMX_U8 * p_build;   /* The segment being built, after room for its tag */
+  OMX_U32 build_len;
+  OMX_U32 build_cap;
+  OMX_U32 parsed;     /* End of the whole MP3 frames in p_build */
+  double build_time;  /* Duration of those frames */
+  double start_time;  /* Stream time at which the segment being built starts */
+  uint64_t chunk;     /* The segmenter's cursor in the ring */
+  OMX_U32 offset;
+};
+
+/* Server-wide counters, reported by the status endpoint */
+struct httpr_stats
+{
+  time_t start_time;
+  uint64_t accepted;
+  uint64_t rejected_clients; /* Over the client limit */
+  uint64_t rejected_rate;    /* Over the accept rate */
+  uint64_t rejected_memory;  /* Over the memory cap */
+  uint64_t skipped;          /* Slow listeners moved to the live edge */
+  uint64_t dropped;          /* Slow listeners disconnected */
+  uint64_t failed;           /* Listeners lost to socket errors */
+  uint64_t bytes_sent;       /* By the listeners already gone */
+};
+
+/* A growable string, e.g. for a status report */
+struct httpr_strbuf
+{
   char * p_data;
+  size_t len;
+  size_t cap;
+  bool failed;
+};
+
+struct httpr_chunk
+{
+  OMX_U8 * p_data;
+  uint64_t pos; /* Stream offset of the chunk's first byte */
+  OMX_U32 len;
+  OMX_U32 refs; /* Number of listeners that are yet to send this chunk */
+};
+
+struct httpr_ring
+{
+  httpr_chunk_t * p_chunks;
+  OMX_U8 * p_store;
+  OMX_U32 nchunks;
+  OMX_U32 chunk_size;
+  uint64_t head; /* Sequence number of the next chunk to be written */
+  uint64_t tail; /* Sequence number of the oldest chunk in the ring */
+  uint64_t head_pos; /* Stream bytes written into the ring so far */
+  OMX_U32 nreaders;
 };
 
 struct httpr_mount
 {
+  OMX_U32 pid; /* The input port that feeds this mount point */
   OMX_U8 mount_name[OMX_MAX_STRINGNAME_SIZE];
   OMX_U8 station_name[OMX_MAX_STRINGNAME_SIZE];
   OMX_U8 station_description[OMX_MAX_STRINGNAME_SIZE];
@@ -90,6 +199,18 @@ struct httpr_mount
   OMX_U8 stream_title[OMX_MAX_STRINGNAME_SIZE];
   OMX_U32 initial_burst_size;
   OMX_U32 max_clients;
+  OMX_AUDIO_CODINGTYPE encoding;
+  OMX_U32 bitrate;
+  OMX_U32 num_channels;
+  OMX_U32 sample_rate;
+  double bytes_per_sec;
+  OMX_U32 burst_size; /* Bytes let out on every tick of the clock */
+  uint64_t pace_limit; /* Stream offset the listeners may send up to */
+  httpr_ring_t ring;
+  OMX_BUFFERHEADERTYPE * p_hdr;
+  httpr_icy_block_t * p_icy; /* The current stream title, encoded */
+  uint32_t icy_gen;
+  httpr_hls_t hls;
 };
 
 struct httpr_connection
@@ -98,29 +219,56 @@ struct httpr_connection
   time_t con_time;
   uint64_t sent_total;
   unsigned int sent_last;
-  unsigned int burst_bytes;
-  OMX_S32 initial_burst_bytes;
-  bool metadata_delivered;
   int sockfd;
   char * p_host;
   char * p_ip;
   unsigned short port;
-  tiz_event_io_t * p_ev_io;
-  tiz_event_timer_t * p_ev_timer;
+  tiz_event_io_t * p_ev_io;    /* Writable */
+  tiz_event_io_t * p_ev_io_rd; /* A request is waiting */
 };
 
 struct httpr_listener
 {
   httpr_server_t * p_server;
   httpr_connection_t * p_con;
+  httpr_mount_t * p_mount; /* NULL until the request has been routed */
   int respcode;
   long intro_offset;
-  unsigned long pos;
-  httpr_listener_buffer_t buf;
+  uint64_t chunk;  /* Sequence number of the ring chunk being sent */
+  OMX_U32 offset;  /* Bytes of that chunk already sent */
+  OMX_U32 metaint;      /* Negotiated ICY metadata interval; 0 if none */
+  OMX_U32 metaint_left; /* Audio bytes until the next metadata block */
+  const char * p_meta;  /* ICY metadata block being sent, or NULL */
+  OMX_U32 meta_len;
+  OMX_U32 meta_offset;
+  httpr_icy_block_t * p_meta_block; /* Reference held while p_meta is sent */
+  uint32_t meta_gen; /* Title generation last delivered to this listener */
+  OMX_U32 skips;     /* Times moved forward for being too slow */
+  bool oneshot; /* A complete response: the headers in buf, then the body
+                   from p_segment or file_fd, if any */
+  httpr_hls_segment_t * p_segment; /* Reference held while it is sent */
+  OMX_U32 segment_offset;
+  OMX_U32 segment_end;
+  int file_fd; /* The local file being sent, or -1 */
+  off_t file_offset;
+  off_t file_end;
+  bool keepalive; /* Wait for another request once the response is out */
+  OMX_U32 nrequests;
+  time_t idle_since; /* When the listener started waiting for a request */
+  httpr_listener_buffer_t buf; /* HTTP request or response */
   tiz_http_parser_t * p_parser;
   bool need_response;
-  bool timer_started;
-  bool want_metadata;
+  bool ready;    /* In the server's ready list, i.e. not blocked on I/O */
+  bool attached; /* Reading from the ring */
+  bool starved;  /* Waiting for the next OMX buffer */
+  bool failed;   /* To be removed once the current event has been handled */
+  bool corked;
+  bool zerocopy;
+  uint32_t zc_head; /* Id of the next MSG_ZEROCOPY send */
+  uint32_t zc_tail; /* Id of the oldest uncompleted MSG_ZEROCOPY send */
+  httpr_zc_send_t zc_sends[ICE_ZEROCOPY_MAX_INFLIGHT];
+  httpr_listener_t * p_prev_ready;
+  httpr_listener_t * p_next_ready;
 };
 
 struct httpr_server
@@ -129,23 +277,32 @@ struct httpr_server
   int lstn_sockfd;
   char * p_ip;
   tiz_event_io_t * p_srv_ev_io;
-  OMX_U32 max_clients; /* In future, more than one will be allowed;
-                          only one allowed at the moment. */
+  OMX_U32 max_clients;
   tiz_map_t * p_lstnrs;
-  OMX_BUFFERHEADERTYPE * p_hdr;
+  httpr_listener_t * p_ready; /* Listeners that can be written to */
+  tiz_event_timer_t * p_ev_timer; /* The pacing clock */
+  bool pacing;
+  httpr_srv_slow_policy_t slow_policy;
+  bool zerocopy;
   httpr_srv_release_buffer_f pf_release_buf;
   httpr_srv_acquire_buffer_f pf_acquire_buf;
-  bool need_more_data;
   bool running;
   OMX_PTR p_arg;
-  OMX_U32 bitrate;
-  OMX_U32 num_channels;
-  OMX_U32 sample_rate;
-  OMX_U32 bytes_per_frame;
-  OMX_U32 burst_size;
   double wait_time;
   double pkts_per_sec;
-  httpr_mount_t mountpoint;
+  httpr_mount_t * p_mounts;
+  OMX_U32 nmounts;
+  OMX_U32 hls_segment_secs; /* 0 if HLS is disabled */
+  OMX_U32 hls_nsegments;
+  char * p_docroot; /* Local files are served from here; NULL if none */
+  char * p_status_path; /* The status report is served here; NULL if none */
+  OMX_U32 max_lag_ms;    /* Listener lag limits; 0 if none */
+  OMX_U32 max_lag_bytes;
+  size_t max_memory;     /* 0 if none */
+  OMX_U32 max_accepts_per_sec; /* 0 if none */
+  double accept_tokens;
+  double accept_time;
+  httpr_stats_t stats;
 };
 
 static void
@@ -183,12 +340,23 @@ srv_is_recoverable_error (httpr_server_t * ap_server, int sockfd, int error)
 #if defined(EWOULDBLOCK) && EWOULDBLOCK != EAGAIN
       case EWOULDBLOCK:
 #endif
+      case EINTR:
+      case ENOBUFS: /* e.g. out of option memory for MSG_ZEROCOPY */
         {
           rc = true;
         }
         break;
+      case EPIPE:
+      case ECONNRESET:
+        {
+          /* The listener has gone away */
+          rc = false;
+        }
+        break;
       default:
         {
+          TIZ_NOTICE (handleOf (ap_server->p_parent), "Socket [%d] : [%s]",
+                      sockfd, strerror (error));
           rc = false;
         }
         break;
@@ -206,694 +374,2760 @@ srv_is_valid_socket (int a_sockfd)
 }
 
 static inline int
-srv_get_listeners_count (const httpr_server_t * ap_server)
+srv_set_notsent_lowat (const int sock)
 {
-  int rc = 0;
-  if (ap_server && ap_server->p_lstnrs)
-    {
-      rc = tiz_map_size (ap_server->p_lstnrs);
-    }
-  return rc;
+#ifdef TCP_NOTSENT_LOWAT
+  /* Keep the unsent backlog in the ring rather than in the socket buffer, so
+     that slow listeners are detected there */
+  int lowat = ICE_NOTSENT_LOWAT;
+  errno = 0;
+  return setsockopt (sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT, (void *) &lowat,
+                     sizeof (int));
+#else
+  return 0;
+#endif
 }
 
-static httpr_listener_t *
-srv_get_first_listener (const httpr_server_t * ap_server)
+static inline int
+srv_set_cork (const int sock, const bool a_cork)
 {
-  httpr_listener_t * p_lstnr = NULL;
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      p_lstnr = tiz_map_value_at (ap_server->p_lstnrs, 0);
-    }
-  return p_lstnr;
+#ifdef TCP_CORK
+  int cork = a_cork ? 1 : 0;
+  errno = 0;
+  return setsockopt (sock, IPPROTO_TCP, TCP_CORK, (void *) &cork,
+                     sizeof (int));
+#else
+  return 0;
+#endif
 }
 
-static int
-srv_set_non_blocking (const int sockfd)
+static inline int
+srv_set_zerocopy (const int sock)
 {
-  int rc = ICE_SOCK_ERROR;
-  int flags;
+#ifdef ICE_HAVE_ZEROCOPY
+  int zerocopy = 1;
   errno = 0;
-  if ((flags = fcntl (sockfd, F_GETFL, 0)) != ICE_SOCK_ERROR)
-    {
-      errno = 0;
-      flags |= O_NONBLOCK;
-      if (fcntl (sockfd, F_SETFL, flags) != ICE_SOCK_ERROR)
-        {
-          rc = 0;
-        }
-    }
-  return rc;
+  return setsockopt (sock, SOL_SOCKET, SO_ZEROCOPY, (void *) &zerocopy,
+                     sizeof (int));
+#else
+  return ICE_SOCK_ERROR;
+#endif
 }
 
 static inline int
-srv_set_nolinger (const int sock)
+srv_set_abortive_close (const int sock)
 {
-  struct linger lin = {0, 0};
+  struct linger lin = {1, 0};
   errno = 0;
-  /* linger inactive. close call will return immediately to the caller, and any
-   * pending data will be delivered if possible. */
+  /* close will reset the connection and discard any unsent data */
   return setsockopt (sock, SOL_SOCKET, SO_LINGER, (void *) &lin,
                      sizeof (struct linger));
 }
 
 static inline int
-srv_set_nodelay (const int sock)
+srv_get_listeners_count (const httpr_server_t * ap_server)
 {
-  int nodelay = 1;
-  errno = 0;
-  return setsockopt (sock, IPPROTO_TCP, TCP_NODELAY, (void *) &nodelay,
-                     sizeof (int));
+  int rc = 0;
+  if (ap_server && ap_server->p_lstnrs)
+    {
+      rc = tiz_map_size (ap_server->p_lstnrs);
+    }
+  return rc;
 }
 
-static inline int
-srv_set_keepalive (const int sock)
+static inline httpr_listener_t *
+srv_get_listener_at (const httpr_server_t * ap_server, const int a_pos)
 {
-  int keepalive = 1;
-  errno = 0;
-  return setsockopt (sock, SOL_SOCKET, SO_KEEPALIVE, (void *) &keepalive,
-                     sizeof (int));
+  assert (ap_server);
+  assert (a_pos < srv_get_listeners_count (ap_server));
+  return tiz_map_value_at (ap_server->p_lstnrs, a_pos);
 }
 
-static int
-srv_accept_socket (httpr_server_t * ap_server, char * ap_ip,
-                   const size_t a_ip_len, unsigned short * ap_port)
-{
-#define bail_on_accept_error(some_error, msg) \
-  do                                          \
-    {                                         \
-      if (some_error)                         \
-        {                                     \
-          TIZ_ERROR (p_hdl, "[%s]", msg);     \
-          goto end;                           \
-        }                                     \
-    }                                         \
-  while (0)
-
-  int accepted_sockfd = ICE_SOCK_ERROR;
-  struct sockaddr_storage sa;
-  socklen_t slen = sizeof (sa);
-  OMX_HANDLETYPE p_hdl = NULL;
-  bool some_error = true;
-  int err = 0;
+/* The block sent at every metadata interval once a listener has the current
+   stream title */
+static const char g_icy_empty_block[1] = {0};
 
-  assert (ap_server);
-  assert (ap_ip);
-  assert (ap_port);
-  p_hdl = handleOf (ap_server->p_parent);
+/* Encodes the stream title as an ICY metadata block: a length byte, in
+   units of 16 bytes, followed by the zero-padded title */
+static httpr_icy_block_t *
+srv_icy_block_encode (const OMX_U8 * ap_title, const uint32_t a_gen)
+{
+  httpr_icy_block_t * p_block = NULL;
+  size_t title_len = 0;
+  size_t nunits = 0;
 
-  some_error = (!srv_is_valid_socket (ap_server->lstn_sockfd));
-  bail_on_accept_error (some_error, "Invalid server socket");
+  assert (ap_title);
 
-  errno = 0;
-  accepted_sockfd
-    = accept (ap_server->lstn_sockfd, (struct sockaddr *) &sa, &slen);
-  some_error = (ICE_SOCK_ERROR == accepted_sockfd);
-  bail_on_accept_error (some_error, strerror (errno));
+  title_len = strnlen ((const char *) ap_title,
+                       OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
+  nunits = MIN ((title_len + 15) / 16, 255);
+  title_len = MIN (title_len, nunits * 16);
 
-  if (0 != (err = getnameinfo ((struct sockaddr *) &sa, slen, ap_ip, a_ip_len,
-                               NULL, 0, NI_NUMERICHOST)))
-    {
-      snprintf (ap_ip, a_ip_len, "unknown");
-      TIZ_ERROR (p_hdl, "getnameinfo error [%s]", gai_strerror (err));
-    }
-  else
+  p_block = (httpr_icy_block_t *) tiz_mem_calloc (
+    1, sizeof (httpr_icy_block_t) + (nunits * 16) + 1);
+  if (p_block)
     {
-      if (sa.ss_family == AF_INET)
-        {
-          struct sockaddr_in * p_sa_in = (struct sockaddr_in *) &sa;
-          *ap_port = ntohs (p_sa_in->sin_port);
-        }
+      p_block->refs = 1;
+      p_block->len = (nunits * 16) + 1;
+      p_block->gen = a_gen;
+      p_block->data[0] = (char) nunits;
+      memcpy (p_block->data + 1, ap_title, title_len);
     }
+  return p_block;
+}
 
-  err = srv_set_nolinger (accepted_sockfd);
-  some_error = (ICE_SOCK_ERROR == err);
-  bail_on_accept_error (some_error, strerror (errno));
-
-  err = srv_set_keepalive (accepted_sockfd);
-  some_error = (ICE_SOCK_ERROR == err);
-  bail_on_accept_error (some_error, strerror (errno));
-
-  TIZ_TRACE (p_hdl, "Accepted [%s:%u] fd [%d]", ap_ip, *ap_port,
-             accepted_sockfd);
-end:
-  if (some_error)
+static inline void
+srv_icy_block_unref (httpr_icy_block_t * ap_block)
+{
+  if (ap_block && 0 == --ap_block->refs)
     {
-      close (accepted_sockfd);
-      accepted_sockfd = ICE_SOCK_ERROR;
+      tiz_mem_free (ap_block);
     }
-
-  return accepted_sockfd;
 }
 
-static inline int
-srv_create_server_socket (httpr_server_t * ap_server, const int a_port,
-                          const char * a_interface)
+/* The block that is due next for a listener that has received the title
+   of generation 'a_gen': the current title, if newer, and an empty block
+   otherwise. NULL stands for the empty block. */
+static inline httpr_icy_block_t *
+srv_icy_next (const httpr_mount_t * ap_mount, const uint32_t a_gen)
 {
-  struct sockaddr_storage sa;
-  struct addrinfo hints;
-  struct addrinfo * res;
-  struct addrinfo * ai;
-  char service[10];
-  int sockfd = ICE_SOCK_ERROR;
-  int getaddrc = ICE_SOCK_ERROR;
-
-  assert (ap_server);
-  assert (a_port >= 0);
+  assert (ap_mount);
+  return (ap_mount->p_icy && ap_mount->p_icy->gen != a_gen) ? ap_mount->p_icy
+                                                            : NULL;
+}
 
-  tiz_mem_set (&sa, 0, sizeof (sa));
-  tiz_mem_set (&hints, 0, sizeof (hints));
+/* Makes the next block pending in the listener's stream. The block is
+   referenced, not copied, so a title change while it is being sent doesn't
+   affect it. */
+static void
+srv_icy_arrange (httpr_listener_t * ap_lstnr)
+{
+  httpr_icy_block_t * p_block = NULL;
 
-  hints.ai_family = AF_UNSPEC;
-  hints.ai_flags = AI_PASSIVE | AI_ADDRCONFIG | AI_NUMERICSERV | AI_NUMERICHOST;
-  hints.ai_socktype = SOCK_STREAM;
-  snprintf (service, sizeof (service), "%d", a_port);
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_mount);
+  assert (!ap_lstnr->p_meta);
 
-  if ((getaddrc = getaddrinfo (a_interface, service, &hints, &res)) != 0)
+  p_block = srv_icy_next (ap_lstnr->p_mount, ap_lstnr->meta_gen);
+  if (p_block)
     {
-      TIZ_ERROR (handleOf (ap_server->p_parent), "[ICE_SOCK_ERROR] : %s.",
-                 gai_strerror (getaddrc));
+      p_block->refs++;
+      ap_lstnr->p_meta = p_block->data;
+      ap_lstnr->meta_len = p_block->len;
     }
   else
     {
-      ai = res;
-      do
-        {
-          int on = 1;
-          sockfd = socket (ai->ai_family, ai->ai_socktype, ai->ai_protocol);
-          if (sockfd < 0)
-            {
-              continue;
-            }
-
-          setsockopt (sockfd, SOL_SOCKET, SO_REUSEADDR, (const void *) &on,
-                      sizeof (on));
-          on = 0;
+      ap_lstnr->p_meta = g_icy_empty_block;
+      ap_lstnr->meta_len = sizeof (g_icy_empty_block);
+    }
+  ap_lstnr->p_meta_block = p_block;
+  ap_lstnr->meta_offset = 0;
+}
 
-          if (bind (sockfd, ai->ai_addr, ai->ai_addrlen) < 0)
-            {
-              close (sockfd);
-              continue;
-            }
+/* The title counts as delivered once its whole block has been sent */
+static void
+srv_icy_advance (httpr_listener_t * ap_lstnr, const size_t a_bytes)
+{
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_meta);
+  assert (ap_lstnr->meta_offset + a_bytes <= ap_lstnr->meta_len);
 
-          freeaddrinfo (res);
-          return sockfd;
+  ap_lstnr->meta_offset += a_bytes;
+  if (ap_lstnr->meta_offset == ap_lstnr->meta_len)
+    {
+      if (ap_lstnr->p_meta_block)
+        {
+          ap_lstnr->meta_gen = ap_lstnr->p_meta_block->gen;
+          srv_icy_block_unref (ap_lstnr->p_meta_block);
+          ap_lstnr->p_meta_block = NULL;
         }
-      while ((ai = ai->ai_next));
-
-      freeaddrinfo (res);
+      ap_lstnr->p_meta = NULL;
+      ap_lstnr->meta_len = 0;
+      ap_lstnr->meta_offset = 0;
     }
-  return ICE_SOCK_ERROR;
 }
 
-static void
-srv_destroy_server_io_watcher (httpr_server_t * ap_server)
+static inline httpr_chunk_t *
+srv_ring_chunk (const httpr_ring_t * ap_ring, const uint64_t a_seq)
 {
-  assert (ap_server);
-  tiz_srv_io_watcher_destroy (ap_server->p_parent, ap_server->p_srv_ev_io);
-  ap_server->p_srv_ev_io = NULL;
+  assert (ap_ring);
+  assert (ap_ring->nchunks > 0);
+  return &(ap_ring->p_chunks[a_seq % ap_ring->nchunks]);
 }
 
 static OMX_ERRORTYPE
-srv_allocate_server_io_watcher (httpr_server_t * ap_server)
+srv_ring_init (httpr_ring_t * ap_ring, const OMX_U32 a_size,
+               const OMX_U32 a_chunk_size)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  assert (ap_server);
-
-  rc = tiz_srv_io_watcher_init (
-    ap_server->p_parent, &(ap_server->p_srv_ev_io), ap_server->lstn_sockfd,
-    TIZ_EVENT_READ, /* Interested in read events only */
-    true            /* Only one event at a time */
-    );
-  if (OMX_ErrorNone != rc)
+  OMX_U32 i = 0;
+  assert (ap_ring);
+  assert (a_chunk_size > 0);
+
+  ap_ring->chunk_size = a_chunk_size;
+  ap_ring->nchunks = MAX (2, a_size / a_chunk_size);
+  ap_ring->head = 0;
+  ap_ring->tail = 0;
+  ap_ring->head_pos = 0;
+  ap_ring->nreaders = 0;
+  ap_ring->p_chunks = (httpr_chunk_t *) tiz_mem_calloc (
+    ap_ring->nchunks, sizeof (httpr_chunk_t));
+  ap_ring->p_store = (OMX_U8 *) tiz_mem_alloc (ap_ring->nchunks
+                                               * ap_ring->chunk_size);
+  if (!ap_ring->p_chunks || !ap_ring->p_store)
     {
-      srv_destroy_server_io_watcher (ap_server);
+      return OMX_ErrorInsufficientResources;
     }
 
-  return rc;
+  for (i = 0; i < ap_ring->nchunks; ++i)
+    {
+      ap_ring->p_chunks[i].p_data = ap_ring->p_store + i * ap_ring->chunk_size;
+    }
+  return OMX_ErrorNone;
 }
 
-static OMX_ERRORTYPE
-srv_start_server_io_watcher (httpr_server_t * ap_server)
+static void
+srv_ring_destroy (httpr_ring_t * ap_ring)
 {
-  assert (ap_server);
-  TIZ_PRINTF_DBG_RED (
-    "Starting server io watcher "
-    "on fd [%d]",
-    ap_server->lstn_sockfd);
-  return tiz_srv_io_watcher_start (ap_server->p_parent, ap_server->p_srv_ev_io);
+  assert (ap_ring);
+  tiz_mem_free (ap_ring->p_chunks);
+  tiz_mem_free (ap_ring->p_store);
+  ap_ring->p_chunks = NULL;
+  ap_ring->p_store = NULL;
+  ap_ring->nchunks = 0;
 }
 
-static inline OMX_ERRORTYPE
-srv_stop_server_io_watcher (httpr_server_t * ap_server)
+static void
+srv_ring_reset (httpr_ring_t * ap_ring)
 {
-  assert (ap_server);
-  TIZ_PRINTF_DBG_RED (
-    "Stopping server io watcher "
-    "on fd [%d]",
-    ap_server->lstn_sockfd);
-  return tiz_srv_io_watcher_stop (ap_server->p_parent, ap_server->p_srv_ev_io);
+  assert (ap_ring);
+  assert (0 == ap_ring->nreaders);
+  ap_ring->head = 0;
+  ap_ring->tail = 0;
+  ap_ring->head_pos = 0;
 }
 
-static OMX_ERRORTYPE
-srv_start_listener_io_watcher (httpr_listener_t * ap_lstnr)
+static void
+srv_ring_attach (httpr_listener_t * ap_lstnr)
 {
+  httpr_ring_t * p_ring = NULL;
+  uint64_t seq = 0;
+  OMX_U32 burst = 0;
+
   assert (ap_lstnr);
-  assert (ap_lstnr->p_server);
-  assert (ap_lstnr->p_con);
-  return tiz_srv_io_watcher_start (ap_lstnr->p_server->p_parent,
-                                   ap_lstnr->p_con->p_ev_io);
+  assert (ap_lstnr->p_mount);
+  assert (!ap_lstnr->attached);
+  p_ring = &(ap_lstnr->p_mount->ring);
+
+  /* Burst-on-connect is served from the chunks already in the ring */
+  seq = p_ring->head;
+  while (seq > p_ring->tail
+         && burst < ap_lstnr->p_mount->initial_burst_size)
+    {
+      --seq;
+      burst += srv_ring_chunk (p_ring, seq)->len;
+    }
+
+  ap_lstnr->chunk = seq;
+  ap_lstnr->offset = 0;
+  for (; seq < p_ring->head; ++seq)
+    {
+      srv_ring_chunk (p_ring, seq)->refs++;
+    }
+  p_ring->nreaders++;
+  ap_lstnr->attached = true;
 }
 
 static void
-srv_stop_listener_io_watcher (httpr_listener_t * ap_lstnr)
+srv_ring_detach (httpr_listener_t * ap_lstnr)
 {
+  httpr_ring_t * p_ring = NULL;
+  uint64_t seq = 0;
+
   assert (ap_lstnr);
-  assert (ap_lstnr->p_con);
-  (void) tiz_srv_io_watcher_stop (ap_lstnr->p_server->p_parent,
-                                  ap_lstnr->p_con->p_ev_io);
+
+  if (ap_lstnr->attached)
+    {
+      assert (ap_lstnr->p_mount);
+      p_ring = &(ap_lstnr->p_mount->ring);
+      for (seq = ap_lstnr->chunk; seq < p_ring->head; ++seq)
+        {
+          assert (srv_ring_chunk (p_ring, seq)->refs > 0);
+          srv_ring_chunk (p_ring, seq)->refs--;
+        }
+      assert (p_ring->nreaders > 0);
+      p_ring->nreaders--;
+      ap_lstnr->attached = false;
+    }
 }
 
-static OMX_ERRORTYPE
-srv_start_listener_timer_watcher (httpr_listener_t * ap_lstnr,
-                                  const double a_wait_time)
+static void
+srv_ring_advance (httpr_ring_t * ap_ring, httpr_listener_t * ap_lstnr,
+                  const OMX_U32 a_bytes)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  httpr_chunk_t * p_chunk = NULL;
+  assert (ap_ring);
   assert (ap_lstnr);
-  if (!ap_lstnr->timer_started)
+  assert (ap_lstnr->chunk < ap_ring->head);
+
+  p_chunk = srv_ring_chunk (ap_ring, ap_lstnr->chunk);
+  ap_lstnr->offset += a_bytes;
+  assert (ap_lstnr->offset <= p_chunk->len);
+  if (ap_lstnr->offset == p_chunk->len)
     {
-      assert (ap_lstnr->p_server);
-      assert (ap_lstnr->p_con);
-      tiz_check_omx (tiz_srv_timer_watcher_start (
-        ap_lstnr->p_server->p_parent, ap_lstnr->p_con->p_ev_timer, a_wait_time,
-        a_wait_time));
-      ap_lstnr->timer_started = true;
+      assert (p_chunk->refs > 0);
+      p_chunk->refs--;
+      ap_lstnr->chunk++;
+      ap_lstnr->offset = 0;
     }
-  return rc;
 }
 
-static void
-srv_stop_listener_timer_watcher (httpr_listener_t * ap_lstnr)
+/* The stream offset of the listener's next byte */
+static inline uint64_t
+srv_ring_pos (const httpr_ring_t * ap_ring, const httpr_listener_t * ap_lstnr)
 {
+  assert (ap_ring);
   assert (ap_lstnr);
-  if (ap_lstnr->timer_started)
+  return ap_lstnr->chunk < ap_ring->head
+           ? srv_ring_chunk (ap_ring, ap_lstnr->chunk)->pos + ap_lstnr->offset
+           : ap_ring->head_pos;
+}
+
+static void
+srv_ring_unref (httpr_ring_t * ap_ring, const uint64_t a_first,
+                const uint64_t a_last)
+{
+  uint64_t seq = 0;
+  assert (ap_ring);
+  for (seq = a_first; seq <= a_last; ++seq)
     {
-      assert (ap_lstnr->p_server);
-      assert (ap_lstnr->p_con);
-      (void) tiz_srv_timer_watcher_stop (ap_lstnr->p_server->p_parent,
-                                         ap_lstnr->p_con->p_ev_timer);
-      ap_lstnr->timer_started = false;
+      assert (srv_ring_chunk (ap_ring, seq)->refs > 0);
+      srv_ring_chunk (ap_ring, seq)->refs--;
     }
 }
 
+static inline httpr_zc_send_t *
+srv_zc_send (httpr_listener_t * ap_lstnr, const uint32_t a_id)
+{
+  assert (ap_lstnr);
+  return &(ap_lstnr->zc_sends[a_id % ICE_ZEROCOPY_MAX_INFLIGHT]);
+}
+
 static void
-srv_destroy_connection (httpr_connection_t * ap_con)
+srv_zc_pin (httpr_listener_t * ap_lstnr, const uint64_t a_first,
+            const uint64_t a_last)
 {
-  if (ap_con)
+  httpr_zc_send_t * p_send = NULL;
+  uint64_t seq = 0;
+
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_mount);
+  assert (ap_lstnr->zc_head - ap_lstnr->zc_tail < ICE_ZEROCOPY_MAX_INFLIGHT);
+
+  p_send = srv_zc_send (ap_lstnr, ap_lstnr->zc_head++);
+  p_send->first = a_first;
+  p_send->last = a_last;
+  p_send->done = false;
+  for (seq = a_first; seq <= a_last; ++seq)
     {
-      if (ICE_SOCK_ERROR != ap_con->sockfd)
-        {
-          close (ap_con->sockfd);
-        }
-      tiz_mem_free (ap_con->p_ip);
-      tiz_mem_free (ap_con->p_host);
-      assert (ap_con->p_lstnr && ap_con->p_lstnr->p_server);
-      tiz_srv_io_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
-                                  ap_con->p_ev_io);
-      tiz_srv_timer_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
-                                     ap_con->p_ev_timer);
-      tiz_mem_free (ap_con);
+      srv_ring_chunk (&(ap_lstnr->p_mount->ring), seq)->refs++;
     }
 }
 
 static void
-srv_destroy_listener (httpr_listener_t * ap_lstnr)
+srv_zc_unpin_completed (httpr_listener_t * ap_lstnr, const bool a_all)
 {
-  if (ap_lstnr)
+  assert (ap_lstnr);
+  while (ap_lstnr->zc_tail != ap_lstnr->zc_head)
     {
-      srv_stop_listener_timer_watcher (ap_lstnr);
-      if (ap_lstnr->p_parser)
+      httpr_zc_send_t * p_send = srv_zc_send (ap_lstnr, ap_lstnr->zc_tail);
+      if (!p_send->done && !a_all)
         {
-          tiz_http_parser_destroy (ap_lstnr->p_parser);
+          break;
         }
-      tiz_mem_free (ap_lstnr->buf.p_data);
-      srv_destroy_connection (ap_lstnr->p_con);
-      tiz_mem_free (ap_lstnr);
+      assert (ap_lstnr->p_mount);
+      srv_ring_unref (&(ap_lstnr->p_mount->ring), p_send->first,
+                      p_send->last);
+      ap_lstnr->zc_tail++;
     }
 }
 
+/* Drains the socket's error queue of MSG_ZEROCOPY completion notifications
+   and unpins the ring chunks of the completed sends */
 static void
-srv_remove_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+srv_zc_reap (httpr_listener_t * ap_lstnr)
 {
-  int nlstnrs = 0;
+#ifdef ICE_HAVE_ZEROCOPY
+  char control[128];
+  struct msghdr msg;
+  struct cmsghdr * p_cm = NULL;
+  struct sock_extended_err * p_serr = NULL;
 
-  assert (ap_server);
   assert (ap_lstnr);
 
-  nlstnrs = srv_get_listeners_count (ap_server);
-  assert (nlstnrs > 0);
-
-  TIZ_LOG (TIZ_PRIORITY_TRACE,
-           "Destroyed listener [%s] - [%d] listeners remaining",
-           ap_lstnr->p_con->p_ip, nlstnrs - 1);
-
-  tiz_map_erase (ap_server->p_lstnrs, &ap_lstnr->p_con->sockfd);
-  assert (nlstnrs - 1 == srv_get_listeners_count (ap_server));
+  while (ap_lstnr->zc_tail != ap_lstnr->zc_head)
+    {
+      tiz_mem_set (&msg, 0, sizeof (msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof (control);
+      if (recvmsg (ap_lstnr->p_con->sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT)
+          < 0)
+        {
+          break;
+        }
+      for (p_cm = CMSG_FIRSTHDR (&msg); p_cm; p_cm = CMSG_NXTHDR (&msg, p_cm))
+        {
+          uint32_t id = 0;
+          if (!((SOL_IP == p_cm->cmsg_level && IP_RECVERR == p_cm->cmsg_type)
+                || (SOL_IPV6 == p_cm->cmsg_level
+                    && IPV6_RECVERR == p_cm->cmsg_type)))
+            {
+              continue;
+            }
+          p_serr = (struct sock_extended_err *) CMSG_DATA (p_cm);
+          if (SO_EE_ORIGIN_ZEROCOPY != p_serr->ee_origin)
+            {
+              continue;
+            }
+          /* Completions may be coalesced into ranges, and may be reported
+             out of order */
+          for (id = p_serr->ee_info; id - p_serr->ee_info
+                                     <= p_serr->ee_data - p_serr->ee_info;
+               ++id)
+            {
+              if (id - ap_lstnr->zc_tail
+                  < ap_lstnr->zc_head - ap_lstnr->zc_tail)
+                {
+                  srv_zc_send (ap_lstnr, id)->done = true;
+                }
+            }
+          if (p_serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            {
+              /* The kernel had to copy the data anyway (e.g. loopback) */
+              ap_lstnr->zerocopy = false;
+            }
+        }
+    }
+  srv_zc_unpin_completed (ap_lstnr, false);
+#endif
+}
 
-  /* NOTE: No need to call srv_destroy_listener as this has been called already
-   * by
-   * the map's listeners_map_free_func */
+static inline bool
+srv_zc_pins (const httpr_listener_t * ap_lstnr, const uint64_t a_seq)
+{
+  assert (ap_lstnr);
+  return (ap_lstnr->zc_tail != ap_lstnr->zc_head
+          && ap_lstnr->zc_sends[ap_lstnr->zc_tail % ICE_ZEROCOPY_MAX_INFLIGHT]
+                 .first
+               <= a_seq);
 }
 
-static httpr_connection_t *
-srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                       const int connected_sockfd, char * ap_ip,
-                       const unsigned short ap_port, const double a_wait_time)
+/* Applies the slow listener policy to the listeners still reading chunk
+   'a_upto' of the ring, or an older one */
+static void
+srv_ring_evict (httpr_server_t * ap_server, httpr_mount_t * ap_mount,
+                const uint64_t a_upto)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  httpr_connection_t * p_con = NULL;
-  OMX_HANDLETYPE p_hdl = NULL;
+  httpr_ring_t * p_ring = NULL;
+  int i = 0;
 
   assert (ap_server);
-  assert (ap_lstnr);
-  p_hdl = handleOf (ap_server->p_parent);
+  assert (ap_mount);
+  p_ring = &(ap_mount->ring);
 
-  p_con
-    = (httpr_connection_t *) tiz_mem_calloc (1, sizeof (httpr_connection_t));
-  rc = p_con ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
-  goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the connection struct");
+  for (i = 0; i < srv_get_listeners_count (ap_server); ++i)
+    {
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      if (p_lstnr->p_mount != ap_mount)
+        {
+          continue;
+        }
+      if (p_lstnr->attached && p_lstnr->chunk <= a_upto)
+        {
+          srv_ring_detach (p_lstnr);
+          if (EHttprSrvSlowPolicyDrop == ap_server->slow_policy)
+            {
+              TIZ_NOTICE (handleOf (ap_server->p_parent),
+                          "Dropping slow listener [%s:%u]",
+                          p_lstnr->p_con->p_ip, p_lstnr->p_con->port);
+              p_lstnr->failed = true;
+              ap_server->stats.dropped++;
+            }
+          else
+            {
+              TIZ_NOTICE (handleOf (ap_server->p_parent),
+                          "Skipping slow listener [%s:%u] forward "
+                          "[%u] chunks",
+                          p_lstnr->p_con->p_ip, p_lstnr->p_con->port,
+                          (unsigned int) (p_ring->head - p_lstnr->chunk));
+              /* Re-attach at the live edge */
+              p_lstnr->chunk = p_ring->head;
+              p_lstnr->offset = 0;
+              p_ring->nreaders++;
+              p_lstnr->attached = true;
+              p_lstnr->skips++;
+              ap_server->stats.skipped++;
+            }
+        }
+    }
+}
 
-  p_con->p_lstnr = ap_lstnr;
-  p_con->con_time = 0; /* time (NULL); */
-  p_con->sent_total = 0;
-  p_con->sent_last = 0;
-  p_con->burst_bytes = 0;
-  p_con->initial_burst_bytes = ap_server->mountpoint.initial_burst_size;
-  p_con->sockfd = connected_sockfd;
-  p_con->p_host = NULL;
-  p_con->p_ip = ap_ip;
-  p_con->port = ap_port;
-  p_con->p_ev_io = NULL;
-  p_con->p_ev_timer = NULL;
+static void
+srv_ring_evict_tail (httpr_server_t * ap_server, httpr_mount_t * ap_mount)
+{
+  httpr_ring_t * p_ring = NULL;
+  int i = 0;
 
-  /* We are interested in knowing when a listener socket is available for
-   * writing */
-  rc = tiz_srv_io_watcher_init (ap_server->p_parent, &(p_con->p_ev_io),
-                                p_con->sockfd, TIZ_EVENT_WRITE, true);
-  goto_end_on_omx_error (rc, p_hdl, "Unable to init the client's io event");
+  assert (ap_server);
+  assert (ap_mount);
+  p_ring = &(ap_mount->ring);
 
-  rc = tiz_srv_timer_watcher_init (ap_server->p_parent, &(p_con->p_ev_timer));
-  goto_end_on_omx_error (rc, p_hdl, "Unable to init the client's timer event");
+  srv_ring_evict (ap_server, ap_mount, p_ring->tail);
 
-end:
-  if (OMX_ErrorNone != rc)
+  for (i = 0; i < srv_get_listeners_count (ap_server); ++i)
     {
-      srv_destroy_connection (p_con);
-      p_con = NULL;
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      if (p_lstnr->p_mount != ap_mount)
+        {
+          continue;
+        }
+      if (srv_zc_pins (p_lstnr, p_ring->tail))
+        {
+          srv_zc_reap (p_lstnr);
+        }
+      if (srv_zc_pins (p_lstnr, p_ring->tail))
+        {
+          /* The kernel still holds a whole ring of this listener's stream;
+             reset the connection so that the pages are released */
+          TIZ_NOTICE (handleOf (ap_server->p_parent),
+                      "Resetting stalled listener [%s:%u]",
+                      p_lstnr->p_con->p_ip, p_lstnr->p_con->port);
+          (void) srv_set_abortive_close (p_lstnr->p_con->sockfd);
+          srv_zc_unpin_completed (p_lstnr, true);
+          srv_ring_detach (p_lstnr);
+          p_lstnr->failed = true;
+          ap_server->stats.dropped++;
+        }
     }
-
-  return p_con;
+  assert (0 == srv_ring_chunk (p_ring, p_ring->tail)->refs);
 }
 
-static OMX_ERRORTYPE
-srv_create_listener (httpr_server_t * ap_server, httpr_listener_t ** app_lstnr,
-                     const int a_connected_sockfd, char * ap_ip,
-                     const unsigned short ap_port)
+/* Copies the next piece of the stream into the head of the ring. Returns
+   false when there is no OMX buffer available at the moment. */
+static bool
+srv_ring_fill (httpr_server_t * ap_server, httpr_mount_t * ap_mount)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorInsufficientResources;
-  httpr_listener_t * p_lstnr = NULL;
-  httpr_connection_t * p_con = NULL;
-  OMX_HANDLETYPE p_hdl = NULL;
-  int sockrc = ICE_SOCK_ERROR;
+  httpr_ring_t * p_ring = NULL;
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  httpr_chunk_t * p_chunk = NULL;
 
   assert (ap_server);
-  assert (app_lstnr);
-  assert (ICE_SOCK_ERROR != a_connected_sockfd);
-  assert (ap_ip);
-  p_hdl = handleOf (ap_server->p_parent);
+  assert (ap_mount);
+  p_ring = &(ap_mount->ring);
 
-  p_lstnr = (httpr_listener_t *) tiz_mem_calloc (1, sizeof (httpr_listener_t));
-  rc = p_lstnr ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
-  goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the listener structure");
+  while (NULL == (p_hdr = ap_mount->p_hdr) || 0 == p_hdr->nFilledLen)
+    {
+      if (p_hdr)
+        {
+          /* Nothing left in this one; return it */
+          ap_mount->p_hdr = NULL;
+          ap_server->pf_release_buf (p_hdr, ap_mount->pid, ap_server->p_arg);
+        }
+      if (NULL == (ap_mount->p_hdr = ap_server->pf_acquire_buf (
+                     ap_mount->pid, ap_server->p_arg)))
+        {
+          return false;
+        }
+    }
 
-  p_con = srv_create_connection (ap_server, p_lstnr, a_connected_sockfd, ap_ip,
-                                 ap_port, ap_server->wait_time);
-  rc = p_con ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
-  goto_end_on_omx_error (rc, p_hdl, "Unable to init the listener's connection");
+  if (p_ring->head - p_ring->tail == p_ring->nchunks)
+    {
+      if (srv_ring_chunk (p_ring, p_ring->tail)->refs > 0)
+        {
+          srv_ring_evict_tail (ap_server, ap_mount);
+        }
+      p_ring->tail++;
+    }
 
-  p_lstnr->p_server = ap_server;
-  p_lstnr->p_con = p_con;
-  p_lstnr->respcode = 200;
-  p_lstnr->intro_offset = 0;
-  p_lstnr->pos = 0;
-  p_lstnr->buf.len = ICE_LISTENER_BUF_SIZE;
-  p_lstnr->buf.metadata_offset = 0;
-  p_lstnr->buf.metadata_bytes = 0;
-  p_lstnr->p_parser = NULL;
-  p_lstnr->need_response = true;
-  p_lstnr->timer_started = false;
-  p_lstnr->want_metadata = false;
+  p_chunk = srv_ring_chunk (p_ring, p_ring->head);
+  p_chunk->len = MIN (p_hdr->nFilledLen, p_ring->chunk_size);
+  memcpy (p_chunk->p_data, p_hdr->pBuffer + p_hdr->nOffset, p_chunk->len);
+  p_chunk->refs = p_ring->nreaders;
+  p_chunk->pos = p_ring->head_pos;
+  p_ring->head++;
+  p_ring->head_pos += p_chunk->len;
+
+  p_hdr->nFilledLen -= p_chunk->len;
+  p_hdr->nOffset += p_chunk->len;
+  if (0 == p_hdr->nFilledLen)
+    {
+      /* Buffer emptied */
+      ap_mount->p_hdr = NULL;
+      ap_server->pf_release_buf (p_hdr, ap_mount->pid, ap_server->p_arg);
+    }
+  return true;
+}
 
-  p_lstnr->buf.p_data = (char *) tiz_mem_alloc (ICE_LISTENER_BUF_SIZE);
-  rc = p_lstnr->buf.p_data ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
-  goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the listener's buffer");
-  p_lstnr->buf.p_data[ICE_LISTENER_BUF_SIZE - 1] = '\0';
+static inline bool
+srv_hls_enabled (const httpr_server_t * ap_server,
+                 const httpr_mount_t * ap_mount)
+{
+  assert (ap_server);
+  assert (ap_mount);
+  return (ap_server->hls_segment_secs > 0 && ap_mount->hls.pp_segments
+          && OMX_AUDIO_CodingMP3 == ap_mount->encoding);
+}
 
-  rc = tiz_http_parser_init (&(p_lstnr->p_parser), ETIZHttpParserTypeRequest);
-  goto_end_on_omx_error (rc, p_hdl, "Unable to init the http parser");
+static inline void
+srv_hls_segment_unref (httpr_hls_segment_t * ap_segment)
+{
+  if (ap_segment && 0 == --ap_segment->refs)
+    {
+      tiz_mem_free (ap_segment);
+    }
+}
 
-  sockrc = srv_set_non_blocking (p_lstnr->p_con->sockfd);
-  rc = sockrc < 0 ? OMX_ErrorInsufficientResources : OMX_ErrorNone;
-  goto_end_on_socket_error (sockrc, p_hdl, strerror (errno));
+/* The segment with that sequence number, if it is still around */
+static inline httpr_hls_segment_t *
+srv_hls_segment (const httpr_server_t * ap_server,
+                 const httpr_mount_t * ap_mount, const uint64_t a_seq)
+{
+  httpr_hls_segment_t * p_segment = NULL;
+  assert (ap_server);
+  assert (ap_mount);
+  assert (ap_mount->hls.pp_segments);
+  p_segment
+    = ap_mount->hls.pp_segments[a_seq % ap_server->hls_nsegments];
+  return (p_segment && p_segment->seq == a_seq) ? p_segment : NULL;
+}
 
-  sockrc = srv_set_nodelay (p_lstnr->p_con->sockfd);
-  rc = sockrc < 0 ? OMX_ErrorInsufficientResources : OMX_ErrorNone;
-  goto_end_on_socket_error (sockrc, p_hdl, strerror (errno));
+/* '/hi.mp3' is segmented as '/hi.m3u8' and '/hi-<n>.mp3'; '/' as
+   '/stream.m3u8' and '/stream-<n>.mp3' */
+static void
+srv_hls_set_base (httpr_mount_t * ap_mount)
+{
+  char * p_base = NULL;
+  size_t len = 0;
 
-  rc = OMX_ErrorNone;
+  assert (ap_mount);
+  p_base = ap_mount->hls.base;
+  snprintf (p_base, sizeof (ap_mount->hls.base), "%s", ap_mount->mount_name);
+  len = strlen (p_base);
+  if (len >= 4 && 0 == strcasecmp (p_base + len - 4, ".mp3"))
+    {
+      p_base[len - 4] = '\0';
+    }
+  else if (len > 0 && '/' == p_base[len - 1])
+    {
+      snprintf (p_base + len, sizeof (ap_mount->hls.base) - len, "stream");
+    }
+}
 
-end:
+static void
+srv_hls_reset (httpr_server_t * ap_server, httpr_mount_t * ap_mount)
+{
+  httpr_hls_t * p_hls = NULL;
+  OMX_U32 i = 0;
 
-  if (OMX_ErrorNone != rc)
+  assert (ap_server);
+  assert (ap_mount);
+  p_hls = &(ap_mount->hls);
+
+  for (i = 0; p_hls->pp_segments && i < ap_server->hls_nsegments; ++i)
     {
-      srv_destroy_listener (p_lstnr);
-      p_lstnr = NULL;
+      srv_hls_segment_unref (p_hls->pp_segments[i]);
+      p_hls->pp_segments[i] = NULL;
     }
+  p_hls->next_seq = 0;
+  p_hls->build_len = ICE_HLS_ID3_TAG_SIZE;
+  p_hls->parsed = ICE_HLS_ID3_TAG_SIZE;
+  p_hls->build_time = 0;
+  p_hls->start_time = 0;
+  p_hls->chunk = ap_mount->ring.head;
+  p_hls->offset = 0;
+}
 
-  *app_lstnr = p_lstnr;
-
-  return rc;
+static void
+srv_hls_destroy (httpr_server_t * ap_server, httpr_mount_t * ap_mount)
+{
+  assert (ap_mount);
+  srv_hls_reset (ap_server, ap_mount);
+  tiz_mem_free (ap_mount->hls.pp_segments);
+  tiz_mem_free (ap_mount->hls.p_build);
+  ap_mount->hls.pp_segments = NULL;
+  ap_mount->hls.p_build = NULL;
+  ap_mount->hls.build_cap = 0;
 }
 
-static int
-srv_read_from_listener (httpr_listener_t * ap_lstnr)
+/* The length of the MPEG audio layer III frame at ap_data (at least 4
+   bytes), or 0 if there isn't one there */
+static OMX_U32
+srv_mp3_frame_len (const OMX_U8 * ap_data, OMX_U32 * ap_samples,
+                   OMX_U32 * ap_rate)
 {
-  httpr_connection_t * p_con = NULL;
-  httpr_listener_buffer_t * p_buf = NULL;
+  static const OMX_U16 kbps[2][16]
+    = {/* MPEG-1 */
+       {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0},
+       /* MPEG-2 and 2.5 */
+       {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0}};
+  static const OMX_U32 rates[3] = {44100, 48000, 32000};
+  unsigned int version = 0;
+  unsigned int br_idx = 0;
+  unsigned int sr_idx = 0;
+
+  assert (ap_data);
+  assert (ap_samples);
+  assert (ap_rate);
+
+  if (0xFF != ap_data[0] || 0xE0 != (ap_data[1] & 0xE0))
+    {
+      return 0;
+    }
 
-  assert (ap_lstnr);
+  /* 3: MPEG-1, 2: MPEG-2, 0: MPEG-2.5; layer bits 01: layer III */
+  version = (ap_data[1] >> 3) & 0x03;
+  br_idx = ap_data[2] >> 4;
+  sr_idx = (ap_data[2] >> 2) & 0x03;
+  if (1 == version || 0x01 != ((ap_data[1] >> 1) & 0x03) || 0 == br_idx
+      || 15 == br_idx || 3 == sr_idx)
+    {
+      return 0;
+    }
+
+  *ap_rate = rates[sr_idx] >> (3 == version ? 0 : (2 == version ? 1 : 2));
+  *ap_samples = (3 == version ? 1152 : 576);
+  return (*ap_samples / 8) * kbps[3 == version ? 0 : 1][br_idx] * 1000
+           / *ap_rate
+         + ((ap_data[2] >> 1) & 0x01);
+}
+
+/* HLS packed audio carries the timestamp of its first frame in an ID3 PRIV
+   frame, as a 33-bit, 90KHz MPEG-2 timestamp */
+static void
+srv_hls_write_id3 (OMX_U8 * ap_tag, const double a_time)
+{
+  static const char owner[] = "com.apple.streaming.transportStreamTimestamp";
+  const uint64_t pts = ((uint64_t) (a_time * 90000)) & 0x1FFFFFFFFULL;
+  const OMX_U32 frame_size = sizeof (owner) + 8;
+  OMX_U8 * p = ap_tag;
+  int i = 0;
+
+  assert (ap_tag);
+  assert (10 + 10 + frame_size == ICE_HLS_ID3_TAG_SIZE);
+
+  /* ID3v2.4 header; the sizes are 'syncsafe' integers, under 128 here */
+  memcpy (p, "ID3\x04\x00\x00\x00\x00\x00", 9);
+  p[9] = (OMX_U8) (10 + frame_size);
+  p += 10;
+  memcpy (p, "PRIV\x00\x00\x00", 7);
+  p[7] = (OMX_U8) frame_size;
+  p[8] = p[9] = 0;
+  p += 10;
+  memcpy (p, owner, sizeof (owner));
+  p += sizeof (owner);
+  for (i = 7; i >= 0; --i)
+    {
+      *p++ = (OMX_U8) (pts >> (i * 8));
+    }
+}
+
+/* Closes the segment being built at the last whole frame, and starts the
+   next one with whatever follows it */
+static void
+srv_hls_cut (httpr_server_t * ap_server, httpr_mount_t * ap_mount)
+{
+  httpr_hls_t * p_hls = NULL;
+  httpr_hls_segment_t * p_segment = NULL;
+  httpr_hls_segment_t ** pp_slot = NULL;
+  OMX_U32 rest = 0;
+
+  assert (ap_server);
+  assert (ap_mount);
+  p_hls = &(ap_mount->hls);
+  assert (p_hls->p_build);
+
+  srv_hls_write_id3 (p_hls->p_build, p_hls->start_time);
+  p_segment = (httpr_hls_segment_t *) tiz_mem_alloc (
+    sizeof (httpr_hls_segment_t) + p_hls->parsed);
+  if (p_segment)
+    {
+      p_segment->refs = 1;
+      p_segment->seq = p_hls->next_seq;
+      p_segment->duration = p_hls->build_time;
+      p_segment->len = p_hls->parsed;
+      memcpy (p_segment->data, p_hls->p_build, p_hls->parsed);
+      pp_slot = &(p_hls->pp_segments[p_hls->next_seq
+                                     % ap_server->hls_nsegments]);
+      srv_hls_segment_unref (*pp_slot);
+      *pp_slot = p_segment;
+      TIZ_TRACE (handleOf (ap_server->p_parent),
+                 "mount [%s] segment [%llu] duration [%f] len [%u]",
+                 ap_mount->mount_name, (unsigned long long) p_segment->seq,
+                 p_segment->duration, (unsigned int) p_segment->len);
+    }
+  else
+    {
+      TIZ_ERROR (handleOf (ap_server->p_parent),
+                 "[OMX_ErrorInsufficientResources] : "
+                 "Unable to store HLS segment [%llu]",
+                 (unsigned long long) p_hls->next_seq);
+    }
+
+  p_hls->next_seq++;
+  p_hls->start_time += p_hls->build_time;
+  p_hls->build_time = 0;
+  rest = p_hls->build_len - p_hls->parsed;
+  memmove (p_hls->p_build + ICE_HLS_ID3_TAG_SIZE,
+           p_hls->p_build + p_hls->parsed, rest);
+  p_hls->build_len = ICE_HLS_ID3_TAG_SIZE + rest;
+  p_hls->parsed = ICE_HLS_ID3_TAG_SIZE;
+}
+
+/* Appends a piece of the stream to the segment being built. Anything that
+   isn't an MP3 frame is dropped. */
+static OMX_ERRORTYPE
+srv_hls_feed (httpr_server_t * ap_server, httpr_mount_t * ap_mount,
+              const OMX_U8 * ap_data, const OMX_U32 a_len)
+{
+  httpr_hls_t * p_hls = NULL;
+
+  assert (ap_server);
+  assert (ap_mount);
+  assert (ap_data);
+  p_hls = &(ap_mount->hls);
+
+  if (p_hls->build_len + a_len > p_hls->build_cap)
+    {
+      OMX_U32 cap = MAX (p_hls->build_cap * 2, p_hls->build_len + a_len);
+      OMX_U8 * p_build = (OMX_U8 *) tiz_mem_realloc (p_hls->p_build, cap);
+      if (!p_build)
+        {
+          return OMX_ErrorInsufficientResources;
+        }
+      p_hls->p_build = p_build;
+      p_hls->build_cap = cap;
+    }
+  memcpy (p_hls->p_build + p_hls->build_len, ap_data, a_len);
+  p_hls->build_len += a_len;
+
+  while (p_hls->build_len - p_hls->parsed >= 4)
+    {
+      OMX_U8 * p_frame = p_hls->p_build + p_hls->parsed;
+      const OMX_U32 avail = p_hls->build_len - p_hls->parsed;
+      OMX_U32 samples = 0;
+      OMX_U32 rate = 0;
+      OMX_U32 frame_len = srv_mp3_frame_len (p_frame, &samples, &rate);
+
+      if (0 == frame_len)
+        {
+          /* Out of sync; skip to the next candidate sync byte */
+          const OMX_U8 * p_sync = memchr (p_frame + 1, 0xFF, avail - 1);
+          const OMX_U32 skip = p_sync ? (OMX_U32) (p_sync - p_frame) : avail;
+          memmove (p_frame, p_frame + skip, avail - skip);
+          p_hls->build_len -= skip;
+          continue;
+        }
+
+      if (frame_len > avail)
+        {
+          break;
+        }
+
+      p_hls->parsed += frame_len;
+      p_hls->build_time += (double) samples / rate;
+      if (p_hls->build_time >= ap_server->hls_segment_secs)
+        {
+          srv_hls_cut (ap_server, ap_mount);
+        }
+    }
+  return OMX_ErrorNone;
+}
+
+/* Moves the segmenter along the ring up to the pacing limit. The segmenter
+   is not counted as a reader of the ring; it is never behind by more than a
+   tick. */
+static void
+srv_hls_pump (httpr_server_t * ap_server, httpr_mount_t * ap_mount)
+{
+  httpr_ring_t * p_ring = NULL;
+  httpr_hls_t * p_hls = NULL;
+
+  assert (ap_server);
+  assert (ap_mount);
+  p_ring = &(ap_mount->ring);
+  p_hls = &(ap_mount->hls);
+
+  while (1)
+    {
+      httpr_chunk_t * p_chunk = NULL;
+      uint64_t pos = 0;
+      OMX_U32 len = 0;
+
+      if (p_hls->chunk < p_ring->tail)
+        {
+          TIZ_WARN (handleOf (ap_server->p_parent),
+                    "mount [%s] : HLS segmenter overrun",
+                    ap_mount->mount_name);
+          p_hls->chunk = p_ring->tail;
+          p_hls->offset = 0;
+        }
+
+      pos = p_hls->chunk < p_ring->head
+              ? srv_ring_chunk (p_ring, p_hls->chunk)->pos + p_hls->offset
+              : p_ring->head_pos;
+      if (pos >= ap_mount->pace_limit)
+        {
+          break;
+        }
+
+      if (p_hls->chunk == p_ring->head && !srv_ring_fill (ap_server, ap_mount))
+        {
+          /* Starved; carry on on the next buffer event */
+          break;
+        }
+
+      p_chunk = srv_ring_chunk (p_ring, p_hls->chunk);
+      len = (OMX_U32) MIN (p_chunk->len - p_hls->offset,
+                           ap_mount->pace_limit - pos);
+      if (OMX_ErrorNone
+          != srv_hls_feed (ap_server, ap_mount, p_chunk->p_data + p_hls->offset,
+                           len))
+        {
+          TIZ_ERROR (handleOf (ap_server->p_parent),
+                     "[OMX_ErrorInsufficientResources] : "
+                     "mount [%s] : dropping [%u] bytes of HLS segment",
+                     ap_mount->mount_name, (unsigned int) len);
+        }
+      p_hls->offset += len;
+      if (p_hls->offset == p_chunk->len)
+        {
+          p_hls->chunk++;
+          p_hls->offset = 0;
+        }
+    }
+}
+
+static void
+srv_hls_pump_all (httpr_server_t * ap_server)
+{
+  OMX_U32 i = 0;
+  assert (ap_server);
+  for (i = 0; i < ap_server->nmounts; ++i)
+    {
+      if (srv_hls_enabled (ap_server, &(ap_server->p_mounts[i])))
+        {
+          srv_hls_pump (ap_server, &(ap_server->p_mounts[i]));
+        }
+    }
+}
+
+static int
+srv_set_non_blocking (const int sockfd)
+{
+  int rc = ICE_SOCK_ERROR;
+  int flags;
+  errno = 0;
+  if ((flags = fcntl (sockfd, F_GETFL, 0)) != ICE_SOCK_ERROR)
+    {
+      errno = 0;
+      flags |= O_NONBLOCK;
+      if (fcntl (sockfd, F_SETFL, flags) != ICE_SOCK_ERROR)
+        {
+          rc = 0;
+        }
+    }
+  return rc;
+}
+
+static inline int
+srv_set_nolinger (const int sock)
+{
+  struct linger lin = {0, 0};
+  errno = 0;
+  /* linger inactive. close call will return immediately to the caller, and any
+   * pending data will be delivered if possible. */
+  return setsockopt (sock, SOL_SOCKET, SO_LINGER, (void *) &lin,
+                     sizeof (struct linger));
+}
+
+static inline int
+srv_set_nodelay (const int sock)
+{
+  int nodelay = 1;
+  errno = 0;
+  return setsockopt (sock, IPPROTO_TCP, TCP_NODELAY, (void *) &nodelay,
+                     sizeof (int));
+}
+
+static inline int
+srv_set_keepalive (const int sock)
+{
+  int keepalive = 1;
+  errno = 0;
+  return setsockopt (sock, SOL_SOCKET, SO_KEEPALIVE, (void *) &keepalive,
+                     sizeof (int));
+}
+
+static int
+srv_accept_socket (httpr_server_t * ap_server, char * ap_ip,
+                   const size_t a_ip_len, unsigned short * ap_port)
+{
+#define bail_on_accept_error(some_error, msg) \
+  do                                          \
+    {                                         \
+      if (some_error)                         \
+        {                                     \
+          TIZ_ERROR (p_hdl, "[%s]", msg);     \
+          goto end;                           \
+        }                                     \
+    }                                         \
+  while (0)
+
+  int accepted_sockfd = ICE_SOCK_ERROR;
+  struct sockaddr_storage sa;
+  socklen_t slen = sizeof (sa);
+  OMX_HANDLETYPE p_hdl = NULL;
+  bool some_error = true;
+  int err = 0;
+
+  assert (ap_server);
+  assert (ap_ip);
+  assert (ap_port);
+  p_hdl = handleOf (ap_server->p_parent);
+
+  some_error = (!srv_is_valid_socket (ap_server->lstn_sockfd));
+  bail_on_accept_error (some_error, "Invalid server socket");
+
+  errno = 0;
+  accepted_sockfd
+    = accept (ap_server->lstn_sockfd, (struct sockaddr *) &sa, &slen);
+  some_error = (ICE_SOCK_ERROR == accepted_sockfd);
+  bail_on_accept_error (some_error, strerror (errno));
+
+  if (0 != (err = getnameinfo ((struct sockaddr *) &sa, slen, ap_ip, a_ip_len,
+                               NULL, 0, NI_NUMERICHOST)))
+    {
+      snprintf (ap_ip, a_ip_len, "unknown");
+      TIZ_ERROR (p_hdl, "getnameinfo error [%s]", gai_strerror (err));
+    }
+  else
+    {
+      if (sa.ss_family == AF_INET)
+        {
+          struct sockaddr_in * p_sa_in = (struct sockaddr_in *) &sa;
+          *ap_port = ntohs (p_sa_in->sin_port);
+        }
+    }
+
+  err = srv_set_nolinger (accepted_sockfd);
+  some_error = (ICE_SOCK_ERROR == err);
+  bail_on_accept_error (some_error, strerror (errno));
+
+  err = srv_set_keepalive (accepted_sockfd);
+  some_error = (ICE_SOCK_ERROR == err);
+  bail_on_accept_error (some_error, strerror (errno));
+
+  TIZ_TRACE (p_hdl, "Accepted [%s:%u] fd [%d]", ap_ip, *ap_port,
+             accepted_sockfd);
+end:
+  if (some_error)
+    {
+      close (accepted_sockfd);
+      accepted_sockfd = ICE_SOCK_ERROR;
+    }
+
+  return accepted_sockfd;
+}
+
+static inline int
+srv_create_server_socket (httpr_server_t * ap_server, const int a_port,
+                          const char * a_interface)
+{
+  struct sockaddr_storage sa;
+  struct addrinfo hints;
+  struct addrinfo * res;
+  struct addrinfo * ai;
+  char service[10];
+  int sockfd = ICE_SOCK_ERROR;
+  int getaddrc = ICE_SOCK_ERROR;
+
+  assert (ap_server);
+  assert (a_port >= 0);
+
+  tiz_mem_set (&sa, 0, sizeof (sa));
+  tiz_mem_set (&hints, 0, sizeof (hints));
+
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_flags = AI_PASSIVE | AI_ADDRCONFIG | AI_NUMERICSERV | AI_NUMERICHOST;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf (service, sizeof (service), "%d", a_port);
+
+  if ((getaddrc = getaddrinfo (a_interface, service, &hints, &res)) != 0)
+    {
+      TIZ_ERROR (handleOf (ap_server->p_parent), "[ICE_SOCK_ERROR] : %s.",
+                 gai_strerror (getaddrc));
+    }
+  else
+    {
+      ai = res;
+      do
+        {
+          int on = 1;
+          sockfd = socket (ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+          if (sockfd < 0)
+            {
+              continue;
+            }
+
+          setsockopt (sockfd, SOL_SOCKET, SO_REUSEADDR, (const void *) &on,
+                      sizeof (on));
+          on = 0;
+
+          if (bind (sockfd, ai->ai_addr, ai->ai_addrlen) < 0)
+            {
+              close (sockfd);
+              continue;
+            }
+
+          freeaddrinfo (res);
+          return sockfd;
+        }
+      while ((ai = ai->ai_next));
+
+      freeaddrinfo (res);
+    }
+  return ICE_SOCK_ERROR;
+}
+
+static void
+srv_destroy_server_io_watcher (httpr_server_t * ap_server)
+{
+  assert (ap_server);
+  tiz_srv_io_watcher_destroy (ap_server->p_parent, ap_server->p_srv_ev_io);
+  ap_server->p_srv_ev_io = NULL;
+}
+
+static OMX_ERRORTYPE
+srv_allocate_server_io_watcher (httpr_server_t * ap_server)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (ap_server);
+
+  rc = tiz_srv_io_watcher_init (
+    ap_server->p_parent, &(ap_server->p_srv_ev_io), ap_server->lstn_sockfd,
+    TIZ_EVENT_READ, /* Interested in read events only */
+    true            /* Only one event at a time */
+    );
+  if (OMX_ErrorNone != rc)
+    {
+      srv_destroy_server_io_watcher (ap_server);
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+srv_start_server_io_watcher (httpr_server_t * ap_server)
+{
+  assert (ap_server);
+  TIZ_PRINTF_DBG_RED (
+    "Starting server io watcher "
+    "on fd [%d]",
+    ap_server->lstn_sockfd);
+  return tiz_srv_io_watcher_start (ap_server->p_parent, ap_server->p_srv_ev_io);
+}
+
+static inline OMX_ERRORTYPE
+srv_stop_server_io_watcher (httpr_server_t * ap_server)
+{
+  assert (ap_server);
+  TIZ_PRINTF_DBG_RED (
+    "Stopping server io watcher "
+    "on fd [%d]",
+    ap_server->lstn_sockfd);
+  return tiz_srv_io_watcher_stop (ap_server->p_parent, ap_server->p_srv_ev_io);
+}
+
+static OMX_ERRORTYPE
+srv_start_listener_io_watcher (httpr_listener_t * ap_lstnr)
+{
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_server);
+  assert (ap_lstnr->p_con);
+  return tiz_srv_io_watcher_start (ap_lstnr->p_server->p_parent,
+                                   ap_lstnr->p_con->p_ev_io);
+}
+
+static void
+srv_stop_listener_io_watcher (httpr_listener_t * ap_lstnr)
+{
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_con);
+  (void) tiz_srv_io_watcher_stop (ap_lstnr->p_server->p_parent,
+                                  ap_lstnr->p_con->p_ev_io);
+  (void) tiz_srv_io_watcher_stop (ap_lstnr->p_server->p_parent,
+                                  ap_lstnr->p_con->p_ev_io_rd);
+}
+
+/* A listener that is waiting for a request is only woken up when there is
+   something to read */
+static OMX_ERRORTYPE
+srv_wait_for_request (httpr_listener_t * ap_lstnr)
+{
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_server);
+  assert (ap_lstnr->p_con);
+  return tiz_srv_io_watcher_start (ap_lstnr->p_server->p_parent,
+                                   ap_lstnr->p_con->p_ev_io_rd);
+}
+
+static void
+srv_ready_add (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  assert (ap_server);
+  assert (ap_lstnr);
+  if (!ap_lstnr->ready)
+    {
+      ap_lstnr->p_prev_ready = NULL;
+      ap_lstnr->p_next_ready = ap_server->p_ready;
+      if (ap_server->p_ready)
+        {
+          ap_server->p_ready->p_prev_ready = ap_lstnr;
+        }
+      ap_server->p_ready = ap_lstnr;
+      ap_lstnr->ready = true;
+    }
+}
+
+static void
+srv_ready_remove (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  assert (ap_server);
+  assert (ap_lstnr);
+  if (ap_lstnr->ready)
+    {
+      if (ap_lstnr->p_prev_ready)
+        {
+          ap_lstnr->p_prev_ready->p_next_ready = ap_lstnr->p_next_ready;
+        }
+      else
+        {
+          ap_server->p_ready = ap_lstnr->p_next_ready;
+        }
+      if (ap_lstnr->p_next_ready)
+        {
+          ap_lstnr->p_next_ready->p_prev_ready = ap_lstnr->p_prev_ready;
+        }
+      ap_lstnr->p_prev_ready = NULL;
+      ap_lstnr->p_next_ready = NULL;
+      ap_lstnr->ready = false;
+    }
+}
+
+/* A listener whose socket can't take any more data leaves the ready list
+   until its one-shot io watcher reports the socket writable again */
+static void
+srv_block_listener (httpr_listener_t * ap_lstnr)
+{
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_server);
+  srv_ready_remove (ap_lstnr->p_server, ap_lstnr);
+  (void) srv_start_listener_io_watcher (ap_lstnr);
+}
+
+static OMX_ERRORTYPE
+srv_start_clock (httpr_server_t * ap_server)
+{
+  assert (ap_server);
+  if (!ap_server->pacing)
+    {
+      tiz_check_omx (tiz_srv_timer_watcher_start (
+        ap_server->p_parent, ap_server->p_ev_timer, ap_server->wait_time,
+        ap_server->wait_time));
+      ap_server->pacing = true;
+    }
+  return OMX_ErrorNone;
+}
+
+/* A mount point's first listener gets its initial burst straight away.
+   When the mount point is being segmented, the stream is already running
+   and the burst comes from the ring. */
+static OMX_ERRORTYPE
+srv_start_pacing (httpr_server_t * ap_server, httpr_mount_t * ap_mount)
+{
+  assert (ap_server);
+  assert (ap_mount);
+  if (1 == ap_mount->ring.nreaders && !srv_hls_enabled (ap_server, ap_mount))
+    {
+      ap_mount->pace_limit
+        = ap_mount->ring.head_pos + ap_mount->initial_burst_size;
+    }
+  return srv_start_clock (ap_server);
+}
+
+static void
+srv_stop_pacing (httpr_server_t * ap_server)
+{
+  assert (ap_server);
+  if (ap_server->pacing)
+    {
+      (void) tiz_srv_timer_watcher_stop (ap_server->p_parent,
+                                         ap_server->p_ev_timer);
+      ap_server->pacing = false;
+    }
+}
+
+/* MP3 streams are paced by their frame size. Other codecs are paced by
+   their nominal bitrate, with some headroom for VBR and the container. */
+static void
+srv_set_mount_rate (httpr_mount_t * ap_mount,
+                    const OMX_AUDIO_CODINGTYPE a_encoding,
+                    const OMX_U32 a_bitrate, const OMX_U32 a_num_channels,
+                    const OMX_U32 a_sample_rate)
+{
+  assert (ap_mount);
+
+  ap_mount->encoding = a_encoding;
+  ap_mount->bitrate = (a_bitrate != 0 ? a_bitrate : 448000);
+  ap_mount->num_channels = (a_num_channels != 0 ? a_num_channels : 2);
+  ap_mount->sample_rate = (a_sample_rate != 0 ? a_sample_rate : 44100);
+
+  if (OMX_AUDIO_CodingMP3 == a_encoding)
+    {
+      OMX_U32 bytes_per_frame
+        = (144 * ap_mount->bitrate / ap_mount->sample_rate) + 1;
+      ap_mount->bytes_per_sec = (double) bytes_per_frame
+                                * ap_mount->sample_rate
+                                / ICE_MP3_SAMPLES_PER_FRAME;
+    }
+  else
+    {
+      ap_mount->bytes_per_sec = (double) ap_mount->bitrate / 8
+                                * (100 + ICE_PACING_HEADROOM_PERCENT) / 100;
+    }
+}
+
+/* The clock ticks every few MP3 frames of the first mount point, and each
+   tick lets that long a stretch of every mount point's stream out to its
+   listeners */
+static void
+srv_set_pacing_rate (httpr_server_t * ap_server)
+{
+  OMX_U32 i = 0;
+
+  assert (ap_server);
+  assert (ap_server->nmounts > 0);
+  assert (ap_server->p_mounts[0].sample_rate > 0);
+
+  ap_server->pkts_per_sec
+    = (double) ap_server->p_mounts[0].sample_rate
+      / (double) (ICE_MP3_SAMPLES_PER_FRAME * ICE_PACING_FRAMES_PER_TICK);
+  ap_server->wait_time = (1 / ap_server->pkts_per_sec);
+
+  for (i = 0; i < ap_server->nmounts; ++i)
+    {
+      httpr_mount_t * p_mount = &(ap_server->p_mounts[i]);
+      p_mount->burst_size
+        = (OMX_U32) (p_mount->bytes_per_sec * ap_server->wait_time + 0.5);
+    }
+
+  if (ap_server->pacing)
+    {
+      (void) tiz_srv_timer_watcher_stop (ap_server->p_parent,
+                                         ap_server->p_ev_timer);
+      (void) tiz_srv_timer_watcher_start (
+        ap_server->p_parent, ap_server->p_ev_timer, ap_server->wait_time,
+        ap_server->wait_time);
+    }
+}
+
+/* The most a listener may lag behind the head of the ring, in bytes; 0 if
+   only the ring's size limits it. Never less than the burst-on-connect, or
+   new listeners would be taken for slow ones. */
+static uint64_t
+srv_max_lag (const httpr_server_t * ap_server, const httpr_mount_t * ap_mount)
+{
+  uint64_t max_lag = 0;
+
+  assert (ap_server);
+  assert (ap_mount);
+
+  if (ap_server->max_lag_ms > 0)
+    {
+      max_lag = (uint64_t) (ap_mount->bytes_per_sec * ap_server->max_lag_ms
+                            / 1000);
+    }
+  if (ap_server->max_lag_bytes > 0)
+    {
+      max_lag = max_lag > 0 ? MIN (max_lag, ap_server->max_lag_bytes)
+                            : ap_server->max_lag_bytes;
+    }
+  return max_lag > 0 ? MAX (max_lag, (uint64_t) ap_mount->initial_burst_size
+                                       + ap_mount->ring.chunk_size)
+                     : 0;
+}
+
+/* Applies the slow listener policy to the listeners that lag too far
+   behind. Only the chunks past the limit are looked at, so this costs
+   nothing while everyone keeps up. */
+static void
+srv_evict_laggards (httpr_server_t * ap_server, httpr_mount_t * ap_mount)
+{
+  httpr_ring_t * p_ring = NULL;
+  uint64_t max_lag = 0;
+  uint64_t seq = 0;
+  bool lagging = false;
+
+  assert (ap_server);
+  assert (ap_mount);
+  p_ring = &(ap_mount->ring);
+
+  if (0 == p_ring->nreaders || 0 == (max_lag = srv_max_lag (ap_server,
+                                                            ap_mount)))
+    {
+      return;
+    }
+
+  for (seq = p_ring->tail; seq < p_ring->head; ++seq)
+    {
+      const httpr_chunk_t * p_chunk = srv_ring_chunk (p_ring, seq);
+      if (p_chunk->pos + p_chunk->len + max_lag > p_ring->head_pos)
+        {
+          break;
+        }
+      lagging = lagging || p_chunk->refs > 0;
+    }
+
+  if (lagging)
+    {
+      srv_ring_evict (ap_server, ap_mount, seq - 1);
+    }
+}
+
+/* Moves the clock forward by one tick's worth of stream. While a mount
+   point's source is starved, the credit doesn't pile up beyond a single
+   tick. The listeners left too far behind are dealt with on the way. */
+static void
+srv_pace_tick (httpr_server_t * ap_server)
+{
+  OMX_U32 i = 0;
+  assert (ap_server);
+  for (i = 0; i < ap_server->nmounts; ++i)
+    {
+      httpr_mount_t * p_mount = &(ap_server->p_mounts[i]);
+      p_mount->pace_limit
+        = MIN (p_mount->pace_limit + p_mount->burst_size,
+               p_mount->ring.head_pos + p_mount->burst_size);
+      srv_evict_laggards (ap_server, p_mount);
+    }
+}
+
+/* The HLS segmenters keep the clock running too */
+static inline bool
+srv_has_readers (const httpr_server_t * ap_server)
+{
+  OMX_U32 i = 0;
+  assert (ap_server);
+  for (i = 0; i < ap_server->nmounts; ++i)
+    {
+      if (ap_server->p_mounts[i].ring.nreaders > 0
+          || srv_hls_enabled (ap_server, &(ap_server->p_mounts[i])))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+static void
+srv_destroy_connection (httpr_connection_t * ap_con)
+{
+  if (ap_con)
+    {
+      if (ICE_SOCK_ERROR != ap_con->sockfd)
+        {
+          close (ap_con->sockfd);
+        }
+      tiz_mem_free (ap_con->p_ip);
+      tiz_mem_free (ap_con->p_host);
+      assert (ap_con->p_lstnr && ap_con->p_lstnr->p_server);
+      tiz_srv_io_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
+                                  ap_con->p_ev_io);
+      tiz_srv_io_watcher_destroy (ap_con->p_lstnr->p_server->p_parent,
+                                  ap_con->p_ev_io_rd);
+      tiz_mem_free (ap_con);
+    }
+}
+
+static void
+srv_destroy_listener (httpr_listener_t * ap_lstnr)
+{
+  if (ap_lstnr)
+    {
+      if (ap_lstnr->p_server)
+        {
+          srv_ready_remove (ap_lstnr->p_server, ap_lstnr);
+          srv_zc_unpin_completed (ap_lstnr, true);
+          srv_ring_detach (ap_lstnr);
+        }
+      srv_icy_block_unref (ap_lstnr->p_meta_block);
+      srv_hls_segment_unref (ap_lstnr->p_segment);
+      if (ap_lstnr->file_fd >= 0)
+        {
+          close (ap_lstnr->file_fd);
+        }
+      if (ap_lstnr->p_parser)
+        {
+          tiz_http_parser_destroy (ap_lstnr->p_parser);
+        }
+      tiz_mem_free (ap_lstnr->buf.p_data);
+      srv_destroy_connection (ap_lstnr->p_con);
+      tiz_mem_free (ap_lstnr);
+    }
+}
+
+static void
+srv_remove_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  int nlstnrs = 0;
+
+  assert (ap_server);
+  assert (ap_lstnr);
+
+  nlstnrs = srv_get_listeners_count (ap_server);
+  assert (nlstnrs > 0);
+
+  TIZ_LOG (TIZ_PRIORITY_TRACE,
+           "Destroyed listener [%s] - [%d] listeners remaining",
+           ap_lstnr->p_con->p_ip, nlstnrs - 1);
+
+  ap_server->stats.bytes_sent += ap_lstnr->p_con->sent_total;
+  tiz_map_erase (ap_server->p_lstnrs, &ap_lstnr->p_con->sockfd);
+  assert (nlstnrs - 1 == srv_get_listeners_count (ap_server));
+
+  if (!srv_has_readers (ap_server))
+    {
+      srv_stop_pacing (ap_server);
+    }
+
+  /* NOTE: No need to call srv_destroy_listener as this has been called already
+   * by
+   * the map's listeners_map_free_func */
+}
+
+static httpr_connection_t *
+srv_create_connection (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
+                       const int connected_sockfd, char * ap_ip,
+                       const unsigned short ap_port)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  httpr_connection_t * p_con = NULL;
+  OMX_HANDLETYPE p_hdl = NULL;
+
+  assert (ap_server);
+  assert (ap_lstnr);
+  p_hdl = handleOf (ap_server->p_parent);
+
+  p_con
+    = (httpr_connection_t *) tiz_mem_calloc (1, sizeof (httpr_connection_t));
+  rc = p_con ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+  goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the connection struct");
+
+  p_con->p_lstnr = ap_lstnr;
+  p_con->con_time = time (NULL);
+  p_con->sent_total = 0;
+  p_con->sent_last = 0;
+  p_con->sockfd = connected_sockfd;
+  p_con->p_host = NULL;
+  p_con->p_ip = ap_ip;
+  p_con->port = ap_port;
+  p_con->p_ev_io = NULL;
+  p_con->p_ev_io_rd = NULL;
+
+  /* We are interested in knowing when a listener socket is available for
+   * writing */
+  rc = tiz_srv_io_watcher_init (ap_server->p_parent, &(p_con->p_ev_io),
+                                p_con->sockfd, TIZ_EVENT_WRITE, true);
+  goto_end_on_omx_error (rc, p_hdl, "Unable to init the client's io event");
+
+  /* ... and when a request has arrived */
+  rc = tiz_srv_io_watcher_init (ap_server->p_parent, &(p_con->p_ev_io_rd),
+                                p_con->sockfd, TIZ_EVENT_READ, true);
+  goto_end_on_omx_error (rc, p_hdl,
+                         "Unable to init the client's read io event");
+
+end:
+  if (OMX_ErrorNone != rc)
+    {
+      srv_destroy_connection (p_con);
+      p_con = NULL;
+    }
+
+  return p_con;
+}
+
+static OMX_ERRORTYPE
+srv_create_listener (httpr_server_t * ap_server, httpr_listener_t ** app_lstnr,
+                     const int a_connected_sockfd, char * ap_ip,
+                     const unsigned short ap_port)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorInsufficientResources;
+  httpr_listener_t * p_lstnr = NULL;
+  httpr_connection_t * p_con = NULL;
+  OMX_HANDLETYPE p_hdl = NULL;
+  int sockrc = ICE_SOCK_ERROR;
+
+  assert (ap_server);
+  assert (app_lstnr);
+  assert (ICE_SOCK_ERROR != a_connected_sockfd);
+  assert (ap_ip);
+  p_hdl = handleOf (ap_server->p_parent);
+
+  p_lstnr = (httpr_listener_t *) tiz_mem_calloc (1, sizeof (httpr_listener_t));
+  rc = p_lstnr ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+  goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the listener structure");
+  p_lstnr->file_fd = -1;
+
+  p_con = srv_create_connection (ap_server, p_lstnr, a_connected_sockfd, ap_ip,
+                                 ap_port);
+  rc = p_con ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+  goto_end_on_omx_error (rc, p_hdl, "Unable to init the listener's connection");
+
+  p_lstnr->p_server = ap_server;
+  p_lstnr->p_con = p_con;
+  p_lstnr->p_mount = NULL;
+  p_lstnr->respcode = 200;
+  p_lstnr->intro_offset = 0;
+  p_lstnr->chunk = 0;
+  p_lstnr->offset = 0;
+  p_lstnr->metaint = 0;
+  p_lstnr->metaint_left = 0;
+  p_lstnr->p_meta = NULL;
+  p_lstnr->meta_len = 0;
+  p_lstnr->meta_offset = 0;
+  p_lstnr->p_meta_block = NULL;
+  p_lstnr->meta_gen = 0;
+  p_lstnr->skips = 0;
+  p_lstnr->oneshot = false;
+  p_lstnr->p_segment = NULL;
+  p_lstnr->segment_offset = 0;
+  p_lstnr->segment_end = 0;
+  p_lstnr->file_offset = 0;
+  p_lstnr->file_end = 0;
+  p_lstnr->keepalive = false;
+  p_lstnr->nrequests = 0;
+  p_lstnr->idle_since = time (NULL);
+  p_lstnr->buf.len = ICE_LISTENER_BUF_SIZE;
+  p_lstnr->buf.offset = 0;
+  p_lstnr->p_parser = NULL;
+  p_lstnr->need_response = true;
+  p_lstnr->ready = false;
+  p_lstnr->attached = false;
+  p_lstnr->starved = false;
+  p_lstnr->failed = false;
+  p_lstnr->corked = false;
+  p_lstnr->zerocopy = false;
+  p_lstnr->zc_head = 0;
+  p_lstnr->zc_tail = 0;
+  p_lstnr->p_prev_ready = NULL;
+  p_lstnr->p_next_ready = NULL;
+
+  p_lstnr->buf.p_data = (char *) tiz_mem_alloc (ICE_LISTENER_BUF_SIZE);
+  rc = p_lstnr->buf.p_data ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+  goto_end_on_omx_error (rc, p_hdl, "Unable to alloc the listener's buffer");
+  p_lstnr->buf.p_data[ICE_LISTENER_BUF_SIZE - 1] = '\0';
+
+  rc = tiz_http_parser_init (&(p_lstnr->p_parser), ETIZHttpParserTypeRequest);
+  goto_end_on_omx_error (rc, p_hdl, "Unable to init the http parser");
+
+  sockrc = srv_set_non_blocking (p_lstnr->p_con->sockfd);
+  rc = sockrc < 0 ? OMX_ErrorInsufficientResources : OMX_ErrorNone;
+  goto_end_on_socket_error (sockrc, p_hdl, strerror (errno));
+
+  sockrc = srv_set_nodelay (p_lstnr->p_con->sockfd);
+  rc = sockrc < 0 ? OMX_ErrorInsufficientResources : OMX_ErrorNone;
+  goto_end_on_socket_error (sockrc, p_hdl, strerror (errno));
+
+  if (ICE_SOCK_ERROR == srv_set_notsent_lowat (p_lstnr->p_con->sockfd))
+    {
+      TIZ_WARN (p_hdl, "TCP_NOTSENT_LOWAT: %s", strerror (errno));
+    }
+
+  p_lstnr->zerocopy
+    = (ap_server->zerocopy && 0 == srv_set_zerocopy (p_lstnr->p_con->sockfd));
+
+  rc = OMX_ErrorNone;
+
+end:
+
+  if (OMX_ErrorNone != rc)
+    {
+      srv_destroy_listener (p_lstnr);
+      p_lstnr = NULL;
+    }
+
+  *app_lstnr = p_lstnr;
+
+  return rc;
+}
+
+static int
+srv_read_from_listener (httpr_listener_t * ap_lstnr)
+{
+  httpr_connection_t * p_con = NULL;
+  httpr_listener_buffer_t * p_buf = NULL;
+
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_con);
+
+  p_con = ap_lstnr->p_con;
+  p_buf = &ap_lstnr->buf;
+  assert (p_buf->p_data);
+  assert (p_buf->len > 0);
+
+  errno = 0;
+  return recv (p_con->sockfd, p_buf->p_data, p_buf->len, 0);
+}
+
+static ssize_t
+srv_build_http_negative_response (char * ap_buf, size_t len, int status,
+                                  const char * ap_msg)
+{
+  const char * http_version = "1.0";
+  time_t now;
+  struct tm result;
+  struct tm * gmtime_result;
+  char currenttime_buffer[80];
+  char status_buffer[80];
+  char contenttype_buffer[80];
+  ssize_t ret;
+  const char * statusmsg = NULL;
+  const char * contenttype = "text/html";
+
+  assert (ap_buf);
+
+  switch (status)
+    {
+      case 400:
+        {
+          statusmsg = "Bad Request";
+        }
+        break;
+      case 403:
+        {
+          statusmsg = "Forbidden";
+        }
+        break;
+      case 404:
+        {
+          statusmsg = "File Not Found";
+        }
+        break;
+      case 500:
+        {
+          statusmsg = "Internal Server Error";
+        }
+        break;
+      case 503:
+        {
+          statusmsg = "Service Unavailable";
+        }
+        break;
+      default:
+        {
+          statusmsg = "(unknown status code)";
+        }
+        break;
+    }
+
+  snprintf (status_buffer, sizeof (status_buffer), "HTTP/%s %d %s\r\n",
+            http_version, status, statusmsg);
+  snprintf (contenttype_buffer, sizeof (contenttype_buffer),
+            "Content-Type: %s\r\n", contenttype);
+
+  time (&now);
+  gmtime_result = gmtime_r (&now, &result);
+
+  strftime (currenttime_buffer, sizeof (currenttime_buffer),
+            "Date: %a, %d-%b-%Y %X GMT\r\n", gmtime_result);
+
+  ret = snprintf (ap_buf, len, "%sServer: %s\r\n%s%s%s%s", status_buffer,
+                  "Tizonia HTTP Server 0.1.0", currenttime_buffer,
+                  contenttype_buffer, (ap_msg ? "\r\n" : ""),
+                  (ap_msg ? ap_msg : ""));
+
+  return ret;
+}
+
+static void
+srv_send_http_error (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
+                     int a_error, const char * ap_err_msg)
+{
+  ssize_t resp_size = 0;
+
+  assert (ap_server);
+  assert (ap_lstnr);
+  assert (ap_lstnr->buf.p_data);
+  assert (ap_lstnr->p_con);
+  assert (ap_err_msg);
+
+  ap_lstnr->buf.p_data[ICE_LISTENER_BUF_SIZE - 1] = '\0';
+  resp_size = srv_build_http_negative_response (
+    ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE - 1, a_error, "");
+
+  snprintf (ap_lstnr->buf.p_data + resp_size, ICE_LISTENER_BUF_SIZE - resp_size,
+            "<html><head><title>Error %i</title></head><body><b>%i - %s</b>"
+            "</body></html>\r\n",
+            a_error, a_error, ap_err_msg);
+
+  ap_lstnr->buf.len = strnlen (ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE);
+
+  /* Ignore send error */
+  (void) send (ap_lstnr->p_con->sockfd, ap_lstnr->buf.p_data, ap_lstnr->buf.len, 0);
+  ap_lstnr->buf.len = 0;
+}
+
+static ssize_t
+srv_build_http_positive_response (const httpr_mount_t * ap_mount, char * ap_buf,
+                                  size_t len, OMX_U32 a_metaint)
+{
+  const char * http_version = "1.0";
+  char status_buffer[80];
+  char contenttype_buffer[80];
+  char icybr_buffer[80];
+  char icyname_buffer[OMX_MAX_STRINGNAME_SIZE * 2];
+  char icydescription_buffer[OMX_MAX_STRINGNAME_SIZE * 2];
+  char icygenre_buffer[OMX_MAX_STRINGNAME_SIZE * 2];
+  char icyurl_buffer[OMX_MAX_STRINGNAME_SIZE * 2];
+  char icypub_buffer[80];
+  char iceaudioinfo_buffer[80];
+  char icymetaint_buffer[80];
+  ssize_t ret;
+  const char * statusmsg = "OK";
+  const char * contenttype = NULL;
+  int status = 200;
+  int pub = 0;
+
+  assert (ap_mount);
+  assert (ap_buf);
+
+  contenttype = OMX_AUDIO_CodingMP3 == ap_mount->encoding ? "audio/mpeg"
+                                                         : "audio/ogg";
+
+  /* HTTP status line */
+  snprintf (status_buffer, sizeof (status_buffer), "HTTP/%s %d %s\r\n",
+            http_version, status, statusmsg);
+
+  /* HTTP Content-Type header */
+  snprintf (contenttype_buffer, sizeof (contenttype_buffer),
+            "Content-Type: %s\r\n", contenttype);
+
+  /* icy-br header */
+  snprintf (icybr_buffer, sizeof (icybr_buffer), "icy-br:%d\r\n",
+            (int) ap_mount->bitrate / 1000);
+
+  /* ice-audio-info header */
+  snprintf (iceaudioinfo_buffer, sizeof (iceaudioinfo_buffer),
+            "ice-audio-info: "
+            "bitrate=%d;channels=%d;samplerate=%d\r\n",
+            (int) ap_mount->bitrate, (int) ap_mount->num_channels,
+            (int) ap_mount->sample_rate);
+
+  /* icy-name header */
+  snprintf (icyname_buffer, sizeof (icyname_buffer), "icy-name:%s\r\n",
+            ap_mount->station_name);
+
+  /* icy-decription header */
+  snprintf (icydescription_buffer, sizeof (icydescription_buffer),
+            "icy-description:%s\r\n",
+            ap_mount->station_description);
+
+  /* icy-genre header */
+  snprintf (icygenre_buffer, sizeof (icygenre_buffer), "icy-genre:%s\r\n",
+            ap_mount->station_genre);
+
+  /* icy-url header */
+  snprintf (icyurl_buffer, sizeof (icyurl_buffer), "icy-url:%s\r\n",
+            ap_mount->station_url);
+
+  /* icy-pub header */
+  snprintf (icypub_buffer, sizeof (icypub_buffer), "icy-pub:%u\r\n", pub);
+
+  if (a_metaint > 0)
+    {
+      /* icy-metaint header */
+      snprintf (icymetaint_buffer, sizeof (icymetaint_buffer),
+                "icy-metaint:%u\r\n", (unsigned int) a_metaint);
+    }
+
+  ret = snprintf (
+    ap_buf, len, "%s%s%s%s%s%s%s%s%s%s%s%s\r\n", status_buffer,
+    contenttype_buffer, icybr_buffer, iceaudioinfo_buffer, icyname_buffer,
+    icydescription_buffer, icygenre_buffer, icyurl_buffer, icypub_buffer,
+    (a_metaint > 0 ? icymetaint_buffer : ""),
+    "Server: Tizonia HTTP Renderer 0.1.0\r\n", "Cache-Control: no-cache\r\n");
+
+  return ret;
+}
+
+static int
+srv_send_http_response (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  ssize_t sent_bytes = 0;
+
+  assert (ap_server);
+  assert (ap_lstnr);
+  assert (ap_lstnr->buf.p_data);
   assert (ap_lstnr->p_con);
 
-  p_con = ap_lstnr->p_con;
-  p_buf = &ap_lstnr->buf;
-  assert (p_buf->p_data);
-  assert (p_buf->len > 0);
+  ap_lstnr->buf.len = strnlen (ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE);
+
+  /* Hold the headers back so that they leave with the initial burst */
+  ap_lstnr->corked = (0 == srv_set_cork (ap_lstnr->p_con->sockfd, true));
+
+  sent_bytes = send (ap_lstnr->p_con->sockfd, ap_lstnr->buf.p_data,
+                     ap_lstnr->buf.len, MSG_NOSIGNAL);
+  ap_lstnr->buf.len = 0;
+  return sent_bytes;
+}
+
+/* 'Icy-MetaData: 1' asks for metadata at the mount point's interval. A
+   larger value asks for metadata every that many audio bytes instead. ICY
+   metadata can only be interleaved with MP3 streams. */
+static OMX_U32
+srv_negotiate_metaint (const httpr_mount_t * ap_mount,
+                       const char * ap_icy_metadata)
+{
+  unsigned long requested = 0;
+  OMX_U32 metaint = 0;
+
+  assert (ap_mount);
+  assert (ap_icy_metadata);
+
+  requested = strtoul (ap_icy_metadata, NULL, 10);
+  metaint = ap_mount->metadata_period;
+  if (0 == requested || 0 == metaint
+      || OMX_AUDIO_CodingMP3 != ap_mount->encoding)
+    {
+      return 0;
+    }
+  if (requested > 1)
+    {
+      metaint = MIN (MAX (requested, ICE_MIN_METADATA_INTERVAL),
+                     ICE_MAX_METADATA_INTERVAL);
+    }
+  return metaint;
+}
+
+/* Routes a request to the mount point with that exact path; the query
+   string is ignored. A server with a single mount point takes any path. */
+static httpr_mount_t *
+srv_find_mount (const httpr_server_t * ap_server, const char * ap_url)
+{
+  size_t len = 0;
+  OMX_U32 i = 0;
+
+  assert (ap_server);
+  assert (ap_url);
+
+  len = strcspn (ap_url, "?");
+  for (i = 0; i < ap_server->nmounts; ++i)
+    {
+      const char * p_name = (const char *) ap_server->p_mounts[i].mount_name;
+      if (strlen (p_name) == len && 0 == strncmp (p_name, ap_url, len))
+        {
+          return &(ap_server->p_mounts[i]);
+        }
+    }
+  return 1 == ap_server->nmounts ? &(ap_server->p_mounts[0]) : NULL;
+}
+
+/* Routes a request for the HLS playlist, or for one of the segments, of a
+   segmented mount point. The query string is ignored. */
+static httpr_mount_t *
+srv_find_hls_mount (const httpr_server_t * ap_server, const char * ap_url,
+                    bool * ap_playlist, uint64_t * ap_seq)
+{
+  size_t len = 0;
+  OMX_U32 i = 0;
+
+  assert (ap_server);
+  assert (ap_url);
+  assert (ap_playlist);
+  assert (ap_seq);
+
+  len = strcspn (ap_url, "?");
+  for (i = 0; i < ap_server->nmounts; ++i)
+    {
+      httpr_mount_t * p_mount = &(ap_server->p_mounts[i]);
+      const size_t base_len = strlen (p_mount->hls.base);
+      const char * p_rest = ap_url + base_len;
+      const size_t rest_len = len - base_len;
+
+      if (!srv_hls_enabled (ap_server, p_mount) || 0 == base_len
+          || len <= base_len || 0 != strncmp (ap_url, p_mount->hls.base,
+                                              base_len))
+        {
+          continue;
+        }
+
+      if (strlen (".m3u8") == rest_len
+          && 0 == strncmp (p_rest, ".m3u8", rest_len))
+        {
+          *ap_playlist = true;
+          return p_mount;
+        }
+
+      if (rest_len > strlen ("-.mp3") && '-' == p_rest[0]
+          && isdigit ((unsigned char) p_rest[1])
+          && 0 == strncmp (p_rest + rest_len - 4, ".mp3", 4))
+        {
+          char * p_end = NULL;
+          *ap_seq = strtoull (p_rest + 1, &p_end, 10);
+          if (p_end == p_rest + rest_len - 4)
+            {
+              *ap_playlist = false;
+              return p_mount;
+            }
+        }
+    }
+  return NULL;
+}
+
+/* Parses a single byte range, i.e. 'bytes=first-last', 'bytes=first-' or
+   'bytes=-suffix'. Returns 206, with the first and last bytes of the range;
+   416 if the range starts past the end of the body; or 200 if the whole
+   body is to be sent. Several ranges, or a malformed one, are ignored. */
+static int
+srv_parse_range (const char * ap_range, const off_t a_size, off_t * ap_first,
+                 off_t * ap_last)
+{
+  const char * p_spec = NULL;
+  char * p_end = NULL;
+  long long first = 0;
+  long long last = 0;
+
+  assert (ap_first);
+  assert (ap_last);
 
-  errno = 0;
-  return recv (p_con->sockfd, p_buf->p_data, p_buf->len, 0);
+  *ap_first = 0;
+  *ap_last = a_size - 1;
+
+  if (!ap_range || 0 != strncasecmp (ap_range, "bytes=", strlen ("bytes="))
+      || strchr (ap_range, ','))
+    {
+      return 200;
+    }
+
+  p_spec = ap_range + strlen ("bytes=");
+  while (isspace ((unsigned char) *p_spec))
+    {
+      ++p_spec;
+    }
+
+  if ('-' == *p_spec)
+    {
+      /* The last 'suffix' bytes */
+      const long long suffix = strtoll (p_spec + 1, &p_end, 10);
+      if (p_end == p_spec + 1 || suffix < 0)
+        {
+          return 200;
+        }
+      if (0 == suffix || 0 == a_size)
+        {
+          return 416;
+        }
+      first = suffix >= a_size ? 0 : a_size - suffix;
+      last = a_size - 1;
+    }
+  else
+    {
+      if (!isdigit ((unsigned char) *p_spec))
+        {
+          return 200;
+        }
+      first = strtoll (p_spec, &p_end, 10);
+      if ('-' != *p_end)
+        {
+          return 200;
+        }
+      p_spec = p_end + 1;
+      last = a_size - 1;
+      if (isdigit ((unsigned char) *p_spec))
+        {
+          last = strtoll (p_spec, &p_end, 10);
+          if (last < first)
+            {
+              return 200;
+            }
+        }
+      if (first >= a_size)
+        {
+          return 416;
+        }
+      last = MIN (last, (long long) a_size - 1);
+    }
+
+  *ap_first = first;
+  *ap_last = last;
+  return 206;
 }
 
+/* The headers of a complete, on-demand response, i.e. a local file or an
+   HLS playlist or segment. 'ap_range' is the Content-Range, if any, and
+   'ap_extra' any other header lines, each ending in CRLF. */
 static ssize_t
-srv_build_http_negative_response (char * ap_buf, size_t len, int status,
-                                  const char * ap_msg)
+srv_build_ondemand_response_headers (char * ap_buf, const size_t a_len,
+                                     const int a_status,
+                                     const char * ap_content_type,
+                                     const off_t a_content_len,
+                                     const char * ap_range,
+                                     const char * ap_extra,
+                                     const OMX_U32 a_requests_left)
 {
-  const char * http_version = "1.0";
-  time_t now;
-  struct tm result;
-  struct tm * gmtime_result;
-  char currenttime_buffer[80];
-  char status_buffer[80];
-  char contenttype_buffer[80];
-  ssize_t ret;
+  char range_buffer[80] = "";
+  char connection_buffer[80];
   const char * statusmsg = NULL;
-  const char * contenttype = "text/html";
 
   assert (ap_buf);
+  assert (ap_content_type);
+  assert (ap_extra);
 
-  switch (status)
+  switch (a_status)
     {
-      case 400:
+      case 206:
         {
-          statusmsg = "Bad Request";
+          statusmsg = "Partial Content";
         }
         break;
-      case 403:
+      case 416:
         {
-          statusmsg = "Forbidden";
+          statusmsg = "Range Not Satisfiable";
         }
         break;
-      case 404:
+      default:
         {
-          statusmsg = "File Not Found";
+          statusmsg = "OK";
         }
         break;
-      case 500:
+    }
+
+  if (ap_range)
+    {
+      snprintf (range_buffer, sizeof (range_buffer), "Content-Range: %s\r\n",
+                ap_range);
+    }
+
+  if (a_requests_left > 0)
+    {
+      snprintf (connection_buffer, sizeof (connection_buffer),
+                "Connection: keep-alive\r\n"
+                "Keep-Alive: timeout=%d, max=%u\r\n",
+                ICE_KEEPALIVE_TIMEOUT, (unsigned int) a_requests_left);
+    }
+  else
+    {
+      snprintf (connection_buffer, sizeof (connection_buffer),
+                "Connection: close\r\n");
+    }
+
+  return snprintf (ap_buf, a_len,
+                   "HTTP/1.1 %d %s\r\n"
+                   "Content-Type: %s\r\n"
+                   "Content-Length: %lld\r\n"
+                   "%s"
+                   "Accept-Ranges: bytes\r\n"
+                   "%s"
+                   "Access-Control-Allow-Origin: *\r\n"
+                   "Server: Tizonia HTTP Renderer 0.1.0\r\n"
+                   "%s\r\n",
+                   a_status, statusmsg, ap_content_type,
+                   (long long) a_content_len, range_buffer, ap_extra,
+                   connection_buffer);
+}
+
+/* Requests that the connection may still carry after this one, if it is to
+   be kept open */
+static OMX_U32
+srv_requests_left (const httpr_listener_t * ap_lstnr)
+{
+  assert (ap_lstnr);
+  return ap_lstnr->keepalive
+           ? ICE_KEEPALIVE_MAX_REQUESTS - ap_lstnr->nrequests
+           : 0;
+}
+
+/* The playlist lists the segments still around, oldest first. Caches may
+   keep it for half a segment. */
+static ssize_t
+srv_build_hls_playlist_response (const httpr_server_t * ap_server,
+                                 const httpr_listener_t * ap_lstnr,
+                                 char * ap_buf, const size_t a_len,
+                                 const bool a_head)
+{
+  char body[ICE_LISTENER_BUF_SIZE / 2];
+  char cache_buffer[80];
+  const httpr_mount_t * p_mount = NULL;
+  const char * p_name = NULL;
+  uint64_t first = 0;
+  uint64_t seq = 0;
+  OMX_U32 target = 0;
+  size_t body_len = 0;
+  ssize_t head_len = 0;
+
+  assert (ap_server);
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_mount);
+  assert (ap_buf);
+  p_mount = ap_lstnr->p_mount;
+
+  /* Segment URIs are relative to the playlist's */
+  p_name = strrchr (p_mount->hls.base, '/');
+  p_name = p_name ? p_name + 1 : p_mount->hls.base;
+
+  first = p_mount->hls.next_seq > ap_server->hls_nsegments
+            ? p_mount->hls.next_seq - ap_server->hls_nsegments
+            : 0;
+  while (first < p_mount->hls.next_seq
+         && !srv_hls_segment (ap_server, p_mount, first))
+    {
+      ++first;
+    }
+  if (first == p_mount->hls.next_seq)
+    {
+      /* Nothing to list yet */
+      return 0;
+    }
+
+  target = ap_server->hls_segment_secs;
+  for (seq = first; seq < p_mount->hls.next_seq; ++seq)
+    {
+      const httpr_hls_segment_t * p_segment
+        = srv_hls_segment (ap_server, p_mount, seq);
+      if (p_segment)
         {
-          statusmsg = "Internal Server Error";
+          target = MAX (target, (OMX_U32) (p_segment->duration + 0.5));
         }
-        break;
-      default:
+    }
+
+  body_len = snprintf (body, sizeof (body),
+                       "#EXTM3U\n"
+                       "#EXT-X-VERSION:3\n"
+                       "#EXT-X-TARGETDURATION:%u\n"
+                       "#EXT-X-MEDIA-SEQUENCE:%llu\n",
+                       (unsigned int) target, (unsigned long long) first);
+  for (seq = first; seq < p_mount->hls.next_seq && body_len < sizeof (body);
+       ++seq)
+    {
+      const httpr_hls_segment_t * p_segment
+        = srv_hls_segment (ap_server, p_mount, seq);
+      if (p_segment)
         {
-          statusmsg = "(unknown status code)";
+          body_len += snprintf (body + body_len, sizeof (body) - body_len,
+                                "#EXTINF:%.3f,\n%s-%llu.mp3\n",
+                                p_segment->duration, p_name,
+                                (unsigned long long) seq);
         }
-        break;
+    }
+  if (body_len >= sizeof (body))
+    {
+      return 0;
     }
 
-  snprintf (status_buffer, sizeof (status_buffer), "HTTP/%s %d %s\r\n",
-            http_version, status, statusmsg);
-  snprintf (contenttype_buffer, sizeof (contenttype_buffer),
-            "Content-Type: %s\r\n", contenttype);
+  snprintf (cache_buffer, sizeof (cache_buffer),
+            "Cache-Control: public, max-age=%u\r\n",
+            (unsigned int) MAX (1, ap_server->hls_segment_secs / 2));
+  head_len = srv_build_ondemand_response_headers (
+    ap_buf, a_len, 200, "application/vnd.apple.mpegurl", body_len, NULL,
+    cache_buffer, srv_requests_left (ap_lstnr));
+  if (head_len < 0 || head_len + body_len >= a_len)
+    {
+      return 0;
+    }
+  if (a_head)
+    {
+      return head_len;
+    }
+  memcpy (ap_buf + head_len, body, body_len);
+  return head_len + body_len;
+}
 
-  time (&now);
-  gmtime_result = gmtime_r (&now, &result);
+/* Prepares the complete response to an HLS request. Returns the HTTP
+   status. */
+static int
+srv_prepare_hls_response (httpr_server_t * ap_server,
+                          httpr_listener_t * ap_lstnr, const bool a_playlist,
+                          const uint64_t a_seq, const bool a_head,
+                          const char * ap_range)
+{
+  httpr_mount_t * p_mount = NULL;
+  int status = 200;
+  ssize_t len = 0;
 
-  strftime (currenttime_buffer, sizeof (currenttime_buffer),
-            "Date: %a, %d-%b-%Y %X GMT\r\n", gmtime_result);
+  assert (ap_server);
+  assert (ap_lstnr);
+  assert (ap_lstnr->p_mount);
+  p_mount = ap_lstnr->p_mount;
 
-  ret = snprintf (ap_buf, len, "%sServer: %s\r\n%s%s%s%s", status_buffer,
-                  "Tizonia HTTP Server 0.1.0", currenttime_buffer,
-                  contenttype_buffer, (ap_msg ? "\r\n" : ""),
-                  (ap_msg ? ap_msg : ""));
+  if (a_playlist)
+    {
+      len = srv_build_hls_playlist_response (ap_server, ap_lstnr,
+                                             ap_lstnr->buf.p_data,
+                                             ICE_LISTENER_BUF_SIZE - 1, a_head);
+      if (len <= 0)
+        {
+          return 503;
+        }
+    }
+  else
+    {
+      httpr_hls_segment_t * p_segment
+        = srv_hls_segment (ap_server, p_mount, a_seq);
+      char cache_buffer[80];
+      char range_buffer[64];
+      off_t first = 0;
+      off_t last = 0;
+
+      if (!p_segment)
+        {
+          return 404;
+        }
 
-  return ret;
+      status = srv_parse_range (ap_range, p_segment->len, &first, &last);
+      if (416 == status)
+        {
+          snprintf (range_buffer, sizeof (range_buffer), "bytes */%u",
+                    (unsigned int) p_segment->len);
+        }
+      else
+        {
+          snprintf (range_buffer, sizeof (range_buffer), "bytes %lld-%lld/%u",
+                    (long long) first, (long long) last,
+                    (unsigned int) p_segment->len);
+        }
+
+      /* A segment doesn't change while it is listed */
+      snprintf (cache_buffer, sizeof (cache_buffer),
+                "Cache-Control: public, max-age=%u\r\n",
+                (unsigned int) (ap_server->hls_nsegments
+                                * ap_server->hls_segment_secs));
+      len = srv_build_ondemand_response_headers (
+        ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE - 1, status, "audio/mpeg",
+        416 == status ? 0 : last - first + 1,
+        200 == status ? NULL : range_buffer, cache_buffer,
+        srv_requests_left (ap_lstnr));
+      if (len <= 0 || len >= ICE_LISTENER_BUF_SIZE - 1)
+        {
+          return 500;
+        }
+      if (!a_head && 416 != status)
+        {
+          p_segment->refs++;
+          ap_lstnr->p_segment = p_segment;
+          ap_lstnr->segment_offset = first;
+          ap_lstnr->segment_end = last + 1;
+        }
+    }
+
+  ap_lstnr->buf.len = len;
+  ap_lstnr->buf.offset = 0;
+  ap_lstnr->oneshot = true;
+  return status;
 }
 
-static void
-srv_send_http_error (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                     int a_error, const char * ap_err_msg)
+static const char *
+srv_content_type (const char * ap_path)
 {
-  ssize_t resp_size = 0;
+  static const struct
+  {
+    const char * p_ext;
+    const char * p_type;
+  } types[] = {
+    { "mp3", "audio/mpeg" },  { "ogg", "audio/ogg" },
+    { "oga", "audio/ogg" },   { "opus", "audio/ogg" },
+    { "flac", "audio/flac" }, { "m4a", "audio/mp4" },
+    { "aac", "audio/aac" },   { "wav", "audio/wav" },
+    { "m3u8", "application/vnd.apple.mpegurl" },
+  };
+  const char * p_ext = NULL;
+  size_t i = 0;
+
+  assert (ap_path);
+  p_ext = strrchr (ap_path, '.');
+  for (i = 0; p_ext && i < sizeof (types) / sizeof (types[0]); ++i)
+    {
+      if (0 == strcasecmp (p_ext + 1, types[i].p_ext))
+        {
+          return types[i].p_type;
+        }
+    }
+  return "application/octet-stream";
+}
+
+/* Prepares the response to a request for a local file; the listener takes
+   the file over. Returns the HTTP status. */
+static int
+srv_prepare_file_response (httpr_server_t * ap_server,
+                           httpr_listener_t * ap_lstnr, const int a_fd,
+                           const struct stat * ap_st, const char * ap_path,
+                           const bool a_head, const char * ap_range)
+{
+  char modified_buffer[80];
+  char range_buffer[80];
+  struct tm result;
+  off_t first = 0;
+  off_t last = 0;
+  ssize_t len = 0;
+  int status = 200;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (ap_lstnr->buf.p_data);
-  assert (ap_lstnr->p_con);
-  assert (ap_err_msg);
+  assert (a_fd >= 0);
+  assert (ap_st);
+  assert (ap_path);
 
-  ap_lstnr->buf.p_data[ICE_LISTENER_BUF_SIZE - 1] = '\0';
-  resp_size = srv_build_http_negative_response (
-    ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE - 1, a_error, "");
+  status = srv_parse_range (ap_range, ap_st->st_size, &first, &last);
+  if (416 == status)
+    {
+      snprintf (range_buffer, sizeof (range_buffer), "bytes */%lld",
+                (long long) ap_st->st_size);
+    }
+  else
+    {
+      snprintf (range_buffer, sizeof (range_buffer), "bytes %lld-%lld/%lld",
+                (long long) first, (long long) last,
+                (long long) ap_st->st_size);
+    }
 
-  snprintf (ap_lstnr->buf.p_data + resp_size, ICE_LISTENER_BUF_SIZE - resp_size,
-            "<html><head><title>Error %i</title></head><body><b>%i - %s</b>"
-            "</body></html>\r\n",
-            a_error, a_error, ap_err_msg);
+  strftime (modified_buffer, sizeof (modified_buffer),
+            "Last-Modified: %a, %d %b %Y %H:%M:%S GMT\r\n",
+            gmtime_r (&(ap_st->st_mtime), &result));
 
-  ap_lstnr->buf.len = strnlen (ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE);
+  len = srv_build_ondemand_response_headers (
+    ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE - 1, status,
+    srv_content_type (ap_path), 416 == status ? 0 : last - first + 1,
+    200 == status ? NULL : range_buffer, modified_buffer,
+    srv_requests_left (ap_lstnr));
+  if (len <= 0 || len >= ICE_LISTENER_BUF_SIZE - 1)
+    {
+      close (a_fd);
+      return 500;
+    }
 
-  /* Ignore send error */
-  (void) send (ap_lstnr->p_con->sockfd, ap_lstnr->buf.p_data, ap_lstnr->buf.len, 0);
-  ap_lstnr->buf.len = 0;
+  if (a_head || 416 == status || last < first)
+    {
+      close (a_fd);
+    }
+  else
+    {
+      ap_lstnr->file_fd = a_fd;
+      ap_lstnr->file_offset = first;
+      ap_lstnr->file_end = last + 1;
+    }
+
+  ap_lstnr->buf.len = len;
+  ap_lstnr->buf.offset = 0;
+  ap_lstnr->oneshot = true;
+  return status;
 }
 
-static ssize_t
-srv_build_http_positive_response (httpr_server_t * ap_server, char * ap_buf,
-                                  size_t len, OMX_U32 a_bitrate,
-                                  OMX_U32 a_num_channels, OMX_U32 a_sample_rate,
-                                  bool a_want_metadata)
+static inline double
+srv_monotonic_time (void)
 {
-  const char * http_version = "1.0";
-  char status_buffer[80];
-  char contenttype_buffer[80];
-  char icybr_buffer[80];
-  char icyname_buffer[OMX_MAX_STRINGNAME_SIZE * 2];
-  char icydescription_buffer[OMX_MAX_STRINGNAME_SIZE * 2];
-  char icygenre_buffer[OMX_MAX_STRINGNAME_SIZE * 2];
-  char icyurl_buffer[OMX_MAX_STRINGNAME_SIZE * 2];
-  char icypub_buffer[80];
-  char iceaudioinfo_buffer[80];
-  char icymetaint_buffer[80];
-  ssize_t ret;
-  const char * statusmsg = "OK";
-  const char * contenttype = "audio/mpeg";
-  int status = 200;
-  int pub = 0;
-  bool metadata_needed = false;
+  struct timespec ts;
+  (void) clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* What a listener costs: its state, its buffer, and the unsent data the
+   kernel may queue for it, which TCP_NOTSENT_LOWAT bounds */
+static inline size_t
+srv_listener_footprint (void)
+{
+  return sizeof (httpr_listener_t) + sizeof (httpr_connection_t)
+         + ICE_LISTENER_BUF_SIZE + ICE_NOTSENT_LOWAT;
+}
+
+/* An estimate of the memory held by the server: the rings, the HLS
+   segments, and the listeners */
+static size_t
+srv_memory_in_use (const httpr_server_t * ap_server)
+{
+  size_t total = 0;
+  OMX_U32 i = 0;
+  OMX_U32 j = 0;
 
   assert (ap_server);
-  assert (ap_buf);
 
-  /* HTTP status line */
-  snprintf (status_buffer, sizeof (status_buffer), "HTTP/%s %d %s\r\n",
-            http_version, status, statusmsg);
+  for (i = 0; i < ap_server->nmounts; ++i)
+    {
+      const httpr_mount_t * p_mount = &(ap_server->p_mounts[i]);
+      total += (size_t) p_mount->ring.nchunks
+               * (p_mount->ring.chunk_size + sizeof (httpr_chunk_t));
+      total += p_mount->hls.build_cap;
+      for (j = 0; p_mount->hls.pp_segments && j < ap_server->hls_nsegments;
+           ++j)
+        {
+          const httpr_hls_segment_t * p_segment = p_mount->hls.pp_segments[j];
+          total += p_segment ? sizeof (*p_segment) + p_segment->len : 0;
+        }
+    }
+  return total + srv_get_listeners_count (ap_server) * srv_listener_footprint ();
+}
 
-  /* HTTP Content-Type header */
-  snprintf (contenttype_buffer, sizeof (contenttype_buffer),
-            "Content-Type: %s\r\n", contenttype);
+static void
+srv_strbuf_printf (httpr_strbuf_t * ap_sb, const char * ap_fmt, ...)
+{
+  va_list ap;
+  int n = 0;
 
-  /* icy-br header */
-  snprintf (icybr_buffer, sizeof (icybr_buffer), "icy-br:%d\r\n",
-            (int) a_bitrate / 1000);
+  assert (ap_sb);
+  assert (ap_fmt);
 
-  /* ice-audio-info header */
-  snprintf (iceaudioinfo_buffer, sizeof (iceaudioinfo_buffer),
-            "ice-audio-info: "
-            "bitrate=%d;channels=%d;samplerate=%d\r\n",
-            (int) a_bitrate, (int) a_num_channels, (int) a_sample_rate);
+  while (!ap_sb->failed)
+    {
+      va_start (ap, ap_fmt);
+      n = vsnprintf (ap_sb->p_data + ap_sb->len, ap_sb->cap - ap_sb->len,
+                     ap_fmt, ap);
+      va_end (ap);
+      if (n < 0)
+        {
+          ap_sb->failed = true;
+        }
+      else if ((size_t) n < ap_sb->cap - ap_sb->len)
+        {
+          ap_sb->len += n;
+          break;
+        }
+      else
+        {
+          const size_t cap = MAX (ap_sb->cap * 2, ap_sb->len + n + 1);
+          char * p_data = (char *) tiz_mem_realloc (ap_sb->p_data, cap);
+          if (p_data)
+            {
+              ap_sb->p_data = p_data;
+              ap_sb->cap = cap;
+            }
+          else
+            {
+              ap_sb->failed = true;
+            }
+        }
+    }
+}
+
+/* Appends a quoted JSON string */
+static void
+srv_strbuf_json_string (httpr_strbuf_t * ap_sb, const char * ap_str)
+{
+  char escaped[OMX_MAX_STRINGNAME_SIZE * 6 + 1];
+  size_t len = 0;
+
+  assert (ap_sb);
+  assert (ap_str);
+
+  for (; *ap_str && len < sizeof (escaped) - 7; ++ap_str)
+    {
+      const unsigned char c = (unsigned char) *ap_str;
+      if ('"' == c || '\\' == c)
+        {
+          escaped[len++] = '\\';
+          escaped[len++] = c;
+        }
+      else if (c < 0x20)
+        {
+          len += snprintf (escaped + len, sizeof (escaped) - len, "\\u%04x", c);
+        }
+      else
+        {
+          escaped[len++] = c;
+        }
+    }
+  escaped[len] = '\0';
+  srv_strbuf_printf (ap_sb, "\"%s\"", escaped);
+}
 
-  /* icy-name header */
-  snprintf (icyname_buffer, sizeof (icyname_buffer), "icy-name:%s\r\n",
-            ap_server->mountpoint.station_name);
+static const char *
+srv_encoding_name (const OMX_AUDIO_CODINGTYPE a_encoding)
+{
+  return OMX_AUDIO_CodingMP3 == a_encoding
+           ? "mp3"
+           : (OMX_AUDIO_CodingOPUS == a_encoding ? "opus" : "other");
+}
 
-  /* icy-decription header */
-  snprintf (icydescription_buffer, sizeof (icydescription_buffer),
-            "icy-description:%s\r\n",
-            ap_server->mountpoint.station_description);
+static const char *
+srv_listener_state (const httpr_listener_t * ap_lstnr)
+{
+  assert (ap_lstnr);
+  return ap_lstnr->need_response
+           ? "idle"
+           : (ap_lstnr->oneshot ? "on-demand"
+                                : (ap_lstnr->attached ? "streaming" : "none"));
+}
 
-  /* icy-genre header */
-  snprintf (icygenre_buffer, sizeof (icygenre_buffer), "icy-genre:%s\r\n",
-            ap_server->mountpoint.station_genre);
+/* The server's counters, its mount points, and its listeners, as JSON */
+static void
+srv_build_status_report (const httpr_server_t * ap_server,
+                         httpr_strbuf_t * ap_sb)
+{
+  const time_t now = time (NULL);
+  const int nlstnrs = srv_get_listeners_count (ap_server);
+  const httpr_stats_t * p_stats = NULL;
+  uint64_t bytes_sent = 0;
+  OMX_U32 i = 0;
+  int j = 0;
 
-  /* icy-url header */
-  snprintf (icyurl_buffer, sizeof (icyurl_buffer), "icy-url:%s\r\n",
-            ap_server->mountpoint.station_url);
+  assert (ap_server);
+  assert (ap_sb);
+  p_stats = &(ap_server->stats);
 
-  /* icy-pub header */
-  snprintf (icypub_buffer, sizeof (icypub_buffer), "icy-pub:%u\r\n", pub);
+  bytes_sent = p_stats->bytes_sent;
+  for (j = 0; j < nlstnrs; ++j)
+    {
+      bytes_sent += srv_get_listener_at (ap_server, j)->p_con->sent_total;
+    }
 
-  if (ap_server->mountpoint.metadata_period > 0 && a_want_metadata)
+  srv_strbuf_printf (
+    ap_sb,
+    "{\n"
+    "  \"uptime\": %.0f,\n"
+    "  \"listeners\": %d,\n"
+    "  \"max_clients\": %u,\n"
+    "  \"memory\": { \"in_use\": %llu, \"cap\": %llu },\n"
+    "  \"limits\": { \"max_lag_ms\": %u, \"max_lag_bytes\": %u, "
+    "\"max_accepts_per_sec\": %u, \"slow_listener_policy\": \"%s\" },\n"
+    "  \"totals\": { \"accepted\": %llu, \"rejected_clients\": %llu, "
+    "\"rejected_rate\": %llu, \"rejected_memory\": %llu, \"skipped\": %llu, "
+    "\"dropped\": %llu, \"failed\": %llu, \"bytes_sent\": %llu },\n"
+    "  \"mounts\": [",
+    difftime (now, p_stats->start_time), nlstnrs,
+    (unsigned int) ap_server->max_clients,
+    (unsigned long long) srv_memory_in_use (ap_server),
+    (unsigned long long) ap_server->max_memory,
+    (unsigned int) ap_server->max_lag_ms,
+    (unsigned int) ap_server->max_lag_bytes,
+    (unsigned int) ap_server->max_accepts_per_sec,
+    EHttprSrvSlowPolicyDrop == ap_server->slow_policy ? "drop" : "skip",
+    (unsigned long long) p_stats->accepted,
+    (unsigned long long) p_stats->rejected_clients,
+    (unsigned long long) p_stats->rejected_rate,
+    (unsigned long long) p_stats->rejected_memory,
+    (unsigned long long) p_stats->skipped,
+    (unsigned long long) p_stats->dropped,
+    (unsigned long long) p_stats->failed, (unsigned long long) bytes_sent);
+
+  for (i = 0; i < ap_server->nmounts; ++i)
     {
-      metadata_needed = true;
-      /* icy-metaint header */
-      snprintf (icymetaint_buffer, sizeof (icymetaint_buffer),
-                "icy-metaint:%lu\r\n", ap_server->mountpoint.metadata_period);
+      const httpr_mount_t * p_mount = &(ap_server->p_mounts[i]);
+      srv_strbuf_printf (ap_sb, "%s\n    { \"mount\": ", i > 0 ? "," : "");
+      srv_strbuf_json_string (ap_sb, (const char *) p_mount->mount_name);
+      srv_strbuf_printf (
+        ap_sb,
+        ", \"encoding\": \"%s\", \"bitrate\": %u, \"listeners\": %u, "
+        "\"bytes_in\": %llu, \"hls_segments\": %llu }",
+        srv_encoding_name (p_mount->encoding),
+        (unsigned int) p_mount->bitrate,
+        (unsigned int) p_mount->ring.nreaders,
+        (unsigned long long) p_mount->ring.head_pos,
+        (unsigned long long) p_mount->hls.next_seq);
     }
 
-  ret = snprintf (
-    ap_buf, len, "%s%s%s%s%s%s%s%s%s%s%s%s\r\n", status_buffer,
-    contenttype_buffer, icybr_buffer, iceaudioinfo_buffer, icyname_buffer,
-    icydescription_buffer, icygenre_buffer, icyurl_buffer, icypub_buffer,
-    (metadata_needed ? icymetaint_buffer : ""),
-    "Server: Tizonia HTTP Renderer 0.1.0\r\n", "Cache-Control: no-cache\r\n");
+  srv_strbuf_printf (ap_sb, "\n  ],\n  \"clients\": [");
+  for (j = 0; j < nlstnrs && j < ICE_STATUS_MAX_LISTENERS; ++j)
+    {
+      const httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, j);
+      const httpr_connection_t * p_con = p_lstnr->p_con;
+      const uint64_t lag
+        = p_lstnr->attached
+            ? p_lstnr->p_mount->ring.head_pos
+                - srv_ring_pos (&(p_lstnr->p_mount->ring), p_lstnr)
+            : 0;
+      srv_strbuf_printf (ap_sb, "%s\n    { \"address\": ", j > 0 ? "," : "");
+      srv_strbuf_json_string (ap_sb, p_con->p_ip);
+      srv_strbuf_printf (ap_sb, ", \"port\": %u, \"mount\": ",
+                         (unsigned int) p_con->port);
+      if (p_lstnr->p_mount)
+        {
+          srv_strbuf_json_string (ap_sb,
+                                  (const char *) p_lstnr->p_mount->mount_name);
+        }
+      else
+        {
+          srv_strbuf_printf (ap_sb, "null");
+        }
+      srv_strbuf_printf (
+        ap_sb,
+        ", \"state\": \"%s\", \"connected\": %.0f, \"bytes_sent\": %llu, "
+        "\"lag\": %llu, \"skips\": %u, \"metaint\": %u, \"requests\": %u }",
+        srv_listener_state (p_lstnr), difftime (now, p_con->con_time),
+        (unsigned long long) p_con->sent_total, (unsigned long long) lag,
+        (unsigned int) p_lstnr->skips, (unsigned int) p_lstnr->metaint,
+        (unsigned int) p_lstnr->nrequests);
+    }
+  srv_strbuf_printf (ap_sb, "\n  ]\n}\n");
+}
 
-  return ret;
+static bool
+srv_is_status_request (const httpr_server_t * ap_server, const char * ap_url)
+{
+  assert (ap_server);
+  assert (ap_url);
+  return ap_server->p_status_path
+         && strcspn (ap_url, "?") == strlen (ap_server->p_status_path)
+         && 0 == strncmp (ap_url, ap_server->p_status_path,
+                          strlen (ap_server->p_status_path));
 }
 
+/* Prepares the status report. It may not fit in the listener's buffer, so
+   the buffer is replaced with a large enough one. Returns the HTTP
+   status. */
 static int
-srv_send_http_response (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+srv_prepare_status_response (httpr_server_t * ap_server,
+                             httpr_listener_t * ap_lstnr, const bool a_head)
 {
-  ssize_t sent_bytes = 0;
+  httpr_strbuf_t body;
+  ssize_t head_len = 0;
+  size_t len = 0;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (ap_lstnr->buf.p_data);
-  assert (ap_lstnr->p_con);
 
-  ap_lstnr->buf.len = strnlen (ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE);
+  body.cap = ICE_LISTENER_BUF_SIZE;
+  body.len = 0;
+  body.failed = (NULL == (body.p_data = (char *) tiz_mem_alloc (body.cap)));
+  srv_build_status_report (ap_server, &body);
 
-  sent_bytes = send (ap_lstnr->p_con->sockfd, ap_lstnr->buf.p_data,
-                     ap_lstnr->buf.len, MSG_NOSIGNAL);
-  ap_lstnr->buf.len = 0;
-  return sent_bytes;
+  head_len = srv_build_ondemand_response_headers (
+    ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE - 1, 200, "application/json",
+    body.len, NULL, "Cache-Control: no-cache\r\n",
+    srv_requests_left (ap_lstnr));
+  if (body.failed || head_len <= 0 || head_len >= ICE_LISTENER_BUF_SIZE - 1)
+    {
+      tiz_mem_free (body.p_data);
+      return 500;
+    }
+
+  len = head_len;
+  if (!a_head)
+    {
+      char * p_data = (char *) tiz_mem_alloc (
+        MAX (head_len + body.len + 1, ICE_LISTENER_BUF_SIZE));
+      if (!p_data)
+        {
+          tiz_mem_free (body.p_data);
+          return 500;
+        }
+      memcpy (p_data, ap_lstnr->buf.p_data, head_len);
+      memcpy (p_data + head_len, body.p_data, body.len);
+      tiz_mem_free (ap_lstnr->buf.p_data);
+      ap_lstnr->buf.p_data = p_data;
+      len += body.len;
+    }
+  tiz_mem_free (body.p_data);
+
+  ap_lstnr->buf.len = len;
+  ap_lstnr->buf.offset = 0;
+  ap_lstnr->oneshot = true;
+  return 200;
 }
 
 static OMX_ERRORTYPE
@@ -921,6 +3155,14 @@ srv_handle_listeners_request (httpr_server_t * ap_server,
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   int to_write = -1;
   const char * parsed_string = NULL;
+  bool hls_playlist = false;
+  uint64_t hls_seq = 0;
+  int status = 0;
+  bool head = false;
+  const char * p_range = NULL;
+  char path[PATH_MAX];
+  struct stat st;
+  int fd = -1;
 
   assert (ap_server);
   assert (ap_lstnr);
@@ -928,6 +3170,7 @@ srv_handle_listeners_request (httpr_server_t * ap_server,
   assert (ap_lstnr->p_parser);
 
   some_error = (srv_get_listeners_count (ap_server) > ap_server->max_clients);
+  ap_server->stats.rejected_clients += some_error ? 1 : 0;
   bail_on_request_error (some_error, 400, "Client limit reached");
 
   /*   some_error */
@@ -936,13 +3179,15 @@ srv_handle_listeners_request (httpr_server_t * ap_server,
   /*   bail_on_request_error (some_error, -1, "Connection timed out"); */
 
   some_error = ((nread = srv_read_from_listener (ap_lstnr)) <= 0);
-  rc
-    = (some_error
-         ? (srv_is_recoverable_error (ap_server, ap_lstnr->p_con->sockfd, errno)
-              ? OMX_ErrorNotReady
-              : OMX_ErrorNone)
-         : OMX_ErrorNone);
-  bail_on_request_error (some_error, -1, strerror (errno));
+  rc = (some_error && nread < 0
+          && srv_is_recoverable_error (ap_server, ap_lstnr->p_con->sockfd,
+                                       errno)
+          ? OMX_ErrorNotReady
+          : OMX_ErrorNone);
+  bail_on_request_error (some_error, -1,
+                         (0 == nread ? "Connection closed by the client"
+                                     : strerror (errno)));
+  ap_lstnr->nrequests++;
 
   nparsed
     = tiz_http_parser_parse (ap_lstnr->p_parser, ap_lstnr->buf.p_data, nread);
@@ -951,35 +3196,98 @@ srv_handle_listeners_request (httpr_server_t * ap_server,
 
   some_error
     = (NULL == (parsed_string = tiz_http_parser_get_method (ap_lstnr->p_parser))
-       || (0 != strncmp ("GET", parsed_string, strlen ("GET"))));
+       || (0 != strcmp ("GET", parsed_string)
+           && 0 != strcmp ("HEAD", parsed_string)));
   bail_on_request_error (some_error, 405, "Method not allowed");
+  head = (0 == strcmp ("HEAD", parsed_string));
+
+  /* Only on-demand responses may keep the connection open */
+  ap_lstnr->keepalive
+    = (tiz_http_parser_should_keep_alive (ap_lstnr->p_parser)
+       && ap_lstnr->nrequests < ICE_KEEPALIVE_MAX_REQUESTS);
+  p_range = tiz_http_parser_get_header (ap_lstnr->p_parser, "Range");
 
   some_error
     = (NULL == (parsed_string = tiz_http_parser_get_url (ap_lstnr->p_parser))
        || (0 != strncmp ("/", parsed_string, strlen ("/"))));
   bail_on_request_error (some_error, 401, "Unathorized");
 
+  if (srv_is_status_request (ap_server, parsed_string))
+    {
+      status = srv_prepare_status_response (ap_server, ap_lstnr, head);
+      some_error = (200 != status);
+      bail_on_request_error (some_error, status, "Internal Server Error");
+      ap_lstnr->need_response = false;
+      goto end;
+    }
+
+  if ((ap_lstnr->p_mount = srv_find_hls_mount (ap_server, parsed_string,
+                                                &hls_playlist, &hls_seq)))
+    {
+      status = srv_prepare_hls_response (ap_server, ap_lstnr, hls_playlist,
+                                         hls_seq, head, p_range);
+      some_error = (200 != status && 206 != status && 416 != status);
+      bail_on_request_error (some_error, status,
+                             (hls_playlist ? "Playlist not available"
+                                           : "Segment not found"));
+      ap_lstnr->need_response = false;
+      goto end;
+    }
+
+  if ((fd = httpr_doc_open (ap_server->p_docroot, parsed_string, &st, path,
+                               sizeof (path)))
+      >= 0)
+    {
+      status = srv_prepare_file_response (ap_server, ap_lstnr, fd, &st, path,
+                                          head, p_range);
+      some_error = (500 == status);
+      bail_on_request_error (some_error, status, "Internal Server Error");
+      TIZ_TRACE (handleOf (ap_server->p_parent), "[%s] : [%d]", path, status);
+      ap_lstnr->need_response = false;
+      goto end;
+    }
+
+  some_error
+    = (NULL == (ap_lstnr->p_mount = srv_find_mount (ap_server, parsed_string)));
+  bail_on_request_error (some_error, 404, "Mount point not found");
+
   if ((parsed_string
-       = tiz_http_parser_get_header (ap_lstnr->p_parser, "Icy-MetaData"))
-      && (0 == strncmp ("1", parsed_string, strlen ("1"))))
+       = tiz_http_parser_get_header (ap_lstnr->p_parser, "Icy-MetaData")))
     {
-      TIZ_TRACE (handleOf (ap_server->p_parent), "ICY metadata requested");
-      ap_lstnr->want_metadata = true;
+      ap_lstnr->metaint
+        = srv_negotiate_metaint (ap_lstnr->p_mount, parsed_string);
+      TIZ_TRACE (handleOf (ap_server->p_parent),
+                 "ICY metadata requested [%s] - metaint [%u]", parsed_string,
+                 (unsigned int) ap_lstnr->metaint);
     }
 
   /* The request seems ok. Now build the response */
   some_error
     = (0 == (to_write = srv_build_http_positive_response (
-               ap_server, ap_lstnr->buf.p_data, ICE_LISTENER_BUF_SIZE - 1,
-               ap_server->bitrate, ap_server->num_channels,
-               ap_server->sample_rate, ap_lstnr->want_metadata)));
+               ap_lstnr->p_mount, ap_lstnr->buf.p_data,
+               ICE_LISTENER_BUF_SIZE - 1, ap_lstnr->metaint)));
   bail_on_request_error (some_error, 500, "Internal Server Error");
 
+  /* The live stream has no end; the connection closes with it */
+  ap_lstnr->keepalive = false;
+  if (head)
+    {
+      ap_lstnr->buf.len = to_write;
+      ap_lstnr->buf.offset = 0;
+      ap_lstnr->oneshot = true;
+      ap_lstnr->need_response = false;
+      some_error = false;
+      goto end;
+    }
+
   some_error = (0 == srv_send_http_response (ap_server, ap_lstnr));
   bail_on_request_error (some_error, 500, "Internal Server Error");
 
   some_error = false;
   ap_lstnr->need_response = false;
+  ap_lstnr->metaint_left = ap_lstnr->metaint;
+  srv_ring_attach (ap_lstnr);
+  rc = srv_start_pacing (ap_server, ap_lstnr->p_mount);
 
 end:
   if (some_error && OMX_ErrorNone == rc)
@@ -990,43 +3298,6 @@ end:
   return rc;
 }
 
-static OMX_S32
-srv_remove_existing_listener (OMX_PTR ap_key, OMX_PTR ap_value, OMX_PTR ap_arg)
-{
-  httpr_server_t * p_server = ap_arg;
-  httpr_listener_t * p_lstnr = NULL;
-
-  assert (p_server);
-  assert (ap_key);
-  assert (ap_value);
-
-  p_lstnr = (httpr_listener_t *) ap_value;
-
-  srv_remove_listener (p_server, p_lstnr);
-
-  return 0;
-}
-
-inline static void
-srv_release_empty_buffer (httpr_server_t * ap_server,
-                          httpr_listener_t * ap_lstnr,
-                          OMX_BUFFERHEADERTYPE ** app_hdr)
-{
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-
-  assert (ap_server);
-  assert (ap_lstnr);
-  assert (app_hdr);
-
-  p_hdr = *app_hdr;
-
-  ap_lstnr->pos = 0;
-  p_hdr->nFilledLen = 0;
-  ap_server->pf_release_buf (p_hdr, ap_server->p_arg);
-  *app_hdr = NULL;
-  ap_server->p_hdr = NULL;
-}
-
 static bool
 srv_is_listener_ready (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
 {
@@ -1044,8 +3315,8 @@ srv_is_listener_ready (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
         {
           if (OMX_ErrorNotReady == rc)
             {
-              TIZ_ERROR (p_hdl, "no data yet lets wait some time ");
-              (void) srv_start_listener_io_watcher (ap_lstnr);
+              TIZ_TRACE (p_hdl, "no request yet; waiting");
+              (void) srv_wait_for_request (ap_lstnr);
             }
           else
             {
@@ -1061,198 +3332,33 @@ srv_is_listener_ready (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
   return lstnr_ready;
 }
 
-static inline bool
-srv_is_time_to_send_metadata (httpr_server_t * ap_server,
-                              httpr_listener_t * ap_lstnr)
-{
-  if (ap_lstnr->p_con->sent_total == 0)
-    {
-      return false;
-    }
-
-  if (((ap_lstnr->p_con->sent_total + ap_server->burst_size)
-       % ap_server->mountpoint.metadata_period)
-      <= ap_server->burst_size)
-    {
-      return true;
-    }
-
-  return false;
-}
-
-static inline size_t
-srv_get_metadata_offset (const httpr_server_t * ap_server,
-                         const httpr_listener_t * ap_lstnr)
-{
-  size_t offset = 0;
-  if (ap_lstnr->p_con->sent_total != 0)
-    {
-      offset = (ap_server->mountpoint.metadata_period
-                * ((ap_lstnr->p_con->sent_total + ap_server->burst_size)
-                   / ap_server->mountpoint.metadata_period))
-               - ap_lstnr->p_con->sent_total;
-    }
-
-  return offset;
-}
-
-static inline size_t
-srv_get_metadata_length (const httpr_server_t * ap_server,
-                         const httpr_listener_t * ap_lstnr)
-{
-  if (ap_lstnr->p_con->sent_total == 0 || ap_lstnr->p_con->metadata_delivered)
-    {
-      return 0;
-    }
-
-  return strnlen ((char *) ap_server->mountpoint.stream_title,
-                  OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
-}
-
-static void
-srv_arrange_metadata (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                      OMX_U8 ** app_buffer, size_t * ap_len)
-{
-  size_t len = 0;
-  httpr_listener_buffer_t * p_lstnr_buf = NULL;
-
-  assert (ap_server);
-  assert (ap_lstnr);
-  assert (app_buffer);
-  assert (ap_len);
-
-  len = *ap_len;
-  p_lstnr_buf = &ap_lstnr->buf;
-
-  if (0 == len || !ap_lstnr->want_metadata
-      || 0 == ap_server->mountpoint.metadata_period
-      || !srv_is_time_to_send_metadata (ap_server, ap_lstnr))
-    {
-      /* p_lstnr_buf->metadata_bytes = 0; */
-      return;
-    }
-
-  {
-    OMX_U8 * p_buffer = *app_buffer;
-    size_t metadata_offset = srv_get_metadata_offset (ap_server, ap_lstnr);
-
-    if (metadata_offset < len && 0 == p_lstnr_buf->metadata_bytes)
-      {
-        OMX_U8 * p_dest = NULL;
-        OMX_U8 * p_src = NULL;
-        size_t metadata_len = srv_get_metadata_length (ap_server, ap_lstnr);
-        size_t metadata_total = 0;
-        size_t metadata_byte = 0;
-
-        if (metadata_len > 0)
-          {
-            metadata_byte = metadata_len / 16;
-            if (metadata_len % 16)
-              {
-                metadata_byte++;
-              }
-          }
-        else
-          {
-            metadata_byte = 0;
-          }
-
-        metadata_total = (metadata_byte * 16) + 1;
-        p_dest = p_buffer + metadata_offset + metadata_total;
-        p_src = p_buffer + metadata_offset;
-
-        /* Move content to make space for the metadata */
-        memmove (p_dest, p_src, len - metadata_offset);
-
-        p_lstnr_buf->metadata_bytes += metadata_total;
-        p_lstnr_buf->metadata_offset += metadata_offset;
-
-        if (metadata_len)
-          {
-            snprintf ((char *) p_src, metadata_total, "%c%s",
-                      (int) metadata_byte,
-                      (char *) ap_server->mountpoint.stream_title);
-            ap_lstnr->p_con->metadata_delivered = true;
-          }
-        else
-          {
-            p_src[0] = metadata_byte;
-          }
-
-        len += metadata_total;
-        p_lstnr_buf->len = len;
-
-        *ap_len = len;
-        *app_buffer = p_buffer;
-      }
-  }
-}
-
-static void
-srv_arrange_data (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                  OMX_U8 ** app_buffer, size_t * ap_len)
-{
-  OMX_U8 * p_buffer = NULL;
-  size_t len = 0;
-  httpr_listener_buffer_t * p_lstnr_buf = NULL;
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-
-  assert (ap_server);
-  assert (ap_lstnr);
-  assert (app_buffer);
-  assert (ap_len);
-
-  p_lstnr_buf = &ap_lstnr->buf;
-  p_hdr = ap_server->p_hdr;
-
-  if (p_hdr && p_hdr->pBuffer && p_hdr->nFilledLen > 0)
-    {
-      int to_copy = 0;
-      if (ap_server->burst_size > p_lstnr_buf->len)
-        {
-          to_copy = ap_server->burst_size - p_lstnr_buf->len;
-        }
-      if (to_copy > p_hdr->nFilledLen)
-        {
-          to_copy = p_hdr->nFilledLen;
-        }
-      memcpy (p_lstnr_buf->p_data + p_lstnr_buf->len,
-              p_hdr->pBuffer + p_hdr->nOffset, to_copy);
-      p_lstnr_buf->len += to_copy;
-      p_hdr->nFilledLen -= to_copy;
-      p_hdr->nOffset += to_copy;
-    }
-
-  p_buffer = (OMX_U8 *) p_lstnr_buf->p_data;
-  len = p_lstnr_buf->len;
-
-  srv_arrange_metadata (ap_server, ap_lstnr, &p_buffer, &len);
-
-  *ap_len = len;
-  *app_buffer = p_buffer;
-}
-
 static OMX_ERRORTYPE
 srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
-                       const void * ap_buffer, const size_t a_buf_len,
-                       int * a_bytes_written)
+                       struct iovec * ap_iov, const int a_iovcnt,
+                       const int a_flags, ssize_t * a_bytes_written)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  int bytes = 0;
+  ssize_t bytes = 0;
   httpr_connection_t * p_con = NULL;
   int sock = ICE_SOCK_ERROR;
+  struct msghdr msg;
 
   assert (ap_server);
   assert (ap_lstnr);
-  assert (ap_buffer);
+  assert (ap_iov);
+  assert (a_iovcnt > 0);
   assert (a_bytes_written);
 
   p_con = ap_lstnr->p_con;
   sock = p_con->sockfd;
   *a_bytes_written = 0;
-  errno = 0;
 
-  bytes = send (sock, (const void *) ap_buffer, a_buf_len, MSG_NOSIGNAL);
+  tiz_mem_set (&msg, 0, sizeof (msg));
+  msg.msg_iov = ap_iov;
+  msg.msg_iovlen = a_iovcnt;
+
+  errno = 0;
+  bytes = sendmsg (sock, &msg, MSG_NOSIGNAL | a_flags);
 
   if (bytes < 0)
     {
@@ -1262,6 +3368,7 @@ srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
             "Non-recoverable error while writing to the socket (will destroy "
             "listener)\n");
           /* Mark the listener as failed, so that it will get removed */
+          ap_server->stats.failed++;
           rc = OMX_ErrorNoMore;
         }
       else
@@ -1269,8 +3376,7 @@ srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
           TIZ_PRINTF_DBG_RED (
             "Recoverable error while writing to the socket"
             "(re-starting io watcher)\n");
-          (void) srv_start_listener_io_watcher (ap_lstnr);
-          srv_stop_listener_timer_watcher (ap_lstnr);
+          srv_block_listener (ap_lstnr);
           rc = OMX_ErrorNotReady;
         }
     }
@@ -1281,127 +3387,249 @@ srv_write_to_listener (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
   return rc;
 }
 
+/* Sends, with a single system call, the listener's pending ICY metadata
+   block, followed by up to 'a_budget' bytes of the ring, with the metadata
+   block that is due in between. The iovecs point straight into the ring
+   chunks and the shared metadata blocks. */
 static OMX_ERRORTYPE
-srv_write_omx_buffer (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+srv_write_omx_buffer (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr,
+                      const size_t a_budget)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   httpr_connection_t * p_con = NULL;
-  int sock = ICE_SOCK_ERROR;
+  httpr_ring_t * p_ring = NULL;
+  httpr_icy_block_t * p_next = NULL;
+  struct iovec iov[ICE_MAX_IOVECS];
+  bool is_audio[ICE_MAX_IOVECS];
+  bool metadata_on = false;
+  bool metadata_in_send = false;
+  uint64_t seq = 0;
+  uint64_t last_seq = 0;
+  OMX_U32 offset = 0;
+  OMX_U32 metaint_left = 0;
+  uint32_t meta_gen = 0;
+  size_t budget = 0;
+  size_t total = 0;
+  size_t left = 0;
+  int niov = 0;
+  int flags = 0;
+  ssize_t bytes = 0;
+  int audio_sent = 0;
+  int i = 0;
 
   assert (ap_server);
   assert (ap_lstnr);
   assert (ap_lstnr->p_con);
 
-  p_con = ap_lstnr->p_con;
-  sock = p_con->sockfd;
+  assert (ap_lstnr->p_mount);
 
+  p_con = ap_lstnr->p_con;
+  p_ring = &(ap_lstnr->p_mount->ring);
   p_con->sent_last = 0;
 
-  if (!srv_is_valid_socket (sock))
+  if (!srv_is_valid_socket (p_con->sockfd))
     {
       TIZ_WARN (handleOf (ap_server->p_parent),
                 "Will destroy listener "
                 "(Invalid listener socket fd [%d])",
-                sock);
+                p_con->sockfd);
       /* The socket is not valid anymore. The listener will be removed. */
-      rc = OMX_ErrorNoMore;
+      return OMX_ErrorNoMore;
     }
-  else
-    {
-      httpr_listener_buffer_t * p_lstnr_buf = &ap_lstnr->buf;
-      OMX_U8 * p_buffer = NULL;
-      size_t len = 0;
-      int bytes = 0;
 
-      /* Obtain a pointer to the data and the amount of data to be written */
-      srv_arrange_data (ap_server, ap_lstnr, &p_buffer, &len);
-
-      if (len > 0)
-        {
-          int metadata_sent = 0;
-          tiz_check_omx (
-            srv_write_to_listener (ap_server, ap_lstnr, p_buffer, len, &bytes));
-          assert (bytes >= 0);
+  metadata_on = (ap_lstnr->metaint > 0);
+  budget = a_budget;
 
-          p_lstnr_buf->len
-            = bytes > p_lstnr_buf->len ? 0 : (p_lstnr_buf->len - bytes);
+  if (ap_lstnr->p_meta)
+    {
+      iov[niov].iov_base = (char *) ap_lstnr->p_meta + ap_lstnr->meta_offset;
+      iov[niov].iov_len = ap_lstnr->meta_len - ap_lstnr->meta_offset;
+      is_audio[niov++] = false;
+      metadata_in_send = true;
+    }
 
-          if (p_lstnr_buf->len > 0)
+  seq = ap_lstnr->chunk;
+  last_seq = seq;
+  offset = ap_lstnr->offset;
+  metaint_left = ap_lstnr->metaint_left;
+  meta_gen = ap_lstnr->p_meta_block ? ap_lstnr->p_meta_block->gen
+                                    : ap_lstnr->meta_gen;
+  while (niov < ICE_MAX_IOVECS && budget > 0 && seq < p_ring->head)
+    {
+      httpr_chunk_t * p_chunk = srv_ring_chunk (p_ring, seq);
+      size_t chunk_len = MIN (p_chunk->len - offset, budget);
+      if (metadata_on)
+        {
+          chunk_len = MIN (chunk_len, metaint_left);
+        }
+      iov[niov].iov_base = p_chunk->p_data + offset;
+      iov[niov].iov_len = chunk_len;
+      is_audio[niov++] = true;
+      last_seq = seq;
+      budget -= chunk_len;
+      offset += chunk_len;
+      if (offset == p_chunk->len)
+        {
+          seq++;
+          offset = 0;
+        }
+      if (metadata_on && 0 == (metaint_left -= chunk_len))
+        {
+          if (niov == ICE_MAX_IOVECS)
             {
-              memmove (p_lstnr_buf->p_data, p_lstnr_buf->p_data + bytes,
-                       p_lstnr_buf->len);
+              break;
             }
+          /* The block is only referenced once it is actually due */
+          p_next = srv_icy_next (ap_lstnr->p_mount, meta_gen);
+          meta_gen = p_next ? p_next->gen : meta_gen;
+          iov[niov].iov_base
+            = p_next ? p_next->data : (char *) g_icy_empty_block;
+          iov[niov].iov_len
+            = p_next ? p_next->len : sizeof (g_icy_empty_block);
+          is_audio[niov++] = false;
+          metadata_in_send = true;
+          metaint_left = ap_lstnr->metaint;
+        }
+    }
+  assert (niov > 0);
 
-          if (bytes > p_lstnr_buf->metadata_offset)
-            {
-              metadata_sent = MIN ((bytes - p_lstnr_buf->metadata_offset),
-                                   p_lstnr_buf->metadata_bytes);
-            }
+  for (i = 0; i < niov; ++i)
+    {
+      total += iov[i].iov_len;
+    }
 
-          if (p_con->initial_burst_bytes > 0)
-            {
-              p_con->initial_burst_bytes -= (bytes - metadata_sent);
-            }
-          else
+#ifdef ICE_HAVE_ZEROCOPY
+  /* Only for large, audio-only sends; a metadata block may be released
+     while the kernel is still reading it */
+  srv_zc_reap (ap_lstnr);
+  if (ap_lstnr->zerocopy && total >= ICE_ZEROCOPY_MIN_BYTES
+      && !metadata_in_send
+      && ap_lstnr->zc_head - ap_lstnr->zc_tail < ICE_ZEROCOPY_MAX_INFLIGHT)
+    {
+      flags = MSG_ZEROCOPY;
+    }
+#endif
+
+  tiz_check_omx (
+    srv_write_to_listener (ap_server, ap_lstnr, iov, niov, flags, &bytes));
+  assert (bytes >= 0);
+
+  if (flags && bytes > 0)
+    {
+      srv_zc_pin (ap_lstnr, ap_lstnr->chunk, last_seq);
+    }
+
+  /* Account for what was actually sent */
+  for (i = 0, left = bytes; i < niov; ++i)
+    {
+      size_t taken = MIN (left, iov[i].iov_len);
+      left -= taken;
+      if (is_audio[i])
+        {
+          srv_ring_advance (p_ring, ap_lstnr, taken);
+          audio_sent += taken;
+          if (metadata_on && taken > 0
+              && 0 == (ap_lstnr->metaint_left -= taken))
             {
-              if (p_con->con_time == 0)
-                {
-                  p_con->con_time = time (NULL);
-                }
+              ap_lstnr->metaint_left = ap_lstnr->metaint;
+              srv_icy_arrange (ap_lstnr);
             }
+        }
+      else if (ap_lstnr->p_meta)
+        {
+          srv_icy_advance (ap_lstnr, taken);
+        }
+    }
 
-          p_con->sent_total += (bytes - metadata_sent);
-          p_con->sent_last = (bytes - metadata_sent);
-          p_con->burst_bytes += (bytes - metadata_sent);
+  p_con->sent_total += audio_sent;
+  p_con->sent_last = audio_sent;
 
-          {
-            time_t t = time (NULL);
-            double d = difftime (t, p_con->con_time);
-            uint64_t rate = d ? p_con->sent_total / (uint64_t) d : 0;
-            TIZ_PRINTF_DBG_BLU (
-              "total [%lld] last [%d] burst [%d] time [%f] rate [%lld] "
-              "server burst [%d] bytes [%d]\n",
-              p_con->sent_total, p_con->sent_last, p_con->burst_bytes, d, rate,
-              ap_server->burst_size, bytes);
-          }
+  {
+    time_t t = time (NULL);
+    double d = difftime (t, p_con->con_time);
+    uint64_t rate = d ? p_con->sent_total / (uint64_t) d : 0;
+    TIZ_PRINTF_DBG_BLU (
+      "total [%lld] last [%d] time [%f] rate [%lld] "
+      "budget [%u] bytes [%zd] iovecs [%d]\n",
+      p_con->sent_total, p_con->sent_last, d, rate, (unsigned int) a_budget,
+      bytes, niov);
+  }
+
+  if (bytes < (ssize_t) total)
+    {
+      TIZ_PRINTF_DBG_RED ("NEED TO STOP bytes [%zd] < len [%zu]\n", bytes,
+                          total);
+      srv_block_listener (ap_lstnr);
+      rc = OMX_ErrorNotReady;
+    }
 
-          TIZ_PRINTF_DBG_GRN (
-            "metadata_bytes [%u] < metadata_offset [%u] metadata_sent [%u]\n",
-            p_lstnr_buf->metadata_bytes, p_lstnr_buf->metadata_offset,
-            metadata_sent);
+  return rc;
+}
 
-          p_lstnr_buf->metadata_bytes -= metadata_sent;
-          if (p_lstnr_buf->metadata_offset > 0 && p_lstnr_buf->metadata_bytes)
-            {
-              p_lstnr_buf->metadata_offset -= ((unsigned int) bytes);
-            }
-          else
-            {
-              p_lstnr_buf->metadata_offset = 0;
-            }
+/* Turns a new connection away, with a 503, if it comes in faster than the
+   accept rate allows, or if it would take the server over its memory
+   cap */
+static bool
+srv_admit_connection (httpr_server_t * ap_server, const int a_sockfd,
+                      const char * ap_ip, const unsigned short a_port)
+{
+  const char * p_reason = NULL;
+
+  assert (ap_server);
+  assert (ap_ip);
+
+  if (ap_server->max_accepts_per_sec > 0)
+    {
+      /* A token bucket, one second deep */
+      const double now = srv_monotonic_time ();
+      ap_server->accept_tokens
+        = MIN ((double) ap_server->max_accepts_per_sec,
+               ap_server->accept_tokens
+                 + (now - ap_server->accept_time)
+                     * ap_server->max_accepts_per_sec);
+      ap_server->accept_time = now;
+      if (ap_server->accept_tokens < 1.0)
+        {
+          p_reason = "accept rate";
+          ap_server->stats.rejected_rate++;
+        }
+      else
+        {
+          ap_server->accept_tokens -= 1.0;
+        }
+    }
+
+  if (!p_reason && ap_server->max_memory > 0
+      && srv_memory_in_use (ap_server) + srv_listener_footprint ()
+           > ap_server->max_memory)
+    {
+      p_reason = "memory cap";
+      ap_server->stats.rejected_memory++;
+    }
 
-          if (bytes < len)
-            {
-              TIZ_PRINTF_DBG_RED (
-                "NEED TO STOP bytes [%d] < len [%u] p_lstnr_buf->len [%u]\n",
-                bytes, len, p_lstnr_buf->len);
-              (void) srv_start_listener_io_watcher (ap_lstnr);
-              srv_stop_listener_timer_watcher (ap_lstnr);
-              rc = OMX_ErrorNotReady;
-            }
-          else
-            {
-              if ((p_con->initial_burst_bytes <= 0)
-                  && (p_con->burst_bytes >= ap_server->burst_size))
-                {
-                  rc = srv_start_listener_timer_watcher (ap_lstnr,
-                                                         ap_server->wait_time);
-                }
-            }
+  if (p_reason)
+    {
+      char buf[512];
+      ssize_t len
+        = srv_build_http_negative_response (buf, sizeof (buf), 503, NULL);
+      if (len > 0 && (size_t) len < sizeof (buf))
+        {
+          len += snprintf (buf + len, sizeof (buf) - len,
+                           "Retry-After: 1\r\n"
+                           "Content-Length: 0\r\n"
+                           "Connection: close\r\n\r\n");
+          /* Ignore send error */
+          (void) send (a_sockfd, buf, MIN ((size_t) len, sizeof (buf) - 1),
+                       MSG_NOSIGNAL | MSG_DONTWAIT);
         }
+      TIZ_NOTICE (handleOf (ap_server->p_parent),
+                  "Turning client [%s:%u] away : %s", ap_ip,
+                  (unsigned int) a_port, p_reason);
+      return false;
     }
 
-  return rc;
+  ap_server->stats.accepted++;
+  return true;
 }
 
 static OMX_ERRORTYPE
@@ -1418,14 +3646,6 @@ srv_accept_connection (httpr_server_t * ap_server)
   assert (ap_server);
   p_hdl = handleOf (ap_server->p_parent);
 
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      /* This is a simple solution to prevent more than one connection at
-       * a time. One day this could be a multi-client renderer */
-      tiz_map_for_each (ap_server->p_lstnrs, srv_remove_existing_listener,
-                        ap_server);
-    }
-
   if ((p_ip = (char *) tiz_mem_alloc (ICE_RENDERER_MAX_ADDR_LEN)))
     {
       unsigned short port = 0;
@@ -1436,6 +3656,11 @@ srv_accept_connection (httpr_server_t * ap_server)
       goto_end_on_socket_error (connected_sockfd, p_hdl,
                                 "Unable to accept the connection");
 
+      if (!srv_admit_connection (ap_server, connected_sockfd, p_ip, port))
+        {
+          goto end;
+        }
+
       rc = srv_create_listener (ap_server, &p_lstnr, connected_sockfd, p_ip,
                                 port);
       goto_end_on_omx_error (rc, p_hdl, "Unable to instantiate the listener");
@@ -1449,7 +3674,7 @@ srv_accept_connection (httpr_server_t * ap_server)
       goto_end_on_omx_error (rc, p_hdl,
                              "Unable to add the listener to the map");
 
-      rc = srv_start_listener_io_watcher (p_lstnr);
+      rc = srv_wait_for_request (p_lstnr);
       goto_end_on_omx_error (rc, p_hdl,
                              "Unable to start the listener's io watcher");
 
@@ -1491,15 +3716,9 @@ end:
 
       TIZ_PRINTF_DBG_RED ("Client connected [%s:%u]\n", p_con->p_ip,
                           p_con->port);
-      TIZ_PRINTF_DBG_GRN (
-        "\tburst [%d] sample rate [%u] bitrate [%u] "
-        "burst_size [%u] bytes per frame [%u] wait_time [%f] "
-        "pkts/s [%f].\n",
-        (unsigned int) p_con->initial_burst_bytes,
-        (unsigned int) ap_server->sample_rate,
-        (unsigned int) ap_server->bitrate, (unsigned int) ap_server->burst_size,
-        (unsigned int) ap_server->bytes_per_frame, ap_server->wait_time,
-        ap_server->pkts_per_sec);
+      TIZ_PRINTF_DBG_GRN ("\tmount points [%u] wait_time [%f] pkts/s [%f].\n",
+                          (unsigned int) ap_server->nmounts,
+                          ap_server->wait_time, ap_server->pkts_per_sec);
     }
 
   /* Always restart the server's watcher, even if an error occurred */
@@ -1508,91 +3727,312 @@ end:
   return rc;
 }
 
+/* Sends the listener's file straight from the page cache, up to a budget
+   per event so that one download can't hold up the stream */
 static OMX_ERRORTYPE
-srv_write (httpr_server_t * ap_server)
+srv_send_file (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
-  httpr_listener_t * p_lstnr = NULL;
   httpr_connection_t * p_con = NULL;
+  size_t budget = ICE_SENDFILE_MAX_BYTES;
 
   assert (ap_server);
+  assert (ap_lstnr);
+  assert (ap_lstnr->file_fd >= 0);
+  p_con = ap_lstnr->p_con;
 
-  if (srv_get_listeners_count (ap_server) <= 0)
+  while (ap_lstnr->file_offset < ap_lstnr->file_end && budget > 0)
     {
-      return OMX_ErrorNoMore;
-    }
+      const size_t count
+        = MIN ((size_t) (ap_lstnr->file_end - ap_lstnr->file_offset), budget);
+      ssize_t bytes = 0;
 
-  /* Until support for multiple listeners gets implemented, there will only be
-     one listener in the map */
-  p_lstnr = srv_get_first_listener (ap_server);
-  assert (p_lstnr);
-  p_con = p_lstnr->p_con;
-  assert (p_con);
+      errno = 0;
+#ifdef ICE_HAVE_SENDFILE
+      bytes = sendfile (p_con->sockfd, ap_lstnr->file_fd,
+                        &(ap_lstnr->file_offset), count);
+#else
+      {
+        char chunk[ICE_RING_CHUNK_SIZE];
+        bytes = pread (ap_lstnr->file_fd, chunk, MIN (count, sizeof (chunk)),
+                       ap_lstnr->file_offset);
+        if (bytes > 0)
+          {
+            bytes = send (p_con->sockfd, chunk, bytes, MSG_NOSIGNAL);
+          }
+        if (bytes > 0)
+          {
+            ap_lstnr->file_offset += bytes;
+          }
+      }
+#endif
+
+      if (bytes < 0)
+        {
+          if (srv_is_recoverable_error (ap_server, p_con->sockfd, errno))
+            {
+              srv_block_listener (ap_lstnr);
+              return OMX_ErrorNotReady;
+            }
+          ap_server->stats.failed++;
+          return OMX_ErrorNoMore;
+        }
 
-  srv_stop_listener_io_watcher (p_lstnr);
-  if (!srv_is_listener_ready (ap_server, p_lstnr))
+      if (0 == bytes)
+        {
+          TIZ_WARN (handleOf (ap_server->p_parent),
+                    "fd [%d] : the file being sent has shrunk", p_con->sockfd);
+          return OMX_ErrorNoMore;
+        }
+
+      p_con->sent_total += bytes;
+      budget -= bytes;
+    }
+
+  if (ap_lstnr->file_offset < ap_lstnr->file_end)
     {
+      /* Budget spent; carry on when the socket is next writable */
+      srv_block_listener (ap_lstnr);
       return OMX_ErrorNotReady;
     }
+  return OMX_ErrorNone;
+}
+
+/* Gets a persistent connection ready for its next request */
+static OMX_ERRORTYPE
+srv_await_next_request (httpr_server_t * ap_server,
+                        httpr_listener_t * ap_lstnr)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
 
-  srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
+  assert (ap_server);
+  assert (ap_lstnr);
 
-  if (p_con->initial_burst_bytes <= 0)
+  srv_hls_segment_unref (ap_lstnr->p_segment);
+  ap_lstnr->p_segment = NULL;
+  ap_lstnr->segment_offset = 0;
+  ap_lstnr->segment_end = 0;
+  if (ap_lstnr->file_fd >= 0)
+    {
+      close (ap_lstnr->file_fd);
+      ap_lstnr->file_fd = -1;
+    }
+  ap_lstnr->p_mount = NULL;
+  ap_lstnr->oneshot = false;
+  ap_lstnr->keepalive = false;
+  ap_lstnr->need_response = true;
+  ap_lstnr->buf.len = ICE_LISTENER_BUF_SIZE;
+  ap_lstnr->buf.offset = 0;
+  ap_lstnr->idle_since = time (NULL);
+
+  /* The parser is good for one message only */
+  tiz_http_parser_destroy (ap_lstnr->p_parser);
+  ap_lstnr->p_parser = NULL;
+  rc = tiz_http_parser_init (&(ap_lstnr->p_parser), ETIZHttpParserTypeRequest);
+  if (OMX_ErrorNone == rc)
     {
-      p_con->burst_bytes = 0;
+      rc = srv_wait_for_request (ap_lstnr);
     }
 
-  while (1)
+  if (OMX_ErrorNone != rc)
+    {
+      srv_remove_listener (ap_server, ap_lstnr);
+      rc = OMX_ErrorNoMore;
+    }
+  return rc;
+}
+
+/* Sends what is left of a complete response: the headers, then the body of
+   an HLS playlist or segment, or of a local file. Once it has all gone out,
+   the listener waits for its next request, or is removed. */
+static OMX_ERRORTYPE
+srv_write_oneshot (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  httpr_hls_segment_t * p_segment = NULL;
+  struct iovec iov[2];
+  size_t head_left = 0;
+  size_t body_left = 0;
+  bool file_left = false;
+  int niov = 0;
+  ssize_t bytes = 0;
+
+  assert (ap_server);
+  assert (ap_lstnr);
+  assert (ap_lstnr->oneshot);
+
+  p_segment = ap_lstnr->p_segment;
+  head_left = ap_lstnr->buf.len - ap_lstnr->buf.offset;
+  body_left = p_segment ? ap_lstnr->segment_end - ap_lstnr->segment_offset : 0;
+  file_left = (ap_lstnr->file_fd >= 0
+               && ap_lstnr->file_offset < ap_lstnr->file_end);
+
+  if (head_left > 0)
+    {
+      iov[niov].iov_base = ap_lstnr->buf.p_data + ap_lstnr->buf.offset;
+      iov[niov++].iov_len = head_left;
+    }
+  if (body_left > 0)
+    {
+      iov[niov].iov_base = p_segment->data + ap_lstnr->segment_offset;
+      iov[niov++].iov_len = body_left;
+    }
+
+  if (niov > 0)
     {
-      if (NULL == p_hdr)
+      /* The headers of a file leave with the start of the file */
+      rc = srv_write_to_listener (ap_server, ap_lstnr, iov, niov,
+                                  file_left ? MSG_MORE : 0, &bytes);
+      if (OMX_ErrorNotReady == rc)
         {
-          if (NULL == (p_hdr = ap_server->pf_acquire_buf (ap_server->p_arg)))
+          /* Blocked; the io watcher will bring us back */
+          return rc;
+        }
+      if (OMX_ErrorNone == rc)
+        {
+          const size_t head_sent = MIN ((size_t) bytes, head_left);
+          ap_lstnr->buf.offset += head_sent;
+          ap_lstnr->segment_offset += bytes - head_sent;
+          ap_lstnr->p_con->sent_total += bytes;
+          if ((size_t) bytes < head_left + body_left)
             {
-              /* no more buffers available at the moment */
-              ap_server->need_more_data = true;
-              srv_stop_listener_timer_watcher (p_lstnr);
-              rc = OMX_ErrorNone;
-              break;
+              srv_block_listener (ap_lstnr);
+              return OMX_ErrorNotReady;
             }
-          ap_server->need_more_data = false;
-          ap_server->p_hdr = p_hdr;
         }
+    }
 
-      rc = srv_write_omx_buffer (ap_server, p_lstnr);
+  if (OMX_ErrorNone == rc && file_left)
+    {
+      rc = srv_send_file (ap_server, ap_lstnr);
+      if (OMX_ErrorNotReady == rc)
+        {
+          return rc;
+        }
+    }
 
-      if (OMX_ErrorNoMore == rc)
+  if (OMX_ErrorNone == rc && ap_lstnr->keepalive)
+    {
+      return srv_await_next_request (ap_server, ap_lstnr);
+    }
+
+  /* Done, or failed */
+  srv_remove_listener (ap_server, ap_lstnr);
+  return OMX_ErrorNoMore;
+}
+
+/* Sends the listener as much of the stream as the pacing clock allows */
+static OMX_ERRORTYPE
+srv_write (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  httpr_connection_t * p_con = NULL;
+  httpr_mount_t * p_mount = NULL;
+  uint64_t pos = 0;
+
+  assert (ap_server);
+  assert (ap_lstnr);
+  p_con = ap_lstnr->p_con;
+  assert (p_con);
+
+  if (ap_lstnr->failed)
+    {
+      return OMX_ErrorNoMore;
+    }
+
+  srv_stop_listener_io_watcher (ap_lstnr);
+  if (!srv_is_listener_ready (ap_server, ap_lstnr))
+    {
+      return OMX_ErrorNotReady;
+    }
+
+  if (ap_lstnr->oneshot)
+    {
+      return srv_write_oneshot (ap_server, ap_lstnr);
+    }
+
+  srv_ready_add (ap_server, ap_lstnr);
+  p_mount = ap_lstnr->p_mount;
+  assert (p_mount);
+
+  while (1)
+    {
+      assert (ap_lstnr->attached);
+      pos = srv_ring_pos (&(p_mount->ring), ap_lstnr);
+      if (!ap_lstnr->p_meta && pos >= p_mount->pace_limit)
         {
-          srv_remove_listener (ap_server, p_lstnr);
+          /* Wait for the next tick */
+          rc = OMX_ErrorNone;
           break;
         }
 
-      if (OMX_ErrorNotReady == rc
-          || ((p_con->initial_burst_bytes <= 0)
-              && (p_con->burst_bytes >= ap_server->burst_size)))
+      if (ap_lstnr->chunk == p_mount->ring.head && !ap_lstnr->p_meta
+          && !srv_ring_fill (ap_server, p_mount))
         {
-          rc = OMX_ErrorNotReady;
+          /* no more buffers available at the moment */
+          ap_lstnr->starved = true;
+          rc = OMX_ErrorNone;
+          break;
+        }
+      ap_lstnr->starved = false;
+
+      rc = ap_lstnr->failed
+             ? OMX_ErrorNoMore
+             : srv_write_omx_buffer (ap_server, ap_lstnr,
+                                     pos < p_mount->pace_limit
+                                       ? p_mount->pace_limit - pos
+                                       : 0);
+
+      if (ap_lstnr->corked && OMX_ErrorNoMore != rc)
+        {
+          /* The headers and the start of the burst have been queued */
+          (void) srv_set_cork (p_con->sockfd, false);
+          ap_lstnr->corked = false;
+        }
+
+      if (OMX_ErrorNoMore == rc)
+        {
+          srv_remove_listener (ap_server, ap_lstnr);
           break;
         }
 
-      /*       if (p_lstnr->pos == ap_server->p_hdr->nFilledLen) */
-      if (0 == ap_server->p_hdr->nFilledLen)
+      if (OMX_ErrorNotReady == rc)
         {
-          /* Buffer emptied */
-          (void) srv_release_empty_buffer (ap_server, p_lstnr, &p_hdr);
+          break;
         }
     };
 
   return rc;
 }
 
+/* Removes the listeners that were marked as failed while serving another
+   listener, and those that have waited too long for a request */
+static void
+srv_purge_listeners (httpr_server_t * ap_server)
+{
+  const time_t now = time (NULL);
+  int i = 0;
+  assert (ap_server);
+  for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
+    {
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      if (p_lstnr->failed
+          || (p_lstnr->need_response
+              && difftime (now, p_lstnr->idle_since)
+                   > (p_lstnr->nrequests > 0 ? ICE_KEEPALIVE_TIMEOUT
+                                             : ICE_DEFAULT_HEADER_TIMEOUT)))
+        {
+          srv_remove_listener (ap_server, p_lstnr);
+        }
+    }
+}
+
 static OMX_ERRORTYPE
-srv_stream_to_client (httpr_server_t * ap_server)
+srv_stream_to_client (httpr_server_t * ap_server, httpr_listener_t * ap_lstnr)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (ap_server);
 
-  rc = srv_write (ap_server);
+  rc = ap_lstnr ? srv_write (ap_server, ap_lstnr) : OMX_ErrorNoMore;
   switch (rc)
     {
       case OMX_ErrorNone:
@@ -1617,6 +4057,29 @@ srv_stream_to_client (httpr_server_t * ap_server)
   return rc;
 }
 
+/* One pass over the listeners that are not blocked on their sockets */
+static OMX_ERRORTYPE
+srv_stream_to_ready_clients (httpr_server_t * ap_server,
+                             const bool a_starved_only)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  httpr_listener_t * p_lstnr = NULL;
+  httpr_listener_t * p_next = NULL;
+  assert (ap_server);
+
+  for (p_lstnr = ap_server->p_ready; p_lstnr && OMX_ErrorNone == rc;
+       p_lstnr = p_next)
+    {
+      /* The listener may leave the list while it is being served */
+      p_next = p_lstnr->p_next_ready;
+      if ((p_lstnr->starved || !a_starved_only) && !p_lstnr->failed)
+        {
+          rc = srv_stream_to_client (ap_server, p_lstnr);
+        }
+    }
+  return rc;
+}
+
 static int
 srv_get_descriptor (const httpr_server_t * ap_server)
 {
@@ -1633,6 +4096,7 @@ httpr_srv_destroy (httpr_server_t * ap_server)
 {
   if (ap_server)
     {
+      OMX_U32 i = 0;
       srv_destroy_server_io_watcher (ap_server);
       if (ICE_SOCK_ERROR != ap_server->lstn_sockfd)
         {
@@ -1640,11 +4104,26 @@ httpr_srv_destroy (httpr_server_t * ap_server)
         }
 
       tiz_mem_free (ap_server->p_ip);
+      if (ap_server->p_ev_timer)
+        {
+          srv_stop_pacing (ap_server);
+          tiz_srv_timer_watcher_destroy (ap_server->p_parent,
+                                         ap_server->p_ev_timer);
+        }
       if (ap_server->p_lstnrs)
         {
           tiz_map_clear (ap_server->p_lstnrs);
           tiz_map_destroy (ap_server->p_lstnrs);
         }
+      for (i = 0; ap_server->p_mounts && i < ap_server->nmounts; ++i)
+        {
+          srv_hls_destroy (ap_server, &(ap_server->p_mounts[i]));
+          srv_ring_destroy (&(ap_server->p_mounts[i].ring));
+          srv_icy_block_unref (ap_server->p_mounts[i].p_icy);
+        }
+      tiz_mem_free (ap_server->p_mounts);
+      tiz_mem_free (ap_server->p_docroot);
+      tiz_mem_free (ap_server->p_status_path);
       tiz_mem_free (ap_server);
     }
 }
@@ -1652,15 +4131,20 @@ httpr_srv_destroy (httpr_server_t * ap_server)
 OMX_ERRORTYPE
 httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
                 OMX_STRING a_address, OMX_U32 a_port, OMX_U32 a_max_clients,
+                const OMX_U32 a_nmounts,
                 httpr_srv_release_buffer_f a_pf_release_buf,
-                httpr_srv_acquire_buffer_f a_pf_acquire_buf, OMX_PTR ap_arg)
+                httpr_srv_acquire_buffer_f a_pf_acquire_buf, OMX_PTR ap_arg,
+                const OMX_U32 a_ring_size,
+                const httpr_srv_slow_policy_t a_slow_policy)
 {
   httpr_server_t * p_server = NULL;
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   bool all_ok = false;
+  OMX_U32 i = 0;
 
   assert (app_server);
   assert (ap_parent);
+  assert (a_nmounts > 0);
   assert (a_pf_release_buf);
   assert (a_pf_acquire_buf);
 
@@ -1675,26 +4159,48 @@ httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
   p_server->p_srv_ev_io = NULL;
   p_server->max_clients = a_max_clients;
   p_server->p_lstnrs = NULL;
-  p_server->p_hdr = NULL;
+  p_server->p_ready = NULL;
+  p_server->p_ev_timer = NULL;
+  p_server->pacing = false;
+  p_server->slow_policy = a_slow_policy;
+  p_server->zerocopy = false;
   p_server->pf_release_buf = a_pf_release_buf;
   p_server->pf_acquire_buf = a_pf_acquire_buf;
-  p_server->need_more_data = true;
   p_server->running = false;
   p_server->p_arg = ap_arg;
-  p_server->bitrate = 0;
-  p_server->num_channels = 0;
-  p_server->sample_rate = 0;
-  p_server->bytes_per_frame = 144 * 128000 / 44100;
-  p_server->burst_size = ICE_MEDIUM_BURST_SIZE;
-  p_server->pkts_per_sec = (((double) p_server->bytes_per_frame
-                             * (double) ((double) 1000 / (double) 26)
-                             / (double) p_server->burst_size));
-  p_server->wait_time = (1 / p_server->pkts_per_sec);
-
-  tiz_mem_set (&(p_server->mountpoint), 0, sizeof (httpr_mount_t));
-  p_server->mountpoint.metadata_period = ICE_DEFAULT_METADATA_INTERVAL;
-  p_server->mountpoint.initial_burst_size = ICE_INITIAL_BURST_SIZE;
-  p_server->mountpoint.max_clients = 1;
+  p_server->hls_segment_secs = 0;
+  p_server->hls_nsegments = 0;
+  p_server->p_docroot = NULL;
+  p_server->p_status_path = NULL;
+  p_server->max_lag_ms = 0;
+  p_server->max_lag_bytes = 0;
+  p_server->max_memory = 0;
+  p_server->max_accepts_per_sec = 0;
+  p_server->accept_tokens = 0;
+  p_server->accept_time = 0;
+  tiz_mem_set (&(p_server->stats), 0, sizeof (p_server->stats));
+  p_server->stats.start_time = time (NULL);
+
+  p_server->p_mounts
+    = (httpr_mount_t *) tiz_mem_calloc (a_nmounts, sizeof (httpr_mount_t));
+  rc = p_server->p_mounts ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+  goto_end_on_omx_error (rc, handleOf (ap_parent),
+                         "Unable to alloc the mount points");
+  p_server->nmounts = a_nmounts;
+
+  for (i = 0; i < a_nmounts; ++i)
+    {
+      httpr_mount_t * p_mount = &(p_server->p_mounts[i]);
+      p_mount->pid = i;
+      p_mount->metadata_period = ICE_DEFAULT_METADATA_INTERVAL;
+      p_mount->initial_burst_size = ICE_INITIAL_BURST_SIZE;
+      p_mount->max_clients = a_max_clients;
+      srv_set_mount_rate (p_mount, OMX_AUDIO_CodingMP3, 128000, 2, 44100);
+      rc = srv_ring_init (&(p_mount->ring), a_ring_size, ICE_RING_CHUNK_SIZE);
+      goto_end_on_omx_error (rc, handleOf (ap_parent),
+                             "Unable to alloc the stream ring");
+    }
+  srv_set_pacing_rate (p_server);
 
   if (a_address)
     {
@@ -1709,6 +4215,10 @@ httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
   goto_end_on_omx_error (rc, handleOf (ap_parent),
                          "Unable to init the listeners map");
 
+  rc = tiz_srv_timer_watcher_init (ap_parent, &(p_server->p_ev_timer));
+  goto_end_on_omx_error (rc, handleOf (ap_parent),
+                         "Unable to init the pacing clock");
+
   p_server->lstn_sockfd
     = srv_create_server_socket (p_server, a_port, a_address);
   goto_end_on_socket_error (p_server->lstn_sockfd, handleOf (ap_parent),
@@ -1754,6 +4264,13 @@ httpr_srv_start (httpr_server_t * ap_server)
   rc = srv_start_server_io_watcher (ap_server);
   goto_end_on_omx_error (rc, p_hdl, "Unable to start the server io watcher");
 
+  if (srv_has_readers (ap_server))
+    {
+      /* The HLS segmenters run from the start */
+      rc = srv_start_clock (ap_server);
+      goto_end_on_omx_error (rc, p_hdl, "Unable to start the pacing clock");
+    }
+
   /* so far so good */
   ap_server->running = true;
   all_ok = true;
@@ -1769,94 +4286,88 @@ end:
 OMX_ERRORTYPE
 httpr_srv_stop (httpr_server_t * ap_server)
 {
-  httpr_listener_t * p_lstnr = NULL;
+  int i = 0;
+  OMX_U32 j = 0;
   assert (ap_server);
   (void) srv_stop_server_io_watcher (ap_server);
-  if (ap_server->p_lstnrs)
+  for (i = srv_get_listeners_count (ap_server) - 1; i >= 0; --i)
     {
-      /* Until support for multiple listeners gets implemented, there will only
-         be one listener in the map */
-      p_lstnr = srv_get_first_listener (ap_server);
-      if (p_lstnr)
-        {
-          srv_stop_listener_io_watcher (p_lstnr);
-          srv_stop_listener_timer_watcher (p_lstnr);
-          srv_remove_listener (ap_server, p_lstnr);
-        }
+      httpr_listener_t * p_lstnr = srv_get_listener_at (ap_server, i);
+      srv_stop_listener_io_watcher (p_lstnr);
+      srv_remove_listener (ap_server, p_lstnr);
+    }
+  srv_stop_pacing (ap_server);
+  for (j = 0; j < ap_server->nmounts; ++j)
+    {
+      srv_ring_reset (&(ap_server->p_mounts[j].ring));
+      srv_hls_reset (ap_server, &(ap_server->p_mounts[j]));
+      ap_server->p_mounts[j].pace_limit = 0;
     }
   ap_server->running = false;
-  ap_server->need_more_data = false;
   return OMX_ErrorNone;
 }
 
 void
-httpr_srv_release_buffers (httpr_server_t * ap_server)
+httpr_srv_release_buffers (httpr_server_t * ap_server, const OMX_U32 a_pid)
 {
+  httpr_mount_t * p_mount = NULL;
   assert (ap_server);
-  if (ap_server->p_hdr)
+  assert (a_pid < ap_server->nmounts);
+  p_mount = &(ap_server->p_mounts[a_pid]);
+  if (p_mount->p_hdr)
     {
-      ap_server->p_hdr->nFilledLen = 0;
-      ap_server->pf_release_buf (ap_server->p_hdr, ap_server->p_arg);
-      ap_server->p_hdr = NULL;
+      p_mount->p_hdr->nFilledLen = 0;
+      ap_server->pf_release_buf (p_mount->p_hdr, a_pid, ap_server->p_arg);
+      p_mount->p_hdr = NULL;
     }
 }
 
 void
-httpr_srv_set_mp3_settings (httpr_server_t * ap_server, const OMX_U32 a_bitrate,
-                            const OMX_U32 a_num_channels,
-                            const OMX_U32 a_sample_rate)
+httpr_srv_set_audio_settings (httpr_server_t * ap_server, const OMX_U32 a_pid,
+                              const OMX_AUDIO_CODINGTYPE a_encoding,
+                              const OMX_U32 a_bitrate,
+                              const OMX_U32 a_num_channels,
+                              const OMX_U32 a_sample_rate)
 {
-  assert (ap_server);
-
-  ap_server->bitrate = (a_bitrate != 0 ? a_bitrate : 448000);
-  ap_server->num_channels = (a_num_channels != 0 ? a_num_channels : 2);
-  ap_server->sample_rate = (a_sample_rate != 0 ? a_sample_rate : 44100);
-  assert (0 != a_sample_rate);
-  ap_server->bytes_per_frame = (144 * ap_server->bitrate / a_sample_rate) + 1;
-  ap_server->burst_size = ICE_MIN_BURST_SIZE;
-
-  ap_server->pkts_per_sec
-    = (((double) ap_server->bytes_per_frame * (double) (1000 / 26)
-        / (double) ap_server->burst_size));
+  httpr_mount_t * p_mount = NULL;
 
-  ap_server->wait_time = (1 / ap_server->pkts_per_sec);
+  assert (ap_server);
+  assert (a_pid < ap_server->nmounts);
 
-  if (srv_get_listeners_count (ap_server) > 0)
-    {
-      httpr_listener_t * p_lstnr = srv_get_first_listener (ap_server);
-      assert (p_lstnr);
-      srv_stop_listener_timer_watcher (p_lstnr);
-      srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
-    }
+  p_mount = &(ap_server->p_mounts[a_pid]);
+  srv_set_mount_rate (p_mount, a_encoding, a_bitrate, a_num_channels,
+                      a_sample_rate);
+  srv_set_pacing_rate (ap_server);
 
   TIZ_PRINTF_DBG_MAG (
-    "burst [%d] sample rate [%u] bitrate [%u] "
-    "burst_size [%u] bytes per frame [%u] wait_time [%f] "
+    "mount [%u] burst [%d] sample rate [%u] bitrate [%u] "
+    "burst_size [%u] bytes per sec [%f] wait_time [%f] "
     "pkts/s [%f].\n",
-    (unsigned int) ap_server->mountpoint.initial_burst_size,
-    (unsigned int) ap_server->sample_rate, (unsigned int) ap_server->bitrate,
-    (unsigned int) ap_server->burst_size,
-    (unsigned int) ap_server->bytes_per_frame, ap_server->wait_time,
-    ap_server->pkts_per_sec);
+    (unsigned int) a_pid, (unsigned int) p_mount->initial_burst_size,
+    (unsigned int) p_mount->sample_rate, (unsigned int) p_mount->bitrate,
+    (unsigned int) p_mount->burst_size, p_mount->bytes_per_sec,
+    ap_server->wait_time, ap_server->pkts_per_sec);
 }
 
 void
 httpr_srv_set_mountpoint_settings (
-  httpr_server_t * ap_server, OMX_U8 * ap_mount_name, OMX_U8 * ap_station_name,
-  OMX_U8 * ap_station_description, OMX_U8 * ap_station_genre,
-  OMX_U8 * ap_station_url, const OMX_U32 a_metadata_period,
-  const OMX_U32 a_burst_size, const OMX_U32 a_max_clients)
+  httpr_server_t * ap_server, const OMX_U32 a_pid, OMX_U8 * ap_mount_name,
+  OMX_U8 * ap_station_name, OMX_U8 * ap_station_description,
+  OMX_U8 * ap_station_genre, OMX_U8 * ap_station_url,
+  const OMX_U32 a_metadata_period, const OMX_U32 a_burst_size,
+  const OMX_U32 a_max_clients)
 {
   httpr_mount_t * p_mount = NULL;
 
   assert (ap_server);
+  assert (a_pid < ap_server->nmounts);
   assert (ap_mount_name);
   assert (ap_station_name);
   assert (ap_station_description);
   assert (ap_station_genre);
   assert (ap_station_url);
 
-  p_mount = &(ap_server->mountpoint);
+  p_mount = &(ap_server->p_mounts[a_pid]);
 
   strncpy ((char *) p_mount->mount_name, (char *) ap_mount_name,
            OMX_MAX_STRINGNAME_SIZE);
@@ -1881,22 +4392,144 @@ httpr_srv_set_mountpoint_settings (
   p_mount->metadata_period = a_metadata_period;
   p_mount->initial_burst_size = a_burst_size;
   p_mount->max_clients = a_max_clients;
+  srv_hls_set_base (p_mount);
 
   TIZ_NOTICE (handleOf (ap_server->p_parent),
-              "StationName [%s] IcyMetadataPeriod [%d]", p_mount->station_name,
+              "Mount [%s] StationName [%s] IcyMetadataPeriod [%d]",
+              p_mount->mount_name, p_mount->station_name,
               p_mount->metadata_period);
 }
 
 void
-httpr_srv_set_stream_title (httpr_server_t * ap_server,
+httpr_srv_set_zerocopy (httpr_server_t * ap_server, const bool a_enabled)
+{
+  assert (ap_server);
+#ifdef ICE_HAVE_ZEROCOPY
+  ap_server->zerocopy = a_enabled;
+#else
+  if (a_enabled)
+    {
+      TIZ_WARN (handleOf (ap_server->p_parent),
+                "MSG_ZEROCOPY is not supported on this platform");
+    }
+#endif
+}
+
+OMX_ERRORTYPE
+httpr_srv_set_hls (httpr_server_t * ap_server, const OMX_U32 a_segment_secs,
+                   const OMX_U32 a_nsegments)
+{
+  OMX_U32 i = 0;
+
+  assert (ap_server);
+  assert (!ap_server->running);
+
+  for (i = 0; i < ap_server->nmounts; ++i)
+    {
+      srv_hls_destroy (ap_server, &(ap_server->p_mounts[i]));
+    }
+
+  ap_server->hls_segment_secs
+    = MIN (a_segment_secs, ICE_HLS_MAX_SEGMENT_SECONDS);
+  ap_server->hls_nsegments = MIN (MAX (a_nsegments, 2), ICE_HLS_MAX_SEGMENTS);
+
+  for (i = 0; ap_server->hls_segment_secs > 0 && i < ap_server->nmounts; ++i)
+    {
+      httpr_mount_t * p_mount = &(ap_server->p_mounts[i]);
+      p_mount->hls.pp_segments = (httpr_hls_segment_t **) tiz_mem_calloc (
+        ap_server->hls_nsegments, sizeof (httpr_hls_segment_t *));
+      if (!p_mount->hls.pp_segments)
+        {
+          return OMX_ErrorInsufficientResources;
+        }
+      srv_hls_reset (ap_server, p_mount);
+    }
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+httpr_srv_set_document_root (httpr_server_t * ap_server,
+                             const char * ap_docroot)
+{
+  assert (ap_server);
+  assert (!ap_server->running);
+
+  tiz_mem_free (ap_server->p_docroot);
+  ap_server->p_docroot = NULL;
+
+  if (ap_docroot && '\0' != ap_docroot[0])
+    {
+      /* Served paths are checked against the root once their symlinks are
+         resolved, so the root itself is resolved here */
+      ap_server->p_docroot = httpr_doc_canonical_root (ap_docroot);
+      if (!ap_server->p_docroot)
+        {
+          TIZ_WARN (handleOf (ap_server->p_parent),
+                    "Document root [%s] is not a directory; "
+                    "no local files will be served",
+                    ap_docroot);
+          return OMX_ErrorNone;
+        }
+      TIZ_NOTICE (handleOf (ap_server->p_parent), "Document root [%s]",
+                  ap_server->p_docroot);
+    }
+  return OMX_ErrorNone;
+}
+
+void
+httpr_srv_set_limits (httpr_server_t * ap_server, const OMX_U32 a_max_lag_ms,
+                      const OMX_U32 a_max_lag_bytes,
+                      const OMX_U32 a_max_memory_kb,
+                      const OMX_U32 a_max_accepts_per_sec)
+{
+  assert (ap_server);
+  ap_server->max_lag_ms = a_max_lag_ms;
+  ap_server->max_lag_bytes = a_max_lag_bytes;
+  ap_server->max_memory = (size_t) a_max_memory_kb * 1024;
+  ap_server->max_accepts_per_sec = a_max_accepts_per_sec;
+  ap_server->accept_tokens = a_max_accepts_per_sec;
+  ap_server->accept_time = srv_monotonic_time ();
+
+  if (ap_server->max_memory > 0
+      && srv_memory_in_use (ap_server) >= ap_server->max_memory)
+    {
+      TIZ_WARN (handleOf (ap_server->p_parent),
+                "The memory cap [%u KB] leaves no room for listeners",
+                (unsigned int) a_max_memory_kb);
+    }
+}
+
+OMX_ERRORTYPE
+httpr_srv_set_status_path (httpr_server_t * ap_server,
+                           const char * ap_status_path)
+{
+  assert (ap_server);
+
+  tiz_mem_free (ap_server->p_status_path);
+  ap_server->p_status_path = NULL;
+
+  if (ap_status_path && '/' == ap_status_path[0])
+    {
+      ap_server->p_status_path = strndup (ap_status_path, PATH_MAX);
+      if (!ap_server->p_status_path)
+        {
+          return OMX_ErrorInsufficientResources;
+        }
+    }
+  return OMX_ErrorNone;
+}
+
+void
+httpr_srv_set_stream_title (httpr_server_t * ap_server, const OMX_U32 a_pid,
                             OMX_U8 * ap_stream_title)
 {
   httpr_mount_t * p_mount = NULL;
 
   assert (ap_server);
+  assert (a_pid < ap_server->nmounts);
   assert (ap_stream_title);
 
-  p_mount = &(ap_server->mountpoint);
+  p_mount = &(ap_server->p_mounts[a_pid]);
 
   TIZ_PRINTF_DBG_YEL ("stream_title [%s]\n", ap_stream_title);
 
@@ -1904,26 +4537,31 @@ httpr_srv_set_stream_title (httpr_server_t * ap_server,
            OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
   p_mount->stream_title[OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE - 1] = '\0';
 
-  if (srv_get_listeners_count (ap_server) > 0)
+  /* Encode the block once; the listeners that are still sending the
+     previous one keep their references to it */
+  srv_icy_block_unref (p_mount->p_icy);
+  p_mount->p_icy
+    = srv_icy_block_encode (p_mount->stream_title, ++p_mount->icy_gen);
+  if (!p_mount->p_icy)
     {
-      httpr_listener_t * p_lstnr = srv_get_first_listener (ap_server);
-      assert (p_lstnr);
-      assert (p_lstnr->p_con);
-      p_lstnr->p_con->metadata_delivered = false;
-      p_lstnr->p_con->initial_burst_bytes
-        = ap_server->mountpoint.initial_burst_size * 0.1;
-      srv_stop_listener_timer_watcher (p_lstnr);
-      srv_start_listener_timer_watcher (p_lstnr, ap_server->wait_time);
+      TIZ_ERROR (handleOf (ap_server->p_parent),
+                 "[OMX_ErrorInsufficientResources] : "
+                 "Unable to encode the stream title");
     }
 }
 
 OMX_ERRORTYPE
 httpr_srv_buffer_event (httpr_server_t * ap_server)
 {
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (ap_server);
-  return ((ap_server->running && ap_server->need_more_data)
-            ? srv_stream_to_client (ap_server)
-            : OMX_ErrorNone);
+  if (ap_server->running)
+    {
+      srv_hls_pump_all (ap_server);
+      rc = srv_stream_to_ready_clients (ap_server, true);
+      srv_purge_listeners (ap_server);
+    }
+  return rc;
 }
 
 OMX_ERRORTYPE
@@ -1945,15 +4583,31 @@ httpr_srv_io_event (httpr_server_t * ap_server, const int a_fd)
       else
         {
           /* The client socket is ready */
-          rc = srv_stream_to_client (ap_server);
+          int fd = a_fd;
+          rc = srv_stream_to_client (
+            ap_server, (httpr_listener_t *) tiz_map_find (ap_server->p_lstnrs,
+                                                          &fd));
+          srv_purge_listeners (ap_server);
         }
     }
   return rc;
 }
 
 OMX_ERRORTYPE
-httpr_srv_timer_event (httpr_server_t * ap_server)
+httpr_srv_timer_event (httpr_server_t * ap_server,
+                       tiz_event_timer_t * ap_ev_timer)
 {
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (ap_server);
-  return ap_server->running ? srv_stream_to_client (ap_server) : OMX_ErrorNone;
+  if (ap_server->running)
+    {
+      if (ap_ev_timer == ap_server->p_ev_timer)
+        {
+          srv_pace_tick (ap_server);
+          srv_hls_pump_all (ap_server);
+          rc = srv_stream_to_ready_clients (ap_server, false);
+          srv_purge_listeners (ap_server);
+        }
+    }
+  return rc;
 }
@@ -33,20 +33,39 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+
+#include <OMX_Audio.h>
 #include <OMX_Core.h>
 #include <OMX_Types.h>
 
+#include <tizplatform.h>
+
 typedef struct httpr_server httpr_server_t;
 
+/* What to do with a listener that falls so far behind that the oldest chunk
+   of the stream ring can't be recycled. */
+typedef enum httpr_srv_slow_policy httpr_srv_slow_policy_t;
+enum httpr_srv_slow_policy
+{
+  EHttprSrvSlowPolicySkip, /* Move the listener forward to the live edge */
+  EHttprSrvSlowPolicyDrop  /* Disconnect the listener */
+};
+
+/* Each mount point is fed from the input port with the same index */
 typedef void (*httpr_srv_release_buffer_f) (OMX_BUFFERHEADERTYPE * ap_hdr,
-                                            OMX_PTR ap_arg);
-typedef OMX_BUFFERHEADERTYPE * (*httpr_srv_acquire_buffer_f) (OMX_PTR ap_arg);
+                                            OMX_U32 a_pid, OMX_PTR ap_arg);
+typedef OMX_BUFFERHEADERTYPE * (*httpr_srv_acquire_buffer_f) (OMX_U32 a_pid,
+                                                              OMX_PTR ap_arg);
 
 OMX_ERRORTYPE
 httpr_srv_init (httpr_server_t ** app_server, void * ap_parent,
                 OMX_STRING a_address, OMX_U32 a_port, OMX_U32 a_max_clients,
+                const OMX_U32 a_nmounts,
                 httpr_srv_release_buffer_f a_pf_release_buf,
-                httpr_srv_acquire_buffer_f a_pf_acquire_buf, OMX_PTR ap_arg);
+                httpr_srv_acquire_buffer_f a_pf_acquire_buf, OMX_PTR ap_arg,
+                const OMX_U32 a_ring_size,
+                const httpr_srv_slow_policy_t a_slow_policy);
 
 void
 httpr_srv_destroy (httpr_server_t * ap_server);
@@ -58,22 +77,58 @@ OMX_ERRORTYPE
 httpr_srv_stop (httpr_server_t * ap_server);
 
 void
-httpr_srv_release_buffers (httpr_server_t * ap_server);
+httpr_srv_release_buffers (httpr_server_t * ap_server, const OMX_U32 a_pid);
 
 void
-httpr_srv_set_mp3_settings (httpr_server_t * ap_server, const OMX_U32 a_bitrate,
-                            const OMX_U32 a_num_channels,
-                            const OMX_U32 a_sample_rate);
+httpr_srv_set_audio_settings (httpr_server_t * ap_server, const OMX_U32 a_pid,
+                              const OMX_AUDIO_CODINGTYPE a_encoding,
+                              const OMX_U32 a_bitrate,
+                              const OMX_U32 a_num_channels,
+                              const OMX_U32 a_sample_rate);
 
 void
 httpr_srv_set_mountpoint_settings (
-  httpr_server_t * ap_server, OMX_U8 * ap_mount_name, OMX_U8 * ap_station_name,
-  OMX_U8 * ap_station_description, OMX_U8 * ap_station_genre,
-  OMX_U8 * ap_station_url, const OMX_U32 metadata_period,
-  const OMX_U32 burst_size, const OMX_U32 max_clients);
+  httpr_server_t * ap_server, const OMX_U32 a_pid, OMX_U8 * ap_mount_name,
+  OMX_U8 * ap_station_name, OMX_U8 * ap_station_description,
+  OMX_U8 * ap_station_genre, OMX_U8 * ap_station_url,
+  const OMX_U32 metadata_period, const OMX_U32 burst_size,
+  const OMX_U32 max_clients);
+
+void
+httpr_srv_set_zerocopy (httpr_server_t * ap_server, const bool a_enabled);
+
+/* Also serve the MP3 mount points as HLS, in segments of about
+   'a_segment_secs' seconds, keeping the last 'a_nsegments'. 0 seconds
+   disables HLS. */
+OMX_ERRORTYPE
+httpr_srv_set_hls (httpr_server_t * ap_server, const OMX_U32 a_segment_secs,
+                   const OMX_U32 a_nsegments);
+
+/* Serve the regular files under 'ap_docroot' on demand, with support for
+   byte ranges and persistent connections. NULL disables it. */
+OMX_ERRORTYPE
+httpr_srv_set_document_root (httpr_server_t * ap_server,
+                             const char * ap_docroot);
+
+/* Admission control and backpressure. A listener that lags more than
+   'a_max_lag_ms' or 'a_max_lag_bytes' behind the live edge gets the slow
+   listener policy. New connections are turned away beyond
+   'a_max_accepts_per_sec', or when the server would need more than
+   'a_max_memory_kb'. 0 leaves a limit off. */
+void
+httpr_srv_set_limits (httpr_server_t * ap_server, const OMX_U32 a_max_lag_ms,
+                      const OMX_U32 a_max_lag_bytes,
+                      const OMX_U32 a_max_memory_kb,
+                      const OMX_U32 a_max_accepts_per_sec);
+
+/* Serve a JSON report of the server's counters at 'ap_status_path', e.g.
+   '/status.json'. NULL disables it. */
+OMX_ERRORTYPE
+httpr_srv_set_status_path (httpr_server_t * ap_server,
+                           const char * ap_status_path);
 
 void
-httpr_srv_set_stream_title (httpr_server_t * ap_server,
+httpr_srv_set_stream_title (httpr_server_t * ap_server, const OMX_U32 a_pid,
                             OMX_U8 * ap_stream_title);
 
 OMX_ERRORTYPE
@@ -81,7 +136,8 @@ httpr_srv_buffer_event (httpr_server_t * ap_server);
 OMX_ERRORTYPE
 httpr_srv_io_event (httpr_server_t * ap_server, const int a_fd);
 OMX_ERRORTYPE
-httpr_srv_timer_event (httpr_server_t * ap_server);
+httpr_srv_timer_event (httpr_server_t * ap_server,
+                       tiz_event_timer_t * ap_ev_timer);
 
 #ifdef __cplusplus
 }
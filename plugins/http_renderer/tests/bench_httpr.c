@@ -0,0 +1,1288 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   bench_httpr.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  HTTP renderer load generator and soak benchmark
+ *
+ * Loads the HTTP renderer through the IL core, feeds its MP3 port with
+ * silent frames and opens many loopback listener connections to its mount
+ * point. Some listeners read slower than the stream's bitrate, some ask for
+ * ICY metadata, while the stream title is changed every few seconds. Every
+ * report interval it prints the received throughput, the worst gaps between
+ * reads, the playback stalls a player would have had, the CPU spent by the
+ * component (i.e. the process minus this benchmark's own threads) per
+ * listener, the resident memory growth and the dropped and rejected
+ * connections.
+ *
+ * The component is found via the IL core's usual config file; point
+ * TIZONIA_RC_FILE at a tizonia.conf whose component-paths include the build
+ * tree to measure a local build. The renderer's own settings (limits, lag,
+ * memory cap, etc) are read from that file too.
+ *
+ * Usage: bench_httpr [-p port] [-u mount] [-n listeners] [-s slow%]
+ *                    [-m metadata%] [-b kbps] [-d seconds] [-i seconds]
+ *                    [-t seconds] [-r]
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <OMX_Audio.h>
+#include <OMX_Component.h>
+#include <OMX_Core.h>
+#include <OMX_TizoniaExt.h>
+#include <OMX_Types.h>
+
+#define BENCH_HTTPR_COMPONENT_NAME "OMX.Aratelia.audio_renderer.http"
+#define BENCH_HTTPR_DEFAULT_PORT 8010
+#define BENCH_HTTPR_DEFAULT_LISTENERS 100
+#define BENCH_HTTPR_DEFAULT_SLOW_PCT 10
+#define BENCH_HTTPR_DEFAULT_META_PCT 25
+#define BENCH_HTTPR_DEFAULT_BITRATE 128
+#define BENCH_HTTPR_DEFAULT_DURATION 60
+#define BENCH_HTTPR_DEFAULT_INTERVAL 10
+#define BENCH_HTTPR_DEFAULT_TITLE_PERIOD 5
+#define BENCH_HTTPR_ICY_METAINT 16000
+#define BENCH_HTTPR_SAMPLE_RATE 48000
+/* Slow listeners read at this fraction of the stream's bitrate, through a
+   small socket buffer, so that they fall behind within seconds */
+#define BENCH_HTTPR_SLOW_RATE 0.5
+#define BENCH_HTTPR_SLOW_RCVBUF (8 * 1024)
+/* A player's initial buffer, and the one it refills after a stall */
+#define BENCH_HTTPR_PREBUFFER_SECS 1.0
+#define BENCH_HTTPR_RECONNECT_SECS 1.0
+#define BENCH_HTTPR_TICK_SECS 0.05
+#define BENCH_HTTPR_STATE_TIMEOUT_SECS 5
+#define BENCH_HTTPR_HEADERS_MAX 4096
+#define BENCH_HTTPR_READ_SIZE (64 * 1024)
+#define BENCH_HTTPR_MAX_EVENTS 256
+#define BENCH_HTTPR_FRAME_MAX (3 * 320)
+
+#define BENCH_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+typedef enum bench_kind
+{
+  BENCH_KIND_NORMAL,
+  BENCH_KIND_SLOW,
+  BENCH_KIND_META,
+  BENCH_KIND_MAX
+} bench_kind_t;
+
+static const char * g_kind_names[BENCH_KIND_MAX] = {"normal", "slow", "icy"};
+
+typedef enum bench_state
+{
+  BENCH_STATE_IDLE,
+  BENCH_STATE_CONNECTING,
+  BENCH_STATE_HEADERS,
+  BENCH_STATE_STREAMING
+} bench_state_t;
+
+typedef struct bench_totals bench_totals_t;
+struct bench_totals
+{
+  uint64_t bytes;
+  unsigned int stalls;
+  unsigned int drops;
+  unsigned int rejects;
+  unsigned int failures;
+  unsigned int titles;
+};
+
+typedef struct bench_listener bench_listener_t;
+struct bench_listener
+{
+  int fd;
+  bench_kind_t kind;
+  bench_state_t state;
+  char hdr[BENCH_HTTPR_HEADERS_MAX];
+  size_t hdr_len;
+  long metaint;
+  long audio_left;  /* audio bytes until the next ICY length byte */
+  long meta_left;   /* ICY metadata bytes still to come */
+  double reconnect_at;
+  double streaming_since;
+  /* Playout model: a player that started playing after a prebuffer */
+  double play_start;
+  uint64_t play_base;
+  uint64_t audio_bytes;
+  double last_data;
+  double max_gap;    /* this interval */
+  bench_totals_t totals;
+};
+
+typedef struct bench_omx bench_omx_t;
+struct bench_omx
+{
+  OMX_HANDLETYPE p_hdl;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  pthread_t feeder;
+  bool feeding;
+  bool stop;
+  OMX_STATETYPE state;
+  OMX_ERRORTYPE error;
+  OMX_BUFFERHEADERTYPE ** pp_hdrs;
+  OMX_U32 nhdrs;
+  OMX_BUFFERHEADERTYPE ** pp_free;
+  OMX_U32 nfree;
+  uint8_t frame[BENCH_HTTPR_FRAME_MAX];
+  size_t frame_len;
+  size_t frame_pos;
+};
+
+static bench_omx_t g_omx;
+static bench_listener_t * gp_listeners = NULL;
+static int g_nlisteners = BENCH_HTTPR_DEFAULT_LISTENERS;
+static int g_port = BENCH_HTTPR_DEFAULT_PORT;
+static const char * gp_mount = "/";
+static int g_bitrate = BENCH_HTTPR_DEFAULT_BITRATE;
+static bool g_reconnect = false;
+static int g_epfd = -1;
+static volatile sig_atomic_t g_interrupted = 0;
+
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+cpu_clock (clockid_t a_clock)
+{
+  struct timespec ts;
+  if (0 != clock_gettime (a_clock, &ts))
+    {
+      return 0;
+    }
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+bytes_per_sec (void)
+{
+  return g_bitrate * 1000.0 / 8;
+}
+
+static long
+resident_kb (void)
+{
+  char line[256];
+  long kb = 0;
+  FILE * p_file = fopen ("/proc/self/status", "r");
+  if (p_file)
+    {
+      while (fgets (line, sizeof (line), p_file))
+        {
+          if (0 == strncmp (line, "VmRSS:", 6))
+            {
+              kb = strtol (line + 6, NULL, 10);
+              break;
+            }
+        }
+      fclose (p_file);
+    }
+  return kb;
+}
+
+static void
+on_signal (int a_sig)
+{
+  (void) a_sig;
+  g_interrupted = 1;
+}
+
+/*
+ * The source: an MPEG-1 Layer III stream of silent mono frames. At 48KHz a
+ * frame is 3 bytes per kbps, with no padding, and all-zero side info makes
+ * every frame decode to silence.
+ */
+
+static bool
+make_frame (void)
+{
+  static const int bitrates[]
+    = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+  int idx = 0;
+  for (idx = 1; idx < (int) (sizeof (bitrates) / sizeof (bitrates[0])); ++idx)
+    {
+      if (bitrates[idx] == g_bitrate)
+        {
+          break;
+        }
+    }
+  if (idx == (int) (sizeof (bitrates) / sizeof (bitrates[0])))
+    {
+      return false;
+    }
+
+  g_omx.frame_len = 3 * g_bitrate;
+  assert (g_omx.frame_len <= sizeof (g_omx.frame));
+  memset (g_omx.frame, 0, g_omx.frame_len);
+  g_omx.frame[0] = 0xFF;
+  g_omx.frame[1] = 0xFB;                  /* MPEG-1, Layer III, no CRC */
+  g_omx.frame[2] = (uint8_t) (idx << 4) | (1 << 2); /* 48KHz, no padding */
+  g_omx.frame[3] = 0xC0;                  /* Mono */
+  return true;
+}
+
+static void
+fill_buffer (OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  OMX_U32 filled = 0;
+  while (filled < ap_hdr->nAllocLen)
+    {
+      const size_t len
+        = BENCH_MIN (g_omx.frame_len - g_omx.frame_pos,
+                   (size_t) (ap_hdr->nAllocLen - filled));
+      memcpy (ap_hdr->pBuffer + filled, g_omx.frame + g_omx.frame_pos, len);
+      filled += len;
+      g_omx.frame_pos = (g_omx.frame_pos + len) % g_omx.frame_len;
+    }
+  ap_hdr->nOffset = 0;
+  ap_hdr->nFilledLen = filled;
+  ap_hdr->nFlags = 0;
+}
+
+/* The renderer paces its input to the stream's bitrate, so the feeder just
+   hands every buffer back as soon as it comes back */
+static void *
+feeder_thread (void * ap_arg)
+{
+  (void) ap_arg;
+  for (;;)
+    {
+      OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+      OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+      pthread_mutex_lock (&g_omx.mutex);
+      while (0 == g_omx.nfree && !g_omx.stop)
+        {
+          pthread_cond_wait (&g_omx.cond, &g_omx.mutex);
+        }
+      if (g_omx.stop)
+        {
+          pthread_mutex_unlock (&g_omx.mutex);
+          break;
+        }
+      p_hdr = g_omx.pp_free[--g_omx.nfree];
+      pthread_mutex_unlock (&g_omx.mutex);
+
+      fill_buffer (p_hdr);
+      rc = OMX_EmptyThisBuffer (g_omx.p_hdl, p_hdr);
+      if (OMX_ErrorNone != rc)
+        {
+          fprintf (stderr, "OMX_EmptyThisBuffer: error [0x%08x]\n",
+                   (unsigned int) rc);
+          pthread_mutex_lock (&g_omx.mutex);
+          g_omx.pp_free[g_omx.nfree++] = p_hdr;
+          pthread_mutex_unlock (&g_omx.mutex);
+          break;
+        }
+    }
+  return NULL;
+}
+
+static OMX_ERRORTYPE
+on_event (OMX_HANDLETYPE ap_hdl, OMX_PTR ap_app_data, OMX_EVENTTYPE a_event,
+          OMX_U32 a_data1, OMX_U32 a_data2, OMX_PTR ap_event_data)
+{
+  (void) ap_hdl;
+  (void) ap_app_data;
+  (void) ap_event_data;
+  pthread_mutex_lock (&g_omx.mutex);
+  if (OMX_EventCmdComplete == a_event && OMX_CommandStateSet == a_data1)
+    {
+      g_omx.state = (OMX_STATETYPE) a_data2;
+      pthread_cond_broadcast (&g_omx.cond);
+    }
+  else if (OMX_EventError == a_event)
+    {
+      g_omx.error = (OMX_ERRORTYPE) a_data1;
+      pthread_cond_broadcast (&g_omx.cond);
+    }
+  pthread_mutex_unlock (&g_omx.mutex);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+on_empty_buffer_done (OMX_HANDLETYPE ap_hdl, OMX_PTR ap_app_data,
+                      OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  (void) ap_hdl;
+  (void) ap_app_data;
+  pthread_mutex_lock (&g_omx.mutex);
+  assert (g_omx.nfree < g_omx.nhdrs);
+  g_omx.pp_free[g_omx.nfree++] = ap_hdr;
+  pthread_cond_broadcast (&g_omx.cond);
+  pthread_mutex_unlock (&g_omx.mutex);
+  return OMX_ErrorNone;
+}
+
+static OMX_CALLBACKTYPE g_callbacks
+  = {on_event, on_empty_buffer_done, NULL};
+
+static OMX_ERRORTYPE
+wait_for_state (OMX_STATETYPE a_state)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  struct timespec deadline;
+
+  clock_gettime (CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += BENCH_HTTPR_STATE_TIMEOUT_SECS;
+
+  pthread_mutex_lock (&g_omx.mutex);
+  while (a_state != g_omx.state && OMX_ErrorNone == g_omx.error)
+    {
+      if (ETIMEDOUT
+          == pthread_cond_timedwait (&g_omx.cond, &g_omx.mutex, &deadline))
+        {
+          rc = OMX_ErrorTimeout;
+          break;
+        }
+    }
+  if (OMX_ErrorNone == rc)
+    {
+      rc = g_omx.error;
+    }
+  pthread_mutex_unlock (&g_omx.mutex);
+  return rc;
+}
+
+static OMX_ERRORTYPE
+set_state (OMX_STATETYPE a_state)
+{
+  OMX_ERRORTYPE rc
+    = OMX_SendCommand (g_omx.p_hdl, OMX_CommandStateSet, a_state, NULL);
+  return OMX_ErrorNone == rc ? wait_for_state (a_state) : rc;
+}
+
+static OMX_ERRORTYPE
+configure_renderer (void)
+{
+  OMX_AUDIO_PARAM_MP3TYPE mp3;
+  OMX_TIZONIA_HTTPSERVERTYPE httpsrv;
+  OMX_TIZONIA_ICECASTMOUNTPOINTTYPE mount;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  memset (&mp3, 0, sizeof (mp3));
+  mp3.nSize = sizeof (mp3);
+  mp3.nVersion.nVersion = OMX_VERSION;
+  mp3.nPortIndex = 0;
+  if (OMX_ErrorNone
+      != (rc = OMX_GetParameter (g_omx.p_hdl, OMX_IndexParamAudioMp3, &mp3)))
+    {
+      return rc;
+    }
+  mp3.nChannels = 1;
+  mp3.nBitRate = g_bitrate * 1000;
+  mp3.nSampleRate = BENCH_HTTPR_SAMPLE_RATE;
+  mp3.eChannelMode = OMX_AUDIO_ChannelModeMono;
+  if (OMX_ErrorNone
+      != (rc = OMX_SetParameter (g_omx.p_hdl, OMX_IndexParamAudioMp3, &mp3)))
+    {
+      return rc;
+    }
+
+  memset (&httpsrv, 0, sizeof (httpsrv));
+  httpsrv.nSize = sizeof (httpsrv);
+  httpsrv.nVersion.nVersion = OMX_VERSION;
+  if (OMX_ErrorNone
+      != (rc = OMX_GetParameter (
+            g_omx.p_hdl, (OMX_INDEXTYPE) OMX_TizoniaIndexParamHttpServer,
+            &httpsrv)))
+    {
+      return rc;
+    }
+  httpsrv.nListeningPort = g_port;
+  httpsrv.nMaxClients = g_nlisteners;
+  if (OMX_ErrorNone
+      != (rc = OMX_SetParameter (
+            g_omx.p_hdl, (OMX_INDEXTYPE) OMX_TizoniaIndexParamHttpServer,
+            &httpsrv)))
+    {
+      return rc;
+    }
+
+  memset (&mount, 0, sizeof (mount));
+  mount.nSize = sizeof (mount);
+  mount.nVersion.nVersion = OMX_VERSION;
+  mount.nPortIndex = 0;
+  if (OMX_ErrorNone
+      != (rc = OMX_GetParameter (
+            g_omx.p_hdl, (OMX_INDEXTYPE) OMX_TizoniaIndexParamIcecastMountpoint,
+            &mount)))
+    {
+      return rc;
+    }
+  snprintf ((char *) mount.cMountName, sizeof (mount.cMountName), "%s",
+            gp_mount);
+  snprintf ((char *) mount.cStationName, sizeof (mount.cStationName),
+            "bench_httpr");
+  mount.eEncoding = OMX_AUDIO_CodingMP3;
+  mount.nIcyMetadataPeriod = BENCH_HTTPR_ICY_METAINT;
+  mount.nMaxClients = g_nlisteners;
+  return OMX_SetParameter (
+    g_omx.p_hdl, (OMX_INDEXTYPE) OMX_TizoniaIndexParamIcecastMountpoint,
+    &mount);
+}
+
+static OMX_ERRORTYPE
+start_renderer (void)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE port_def;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_U32 i = 0;
+
+  pthread_mutex_init (&g_omx.mutex, NULL);
+  pthread_cond_init (&g_omx.cond, NULL);
+  g_omx.state = OMX_StateLoaded;
+
+  if (OMX_ErrorNone != (rc = OMX_Init ())
+      || OMX_ErrorNone
+           != (rc = OMX_GetHandle (&g_omx.p_hdl,
+                                   BENCH_HTTPR_COMPONENT_NAME, NULL,
+                                   &g_callbacks))
+      || OMX_ErrorNone != (rc = configure_renderer ()))
+    {
+      return rc;
+    }
+
+  memset (&port_def, 0, sizeof (port_def));
+  port_def.nSize = sizeof (port_def);
+  port_def.nVersion.nVersion = OMX_VERSION;
+  port_def.nPortIndex = 0;
+  if (OMX_ErrorNone
+      != (rc = OMX_GetParameter (g_omx.p_hdl, OMX_IndexParamPortDefinition,
+                                 &port_def)))
+    {
+      return rc;
+    }
+
+  g_omx.nhdrs = port_def.nBufferCountActual;
+  g_omx.pp_hdrs = calloc (g_omx.nhdrs, sizeof (OMX_BUFFERHEADERTYPE *));
+  g_omx.pp_free = calloc (g_omx.nhdrs, sizeof (OMX_BUFFERHEADERTYPE *));
+  if (!g_omx.pp_hdrs || !g_omx.pp_free)
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+
+  if (OMX_ErrorNone
+      != (rc = OMX_SendCommand (g_omx.p_hdl, OMX_CommandStateSet,
+                                OMX_StateIdle, NULL)))
+    {
+      return rc;
+    }
+  for (i = 0; i < g_omx.nhdrs && OMX_ErrorNone == rc; ++i)
+    {
+      rc = OMX_AllocateBuffer (g_omx.p_hdl, &g_omx.pp_hdrs[i], 0, NULL,
+                               port_def.nBufferSize);
+    }
+  if (OMX_ErrorNone != rc
+      || OMX_ErrorNone != (rc = wait_for_state (OMX_StateIdle))
+      || OMX_ErrorNone != (rc = set_state (OMX_StateExecuting)))
+    {
+      return rc;
+    }
+
+  pthread_mutex_lock (&g_omx.mutex);
+  for (i = 0; i < g_omx.nhdrs; ++i)
+    {
+      g_omx.pp_free[g_omx.nfree++] = g_omx.pp_hdrs[i];
+    }
+  pthread_mutex_unlock (&g_omx.mutex);
+
+  if (0 != pthread_create (&g_omx.feeder, NULL, feeder_thread, NULL))
+    {
+      return OMX_ErrorInsufficientResources;
+    }
+  g_omx.feeding = true;
+  return OMX_ErrorNone;
+}
+
+static void
+stop_renderer (void)
+{
+  OMX_U32 i = 0;
+
+  if (g_omx.feeding)
+    {
+      pthread_mutex_lock (&g_omx.mutex);
+      g_omx.stop = true;
+      pthread_cond_broadcast (&g_omx.cond);
+      pthread_mutex_unlock (&g_omx.mutex);
+      pthread_join (g_omx.feeder, NULL);
+    }
+
+  if (g_omx.p_hdl)
+    {
+      if (OMX_StateExecuting == g_omx.state)
+        {
+          (void) set_state (OMX_StateIdle);
+        }
+      if (OMX_StateIdle == g_omx.state)
+        {
+          (void) OMX_SendCommand (g_omx.p_hdl, OMX_CommandStateSet,
+                                  OMX_StateLoaded, NULL);
+          for (i = 0; i < g_omx.nhdrs; ++i)
+            {
+              if (g_omx.pp_hdrs[i])
+                {
+                  (void) OMX_FreeBuffer (g_omx.p_hdl, 0, g_omx.pp_hdrs[i]);
+                }
+            }
+          (void) wait_for_state (OMX_StateLoaded);
+        }
+      (void) OMX_FreeHandle (g_omx.p_hdl);
+    }
+  (void) OMX_Deinit ();
+  free (g_omx.pp_hdrs);
+  free (g_omx.pp_free);
+}
+
+static void
+set_stream_title (unsigned int a_count)
+{
+  OMX_TIZONIA_ICECASTMETADATATYPE * p_meta
+    = calloc (1, sizeof (OMX_TIZONIA_ICECASTMETADATATYPE)
+                   + OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE);
+  if (p_meta)
+    {
+      p_meta->nVersion.nVersion = OMX_VERSION;
+      p_meta->nPortIndex = 0;
+      snprintf ((char *) p_meta->cStreamTitle,
+                OMX_TIZONIA_MAX_SHOUTCAST_METADATA_SIZE,
+                "StreamTitle='bench_httpr title %u';", a_count);
+      p_meta->nSize = sizeof (OMX_TIZONIA_ICECASTMETADATATYPE)
+                      + strlen ((char *) p_meta->cStreamTitle);
+      (void) OMX_SetConfig (g_omx.p_hdl,
+                            (OMX_INDEXTYPE)
+                              OMX_TizoniaIndexConfigIcecastMetadata,
+                            p_meta);
+      free (p_meta);
+    }
+}
+
+/*
+ * The listeners
+ */
+
+static void
+close_listener (bench_listener_t * ap_l, double a_now, bool a_dropped)
+{
+  if (ap_l->fd >= 0)
+    {
+      (void) epoll_ctl (g_epfd, EPOLL_CTL_DEL, ap_l->fd, NULL);
+      close (ap_l->fd);
+      ap_l->fd = -1;
+    }
+  if (a_dropped && BENCH_STATE_STREAMING == ap_l->state)
+    {
+      ap_l->totals.drops++;
+    }
+  ap_l->state = BENCH_STATE_IDLE;
+  ap_l->reconnect_at = g_reconnect ? a_now + BENCH_HTTPR_RECONNECT_SECS : 0;
+}
+
+static void
+connect_listener (bench_listener_t * ap_l, double a_now)
+{
+  struct sockaddr_in addr;
+  struct epoll_event ev;
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (g_port);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  ap_l->reconnect_at = 0;
+  ap_l->hdr_len = 0;
+  ap_l->metaint = 0;
+  ap_l->meta_left = 0;
+  ap_l->fd = socket (AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (ap_l->fd < 0)
+    {
+      ap_l->totals.failures++;
+      close_listener (ap_l, a_now, false);
+      return;
+    }
+
+  if (BENCH_KIND_SLOW == ap_l->kind)
+    {
+      int size = BENCH_HTTPR_SLOW_RCVBUF;
+      (void) setsockopt (ap_l->fd, SOL_SOCKET, SO_RCVBUF, &size,
+                         sizeof (size));
+    }
+
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLOUT;
+  ev.data.ptr = ap_l;
+  if ((connect (ap_l->fd, (struct sockaddr *) &addr, sizeof (addr)) < 0
+       && EINPROGRESS != errno)
+      || epoll_ctl (g_epfd, EPOLL_CTL_ADD, ap_l->fd, &ev) < 0)
+    {
+      ap_l->totals.failures++;
+      close_listener (ap_l, a_now, false);
+      return;
+    }
+  ap_l->state = BENCH_STATE_CONNECTING;
+}
+
+static void
+send_request (bench_listener_t * ap_l, double a_now)
+{
+  char req[512];
+  struct epoll_event ev;
+  int err = 0;
+  socklen_t errlen = sizeof (err);
+  int len = 0;
+
+  if (getsockopt (ap_l->fd, SOL_SOCKET, SO_ERROR, &err, &errlen) < 0
+      || err != 0)
+    {
+      ap_l->totals.failures++;
+      close_listener (ap_l, a_now, false);
+      return;
+    }
+
+  len = snprintf (req, sizeof (req),
+                  "GET %s HTTP/1.0\r\n"
+                  "Host: 127.0.0.1:%d\r\n"
+                  "User-Agent: bench_httpr\r\n"
+                  "%s"
+                  "\r\n",
+                  gp_mount, g_port,
+                  BENCH_KIND_META == ap_l->kind ? "Icy-MetaData: 1\r\n" : "");
+
+  memset (&ev, 0, sizeof (ev));
+  ev.events = EPOLLIN;
+  ev.data.ptr = ap_l;
+  if (send (ap_l->fd, req, len, MSG_NOSIGNAL) != len
+      || epoll_ctl (g_epfd, EPOLL_CTL_MOD, ap_l->fd, &ev) < 0)
+    {
+      ap_l->totals.failures++;
+      close_listener (ap_l, a_now, false);
+      return;
+    }
+  ap_l->state = BENCH_STATE_HEADERS;
+}
+
+static void
+consume_audio (bench_listener_t * ap_l, size_t a_len, double a_now)
+{
+  const double rate = bytes_per_sec ();
+  const double played
+    = (a_now - ap_l->play_start - BENCH_HTTPR_PREBUFFER_SECS) * rate;
+
+  /* A player would have run dry before this data arrived; it stops and
+     buffers again */
+  if (played > 0 && (double) (ap_l->audio_bytes - ap_l->play_base) < played)
+    {
+      ap_l->totals.stalls++;
+      ap_l->play_start = a_now;
+      ap_l->play_base = ap_l->audio_bytes;
+    }
+  ap_l->audio_bytes += a_len;
+  ap_l->totals.bytes += a_len;
+}
+
+static void
+consume_body (bench_listener_t * ap_l, const uint8_t * ap_data, size_t a_len,
+              double a_now)
+{
+  size_t audio = 0;
+
+  if (0 == ap_l->metaint)
+    {
+      consume_audio (ap_l, a_len, a_now);
+      return;
+    }
+
+  while (a_len > 0)
+    {
+      if (ap_l->audio_left > 0)
+        {
+          const size_t n = BENCH_MIN ((size_t) ap_l->audio_left, a_len);
+          audio += n;
+          ap_l->audio_left -= n;
+          ap_data += n;
+          a_len -= n;
+        }
+      else if (ap_l->meta_left > 0)
+        {
+          const size_t n = BENCH_MIN ((size_t) ap_l->meta_left, a_len);
+          ap_l->meta_left -= n;
+          ap_data += n;
+          a_len -= n;
+          if (0 == ap_l->meta_left)
+            {
+              ap_l->audio_left = ap_l->metaint;
+            }
+        }
+      else
+        {
+          /* The length byte, in 16-byte units */
+          ap_l->meta_left = 16 * ap_data[0];
+          ap_data++;
+          a_len--;
+          if (ap_l->meta_left > 0)
+            {
+              ap_l->totals.titles++;
+            }
+          else
+            {
+              ap_l->audio_left = ap_l->metaint;
+            }
+        }
+    }
+
+  if (audio > 0)
+    {
+      consume_audio (ap_l, audio, a_now);
+    }
+}
+
+static bool
+consume_headers (bench_listener_t * ap_l, const uint8_t ** app_data,
+                 size_t * ap_len, double a_now)
+{
+  const size_t room = sizeof (ap_l->hdr) - 1 - ap_l->hdr_len;
+  const size_t n = BENCH_MIN (room, *ap_len);
+  char * p_end = NULL;
+  char * p_metaint = NULL;
+  size_t used = 0;
+  int status = 0;
+
+  memcpy (ap_l->hdr + ap_l->hdr_len, *app_data, n);
+  ap_l->hdr_len += n;
+  ap_l->hdr[ap_l->hdr_len] = '\0';
+
+  if (!(p_end = strstr (ap_l->hdr, "\r\n\r\n")))
+    {
+      if (0 == room)
+        {
+          ap_l->totals.failures++;
+          close_listener (ap_l, a_now, false);
+          return false;
+        }
+      *app_data += n;
+      *ap_len -= n;
+      return true;
+    }
+
+  /* What came after the headers is the start of the body */
+  used = n - (ap_l->hdr_len - (size_t) (p_end + 4 - ap_l->hdr));
+  *app_data += used;
+  *ap_len -= used;
+  *p_end = '\0';
+
+  if (1 != sscanf (ap_l->hdr, "%*s %d", &status) || 200 != status)
+    {
+      if (503 == status)
+        {
+          ap_l->totals.rejects++;
+        }
+      else
+        {
+          ap_l->totals.failures++;
+        }
+      close_listener (ap_l, a_now, false);
+      return false;
+    }
+
+  if ((p_metaint = strcasestr (ap_l->hdr, "icy-metaint:")))
+    {
+      ap_l->metaint = strtol (p_metaint + strlen ("icy-metaint:"), NULL, 10);
+      ap_l->audio_left = ap_l->metaint;
+    }
+
+  ap_l->state = BENCH_STATE_STREAMING;
+  ap_l->streaming_since = a_now;
+  ap_l->play_start = a_now;
+  ap_l->play_base = ap_l->audio_bytes;
+  ap_l->last_data = a_now;
+
+  /* Slow listeners are read on the clock, not when data arrives */
+  if (BENCH_KIND_SLOW == ap_l->kind)
+    {
+      (void) epoll_ctl (g_epfd, EPOLL_CTL_DEL, ap_l->fd, NULL);
+    }
+  return true;
+}
+
+static void
+read_listener (bench_listener_t * ap_l, size_t a_budget, double a_now)
+{
+  static uint8_t buf[BENCH_HTTPR_READ_SIZE];
+
+  while (a_budget > 0 && ap_l->fd >= 0)
+    {
+      const uint8_t * p_data = buf;
+      size_t len = 0;
+      ssize_t bytes = recv (ap_l->fd, buf, BENCH_MIN (sizeof (buf), a_budget),
+                            MSG_DONTWAIT);
+      if (bytes < 0 && (EAGAIN == errno || EWOULDBLOCK == errno))
+        {
+          break;
+        }
+      if (bytes <= 0)
+        {
+          close_listener (ap_l, a_now, true);
+          break;
+        }
+
+      len = bytes;
+      a_budget -= len;
+      if (BENCH_STATE_HEADERS == ap_l->state
+          && !consume_headers (ap_l, &p_data, &len, a_now))
+        {
+          break;
+        }
+      if (BENCH_STATE_STREAMING == ap_l->state && len > 0)
+        {
+          const double gap = a_now - ap_l->last_data;
+          if (gap > ap_l->max_gap)
+            {
+              ap_l->max_gap = gap;
+            }
+          ap_l->last_data = a_now;
+          consume_body (ap_l, p_data, len, a_now);
+        }
+    }
+}
+
+static void
+tick_listeners (double a_now, double a_elapsed)
+{
+  const size_t slow_budget
+    = (size_t) (bytes_per_sec () * BENCH_HTTPR_SLOW_RATE * a_elapsed) + 1;
+  int i = 0;
+
+  for (i = 0; i < g_nlisteners; ++i)
+    {
+      bench_listener_t * p_l = &gp_listeners[i];
+      if (BENCH_STATE_IDLE == p_l->state && p_l->reconnect_at > 0
+          && a_now >= p_l->reconnect_at)
+        {
+          connect_listener (p_l, a_now);
+        }
+      else if (BENCH_KIND_SLOW == p_l->kind
+               && BENCH_STATE_STREAMING == p_l->state)
+        {
+          read_listener (p_l, slow_budget, a_now);
+        }
+    }
+}
+
+/*
+ * Reporting
+ */
+
+static int
+compare_doubles (const void * ap_a, const void * ap_b)
+{
+  const double a = *(const double *) ap_a;
+  const double b = *(const double *) ap_b;
+  return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+static double
+percentile (const double * ap_sorted, int a_count, double a_pct)
+{
+  int idx = 0;
+  if (0 == a_count)
+    {
+      return 0;
+    }
+  idx = (int) (a_pct / 100.0 * (a_count - 1) + 0.5);
+  return ap_sorted[idx];
+}
+
+static void
+sum_totals (bench_totals_t * ap_sums, int * ap_streaming, bench_kind_t a_kind)
+{
+  int i = 0;
+  memset (ap_sums, 0, sizeof (*ap_sums));
+  *ap_streaming = 0;
+  for (i = 0; i < g_nlisteners; ++i)
+    {
+      const bench_listener_t * p_l = &gp_listeners[i];
+      if (BENCH_KIND_MAX != a_kind && a_kind != p_l->kind)
+        {
+          continue;
+        }
+      ap_sums->bytes += p_l->totals.bytes;
+      ap_sums->stalls += p_l->totals.stalls;
+      ap_sums->drops += p_l->totals.drops;
+      ap_sums->rejects += p_l->totals.rejects;
+      ap_sums->failures += p_l->totals.failures;
+      ap_sums->titles += p_l->totals.titles;
+      if (BENCH_STATE_STREAMING == p_l->state)
+        {
+          (*ap_streaming)++;
+        }
+    }
+}
+
+typedef struct bench_sample bench_sample_t;
+struct bench_sample
+{
+  double time;
+  double server_cpu;
+  bench_totals_t totals;
+};
+
+static int
+take_sample (bench_sample_t * ap_sample, double a_now)
+{
+  int streaming = 0;
+  double own = cpu_clock (CLOCK_THREAD_CPUTIME_ID);
+  clockid_t feeder_clock;
+
+  if (g_omx.feeding && 0 == pthread_getcpuclockid (g_omx.feeder,
+                                                   &feeder_clock))
+    {
+      own += cpu_clock (feeder_clock);
+    }
+  ap_sample->time = a_now;
+  ap_sample->server_cpu = cpu_clock (CLOCK_PROCESS_CPUTIME_ID) - own;
+  sum_totals (&ap_sample->totals, &streaming, BENCH_KIND_MAX);
+  return streaming;
+}
+
+static void
+report_interval (bench_sample_t * ap_last, double a_start, long a_base_kb,
+                 double * ap_gaps)
+{
+  const double t = now ();
+  bench_sample_t sample;
+  double secs = 0;
+  double cpu = 0;
+  int streaming = 0;
+  int ngaps = 0;
+  long rss_kb = 0;
+  int i = 0;
+
+  streaming = take_sample (&sample, t);
+  secs = sample.time - ap_last->time;
+  cpu = secs > 0 ? (sample.server_cpu - ap_last->server_cpu) / secs : 0;
+
+  for (i = 0; i < g_nlisteners; ++i)
+    {
+      bench_listener_t * p_l = &gp_listeners[i];
+      if (BENCH_KIND_SLOW != p_l->kind && BENCH_STATE_STREAMING == p_l->state)
+        {
+          const double gap = t - p_l->last_data;
+          ap_gaps[ngaps++] = (gap > p_l->max_gap ? gap : p_l->max_gap) * 1000;
+        }
+      p_l->max_gap = 0;
+    }
+  qsort (ap_gaps, ngaps, sizeof (double), compare_doubles);
+  rss_kb = resident_kb ();
+
+  printf ("[%5.0fs] streaming %5d/%d  rx %7.2f MB/s (%6.2fx)  "
+          "gap p50 %5.0f p99 %5.0f max %5.0f ms  stalls %4u  "
+          "drops %4u  503s %4u  errs %4u  cpu %5.1f%% (%6.1f us/s/lstnr)  "
+          "rss %7.1f MB (%+.1f)\n",
+          t - a_start, streaming, g_nlisteners,
+          secs > 0 ? (sample.totals.bytes - ap_last->totals.bytes) / secs / 1e6
+                   : 0.0,
+          secs > 0 && streaming > 0
+            ? (sample.totals.bytes - ap_last->totals.bytes) / secs
+                / bytes_per_sec () / streaming
+            : 0.0,
+          percentile (ap_gaps, ngaps, 50), percentile (ap_gaps, ngaps, 99),
+          percentile (ap_gaps, ngaps, 100),
+          sample.totals.stalls - ap_last->totals.stalls,
+          sample.totals.drops - ap_last->totals.drops,
+          sample.totals.rejects - ap_last->totals.rejects,
+          sample.totals.failures - ap_last->totals.failures, cpu * 100,
+          streaming > 0 ? cpu * 1e6 / streaming : 0.0, rss_kb / 1024.0,
+          a_base_kb > 0 ? (rss_kb - a_base_kb) / 1024.0 : 0.0);
+  fflush (stdout);
+  *ap_last = sample;
+}
+
+static void
+report_summary (double a_elapsed, const bench_sample_t * ap_first,
+                const bench_sample_t * ap_last, long a_base_kb)
+{
+  int k = 0;
+
+  printf ("\n%-8s %9s %9s %12s %8s %7s %7s %7s %8s\n", "kind", "lstnrs",
+          "streaming", "rate (x nom)", "stalls", "drops", "503s", "errs",
+          "titles");
+  for (k = 0; k < BENCH_KIND_MAX; ++k)
+    {
+      bench_totals_t sums;
+      int streaming = 0;
+      int count = 0;
+      int i = 0;
+      for (i = 0; i < g_nlisteners; ++i)
+        {
+          count += (gp_listeners[i].kind == (bench_kind_t) k);
+        }
+      sum_totals (&sums, &streaming, (bench_kind_t) k);
+      printf ("%-8s %9d %9d %12.2f %8u %7u %7u %7u %8u\n", g_kind_names[k],
+              count, streaming,
+              count > 0 && a_elapsed > 0
+                ? sums.bytes / a_elapsed / bytes_per_sec () / count
+                : 0.0,
+              sums.stalls, sums.drops, sums.rejects, sums.failures,
+              sums.titles);
+    }
+
+  if (a_base_kb > 0 && ap_last->time > ap_first->time)
+    {
+      printf ("\nserver cpu %.1f%% of a core on average, "
+              "resident memory grew %+.1f MB after the first interval\n",
+              (ap_last->server_cpu - ap_first->server_cpu)
+                / (ap_last->time - ap_first->time) * 100,
+              (resident_kb () - a_base_kb) / 1024.0);
+    }
+}
+
+static void
+usage (const char * ap_prog)
+{
+  fprintf (stderr,
+           "Usage: %s [-p port] [-u mount] [-n listeners] [-s slow%%] "
+           "[-m metadata%%]\n"
+           "       [-b kbps] [-d seconds] [-i seconds] [-t seconds] [-r]\n\n"
+           "  -p  port the renderer listens on (%d)\n"
+           "  -u  mount point (/)\n"
+           "  -n  number of listeners (%d)\n"
+           "  -s  percentage of listeners that read at half the bitrate "
+           "(%d)\n"
+           "  -m  percentage of listeners that request ICY metadata (%d)\n"
+           "  -b  MP3 bitrate in kbps (%d)\n"
+           "  -d  duration of the run in seconds (%d)\n"
+           "  -i  report interval in seconds (%d)\n"
+           "  -t  seconds between stream title changes (%d)\n"
+           "  -r  reconnect dropped and rejected listeners (soak)\n",
+           ap_prog, BENCH_HTTPR_DEFAULT_PORT, BENCH_HTTPR_DEFAULT_LISTENERS,
+           BENCH_HTTPR_DEFAULT_SLOW_PCT, BENCH_HTTPR_DEFAULT_META_PCT,
+           BENCH_HTTPR_DEFAULT_BITRATE, BENCH_HTTPR_DEFAULT_DURATION,
+           BENCH_HTTPR_DEFAULT_INTERVAL, BENCH_HTTPR_DEFAULT_TITLE_PERIOD);
+}
+
+int
+main (int argc, char ** argv)
+{
+  struct epoll_event events[BENCH_HTTPR_MAX_EVENTS];
+  bench_sample_t first, last;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  int slow_pct = BENCH_HTTPR_DEFAULT_SLOW_PCT;
+  int meta_pct = BENCH_HTTPR_DEFAULT_META_PCT;
+  int duration = BENCH_HTTPR_DEFAULT_DURATION;
+  int interval = BENCH_HTTPR_DEFAULT_INTERVAL;
+  int title_period = BENCH_HTTPR_DEFAULT_TITLE_PERIOD;
+  unsigned int titles = 0;
+  double * p_gaps = NULL;
+  double start = 0, t = 0, last_tick = 0, next_report = 0, next_title = 0;
+  long base_kb = 0;
+  int opt = 0, i = 0;
+
+  while ((opt = getopt (argc, argv, "p:u:n:s:m:b:d:i:t:rh")) != -1)
+    {
+      switch (opt)
+        {
+          case 'p':
+            g_port = atoi (optarg);
+            break;
+          case 'u':
+            gp_mount = optarg;
+            break;
+          case 'n':
+            g_nlisteners = atoi (optarg);
+            break;
+          case 's':
+            slow_pct = atoi (optarg);
+            break;
+          case 'm':
+            meta_pct = atoi (optarg);
+            break;
+          case 'b':
+            g_bitrate = atoi (optarg);
+            break;
+          case 'd':
+            duration = atoi (optarg);
+            break;
+          case 'i':
+            interval = atoi (optarg);
+            break;
+          case 't':
+            title_period = atoi (optarg);
+            break;
+          case 'r':
+            g_reconnect = true;
+            break;
+          default:
+            usage (argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (g_port <= 0 || g_nlisteners <= 0 || slow_pct < 0 || meta_pct < 0
+      || slow_pct + meta_pct > 100 || duration <= 0 || interval <= 0
+      || '/' != gp_mount[0])
+    {
+      usage (argv[0]);
+      return EXIT_FAILURE;
+    }
+  if (!make_frame ())
+    {
+      fprintf (stderr, "%d kbps is not an MPEG-1 Layer III bitrate\n",
+               g_bitrate);
+      return EXIT_FAILURE;
+    }
+
+  gp_listeners = calloc (g_nlisteners, sizeof (bench_listener_t));
+  p_gaps = calloc (g_nlisteners, sizeof (double));
+  if (!gp_listeners || !p_gaps
+      || (g_epfd = epoll_create1 (EPOLL_CLOEXEC)) < 0)
+    {
+      perror ("bench_httpr");
+      return EXIT_FAILURE;
+    }
+
+  /* Each kind gets its share of the listeners */
+  for (i = 0; i < g_nlisteners; ++i)
+    {
+      const int slot = i * 100 / g_nlisteners;
+      gp_listeners[i].fd = -1;
+      gp_listeners[i].kind
+        = slot < slow_pct
+            ? BENCH_KIND_SLOW
+            : (slot < slow_pct + meta_pct ? BENCH_KIND_META : BENCH_KIND_NORMAL);
+    }
+
+  signal (SIGINT, on_signal);
+  signal (SIGTERM, on_signal);
+  signal (SIGPIPE, SIG_IGN);
+
+  if (OMX_ErrorNone != (rc = start_renderer ()))
+    {
+      fprintf (stderr, "Unable to start %s: error [0x%08x]\n",
+               BENCH_HTTPR_COMPONENT_NAME, (unsigned int) rc);
+      stop_renderer ();
+      return EXIT_FAILURE;
+    }
+
+  printf ("%d listeners (%d%% slow, %d%% icy) on http://127.0.0.1:%d%s, "
+          "%d kbps, %d s\n",
+          g_nlisteners, slow_pct, meta_pct, g_port, gp_mount, g_bitrate,
+          duration);
+
+  start = last_tick = now ();
+  for (i = 0; i < g_nlisteners; ++i)
+    {
+      connect_listener (&gp_listeners[i], start);
+    }
+  take_sample (&first, start);
+  last = first;
+  next_report = start + interval;
+  next_title = start + title_period;
+
+  while (!g_interrupted && (t = now ()) < start + duration)
+    {
+      const int n = epoll_wait (g_epfd, events, BENCH_HTTPR_MAX_EVENTS,
+                                (int) (BENCH_HTTPR_TICK_SECS * 1000));
+      t = now ();
+      for (i = 0; i < n; ++i)
+        {
+          bench_listener_t * p_l = events[i].data.ptr;
+          if (BENCH_STATE_CONNECTING == p_l->state)
+            {
+              send_request (p_l, t);
+            }
+          else if (BENCH_KIND_SLOW != p_l->kind
+                   || BENCH_STATE_STREAMING != p_l->state)
+            {
+              read_listener (p_l, SIZE_MAX, t);
+            }
+        }
+
+      if (t - last_tick >= BENCH_HTTPR_TICK_SECS)
+        {
+          tick_listeners (t, t - last_tick);
+          last_tick = t;
+        }
+
+      if (title_period > 0 && t >= next_title)
+        {
+          set_stream_title (++titles);
+          next_title += title_period;
+        }
+
+      if (t >= next_report)
+        {
+          report_interval (&last, start, base_kb, p_gaps);
+          if (0 == base_kb)
+            {
+              /* Growth is measured from the end of the first interval, once
+                 the ring and the listener buffers have been filled */
+              base_kb = resident_kb ();
+              first = last;
+            }
+          next_report += interval;
+        }
+    }
+
+  report_summary (now () - start, &first, &last, base_kb);
+
+  for (i = 0; i < g_nlisteners; ++i)
+    {
+      gp_listeners[i].reconnect_at = 0;
+      if (gp_listeners[i].fd >= 0)
+        {
+          close (gp_listeners[i].fd);
+        }
+    }
+  close (g_epfd);
+  stop_renderer ();
+  free (p_gaps);
+  free (gp_listeners);
+  return EXIT_SUCCESS;
+}
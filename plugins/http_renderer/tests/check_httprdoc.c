@@ -0,0 +1,209 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   check_httprdoc.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  HTTP renderer's document root unit tests
+ *
+ * Builds a small tree in a temporary directory:
+ *
+ *   root/a.mp3
+ *   root/inner -> a.mp3            (stays inside the root)
+ *   root/escape -> ../secret.mp3   (points outside the root)
+ *   root/sibling -> ../rootx/b.mp3 (outside, sharing the root's prefix)
+ *   secret.mp3
+ *   rootx/b.mp3
+ *
+ */
+
+#include <check.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../src/httprdoc.h"
+
+static char g_base[64];
+static char g_root[PATH_MAX];
+
+static void
+make_file (const char * ap_rel)
+{
+  char path[PATH_MAX];
+  FILE * p_file = NULL;
+  snprintf (path, sizeof (path), "%s/%s", g_base, ap_rel);
+  p_file = fopen (path, "w");
+  ck_assert (NULL != p_file);
+  fputs ("ID3", p_file);
+  fclose (p_file);
+}
+
+static void
+make_link (const char * ap_target, const char * ap_rel)
+{
+  char path[PATH_MAX];
+  snprintf (path, sizeof (path), "%s/%s", g_base, ap_rel);
+  ck_assert (0 == symlink (ap_target, path));
+}
+
+static void
+setup (void)
+{
+  char dir[PATH_MAX];
+  char * p_root = NULL;
+
+  snprintf (g_base, sizeof (g_base), "/tmp/check_httprdoc.XXXXXX");
+  ck_assert (NULL != mkdtemp (g_base));
+  snprintf (dir, sizeof (dir), "%s/root", g_base);
+  ck_assert (0 == mkdir (dir, 0755));
+  snprintf (dir, sizeof (dir), "%s/rootx", g_base);
+  ck_assert (0 == mkdir (dir, 0755));
+
+  make_file ("root/a.mp3");
+  make_file ("secret.mp3");
+  make_file ("rootx/b.mp3");
+  make_link ("a.mp3", "root/inner");
+  make_link ("../secret.mp3", "root/escape");
+  make_link ("../rootx/b.mp3", "root/sibling");
+
+  /* The root is given without a trailing slash */
+  snprintf (dir, sizeof (dir), "%s/root", g_base);
+  p_root = httpr_doc_canonical_root (dir);
+  ck_assert (NULL != p_root);
+  snprintf (g_root, sizeof (g_root), "%s", p_root);
+  free (p_root);
+}
+
+static void
+teardown (void)
+{
+  char cmd[PATH_MAX + 16];
+  snprintf (cmd, sizeof (cmd), "rm -rf '%s'", g_base);
+  ck_assert (0 == system (cmd));
+}
+
+static int
+try_open (const char * ap_url)
+{
+  char path[PATH_MAX];
+  struct stat st;
+  int fd = httpr_doc_open (g_root, ap_url, &st, path, sizeof (path));
+  if (fd >= 0)
+    {
+      close (fd);
+    }
+  return fd;
+}
+
+START_TEST (test_httprdoc_canonical_root)
+{
+  char dir[PATH_MAX];
+  char * p_root = NULL;
+
+  snprintf (dir, sizeof (dir), "%s/root//", g_base);
+  p_root = httpr_doc_canonical_root (dir);
+  ck_assert (NULL != p_root);
+  ck_assert (0 == strcmp (p_root, g_root));
+  ck_assert ('/' != p_root[strlen (p_root) - 1]);
+  free (p_root);
+
+  snprintf (dir, sizeof (dir), "%s/root/a.mp3", g_base);
+  ck_assert (NULL == httpr_doc_canonical_root (dir));
+  snprintf (dir, sizeof (dir), "%s/nowhere", g_base);
+  ck_assert (NULL == httpr_doc_canonical_root (dir));
+  ck_assert (NULL == httpr_doc_canonical_root (""));
+}
+END_TEST
+
+START_TEST (test_httprdoc_open_regular_file)
+{
+  ck_assert (try_open ("/a.mp3") >= 0);
+  ck_assert (try_open ("/a.mp3?t=1") >= 0);
+  ck_assert (try_open ("/%61.mp3") >= 0);
+  ck_assert (try_open ("/inner") >= 0);
+  ck_assert (try_open ("/missing.mp3") < 0);
+  ck_assert (try_open ("/") < 0);
+}
+END_TEST
+
+START_TEST (test_httprdoc_dot_dot)
+{
+  ck_assert (try_open ("/../secret.mp3") < 0);
+  ck_assert (try_open ("/..") < 0);
+  ck_assert (try_open ("/../root/a.mp3") < 0);
+}
+END_TEST
+
+START_TEST (test_httprdoc_encoded_dot_dot)
+{
+  ck_assert (try_open ("/..%2fsecret.mp3") < 0);
+  ck_assert (try_open ("/..%2Fsecret.mp3") < 0);
+  ck_assert (try_open ("/%2e%2e/secret.mp3") < 0);
+  ck_assert (try_open ("/%2e%2e%2fsecret.mp3") < 0);
+  ck_assert (try_open ("/a.mp3%00") < 0);
+}
+END_TEST
+
+START_TEST (test_httprdoc_symlink_escape)
+{
+  ck_assert (try_open ("/escape") < 0);
+  ck_assert (try_open ("/sibling") < 0);
+}
+END_TEST
+
+Suite *
+httprdoc_suite (void)
+{
+  TCase * tc_doc = NULL;
+  Suite * s = suite_create ("HTTP renderer document root");
+
+  tc_doc = tcase_create ("document root");
+  tcase_add_checked_fixture (tc_doc, setup, teardown);
+  tcase_add_test (tc_doc, test_httprdoc_canonical_root);
+  tcase_add_test (tc_doc, test_httprdoc_open_regular_file);
+  tcase_add_test (tc_doc, test_httprdoc_dot_dot);
+  tcase_add_test (tc_doc, test_httprdoc_encoded_dot_dot);
+  tcase_add_test (tc_doc, test_httprdoc_symlink_escape);
+  suite_add_tcase (s, tc_doc);
+
+  return s;
+}
+
+int
+main (void)
+{
+  int number_failed = 0;
+  SRunner * sr = srunner_create (httprdoc_suite ());
+  srunner_run_all (sr, CK_VERBOSE);
+  number_failed = srunner_ntests_failed (sr);
+  srunner_free (sr);
+  return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Local Variables: */
+/* c-default-style: gnu */
+/* fill-column: 79 */
+/* indent-tabs-mode: nil */
+/* compile-command: "make check" */
+/* End: */
@@ -43,6 +43,7 @@
 #include <tizscheduler.h>
 
 #include "httpsrc.h"
+#include "httpsrclookahead.h"
 #include "gmusicprc.h"
 #include "gmusicprc_decls.h"
 
@@ -86,7 +87,7 @@ is_valid_character (const char c)
   return (unsigned char) c > 0x20;
 }
 
-static void
+static OMX_S32
 obtain_coding_type (gmusic_prc_t * ap_prc, char * ap_info)
 {
   assert (ap_prc);
@@ -96,12 +97,9 @@ obtain_coding_type (gmusic_prc_t * ap_prc, char * ap_info)
       || strncasecmp (ap_info, "audio/mpg", 9) == 0
       || strncasecmp (ap_info, "audio/mp3", 9) == 0)
     {
-      ap_prc->audio_coding_type_ = OMX_AUDIO_CodingMP3;
-    }
-  else
-    {
-      ap_prc->audio_coding_type_ = OMX_AUDIO_CodingUnused;
+      return OMX_AUDIO_CodingMP3;
     }
+  return OMX_AUDIO_CodingUnused;
 }
 
 static int
@@ -132,15 +130,14 @@ convert_str_to_int (gmusic_prc_t * ap_prc, const char * ap_start,
   return val;
 }
 
-static void
+static OMX_U32
 obtain_content_length (gmusic_prc_t * ap_prc, char * ap_info)
 {
   char * p_end = NULL;
 
   assert (ap_prc);
   assert (ap_info);
-  ap_prc->content_length_bytes_ = convert_str_to_int (ap_prc, ap_info, &p_end);
-  ap_prc->bytes_before_eos_ = ap_prc->content_length_bytes_;
+  return convert_str_to_int (ap_prc, ap_info, &p_end);
 }
 
 static OMX_ERRORTYPE
@@ -262,13 +259,15 @@ obtain_audio_encoding_from_headers (gmusic_prc_t * ap_prc,
 
           if (strncasecmp (name, "Content-Type", 12) == 0)
             {
-              obtain_coding_type (ap_prc, p_info);
+              ap_prc->audio_coding_type_ = obtain_coding_type (ap_prc, p_info);
               /* Now set the new coding type value on the output port */
               (void) set_audio_coding_on_port (ap_prc);
             }
           else if (strncasecmp (name, "Content-Length", 14) == 0)
             {
-              obtain_content_length (ap_prc, p_info);
+              ap_prc->content_length_bytes_
+                = obtain_content_length (ap_prc, p_info);
+              ap_prc->bytes_before_eos_ = ap_prc->content_length_bytes_;
             }
           tiz_mem_free (p_info);
         }
@@ -365,58 +364,73 @@ update_metadata (gmusic_prc_t * ap_prc)
 }
 
 static OMX_ERRORTYPE
-obtain_next_url (gmusic_prc_t * ap_prc, int a_skip_value)
+alloc_uri_param (OMX_PARAM_CONTENTURITYPE ** app_uri_param)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
   const long pathname_max = PATH_MAX + NAME_MAX;
 
-  assert (ap_prc);
-  assert (ap_prc->p_gmusic_);
+  assert (app_uri_param);
 
-  if (!ap_prc->p_uri_param_)
+  if (!*app_uri_param)
     {
-      ap_prc->p_uri_param_ = tiz_mem_calloc (
+      *app_uri_param = tiz_mem_calloc (
         1, sizeof (OMX_PARAM_CONTENTURITYPE) + pathname_max + 1);
     }
 
-  tiz_check_null_ret_oom (ap_prc->p_uri_param_);
+  tiz_check_null_ret_oom (*app_uri_param);
 
-  ap_prc->p_uri_param_->nSize
+  (*app_uri_param)->nSize
     = sizeof (OMX_PARAM_CONTENTURITYPE) + pathname_max + 1;
-  ap_prc->p_uri_param_->nVersion.nVersion = OMX_VERSION;
+  (*app_uri_param)->nVersion.nVersion = OMX_VERSION;
+  return OMX_ErrorNone;
+}
 
-  {
-    const char * p_next_url = a_skip_value > 0
-                                ? tiz_gmusic_get_next_url (ap_prc->p_gmusic_)
-                                : tiz_gmusic_get_prev_url (ap_prc->p_gmusic_);
-    tiz_check_null_ret_oom (p_next_url);
+static OMX_ERRORTYPE
+store_url (gmusic_prc_t * ap_prc, OMX_PARAM_CONTENTURITYPE * ap_uri_param,
+           const char * ap_url)
+{
+  const long pathname_max = PATH_MAX + NAME_MAX;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
 
-    {
-      const OMX_U32 url_len = strnlen (p_next_url, pathname_max);
-      TIZ_TRACE (handleOf (ap_prc), "URL [%s]", p_next_url);
+  assert (ap_prc);
+  assert (ap_uri_param);
+  tiz_check_null_ret_oom (ap_url);
 
-      /* Verify we are getting an http scheme */
-      if (!p_next_url || !url_len
-          || (strncasecmp (p_next_url, "http://", 7) != 0
-              && strncasecmp (p_next_url, "https://", 8) != 0))
-        {
-          rc = OMX_ErrorContentURIError;
-        }
-      else
-        {
-          strncpy ((char *) ap_prc->p_uri_param_->contentURI, p_next_url,
-                   url_len);
-          ap_prc->p_uri_param_->contentURI[url_len] = '\0';
+  {
+    const OMX_U32 url_len = strnlen (ap_url, pathname_max);
+    TIZ_TRACE (handleOf (ap_prc), "URL [%s]", ap_url);
 
-          /* Song metadata is now available, update the IL client */
-          rc = update_metadata (ap_prc);
-        }
-    }
+    /* Verify we are getting an http scheme */
+    if (!url_len
+        || (strncasecmp (ap_url, "http://", 7) != 0
+            && strncasecmp (ap_url, "https://", 8) != 0))
+      {
+        rc = OMX_ErrorContentURIError;
+      }
+    else
+      {
+        strncpy ((char *) ap_uri_param->contentURI, ap_url, url_len);
+        ap_uri_param->contentURI[url_len] = '\0';
+      }
   }
-
   return rc;
 }
 
+static OMX_ERRORTYPE
+obtain_next_url (gmusic_prc_t * ap_prc, int a_skip_value)
+{
+  assert (ap_prc);
+  assert (ap_prc->p_gmusic_);
+
+  tiz_check_omx (alloc_uri_param (&(ap_prc->p_uri_param_)));
+  tiz_check_omx (store_url (ap_prc, ap_prc->p_uri_param_,
+                            a_skip_value > 0
+                              ? tiz_gmusic_get_next_url (ap_prc->p_gmusic_)
+                              : tiz_gmusic_get_prev_url (ap_prc->p_gmusic_)));
+
+  /* Song metadata is now available, update the IL client */
+  return update_metadata (ap_prc);
+}
+
 static OMX_ERRORTYPE
 release_buffer (gmusic_prc_t * ap_prc)
 {
@@ -536,11 +550,79 @@ connection_lost (OMX_PTR ap_arg)
 
   p_prc->connection_closed_ = true;
   p_prc->bytes_before_eos_ = tiz_urltrans_bytes_available (p_prc->p_trans_);
+
+  /* The current song has been fully downloaded (or the connection has
+     dropped); the network is idle, so this is a good time to start pre-rolling
+     the next item in the playlist. */
+  (void) httpsrc_lookahead_start (p_prc->p_lookahead_, p_prc->bitrate_);
+
   /* Return false to indicate that there is no need to start the automatic
      reconnection procedure */
   return false;
 }
 
+static const tiz_urltrans_buffer_cbacks_t main_buffer_cbacks
+  = {buffer_filled, buffer_emptied};
+static const tiz_urltrans_info_cbacks_t main_info_cbacks
+  = {header_available, data_available, connection_lost};
+
+static const char *
+lookahead_next_url (OMX_PTR ap_arg)
+{
+  gmusic_prc_t * p_prc = ap_arg;
+  assert (p_prc);
+  return tiz_gmusic_get_next_url (p_prc->p_gmusic_);
+}
+
+static void
+lookahead_rewind (OMX_PTR ap_arg)
+{
+  gmusic_prc_t * p_prc = ap_arg;
+  assert (p_prc);
+  (void) tiz_gmusic_get_prev_url (p_prc->p_gmusic_);
+}
+
+static void
+lookahead_release (OMX_PTR ap_arg, OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  gmusic_prc_t * p_prc = ap_arg;
+  assert (p_prc);
+  if (p_prc->p_outhdr_ == ap_hdr)
+    {
+      (void) release_buffer (p_prc);
+    }
+}
+
+static OMX_ERRORTYPE
+promote_lookahead (gmusic_prc_t * ap_prc)
+{
+  assert (ap_prc);
+
+  /* This replays the new song's headers (coding type and length) and, if
+     the song was pre-rolled in full, the end of its download, which starts
+     pre-rolling the song after it */
+  ap_prc->connection_closed_ = false;
+  tiz_check_omx (httpsrc_lookahead_promote (
+    ap_prc->p_lookahead_, &(ap_prc->p_trans_), &(ap_prc->p_uri_param_),
+    main_buffer_cbacks, main_info_cbacks, ap_prc->cache_bytes_));
+
+  /* Song metadata is now available, update the IL client */
+  tiz_check_omx (update_metadata (ap_prc));
+
+  if (ap_prc->port_disabled_)
+    {
+      /* Record that the pre-rolled data needs to be delivered when the port
+         is re-enabled */
+      ap_prc->uri_changed_ = false;
+      ap_prc->lookahead_promoted_ = true;
+      return OMX_ErrorNone;
+    }
+
+  /* Deliver what has been pre-rolled so far (this also resumes the transfer
+     if it was paused) */
+  return tiz_urltrans_on_buffers_ready (ap_prc->p_trans_);
+}
+
 static OMX_ERRORTYPE
 prepare_for_port_auto_detection (gmusic_prc_t * ap_prc)
 {
@@ -678,6 +760,7 @@ gmusic_prc_ctor (void * ap_obj, va_list * app)
   p_prc->p_outhdr_ = NULL;
   p_prc->p_uri_param_ = NULL;
   p_prc->p_trans_ = NULL;
+  p_prc->p_lookahead_ = NULL;
   p_prc->p_gmusic_ = NULL;
   p_prc->eos_ = false;
   p_prc->port_disabled_ = false;
@@ -691,6 +774,7 @@ gmusic_prc_ctor (void * ap_obj, va_list * app)
   p_prc->bitrate_ = ARATELIA_HTTP_SOURCE_DEFAULT_BIT_RATE_KBITS;
   update_cache_size (p_prc);
   p_prc->connection_closed_ = false;
+  p_prc->lookahead_promoted_ = false;
   return p_prc;
 }
 
@@ -728,10 +812,6 @@ gmusic_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
   tiz_check_omx (obtain_next_url (p_prc, 1));
 
   {
-    const tiz_urltrans_buffer_cbacks_t buffer_cbacks
-      = {buffer_filled, buffer_emptied};
-    const tiz_urltrans_info_cbacks_t info_cbacks
-      = {header_available, data_available, connection_lost};
     const tiz_urltrans_event_io_cbacks_t io_cbacks
       = {tiz_srv_io_watcher_init, tiz_srv_io_watcher_destroy,
          tiz_srv_io_watcher_start, tiz_srv_io_watcher_stop};
@@ -739,12 +819,23 @@ gmusic_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
       = {tiz_srv_timer_watcher_init, tiz_srv_timer_watcher_destroy,
          tiz_srv_timer_watcher_start, tiz_srv_timer_watcher_stop,
          tiz_srv_timer_watcher_restart};
-    rc
-      = tiz_urltrans_init (&(p_prc->p_trans_), p_prc, p_prc->p_uri_param_,
-                           ARATELIA_HTTP_SOURCE_COMPONENT_NAME,
-                           ARATELIA_HTTP_SOURCE_PORT_MIN_BUF_SIZE,
-                           ARATELIA_HTTP_SOURCE_DEFAULT_RECONNECT_TIMEOUT,
-                           buffer_cbacks, info_cbacks, io_cbacks, timer_cbacks);
+    rc = tiz_urltrans_init (
+      &(p_prc->p_trans_), p_prc, p_prc->p_uri_param_,
+      ARATELIA_HTTP_SOURCE_COMPONENT_NAME,
+      ARATELIA_HTTP_SOURCE_PORT_MIN_BUF_SIZE,
+      ARATELIA_HTTP_SOURCE_DEFAULT_RECONNECT_TIMEOUT, main_buffer_cbacks,
+      main_info_cbacks, io_cbacks, timer_cbacks);
+
+    if (OMX_ErrorNone == rc)
+      {
+        /* A second transfer object is used to pre-roll the next song while
+           the current one is still playing */
+        const httpsrc_lookahead_cbacks_t lookahead_cbacks
+          = {lookahead_next_url, lookahead_rewind, lookahead_release};
+        rc = httpsrc_lookahead_init (&(p_prc->p_lookahead_), p_prc,
+                                     lookahead_cbacks, io_cbacks,
+                                     timer_cbacks);
+      }
   }
   return rc;
 }
@@ -756,6 +847,8 @@ gmusic_prc_deallocate_resources (void * ap_prc)
   assert (p_prc);
   tiz_urltrans_destroy (p_prc->p_trans_);
   p_prc->p_trans_ = NULL;
+  httpsrc_lookahead_destroy (p_prc->p_lookahead_);
+  p_prc->p_lookahead_ = NULL;
   delete_uri (p_prc);
   tiz_gmusic_destroy (p_prc->p_gmusic_);
   p_prc->p_gmusic_ = NULL;
@@ -768,6 +861,8 @@ gmusic_prc_prepare_to_transfer (void * ap_prc, OMX_U32 a_pid)
   gmusic_prc_t * p_prc = ap_prc;
   assert (ap_prc);
   p_prc->eos_ = false;
+  p_prc->lookahead_promoted_ = false;
+  httpsrc_lookahead_discard (p_prc->p_lookahead_);
   tiz_urltrans_cancel (p_prc->p_trans_);
   tiz_urltrans_set_internal_buffer_size (p_prc->p_trans_, p_prc->cache_bytes_);
   return prepare_for_port_auto_detection (p_prc);
@@ -797,6 +892,7 @@ gmusic_prc_stop_and_return (void * ap_prc)
       tiz_urltrans_pause (p_prc->p_trans_);
       tiz_urltrans_flush_buffer (p_prc->p_trans_);
     }
+  httpsrc_lookahead_discard (p_prc->p_lookahead_);
   return release_buffer (p_prc);
 }
 
@@ -819,6 +915,8 @@ gmusic_prc_io_ready (void * ap_prc, tiz_event_io_t * ap_ev_io, int a_fd,
   gmusic_prc_t * p_prc = ap_prc;
   /*   OMX_ERRORTYPE rc = OMX_ErrorNone; */
   assert (p_prc);
+  tiz_check_omx (httpsrc_lookahead_on_io_ready (p_prc->p_lookahead_, ap_ev_io,
+                                                a_fd, a_events));
    return tiz_urltrans_on_io_ready (p_prc->p_trans_, ap_ev_io, a_fd, a_events);
 /*   rc = tiz_urltrans_on_io_ready (p_prc->p_trans_, ap_ev_io, a_fd, a_events); */
 /*   if (p_prc->connection_closed_ && tiz_urltrans_handshake_error_found(p_prc->p_trans_)) */
@@ -836,6 +934,8 @@ gmusic_prc_timer_ready (void * ap_prc, tiz_event_timer_t * ap_ev_timer,
 {
   gmusic_prc_t * p_prc = ap_prc;
   assert (p_prc);
+  tiz_check_omx (
+    httpsrc_lookahead_on_timer_ready (p_prc->p_lookahead_, ap_ev_timer));
   return tiz_urltrans_on_timer_ready (p_prc->p_trans_, ap_ev_timer);
 }
 
@@ -890,7 +990,13 @@ gmusic_prc_port_enable (const void * ap_prc, OMX_U32 a_pid)
   if (p_prc->port_disabled_)
     {
       p_prc->port_disabled_ = false;
-      if (!p_prc->uri_changed_)
+      if (p_prc->lookahead_promoted_)
+        {
+          /* Deliver the pre-rolled data of the new song */
+          p_prc->lookahead_promoted_ = false;
+          rc = tiz_urltrans_on_buffers_ready (p_prc->p_trans_);
+        }
+      else if (!p_prc->uri_changed_)
         {
           rc = tiz_urltrans_unpause (p_prc->p_trans_);
         }
@@ -919,6 +1025,17 @@ gmusic_prc_config_change (void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid),
       tiz_check_omx (tiz_api_GetConfig (
         tiz_get_krn (handleOf (p_prc)), handleOf (p_prc),
         OMX_TizoniaIndexConfigPlaylistSkip, &p_prc->playlist_skip_));
+
+      if (p_prc->playlist_skip_.nValue > 0
+          && httpsrc_lookahead_ready (p_prc->p_lookahead_))
+        {
+          /* The next song has already been pre-rolled; no need to
+             re-connect */
+          return promote_lookahead (p_prc);
+        }
+
+      httpsrc_lookahead_discard (p_prc->p_lookahead_);
+      p_prc->lookahead_promoted_ = false;
       p_prc->playlist_skip_.nValue > 0 ? obtain_next_url (p_prc, 1)
                                        : obtain_next_url (p_prc, -1);
       /* Changing the URL has the side effect of halting the current
@@ -41,6 +41,8 @@ extern "C" {
 
 #include <tizplatform.h>
 
+#include "httpsrclookahead.h"
+
 typedef struct gmusic_prc gmusic_prc_t;
 struct gmusic_prc
 {
@@ -52,6 +54,7 @@ struct gmusic_prc
   OMX_TIZONIA_PLAYLISTSKIPTYPE playlist_skip_;
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   tiz_urltrans_t * p_trans_;
+  httpsrc_lookahead_t * p_lookahead_;
   tiz_gmusic_t * p_gmusic_;
   bool eos_;
   bool port_disabled_;
@@ -65,6 +68,7 @@ struct gmusic_prc
   int bitrate_;
   int cache_bytes_;
   bool connection_closed_;
+  bool lookahead_promoted_;
 };
 
 typedef struct gmusic_prc_class gmusic_prc_class_t;
@@ -57,6 +57,7 @@ extern "C" {
 #define ARATELIA_HTTP_SOURCE_DEFAULT_RECONNECT_TIMEOUT 3.0F
 #define ARATELIA_HTTP_SOURCE_DEFAULT_BIT_RATE_KBITS 128
 #define ARATELIA_HTTP_SOURCE_DEFAULT_CACHE_SECONDS 20
+#define ARATELIA_HTTP_SOURCE_DEFAULT_LOOKAHEAD_SECONDS 10
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,401 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   httpsrclookahead.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - HTTP source: pre-rolling of the next playlist item
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tizplatform.h>
+
+#include <tizkernel.h>
+#include <tizscheduler.h>
+
+#include "httpsrc.h"
+#include "httpsrclookahead.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.http_source.lookahead"
+#endif
+
+/* Initial size of the store for the pre-rolled item's headers (it grows if
+   needed) */
+#define HTTPSRC_LOOKAHEAD_HEADERS_SIZE 4096
+
+struct httpsrc_lookahead
+{
+  void * p_prc_; /* not owned */
+  httpsrc_lookahead_cbacks_t cbacks_;
+  tiz_urltrans_t * p_trans_;
+  OMX_PARAM_CONTENTURITYPE * p_uri_param_;
+  /* The pre-rolled item's HTTP headers, each one stored as its length (a
+     size_t) followed by its bytes */
+  tiz_buffer_t * p_headers_;
+  int seconds_;
+  bool ready_;
+  bool closed_;
+};
+
+static void
+lookahead_buffer_filled (OMX_BUFFERHEADERTYPE * ap_hdr, void * ap_arg)
+{
+  httpsrc_lookahead_t * p_la = ap_arg;
+  assert (p_la);
+  assert (ap_hdr);
+  /* The transfer only fills the buffers that lookahead_buffer_emptied hands
+     out, so this is not expected. Should a port buffer ever get here, give
+     it back to the processor, so that it isn't lost */
+  TIZ_WARN (handleOf (p_la->p_prc_), "Look-ahead transfer filled HEADER [%p]",
+            ap_hdr);
+  p_la->cbacks_.pf_release (p_la->p_prc_, ap_hdr);
+}
+
+static OMX_BUFFERHEADERTYPE *
+lookahead_buffer_emptied (OMX_PTR TIZ_UNUSED (ap_arg))
+{
+  /* The data accumulates in the transfer's internal store until the
+     transfer is promoted */
+  return NULL;
+}
+
+static void
+lookahead_header_available (OMX_PTR ap_arg, const void * ap_ptr,
+                            const size_t a_nbytes)
+{
+  httpsrc_lookahead_t * p_la = ap_arg;
+  assert (p_la);
+  assert (ap_ptr);
+  (void) tiz_buffer_push (p_la->p_headers_, &a_nbytes, sizeof (a_nbytes));
+  (void) tiz_buffer_push (p_la->p_headers_, ap_ptr, a_nbytes);
+}
+
+static bool
+lookahead_data_available (OMX_PTR TIZ_UNUSED (ap_arg),
+                          const void * TIZ_UNUSED (ap_ptr),
+                          const size_t TIZ_UNUSED (a_nbytes))
+{
+  /* No need to pause; the transfer pauses by itself when its store is
+     full */
+  return false;
+}
+
+static bool
+lookahead_connection_lost (OMX_PTR ap_arg)
+{
+  httpsrc_lookahead_t * p_la = ap_arg;
+  assert (p_la);
+  p_la->closed_ = true;
+  return false;
+}
+
+static const tiz_urltrans_buffer_cbacks_t lookahead_buffer_cbacks
+  = {lookahead_buffer_filled, lookahead_buffer_emptied};
+static const tiz_urltrans_info_cbacks_t lookahead_info_cbacks
+  = {lookahead_header_available, lookahead_data_available,
+     lookahead_connection_lost};
+
+static OMX_ERRORTYPE
+store_url (httpsrc_lookahead_t * ap_la, const char * ap_url)
+{
+  const long pathname_max = PATH_MAX + NAME_MAX;
+  OMX_U32 url_len = 0;
+
+  assert (ap_la);
+
+  if (!ap_url)
+    {
+      return OMX_ErrorNoMore;
+    }
+
+  url_len = strnlen (ap_url, pathname_max);
+  /* Verify we are getting an http scheme */
+  if (!url_len
+      || (strncasecmp (ap_url, "http://", 7) != 0
+          && strncasecmp (ap_url, "https://", 8) != 0))
+    {
+      return OMX_ErrorContentURIError;
+    }
+
+  strncpy ((char *) ap_la->p_uri_param_->contentURI, ap_url, url_len);
+  ap_la->p_uri_param_->contentURI[url_len] = '\0';
+  return OMX_ErrorNone;
+}
+
+static void
+replay_headers (httpsrc_lookahead_t * ap_la, void * ap_prc,
+                const tiz_urltrans_info_cbacks_t * ap_info_cbacks)
+{
+  const char * p_next = NULL;
+  int left = 0;
+
+  assert (ap_la);
+  assert (ap_info_cbacks);
+
+  p_next = tiz_buffer_get (ap_la->p_headers_);
+  left = tiz_buffer_available (ap_la->p_headers_);
+  while (left >= (int) sizeof (size_t))
+    {
+      size_t len = 0;
+      memcpy (&len, p_next, sizeof (len));
+      p_next += sizeof (len);
+      left -= sizeof (len);
+      assert (left >= (int) len);
+      ap_info_cbacks->pf_header_avail (ap_prc, p_next, len);
+      p_next += len;
+      left -= len;
+    }
+  tiz_buffer_clear (ap_la->p_headers_);
+}
+
+OMX_ERRORTYPE
+httpsrc_lookahead_init (httpsrc_lookahead_ptr_t * app_lookahead, void * ap_prc,
+                        const httpsrc_lookahead_cbacks_t a_cbacks,
+                        const tiz_urltrans_event_io_cbacks_t a_io_cbacks,
+                        const tiz_urltrans_event_timer_cbacks_t a_timer_cbacks)
+{
+  const long pathname_max = PATH_MAX + NAME_MAX;
+  httpsrc_lookahead_t * p_la = NULL;
+  const char * p_seconds = NULL;
+  int seconds = ARATELIA_HTTP_SOURCE_DEFAULT_LOOKAHEAD_SECONDS;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (app_lookahead);
+  assert (ap_prc);
+  assert (a_cbacks.pf_next_url);
+  assert (a_cbacks.pf_rewind);
+  assert (a_cbacks.pf_release);
+
+  *app_lookahead = NULL;
+
+  p_seconds
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_source.http.lookahead_seconds");
+  if (p_seconds)
+    {
+      seconds = MAX (0, atoi (p_seconds));
+    }
+  TIZ_TRACE (handleOf (ap_prc), "Look-ahead seconds [%d]", seconds);
+  if (0 == seconds)
+    {
+      return OMX_ErrorNone;
+    }
+
+  p_la = tiz_mem_calloc (1, sizeof (httpsrc_lookahead_t));
+  tiz_check_null_ret_oom (p_la);
+  p_la->p_prc_ = ap_prc;
+  p_la->cbacks_ = a_cbacks;
+  p_la->seconds_ = seconds;
+
+  p_la->p_uri_param_
+    = tiz_mem_calloc (1, sizeof (OMX_PARAM_CONTENTURITYPE) + pathname_max + 1);
+  if (!p_la->p_uri_param_)
+    {
+      rc = OMX_ErrorInsufficientResources;
+      goto end;
+    }
+  p_la->p_uri_param_->nSize
+    = sizeof (OMX_PARAM_CONTENTURITYPE) + pathname_max + 1;
+  p_la->p_uri_param_->nVersion.nVersion = OMX_VERSION;
+
+  if (OMX_ErrorNone
+      != (rc = tiz_buffer_init (&(p_la->p_headers_),
+                                HTTPSRC_LOOKAHEAD_HEADERS_SIZE)))
+    {
+      goto end;
+    }
+
+  /* The io and timer watchers belong to the processor; the buffer and info
+     callbacks are the look-ahead's own */
+  if (OMX_ErrorNone
+      == (rc = tiz_urltrans_init (
+            &(p_la->p_trans_), ap_prc, p_la->p_uri_param_,
+            ARATELIA_HTTP_SOURCE_COMPONENT_NAME,
+            ARATELIA_HTTP_SOURCE_PORT_MIN_BUF_SIZE,
+            ARATELIA_HTTP_SOURCE_DEFAULT_RECONNECT_TIMEOUT,
+            lookahead_buffer_cbacks, lookahead_info_cbacks, a_io_cbacks,
+            a_timer_cbacks)))
+    {
+      tiz_urltrans_set_cbacks (p_la->p_trans_, p_la, lookahead_buffer_cbacks,
+                               lookahead_info_cbacks);
+    }
+
+end:
+
+  if (OMX_ErrorNone != rc)
+    {
+      httpsrc_lookahead_destroy (p_la);
+      p_la = NULL;
+    }
+
+  *app_lookahead = p_la;
+  return rc;
+}
+
+void
+httpsrc_lookahead_destroy (httpsrc_lookahead_t * ap_lookahead)
+{
+  if (ap_lookahead)
+    {
+      tiz_urltrans_destroy (ap_lookahead->p_trans_);
+      tiz_buffer_destroy (ap_lookahead->p_headers_);
+      tiz_mem_free (ap_lookahead->p_uri_param_);
+      tiz_mem_free (ap_lookahead);
+    }
+}
+
+OMX_ERRORTYPE
+httpsrc_lookahead_start (httpsrc_lookahead_t * ap_lookahead,
+                         const int a_bitrate_kbits)
+{
+  httpsrc_lookahead_t * p_la = ap_lookahead;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  if (!p_la || p_la->ready_)
+    {
+      return OMX_ErrorNone;
+    }
+
+  rc = store_url (p_la, p_la->cbacks_.pf_next_url (p_la->p_prc_));
+  if (OMX_ErrorNone != rc)
+    {
+      /* Undo the playlist position change; the regular skip path will deal
+         with this item */
+      p_la->cbacks_.pf_rewind (p_la->p_prc_);
+      return OMX_ErrorNoMore == rc ? OMX_ErrorNone : rc;
+    }
+
+  TIZ_TRACE (handleOf (p_la->p_prc_), "Pre-rolling [%s]",
+             p_la->p_uri_param_->contentURI);
+  p_la->ready_ = true;
+  p_la->closed_ = false;
+  tiz_buffer_clear (p_la->p_headers_);
+  tiz_urltrans_set_uri (p_la->p_trans_, p_la->p_uri_param_);
+  /* The transfer pauses itself when twice the internal buffer size has been
+     stored */
+  tiz_urltrans_set_internal_buffer_size (
+    p_la->p_trans_,
+    MAX (1, ((a_bitrate_kbits * 1000) / 8) * p_la->seconds_ / 2));
+  return tiz_urltrans_start (p_la->p_trans_);
+}
+
+bool
+httpsrc_lookahead_ready (const httpsrc_lookahead_t * ap_lookahead)
+{
+  return ap_lookahead && ap_lookahead->ready_;
+}
+
+void
+httpsrc_lookahead_discard (httpsrc_lookahead_t * ap_lookahead)
+{
+  if (httpsrc_lookahead_ready (ap_lookahead))
+    {
+      tiz_urltrans_cancel (ap_lookahead->p_trans_);
+      tiz_urltrans_flush_buffer (ap_lookahead->p_trans_);
+      tiz_buffer_clear (ap_lookahead->p_headers_);
+      ap_lookahead->ready_ = false;
+      /* The playlist position was advanced when the pre-roll started */
+      ap_lookahead->cbacks_.pf_rewind (ap_lookahead->p_prc_);
+    }
+}
+
+OMX_ERRORTYPE
+httpsrc_lookahead_promote (httpsrc_lookahead_t * ap_lookahead,
+                           tiz_urltrans_t ** app_trans,
+                           OMX_PARAM_CONTENTURITYPE ** app_uri_param,
+                           const tiz_urltrans_buffer_cbacks_t a_buffer_cbacks,
+                           const tiz_urltrans_info_cbacks_t a_info_cbacks,
+                           const int a_cache_bytes)
+{
+  httpsrc_lookahead_t * p_la = ap_lookahead;
+  tiz_urltrans_t * p_trans = NULL;
+  OMX_PARAM_CONTENTURITYPE * p_uri_param = NULL;
+
+  assert (app_trans);
+  assert (app_uri_param);
+  assert (httpsrc_lookahead_ready (p_la));
+
+  TIZ_TRACE (handleOf (p_la->p_prc_), "Promoting pre-rolled [%s] - [%u] bytes",
+             p_la->p_uri_param_->contentURI,
+             tiz_urltrans_bytes_available (p_la->p_trans_));
+
+  /* Retire the current transfer; it becomes the next look-ahead transfer */
+  p_trans = *app_trans;
+  p_uri_param = *app_uri_param;
+  tiz_urltrans_cancel (p_trans);
+  tiz_urltrans_flush_buffer (p_trans);
+  tiz_urltrans_set_cbacks (p_trans, p_la, lookahead_buffer_cbacks,
+                           lookahead_info_cbacks);
+
+  *app_trans = p_la->p_trans_;
+  *app_uri_param = p_la->p_uri_param_;
+  p_la->p_trans_ = p_trans;
+  p_la->p_uri_param_ = p_uri_param;
+  p_la->ready_ = false;
+
+  tiz_urltrans_set_cbacks (*app_trans, p_la->p_prc_, a_buffer_cbacks,
+                           a_info_cbacks);
+  tiz_urltrans_set_internal_buffer_size (*app_trans, a_cache_bytes);
+
+  /* The processor hasn't seen the new item's headers yet */
+  replay_headers (p_la, p_la->p_prc_, &a_info_cbacks);
+
+  if (p_la->closed_)
+    {
+      /* The whole item was pre-rolled; the processor won't be told that its
+         download has ended unless it is done here */
+      p_la->closed_ = false;
+      (void) a_info_cbacks.pf_connection_lost (p_la->p_prc_);
+    }
+
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+httpsrc_lookahead_on_io_ready (httpsrc_lookahead_t * ap_lookahead,
+                               tiz_event_io_t * ap_ev_io, int a_fd,
+                               int a_events)
+{
+  return httpsrc_lookahead_ready (ap_lookahead)
+           ? tiz_urltrans_on_io_ready (ap_lookahead->p_trans_, ap_ev_io, a_fd,
+                                       a_events)
+           : OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+httpsrc_lookahead_on_timer_ready (httpsrc_lookahead_t * ap_lookahead,
+                                  tiz_event_timer_t * ap_ev_timer)
+{
+  return httpsrc_lookahead_ready (ap_lookahead)
+           ? tiz_urltrans_on_timer_ready (ap_lookahead->p_trans_, ap_ev_timer)
+           : OMX_ErrorNone;
+}
@@ -0,0 +1,152 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   httpsrclookahead.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - HTTP source: pre-rolling of the next playlist item
+ *
+ * A second URL transfer that downloads the first seconds of the next item in
+ * a service's playlist while the current item plays. On skip, the processor
+ * promotes it to be its main transfer, so that playback continues without a
+ * new DNS/TLS/HTTP round-trip.
+ *
+ */
+
+#ifndef HTTPSRCLOOKAHEAD_H
+#define HTTPSRCLOOKAHEAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+#include <tizplatform.h>
+
+typedef struct httpsrc_lookahead httpsrc_lookahead_t;
+typedef /*@null@ */ httpsrc_lookahead_t * httpsrc_lookahead_ptr_t;
+
+/**
+ * Moves the service's playlist to the next item and returns its URL, or NULL
+ * if there isn't one.
+ */
+typedef const char * (*httpsrc_lookahead_next_url_f) (OMX_PTR ap_prc);
+
+/**
+ * Moves the service's playlist back to the item that was current before the
+ * last call to the next_url callback.
+ */
+typedef void (*httpsrc_lookahead_rewind_f) (OMX_PTR ap_prc);
+
+/**
+ * Hands back to the processor a port buffer that the pre-roll transfer
+ * should never have been given, so that it can be released downstream.
+ */
+typedef void (*httpsrc_lookahead_release_f) (OMX_PTR ap_prc,
+                                             OMX_BUFFERHEADERTYPE * ap_hdr);
+
+typedef struct httpsrc_lookahead_cbacks httpsrc_lookahead_cbacks_t;
+struct httpsrc_lookahead_cbacks
+{
+  httpsrc_lookahead_next_url_f pf_next_url;
+  httpsrc_lookahead_rewind_f pf_rewind;
+  httpsrc_lookahead_release_f pf_release;
+};
+
+/**
+ * Creates the look-ahead object of a processor. The look-ahead length is
+ * read from OMX.Aratelia.audio_source.http.lookahead_seconds; when it is 0,
+ * no object is created and *app_lookahead is set to NULL. All the other
+ * functions accept a NULL look-ahead object, and do nothing with it.
+ *
+ * @param ap_prc The processor; the next_url and rewind callbacks, and the
+ * transfer's io and timer callbacks, receive it.
+ */
+OMX_ERRORTYPE
+httpsrc_lookahead_init (httpsrc_lookahead_ptr_t * app_lookahead, void * ap_prc,
+                        const httpsrc_lookahead_cbacks_t a_cbacks,
+                        const tiz_urltrans_event_io_cbacks_t a_io_cbacks,
+                        const tiz_urltrans_event_timer_cbacks_t a_timer_cbacks);
+
+void
+httpsrc_lookahead_destroy (httpsrc_lookahead_t * ap_lookahead);
+
+/**
+ * Starts pre-rolling the next item, at most the configured number of seconds
+ * at @a a_bitrate_kbits. Does nothing if an item is already being
+ * pre-rolled. Meant to be called once the current item has been downloaded
+ * in full, i.e. from the processor's connection_lost callback.
+ */
+OMX_ERRORTYPE
+httpsrc_lookahead_start (httpsrc_lookahead_t * ap_lookahead,
+                         const int a_bitrate_kbits);
+
+/**
+ * Returns true if the next item is being (or has been) pre-rolled.
+ */
+bool
+httpsrc_lookahead_ready (const httpsrc_lookahead_t * ap_lookahead);
+
+/**
+ * Cancels the pre-roll, and moves the service's playlist back to the current
+ * item.
+ */
+void
+httpsrc_lookahead_discard (httpsrc_lookahead_t * ap_lookahead);
+
+/**
+ * Swaps the processor's main transfer (and its uri) with the pre-rolled one.
+ * The former main transfer is cancelled, and kept for the next pre-roll.
+ *
+ * The pre-rolled item's HTTP headers are passed on to the processor's
+ * header_avail callback, as the processor missed them. If the pre-rolled
+ * download has already completed, the processor's connection_lost callback
+ * is invoked too (which usually starts the next pre-roll). The pre-rolled
+ * data itself is delivered by the next tiz_urltrans_on_buffers_ready call on
+ * the (new) main transfer.
+ *
+ * @param a_cache_bytes The internal buffer size of the main transfer.
+ */
+OMX_ERRORTYPE
+httpsrc_lookahead_promote (httpsrc_lookahead_t * ap_lookahead,
+                           tiz_urltrans_t ** app_trans,
+                           OMX_PARAM_CONTENTURITYPE ** app_uri_param,
+                           const tiz_urltrans_buffer_cbacks_t a_buffer_cbacks,
+                           const tiz_urltrans_info_cbacks_t a_info_cbacks,
+                           const int a_cache_bytes);
+
+OMX_ERRORTYPE
+httpsrc_lookahead_on_io_ready (httpsrc_lookahead_t * ap_lookahead,
+                               tiz_event_io_t * ap_ev_io, int a_fd,
+                               int a_events);
+
+OMX_ERRORTYPE
+httpsrc_lookahead_on_timer_ready (httpsrc_lookahead_t * ap_lookahead,
+                                  tiz_event_timer_t * ap_ev_timer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTPSRCLOOKAHEAD_H */
@@ -43,6 +43,7 @@
 #include <tizscheduler.h>
 
 #include "httpsrc.h"
+#include "httpsrclookahead.h"
 #include "plexprc.h"
 #include "plexprc_decls.h"
 
@@ -618,6 +619,11 @@ connection_lost (OMX_PTR ap_arg)
     p_prc->bytes_before_eos_, p_prc->content_length_bytes_);
 
   p_prc->connection_closed_ = true;
+  /* The current track has been fully downloaded (or the connection has
+     dropped); the network is idle, so this is a good time to start
+     pre-rolling the next item in the playlist. */
+  (void) httpsrc_lookahead_start (p_prc->p_lookahead_, p_prc->bitrate_);
+
   /* Return false to indicate that there is no need to start the automatic
      reconnection procedure */
   return false;
@@ -714,6 +720,86 @@ enqueue_playlist_items (plex_prc_t * ap_prc)
   return (rc == 0 ? OMX_ErrorNone : OMX_ErrorInsufficientResources);
 }
 
+static const tiz_urltrans_buffer_cbacks_t main_buffer_cbacks
+  = {buffer_filled, buffer_emptied};
+static const tiz_urltrans_info_cbacks_t main_info_cbacks
+  = {header_available, data_available, connection_lost};
+
+static const char *
+lookahead_next_url (OMX_PTR ap_arg)
+{
+  plex_prc_t * p_prc = ap_arg;
+  assert (p_prc);
+  return tiz_plex_get_next_url (p_prc->p_plex_, false);
+}
+
+static void
+lookahead_rewind (OMX_PTR ap_arg)
+{
+  plex_prc_t * p_prc = ap_arg;
+  assert (p_prc);
+  (void) tiz_plex_get_prev_url (p_prc->p_plex_, false);
+}
+
+static void
+lookahead_release (OMX_PTR ap_arg, OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  plex_prc_t * p_prc = ap_arg;
+  assert (p_prc);
+  if (p_prc->p_outhdr_ == ap_hdr)
+    {
+      (void) release_buffer (p_prc);
+    }
+}
+
+static OMX_ERRORTYPE
+promote_lookahead (plex_prc_t * ap_prc)
+{
+  assert (ap_prc);
+
+  ap_prc->content_length_bytes_ = 0;
+  ap_prc->connection_closed_ = false;
+
+  /* Get ready to auto-detect the new stream */
+  set_auto_detect_on_port (ap_prc);
+  prepare_for_port_auto_detection (ap_prc);
+
+  /* This replays the new track's headers and, if it was pre-rolled in full,
+     the end of its download, which starts pre-rolling the item after it */
+  tiz_check_omx (httpsrc_lookahead_promote (
+    ap_prc->p_lookahead_, &(ap_prc->p_trans_), &(ap_prc->p_uri_param_),
+    main_buffer_cbacks, main_info_cbacks, ap_prc->cache_bytes_));
+
+  /* The track's metadata is now available, update the IL client */
+  tiz_check_omx (update_metadata (ap_prc));
+
+  if (ap_prc->auto_detect_on_
+      && tiz_urltrans_bytes_available (ap_prc->p_trans_) > 0)
+    {
+      /* The data that data_available would have been told about is already
+         here, so the stream format is detected now; the pre-rolled data is
+         delivered once the client has re-enabled the port */
+      ap_prc->auto_detect_on_ = false;
+      tiz_urltrans_pause (ap_prc->p_trans_);
+      ap_prc->lookahead_promoted_ = true;
+      send_port_auto_detect_events (ap_prc);
+      return OMX_ErrorNone;
+    }
+
+  if (ap_prc->port_disabled_)
+    {
+      /* Record that the pre-rolled data needs to be delivered when the port
+         is re-enabled */
+      ap_prc->uri_changed_ = false;
+      ap_prc->lookahead_promoted_ = true;
+      return OMX_ErrorNone;
+    }
+
+  /* Deliver what has been pre-rolled so far (this also resumes the transfer
+     if it was paused) */
+  return tiz_urltrans_on_buffers_ready (ap_prc->p_trans_);
+}
+
 /*
  * plexprc
  */
@@ -728,6 +814,7 @@ plex_prc_ctor (void * ap_obj, va_list * app)
   TIZ_INIT_OMX_STRUCT (p_prc->playlist_skip_);
   p_prc->p_uri_param_ = NULL;
   p_prc->p_trans_ = NULL;
+  p_prc->p_lookahead_ = NULL;
   p_prc->p_plex_ = NULL;
   p_prc->eos_ = false;
   p_prc->port_disabled_ = false;
@@ -740,6 +827,7 @@ plex_prc_ctor (void * ap_obj, va_list * app)
   p_prc->auto_detect_on_ = false;
   p_prc->bitrate_ = ARATELIA_HTTP_SOURCE_DEFAULT_BIT_RATE_KBITS;
   update_cache_size (p_prc);
+  p_prc->lookahead_promoted_ = false;
   p_prc->remove_current_url_ = false;
   p_prc->connection_closed_ = false;
   return p_prc;
@@ -773,10 +861,6 @@ plex_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
   tiz_check_omx (obtain_next_url (p_prc, 1));
 
   {
-    const tiz_urltrans_buffer_cbacks_t buffer_cbacks
-      = {buffer_filled, buffer_emptied};
-    const tiz_urltrans_info_cbacks_t info_cbacks
-      = {header_available, data_available, connection_lost};
     const tiz_urltrans_event_io_cbacks_t io_cbacks
       = {tiz_srv_io_watcher_init, tiz_srv_io_watcher_destroy,
          tiz_srv_io_watcher_start, tiz_srv_io_watcher_stop};
@@ -789,7 +873,18 @@ plex_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
                            ARATELIA_HTTP_SOURCE_COMPONENT_NAME,
                            ARATELIA_HTTP_SOURCE_PORT_MIN_BUF_SIZE,
                            ARATELIA_HTTP_SOURCE_DEFAULT_RECONNECT_TIMEOUT,
-                           buffer_cbacks, info_cbacks, io_cbacks, timer_cbacks);
+                           main_buffer_cbacks, main_info_cbacks, io_cbacks,
+                           timer_cbacks);
+    if (OMX_ErrorNone == rc)
+      {
+        /* A second transfer object is used to pre-roll the next track
+           while the current one is still playing */
+        const httpsrc_lookahead_cbacks_t lookahead_cbacks
+          = {lookahead_next_url, lookahead_rewind, lookahead_release};
+        rc = httpsrc_lookahead_init (&(p_prc->p_lookahead_), p_prc,
+                                     lookahead_cbacks, io_cbacks,
+                                     timer_cbacks);
+      }
   }
   return rc;
 }
@@ -801,6 +896,8 @@ plex_prc_deallocate_resources (void * ap_prc)
   assert (p_prc);
   tiz_urltrans_destroy (p_prc->p_trans_);
   p_prc->p_trans_ = NULL;
+  httpsrc_lookahead_destroy (p_prc->p_lookahead_);
+  p_prc->p_lookahead_ = NULL;
   delete_uri (p_prc);
   tiz_plex_destroy (p_prc->p_plex_);
   p_prc->p_plex_ = NULL;
@@ -813,6 +910,8 @@ plex_prc_prepare_to_transfer (void * ap_prc, OMX_U32 a_pid)
   plex_prc_t * p_prc = ap_prc;
   assert (ap_prc);
   p_prc->eos_ = false;
+  p_prc->lookahead_promoted_ = false;
+  httpsrc_lookahead_discard (p_prc->p_lookahead_);
   tiz_urltrans_cancel (p_prc->p_trans_);
   tiz_urltrans_set_internal_buffer_size (p_prc->p_trans_, p_prc->cache_bytes_);
   return prepare_for_port_auto_detection (p_prc);
@@ -841,6 +940,7 @@ plex_prc_stop_and_return (void * ap_prc)
       tiz_urltrans_pause (p_prc->p_trans_);
       tiz_urltrans_flush_buffer (p_prc->p_trans_);
     }
+  httpsrc_lookahead_discard (p_prc->p_lookahead_);
   return release_buffer (p_prc);
 }
 
@@ -862,6 +962,8 @@ plex_prc_io_ready (void * ap_prc, tiz_event_io_t * ap_ev_io, int a_fd,
 {
   plex_prc_t * p_prc = ap_prc;
   assert (p_prc);
+  tiz_check_omx (httpsrc_lookahead_on_io_ready (p_prc->p_lookahead_, ap_ev_io,
+                                                a_fd, a_events));
   return tiz_urltrans_on_io_ready (p_prc->p_trans_, ap_ev_io, a_fd, a_events);
 }
 
@@ -871,6 +973,8 @@ plex_prc_timer_ready (void * ap_prc, tiz_event_timer_t * ap_ev_timer,
 {
   plex_prc_t * p_prc = ap_prc;
   assert (p_prc);
+  tiz_check_omx (
+    httpsrc_lookahead_on_timer_ready (p_prc->p_lookahead_, ap_ev_timer));
   return tiz_urltrans_on_timer_ready (p_prc->p_trans_, ap_ev_timer);
 }
 
@@ -921,7 +1025,13 @@ plex_prc_port_enable (const void * ap_prc, OMX_U32 a_pid)
   if (p_prc->port_disabled_)
     {
       p_prc->port_disabled_ = false;
-      if (!p_prc->uri_changed_)
+      if (p_prc->lookahead_promoted_)
+        {
+          /* Deliver the pre-rolled data of the new track */
+          p_prc->lookahead_promoted_ = false;
+          rc = tiz_urltrans_on_buffers_ready (p_prc->p_trans_);
+        }
+      else if (!p_prc->uri_changed_)
         {
           rc = tiz_urltrans_unpause (p_prc->p_trans_);
         }
@@ -949,6 +1059,17 @@ plex_prc_config_change (void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid),
       tiz_check_omx (tiz_api_GetConfig (
         tiz_get_krn (handleOf (p_prc)), handleOf (p_prc),
         OMX_TizoniaIndexConfigPlaylistSkip, &p_prc->playlist_skip_));
+
+      if (p_prc->playlist_skip_.nValue > 0
+          && httpsrc_lookahead_ready (p_prc->p_lookahead_))
+        {
+          /* The next track has already been pre-rolled; no need to
+             re-connect */
+          return promote_lookahead (p_prc);
+        }
+
+      httpsrc_lookahead_discard (p_prc->p_lookahead_);
+      p_prc->lookahead_promoted_ = false;
       p_prc->playlist_skip_.nValue > 0 ? obtain_next_url (p_prc, 1)
                                        : obtain_next_url (p_prc, -1);
       /* Changing the URL has the side effect of halting the current
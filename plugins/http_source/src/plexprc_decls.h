@@ -39,6 +39,8 @@ extern "C" {
 #include <tizprc_decls.h>
 
 #include <tizplatform.h>
+
+#include "httpsrclookahead.h"
 #include <tizplex_c.h>
 
 typedef struct plex_prc plex_prc_t;
@@ -52,6 +54,7 @@ struct plex_prc
   OMX_TIZONIA_PLAYLISTSKIPTYPE playlist_skip_;
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   tiz_urltrans_t * p_trans_;
+  httpsrc_lookahead_t * p_lookahead_;
   tiz_plex_t * p_plex_;
   bool eos_;
   bool port_disabled_;
@@ -64,6 +67,7 @@ struct plex_prc
   bool auto_detect_on_;
   int bitrate_;
   int cache_bytes_;
+  bool lookahead_promoted_;
   bool remove_current_url_;
   bool connection_closed_;
 };
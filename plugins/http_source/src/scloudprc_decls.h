@@ -41,6 +41,8 @@ extern "C" {
 
 #include "tizplatform.h"
 
+#include "httpsrclookahead.h"
+
 typedef struct scloud_prc scloud_prc_t;
 struct scloud_prc
 {
@@ -52,6 +54,7 @@ struct scloud_prc
   OMX_TIZONIA_PLAYLISTSKIPTYPE playlist_skip_;
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   tiz_urltrans_t * p_trans_;
+  httpsrc_lookahead_t * p_lookahead_;
   tiz_scloud_t * p_scloud_;
   bool eos_;
   bool port_disabled_;
@@ -64,6 +67,7 @@ struct scloud_prc
   bool auto_detect_on_;
   int bitrate_;
   int cache_bytes_;
+  bool lookahead_promoted_;
 };
 
 typedef struct scloud_prc_class scloud_prc_class_t;
@@ -39,6 +39,8 @@ extern "C" {
 #include <tizprc_decls.h>
 
 #include <tizplatform.h>
+
+#include "httpsrclookahead.h"
 #include <tizyoutube_c.h>
 
 typedef struct youtube_prc youtube_prc_t;
@@ -52,6 +54,7 @@ struct youtube_prc
   OMX_TIZONIA_PLAYLISTSKIPTYPE playlist_skip_;
   OMX_PARAM_CONTENTURITYPE * p_uri_param_;
   tiz_urltrans_t * p_trans_;
+  httpsrc_lookahead_t * p_lookahead_;
   tiz_youtube_t * p_youtube_;
   bool eos_;
   bool port_disabled_;
@@ -64,6 +67,7 @@ struct youtube_prc
   bool auto_detect_on_;
   int bitrate_;
   int cache_bytes_;
+  bool lookahead_promoted_;
   bool remove_current_url_;
 };
 
@@ -31,7 +31,7 @@
 #endif
 
 #include <assert.h>
-#include <limits.h>
+#include <endian.h>
 #include <string.h>
 
 #include <tizplatform.h>
@@ -47,6 +47,9 @@
 #define TIZ_LOG_CATEGORY_NAME "tiz.mp3_decoder.prc"
 #endif
 
+/* The maximum number of frames (per channel) in libmad's synth buffer */
+#define MP3D_SYNTH_MAX_FRAMES 1152
+
 static void
 reset_stream_parameters (mp3d_prc_t * ap_prc)
 {
@@ -79,6 +82,20 @@ deinit_mad_decoder (mp3d_prc_t * ap_prc)
   mad_stream_finish (&ap_prc->stream_);
 }
 
+static void
+flush_mad_decoder (mp3d_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  /* Discard any partially decoded data, so that decoding resumes at the next
+   * frame boundary found in the input (e.g. after a seek) */
+  mad_stream_finish (&ap_prc->stream_);
+  mad_stream_init (&ap_prc->stream_);
+  mad_frame_mute (&ap_prc->frame_);
+  mad_synth_mute (&ap_prc->synth_);
+  ap_prc->remaining_ = 0;
+  ap_prc->next_synth_sample_ = 0;
+}
+
 static OMX_ERRORTYPE
 release_headers (const void * ap_obj, OMX_U32 a_pid)
 {
@@ -280,46 +297,6 @@ store_stream_metadata (mp3d_prc_t * ap_prc, struct mad_header * Header)
              Emphasis, Header->samplerate);
 }
 
-static signed short
-mad_fixed_to_sshort (mad_fixed_t fixed)
-{
-  /* A fixed point number is formed of the following bit pattern:
-   *
-   * SWWWFFFFFFFFFFFFFFFFFFFFFFFFFFFF
-   * MSB                          LSB
-   * S ==> Sign (0 is positive, 1 is negative)
-   * W ==> Whole part bits
-   * F ==> Fractional part bits
-   *
-   * This pattern contains MAD_F_FRACBITS fractional bits, one
-   * should alway use this macro when working on the bits of a fixed
-   * point number. It is not guaranteed to be constant over the
-   * different platforms supported by libmad.
-   *
-   * The signed short value is formed, after clipping, by the least
-   * significant whole part bit, followed by the 15 most significant
-   * fractional part bits. Warning: this is a quick and dirty way to
-   * compute the 16-bit number, madplay includes much better
-   * algorithms.
-   */
-
-  /* Clipping */
-  if (fixed >= MAD_F_ONE)
-    {
-      return (SHRT_MAX);
-    }
-
-  if (fixed <= -MAD_F_ONE)
-    {
-      return (-SHRT_MAX);
-    }
-
-  /* Conversion. */
-  fixed = fixed >> (MAD_F_FRACBITS - 15);
-
-  return (signed short) fixed;
-}
-
 static size_t
 read_from_omx_buffer (const mp3d_prc_t * ap_prc, void * ap_dst, size_t bytes,
                       OMX_BUFFERHEADERTYPE * ap_hdr)
@@ -385,33 +362,67 @@ static int
 synthesize_samples (const void * ap_obj, int next_sample)
 {
   mp3d_prc_t * p_prc = (mp3d_prc_t *) ap_obj;
-  const unsigned char * p_bufend
-    = p_prc->p_outhdr_->pBuffer + p_prc->p_outhdr_->nAllocLen;
-  unsigned char * p_output
-    = p_prc->p_outhdr_->pBuffer + p_prc->p_outhdr_->nFilledLen;
-  bool buffer_full = (p_bufend == p_output);
-  int i;
-
-  for (i = next_sample; i < p_prc->synth_.pcm.length && !buffer_full; i++)
+  OMX_BUFFERHEADERTYPE * p_hdr = p_prc->p_outhdr_;
+  const OMX_U32 early_release_len
+    = (OMX_U32) (ARATELIA_MP3_DECODER_PORT_MIN_OUTPUT_BUF_SIZE * .2);
+  bool buffer_full = (p_hdr->nAllocLen - p_hdr->nFilledLen < 4);
+  int i = next_sample;
+
+  while (i < p_prc->synth_.pcm.length && !buffer_full)
     {
-      signed short sample;
+      /* We're outputting two channels, also for mono streams, so a frame is
+       * four bytes */
+      int16_t left[MP3D_SYNTH_MAX_FRAMES];
+      int16_t right[MP3D_SYNTH_MAX_FRAMES];
+      const int16_t * planes[2] = {left, right};
+      int16_t * p_output = (int16_t *) (p_hdr->pBuffer + p_hdr->nFilledLen);
+      OMX_U32 nframes = p_prc->synth_.pcm.length - i;
+
+      if (nframes > (p_hdr->nAllocLen - p_hdr->nFilledLen) / 4)
+        {
+          nframes = (p_hdr->nAllocLen - p_hdr->nFilledLen) / 4;
+        }
+
+      if (p_prc->frame_count_ < 5)
+        {
+          /* At the early stages of the decoding, the buffer is released as
+           * soon as it reaches a fraction of its size */
+          const OMX_U32 needed
+            = p_hdr->nFilledLen < early_release_len
+                ? (early_release_len - p_hdr->nFilledLen + 3) / 4
+                : 1;
+          if (nframes > needed)
+            {
+              nframes = needed;
+            }
+        }
+
+      assert (nframes <= MP3D_SYNTH_MAX_FRAMES);
 
-      /* Left channel */
-      sample = mad_fixed_to_sshort (p_prc->synth_.pcm.samples[0][i]);
-      *(p_output++) = sample >> 8;
-      *(p_output++) = sample & 0xff;
+      tiz_dsp_fixed_to_s16 (left, &(p_prc->synth_.pcm.samples[0][i]), nframes,
+                            MAD_F_FRACBITS);
 
       /* Right channel. If the decoded stream is monophonic then
        * the right output channel is the same as the left one.
        */
       if (MAD_NCHANNELS (&p_prc->frame_.header) == 2)
         {
-          sample = mad_fixed_to_sshort (p_prc->synth_.pcm.samples[1][i]);
+          tiz_dsp_fixed_to_s16 (right, &(p_prc->synth_.pcm.samples[1][i]),
+                                nframes, MAD_F_FRACBITS);
+        }
+      else
+        {
+          planes[1] = left;
         }
-      *(p_output++) = sample >> 8;
-      *(p_output++) = sample & 0xff;
 
-      p_prc->p_outhdr_->nFilledLen += 4;
+      tiz_dsp_interleave_s16 (p_output, planes, 2, nframes);
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+      /* The output of this decoder is Big Endian */
+      tiz_dsp_bswap16 (p_output, nframes * 2);
+#endif
+
+      p_hdr->nFilledLen += nframes * 4;
+      i += nframes;
 
       if (p_prc->frame_.header.samplerate != p_prc->pcmmode_.nSamplingRate
           || p_prc->pcmmode_.nChannels < 2)
@@ -430,20 +441,10 @@ synthesize_samples (const void * ap_obj, int next_sample)
 
       /* release the output buffer if it is full, or if we are at the early stages
          of the decoding */
-      if (p_output == p_bufend)
-        {
-          p_output = p_prc->p_outhdr_->pBuffer;
-          p_prc->p_outhdr_->nFilledLen = p_prc->p_outhdr_->nAllocLen;
-          (void) release_headers (p_prc,
-                                  ARATELIA_MP3_DECODER_OUTPUT_PORT_INDEX);
-          buffer_full = true;
-        }
-      else if (p_prc->frame_count_ < 5
-               && p_prc->p_outhdr_->nFilledLen
-                    >= (int) (ARATELIA_MP3_DECODER_PORT_MIN_OUTPUT_BUF_SIZE
-                              * .2))
+      if (p_hdr->nAllocLen - p_hdr->nFilledLen < 4
+          || (p_prc->frame_count_ < 5
+              && p_hdr->nFilledLen >= early_release_len))
         {
-          p_output = p_prc->p_outhdr_->pBuffer;
           (void) release_headers (p_prc,
                                   ARATELIA_MP3_DECODER_OUTPUT_PORT_INDEX);
           buffer_full = true;
@@ -854,7 +855,12 @@ static OMX_ERRORTYPE
 mp3d_proc_port_flush (const void * ap_obj, OMX_U32 a_pid)
 {
   mp3d_prc_t * p_obj = (mp3d_prc_t *) ap_obj;
-  return release_headers (p_obj, a_pid);
+  tiz_check_omx (release_headers (p_obj, a_pid));
+  if (OMX_ALL == a_pid || ARATELIA_MP3_DECODER_INPUT_PORT_INDEX == a_pid)
+    {
+      flush_mad_decoder (p_obj);
+    }
+  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
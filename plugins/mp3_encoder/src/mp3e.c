@@ -42,9 +42,11 @@
 #include <tizplatform.h>
 
 #include <tizport.h>
+#include <tizport-macros.h>
 #include <tizscheduler.h>
 
 #include "mp3eprc.h"
+#include "mp3ecfgport.h"
 #include "mp3e.h"
 
 #ifdef TIZ_LOG_CATEGORY_NAME
@@ -114,8 +116,9 @@ instantiate_pcm_port (OMX_HANDLETYPE ap_hdl)
 }
 
 static OMX_PTR
-instantiate_mp3_port (OMX_HANDLETYPE ap_hdl)
+instantiate_mp3_port (OMX_HANDLETYPE ap_hdl, const OMX_U32 a_pid)
 {
+  OMX_PTR p_port = NULL;
   OMX_AUDIO_PARAM_MP3TYPE mp3type;
   OMX_AUDIO_CODINGTYPE encodings[] = {OMX_AUDIO_CodingMP3, OMX_AUDIO_CodingMax};
   tiz_port_options_t mp3_port_opts = {
@@ -126,13 +129,13 @@ instantiate_mp3_port (OMX_HANDLETYPE ap_hdl)
     ARATELIA_MP3_ENCODER_PORT_NONCONTIGUOUS,
     ARATELIA_MP3_ENCODER_PORT_ALIGNMENT,
     ARATELIA_MP3_ENCODER_PORT_SUPPLIERPREF,
-    {ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX, NULL, NULL, NULL},
+    {a_pid, NULL, NULL, NULL},
     0 /* Master port */
   };
 
   mp3type.nSize = sizeof (OMX_AUDIO_PARAM_MP3TYPE);
   mp3type.nVersion.nVersion = OMX_VERSION;
-  mp3type.nPortIndex = ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX;
+  mp3type.nPortIndex = a_pid;
   mp3type.nChannels = 2;
   mp3type.nBitRate = 0;
   mp3type.nSampleRate = 0;
@@ -140,14 +143,48 @@ instantiate_mp3_port (OMX_HANDLETYPE ap_hdl)
   mp3type.eChannelMode = OMX_AUDIO_ChannelModeStereo;
   mp3type.eFormat = OMX_AUDIO_MP3StreamFormatMP1Layer3;
 
-  return factory_new (tiz_get_type (ap_hdl, "tizmp3port"), &mp3_port_opts,
-                      &encodings, &mp3type);
+  p_port = factory_new (tiz_get_type (ap_hdl, "tizmp3port"), &mp3_port_opts,
+                        &encodings, &mp3type);
+
+  /* Only the first output port is in use until the IL client asks for more
+     (see OMX_TizoniaIndexParamAudioEncoderOutputs) */
+  if (p_port && a_pid > ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX)
+    {
+      TIZ_PORT_SET_DISABLED (p_port);
+    }
+
+  return p_port;
+}
+
+/* The role factory's port hooks don't take the port index */
+static OMX_PTR
+instantiate_mp3_port_1 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_mp3_port (ap_hdl, 1);
+}
+
+static OMX_PTR
+instantiate_mp3_port_2 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_mp3_port (ap_hdl, 2);
+}
+
+static OMX_PTR
+instantiate_mp3_port_3 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_mp3_port (ap_hdl, 3);
+}
+
+static OMX_PTR
+instantiate_mp3_port_4 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_mp3_port (ap_hdl, 4);
 }
 
 static OMX_PTR
 instantiate_config_port (OMX_HANDLETYPE ap_hdl)
 {
-  return factory_new (tiz_get_type (ap_hdl, "tizconfigport"),
+  return factory_new (tiz_get_type (ap_hdl, "mp3ecfgport"),
                       NULL, /* this port does not take options */
                       ARATELIA_MP3_ENCODER_COMPONENT_NAME, mp3_encoder_version);
 }
@@ -164,7 +201,8 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
   tiz_role_factory_t role_factory;
   const tiz_role_factory_t * rf_list[] = {&role_factory};
   tiz_type_factory_t mp3eprc_type;
-  const tiz_type_factory_t * tf_list[] = {&mp3eprc_type};
+  tiz_type_factory_t mp3ecfgport_type;
+  const tiz_type_factory_t * tf_list[] = {&mp3eprc_type, &mp3ecfgport_type};
 
   TIZ_LOG (TIZ_PRIORITY_TRACE,
            "OMX_ComponentInit: "
@@ -174,8 +212,11 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
   strcpy ((OMX_STRING) role_factory.role, ARATELIA_MP3_ENCODER_DEFAULT_ROLE);
   role_factory.pf_cport = instantiate_config_port;
   role_factory.pf_port[0] = instantiate_pcm_port;
-  role_factory.pf_port[1] = instantiate_mp3_port;
-  role_factory.nports = 2;
+  role_factory.pf_port[1] = instantiate_mp3_port_1;
+  role_factory.pf_port[2] = instantiate_mp3_port_2;
+  role_factory.pf_port[3] = instantiate_mp3_port_3;
+  role_factory.pf_port[4] = instantiate_mp3_port_4;
+  role_factory.nports = 1 + ARATELIA_MP3_ENCODER_MAX_OUTPUT_PORTS;
   role_factory.pf_proc = instantiate_processor;
 
   strcpy ((OMX_STRING) mp3eprc_type.class_name, "mp3eprc_class");
@@ -183,11 +224,16 @@ OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
   strcpy ((OMX_STRING) mp3eprc_type.object_name, "mp3eprc");
   mp3eprc_type.pf_object_init = mp3e_prc_init;
 
+  strcpy ((OMX_STRING) mp3ecfgport_type.class_name, "mp3ecfgport_class");
+  mp3ecfgport_type.pf_class_init = mp3e_cfgport_class_init;
+  strcpy ((OMX_STRING) mp3ecfgport_type.object_name, "mp3ecfgport");
+  mp3ecfgport_type.pf_object_init = mp3e_cfgport_init;
+
   /* Initialize the component infrastructure */
   tiz_check_omx (tiz_comp_init (ap_hdl, ARATELIA_MP3_ENCODER_COMPONENT_NAME));
 
-  /* Register the "mp3eprc" class */
-  tiz_check_omx (tiz_comp_register_types (ap_hdl, tf_list, 1));
+  /* Register the "mp3eprc" and "mp3ecfgport" classes */
+  tiz_check_omx (tiz_comp_register_types (ap_hdl, tf_list, 2));
 
   /* Register the component role */
   tiz_check_omx (tiz_comp_register_roles (ap_hdl, rf_list, 1));
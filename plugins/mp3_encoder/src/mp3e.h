@@ -40,6 +40,9 @@ extern "C" {
 /* With libtizonia, port indexes must start at index 0 */
 #define ARATELIA_MP3_ENCODER_INPUT_PORT_INDEX 0
 #define ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX 1
+/* Each output port is a separate encoding of the same PCM input (see
+   OMX_TizoniaIndexParamAudioEncoderOutputs) */
+#define ARATELIA_MP3_ENCODER_MAX_OUTPUT_PORTS 4
 #define ARATELIA_MP3_ENCODER_PORT_MIN_BUF_COUNT 2
 /* Assuming worst case of 16 bit per sample per channel adn 48khz, lets try to
    fit 25ms of audio (1200 samples per channel) */
@@ -0,0 +1,207 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   mp3ecfgport.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Mp3 Encoder config port class
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <tizplatform.h>
+
+#include <tizkernel.h>
+#include <tizport-macros.h>
+
+#include "mp3e.h"
+#include "mp3ecfgport.h"
+#include "mp3ecfgport_decls.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.mp3_encoder.cfgport"
+#endif
+
+/* The output ports beyond the ones in use are kept disabled, so that they
+   are left out of the component's state transitions */
+static void
+enable_output_ports (OMX_HANDLETYPE ap_hdl, const OMX_U32 a_noutputs)
+{
+  void * p_krn = tiz_get_krn (ap_hdl);
+  OMX_U32 i = 0;
+
+  for (i = 0; i < ARATELIA_MP3_ENCODER_MAX_OUTPUT_PORTS; ++i)
+    {
+      void * p_port = tiz_krn_get_port (
+        p_krn, ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX + i);
+      assert (p_port);
+      if (i < a_noutputs)
+        {
+          tiz_port_set_flags (p_port, 1, EFlagEnabled);
+        }
+      else
+        {
+          TIZ_PORT_SET_DISABLED (p_port);
+        }
+    }
+}
+
+/*
+ * mp3ecfgport class
+ */
+
+static void *
+mp3e_cfgport_ctor (void * ap_obj, va_list * app)
+{
+  mp3e_cfgport_t * p_obj
+    = super_ctor (typeOf (ap_obj, "mp3ecfgport"), ap_obj, app);
+
+  assert (p_obj);
+
+  tiz_port_register_index (p_obj, OMX_TizoniaIndexParamAudioEncoderOutputs);
+
+  p_obj->outputs_.nSize = sizeof (OMX_TIZONIA_AUDIO_PARAM_ENCODEROUTPUTSTYPE);
+  p_obj->outputs_.nVersion.nVersion = OMX_VERSION;
+  p_obj->outputs_.nOutputs = 1;
+  p_obj->outputs_.nMaxOutputs = ARATELIA_MP3_ENCODER_MAX_OUTPUT_PORTS;
+
+  return p_obj;
+}
+
+static void *
+mp3e_cfgport_dtor (void * ap_obj)
+{
+  return super_dtor (typeOf (ap_obj, "mp3ecfgport"), ap_obj);
+}
+
+/*
+ * from tiz_api
+ */
+
+static OMX_ERRORTYPE
+mp3e_cfgport_GetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                           OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  const mp3e_cfgport_t * p_obj = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "GetParameter [%s]...", tiz_idx_to_str (a_index));
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexParamAudioEncoderOutputs == a_index)
+    {
+      OMX_TIZONIA_AUDIO_PARAM_ENCODEROUTPUTSTYPE * p_outputs
+        = (OMX_TIZONIA_AUDIO_PARAM_ENCODEROUTPUTSTYPE *) ap_struct;
+      *p_outputs = p_obj->outputs_;
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_GetParameter (typeOf (ap_obj, "mp3ecfgport"), ap_obj, ap_hdl,
+                               a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+mp3e_cfgport_SetParameter (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                           OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  mp3e_cfgport_t * p_obj = (mp3e_cfgport_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "SetParameter [%s]...", tiz_idx_to_str (a_index));
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexParamAudioEncoderOutputs == a_index)
+    {
+      const OMX_TIZONIA_AUDIO_PARAM_ENCODEROUTPUTSTYPE * p_outputs
+        = (OMX_TIZONIA_AUDIO_PARAM_ENCODEROUTPUTSTYPE *) ap_struct;
+      if (p_outputs->nOutputs < 1
+          || p_outputs->nOutputs > ARATELIA_MP3_ENCODER_MAX_OUTPUT_PORTS)
+        {
+          rc = OMX_ErrorBadParameter;
+        }
+      else
+        {
+          p_obj->outputs_.nOutputs = p_outputs->nOutputs;
+          enable_output_ports (ap_hdl, p_obj->outputs_.nOutputs);
+          TIZ_TRACE (ap_hdl, "nOutputs [%u]...", p_obj->outputs_.nOutputs);
+        }
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_SetParameter (typeOf (ap_obj, "mp3ecfgport"), ap_obj, ap_hdl,
+                               a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+/*
+ * mp3e_cfgport_class
+ */
+
+static void *
+mp3e_cfgport_class_ctor (void * ap_obj, va_list * app)
+{
+  /* NOTE: Class methods might be added in the future. None for now. */
+  return super_ctor (typeOf (ap_obj, "mp3ecfgport_class"), ap_obj, app);
+}
+
+/*
+ * initialization
+ */
+
+void *
+mp3e_cfgport_class_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizconfigport = tiz_get_type (ap_hdl, "tizconfigport");
+  void * mp3ecfgport_class
+    = factory_new (classOf (tizconfigport), "mp3ecfgport_class",
+                   classOf (tizconfigport), sizeof (mp3e_cfgport_class_t),
+                   ap_tos, ap_hdl, ctor, mp3e_cfgport_class_ctor, 0);
+  return mp3ecfgport_class;
+}
+
+void *
+mp3e_cfgport_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizconfigport = tiz_get_type (ap_hdl, "tizconfigport");
+  void * mp3ecfgport_class = tiz_get_type (ap_hdl, "mp3ecfgport_class");
+  TIZ_LOG_CLASS (mp3ecfgport_class);
+  void * mp3ecfgport = factory_new (
+    mp3ecfgport_class, "mp3ecfgport", tizconfigport, sizeof (mp3e_cfgport_t),
+    ap_tos, ap_hdl, ctor, mp3e_cfgport_ctor, dtor, mp3e_cfgport_dtor,
+    tiz_api_GetParameter, mp3e_cfgport_GetParameter, tiz_api_SetParameter,
+    mp3e_cfgport_SetParameter, 0);
+
+  return mp3ecfgport;
+}
@@ -37,6 +37,7 @@
 #include <tizplatform.h>
 
 #include <tizkernel.h>
+#include <tizport-macros.h>
 
 #include "mp3e.h"
 #include "mp3eprc.h"
@@ -48,139 +49,461 @@
 #endif
 
 #define TIZ_LAME_MP3_ENC_MIN_BUFFER_SIZE 7200
+/* One mp3 frame's worth of PCM frames, the smallest amount worth handing to
+   lame */
+#define TIZ_LAME_MP3_ENC_CHUNK_FRAMES 1152
+
+static OMX_ERRORTYPE
+reset_branch_encoder (mp3e_prc_t * ap_prc, mp3e_branch_t * ap_br);
+
+static OMX_U32
+pcm_frame_bytes (const mp3e_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  return MAX (ap_prc->pcmmode_.nChannels * ap_prc->pcmmode_.nBitPerSample / 8,
+              1);
+}
+
+static OMX_U32
+output_space (const mp3e_branch_t * ap_br)
+{
+  assert (ap_br);
+  assert (ap_br->p_outhdr);
+  return ap_br->p_outhdr->nAllocLen - ap_br->p_outhdr->nFilledLen;
+}
+
+/* The number of PCM frames that lame is guaranteed to be able to encode into
+   the space left in the branch's output buffer. As per lame.h, the worst case
+   is 1.25 * nframes + 7200 bytes. */
+static OMX_U32
+output_capacity (const mp3e_branch_t * ap_br)
+{
+  const OMX_U32 space = output_space (ap_br);
+  return space > TIZ_LAME_MP3_ENC_MIN_BUFFER_SIZE
+           ? (space - TIZ_LAME_MP3_ENC_MIN_BUFFER_SIZE) * 4 / 5
+           : 0;
+}
+
+static OMX_ERRORTYPE
+release_output (mp3e_prc_t * ap_prc, mp3e_branch_t * ap_br)
+{
+  assert (ap_prc);
+  assert (ap_br);
+  assert (ap_br->p_outhdr);
+
+  ap_br->p_outhdr->nOffset = 0;
+  tiz_check_omx (tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                         ap_br->pid, ap_br->p_outhdr));
+  ap_br->p_outhdr = NULL;
+  ap_br->output_full = false;
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+release_input (mp3e_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  assert (ap_prc->p_inhdr_);
+
+  ap_prc->p_inhdr_->nFilledLen = 0;
+  ap_prc->p_inhdr_->nOffset = 0;
+  tiz_check_omx (tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_prc)),
+                                         ARATELIA_MP3_ENCODER_INPUT_PORT_INDEX,
+                                         ap_prc->p_inhdr_));
+  ap_prc->p_inhdr_ = NULL;
+  return OMX_ErrorNone;
+}
+
+/* Returns the branch to the start of a stream: whatever it holds is
+   dropped, and its encoder is recreated */
+static OMX_ERRORTYPE
+clear_branch (mp3e_prc_t * ap_prc, mp3e_branch_t * ap_br)
+{
+  assert (ap_prc);
+  assert (ap_br);
+
+  if (ap_br->p_outhdr)
+    {
+      tiz_check_omx (release_output (ap_prc, ap_br));
+    }
+  if (ap_br->p_backlog)
+    {
+      tiz_buffer_clear (ap_br->p_backlog);
+    }
+  ap_br->in_offset = 0;
+  ap_br->input_pending = false;
+  ap_br->output_full = false;
+  ap_br->eos_pending = false;
+  return ap_br->lame ? reset_branch_encoder (ap_prc, ap_br) : OMX_ErrorNone;
+}
 
 static OMX_ERRORTYPE
 release_buffers (const void * ap_obj)
 {
   mp3e_prc_t * p_obj = (mp3e_prc_t *) ap_obj;
+  OMX_U32 i = 0;
 
   if (p_obj->p_inhdr_)
     {
-      tiz_check_omx (tiz_krn_release_buffer (
-        tiz_get_krn (handleOf (ap_obj)), ARATELIA_MP3_ENCODER_INPUT_PORT_INDEX,
-        p_obj->p_inhdr_));
-      p_obj->p_inhdr_ = NULL;
+      tiz_check_omx (release_input (p_obj));
     }
 
-  if (p_obj->p_outhdr_)
+  for (i = 0; i < p_obj->nbranches_; ++i)
     {
-      tiz_check_omx (tiz_krn_release_buffer (
-        tiz_get_krn (handleOf (ap_obj)), ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX,
-        p_obj->p_outhdr_));
-      p_obj->p_outhdr_ = NULL;
+      tiz_check_omx (clear_branch (p_obj, &(p_obj->branches_[i])));
     }
 
-  p_obj->frame_size_ = 0;
-  if (!p_obj->lame_flushed_)
+  return OMX_ErrorNone;
+}
+
+/* Encodes as much of the given PCM data as fits in the branch's output
+   buffer. Returns the number of bytes consumed; zero when the output buffer
+   is full, or there is less than one PCM frame. */
+static OMX_U32
+encode_pcm (mp3e_branch_t * ap_br, const OMX_U8 * ap_pcm,
+            const OMX_U32 a_nbytes)
+{
+  const mp3e_prc_t * p_prc = NULL;
+  OMX_BUFFERHEADERTYPE * p_outhdr = NULL;
+  OMX_U32 frame_bytes = 0;
+  OMX_U32 nframes = 0;
+  int encoded_bytes = 0;
+
+  assert (ap_br);
+  assert (ap_br->p_outhdr);
+  assert (ap_pcm);
+
+  p_prc = ap_br->p_prc;
+  p_outhdr = ap_br->p_outhdr;
+  frame_bytes = pcm_frame_bytes (p_prc);
+  nframes = MIN (a_nbytes / frame_bytes, output_capacity (ap_br));
+
+  if (0 == nframes)
     {
-      if (p_obj->lame_)
+      if (a_nbytes < frame_bytes)
         {
-          OMX_U8 * p_buffer = NULL;
-
-          if (NULL
-              == (p_buffer = (OMX_U8 *) tiz_mem_alloc (
-                    (size_t) TIZ_LAME_MP3_ENC_MIN_BUFFER_SIZE)))
-            {
-              return OMX_ErrorInsufficientResources;
-            }
+          return 0;
+        }
+      if (p_outhdr->nFilledLen > 0)
+        {
+          ap_br->output_full = true;
+          return 0;
+        }
+      /* The buffer is smaller than lame's worst case; try a single mp3
+         frame, lame tells if it doesn't fit */
+      nframes = MIN (a_nbytes / frame_bytes, TIZ_LAME_MP3_ENC_CHUNK_FRAMES);
+    }
 
-          (void) lame_encode_flush (p_obj->lame_, p_buffer,
-                                    TIZ_LAME_MP3_ENC_MIN_BUFFER_SIZE);
+  encoded_bytes = lame_encode_buffer_interleaved (
+    ap_br->lame, (short int *) ap_pcm, nframes,
+    p_outhdr->pBuffer + p_outhdr->nOffset, output_space (ap_br));
 
-          tiz_mem_free (p_buffer);
+  if (encoded_bytes >= 0)
+    {
+      p_outhdr->nFilledLen += encoded_bytes;
+      p_outhdr->nOffset += encoded_bytes;
+      if (p_outhdr->nFilledLen > 0
+          && output_capacity (ap_br) < TIZ_LAME_MP3_ENC_CHUNK_FRAMES)
+        {
+          ap_br->output_full = true;
         }
-      p_obj->lame_flushed_ = true;
+    }
+  else
+    {
+      TIZ_ERROR (handleOf (p_prc),
+                 "port [%d] : Some error occurred during encoding [%d]...",
+                 ap_br->pid, encoded_bytes);
+      /* Skip this chunk on this branch */
+      ap_br->output_full = p_outhdr->nFilledLen > 0;
     }
 
-  return OMX_ErrorNone;
+  return nframes * frame_bytes;
 }
 
-static OMX_ERRORTYPE
-encode_buffer (const void * ap_obj)
+/* Moves what is left of the input buffer to the branch's backlog */
+static bool
+backlog_input (mp3e_branch_t * ap_br)
 {
-  mp3e_prc_t * p_obj = (mp3e_prc_t *) ap_obj;
-  int nsamples = 0;
-  int encoded_bytes = 0;
+  const OMX_BUFFERHEADERTYPE * p_inhdr = NULL;
+  OMX_U32 nbytes = 0;
+
+  assert (ap_br);
+  p_inhdr = ap_br->p_prc->p_inhdr_;
+  assert (p_inhdr);
+
+  nbytes = p_inhdr->nFilledLen - MIN (ap_br->in_offset, p_inhdr->nFilledLen);
+  ap_br->input_pending = false;
+  return tiz_buffer_push (ap_br->p_backlog,
+                          p_inhdr->pBuffer + p_inhdr->nOffset
+                            + ap_br->in_offset,
+                          nbytes)
+         >= (int) nbytes;
+}
 
-  assert (p_obj->p_outhdr_);
+/* This may run on the branch's worker thread, so it must not call into the
+   kernel. The input buffer is only read. */
+static void
+encode_branch (mp3e_branch_t * ap_br)
+{
+  tiz_buffer_t * p_backlog = NULL;
+  OMX_U32 consumed = 0;
 
-  if (p_obj->p_inhdr_)
+  assert (ap_br);
+  p_backlog = ap_br->p_backlog;
+
+  while (ap_br->p_outhdr && !ap_br->output_full)
     {
-      if ((p_obj->p_inhdr_->nFlags & OMX_BUFFERFLAG_EOS) != 0)
+      /* The backlog holds older data than the input buffer */
+      if (tiz_buffer_available (p_backlog) > 0)
         {
-          p_obj->eos_ = true;
+          if ((consumed = encode_pcm (ap_br, tiz_buffer_get (p_backlog),
+                                      tiz_buffer_available (p_backlog)))
+              > 0)
+            {
+              (void) tiz_buffer_advance (p_backlog, consumed);
+            }
+          else if (!ap_br->output_full && ap_br->input_pending)
+            {
+              /* Only part of a PCM frame is left; the input completes it */
+              (void) backlog_input (ap_br);
+            }
+          else
+            {
+              break;
+            }
         }
-
-      nsamples = (p_obj->p_inhdr_->nFilledLen / p_obj->pcmmode_.nChannels
-                  / p_obj->pcmmode_.nBitPerSample)
-                 * 8;
-
-      TIZ_TRACE (handleOf (ap_obj),
-                 "p_inhdr [%p] nsamples [%d] nFilledLen [%d] "
-                 "nChannels [%d] nBitPerSample [%d]"
-                 "nOffset [%d]",
-                 p_obj->p_inhdr_, nsamples, p_obj->p_inhdr_->nFilledLen,
-                 p_obj->pcmmode_.nChannels, p_obj->pcmmode_.nBitPerSample,
-                 p_obj->p_inhdr_->nOffset);
-
-      if (0
-          > (encoded_bytes = lame_encode_buffer_interleaved (
-               p_obj->lame_,
-               (short int *) (p_obj->p_inhdr_->pBuffer
-                              + p_obj->p_inhdr_->nOffset),
-               nsamples, p_obj->p_outhdr_->pBuffer + p_obj->p_outhdr_->nOffset,
-               p_obj->p_outhdr_->nAllocLen - p_obj->p_outhdr_->nFilledLen)))
+      else if (ap_br->input_pending)
         {
-          if (encoded_bytes == -1)
+          const OMX_BUFFERHEADERTYPE * p_inhdr = ap_br->p_prc->p_inhdr_;
+          assert (p_inhdr);
+          if (ap_br->in_offset >= p_inhdr->nFilledLen)
             {
-              TIZ_TRACE (
-                handleOf (ap_obj), "Output buffer is not big enough... [%d]...",
-                p_obj->p_outhdr_->nAllocLen - p_obj->p_outhdr_->nFilledLen);
+              ap_br->input_pending = false;
             }
-          else
+          else if ((consumed = encode_pcm (
+                      ap_br, p_inhdr->pBuffer + p_inhdr->nOffset
+                               + ap_br->in_offset,
+                      p_inhdr->nFilledLen - ap_br->in_offset))
+                   > 0)
             {
-              TIZ_TRACE (handleOf (ap_obj),
-                         "Some error occurred during encoding [%d]...",
-                         encoded_bytes);
+              ap_br->in_offset += consumed;
+            }
+          else if (!ap_br->output_full)
+            {
+              /* A partial PCM frame is kept for the next buffer */
+              (void) backlog_input (ap_br);
             }
         }
       else
         {
-          if (p_obj->frame_size_ == 0)
+          break;
+        }
+    }
+}
+
+static OMX_PTR
+branch_thread_func (OMX_PTR ap_arg)
+{
+  mp3e_branch_t * p_br = ap_arg;
+  mp3e_prc_t * p_prc = NULL;
+
+  assert (p_br);
+  p_prc = p_br->p_prc;
+
+  while (OMX_ErrorNone == tiz_sem_wait (&(p_br->sem)) && !p_prc->workers_exit_)
+    {
+      encode_branch (p_br);
+      (void) tiz_sem_post (&(p_prc->done_sem_));
+    }
+
+  return NULL;
+}
+
+static bool
+branch_has_work (const mp3e_branch_t * ap_br)
+{
+  assert (ap_br);
+  return ap_br->active && ap_br->p_outhdr && !ap_br->output_full
+         && (ap_br->input_pending
+             || tiz_buffer_available (ap_br->p_backlog) > 0);
+}
+
+/* Every branch with an output buffer encodes on its own; the first one does
+   so on this thread while the others run on their workers. Sets ap_progress
+   if any PCM data was consumed. */
+static OMX_ERRORTYPE
+encode_branches (mp3e_prc_t * ap_prc, bool * ap_progress)
+{
+  OMX_U32 before[ARATELIA_MP3_ENCODER_MAX_OUTPUT_PORTS];
+  OMX_U32 nforked = 0;
+  OMX_U32 i = 0;
+
+  assert (ap_prc);
+  assert (ap_progress);
+
+  for (i = 0; i < ap_prc->nbranches_; ++i)
+    {
+      mp3e_branch_t * p_br = &(ap_prc->branches_[i]);
+      before[i] = p_br->in_offset + tiz_buffer_offset (p_br->p_backlog)
+                  + (p_br->input_pending ? 0 : 1);
+      if (i > 0 && branch_has_work (p_br))
+        {
+          if (OMX_ErrorNone == tiz_sem_post (&(p_br->sem)))
+            {
+              ++nforked;
+            }
+          else
             {
-              p_obj->frame_size_ = encoded_bytes;
+              encode_branch (p_br);
             }
+        }
+    }
+
+  if (ap_prc->nbranches_ > 0 && branch_has_work (&(ap_prc->branches_[0])))
+    {
+      encode_branch (&(ap_prc->branches_[0]));
+    }
+
+  for (; nforked > 0; --nforked)
+    {
+      tiz_check_omx (tiz_sem_wait (&(ap_prc->done_sem_)));
+    }
 
-          p_obj->p_inhdr_->nFilledLen = 0;
-          p_obj->p_outhdr_->nFilledLen += encoded_bytes;
-          p_obj->p_outhdr_->nOffset += encoded_bytes;
+  for (i = 0; i < ap_prc->nbranches_; ++i)
+    {
+      const mp3e_branch_t * p_br = &(ap_prc->branches_[i]);
+      if (before[i] != p_br->in_offset + tiz_buffer_offset (p_br->p_backlog)
+                         + (p_br->input_pending ? 0 : 1))
+        {
+          *ap_progress = true;
         }
+    }
+
+  return OMX_ErrorNone;
+}
+
+/* A branch that can't get an output buffer keeps a copy of what it hasn't
+   encoded yet, so that it doesn't hold up the others. The input buffer is
+   returned once no branch needs it. */
+static OMX_ERRORTYPE
+store_input (mp3e_prc_t * ap_prc, bool * ap_progress)
+{
+  const OMX_BUFFERHEADERTYPE * p_inhdr = NULL;
+  bool in_use = false;
+  OMX_U32 i = 0;
+
+  assert (ap_prc);
+  assert (ap_progress);
 
-      if (p_obj->frame_size_
-            > (p_obj->p_outhdr_->nAllocLen - p_obj->p_outhdr_->nFilledLen)
-          || encoded_bytes == -1)
+  if (!(p_inhdr = ap_prc->p_inhdr_))
+    {
+      return OMX_ErrorNone;
+    }
+
+  for (i = 0; i < ap_prc->nbranches_; ++i)
+    {
+      mp3e_branch_t * p_br = &(ap_prc->branches_[i]);
+      if (p_br->input_pending && !p_br->p_outhdr)
         {
-          p_obj->p_outhdr_->nOffset = 0;
-          tiz_krn_release_buffer (tiz_get_krn (handleOf (ap_obj)),
-                                  ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX,
-                                  p_obj->p_outhdr_);
-          p_obj->p_outhdr_ = NULL;
+          const int excess
+            = tiz_buffer_available (p_br->p_backlog)
+              + (int) (p_inhdr->nFilledLen - p_br->in_offset)
+              - MAX_BACKLOG_SIZE;
+          if (excess > 0)
+            {
+              const OMX_U32 frame_bytes = pcm_frame_bytes (ap_prc);
+              TIZ_NOTICE (handleOf (ap_prc),
+                          "port [%d] : dropping [%d] bytes of PCM data",
+                          p_br->pid, excess);
+              (void) tiz_buffer_advance (
+                p_br->p_backlog,
+                ((excess + frame_bytes - 1) / frame_bytes) * frame_bytes);
+            }
+          if (!backlog_input (p_br))
+            {
+              return OMX_ErrorInsufficientResources;
+            }
         }
+      in_use = in_use || p_br->input_pending;
+    }
+
+  if (!in_use)
+    {
+      tiz_check_omx (release_input (ap_prc));
+      *ap_progress = true;
+    }
+
+  return OMX_ErrorNone;
+}
+
+static bool
+claim_output (mp3e_prc_t * ap_prc, mp3e_branch_t * ap_br);
+
+/* Once EOS has reached the end of a branch's data, the encoder is flushed
+   into a buffer with the EOS flag, and then started afresh */
+static OMX_ERRORTYPE
+finish_branch (mp3e_prc_t * ap_prc, mp3e_branch_t * ap_br, bool * ap_progress)
+{
+  int encoded_bytes = 0;
+
+  assert (ap_prc);
+  assert (ap_br);
+  assert (ap_progress);
+
+  if (!ap_br->eos_pending || ap_br->input_pending
+      || tiz_buffer_available (ap_br->p_backlog)
+           >= (int) pcm_frame_bytes (ap_prc))
+    {
+      return OMX_ErrorNone;
+    }
+
+  if (ap_br->p_outhdr && output_space (ap_br) < TIZ_LAME_MP3_ENC_MIN_BUFFER_SIZE
+      && ap_br->p_outhdr->nFilledLen > 0)
+    {
+      tiz_check_omx (release_output (ap_prc, ap_br));
+      *ap_progress = true;
+    }
+  if (!ap_br->p_outhdr && !claim_output (ap_prc, ap_br))
+    {
+      return OMX_ErrorNone;
+    }
+
+  /* may return one more mp3 frames */
+  encoded_bytes = lame_encode_flush (
+    ap_br->lame, ap_br->p_outhdr->pBuffer + ap_br->p_outhdr->nOffset,
+    output_space (ap_br));
+  if (encoded_bytes > 0)
+    {
+      ap_br->p_outhdr->nFilledLen += encoded_bytes;
+      ap_br->p_outhdr->nOffset += encoded_bytes;
+    }
+
+  TIZ_TRACE (handleOf (ap_prc), "port [%d] : EOS OUTPUT HEADER [%p]...",
+             ap_br->pid, ap_br->p_outhdr);
+  ap_br->p_outhdr->nFlags |= OMX_BUFFERFLAG_EOS;
+  tiz_check_omx (clear_branch (ap_prc, ap_br));
+  *ap_progress = true;
+
+  return OMX_ErrorNone;
+}
 
-    } /* if (p_obj->p_inhdr_) */
+static OMX_ERRORTYPE
+release_outputs (mp3e_prc_t * ap_prc, bool * ap_progress)
+{
+  OMX_U32 i = 0;
 
-  if (true == p_obj->eos_)
+  assert (ap_prc);
+  assert (ap_progress);
+
+  for (i = 0; i < ap_prc->nbranches_; ++i)
     {
-      if (p_obj->p_outhdr_)
+      mp3e_branch_t * p_br = &(ap_prc->branches_[i]);
+      if (p_br->p_outhdr && p_br->output_full)
         {
-          /* may return one more mp3 frames */
-          encoded_bytes = lame_encode_flush (
-            p_obj->lame_, p_obj->p_outhdr_->pBuffer + p_obj->p_outhdr_->nOffset,
-            p_obj->p_outhdr_->nAllocLen - p_obj->p_outhdr_->nFilledLen);
-          p_obj->p_outhdr_->nFilledLen += encoded_bytes;
-          p_obj->p_outhdr_->nOffset += encoded_bytes;
-          p_obj->lame_flushed_ = true;
+          tiz_check_omx (release_output (ap_prc, p_br));
+          *ap_progress = true;
         }
+      tiz_check_omx (finish_branch (ap_prc, p_br, ap_progress));
     }
 
   return OMX_ErrorNone;
@@ -201,7 +524,8 @@ claim_input (const void * ap_obj)
   assert (p_prc);
 
   if (OMX_ErrorNone
-      == tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)), 0, 0,
+      == tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)),
+                               ARATELIA_MP3_ENCODER_INPUT_PORT_INDEX, 0,
                                &p_prc->p_inhdr_))
     {
       if (p_prc->p_inhdr_)
@@ -216,25 +540,26 @@ claim_input (const void * ap_obj)
 }
 
 static bool
-claim_output (const void * ap_obj)
+claim_output (mp3e_prc_t * ap_prc, mp3e_branch_t * ap_br)
 {
-  mp3e_prc_t * p_prc = (mp3e_prc_t *) ap_obj;
   bool rc = false;
-  assert (p_prc);
+  assert (ap_prc);
+  assert (ap_br);
 
   if (OMX_ErrorNone
-      == tiz_krn_claim_buffer (tiz_get_krn (handleOf (p_prc)), 1, 0,
-                               &p_prc->p_outhdr_))
+      == tiz_krn_claim_buffer (tiz_get_krn (handleOf (ap_prc)), ap_br->pid, 0,
+                               &ap_br->p_outhdr))
     {
-      if (p_prc->p_outhdr_)
+      if (ap_br->p_outhdr)
         {
-          TIZ_TRACE (
-            handleOf (p_prc),
-            "Claimed OUTPUT HEADER [%p] BUFFER [%p] nFilledLen [%d]...",
-            p_prc->p_outhdr_, p_prc->p_outhdr_->pBuffer,
-            p_prc->p_outhdr_->nFilledLen);
-          p_prc->p_outhdr_->nFilledLen = 0;
-          p_prc->p_outhdr_->nOffset = 0;
+          TIZ_TRACE (handleOf (ap_prc),
+                     "Claimed OUTPUT HEADER [%p] BUFFER [%p] port [%d] "
+                     "nFilledLen [%d]...",
+                     ap_br->p_outhdr, ap_br->p_outhdr->pBuffer, ap_br->pid,
+                     ap_br->p_outhdr->nFilledLen);
+          ap_br->p_outhdr->nFilledLen = 0;
+          ap_br->p_outhdr->nOffset = 0;
+          ap_br->p_outhdr->nFlags = 0;
           rc = true;
         }
     }
@@ -242,6 +567,98 @@ claim_output (const void * ap_obj)
   return rc;
 }
 
+/* Each active branch claims its own output buffer; one that can't get one
+   doesn't stop the others */
+static void
+claim_outputs (mp3e_prc_t * ap_prc, bool * ap_progress)
+{
+  OMX_U32 i = 0;
+  assert (ap_prc);
+  assert (ap_progress);
+
+  for (i = 0; i < ap_prc->nbranches_; ++i)
+    {
+      mp3e_branch_t * p_br = &(ap_prc->branches_[i]);
+      if (p_br->active && !p_br->p_outhdr && claim_output (ap_prc, p_br))
+        {
+          *ap_progress = true;
+        }
+    }
+}
+
+static bool
+eos_pending (const mp3e_prc_t * ap_prc)
+{
+  OMX_U32 i = 0;
+  assert (ap_prc);
+  for (i = 0; i < ap_prc->nbranches_; ++i)
+    {
+      if (ap_prc->branches_[i].eos_pending)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+/* The first output is always in use; the others only carry a stream while
+   they are enabled and tunneled to something */
+static bool
+is_branch_active (const mp3e_prc_t * ap_prc, const mp3e_branch_t * ap_br)
+{
+  const void * p_port = NULL;
+  assert (ap_prc);
+  assert (ap_br);
+  p_port = tiz_krn_get_port (tiz_get_krn (handleOf (ap_prc)), ap_br->pid);
+  return p_port && TIZ_PORT_IS_ENABLED (p_port)
+         && !TIZ_PORT_IS_BEING_DISABLED (p_port)
+         && (ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX == ap_br->pid
+             || TIZ_PORT_IS_TUNNELED (p_port));
+}
+
+static OMX_ERRORTYPE
+update_active_branches (mp3e_prc_t * ap_prc)
+{
+  OMX_U32 i = 0;
+  assert (ap_prc);
+  for (i = 0; i < ap_prc->nbranches_; ++i)
+    {
+      mp3e_branch_t * p_br = &(ap_prc->branches_[i]);
+      const bool active = is_branch_active (ap_prc, p_br);
+      if (p_br->active && !active)
+        {
+          tiz_check_omx (clear_branch (ap_prc, p_br));
+        }
+      p_br->active = active;
+    }
+  return OMX_ErrorNone;
+}
+
+static void
+start_input (mp3e_prc_t * ap_prc)
+{
+  const bool eos = (ap_prc->p_inhdr_->nFlags & OMX_BUFFERFLAG_EOS) != 0;
+  OMX_U32 i = 0;
+
+  TIZ_TRACE (handleOf (ap_prc),
+             "p_inhdr [%p] nFilledLen [%d] nOffset [%d] "
+             "nChannels [%d] nBitPerSample [%d] nbranches [%d]",
+             ap_prc->p_inhdr_, ap_prc->p_inhdr_->nFilledLen,
+             ap_prc->p_inhdr_->nOffset, ap_prc->pcmmode_.nChannels,
+             ap_prc->pcmmode_.nBitPerSample, ap_prc->nbranches_);
+
+  for (i = 0; i < ap_prc->nbranches_; ++i)
+    {
+      mp3e_branch_t * p_br = &(ap_prc->branches_[i]);
+      if (p_br->active)
+        {
+          p_br->in_offset = 0;
+          p_br->input_pending = true;
+          p_br->eos_pending = eos;
+        }
+    }
+}
+
 static OMX_ERRORTYPE
 set_lame_pcm_settings (void * ap_obj, OMX_HANDLETYPE ap_hdl, void * ap_krn)
 {
@@ -280,23 +697,26 @@ set_lame_pcm_settings (void * ap_obj, OMX_HANDLETYPE ap_hdl, void * ap_krn)
 }
 
 static OMX_ERRORTYPE
-set_lame_mp3_settings (void * ap_obj, OMX_HANDLETYPE ap_hdl, void * ap_krn)
+set_lame_mp3_settings (void * ap_obj, mp3e_branch_t * ap_br,
+                       OMX_HANDLETYPE ap_hdl, void * ap_krn)
 {
   mp3e_prc_t * p_prc = ap_obj;
   OMX_ERRORTYPE ret_val = OMX_ErrorNone;
   int lame_mode = 0;
 
   assert (p_prc);
+  assert (ap_br);
   assert (ap_hdl);
   assert (ap_krn);
 
   /* Retrieve mp3 params from port */
-  p_prc->mp3type_.nSize = sizeof (OMX_AUDIO_PARAM_MP3TYPE);
-  p_prc->mp3type_.nVersion.nVersion = OMX_VERSION;
-  p_prc->mp3type_.nPortIndex = 1;
+  ap_br->mp3type.nSize = sizeof (OMX_AUDIO_PARAM_MP3TYPE);
+  ap_br->mp3type.nVersion.nVersion = OMX_VERSION;
+  ap_br->mp3type.nPortIndex = ap_br->pid;
   if (OMX_ErrorNone
-      != (ret_val = tiz_api_GetParameter (
-            ap_krn, ap_hdl, OMX_IndexParamAudioMp3, &p_prc->mp3type_)))
+      != (ret_val = tiz_api_GetParameter (ap_krn, ap_hdl,
+                                          OMX_IndexParamAudioMp3,
+                                          &ap_br->mp3type)))
     {
       TIZ_ERROR (handleOf (p_prc),
                  "[%s] : Error retrieving mp3 params from port",
@@ -305,18 +725,21 @@ set_lame_mp3_settings (void * ap_obj, OMX_HANDLETYPE ap_hdl, void * ap_krn)
     }
 
   TIZ_ERROR (handleOf (p_prc),
-             "nChannels = [%d] nBitRate = [%d] "
+             "port [%d] nChannels = [%d] nBitRate = [%d] "
              "nSampleRate = [%d] nAudioBandWidth = [%d] eChannelMode = [%d] "
              "eFormat = [%d]",
-             p_prc->mp3type_.nChannels, p_prc->mp3type_.nBitRate,
-             p_prc->mp3type_.nSampleRate, p_prc->mp3type_.nAudioBandWidth,
-             p_prc->mp3type_.eChannelMode, p_prc->mp3type_.eFormat);
-
-  (void) lame_set_num_channels (p_prc->lame_, p_prc->mp3type_.nChannels);
-  (void) lame_set_in_samplerate (p_prc->lame_, p_prc->mp3type_.nSampleRate);
-  (void) lame_set_brate (p_prc->lame_, p_prc->mp3type_.nBitRate);
-
-  switch (p_prc->mp3type_.eChannelMode)
+             ap_br->pid, ap_br->mp3type.nChannels, ap_br->mp3type.nBitRate,
+             ap_br->mp3type.nSampleRate, ap_br->mp3type.nAudioBandWidth,
+             ap_br->mp3type.eChannelMode, ap_br->mp3type.eFormat);
+
+  (void) lame_set_num_channels (ap_br->lame, ap_br->mp3type.nChannels);
+  (void) lame_set_in_samplerate (ap_br->lame, ap_br->mp3type.nSampleRate);
+  /* lame wants kbps; accept the bitrate in either unit */
+  (void) lame_set_brate (ap_br->lame, ap_br->mp3type.nBitRate >= 1000
+                                        ? ap_br->mp3type.nBitRate / 1000
+                                        : ap_br->mp3type.nBitRate);
+
+  switch (ap_br->mp3type.eChannelMode)
     {
       case OMX_AUDIO_ChannelModeStereo:
         {
@@ -346,12 +769,138 @@ set_lame_mp3_settings (void * ap_obj, OMX_HANDLETYPE ap_hdl, void * ap_krn)
         }
     };
 
-  (void) lame_set_mode (p_prc->lame_, lame_mode);
-  (void) lame_set_quality (p_prc->lame_, 2); /* 2=high  5 = medium  7=low */
+  (void) lame_set_mode (ap_br->lame, lame_mode);
+  (void) lame_set_quality (ap_br->lame, 2); /* 2=high  5 = medium  7=low */
 
   return ret_val;
 }
 
+static OMX_ERRORTYPE
+reset_branch_encoder (mp3e_prc_t * ap_prc, mp3e_branch_t * ap_br)
+{
+  assert (ap_prc);
+  assert (ap_br);
+
+  if (ap_br->lame)
+    {
+      lame_close (ap_br->lame);
+    }
+
+  if (NULL == (ap_br->lame = lame_init ()))
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[OMX_ErrorInsufficientResources] : "
+                 "lame encoder initialization error");
+      return OMX_ErrorInsufficientResources;
+    }
+
+  (void) lame_set_errorf (ap_br->lame, lame_debugf);
+  (void) lame_set_debugf (ap_br->lame, lame_debugf);
+  (void) lame_set_msgf (ap_br->lame, lame_debugf);
+
+  tiz_check_omx (set_lame_mp3_settings (ap_prc, ap_br, handleOf (ap_prc),
+                                        tiz_get_krn (handleOf (ap_prc))));
+
+  if (-1 == lame_init_params (ap_br->lame))
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[OMX_ErrorInsufficientResources] : "
+                 "Error returned by lame during initialization.");
+      return OMX_ErrorInsufficientResources;
+    }
+
+  return OMX_ErrorNone;
+}
+
+static void
+stop_branches (mp3e_prc_t * ap_prc)
+{
+  OMX_U32 i = 0;
+  assert (ap_prc);
+
+  ap_prc->workers_exit_ = true;
+  for (i = 0; i < ap_prc->nbranches_; ++i)
+    {
+      mp3e_branch_t * p_br = &(ap_prc->branches_[i]);
+      if (p_br->thread_running)
+        {
+          void * p_result = NULL;
+          (void) tiz_sem_post (&(p_br->sem));
+          (void) tiz_thread_join (&(p_br->thread), &p_result);
+          (void) tiz_sem_destroy (&(p_br->sem));
+          p_br->thread_running = false;
+        }
+      if (p_br->lame)
+        {
+          lame_close (p_br->lame);
+          p_br->lame = NULL;
+        }
+      tiz_buffer_destroy (p_br->p_backlog);
+      p_br->p_backlog = NULL;
+    }
+
+  if (ap_prc->nbranches_ > 0)
+    {
+      (void) tiz_sem_destroy (&(ap_prc->done_sem_));
+      ap_prc->nbranches_ = 0;
+    }
+  ap_prc->workers_exit_ = false;
+}
+
+/* The branch's encoder is created when the component starts processing */
+static OMX_ERRORTYPE
+start_branch (mp3e_prc_t * ap_prc, const OMX_U32 a_idx)
+{
+  mp3e_branch_t * p_br = NULL;
+
+  assert (ap_prc);
+  assert (a_idx < ARATELIA_MP3_ENCODER_MAX_OUTPUT_PORTS);
+
+  p_br = &(ap_prc->branches_[a_idx]);
+  p_br->p_prc = ap_prc;
+  p_br->pid = ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX + a_idx;
+  p_br->lame = NULL;
+  p_br->p_outhdr = NULL;
+  p_br->p_backlog = NULL;
+  p_br->in_offset = 0;
+  p_br->active = false;
+  p_br->input_pending = false;
+  p_br->output_full = false;
+  p_br->eos_pending = false;
+  p_br->thread_running = false;
+
+  tiz_check_omx (tiz_buffer_init (&(p_br->p_backlog), INPUT_BUFFER_SIZE));
+
+  /* The first branch is encoded on the component's own thread */
+  if (a_idx > 0)
+    {
+      char name[16];
+      tiz_check_omx (tiz_sem_init (&(p_br->sem), 0));
+      if (OMX_ErrorNone
+          != tiz_thread_create (&(p_br->thread), 0, 0, branch_thread_func,
+                                p_br))
+        {
+          (void) tiz_sem_destroy (&(p_br->sem));
+          return OMX_ErrorInsufficientResources;
+        }
+      p_br->thread_running = true;
+      snprintf (name, sizeof (name), "tizmp3enc:%u", (unsigned) p_br->pid);
+      (void) tiz_thread_setname (&(p_br->thread), name);
+    }
+
+  return OMX_ErrorNone;
+}
+
+static mp3e_branch_t *
+get_branch (mp3e_prc_t * ap_prc, const OMX_U32 a_pid)
+{
+  assert (ap_prc);
+  return (a_pid >= ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX
+          && a_pid - ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX < ap_prc->nbranches_)
+           ? &(ap_prc->branches_[a_pid - ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX])
+           : NULL;
+}
+
 /*
  * mp3eprc
  */
@@ -361,12 +910,9 @@ mp3e_proc_ctor (void * ap_obj, va_list * app)
 {
   mp3e_prc_t * p_prc = super_ctor (typeOf (ap_obj, "mp3eprc"), ap_obj, app);
   assert (p_prc);
-  p_prc->lame_ = NULL;
-  p_prc->frame_size_ = 0;
+  p_prc->nbranches_ = 0;
+  p_prc->workers_exit_ = false;
   p_prc->p_inhdr_ = 0;
-  p_prc->p_outhdr_ = 0;
-  p_prc->eos_ = false;
-  p_prc->lame_flushed_ = true;
   return p_prc;
 }
 
@@ -376,11 +922,7 @@ mp3e_proc_dtor (void * ap_obj)
   mp3e_prc_t * p_prc = ap_obj;
   assert (p_prc);
 
-  if (p_prc->lame_)
-    {
-      lame_close (p_prc->lame_);
-      p_prc->lame_ = NULL;
-    }
+  stop_branches (p_prc);
 
   return super_dtor (typeOf (ap_obj, "mp3eprc"), ap_obj);
 }
@@ -393,24 +935,38 @@ static OMX_ERRORTYPE
 mp3e_proc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
 {
   mp3e_prc_t * p_prc = ap_obj;
+  OMX_PORT_PARAM_TYPE port_param;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  OMX_U32 nbranches = 0;
+  OMX_U32 i = 0;
+
   assert (p_prc);
+  assert (0 == p_prc->nbranches_);
+
+  /* One branch per output port */
+  TIZ_INIT_OMX_STRUCT (port_param);
+  tiz_check_omx (tiz_api_GetParameter (tiz_get_krn (handleOf (p_prc)),
+                                       handleOf (p_prc),
+                                       OMX_IndexParamAudioInit, &port_param));
+  nbranches = MIN (MAX (port_param.nPorts, 2) - 1,
+                   ARATELIA_MP3_ENCODER_MAX_OUTPUT_PORTS);
+
+  TIZ_TRACE (handleOf (p_prc), "lame encoder version [%s] nbranches [%d]",
+             get_lame_version (), nbranches);
 
-  if (NULL == (p_prc->lame_ = lame_init ()))
+  tiz_check_omx (tiz_sem_init (&(p_prc->done_sem_), 0));
+  for (i = 0; i < nbranches && OMX_ErrorNone == rc; ++i)
     {
-      TIZ_ERROR (handleOf (p_prc),
-                 "[OMX_ErrorInsufficientResources] : "
-                 "lame encoder initialization error");
-      return OMX_ErrorInsufficientResources;
+      p_prc->nbranches_ = i + 1;
+      rc = start_branch (p_prc, i);
     }
 
-  TIZ_TRACE (handleOf (p_prc), "lame encoder version [%s]",
-             get_lame_version ());
-
-  (void) lame_set_errorf (p_prc->lame_, lame_debugf);
-  (void) lame_set_debugf (p_prc->lame_, lame_debugf);
-  (void) lame_set_msgf (p_prc->lame_, lame_debugf);
+  if (OMX_ErrorNone != rc)
+    {
+      stop_branches (p_prc);
+    }
 
-  return OMX_ErrorNone;
+  return rc;
 }
 
 static OMX_ERRORTYPE
@@ -418,13 +974,7 @@ mp3e_proc_deallocate_resources (void * ap_obj)
 {
   mp3e_prc_t * p_prc = ap_obj;
   assert (p_prc);
-
-  if (p_prc->lame_)
-    {
-      lame_close (p_prc->lame_);
-      p_prc->lame_ = NULL;
-    }
-
+  stop_branches (p_prc);
   return OMX_ErrorNone;
 }
 
@@ -432,40 +982,30 @@ static OMX_ERRORTYPE
 mp3e_proc_prepare_to_transfer (void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
 {
   mp3e_prc_t * p_prc = ap_obj;
-  OMX_ERRORTYPE ret_val = OMX_ErrorNone;
+  OMX_U32 i = 0;
 
   assert (p_prc);
 
-  if (NULL == p_prc->lame_)
+  if (0 == p_prc->nbranches_)
     {
       return OMX_ErrorNone;
     }
 
-  if (OMX_ErrorNone
-      != (ret_val = set_lame_mp3_settings (p_prc, handleOf (p_prc),
-                                           tiz_get_krn (handleOf (p_prc)))))
-    {
-      return ret_val;
-    }
-
-  if (OMX_ErrorNone
-      != (ret_val = set_lame_pcm_settings (p_prc, handleOf (p_prc),
-                                           tiz_get_krn (handleOf (p_prc)))))
-    {
-      return ret_val;
-    }
+  tiz_check_omx (set_lame_pcm_settings (p_prc, handleOf (p_prc),
+                                        tiz_get_krn (handleOf (p_prc))));
 
-  if (-1 == lame_init_params (p_prc->lame_))
+  for (i = 0; i < p_prc->nbranches_; ++i)
     {
-      TIZ_ERROR (handleOf (p_prc),
-                 "[OMX_ErrorInsufficientResources] : "
-                 "Error returned by lame during initialization.");
-      return OMX_ErrorInsufficientResources;
+      mp3e_branch_t * p_br = &(p_prc->branches_[i]);
+      p_br->active = false;
+      tiz_check_omx (clear_branch (p_prc, p_br));
+      if (!p_br->lame)
+        {
+          tiz_check_omx (reset_branch_encoder (p_prc, p_br));
+        }
     }
 
-  p_prc->lame_flushed_ = false;
-
-  return OMX_ErrorNone;
+  return update_active_branches (p_prc);
 }
 
 static OMX_ERRORTYPE
@@ -488,71 +1028,78 @@ static OMX_ERRORTYPE
 mp3e_proc_buffers_ready (const void * ap_obj)
 {
   mp3e_prc_t * p_prc = (mp3e_prc_t *) ap_obj;
+  bool progress = true;
   assert (p_prc);
 
-  while (1)
-    {
-
-      if (!p_prc->p_inhdr_)
-        {
-          if (!claim_input (p_prc) || (!p_prc->p_inhdr_))
-            {
-              break;
-            }
-        }
-
-      if (!p_prc->p_outhdr_)
-        {
-          if (!claim_output (p_prc))
-            {
-              break;
-            }
-        }
+  tiz_check_omx (update_active_branches (p_prc));
 
-      tiz_check_omx (encode_buffer (p_prc));
-      if (p_prc->p_inhdr_ && (0 == p_prc->p_inhdr_->nFilledLen))
+  while (progress)
+    {
+      progress = false;
+      tiz_check_omx (release_outputs (p_prc, &progress));
+      claim_outputs (p_prc, &progress);
+      tiz_check_omx (store_input (p_prc, &progress));
+
+      /* The next stream can't start until every branch has flushed its
+         encoder */
+      if (!p_prc->p_inhdr_ && !eos_pending (p_prc) && claim_input (p_prc))
         {
-          p_prc->p_inhdr_->nOffset = 0;
-          tiz_krn_release_buffer (tiz_get_krn (handleOf (p_prc)),
-                                  ARATELIA_MP3_ENCODER_INPUT_PORT_INDEX,
-                                  p_prc->p_inhdr_);
-          p_prc->p_inhdr_ = NULL;
+          start_input (p_prc);
+          progress = true;
         }
-    }
 
-  if (p_prc->eos_ && p_prc->lame_flushed_ && p_prc->p_outhdr_)
-    {
-      /* EOS has been received and all the input data has been consumed
-       * already, so its time to propagate the EOS flag */
-      TIZ_TRACE (handleOf (p_prc), "p_prc->eos OUTPUT HEADER [%p]...",
-                 p_prc->p_outhdr_);
-      p_prc->p_outhdr_->nFlags |= OMX_BUFFERFLAG_EOS;
-      tiz_krn_release_buffer (tiz_get_krn (handleOf (p_prc)),
-                              ARATELIA_MP3_ENCODER_OUTPUT_PORT_INDEX,
-                              p_prc->p_outhdr_);
-      p_prc->p_outhdr_ = NULL;
+      tiz_check_omx (encode_branches (p_prc, &progress));
     }
 
   return OMX_ErrorNone;
 }
 
+/* A command on an output port only affects that port's branch; one on the
+   input port affects them all */
 static OMX_ERRORTYPE
-mp3e_proc_port_flush (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
+mp3e_proc_port_flush (const void * ap_obj, OMX_U32 a_pid)
 {
-  /* Release all buffers, regardless of the port this is received on */
-  return release_buffers (ap_obj);
+  mp3e_prc_t * p_prc = (mp3e_prc_t *) ap_obj;
+  mp3e_branch_t * p_br = get_branch (p_prc, a_pid);
+  return p_br ? clear_branch (p_prc, p_br) : release_buffers (ap_obj);
 }
 
 static OMX_ERRORTYPE
-mp3e_proc_port_disable (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
+mp3e_proc_port_disable (const void * ap_obj, OMX_U32 a_pid)
 {
-  /* Release all buffers, regardless of the port this is received on */
-  return release_buffers (ap_obj);
+  mp3e_prc_t * p_prc = (mp3e_prc_t *) ap_obj;
+  mp3e_branch_t * p_br = get_branch (p_prc, a_pid);
+  OMX_U32 i = 0;
+
+  if (p_br)
+    {
+      p_br->active = false;
+      return clear_branch (p_prc, p_br);
+    }
+
+  if (ARATELIA_MP3_ENCODER_INPUT_PORT_INDEX != a_pid)
+    {
+      return release_buffers (ap_obj);
+    }
+
+  /* The input is disabled between tracks, e.g.; the outputs carry on with
+     what they have already been given */
+  for (i = 0; i < p_prc->nbranches_; ++i)
+    {
+      if (p_prc->branches_[i].input_pending
+          && !backlog_input (&(p_prc->branches_[i])))
+        {
+          return OMX_ErrorInsufficientResources;
+        }
+    }
+  return p_prc->p_inhdr_ ? release_input (p_prc) : OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
 mp3e_proc_port_enable (const void * ap_obj, OMX_U32 a_pid)
 {
+  /* The branch joins in with the next input buffer (see
+     update_active_branches) */
   return OMX_ErrorNone;
 }
 
@@ -33,6 +33,7 @@
 extern "C" {
 #endif
 
+#include "mp3e.h"
 #include "mp3eprc.h"
 #include "tizprc_decls.h"
 
@@ -41,22 +42,50 @@ extern "C" {
 #include <stdbool.h>
 #include <lame/lame.h>
 
+#include <tizplatform.h>
+
 #define INPUT_BUFFER_SIZE (5 * 8192)
 #define OUTPUT_BUFFER_SIZE 8192 /* Must be an integer multiple of 4. */
+/* PCM held for a branch whose output port is not keeping up; about 5 seconds
+   of 48KHz stereo audio. The oldest data is dropped beyond this. */
+#define MAX_BACKLOG_SIZE (1024 * 1024)
 
 typedef struct mp3e_prc mp3e_prc_t;
+
+/* One encoding of the input stream, delivered on its own output port. A
+   branch encodes the input buffer in place when it can; otherwise it keeps a
+   copy in its backlog, so that the input buffer can be returned without
+   waiting for it. Every branch but the first runs on its own worker
+   thread. */
+typedef struct mp3e_branch mp3e_branch_t;
+struct mp3e_branch
+{
+  mp3e_prc_t * p_prc;
+  OMX_U32 pid;
+  OMX_AUDIO_PARAM_MP3TYPE mp3type;
+  lame_t lame;
+  OMX_BUFFERHEADERTYPE * p_outhdr;
+  tiz_buffer_t * p_backlog;
+  OMX_U32 in_offset;  /* how much of the current input buffer is encoded */
+  bool active;        /* enabled, and tunneled unless it's the first output */
+  bool input_pending; /* the current input buffer is still to be encoded */
+  bool output_full;
+  bool eos_pending;   /* EOS is to be sent once the backlog is encoded */
+  tiz_thread_t thread;
+  tiz_sem_t sem; /* posted when there is work for the thread */
+  bool thread_running;
+};
+
 struct mp3e_prc
 {
   /* Object */
   const tiz_prc_t _;
   OMX_AUDIO_PARAM_PCMMODETYPE pcmmode_;
-  OMX_AUDIO_PARAM_MP3TYPE mp3type_;
-  lame_t lame_;
-  int frame_size_;
+  OMX_U32 nbranches_;
+  mp3e_branch_t branches_[ARATELIA_MP3_ENCODER_MAX_OUTPUT_PORTS];
+  tiz_sem_t done_sem_; /* posted by a worker when its branch is encoded */
+  bool workers_exit_;
   OMX_BUFFERHEADERTYPE * p_inhdr_;
-  OMX_BUFFERHEADERTYPE * p_outhdr_;
-  bool eos_;
-  bool lame_flushed_;
 };
 
 typedef struct mp3e_prc_class mp3e_prc_class_t;
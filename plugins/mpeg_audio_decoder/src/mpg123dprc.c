@@ -517,6 +517,26 @@ static OMX_ERRORTYPE mpg123d_prc_buffers_ready (const void *ap_prc)
 static OMX_ERRORTYPE mpg123d_proc_port_flush (const void *ap_prc, OMX_U32 a_pid)
 {
   mpg123d_prc_t *p_prc = (mpg123d_prc_t *)ap_prc;
+  assert (p_prc);
+  if ((OMX_ALL == a_pid || ARATELIA_MPG123_DECODER_INPUT_PORT_INDEX == a_pid)
+      && p_prc->p_mpg123_)
+    {
+      /* Reopening the feed drops the data buffered in libmpg123 and the
+         decoder's state (e.g. after a seek) */
+      int ret = mpg123_close (p_prc->p_mpg123_);
+      if (MPG123_OK == ret)
+        {
+          ret = mpg123_open_feed (p_prc->p_mpg123_);
+        }
+      if (MPG123_OK != ret)
+        {
+          TIZ_ERROR (handleOf (p_prc),
+                     "[OMX_ErrorInsufficientResources] : "
+                     "reopening the feed : [%s]",
+                     mpg123_plain_strerror (ret));
+          return OMX_ErrorInsufficientResources;
+        }
+    }
   reset_stream_parameters (p_prc);
   return tiz_filter_prc_release_header (p_prc, a_pid);
 }
@@ -235,7 +235,10 @@ alloc_oggz (oggdmux_prc_t * ap_prc)
   assert (!ap_prc->p_oggz_);
 
   /* Allocate the oggz object */
-  tiz_check_null_ret_oom ((ap_prc->p_oggz_ = oggz_new (OGGZ_READ)));
+  /* OGGZ_AUTO sets the granulepos metrics of known codecs, which are needed
+   * for time-based seeking */
+  tiz_check_null_ret_oom (
+    (ap_prc->p_oggz_ = oggz_new (OGGZ_READ | OGGZ_AUTO)));
 
   /* Allocate a table */
   tiz_check_null_ret_oom ((ap_prc->p_tracks_ = oggz_table_new ()));
@@ -895,6 +898,42 @@ seek_to_byte_offset (oggdmux_prc_t * ap_prc, const oggz_off_t a_offset)
   return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE
+seek_to_time (oggdmux_prc_t * ap_prc, const OMX_TICKS a_time)
+{
+  ogg_int64_t units = 0;
+  assert (ap_prc);
+
+  if (!ap_prc->p_oggz_)
+    {
+      return OMX_ErrorIncorrectStateOperation;
+    }
+
+  /* Data already demuxed from the old position is discarded; oggz bisects the
+   * file using the page granulepos, so this is not proportional to file
+   * size */
+  ap_prc->aud_store_offset_ = 0;
+  ap_prc->vid_store_offset_ = 0;
+  if ((units = oggz_seek_units (ap_prc->p_oggz_,
+                                a_time > 0 ? a_time / 1000 : 0, SEEK_SET))
+      < 0)
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[OMX_ErrorUnsupportedSetting] : "
+                 "Could not seek to [%lld] ms",
+                 (long long) (a_time / 1000));
+      return OMX_ErrorUnsupportedSetting;
+    }
+
+  TIZ_NOTICE (handleOf (ap_prc), "Seek to [%lld] ms : landed at [%lld] ms",
+              (long long) (a_time / 1000), (long long) units);
+
+  ap_prc->file_eos_ = false;
+  ap_prc->aud_eos_ = false;
+  ap_prc->vid_eos_ = false;
+  return OMX_ErrorNone;
+}
+
 static inline OMX_ERRORTYPE
 set_read_page_callback (oggdmux_prc_t * ap_prc, OggzReadPage ap_read_cback)
 {
@@ -1241,6 +1280,93 @@ oggdmux_prc_port_enable (const void * ap_obj, OMX_U32 a_pid)
   return OMX_ErrorNone;
 }
 
+/*
+ * from tiz_api
+ */
+
+static OMX_ERRORTYPE
+oggdmux_prc_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                       OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  oggdmux_prc_t * p_prc = (oggdmux_prc_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (p_prc);
+  assert (ap_struct);
+
+  switch (a_index)
+    {
+      case OMX_IndexConfigTimePosition:
+        {
+          OMX_TIME_CONFIG_TIMESTAMPTYPE * p_pos = ap_struct;
+          if (!p_prc->p_oggz_)
+            {
+              rc = OMX_ErrorIncorrectStateOperation;
+            }
+          else
+            {
+              p_pos->nTimestamp
+                = (OMX_TICKS) oggz_tell_units (p_prc->p_oggz_) * 1000;
+            }
+        }
+        break;
+
+      case OMX_IndexConfigTimeSeekMode:
+        {
+          /* Seeking is accurate to the Ogg page only */
+          OMX_TIME_CONFIG_SEEKMODETYPE * p_seek_mode = ap_struct;
+          p_seek_mode->eType = OMX_TIME_SeekModeFast;
+        }
+        break;
+
+      default:
+        {
+          rc = super_GetConfig (typeOf (ap_obj, "oggdmuxprc"), ap_obj, ap_hdl,
+                                a_index, ap_struct);
+        }
+    };
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+oggdmux_prc_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                       OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  oggdmux_prc_t * p_prc = (oggdmux_prc_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (p_prc);
+  assert (ap_struct);
+
+  switch (a_index)
+    {
+      case OMX_IndexConfigTimePosition:
+        {
+          const OMX_TIME_CONFIG_TIMESTAMPTYPE * p_pos = ap_struct;
+          rc = seek_to_time (p_prc, p_pos->nTimestamp);
+        }
+        break;
+
+      case OMX_IndexConfigTimeSeekMode:
+        {
+          const OMX_TIME_CONFIG_SEEKMODETYPE * p_seek_mode = ap_struct;
+          rc = (OMX_TIME_SeekModeFast == p_seek_mode->eType
+                  ? OMX_ErrorNone
+                  : OMX_ErrorUnsupportedSetting);
+        }
+        break;
+
+      default:
+        {
+          rc = super_SetConfig (typeOf (ap_obj, "oggdmuxprc"), ap_obj, ap_hdl,
+                                a_index, ap_struct);
+        }
+    };
+
+  return rc;
+}
+
 /*
  * oggdmux_prc_class
  */
@@ -1305,6 +1431,10 @@ oggdmux_prc_init (void * ap_tos, void * ap_hdl)
      tiz_prc_port_enable, oggdmux_prc_port_enable,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_buffers_ready, oggdmux_prc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_GetConfig, oggdmux_prc_GetConfig,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_SetConfig, oggdmux_prc_SetConfig,
      /* TIZ_CLASS_COMMENT: stop value*/
      0);
 
@@ -44,20 +44,6 @@
 #include "opusdprc.h"
 #include "opusdprc_decls.h"
 
-#ifdef HAVE_LRINTF
-#define float2int(x) lrintf (x)
-#else
-#define float2int(flt) ((int) (floor (.5 + flt)))
-#endif
-
-#ifndef HAVE_FMINF
-#define fminf(_x, _y) ((_x) < (_y) ? (_x) : (_y))
-#endif
-
-#ifndef HAVE_FMAXF
-#define fmaxf(_x, _y) ((_x) > (_y) ? (_x) : (_y))
-#endif
-
 #ifdef TIZ_LOG_CATEGORY_NAME
 #undef TIZ_LOG_CATEGORY_NAME
 #define TIZ_LOG_CATEGORY_NAME "tiz.opus_decoder.prc"
@@ -424,7 +410,6 @@ transform_buffer (opusd_prc_t * ap_prc)
     float * output = NULL;
     short * out = NULL;
     unsigned out_len = 0;
-    int i = 0;
     int tmp_skip = 0;
     int frame_size = opus_multistream_decode_float (ap_prc->p_opus_dec_, p_data,
                                                     len, ap_prc->p_out_buf_,
@@ -446,11 +431,7 @@ transform_buffer (opusd_prc_t * ap_prc)
 
         /* Convert to short and save to output file */
         out = (short *) (p_out->pBuffer + p_out->nOffset);
-        for (i = 0; i < (int) out_len * ap_prc->channels_; ++i)
-          {
-            out[i] = (short) float2int (
-              fmaxf (-32768, fminf (output[i] * 32768.f, 32767)));
-          }
+        tiz_dsp_f32_to_s16 (out, output, out_len * ap_prc->channels_, NULL);
 
         if ((p_in->nFlags & OMX_BUFFERFLAG_EOS) > 0)
           {
@@ -662,6 +643,16 @@ static OMX_ERRORTYPE
 opusd_prc_port_flush (const void * ap_obj, OMX_U32 a_pid)
 {
   opusd_prc_t * p_obj = (opusd_prc_t *) ap_obj;
+  assert (p_obj);
+  if ((OMX_ALL == a_pid || ARATELIA_OPUS_DECODER_INPUT_PORT_INDEX == a_pid)
+      && p_obj->p_opus_dec_)
+    {
+      /* Forget the decoder's history (e.g. after a seek); the stream headers
+         already parsed still apply */
+      opus_multistream_decoder_ctl (p_obj->p_opus_dec_, OPUS_RESET_STATE);
+      reset_output_buffer (p_obj);
+      p_obj->eos_ = false;
+    }
   return release_headers (p_obj, a_pid);
 }
 
@@ -435,6 +435,11 @@ static OMX_ERRORTYPE
 opusfiled_proc_port_flush (const void * ap_prc, OMX_U32 a_pid)
 {
   opusfiled_prc_t * p_prc = (opusfiled_prc_t *) ap_prc;
+  assert (p_prc);
+  /* The decoder is opened again on the data that follows; opusfile has no
+     way to resync an open handle on a new stream position */
+  op_free (p_prc->p_opus_dec_);
+  p_prc->p_opus_dec_ = NULL;
   reset_stream_parameters (p_prc);
   return tiz_filter_prc_release_header (p_prc, a_pid);
 }
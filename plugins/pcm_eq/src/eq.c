@@ -0,0 +1,187 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   eq.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Parametric equalizer component
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMX_Types.h>
+
+#include <tizplatform.h>
+
+#include <tizport.h>
+#include <tizscheduler.h>
+
+#include "eqcfgport.h"
+#include "eqprc.h"
+#include "eq.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.eq"
+#endif
+
+/**
+ *@defgroup libtizeq 'libtizeq' : OpenMAX IL parametric equalizer
+ *
+ * - Component name : "OMX.Aratelia.audio_processor.eq"
+ * - Implements role: "audio_processor.eq"
+ *
+ * The output port follows the pcm settings of the input port. The filters
+ * are configured with OMX_TizoniaIndexConfigAudioEqualizer, at any time.
+ *
+ *@ingroup plugins
+ */
+
+static OMX_VERSIONTYPE eq_version = {{1, 0, 0, 0}};
+
+static OMX_PTR
+instantiate_pcm_port (OMX_HANDLETYPE ap_hdl, const OMX_U32 a_port_id,
+                      const OMX_DIRTYPE a_dir, const OMX_U32 a_buf_size,
+                      const OMX_U32 a_mos_port)
+{
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmmode;
+  OMX_AUDIO_CONFIG_VOLUMETYPE volume;
+  OMX_AUDIO_CONFIG_MUTETYPE mute;
+  OMX_AUDIO_CODINGTYPE encodings[] = {OMX_AUDIO_CodingPCM, OMX_AUDIO_CodingMax};
+  tiz_port_options_t pcm_port_opts = {
+    OMX_PortDomainAudio,
+    a_dir,
+    ARATELIA_EQ_PORT_MIN_BUF_COUNT,
+    a_buf_size,
+    ARATELIA_EQ_PORT_NONCONTIGUOUS,
+    ARATELIA_EQ_PORT_ALIGNMENT,
+    ARATELIA_EQ_PORT_SUPPLIERPREF,
+    {a_port_id, NULL, NULL, NULL},
+    a_mos_port
+  };
+
+  pcmmode.nSize = sizeof (OMX_AUDIO_PARAM_PCMMODETYPE);
+  pcmmode.nVersion.nVersion = OMX_VERSION;
+  pcmmode.nPortIndex = a_port_id;
+  pcmmode.nChannels = 2;
+  pcmmode.eNumData = OMX_NumericalDataSigned;
+  pcmmode.eEndian = OMX_EndianLittle;
+  pcmmode.bInterleaved = OMX_TRUE;
+  pcmmode.nBitPerSample = 16;
+  pcmmode.nSamplingRate = 48000;
+  pcmmode.ePCMMode = OMX_AUDIO_PCMModeLinear;
+  pcmmode.eChannelMapping[0] = OMX_AUDIO_ChannelLF;
+  pcmmode.eChannelMapping[1] = OMX_AUDIO_ChannelRF;
+
+  volume.nSize = sizeof (OMX_AUDIO_CONFIG_VOLUMETYPE);
+  volume.nVersion.nVersion = OMX_VERSION;
+  volume.nPortIndex = a_port_id;
+  volume.bLinear = OMX_FALSE;
+  volume.sVolume.nValue = 50;
+  volume.sVolume.nMin = 0;
+  volume.sVolume.nMax = 100;
+
+  mute.nSize = sizeof (OMX_AUDIO_CONFIG_MUTETYPE);
+  mute.nVersion.nVersion = OMX_VERSION;
+  mute.nPortIndex = a_port_id;
+  mute.bMute = OMX_FALSE;
+
+  return factory_new (tiz_get_type (ap_hdl, "tizpcmport"), &pcm_port_opts,
+                      &encodings, &pcmmode, &volume, &mute);
+}
+
+static OMX_PTR
+instantiate_input_port (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_pcm_port (ap_hdl, ARATELIA_EQ_INPUT_PORT_INDEX,
+                               OMX_DirInput,
+                               ARATELIA_EQ_PORT_MIN_INPUT_BUF_SIZE,
+                               1 /* slave port's index  */);
+}
+
+static OMX_PTR
+instantiate_output_port (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_pcm_port (ap_hdl, ARATELIA_EQ_OUTPUT_PORT_INDEX,
+                               OMX_DirOutput,
+                               ARATELIA_EQ_PORT_MIN_OUTPUT_BUF_SIZE,
+                               0 /* Master port */);
+}
+
+static OMX_PTR
+instantiate_config_port (OMX_HANDLETYPE ap_hdl)
+{
+  return factory_new (tiz_get_type (ap_hdl, "eqcfgport"),
+                      NULL, /* this port does not take options */
+                      ARATELIA_EQ_COMPONENT_NAME, eq_version);
+}
+
+static OMX_PTR
+instantiate_processor (OMX_HANDLETYPE ap_hdl)
+{
+  return factory_new (tiz_get_type (ap_hdl, "eqprc"));
+}
+
+OMX_ERRORTYPE
+OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
+{
+  tiz_role_factory_t role_factory;
+  const tiz_role_factory_t * rf_list[] = {&role_factory};
+  tiz_type_factory_t eqprc_type;
+  tiz_type_factory_t eqcfgport_type;
+  const tiz_type_factory_t * tf_list[] = {&eqprc_type, &eqcfgport_type};
+
+  strcpy ((OMX_STRING) role_factory.role, ARATELIA_EQ_DEFAULT_ROLE);
+  role_factory.pf_cport = instantiate_config_port;
+  role_factory.pf_port[0] = instantiate_input_port;
+  role_factory.pf_port[1] = instantiate_output_port;
+  role_factory.nports = 2;
+  role_factory.pf_proc = instantiate_processor;
+
+  strcpy ((OMX_STRING) eqprc_type.class_name, "eqprc_class");
+  eqprc_type.pf_class_init = eq_prc_class_init;
+  strcpy ((OMX_STRING) eqprc_type.object_name, "eqprc");
+  eqprc_type.pf_object_init = eq_prc_init;
+
+  strcpy ((OMX_STRING) eqcfgport_type.class_name, "eqcfgport_class");
+  eqcfgport_type.pf_class_init = eq_cfgport_class_init;
+  strcpy ((OMX_STRING) eqcfgport_type.object_name, "eqcfgport");
+  eqcfgport_type.pf_object_init = eq_cfgport_init;
+
+  /* Initialize the component infrastructure */
+  tiz_check_omx (tiz_comp_init (ap_hdl, ARATELIA_EQ_COMPONENT_NAME));
+
+  /* Register the "eqprc" and "eqcfgport" classes */
+  tiz_check_omx (tiz_comp_register_types (ap_hdl, tf_list, 2));
+
+  /* Register the component role(s) */
+  tiz_check_omx (tiz_comp_register_roles (ap_hdl, rf_list, 1));
+
+  return OMX_ErrorNone;
+}
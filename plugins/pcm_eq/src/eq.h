@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   eq.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Parametric equalizer - constants
+ *
+ *
+ */
+#ifndef EQ_H
+#define EQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+#define ARATELIA_EQ_DEFAULT_ROLE "audio_processor.eq"
+#define ARATELIA_EQ_COMPONENT_NAME "OMX.Aratelia.audio_processor.eq"
+/* With libtizonia, port indexes must start at index 0 */
+#define ARATELIA_EQ_INPUT_PORT_INDEX 0
+#define ARATELIA_EQ_OUTPUT_PORT_INDEX 1
+#define ARATELIA_EQ_PORT_MIN_BUF_COUNT 2
+#define ARATELIA_EQ_PORT_MIN_INPUT_BUF_SIZE 8192
+#define ARATELIA_EQ_PORT_MIN_OUTPUT_BUF_SIZE 8192
+#define ARATELIA_EQ_PORT_NONCONTIGUOUS OMX_FALSE
+#define ARATELIA_EQ_PORT_ALIGNMENT 0
+#define ARATELIA_EQ_PORT_SUPPLIERPREF OMX_BufferSupplyInput
+/* Number of frames converted to float and filtered in one go */
+#define ARATELIA_EQ_BLOCK_FRAMES 1024
+#define ARATELIA_EQ_MAX_CHANNELS 8
+#define ARATELIA_EQ_MAX_FIR_TAPS 4096
+/* Time taken by the filters to move to new settings */
+#define ARATELIA_EQ_RAMP_TIME_MS 20
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EQ_H */
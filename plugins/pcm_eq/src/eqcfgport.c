@@ -0,0 +1,296 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   eqcfgport.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Parametric equalizer - config port class
+ *
+ * Holds the equalizer's bands. The initial bands are read from the
+ * 'OMX.Aratelia.audio_processor.eq.bands' key of tizonia.conf, as a
+ * semi-colon-separated list of 'type,frequency,gain,q' items, e.g.
+ * 'lowshelf,100,3,0.71;peaking,2500,-2.5,1.4'. The frequency is in Hz and
+ * the gain in dB.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <tizplatform.h>
+
+#include "eq.h"
+#include "eqcfgport.h"
+#include "eqcfgport_decls.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.eq.cfgport"
+#endif
+
+static const struct
+{
+  const char * p_name;
+  OMX_TIZONIA_AUDIO_EQFILTERTYPE filter;
+} g_filter_names[] = {
+  {"peaking", OMX_AUDIO_EqFilterPeaking},
+  {"lowshelf", OMX_AUDIO_EqFilterLowShelf},
+  {"highshelf", OMX_AUDIO_EqFilterHighShelf},
+  {"lowpass", OMX_AUDIO_EqFilterLowPass},
+  {"highpass", OMX_AUDIO_EqFilterHighPass},
+};
+
+static bool
+is_valid_band (const OMX_TIZONIA_AUDIO_EQBANDTYPE * ap_band)
+{
+  assert (ap_band);
+  return (OMX_FALSE == ap_band->bEnable
+          || (ap_band->eFilter <= OMX_AUDIO_EqFilterHighPass
+              && ap_band->nFrequency > 0 && ap_band->nQ > 0));
+}
+
+static bool
+parse_band (char * ap_item, OMX_TIZONIA_AUDIO_EQBANDTYPE * ap_band)
+{
+  char * p_save = NULL;
+  char * p_type = strtok_r (ap_item, ",", &p_save);
+  char * p_freq = strtok_r (NULL, ",", &p_save);
+  char * p_gain = strtok_r (NULL, ",", &p_save);
+  char * p_q = strtok_r (NULL, ",", &p_save);
+  size_t i = 0;
+
+  assert (ap_band);
+
+  if (!p_type || !p_freq || !p_gain || !p_q)
+    {
+      return false;
+    }
+
+  while (' ' == *p_type)
+    {
+      ++p_type;
+    }
+  for (i = 0; i < sizeof (g_filter_names) / sizeof (g_filter_names[0]); ++i)
+    {
+      if (0 == strncasecmp (p_type, g_filter_names[i].p_name,
+                            strlen (g_filter_names[i].p_name)))
+        {
+          break;
+        }
+    }
+  if (i == sizeof (g_filter_names) / sizeof (g_filter_names[0]))
+    {
+      return false;
+    }
+
+  ap_band->eFilter = g_filter_names[i].filter;
+  ap_band->bEnable = OMX_TRUE;
+  ap_band->nFrequency = (OMX_U32) MAX (atoi (p_freq), 0);
+  ap_band->nGain = (OMX_S32) (atof (p_gain) * 100.0);
+  ap_band->nQ = (OMX_U32) MAX (atof (p_q) * 100.0 + 0.5, 0.0);
+  return is_valid_band (ap_band);
+}
+
+static void
+read_bands_from_rcfile (eq_cfgport_t * ap_obj)
+{
+  const char * p_value = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION, "OMX.Aratelia.audio_processor.eq.bands");
+  char * p_bands = NULL;
+  char * p_save = NULL;
+  char * p_item = NULL;
+
+  assert (ap_obj);
+
+  if (!p_value || !(p_bands = strdup (p_value)))
+    {
+      return;
+    }
+
+  for (p_item = strtok_r (p_bands, ";", &p_save);
+       p_item && ap_obj->eq_.nBands < OMX_TIZONIA_AUDIO_MAX_EQ_BANDS;
+       p_item = strtok_r (NULL, ";", &p_save))
+    {
+      if (parse_band (p_item, &(ap_obj->eq_.sBands[ap_obj->eq_.nBands])))
+        {
+          ++(ap_obj->eq_.nBands);
+        }
+      else
+        {
+          TIZ_ERROR (handleOf (ap_obj), "Ignoring invalid band [%s]", p_item);
+          memset (&(ap_obj->eq_.sBands[ap_obj->eq_.nBands]), 0,
+                  sizeof (OMX_TIZONIA_AUDIO_EQBANDTYPE));
+        }
+    }
+
+  free (p_bands);
+}
+
+/*
+ * eqcfgport class
+ */
+
+static void *
+eq_cfgport_ctor (void * ap_obj, va_list * app)
+{
+  eq_cfgport_t * p_obj = super_ctor (typeOf (ap_obj, "eqcfgport"), ap_obj, app);
+
+  assert (p_obj);
+
+  tiz_port_register_index (p_obj, OMX_TizoniaIndexConfigAudioEqualizer);
+
+  memset (&(p_obj->eq_), 0, sizeof (p_obj->eq_));
+  p_obj->eq_.nSize = sizeof (OMX_TIZONIA_AUDIO_CONFIG_EQUALIZERTYPE);
+  p_obj->eq_.nVersion.nVersion = OMX_VERSION;
+  p_obj->eq_.nPortIndex = ARATELIA_EQ_INPUT_PORT_INDEX;
+  p_obj->eq_.bEnable = OMX_TRUE;
+  read_bands_from_rcfile (p_obj);
+
+  return p_obj;
+}
+
+static void *
+eq_cfgport_dtor (void * ap_obj)
+{
+  return super_dtor (typeOf (ap_obj, "eqcfgport"), ap_obj);
+}
+
+/*
+ * from tiz_api
+ */
+
+static OMX_ERRORTYPE
+eq_cfgport_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                      OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  const eq_cfgport_t * p_obj = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "GetConfig [%s]...", tiz_idx_to_str (a_index));
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexConfigAudioEqualizer == a_index)
+    {
+      OMX_TIZONIA_AUDIO_CONFIG_EQUALIZERTYPE * p_eq
+        = (OMX_TIZONIA_AUDIO_CONFIG_EQUALIZERTYPE *) ap_struct;
+      *p_eq = p_obj->eq_;
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_GetConfig (typeOf (ap_obj, "eqcfgport"), ap_obj, ap_hdl,
+                            a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+eq_cfgport_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                      OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  eq_cfgport_t * p_obj = (eq_cfgport_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "SetConfig [%s]...", tiz_idx_to_str (a_index));
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexConfigAudioEqualizer == a_index)
+    {
+      const OMX_TIZONIA_AUDIO_CONFIG_EQUALIZERTYPE * p_eq
+        = (OMX_TIZONIA_AUDIO_CONFIG_EQUALIZERTYPE *) ap_struct;
+      OMX_U32 i = 0;
+      if (p_eq->nBands > OMX_TIZONIA_AUDIO_MAX_EQ_BANDS)
+        {
+          return OMX_ErrorBadParameter;
+        }
+      for (i = 0; i < p_eq->nBands; ++i)
+        {
+          if (!is_valid_band (&(p_eq->sBands[i])))
+            {
+              TIZ_ERROR (ap_hdl, "[OMX_ErrorBadParameter] : invalid band [%u]",
+                         i);
+              return OMX_ErrorBadParameter;
+            }
+        }
+      p_obj->eq_.bEnable = p_eq->bEnable;
+      p_obj->eq_.nBands = p_eq->nBands;
+      memcpy (p_obj->eq_.sBands, p_eq->sBands, sizeof (p_obj->eq_.sBands));
+      TIZ_TRACE (ap_hdl, "bEnable [%s] nBands [%u]...",
+                 (p_obj->eq_.bEnable == OMX_FALSE ? "FALSE" : "TRUE"),
+                 p_obj->eq_.nBands);
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_SetConfig (typeOf (ap_obj, "eqcfgport"), ap_obj, ap_hdl,
+                            a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+/*
+ * eq_cfgport_class
+ */
+
+static void *
+eq_cfgport_class_ctor (void * ap_obj, va_list * app)
+{
+  /* NOTE: Class methods might be added in the future. None for now. */
+  return super_ctor (typeOf (ap_obj, "eqcfgport_class"), ap_obj, app);
+}
+
+/*
+ * initialization
+ */
+
+void *
+eq_cfgport_class_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizconfigport = tiz_get_type (ap_hdl, "tizconfigport");
+  void * eqcfgport_class
+    = factory_new (classOf (tizconfigport), "eqcfgport_class",
+                   classOf (tizconfigport), sizeof (eq_cfgport_class_t),
+                   ap_tos, ap_hdl, ctor, eq_cfgport_class_ctor, 0);
+  return eqcfgport_class;
+}
+
+void *
+eq_cfgport_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizconfigport = tiz_get_type (ap_hdl, "tizconfigport");
+  void * eqcfgport_class = tiz_get_type (ap_hdl, "eqcfgport_class");
+  TIZ_LOG_CLASS (eqcfgport_class);
+  void * eqcfgport = factory_new (
+    eqcfgport_class, "eqcfgport", tizconfigport, sizeof (eq_cfgport_t),
+    ap_tos, ap_hdl, ctor, eq_cfgport_ctor, dtor, eq_cfgport_dtor,
+    tiz_api_GetConfig, eq_cfgport_GetConfig, tiz_api_SetConfig,
+    eq_cfgport_SetConfig, 0);
+
+  return eqcfgport;
+}
@@ -0,0 +1,620 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   eqprc.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Parametric equalizer - processor class implementation
+ *
+ * Input samples are converted to float in blocks, filtered in place by a
+ * cascade of biquad sections and an optional FIR filter (see
+ * tiz_dsp_eq_process_f32), and converted back, with dither when reducing to
+ * 16 or 24 bits. When the equalizer is flat, the samples are copied as they
+ * are.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OMX_TizoniaExt.h>
+
+#include <tizplatform.h>
+
+#include <tizkernel.h>
+
+#include "eq.h"
+#include "eqprc.h"
+#include "eqprc_decls.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.eq.prc"
+#endif
+
+/* Forward declarations */
+static OMX_ERRORTYPE
+eq_prc_deallocate_resources (void *);
+
+static inline size_t
+frame_size (const OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode)
+{
+  assert (ap_pcmmode);
+  return (ap_pcmmode->nBitPerSample / 8) * ap_pcmmode->nChannels;
+}
+
+static bool
+is_supported_format (const OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode)
+{
+  assert (ap_pcmmode);
+  return (OMX_NumericalDataSigned == ap_pcmmode->eNumData
+          && OMX_EndianLittle == ap_pcmmode->eEndian
+          && OMX_TRUE == ap_pcmmode->bInterleaved
+          && (16 == ap_pcmmode->nBitPerSample
+              || 24 == ap_pcmmode->nBitPerSample
+              || 32 == ap_pcmmode->nBitPerSample)
+          && ap_pcmmode->nChannels > 0
+          && ap_pcmmode->nChannels <= ARATELIA_EQ_MAX_CHANNELS
+          && ap_pcmmode->nSamplingRate > 0);
+}
+
+static inline OMX_BUFFERHEADERTYPE *
+get_in_hdr (eq_prc_t * ap_prc)
+{
+  return tiz_filter_prc_get_header (ap_prc, ARATELIA_EQ_INPUT_PORT_INDEX);
+}
+
+static inline OMX_BUFFERHEADERTYPE *
+get_out_hdr (eq_prc_t * ap_prc)
+{
+  return tiz_filter_prc_get_header (ap_prc, ARATELIA_EQ_OUTPUT_PORT_INDEX);
+}
+
+static OMX_ERRORTYPE
+release_in_hdr (eq_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_in = get_in_hdr (ap_prc);
+  assert (ap_prc);
+  if (p_in)
+    {
+      if ((p_in->nFlags & OMX_BUFFERFLAG_EOS) > 0)
+        {
+          TIZ_TRACE (handleOf (ap_prc), "EOS flag received");
+          /* Remember the EOS flag, to propagate it on the output buffer */
+          tiz_filter_prc_update_eos_flag (ap_prc, true);
+          tiz_util_reset_eos_flag (p_in);
+        }
+      TIZ_TRACE (handleOf (ap_prc), "Releasing IN HEADER [%p]", p_in);
+      tiz_filter_prc_release_header (ap_prc, ARATELIA_EQ_INPUT_PORT_INDEX);
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+release_out_hdr (eq_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_out = get_out_hdr (ap_prc);
+  assert (ap_prc);
+  if (p_out)
+    {
+      if (tiz_filter_prc_is_eos (ap_prc))
+        {
+          /* The filters' histories are kept, as the next stream is likely
+             to follow on from this one */
+          TIZ_TRACE (handleOf (ap_prc), "Propagating EOS flag");
+          tiz_util_set_eos_flag (p_out);
+          tiz_filter_prc_update_eos_flag (ap_prc, false);
+        }
+      TIZ_TRACE (handleOf (ap_prc),
+                 "Releasing OUT HEADER [%p] nFilledLen [%d] nAllocLen [%d]",
+                 p_out, p_out->nFilledLen, p_out->nAllocLen);
+      tiz_filter_prc_release_header (ap_prc, ARATELIA_EQ_OUTPUT_PORT_INDEX);
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+retrieve_pcm_mode (eq_prc_t * ap_prc)
+{
+  OMX_AUDIO_PARAM_PCMMODETYPE * p_pcmmode = NULL;
+  assert (ap_prc);
+  p_pcmmode = &(ap_prc->pcmmode_);
+  TIZ_INIT_OMX_PORT_STRUCT (*p_pcmmode, ARATELIA_EQ_INPUT_PORT_INDEX);
+  tiz_check_omx (tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)),
+                                       handleOf (ap_prc),
+                                       OMX_IndexParamAudioPcm, p_pcmmode));
+  if (!is_supported_format (p_pcmmode))
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[OMX_ErrorUnsupportedSetting] : "
+                 "unsupported pcm format (%u bits, %u channels, %u Hz)",
+                 p_pcmmode->nBitPerSample, p_pcmmode->nChannels,
+                 p_pcmmode->nSamplingRate);
+      return OMX_ErrorUnsupportedSetting;
+    }
+  return OMX_ErrorNone;
+}
+
+/* Designs the biquad sections for the bands currently set on the config
+   port */
+static OMX_ERRORTYPE
+apply_equalizer (eq_prc_t * ap_prc, const size_t a_ramp_frames)
+{
+  OMX_TIZONIA_AUDIO_CONFIG_EQUALIZERTYPE eq;
+  tiz_dsp_biquad_t sections[OMX_TIZONIA_AUDIO_MAX_EQ_BANDS];
+  size_t nsections = 0;
+  OMX_U32 i = 0;
+
+  assert (ap_prc);
+  assert (ap_prc->p_eq_);
+
+  TIZ_INIT_OMX_PORT_STRUCT (eq, ARATELIA_EQ_INPUT_PORT_INDEX);
+  tiz_check_omx (tiz_api_GetConfig (tiz_get_krn (handleOf (ap_prc)),
+                                    handleOf (ap_prc),
+                                    OMX_TizoniaIndexConfigAudioEqualizer, &eq));
+
+  for (i = 0; OMX_TRUE == eq.bEnable && i < eq.nBands
+              && i < OMX_TIZONIA_AUDIO_MAX_EQ_BANDS;
+       ++i)
+    {
+      const OMX_TIZONIA_AUDIO_EQBANDTYPE * p_band = &(eq.sBands[i]);
+      if (OMX_FALSE == p_band->bEnable)
+        {
+          continue;
+        }
+      /* The filter types are listed in the same order in both enums */
+      if (OMX_ErrorNone
+          == tiz_dsp_biquad_design (
+               &(sections[nsections]), (tiz_dsp_biquad_type_t) p_band->eFilter,
+               ap_prc->pcmmode_.nSamplingRate, (float) p_band->nFrequency,
+               (float) p_band->nQ / 100.0f, (float) p_band->nGain / 100.0f))
+        {
+          ++nsections;
+        }
+      else
+        {
+          TIZ_WARN (handleOf (ap_prc),
+                    "Ignoring band [%u] : %u Hz is out of range at %u Hz", i,
+                    p_band->nFrequency, ap_prc->pcmmode_.nSamplingRate);
+        }
+    }
+
+  TIZ_TRACE (handleOf (ap_prc), "sections [%u] ramp frames [%u]",
+             (unsigned int) nsections, (unsigned int) a_ramp_frames);
+  return tiz_dsp_eq_set_biquads (ap_prc->p_eq_, sections, nsections,
+                                 a_ramp_frames);
+}
+
+/* Loads the FIR filter (e.g. a room correction filter) from the text file
+   given in tizonia.conf, if any. A missing or unreadable file is not fatal:
+   the stream plays without it */
+static OMX_ERRORTYPE
+load_fir (eq_prc_t * ap_prc)
+{
+  const char * p_file = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION, "OMX.Aratelia.audio_processor.eq.fir_file");
+  const char * p_rate = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION, "OMX.Aratelia.audio_processor.eq.fir_rate");
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  float * p_taps = NULL;
+  size_t ntaps = 0;
+  FILE * p_f = NULL;
+
+  assert (ap_prc);
+
+  if (!p_file)
+    {
+      return OMX_ErrorNone;
+    }
+
+  if (p_rate && atoi (p_rate) > 0
+      && (OMX_U32) atoi (p_rate) != ap_prc->pcmmode_.nSamplingRate)
+    {
+      TIZ_NOTICE (handleOf (ap_prc),
+                  "FIR filter designed for %s Hz; not used at %u Hz", p_rate,
+                  ap_prc->pcmmode_.nSamplingRate);
+      return OMX_ErrorNone;
+    }
+
+  if (!(p_f = fopen (p_file, "r")))
+    {
+      TIZ_ERROR (handleOf (ap_prc), "Unable to open FIR filter file [%s]",
+                 p_file);
+      return OMX_ErrorNone;
+    }
+
+  if ((p_taps = tiz_mem_alloc (ARATELIA_EQ_MAX_FIR_TAPS * sizeof (float))))
+    {
+      while (ntaps < ARATELIA_EQ_MAX_FIR_TAPS
+             && 1 == fscanf (p_f, "%f", &(p_taps[ntaps])))
+        {
+          ++ntaps;
+        }
+      TIZ_NOTICE (handleOf (ap_prc), "FIR filter [%s] : %u taps", p_file,
+                  (unsigned int) ntaps);
+      rc = tiz_dsp_eq_set_fir (ap_prc->p_eq_, p_taps, ntaps);
+      tiz_mem_free (p_taps);
+    }
+  else
+    {
+      rc = OMX_ErrorInsufficientResources;
+    }
+
+  fclose (p_f);
+  return rc;
+}
+
+static void
+destroy_eq (eq_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  tiz_dsp_eq_destroy (ap_prc->p_eq_);
+  ap_prc->p_eq_ = NULL;
+  tiz_mem_free (ap_prc->p_f32_);
+  ap_prc->p_f32_ = NULL;
+}
+
+static OMX_ERRORTYPE
+create_eq (eq_prc_t * ap_prc)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+
+  destroy_eq (ap_prc);
+
+  tiz_check_omx (retrieve_pcm_mode (ap_prc));
+
+  TIZ_NOTICE (handleOf (ap_prc), "%u Hz %u ch %u bits",
+              ap_prc->pcmmode_.nSamplingRate, ap_prc->pcmmode_.nChannels,
+              ap_prc->pcmmode_.nBitPerSample);
+
+  tiz_check_omx (
+    tiz_dsp_eq_init (&(ap_prc->p_eq_), ap_prc->pcmmode_.nChannels));
+
+  ap_prc->p_f32_ = tiz_mem_alloc (ARATELIA_EQ_BLOCK_FRAMES
+                                  * ARATELIA_EQ_MAX_CHANNELS * sizeof (float));
+  if (!ap_prc->p_f32_)
+    {
+      rc = OMX_ErrorInsufficientResources;
+    }
+
+  /* The first settings are used as they are, with no ramp */
+  if (OMX_ErrorNone == rc)
+    {
+      rc = apply_equalizer (ap_prc, 0);
+    }
+  if (OMX_ErrorNone == rc)
+    {
+      rc = load_fir (ap_prc);
+    }
+  if (OMX_ErrorNone != rc)
+    {
+      destroy_eq (ap_prc);
+    }
+  return rc;
+}
+
+static void
+filter_frames (eq_prc_t * ap_prc, const OMX_U8 * ap_src, OMX_U8 * ap_dst,
+               const size_t a_nframes)
+{
+  const OMX_AUDIO_PARAM_PCMMODETYPE * p_pcm = &(ap_prc->pcmmode_);
+  const size_t nsamples = a_nframes * p_pcm->nChannels;
+  float * p_buf = ap_prc->p_f32_;
+
+  if (tiz_dsp_eq_bypassed (ap_prc->p_eq_))
+    {
+      memcpy (ap_dst, ap_src, a_nframes * frame_size (p_pcm));
+      return;
+    }
+
+  switch (p_pcm->nBitPerSample)
+    {
+      case 16:
+        tiz_dsp_s16_to_f32 (p_buf, (const int16_t *) ap_src, nsamples);
+        break;
+      case 24:
+        tiz_dsp_s24_to_f32 (p_buf, ap_src, nsamples);
+        break;
+      default:
+        tiz_dsp_s32_to_f32 (p_buf, (const int32_t *) ap_src, nsamples);
+        break;
+    };
+
+  tiz_dsp_eq_process_f32 (ap_prc->p_eq_, p_buf, a_nframes);
+
+  switch (p_pcm->nBitPerSample)
+    {
+      case 16:
+        tiz_dsp_f32_to_s16 ((int16_t *) ap_dst, p_buf, nsamples,
+                            &(ap_prc->dither_));
+        break;
+      case 24:
+        tiz_dsp_f32_to_s24 (ap_dst, p_buf, nsamples, &(ap_prc->dither_));
+        break;
+      default:
+        tiz_dsp_f32_to_s32 ((int32_t *) ap_dst, p_buf, nsamples);
+        break;
+    };
+}
+
+static OMX_ERRORTYPE
+transform_buffer (eq_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_in = get_in_hdr (ap_prc);
+  OMX_BUFFERHEADERTYPE * p_out = get_out_hdr (ap_prc);
+  const size_t fsize = frame_size (&(ap_prc->pcmmode_));
+  size_t room = 0;
+  size_t nframes = 0;
+
+  assert (ap_prc);
+  assert (ap_prc->p_eq_);
+
+  if (!p_in || !p_out)
+    {
+      return OMX_ErrorNotReady;
+    }
+
+  room = (p_out->nAllocLen - p_out->nOffset - p_out->nFilledLen) / fsize;
+  nframes
+    = MIN (MIN (p_in->nFilledLen / fsize, room), ARATELIA_EQ_BLOCK_FRAMES);
+
+  if (nframes > 0)
+    {
+      filter_frames (ap_prc, p_in->pBuffer + p_in->nOffset,
+                     p_out->pBuffer + p_out->nOffset + p_out->nFilledLen,
+                     nframes);
+      p_in->nOffset += nframes * fsize;
+      p_in->nFilledLen -= nframes * fsize;
+      p_out->nFilledLen += nframes * fsize;
+      room -= nframes;
+    }
+
+  if (p_in->nFilledLen < fsize)
+    {
+      p_in->nFilledLen = 0;
+      (void) release_in_hdr (ap_prc);
+    }
+
+  if (0 == room || tiz_filter_prc_is_eos (ap_prc))
+    {
+      (void) release_out_hdr (ap_prc);
+    }
+
+  return OMX_ErrorNone;
+}
+
+/*
+ * eqprc
+ */
+
+static void *
+eq_prc_ctor (void * ap_obj, va_list * app)
+{
+  eq_prc_t * p_prc = super_ctor (typeOf (ap_obj, "eqprc"), ap_obj, app);
+  assert (p_prc);
+  p_prc->p_eq_ = NULL;
+  p_prc->p_f32_ = NULL;
+  p_prc->dither_ = 1;
+  return p_prc;
+}
+
+static void *
+eq_prc_dtor (void * ap_obj)
+{
+  (void) eq_prc_deallocate_resources (ap_obj);
+  return super_dtor (typeOf (ap_obj, "eqprc"), ap_obj);
+}
+
+/*
+ * from tizsrv class
+ */
+
+static OMX_ERRORTYPE
+eq_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
+{
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+eq_prc_deallocate_resources (void * ap_obj)
+{
+  destroy_eq (ap_obj);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+eq_prc_prepare_to_transfer (void * ap_obj, OMX_U32 a_pid)
+{
+  /* The ports' pcm settings are final at this point */
+  tiz_check_omx (create_eq (ap_obj));
+  tiz_filter_prc_update_eos_flag (ap_obj, false);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+eq_prc_transfer_and_process (void * ap_obj, OMX_U32 a_pid)
+{
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+eq_prc_stop_and_return (void * ap_obj)
+{
+  return tiz_filter_prc_release_all_headers (ap_obj);
+}
+
+/*
+ * from tizprc class
+ */
+
+static OMX_ERRORTYPE
+eq_prc_buffers_ready (const void * ap_prc)
+{
+  eq_prc_t * p_prc = (eq_prc_t *) ap_prc;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+
+  if (!p_prc->p_eq_)
+    {
+      return OMX_ErrorNone;
+    }
+
+  while (OMX_ErrorNone == rc)
+    {
+      rc = transform_buffer (p_prc);
+    }
+  if (OMX_ErrorNotReady == rc)
+    {
+      rc = OMX_ErrorNone;
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+eq_prc_port_flush (const void * ap_prc, OMX_U32 a_pid)
+{
+  eq_prc_t * p_prc = (eq_prc_t *) ap_prc;
+  if ((OMX_ALL == a_pid || ARATELIA_EQ_INPUT_PORT_INDEX == a_pid)
+      && p_prc->p_eq_)
+    {
+      /* A flush means a discontinuity (e.g. a seek), so drop the history */
+      tiz_filter_prc_update_eos_flag (p_prc, false);
+      tiz_dsp_eq_reset (p_prc->p_eq_);
+    }
+  return tiz_filter_prc_release_header (p_prc, a_pid);
+}
+
+static OMX_ERRORTYPE
+eq_prc_port_enable (const void * ap_prc, OMX_U32 a_pid)
+{
+  eq_prc_t * p_prc = (eq_prc_t *) ap_prc;
+  /* The port's settings may have been changed while disabled */
+  return eq_prc_prepare_to_transfer (p_prc, OMX_ALL);
+}
+
+static OMX_ERRORTYPE
+eq_prc_port_disable (const void * ap_prc, OMX_U32 a_pid)
+{
+  eq_prc_t * p_prc = (eq_prc_t *) ap_prc;
+  (void) eq_prc_deallocate_resources (p_prc);
+  return tiz_filter_prc_release_header (p_prc, a_pid);
+}
+
+static OMX_ERRORTYPE
+eq_prc_config_change (void * ap_prc, OMX_U32 a_pid,
+                      OMX_INDEXTYPE a_config_idx)
+{
+  eq_prc_t * p_prc = ap_prc;
+
+  assert (p_prc);
+
+  /* Before the stream starts, the settings are picked up by create_eq */
+  if (OMX_TizoniaIndexConfigAudioEqualizer == a_config_idx && p_prc->p_eq_)
+    {
+      /* Move to the new settings gradually, to avoid clicks */
+      return apply_equalizer (p_prc, (p_prc->pcmmode_.nSamplingRate
+                                      * ARATELIA_EQ_RAMP_TIME_MS)
+                                       / 1000);
+    }
+  return OMX_ErrorNone;
+}
+
+/*
+ * eq_prc_class
+ */
+
+static void *
+eq_prc_class_ctor (void * ap_obj, va_list * app)
+{
+  /* NOTE: Class methods might be added in the future. None for now. */
+  return super_ctor (typeOf (ap_obj, "eqprc_class"), ap_obj, app);
+}
+
+/*
+ * initialization
+ */
+
+void *
+eq_prc_class_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizfilterprc = tiz_get_type (ap_hdl, "tizfilterprc");
+  void * eqprc_class = factory_new
+    /* TIZ_CLASS_COMMENT: class type, class name, parent, size */
+    (classOf (tizfilterprc), "eqprc_class", classOf (tizfilterprc),
+     sizeof (eq_prc_class_t),
+     /* TIZ_CLASS_COMMENT: */
+     ap_tos, ap_hdl,
+     /* TIZ_CLASS_COMMENT: class constructor */
+     ctor, eq_prc_class_ctor,
+     /* TIZ_CLASS_COMMENT: stop value*/
+     0);
+  return eqprc_class;
+}
+
+void *
+eq_prc_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizfilterprc = tiz_get_type (ap_hdl, "tizfilterprc");
+  void * eqprc_class = tiz_get_type (ap_hdl, "eqprc_class");
+  TIZ_LOG_CLASS (eqprc_class);
+  void * eqprc = factory_new
+    /* TIZ_CLASS_COMMENT: class type, class name, parent, size */
+    (eqprc_class, "eqprc", tizfilterprc, sizeof (eq_prc_t),
+     /* TIZ_CLASS_COMMENT: */
+     ap_tos, ap_hdl,
+     /* TIZ_CLASS_COMMENT: class constructor */
+     ctor, eq_prc_ctor,
+     /* TIZ_CLASS_COMMENT: class destructor */
+     dtor, eq_prc_dtor,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_allocate_resources, eq_prc_allocate_resources,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_deallocate_resources, eq_prc_deallocate_resources,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_prepare_to_transfer, eq_prc_prepare_to_transfer,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_transfer_and_process, eq_prc_transfer_and_process,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_stop_and_return, eq_prc_stop_and_return,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_buffers_ready, eq_prc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_flush, eq_prc_port_flush,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_enable, eq_prc_port_enable,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_disable, eq_prc_port_disable,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_config_change, eq_prc_config_change,
+     /* TIZ_CLASS_COMMENT: stop value */
+     0);
+
+  return eqprc;
+}
@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   eqprc_decls.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Parametric equalizer - processor class decls
+ *
+ *
+ */
+
+#ifndef EQPRC_DECLS_H
+#define EQPRC_DECLS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include <tizplatform.h>
+
+#include <tizfilterprc.h>
+#include <tizfilterprc_decls.h>
+
+typedef struct eq_prc eq_prc_t;
+struct eq_prc
+{
+  /* Object */
+  const tiz_filter_prc_t _;
+  tiz_dsp_eq_t * p_eq_;
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmmode_;
+  float * p_f32_;
+  uint32_t dither_;
+};
+
+typedef struct eq_prc_class eq_prc_class_t;
+struct eq_prc_class
+{
+  /* Class */
+  const tiz_filter_prc_class_t _;
+  /* NOTE: Class methods might be added in the future */
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EQPRC_DECLS_H */
@@ -0,0 +1,206 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   mixer.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - PCM mixer component
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMX_Types.h>
+
+#include <tizplatform.h>
+
+#include <tizport.h>
+#include <tizscheduler.h>
+
+#include "mixerprc.h"
+#include "mixer.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.pcm_mixer"
+#endif
+
+/**
+ *@defgroup libtizpcmmixer 'libtizpcmmixer' : OpenMAX IL PCM mixer
+ *
+ * - Component name : "OMX.Aratelia.audio_mixer.pcm"
+ * - Implements role: "audio_mixer.pcm"
+ *
+ * Ports 0 to 3 are PCM inputs, port 4 is the PCM output. The inputs must
+ * have the output's sampling rate; channel counts and sample sizes may
+ * differ. Each input's gain is set with OMX_IndexConfigAudioVolume and
+ * OMX_IndexConfigAudioMute on its port, and inputs can be attached and
+ * detached while executing by enabling and disabling their ports.
+ *
+ *@ingroup plugins
+ */
+
+static OMX_VERSIONTYPE pcm_mixer_version = {{1, 0, 0, 0}};
+
+static OMX_PTR
+instantiate_pcm_port (OMX_HANDLETYPE ap_hdl, const OMX_U32 a_port_id,
+                      const OMX_DIRTYPE a_dir, const OMX_U32 a_buf_size)
+{
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmmode;
+  OMX_AUDIO_CONFIG_VOLUMETYPE volume;
+  OMX_AUDIO_CONFIG_MUTETYPE mute;
+  OMX_AUDIO_CODINGTYPE encodings[] = {OMX_AUDIO_CodingPCM, OMX_AUDIO_CodingMax};
+  tiz_port_options_t pcm_port_opts = {
+    OMX_PortDomainAudio,
+    a_dir,
+    ARATELIA_PCM_MIXER_PORT_MIN_BUF_COUNT,
+    a_buf_size,
+    ARATELIA_PCM_MIXER_PORT_NONCONTIGUOUS,
+    ARATELIA_PCM_MIXER_PORT_ALIGNMENT,
+    ARATELIA_PCM_MIXER_PORT_SUPPLIERPREF,
+    {a_port_id, NULL, NULL, NULL},
+    -1 /* not slaved, each input carries its own stream */
+  };
+
+  pcmmode.nSize = sizeof (OMX_AUDIO_PARAM_PCMMODETYPE);
+  pcmmode.nVersion.nVersion = OMX_VERSION;
+  pcmmode.nPortIndex = a_port_id;
+  pcmmode.nChannels = 2;
+  pcmmode.eNumData = OMX_NumericalDataSigned;
+  pcmmode.eEndian = OMX_EndianLittle;
+  pcmmode.bInterleaved = OMX_TRUE;
+  pcmmode.nBitPerSample = 16;
+  pcmmode.nSamplingRate = 48000;
+  pcmmode.ePCMMode = OMX_AUDIO_PCMModeLinear;
+  pcmmode.eChannelMapping[0] = OMX_AUDIO_ChannelLF;
+  pcmmode.eChannelMapping[1] = OMX_AUDIO_ChannelRF;
+
+  volume.nSize = sizeof (OMX_AUDIO_CONFIG_VOLUMETYPE);
+  volume.nVersion.nVersion = OMX_VERSION;
+  volume.nPortIndex = a_port_id;
+  volume.bLinear = OMX_FALSE;
+  volume.sVolume.nValue = ARATELIA_PCM_MIXER_MAX_VOLUME_VALUE;
+  volume.sVolume.nMin = ARATELIA_PCM_MIXER_MIN_VOLUME_VALUE;
+  volume.sVolume.nMax = ARATELIA_PCM_MIXER_MAX_VOLUME_VALUE;
+
+  mute.nSize = sizeof (OMX_AUDIO_CONFIG_MUTETYPE);
+  mute.nVersion.nVersion = OMX_VERSION;
+  mute.nPortIndex = a_port_id;
+  mute.bMute = OMX_FALSE;
+
+  return factory_new (tiz_get_type (ap_hdl, "tizpcmport"), &pcm_port_opts,
+                      &encodings, &pcmmode, &volume, &mute);
+}
+
+static OMX_PTR
+instantiate_input_port (OMX_HANDLETYPE ap_hdl, const OMX_U32 a_pid)
+{
+  return instantiate_pcm_port (ap_hdl, a_pid, OMX_DirInput,
+                               ARATELIA_PCM_MIXER_PORT_MIN_INPUT_BUF_SIZE);
+}
+
+static OMX_PTR
+instantiate_input_port_0 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_input_port (ap_hdl, 0);
+}
+
+static OMX_PTR
+instantiate_input_port_1 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_input_port (ap_hdl, 1);
+}
+
+static OMX_PTR
+instantiate_input_port_2 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_input_port (ap_hdl, 2);
+}
+
+static OMX_PTR
+instantiate_input_port_3 (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_input_port (ap_hdl, 3);
+}
+
+static OMX_PTR
+instantiate_output_port (OMX_HANDLETYPE ap_hdl)
+{
+  return instantiate_pcm_port (ap_hdl, ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX,
+                               OMX_DirOutput,
+                               ARATELIA_PCM_MIXER_PORT_MIN_OUTPUT_BUF_SIZE);
+}
+
+static OMX_PTR
+instantiate_config_port (OMX_HANDLETYPE ap_hdl)
+{
+  return factory_new (tiz_get_type (ap_hdl, "tizconfigport"),
+                      NULL, /* this port does not take options */
+                      ARATELIA_PCM_MIXER_COMPONENT_NAME, pcm_mixer_version);
+}
+
+static OMX_PTR
+instantiate_processor (OMX_HANDLETYPE ap_hdl)
+{
+  return factory_new (tiz_get_type (ap_hdl, "mixerprc"));
+}
+
+OMX_ERRORTYPE
+OMX_ComponentInit (OMX_HANDLETYPE ap_hdl)
+{
+  tiz_role_factory_t role_factory;
+  const tiz_role_factory_t * rf_list[] = {&role_factory};
+  tiz_type_factory_t mixerprc_type;
+  const tiz_type_factory_t * tf_list[] = {&mixerprc_type};
+
+  strcpy ((OMX_STRING) role_factory.role, ARATELIA_PCM_MIXER_DEFAULT_ROLE);
+  role_factory.pf_cport = instantiate_config_port;
+  role_factory.pf_port[0] = instantiate_input_port_0;
+  role_factory.pf_port[1] = instantiate_input_port_1;
+  role_factory.pf_port[2] = instantiate_input_port_2;
+  role_factory.pf_port[3] = instantiate_input_port_3;
+  role_factory.pf_port[4] = instantiate_output_port;
+  role_factory.nports = ARATELIA_PCM_MIXER_NUM_INPUTS + 1;
+  role_factory.pf_proc = instantiate_processor;
+
+  strcpy ((OMX_STRING) mixerprc_type.class_name, "mixerprc_class");
+  mixerprc_type.pf_class_init = mixer_prc_class_init;
+  strcpy ((OMX_STRING) mixerprc_type.object_name, "mixerprc");
+  mixerprc_type.pf_object_init = mixer_prc_init;
+
+  /* Initialize the component infrastructure */
+  tiz_check_omx (tiz_comp_init (ap_hdl, ARATELIA_PCM_MIXER_COMPONENT_NAME));
+
+  /* Register the "mixerprc" class */
+  tiz_check_omx (tiz_comp_register_types (ap_hdl, tf_list, 1));
+
+  /* Register the component role(s) */
+  tiz_check_omx (tiz_comp_register_roles (ap_hdl, rf_list, 1));
+
+  return OMX_ErrorNone;
+}
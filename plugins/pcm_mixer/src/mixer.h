@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   mixer.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - PCM mixer - constants
+ *
+ *
+ */
+#ifndef MIXER_H
+#define MIXER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <OMX_Core.h>
+#include <OMX_Types.h>
+
+#define ARATELIA_PCM_MIXER_DEFAULT_ROLE "audio_mixer.pcm"
+#define ARATELIA_PCM_MIXER_COMPONENT_NAME "OMX.Aratelia.audio_mixer.pcm"
+/* With libtizonia, port indexes must start at index 0. Ports 0 to 3 are
+   inputs, port 4 is the output. */
+#define ARATELIA_PCM_MIXER_NUM_INPUTS 4
+#define ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX ARATELIA_PCM_MIXER_NUM_INPUTS
+#define ARATELIA_PCM_MIXER_PORT_MIN_BUF_COUNT 2
+#define ARATELIA_PCM_MIXER_PORT_MIN_INPUT_BUF_SIZE 8192
+#define ARATELIA_PCM_MIXER_PORT_MIN_OUTPUT_BUF_SIZE 8192
+#define ARATELIA_PCM_MIXER_PORT_NONCONTIGUOUS OMX_FALSE
+#define ARATELIA_PCM_MIXER_PORT_ALIGNMENT 0
+#define ARATELIA_PCM_MIXER_PORT_SUPPLIERPREF OMX_BufferSupplyInput
+#define ARATELIA_PCM_MIXER_MIN_VOLUME_VALUE 0
+#define ARATELIA_PCM_MIXER_MAX_VOLUME_VALUE 100
+#define ARATELIA_PCM_MIXER_MAX_CHANNELS 8
+/* Number of frames mixed in one go */
+#define ARATELIA_PCM_MIXER_BLOCK_FRAMES 1024
+/* Length of the gain ramps on volume and mute changes */
+#define ARATELIA_PCM_MIXER_FADE_TIME_MS 30
+/* Length of the gain ramps when ducking starts and stops */
+#define ARATELIA_PCM_MIXER_DUCKING_FADE_TIME_MS 250
+#define ARATELIA_PCM_MIXER_DEFAULT_DUCKING_GAIN_DB -12
+/* Timestamp gaps or overlaps shorter than this are ignored */
+#define ARATELIA_PCM_MIXER_SYNC_TOLERANCE_MS 20
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIXER_H */
@@ -0,0 +1,945 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   mixerprc.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - PCM mixer - processor class implementation
+ *
+ * The active inputs are converted to float, remixed to the output's channel
+ * count, scaled by their own gain (volume, mute and ducking, all of them
+ * ramped per sample) and summed into a float mix buffer, which is then
+ * converted to the output's sample size with saturation and dither.
+ *
+ * An input becomes active when the first buffer of a stream arrives, and
+ * inactive on EOS or when its port is disabled. The output waits only for
+ * the active inputs. The timestamps of an input are taken relative to the
+ * position of the mix at which its stream started: gaps are filled with
+ * silence, and late samples are dropped.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tizplatform.h>
+
+#include <tizkernel.h>
+
+#include "mixer.h"
+#include "mixerprc.h"
+#include "mixerprc_decls.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.pcm_mixer.prc"
+#endif
+
+/* Forward declarations */
+static OMX_ERRORTYPE
+mixer_prc_deallocate_resources (void *);
+
+static OMX_S32
+get_ducking_port (void)
+{
+  const char * p_port
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_mixer.pcm.ducking_port");
+  return p_port ? atoi (p_port) : ARATELIA_PCM_MIXER_NUM_INPUTS - 1;
+}
+
+static float
+get_ducking_gain (void)
+{
+  const char * p_db
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_mixer.pcm.ducking_gain_db");
+  return tiz_dsp_db_to_gain (
+    MIN (0.0f, p_db ? (float) atof (p_db)
+                    : (float) ARATELIA_PCM_MIXER_DEFAULT_DUCKING_GAIN_DB));
+}
+
+static inline size_t
+frame_size (const OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode)
+{
+  assert (ap_pcmmode);
+  return (ap_pcmmode->nBitPerSample / 8) * ap_pcmmode->nChannels;
+}
+
+static inline size_t
+ms_to_frames (const mixer_prc_t * ap_prc, const unsigned int a_ms)
+{
+  assert (ap_prc);
+  return (size_t) ap_prc->out_pcmmode_.nSamplingRate * a_ms / 1000;
+}
+
+static inline bool
+is_input_port (const OMX_U32 a_pid)
+{
+  return a_pid < ARATELIA_PCM_MIXER_NUM_INPUTS;
+}
+
+static bool
+is_supported_format (const OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode)
+{
+  assert (ap_pcmmode);
+  return (OMX_NumericalDataSigned == ap_pcmmode->eNumData
+          && OMX_EndianLittle == ap_pcmmode->eEndian
+          && OMX_TRUE == ap_pcmmode->bInterleaved
+          && (16 == ap_pcmmode->nBitPerSample
+              || 24 == ap_pcmmode->nBitPerSample
+              || 32 == ap_pcmmode->nBitPerSample)
+          && ap_pcmmode->nChannels > 0
+          && ap_pcmmode->nChannels <= ARATELIA_PCM_MIXER_MAX_CHANNELS);
+}
+
+static float
+input_gain (const mixer_prc_t * ap_prc, const OMX_U32 a_pid)
+{
+  const mixer_input_t * p_input = NULL;
+  float gain = 0.0f;
+  assert (ap_prc);
+  assert (is_input_port (a_pid));
+  p_input = &(ap_prc->inputs_[a_pid]);
+  if (!p_input->muted)
+    {
+      gain = (float) p_input->volume / ARATELIA_PCM_MIXER_MAX_VOLUME_VALUE;
+      if (ap_prc->ducking_ && ap_prc->ducking_port_ != (OMX_S32) a_pid)
+        {
+          gain *= ap_prc->ducking_gain_;
+        }
+    }
+  return gain;
+}
+
+static float
+output_gain (const mixer_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  return ap_prc->out_muted_ ? 0.0f : (float) ap_prc->out_volume_
+                                       / ARATELIA_PCM_MIXER_MAX_VOLUME_VALUE;
+}
+
+static void
+update_ducking (mixer_prc_t * ap_prc)
+{
+  bool ducking = false;
+  assert (ap_prc);
+
+  ducking = (ap_prc->ducking_port_ >= 0
+             && ap_prc->ducking_port_ < ARATELIA_PCM_MIXER_NUM_INPUTS
+             && ap_prc->inputs_[ap_prc->ducking_port_].active);
+
+  if (ducking != ap_prc->ducking_)
+    {
+      OMX_U32 pid = 0;
+      TIZ_DEBUG (handleOf (ap_prc), "ducking [%s]", ducking ? "ON" : "OFF");
+      ap_prc->ducking_ = ducking;
+      for (pid = 0; pid < ARATELIA_PCM_MIXER_NUM_INPUTS; ++pid)
+        {
+          if ((OMX_S32) pid != ap_prc->ducking_port_)
+            {
+              tiz_dsp_fader_ramp (
+                &(ap_prc->inputs_[pid].fader), input_gain (ap_prc, pid),
+                ms_to_frames (ap_prc, ARATELIA_PCM_MIXER_DUCKING_FADE_TIME_MS));
+            }
+        }
+    }
+}
+
+static void
+deactivate_input (mixer_prc_t * ap_prc, const OMX_U32 a_pid)
+{
+  mixer_input_t * p_input = NULL;
+  OMX_U32 pid = 0;
+  bool any_active = false;
+
+  assert (ap_prc);
+  assert (is_input_port (a_pid));
+
+  p_input = &(ap_prc->inputs_[a_pid]);
+  if (!p_input->active)
+    {
+      return;
+    }
+
+  TIZ_DEBUG (handleOf (ap_prc), "input [%u] inactive", a_pid);
+  p_input->active = false;
+  p_input->p_last_hdr = NULL;
+  p_input->silence_frames = 0;
+  update_ducking (ap_prc);
+
+  for (pid = 0; pid < ARATELIA_PCM_MIXER_NUM_INPUTS; ++pid)
+    {
+      any_active |= ap_prc->inputs_[pid].active;
+    }
+  if (!any_active)
+    {
+      /* The last stream has ended, let the renderer know */
+      tiz_filter_prc_update_eos_flag (ap_prc, true);
+    }
+}
+
+static void
+activate_input (mixer_prc_t * ap_prc, const OMX_U32 a_pid,
+                const OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  mixer_input_t * p_input = NULL;
+  assert (ap_prc);
+  assert (ap_hdr);
+  assert (is_input_port (a_pid));
+
+  p_input = &(ap_prc->inputs_[a_pid]);
+  TIZ_DEBUG (handleOf (ap_prc), "input [%u] active at frame [%llu]", a_pid,
+             (unsigned long long) ap_prc->pos_);
+  p_input->active = true;
+  p_input->anchor_ts = ap_hdr->nTimeStamp;
+  p_input->last_ts = ap_hdr->nTimeStamp;
+  p_input->anchor_pos = ap_prc->pos_;
+  p_input->pos = ap_prc->pos_;
+  p_input->silence_frames = 0;
+  p_input->p_last_hdr = (OMX_BUFFERHEADERTYPE *) ap_hdr;
+  tiz_dsp_fader_init (&(p_input->fader), 0.0f);
+  /* The mix goes on, so an end of stream that has not been propagated yet is
+     no longer one */
+  tiz_filter_prc_update_eos_flag (ap_prc, false);
+  update_ducking (ap_prc);
+  tiz_dsp_fader_ramp (&(p_input->fader), input_gain (ap_prc, a_pid),
+                      ms_to_frames (ap_prc, ARATELIA_PCM_MIXER_FADE_TIME_MS));
+}
+
+/* Compares the timestamp of a new buffer with the input's position in the
+   mix. Only timestamps that advance are considered, as many sources don't
+   stamp their buffers. */
+static void
+align_input (mixer_prc_t * ap_prc, const OMX_U32 a_pid,
+             OMX_BUFFERHEADERTYPE * ap_hdr)
+{
+  mixer_input_t * p_input = NULL;
+  const size_t tolerance
+    = ms_to_frames (ap_prc, ARATELIA_PCM_MIXER_SYNC_TOLERANCE_MS);
+  uint64_t expected = 0;
+
+  assert (ap_prc);
+  assert (ap_hdr);
+
+  p_input = &(ap_prc->inputs_[a_pid]);
+  p_input->p_last_hdr = ap_hdr;
+  if (ap_hdr->nTimeStamp <= p_input->last_ts)
+    {
+      return;
+    }
+  p_input->last_ts = ap_hdr->nTimeStamp;
+
+  expected = p_input->anchor_pos
+             + (uint64_t) (ap_hdr->nTimeStamp - p_input->anchor_ts)
+                 * ap_prc->out_pcmmode_.nSamplingRate / 1000000;
+
+  if (expected > p_input->pos + tolerance)
+    {
+      p_input->silence_frames = expected - p_input->pos;
+      TIZ_DEBUG (handleOf (ap_prc), "input [%u] : gap of [%lu] frames", a_pid,
+                 (unsigned long) p_input->silence_frames);
+    }
+  else if (expected + tolerance < p_input->pos)
+    {
+      const size_t in_frame_size = frame_size (&(p_input->pcmmode));
+      const size_t late = MIN (p_input->pos - expected,
+                               ap_hdr->nFilledLen / in_frame_size);
+      TIZ_DEBUG (handleOf (ap_prc), "input [%u] : dropping [%lu] late frames",
+                 a_pid, (unsigned long) late);
+      ap_hdr->nOffset += late * in_frame_size;
+      ap_hdr->nFilledLen -= late * in_frame_size;
+    }
+}
+
+static OMX_ERRORTYPE
+release_in_hdr (mixer_prc_t * ap_prc, const OMX_U32 a_pid)
+{
+  OMX_BUFFERHEADERTYPE * p_in = tiz_filter_prc_get_header (ap_prc, a_pid);
+  assert (ap_prc);
+  if (p_in)
+    {
+      const bool eos = (p_in->nFlags & OMX_BUFFERFLAG_EOS) > 0;
+      if (eos)
+        {
+          TIZ_TRACE (handleOf (ap_prc), "EOS flag received on input [%u]",
+                     a_pid);
+          tiz_util_reset_eos_flag (p_in);
+        }
+      TIZ_TRACE (handleOf (ap_prc), "Releasing IN HEADER [%p]", p_in);
+      tiz_check_omx (tiz_filter_prc_release_header (ap_prc, a_pid));
+      if (eos)
+        {
+          deactivate_input (ap_prc, a_pid);
+        }
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+release_out_hdr (mixer_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_out = tiz_filter_prc_get_header (
+    ap_prc, ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX);
+  assert (ap_prc);
+  if (p_out)
+    {
+      if (tiz_filter_prc_is_eos (ap_prc))
+        {
+          TIZ_TRACE (handleOf (ap_prc), "Propagating EOS flag");
+          tiz_util_set_eos_flag (p_out);
+          tiz_filter_prc_update_eos_flag (ap_prc, false);
+        }
+      TIZ_TRACE (handleOf (ap_prc),
+                 "Releasing OUT HEADER [%p] nFilledLen [%d] nAllocLen [%d]",
+                 p_out, p_out->nFilledLen, p_out->nAllocLen);
+      tiz_check_omx (tiz_filter_prc_release_header (
+        ap_prc, ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX));
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+retrieve_pcm_mode (mixer_prc_t * ap_prc, const OMX_U32 a_pid,
+                   OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode)
+{
+  assert (ap_prc);
+  assert (ap_pcmmode);
+  TIZ_INIT_OMX_PORT_STRUCT (*ap_pcmmode, a_pid);
+  tiz_check_omx (tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)),
+                                       handleOf (ap_prc),
+                                       OMX_IndexParamAudioPcm, ap_pcmmode));
+  if (!is_supported_format (ap_pcmmode)
+      || (a_pid != ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX
+          && ap_pcmmode->nSamplingRate
+               != ap_prc->out_pcmmode_.nSamplingRate))
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[OMX_ErrorUnsupportedSetting] : PORT [%u] : "
+                 "unsupported pcm format (%u bits, %u channels, %u Hz)",
+                 a_pid, ap_pcmmode->nBitPerSample, ap_pcmmode->nChannels,
+                 ap_pcmmode->nSamplingRate);
+      return OMX_ErrorUnsupportedSetting;
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+retrieve_volume (mixer_prc_t * ap_prc, const OMX_U32 a_pid, OMX_S32 * ap_volume,
+                 bool * ap_muted)
+{
+  OMX_AUDIO_CONFIG_VOLUMETYPE volume;
+  OMX_AUDIO_CONFIG_MUTETYPE mute;
+  assert (ap_prc);
+  assert (ap_volume);
+  assert (ap_muted);
+
+  TIZ_INIT_OMX_PORT_STRUCT (volume, a_pid);
+  tiz_check_omx (tiz_api_GetConfig (tiz_get_krn (handleOf (ap_prc)),
+                                    handleOf (ap_prc),
+                                    OMX_IndexConfigAudioVolume, &volume));
+  TIZ_INIT_OMX_PORT_STRUCT (mute, a_pid);
+  tiz_check_omx (tiz_api_GetConfig (tiz_get_krn (handleOf (ap_prc)),
+                                    handleOf (ap_prc), OMX_IndexConfigAudioMute,
+                                    &mute));
+  *ap_volume = MAX (ARATELIA_PCM_MIXER_MIN_VOLUME_VALUE,
+                    MIN (ARATELIA_PCM_MIXER_MAX_VOLUME_VALUE,
+                         volume.sVolume.nValue));
+  *ap_muted = (OMX_TRUE == mute.bMute);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+configure_input (mixer_prc_t * ap_prc, const OMX_U32 a_pid)
+{
+  mixer_input_t * p_input = NULL;
+  assert (ap_prc);
+  assert (is_input_port (a_pid));
+  p_input = &(ap_prc->inputs_[a_pid]);
+  tiz_check_omx (retrieve_pcm_mode (ap_prc, a_pid, &(p_input->pcmmode)));
+  tiz_check_omx (
+    retrieve_volume (ap_prc, a_pid, &(p_input->volume), &(p_input->muted)));
+  p_input->active = false;
+  p_input->p_last_hdr = NULL;
+  p_input->silence_frames = 0;
+  tiz_dsp_fader_init (&(p_input->fader), input_gain (ap_prc, a_pid));
+  return OMX_ErrorNone;
+}
+
+static void
+free_buffers (mixer_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  tiz_mem_free (ap_prc->p_mix_);
+  ap_prc->p_mix_ = NULL;
+  tiz_mem_free (ap_prc->p_in_f32_);
+  ap_prc->p_in_f32_ = NULL;
+  tiz_mem_free (ap_prc->p_remix_f32_);
+  ap_prc->p_remix_f32_ = NULL;
+}
+
+static OMX_ERRORTYPE
+alloc_buffers (mixer_prc_t * ap_prc)
+{
+  const size_t block_size = ARATELIA_PCM_MIXER_BLOCK_FRAMES
+                            * ARATELIA_PCM_MIXER_MAX_CHANNELS * sizeof (float);
+  assert (ap_prc);
+  if (!ap_prc->p_mix_)
+    {
+      ap_prc->p_mix_ = tiz_mem_alloc (block_size);
+      ap_prc->p_in_f32_ = tiz_mem_alloc (block_size);
+      ap_prc->p_remix_f32_ = tiz_mem_alloc (block_size);
+      if (!ap_prc->p_mix_ || !ap_prc->p_in_f32_ || !ap_prc->p_remix_f32_)
+        {
+          free_buffers (ap_prc);
+          return OMX_ErrorInsufficientResources;
+        }
+    }
+  return OMX_ErrorNone;
+}
+
+/* Returns the number of frames that an input can contribute to the mix right
+   now, or zero if it is waiting for data */
+static size_t
+input_frames_available (mixer_prc_t * ap_prc, const OMX_U32 a_pid)
+{
+  mixer_input_t * p_input = &(ap_prc->inputs_[a_pid]);
+  OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+  size_t in_frame_size = 0;
+
+  if (tiz_filter_prc_is_port_disabled (ap_prc, a_pid))
+    {
+      return 0;
+    }
+
+  p_hdr = tiz_filter_prc_get_header (ap_prc, a_pid);
+  in_frame_size = frame_size (&(p_input->pcmmode));
+
+  if (p_hdr)
+    {
+      if (!p_input->active)
+        {
+          activate_input (ap_prc, a_pid, p_hdr);
+        }
+      else if (p_hdr != p_input->p_last_hdr)
+        {
+          align_input (ap_prc, a_pid, p_hdr);
+        }
+
+      if (p_hdr->nFilledLen < in_frame_size)
+        {
+          /* Empty buffer, typically the one that carries the EOS flag */
+          p_hdr->nFilledLen = 0;
+          (void) release_in_hdr (ap_prc, a_pid);
+          return p_input->active ? input_frames_available (ap_prc, a_pid) : 0;
+        }
+    }
+
+  return p_input->silence_frames
+         + (p_hdr ? p_hdr->nFilledLen / in_frame_size : 0);
+}
+
+/* Reads a_nframes frames from an input, and adds them to the mix */
+static void
+mix_input (mixer_prc_t * ap_prc, const OMX_U32 a_pid, float * ap_mix,
+           const size_t a_nframes)
+{
+  mixer_input_t * p_input = &(ap_prc->inputs_[a_pid]);
+  OMX_BUFFERHEADERTYPE * p_hdr = tiz_filter_prc_get_header (ap_prc, a_pid);
+  const size_t in_channels = p_input->pcmmode.nChannels;
+  const size_t out_channels = ap_prc->out_pcmmode_.nChannels;
+  const size_t in_frame_size = frame_size (&(p_input->pcmmode));
+  const size_t nsamples = a_nframes * in_channels;
+  const OMX_U8 * p_src = NULL;
+  float * p_buf = ap_prc->p_in_f32_;
+
+  assert (p_hdr);
+  assert (p_hdr->nFilledLen >= a_nframes * in_frame_size);
+
+  p_src = p_hdr->pBuffer + p_hdr->nOffset;
+  switch (p_input->pcmmode.nBitPerSample)
+    {
+      case 16:
+        tiz_dsp_s16_to_f32 (p_buf, (const int16_t *) p_src, nsamples);
+        break;
+      case 24:
+        tiz_dsp_s24_to_f32 (p_buf, p_src, nsamples);
+        break;
+      default:
+        tiz_dsp_s32_to_f32 (p_buf, (const int32_t *) p_src, nsamples);
+        break;
+    };
+
+  if (in_channels != out_channels)
+    {
+      tiz_dsp_remix_f32 (ap_prc->p_remix_f32_, out_channels, p_buf,
+                         in_channels, a_nframes);
+      p_buf = ap_prc->p_remix_f32_;
+    }
+
+  if (p_input->fader.remaining > 0)
+    {
+      tiz_dsp_fader_f32 (&(p_input->fader), p_buf, out_channels, a_nframes);
+      tiz_dsp_mix_f32 (ap_mix, p_buf, a_nframes * out_channels, 1.0f);
+    }
+  else if (p_input->fader.gain > 0.0f)
+    {
+      tiz_dsp_mix_f32 (ap_mix, p_buf, a_nframes * out_channels,
+                       p_input->fader.gain);
+    }
+
+  p_hdr->nOffset += a_nframes * in_frame_size;
+  p_hdr->nFilledLen -= a_nframes * in_frame_size;
+  if (p_hdr->nFilledLen < in_frame_size)
+    {
+      p_hdr->nFilledLen = 0;
+      (void) release_in_hdr (ap_prc, a_pid);
+    }
+}
+
+static void
+write_output_frames (mixer_prc_t * ap_prc, OMX_U8 * ap_dst,
+                     const size_t a_nframes)
+{
+  const OMX_AUDIO_PARAM_PCMMODETYPE * p_out = &(ap_prc->out_pcmmode_);
+  const size_t nsamples = a_nframes * p_out->nChannels;
+
+  if (!tiz_dsp_fader_is_unity (&(ap_prc->out_fader_)))
+    {
+      tiz_dsp_fader_f32 (&(ap_prc->out_fader_), ap_prc->p_mix_,
+                         p_out->nChannels, a_nframes);
+    }
+
+  switch (p_out->nBitPerSample)
+    {
+      case 16:
+        tiz_dsp_f32_to_s16 ((int16_t *) ap_dst, ap_prc->p_mix_, nsamples,
+                            &(ap_prc->dither_));
+        break;
+      case 24:
+        tiz_dsp_f32_to_s24 (ap_dst, ap_prc->p_mix_, nsamples,
+                            &(ap_prc->dither_));
+        break;
+      default:
+        tiz_dsp_f32_to_s32 ((int32_t *) ap_dst, ap_prc->p_mix_, nsamples);
+        break;
+    };
+}
+
+static OMX_ERRORTYPE
+mix_block (mixer_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_out = NULL;
+  const size_t out_channels = ap_prc->out_pcmmode_.nChannels;
+  const size_t out_frame_size = frame_size (&(ap_prc->out_pcmmode_));
+  size_t nframes = 0;
+  size_t room = 0;
+  bool any_active = false;
+  OMX_U32 pid = 0;
+
+  assert (ap_prc);
+
+  p_out = tiz_filter_prc_get_header (ap_prc,
+                                     ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX);
+  if (!p_out)
+    {
+      return OMX_ErrorNotReady;
+    }
+
+  room = (p_out->nAllocLen - p_out->nOffset - p_out->nFilledLen)
+         / out_frame_size;
+  nframes = MIN (room, ARATELIA_PCM_MIXER_BLOCK_FRAMES);
+
+  /* The block is as long as the shortest of the active inputs */
+  for (pid = 0; pid < ARATELIA_PCM_MIXER_NUM_INPUTS; ++pid)
+    {
+      const size_t avail = input_frames_available (ap_prc, pid);
+      if (ap_prc->inputs_[pid].active)
+        {
+          any_active = true;
+          nframes = MIN (nframes, avail);
+        }
+    }
+
+  if (!any_active || 0 == nframes)
+    {
+      if (tiz_filter_prc_is_eos (ap_prc))
+        {
+          /* All streams have ended */
+          tiz_check_omx (release_out_hdr (ap_prc));
+          return OMX_ErrorNone;
+        }
+      return OMX_ErrorNotReady;
+    }
+
+  memset (ap_prc->p_mix_, 0, nframes * out_channels * sizeof (float));
+
+  for (pid = 0; pid < ARATELIA_PCM_MIXER_NUM_INPUTS; ++pid)
+    {
+      mixer_input_t * p_input = &(ap_prc->inputs_[pid]);
+      size_t silence = 0;
+      if (!p_input->active)
+        {
+          continue;
+        }
+      silence = MIN (p_input->silence_frames, nframes);
+      p_input->silence_frames -= silence;
+      if (nframes > silence)
+        {
+          mix_input (ap_prc, pid, ap_prc->p_mix_ + silence * out_channels,
+                     nframes - silence);
+        }
+      p_input->pos += nframes;
+    }
+
+  write_output_frames (ap_prc,
+                       p_out->pBuffer + p_out->nOffset + p_out->nFilledLen,
+                       nframes);
+  p_out->nFilledLen += nframes * out_frame_size;
+  ap_prc->pos_ += nframes;
+
+  if (room == nframes || tiz_filter_prc_is_eos (ap_prc))
+    {
+      tiz_check_omx (release_out_hdr (ap_prc));
+    }
+
+  return OMX_ErrorNone;
+}
+
+static void
+reset_stream_parameters (mixer_prc_t * ap_prc)
+{
+  OMX_U32 pid = 0;
+  assert (ap_prc);
+  for (pid = 0; pid < ARATELIA_PCM_MIXER_NUM_INPUTS; ++pid)
+    {
+      ap_prc->inputs_[pid].active = false;
+      ap_prc->inputs_[pid].p_last_hdr = NULL;
+      ap_prc->inputs_[pid].silence_frames = 0;
+    }
+  ap_prc->ducking_ = false;
+  ap_prc->pos_ = 0;
+  tiz_filter_prc_update_eos_flag (ap_prc, false);
+}
+
+/*
+ * mixerprc
+ */
+
+static void *
+mixer_prc_ctor (void * ap_obj, va_list * app)
+{
+  mixer_prc_t * p_prc = super_ctor (typeOf (ap_obj, "mixerprc"), ap_obj, app);
+  assert (p_prc);
+  p_prc->out_volume_ = ARATELIA_PCM_MIXER_MAX_VOLUME_VALUE;
+  p_prc->out_muted_ = false;
+  tiz_dsp_fader_init (&(p_prc->out_fader_), 1.0f);
+  p_prc->p_mix_ = NULL;
+  p_prc->p_in_f32_ = NULL;
+  p_prc->p_remix_f32_ = NULL;
+  p_prc->dither_ = 1;
+  p_prc->ducking_port_ = get_ducking_port ();
+  p_prc->ducking_gain_ = get_ducking_gain ();
+  reset_stream_parameters (p_prc);
+  return p_prc;
+}
+
+static void *
+mixer_prc_dtor (void * ap_obj)
+{
+  (void) mixer_prc_deallocate_resources (ap_obj);
+  return super_dtor (typeOf (ap_obj, "mixerprc"), ap_obj);
+}
+
+/*
+ * from tizsrv class
+ */
+
+static OMX_ERRORTYPE
+mixer_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
+{
+  return alloc_buffers (ap_obj);
+}
+
+static OMX_ERRORTYPE
+mixer_prc_deallocate_resources (void * ap_obj)
+{
+  free_buffers (ap_obj);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+mixer_prc_prepare_to_transfer (void * ap_obj, OMX_U32 a_pid)
+{
+  mixer_prc_t * p_prc = ap_obj;
+  OMX_U32 pid = 0;
+  assert (p_prc);
+
+  /* The output comes first, as the inputs must match its rate */
+  tiz_check_omx (retrieve_pcm_mode (p_prc, ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX,
+                                    &(p_prc->out_pcmmode_)));
+  tiz_check_omx (retrieve_volume (p_prc, ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX,
+                                  &(p_prc->out_volume_),
+                                  &(p_prc->out_muted_)));
+  tiz_dsp_fader_init (&(p_prc->out_fader_), output_gain (p_prc));
+
+  for (pid = 0; pid < ARATELIA_PCM_MIXER_NUM_INPUTS; ++pid)
+    {
+      if (tiz_filter_prc_is_port_enabled (p_prc, pid))
+        {
+          tiz_check_omx (configure_input (p_prc, pid));
+        }
+    }
+
+  reset_stream_parameters (p_prc);
+  return alloc_buffers (p_prc);
+}
+
+static OMX_ERRORTYPE
+mixer_prc_transfer_and_process (void * ap_obj, OMX_U32 a_pid)
+{
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+mixer_prc_stop_and_return (void * ap_obj)
+{
+  return tiz_filter_prc_release_all_headers (ap_obj);
+}
+
+/*
+ * from tizprc class
+ */
+
+static OMX_ERRORTYPE
+mixer_prc_buffers_ready (const void * ap_prc)
+{
+  mixer_prc_t * p_prc = (mixer_prc_t *) ap_prc;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+
+  if (!p_prc->p_mix_)
+    {
+      return OMX_ErrorNone;
+    }
+
+  while (OMX_ErrorNone == rc)
+    {
+      rc = mix_block (p_prc);
+    }
+  if (OMX_ErrorNotReady == rc)
+    {
+      rc = OMX_ErrorNone;
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+mixer_prc_port_flush (const void * ap_prc, OMX_U32 a_pid)
+{
+  mixer_prc_t * p_prc = (mixer_prc_t *) ap_prc;
+  assert (p_prc);
+  if (is_input_port (a_pid))
+    {
+      /* The input's next buffer starts a new stream */
+      deactivate_input (p_prc, a_pid);
+      tiz_filter_prc_update_eos_flag (p_prc, false);
+    }
+  else if (OMX_ALL == a_pid)
+    {
+      reset_stream_parameters (p_prc);
+    }
+  return tiz_filter_prc_release_header (p_prc, a_pid);
+}
+
+static OMX_ERRORTYPE
+mixer_prc_port_disable (const void * ap_prc, OMX_U32 a_pid)
+{
+  mixer_prc_t * p_prc = (mixer_prc_t *) ap_prc;
+  OMX_ERRORTYPE rc = tiz_filter_prc_release_header (p_prc, a_pid);
+  assert (p_prc);
+  if (is_input_port (a_pid))
+    {
+      /* Detach the input; the other inputs keep playing */
+      deactivate_input (p_prc, a_pid);
+      tiz_filter_prc_update_eos_flag (p_prc, false);
+      tiz_filter_prc_update_port_disabled_flag (p_prc, a_pid, true);
+    }
+  else if (OMX_ALL == a_pid)
+    {
+      OMX_U32 pid = 0;
+      reset_stream_parameters (p_prc);
+      for (pid = 0; pid <= ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX; ++pid)
+        {
+          tiz_filter_prc_update_port_disabled_flag (p_prc, pid, true);
+        }
+    }
+  else
+    {
+      tiz_filter_prc_update_port_disabled_flag (p_prc, a_pid, true);
+    }
+  return rc;
+}
+
+static OMX_ERRORTYPE
+mixer_prc_port_enable (const void * ap_prc, OMX_U32 a_pid)
+{
+  mixer_prc_t * p_prc = (mixer_prc_t *) ap_prc;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  assert (p_prc);
+  if (is_input_port (a_pid))
+    {
+      /* Attach an input. Its stream starts at the current position of the
+         mix when its first buffer arrives. */
+      tiz_filter_prc_update_port_disabled_flag (p_prc, a_pid, false);
+      rc = configure_input (p_prc, a_pid);
+    }
+  else if (OMX_ALL == a_pid)
+    {
+      OMX_U32 pid = 0;
+      for (pid = 0; pid <= ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX; ++pid)
+        {
+          tiz_filter_prc_update_port_disabled_flag (p_prc, pid, false);
+        }
+      rc = mixer_prc_prepare_to_transfer (p_prc, OMX_ALL);
+    }
+  else
+    {
+      tiz_filter_prc_update_port_disabled_flag (p_prc, a_pid, false);
+      rc = mixer_prc_prepare_to_transfer (p_prc, OMX_ALL);
+    }
+  return rc;
+}
+
+static OMX_ERRORTYPE
+mixer_prc_config_change (void * ap_prc, OMX_U32 a_pid,
+                         OMX_INDEXTYPE a_config_idx)
+{
+  mixer_prc_t * p_prc = ap_prc;
+  assert (p_prc);
+
+  if (OMX_IndexConfigAudioVolume != a_config_idx
+      && OMX_IndexConfigAudioMute != a_config_idx)
+    {
+      return OMX_ErrorNone;
+    }
+
+  if (is_input_port (a_pid))
+    {
+      mixer_input_t * p_input = &(p_prc->inputs_[a_pid]);
+      tiz_check_omx (
+        retrieve_volume (p_prc, a_pid, &(p_input->volume), &(p_input->muted)));
+      TIZ_TRACE (handleOf (p_prc), "input [%u] : volume [%d] muted [%s]", a_pid,
+                 p_input->volume, p_input->muted ? "YES" : "NO");
+      tiz_dsp_fader_ramp (
+        &(p_input->fader), input_gain (p_prc, a_pid),
+        ms_to_frames (p_prc, ARATELIA_PCM_MIXER_FADE_TIME_MS));
+    }
+  else if (ARATELIA_PCM_MIXER_OUTPUT_PORT_INDEX == a_pid)
+    {
+      tiz_check_omx (retrieve_volume (p_prc, a_pid, &(p_prc->out_volume_),
+                                      &(p_prc->out_muted_)));
+      tiz_dsp_fader_ramp (
+        &(p_prc->out_fader_), output_gain (p_prc),
+        ms_to_frames (p_prc, ARATELIA_PCM_MIXER_FADE_TIME_MS));
+    }
+  return OMX_ErrorNone;
+}
+
+/*
+ * mixer_prc_class
+ */
+
+static void *
+mixer_prc_class_ctor (void * ap_obj, va_list * app)
+{
+  /* NOTE: Class methods might be added in the future. None for now. */
+  return super_ctor (typeOf (ap_obj, "mixerprc_class"), ap_obj, app);
+}
+
+/*
+ * initialization
+ */
+
+void *
+mixer_prc_class_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizfilterprc = tiz_get_type (ap_hdl, "tizfilterprc");
+  void * mixerprc_class = factory_new
+    /* TIZ_CLASS_COMMENT: class type, class name, parent, size */
+    (classOf (tizfilterprc), "mixerprc_class", classOf (tizfilterprc),
+     sizeof (mixer_prc_class_t),
+     /* TIZ_CLASS_COMMENT: */
+     ap_tos, ap_hdl,
+     /* TIZ_CLASS_COMMENT: class constructor */
+     ctor, mixer_prc_class_ctor,
+     /* TIZ_CLASS_COMMENT: stop value*/
+     0);
+  return mixerprc_class;
+}
+
+void *
+mixer_prc_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizfilterprc = tiz_get_type (ap_hdl, "tizfilterprc");
+  void * mixerprc_class = tiz_get_type (ap_hdl, "mixerprc_class");
+  TIZ_LOG_CLASS (mixerprc_class);
+  void * mixerprc = factory_new
+    /* TIZ_CLASS_COMMENT: class type, class name, parent, size */
+    (mixerprc_class, "mixerprc", tizfilterprc, sizeof (mixer_prc_t),
+     /* TIZ_CLASS_COMMENT: */
+     ap_tos, ap_hdl,
+     /* TIZ_CLASS_COMMENT: class constructor */
+     ctor, mixer_prc_ctor,
+     /* TIZ_CLASS_COMMENT: class destructor */
+     dtor, mixer_prc_dtor,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_allocate_resources, mixer_prc_allocate_resources,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_deallocate_resources, mixer_prc_deallocate_resources,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_prepare_to_transfer, mixer_prc_prepare_to_transfer,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_transfer_and_process, mixer_prc_transfer_and_process,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_stop_and_return, mixer_prc_stop_and_return,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_buffers_ready, mixer_prc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_flush, mixer_prc_port_flush,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_enable, mixer_prc_port_enable,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_disable, mixer_prc_port_disable,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_config_change, mixer_prc_config_change,
+     /* TIZ_CLASS_COMMENT: stop value */
+     0);
+
+  return mixerprc;
+}
@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   mixerprc_decls.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - PCM mixer - processor class decls
+ *
+ *
+ */
+
+#ifndef MIXERPRC_DECLS_H
+#define MIXERPRC_DECLS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <tizplatform.h>
+
+#include <tizfilterprc.h>
+#include <tizfilterprc_decls.h>
+
+#include "mixer.h"
+
+typedef struct mixer_input mixer_input_t;
+struct mixer_input
+{
+  OMX_AUDIO_PARAM_PCMMODETYPE pcmmode;
+  /* A stream is being received on this input */
+  bool active;
+  OMX_S32 volume;
+  bool muted;
+  tiz_dsp_fader_t fader;
+  /* Timestamp alignment state */
+  OMX_BUFFERHEADERTYPE * p_last_hdr;
+  OMX_TICKS anchor_ts;
+  OMX_TICKS last_ts;
+  uint64_t anchor_pos;
+  uint64_t pos;
+  size_t silence_frames;
+};
+
+typedef struct mixer_prc mixer_prc_t;
+struct mixer_prc
+{
+  /* Object */
+  const tiz_filter_prc_t _;
+  mixer_input_t inputs_[ARATELIA_PCM_MIXER_NUM_INPUTS];
+  OMX_AUDIO_PARAM_PCMMODETYPE out_pcmmode_;
+  OMX_S32 out_volume_;
+  bool out_muted_;
+  tiz_dsp_fader_t out_fader_;
+  float * p_mix_;
+  float * p_in_f32_;
+  float * p_remix_f32_;
+  uint32_t dither_;
+  /* Number of frames mixed since the start of the session */
+  uint64_t pos_;
+  OMX_S32 ducking_port_;
+  float ducking_gain_;
+  bool ducking_;
+};
+
+typedef struct mixer_prc_class mixer_prc_class_t;
+struct mixer_prc_class
+{
+  /* Class */
+  const tiz_filter_prc_class_t _;
+  /* NOTE: Class methods might be added in the future */
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIXERPRC_DECLS_H */
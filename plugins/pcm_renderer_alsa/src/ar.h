@@ -55,8 +55,10 @@ extern "C" {
 #define ARATELIA_AUDIO_RENDERER_DEFAULT_ALSA_DEVICE \
   ARATELIA_AUDIO_RENDERER_NULL_ALSA_DEVICE
 #define ARATELIA_AUDIO_RENDERER_DEFAULT_ALSA_MIXER "Master"
-
-#define ARATELIA_AUDIO_RENDERER_DEFAULT_RAMP_STEP_COUNT 20
+#define ARATELIA_AUDIO_RENDERER_MAX_CHANNELS 8
+#define ARATELIA_AUDIO_RENDERER_DEFAULT_BUFFER_TIME_US 100000
+#define ARATELIA_AUDIO_RENDERER_PERIODS_PER_BUFFER 4
+#define ARATELIA_AUDIO_RENDERER_FADE_TIME_MS 30
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,236 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   arcfgport.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Audio Renderer Component config port class
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OMX_Other.h>
+
+#include <tizplatform.h>
+
+#include "ar.h"
+#include "arcfgport.h"
+#include "arcfgport_decls.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.audio_renderer.cfgport"
+#endif
+
+static OMX_U32
+get_time_from_rcfile (const char * ap_key, const OMX_U32 a_default)
+{
+  const char * p_value
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION, ap_key);
+  return (p_value && atoi (p_value) > 0) ? (OMX_U32) atoi (p_value)
+                                         : a_default;
+}
+
+/*
+ * arcfgport class
+ */
+
+static void *
+ar_cfgport_ctor (void * ap_obj, va_list * app)
+{
+  ar_cfgport_t * p_obj = super_ctor (typeOf (ap_obj, "arcfgport"), ap_obj, app);
+
+  assert (p_obj);
+
+  tiz_port_register_index (p_obj, OMX_TizoniaIndexConfigAudioRendererBuffering);
+  tiz_port_register_index (p_obj, OMX_IndexConfigTimeRenderingDelay);
+  tiz_port_register_index (p_obj, OMX_IndexConfigTimePosition);
+
+  p_obj->buffering_.nSize
+    = sizeof (OMX_TIZONIA_AUDIO_CONFIG_RENDERERBUFFERINGTYPE);
+  p_obj->buffering_.nVersion.nVersion = OMX_VERSION;
+  p_obj->buffering_.nPortIndex = ARATELIA_AUDIO_RENDERER_PORT_INDEX;
+  p_obj->buffering_.nBufferTime = get_time_from_rcfile (
+    "OMX.Aratelia.audio_renderer.alsa.pcm.buffer_time_us", 0);
+  p_obj->buffering_.nPeriodTime = get_time_from_rcfile (
+    "OMX.Aratelia.audio_renderer.alsa.pcm.period_time_us", 0);
+
+  return p_obj;
+}
+
+static void *
+ar_cfgport_dtor (void * ap_obj)
+{
+  return super_dtor (typeOf (ap_obj, "arcfgport"), ap_obj);
+}
+
+/*
+ * from tiz_api
+ */
+
+static OMX_ERRORTYPE
+ar_cfgport_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                      OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  const ar_cfgport_t * p_obj = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "GetConfig [%s]...", tiz_idx_to_str (a_index));
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexConfigAudioRendererBuffering == a_index)
+    {
+      OMX_TIZONIA_AUDIO_CONFIG_RENDERERBUFFERINGTYPE * p_buffering
+        = (OMX_TIZONIA_AUDIO_CONFIG_RENDERERBUFFERINGTYPE *) ap_struct;
+      *p_buffering = p_obj->buffering_;
+    }
+  else if (OMX_IndexConfigTimeRenderingDelay == a_index
+           || OMX_IndexConfigTimePosition == a_index)
+    {
+      /* Only the processor knows about the current output delay and
+         position. So lets get the processor to fill this info for us. */
+      void * p_prc = tiz_get_prc (ap_hdl);
+      assert (p_prc);
+      if (OMX_ErrorNone
+          != (rc = tiz_api_GetConfig (p_prc, ap_hdl, a_index, ap_struct)))
+        {
+          TIZ_ERROR (ap_hdl,
+                     "[%s] : Error retrieving [%s] "
+                     "from the processor",
+                     tiz_err_to_str (rc), tiz_idx_to_str (a_index));
+        }
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_GetConfig (typeOf (ap_obj, "arcfgport"), ap_obj, ap_hdl,
+                            a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+ar_cfgport_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                      OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  ar_cfgport_t * p_obj = (ar_cfgport_t *) ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  TIZ_TRACE (ap_hdl, "SetConfig [%s]...", tiz_idx_to_str (a_index));
+  assert (p_obj);
+
+  if (OMX_TizoniaIndexConfigAudioRendererBuffering == a_index)
+    {
+      const OMX_TIZONIA_AUDIO_CONFIG_RENDERERBUFFERINGTYPE * p_buffering
+        = (OMX_TIZONIA_AUDIO_CONFIG_RENDERERBUFFERINGTYPE *) ap_struct;
+      if (p_buffering->nBufferTime > 0 && p_buffering->nPeriodTime > 0
+          && p_buffering->nPeriodTime > p_buffering->nBufferTime)
+        {
+          rc = OMX_ErrorBadParameter;
+        }
+      else
+        {
+          p_obj->buffering_.nBufferTime = p_buffering->nBufferTime;
+          p_obj->buffering_.nPeriodTime = p_buffering->nPeriodTime;
+          TIZ_TRACE (ap_hdl, "nBufferTime [%u] nPeriodTime [%u]...",
+                     p_obj->buffering_.nBufferTime,
+                     p_obj->buffering_.nPeriodTime);
+        }
+    }
+  else if (OMX_IndexConfigTimeRenderingDelay == a_index)
+    {
+      /* This is a read-only index. Simply ignore it. */
+      TIZ_NOTICE (ap_hdl, "Ignoring read-only index [%s] ",
+                  tiz_idx_to_str (a_index));
+    }
+  else if (OMX_IndexConfigTimePosition == a_index)
+    {
+      /* The client has repositioned the stream; the processor takes it from
+         here. */
+      void * p_prc = tiz_get_prc (ap_hdl);
+      assert (p_prc);
+      if (OMX_ErrorNone
+          != (rc = tiz_api_SetConfig (p_prc, ap_hdl, a_index, ap_struct)))
+        {
+          TIZ_ERROR (ap_hdl,
+                     "[%s] : Error passing [%s] "
+                     "to the processor",
+                     tiz_err_to_str (rc), tiz_idx_to_str (a_index));
+        }
+    }
+  else
+    {
+      /* Delegate to the base port */
+      rc = super_SetConfig (typeOf (ap_obj, "arcfgport"), ap_obj, ap_hdl,
+                            a_index, ap_struct);
+    }
+
+  return rc;
+}
+
+/*
+ * ar_cfgport_class
+ */
+
+static void *
+ar_cfgport_class_ctor (void * ap_obj, va_list * app)
+{
+  /* NOTE: Class methods might be added in the future. None for now. */
+  return super_ctor (typeOf (ap_obj, "arcfgport_class"), ap_obj, app);
+}
+
+/*
+ * initialization
+ */
+
+void *
+ar_cfgport_class_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizconfigport = tiz_get_type (ap_hdl, "tizconfigport");
+  void * arcfgport_class
+    = factory_new (classOf (tizconfigport), "arcfgport_class",
+                   classOf (tizconfigport), sizeof (ar_cfgport_class_t),
+                   ap_tos, ap_hdl, ctor, ar_cfgport_class_ctor, 0);
+  return arcfgport_class;
+}
+
+void *
+ar_cfgport_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizconfigport = tiz_get_type (ap_hdl, "tizconfigport");
+  void * arcfgport_class = tiz_get_type (ap_hdl, "arcfgport_class");
+  TIZ_LOG_CLASS (arcfgport_class);
+  void * arcfgport = factory_new (
+    arcfgport_class, "arcfgport", tizconfigport, sizeof (ar_cfgport_t),
+    ap_tos, ap_hdl, ctor, ar_cfgport_ctor, dtor, ar_cfgport_dtor,
+    tiz_api_GetConfig, ar_cfgport_GetConfig, tiz_api_SetConfig,
+    ar_cfgport_SetConfig, 0);
+
+  return arcfgport;
+}
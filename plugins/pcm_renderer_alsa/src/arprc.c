@@ -33,8 +33,12 @@
 #include <assert.h>
 #include <errno.h>
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
-#include <byteswap.h>
+#include <endian.h>
+
+#include <OMX_Other.h>
+#include <OMX_TizoniaExt.h>
 
 #include <tizplatform.h>
 
@@ -422,6 +426,20 @@ release_header (ar_prc_t * ap_prc)
   return OMX_ErrorNone;
 }
 
+/* The frames written to alsa that haven't been heard yet */
+static OMX_S64
+queued_frames (const ar_prc_t * ap_prc)
+{
+  snd_pcm_sframes_t delay = 0;
+  assert (ap_prc);
+  if (!ap_prc->p_pcm_ || 0 != snd_pcm_delay (ap_prc->p_pcm_, &delay)
+      || delay <= 0)
+    {
+      return 0;
+    }
+  return MIN ((OMX_S64) delay, ap_prc->frames_written_);
+}
+
 static inline OMX_ERRORTYPE
 do_flush (ar_prc_t * ap_prc)
 {
@@ -430,121 +448,257 @@ do_flush (ar_prc_t * ap_prc)
   stop_eos_timer (ap_prc);
   if (ap_prc->p_pcm_)
     {
+      /* The dropped frames are never heard */
+      ap_prc->frames_written_ -= queued_frames (ap_prc);
       (void) snd_pcm_drop (ap_prc->p_pcm_);
+      /* Leave the pcm ready to take samples again */
+      (void) snd_pcm_prepare (ap_prc->p_pcm_);
     }
   /* Release any buffers held  */
   return release_header (ap_prc);
 }
 
+static bool
+is_native_byte_order (const OMX_ENDIANTYPE a_endian)
+{
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+  return OMX_EndianLittle == a_endian;
+#else
+  return OMX_EndianBig == a_endian;
+#endif
+}
+
+/* The software gain stage handles 16-bit and float samples; 24-bit streams
+   fall back to the alsa mixer for muting */
+static inline bool
+fader_applies (const ar_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  return (24 != ap_prc->pcmmode_.nBitPerSample);
+}
+
+static inline bool
+fader_active (const ar_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  return (fader_applies (ap_prc)
+          && !tiz_dsp_fader_is_unity (&(ap_prc->fader_)));
+}
+
+static inline bool
+samples_need_arranging (const ar_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  return (ap_prc->pcmmode_.nChannels != ap_prc->num_channels_supported_
+          || ap_prc->swap_byte_order_ || fader_active (ap_prc));
+}
+
 static float
-sint_to_float (const int a_sample)
+target_gain (const ar_prc_t * ap_prc)
 {
-  float f;
-  if (a_sample >= 0)
+  float gain = 0.0f;
+  assert (ap_prc);
+  if (!ap_prc->muted_)
     {
-      f = a_sample / 32767.0;
+      gain = ap_prc->gain_factor_ * ap_prc->loudness_factor_;
+      if (ap_prc->sw_volume_)
+        {
+          gain *= (float) ap_prc->volume_
+                  / (float) ARATELIA_AUDIO_RENDERER_MAX_VOLUME_VALUE;
+        }
     }
-  else
+  return gain;
+}
+
+/* Ramps the software gain towards its current target over a_fade_ms
+   milliseconds of audio. The ramp is sample-accurate, as it progresses with
+   the frames written to the device, not with the wall clock. */
+static void
+fade_to_target_gain (ar_prc_t * ap_prc, const unsigned int a_fade_ms)
+{
+  assert (ap_prc);
+  tiz_dsp_fader_ramp (
+    &(ap_prc->fader_), target_gain (ap_prc),
+    (size_t) ap_prc->pcmmode_.nSamplingRate * a_fade_ms / 1000);
+}
+
+static void
+fade_in (ar_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  tiz_dsp_fader_init (&(ap_prc->fader_), 0.0f);
+  fade_to_target_gain (ap_prc, ARATELIA_AUDIO_RENDERER_FADE_TIME_MS);
+}
+
+/* Converts a normalisation gain into a linear factor, reduced where needed
+   so that the stream's peak doesn't clip. Both values are in millibels. */
+static float
+loudness_factor (const OMX_S32 a_gain_mb, const OMX_S32 a_peak_mb)
+{
+  const float peak = tiz_dsp_db_to_gain ((float) a_peak_mb / 100.0f);
+  float factor = tiz_dsp_db_to_gain ((float) a_gain_mb / 100.0f);
+  if (peak > 0.0f && peak * factor > 1.0f)
     {
-      f = a_sample / 32768.0;
+      factor = 1.0f / peak;
     }
-  return f;
+  return factor;
 }
 
-static int
-float_to_sint (const float a_sample)
+static void
+stop_loudness_analysis (ar_prc_t * ap_prc)
 {
-  float f;
-  f = a_sample * 32767;
-  if (f < -32768)
+  assert (ap_prc);
+  tiz_dsp_loudness_destroy (ap_prc->p_loudness_);
+  ap_prc->p_loudness_ = NULL;
+  ap_prc->analyse_ = false;
+}
+
+/* Measures the frames just written. The meter is created with the first
+   frames of the stream, when the pcm mode is known. */
+static void
+analyse_loudness (ar_prc_t * ap_prc, const OMX_U8 * ap_src,
+                  const size_t a_nframes)
+{
+  assert (ap_prc);
+  if (!ap_prc->analyse_ || 24 == ap_prc->pcmmode_.nBitPerSample
+      || !is_native_byte_order (ap_prc->pcmmode_.eEndian))
     {
-      f = -32768;
+      return;
     }
-  if (f > 32767)
+
+  if (!ap_prc->p_loudness_
+      && OMX_ErrorNone
+           != tiz_dsp_loudness_init (&(ap_prc->p_loudness_),
+                                     ap_prc->pcmmode_.nSamplingRate,
+                                     ap_prc->pcmmode_.nChannels))
     {
-      f = 32767;
+      TIZ_NOTICE (handleOf (ap_prc), "Unable to measure the loudness");
+      stop_loudness_analysis (ap_prc);
+      return;
+    }
+
+  if (16 == ap_prc->pcmmode_.nBitPerSample)
+    {
+      tiz_dsp_loudness_s16 (ap_prc->p_loudness_, (const int16_t *) ap_src,
+                            a_nframes);
+    }
+  else
+    {
+      tiz_dsp_loudness_f32 (ap_prc->p_loudness_, (const float *) ap_src,
+                            a_nframes);
     }
-  return (int) f;
 }
 
 static void
-adjust_gain (const ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
-             const snd_pcm_uframes_t a_samples_per_channel)
+map_channels (const ar_prc_t * ap_prc, OMX_U8 * ap_dst, const OMX_U8 * ap_src,
+              const snd_pcm_uframes_t a_nframes)
 {
-  assert (ap_prc);
-  assert (ap_hdr);
+  const size_t sample_size = ap_prc->pcmmode_.nBitPerSample / 8;
+  const size_t in_channels = ap_prc->pcmmode_.nChannels;
+  const size_t out_channels = ap_prc->num_channels_supported_;
 
-  if (ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE != ap_prc->gain_)
+  if (in_channels == out_channels)
+    {
+      memcpy (ap_dst, ap_src, a_nframes * out_channels * sample_size);
+    }
+  else if (1 == in_channels && 2 == sample_size
+           && out_channels <= ARATELIA_AUDIO_RENDERER_MAX_CHANNELS)
     {
-      int i;
-      int gainadj = (int) (ap_prc->gain_ * 256.);
-      float gain = pow (10., gainadj / 5120.);
-      /*       gain = 3.1f; */
-      /*       fprintf (stderr, "%f samples %ld\n", gain, a_samples_per_channel); */
-      OMX_S16 * pcm = (OMX_S16 *) (ap_hdr->pBuffer + ap_hdr->nOffset);
-      for (i = 0; i < a_samples_per_channel; i++)
+      /* The usual case, mono on a stereo-only device */
+      const int16_t * planes[ARATELIA_AUDIO_RENDERER_MAX_CHANNELS];
+      size_t c = 0;
+      for (c = 0; c < out_channels; ++c)
         {
-          float f = sint_to_float (*pcm);
-          f *= gain;
-          int v = float_to_sint (f);
-          *(pcm++) = (v > 32767) ? 32767 : ((v < -32768) ? -32768 : v);
-          f = sint_to_float (*pcm);
-          f *= gain;
-          v = float_to_sint (f);
-          *(pcm++) = (v > 32767) ? 32767 : ((v < -32768) ? -32768 : v);
+          planes[c] = (const int16_t *) ap_src;
+        }
+      tiz_dsp_interleave_s16 ((int16_t *) ap_dst, planes, out_channels,
+                              a_nframes);
+    }
+  else
+    {
+      /* Device channels are fed from the input channels in a round-robin
+         fashion; any extra input channels are dropped */
+      const size_t in_step = sample_size * in_channels;
+      snd_pcm_uframes_t f = 0;
+      for (f = 0; f < a_nframes; ++f)
+        {
+          size_t c = 0;
+          for (c = 0; c < out_channels; ++c)
+            {
+              memcpy (ap_dst, ap_src + (c % in_channels) * sample_size,
+                      sample_size);
+              ap_dst += sample_size;
+            }
+          ap_src += in_step;
         }
     }
 }
 
 static void
-swap_byte_order_s16 (const ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
-                     const int a_samples)
+swap_samples (const ar_prc_t * ap_prc, OMX_U8 * ap_samples,
+              const size_t a_nsamples)
 {
-  assert (ap_prc);
-  assert (ap_hdr);
-  assert (ap_hdr->pBuffer);
-
-  {
-    OMX_S16 * p_pcm = (OMX_S16 *) (ap_hdr->pBuffer + ap_hdr->nOffset);
-    int i = 0;
-    for (i = 0; i < a_samples; ++i)
-      {
-        *p_pcm = bswap_16 (*p_pcm);
-        p_pcm++;
-      }
-  }
+  switch (ap_prc->pcmmode_.nBitPerSample)
+    {
+      case 16:
+        {
+          tiz_dsp_bswap16 (ap_samples, a_nsamples);
+        }
+        break;
+      case 32:
+        {
+          tiz_dsp_bswap32 (ap_samples, a_nsamples);
+        }
+        break;
+      default:
+        {
+        }
+        break;
+    };
 }
 
+/* Writes a_nframes input frames into ap_dst in the layout that the alsa pcm
+   has been configured with, i.e. with channel duplication, gain and byte
+   order adjustments applied. */
 static void
-swap_byte_order (const ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
+arrange_samples (ar_prc_t * ap_prc, OMX_U8 * ap_dst, const OMX_U8 * ap_src,
+                 const snd_pcm_uframes_t a_nframes)
 {
+  const size_t nchannels = ap_prc->num_channels_supported_;
+  const size_t nsamples = a_nframes * nchannels;
+  bool fade = false;
+  bool swapped = false;
+
   assert (ap_prc);
-  assert (ap_hdr);
+  assert (ap_dst);
+  assert (ap_src);
 
-  if (ap_prc->swap_byte_order_ && !ap_hdr->nOffset)
-    {
-      const int bytes_per_sample = ap_prc->pcmmode_.nBitPerSample / 8;
-      const int samples = ap_hdr->nFilledLen / bytes_per_sample;
-      TIZ_DEBUG (handleOf (ap_prc),
-                 "nBitPerSample = [%d] "
-                 "nFilledLen = [%d] "
-                 "samples = [%d]"
-                 "nOffset = [%d]",
-                 ap_prc->pcmmode_.nBitPerSample, ap_hdr->nFilledLen, samples,
-                 ap_hdr->nOffset);
+  map_channels (ap_prc, ap_dst, ap_src, a_nframes);
 
-      switch (ap_prc->pcmmode_.nBitPerSample)
+  fade = fader_active (ap_prc);
+  if (fade)
+    {
+      /* The gain stage needs samples in the host's byte order */
+      if (!is_native_byte_order (ap_prc->pcmmode_.eEndian))
         {
-          case 16:
-            {
-              swap_byte_order_s16 (ap_prc, ap_hdr, samples);
-            }
-            break;
-          default:
-            {
-            }
-            break;
-        };
+          swap_samples (ap_prc, ap_dst, nsamples);
+          swapped = true;
+        }
+      if (16 == ap_prc->pcmmode_.nBitPerSample)
+        {
+          tiz_dsp_fader_s16 (&(ap_prc->fader_), (int16_t *) ap_dst, nchannels,
+                             a_nframes);
+        }
+      else
+        {
+          tiz_dsp_fader_f32 (&(ap_prc->fader_), (float *) ap_dst, nchannels,
+                             a_nframes);
+        }
+    }
+
+  if (ap_prc->swap_byte_order_ != swapped)
+    {
+      swap_samples (ap_prc, ap_dst, nsamples);
     }
 }
 
@@ -683,7 +837,12 @@ toggle_mute (ar_prc_t * ap_prc, const bool a_mute)
 {
   assert (ap_prc);
 
-  if (!using_null_alsa_device (ap_prc))
+  ap_prc->muted_ = a_mute;
+  if (fader_applies (ap_prc))
+    {
+      fade_to_target_gain (ap_prc, ARATELIA_AUDIO_RENDERER_FADE_TIME_MS);
+    }
+  else if (!using_null_alsa_device (ap_prc))
     {
       long new_volume = (a_mute ? 0 : ap_prc->volume_);
       TIZ_TRACE (handleOf (ap_prc), "new volume = %ld - ap_prc->volume_ [%d]",
@@ -694,58 +853,16 @@ toggle_mute (ar_prc_t * ap_prc, const bool a_mute)
 
 static void
 set_volume (ar_prc_t * ap_prc, const long a_volume)
-{
-  if (!using_null_alsa_device (ap_prc))
-    {
-      if (set_alsa_master_volume (ap_prc, a_volume))
-        {
-          assert (ap_prc);
-          ap_prc->volume_ = a_volume;
-          TIZ_TRACE (handleOf (ap_prc), "ap_prc->volume_ = %ld",
-                     ap_prc->volume_);
-        }
-    }
-}
-
-static void
-prepare_volume_ramp (ar_prc_t * ap_prc)
 {
   assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
-    {
-      ap_prc->ramp_volume_ = ARATELIA_AUDIO_RENDERER_DEFAULT_VOLUME_VALUE;
-      ap_prc->ramp_step_count_
-        = ARATELIA_AUDIO_RENDERER_DEFAULT_RAMP_STEP_COUNT;
-      ap_prc->ramp_step_
-        = (double) ap_prc->ramp_volume_ / (double) ap_prc->ramp_step_count_;
-    }
-}
 
-static OMX_ERRORTYPE
-start_volume_ramp (ar_prc_t * ap_prc)
-{
-  assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
-    {
-      assert (ap_prc->p_vol_ramp_timer_);
-      ap_prc->ramp_volume_ = 0;
-      tiz_check_omx (tiz_srv_timer_watcher_start (
-        ap_prc, ap_prc->p_vol_ramp_timer_, 0.2, 0.2));
-    }
-  return OMX_ErrorNone;
-}
-
-static void
-stop_volume_ramp (ar_prc_t * ap_prc)
-{
-  assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
-    {
-      if (ap_prc->p_vol_ramp_timer_)
-        {
-          (void) tiz_srv_timer_watcher_stop (ap_prc, ap_prc->p_vol_ramp_timer_);
-        }
-    }
+  /* Devices without a usable mixer control get a software volume */
+  ap_prc->sw_volume_ = (using_null_alsa_device (ap_prc)
+                        || !set_alsa_master_volume (ap_prc, a_volume));
+  ap_prc->volume_ = a_volume;
+  TIZ_TRACE (handleOf (ap_prc), "ap_prc->volume_ = %ld (%s)", ap_prc->volume_,
+             ap_prc->sw_volume_ ? "software" : "mixer");
+  fade_to_target_gain (ap_prc, ARATELIA_AUDIO_RENDERER_FADE_TIME_MS);
 }
 
 static OMX_ERRORTYPE
@@ -780,125 +897,323 @@ stop_eos_timer (ar_prc_t * ap_prc)
     }
 }
 
-static OMX_ERRORTYPE
-apply_ramp_step (ar_prc_t * ap_prc)
+static bool
+mmap_access_enabled (ar_prc_t * ap_prc)
+{
+  const char * p_mmap = NULL;
+  assert (ap_prc);
+  p_mmap
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_renderer.alsa.pcm.mmap_access");
+  return (!p_mmap || 0 == strncmp (p_mmap, "true", 4));
+}
+
+static OMX_S32
+get_rt_priority (ar_prc_t * ap_prc)
 {
+  const char * p_prio = NULL;
   assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
+  p_prio
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_renderer.alsa.pcm.rt_priority");
+  return p_prio ? MAX (0, atoi (p_prio)) : 0;
+}
+
+static void
+start_pcm_if_prepared (ar_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  /* With mmap access, alsa does not start the pcm automatically */
+  if (ap_prc->mmap_access_ && ap_prc->p_pcm_
+      && SND_PCM_STATE_PREPARED == snd_pcm_state (ap_prc->p_pcm_))
     {
-      if (ap_prc->ramp_step_count_-- > 0)
+      const int err = snd_pcm_start (ap_prc->p_pcm_);
+      if (err < 0)
         {
-          ap_prc->ramp_volume_ += ap_prc->ramp_step_;
-          set_volume (ap_prc, ap_prc->ramp_volume_);
+          TIZ_ERROR (handleOf (ap_prc), "snd_pcm_start error: %s",
+                     snd_strerror (err));
         }
-      else
+    }
+}
+
+static snd_pcm_sframes_t
+write_frames_mmap (ar_prc_t * ap_prc, const OMX_U8 * ap_src,
+                   const snd_pcm_uframes_t a_nframes)
+{
+  const snd_pcm_channel_area_t * p_areas = NULL;
+  snd_pcm_uframes_t offset = 0;
+  snd_pcm_uframes_t frames = a_nframes;
+  int err = 0;
+
+  assert (ap_prc);
+
+  if ((err = snd_pcm_mmap_begin (ap_prc->p_pcm_, &p_areas, &offset, &frames))
+      < 0)
+    {
+      return err;
+    }
+
+  /* Interleaved access: all the channels share the first area. The samples
+     are arranged directly into alsa's ring buffer. */
+  arrange_samples (ap_prc,
+                   (OMX_U8 *) p_areas[0].addr
+                     + (p_areas[0].first + offset * p_areas[0].step) / 8,
+                   ap_src, frames);
+
+  return snd_pcm_mmap_commit (ap_prc->p_pcm_, offset, frames);
+}
+
+static snd_pcm_sframes_t
+write_frames_rw (ar_prc_t * ap_prc, const OMX_U8 * ap_src,
+                 const snd_pcm_uframes_t a_nframes)
+{
+  const void * p_buffer = ap_src;
+
+  assert (ap_prc);
+
+  if (samples_need_arranging (ap_prc))
+    {
+      const size_t nbytes = a_nframes * ap_prc->num_channels_supported_
+                            * (ap_prc->pcmmode_.nBitPerSample / 8);
+      if (nbytes > ap_prc->sample_buf_size_)
         {
-          stop_volume_ramp (ap_prc);
+          OMX_U8 * p_buf = tiz_mem_realloc (ap_prc->p_sample_buf_, nbytes);
+          if (!p_buf)
+            {
+              return -ENOMEM;
+            }
+          ap_prc->p_sample_buf_ = p_buf;
+          ap_prc->sample_buf_size_ = nbytes;
         }
+      arrange_samples (ap_prc, ap_prc->p_sample_buf_, ap_src, a_nframes);
+      p_buffer = ap_prc->p_sample_buf_;
     }
-  return OMX_ErrorNone;
+
+  return snd_pcm_writei (ap_prc->p_pcm_, p_buffer, a_nframes);
 }
 
 static OMX_ERRORTYPE
-arrange_samples_buffer (ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
-                        unsigned long int a_sample_size,
-                        unsigned long int a_step,
-                        snd_pcm_uframes_t a_samples_per_channel,
-                        const void ** app_buffer)
+recover_pcm (ar_prc_t * ap_prc, snd_pcm_sframes_t a_err)
 {
-  OMX_U8 * p_hdr_buf = NULL;
   assert (ap_prc);
-  assert (app_buffer);
-  assert (ap_hdr);
-  assert (a_samples_per_channel > 0);
+  /* This should handle -EINTR (interrupted system call), -EPIPE (overrun or
+   * underrun) and -ESTRPIPE (stream is suspended) */
+  if (snd_pcm_recover (ap_prc->p_pcm_, (int) a_err, 0) < 0)
+    {
+      TIZ_ERROR (handleOf (ap_prc), "snd_pcm_recover error: %s",
+                 snd_strerror ((int) a_err));
+      return OMX_ErrorUnderflow;
+    }
+  return OMX_ErrorNone;
+}
 
-  p_hdr_buf = ap_hdr->pBuffer + ap_hdr->nOffset;
+static int
+set_hw_params (ar_prc_t * ap_prc, const snd_pcm_format_t a_format,
+               const snd_pcm_access_t a_access, unsigned int a_buffer_time,
+               unsigned int a_period_time)
+{
+  snd_pcm_t * p_pcm = NULL;
+  snd_pcm_hw_params_t * p_params = NULL;
+  int dir = 0;
+  int err = 0;
 
-  if (ap_prc->pcmmode_.nChannels < ap_prc->num_channels_supported_)
+  assert (ap_prc);
+  p_pcm = ap_prc->p_pcm_;
+  p_params = ap_prc->p_hw_params_;
+
+  if ((err = snd_pcm_hw_params_any (p_pcm, p_params)) < 0
+      /* allow alsa-lib resampling */
+      || (err = snd_pcm_hw_params_set_rate_resample (p_pcm, p_params, 1)) < 0
+      || (err = snd_pcm_hw_params_set_access (p_pcm, p_params, a_access)) < 0
+      || (err = snd_pcm_hw_params_set_format (p_pcm, p_params, a_format)) < 0
+      || (err = snd_pcm_hw_params_set_channels (
+            p_pcm, p_params, ap_prc->num_channels_supported_))
+           < 0
+      || (err = snd_pcm_hw_params_set_rate (
+            p_pcm, p_params, ap_prc->pcmmode_.nSamplingRate, 0))
+           < 0
+      || (err = snd_pcm_hw_params_set_buffer_time_near (p_pcm, p_params,
+                                                        &a_buffer_time, &dir))
+           < 0
+      || (err = snd_pcm_hw_params_set_period_time_near (p_pcm, p_params,
+                                                        &a_period_time, &dir))
+           < 0
+      || (err = snd_pcm_hw_params (p_pcm, p_params)) < 0
+      || (err = snd_pcm_hw_params_get_buffer_size (p_params,
+                                                   &ap_prc->buffer_size_))
+           < 0
+      || (err = snd_pcm_hw_params_get_period_size (
+            p_params, &ap_prc->period_size_, &dir))
+           < 0)
     {
-      snd_pcm_uframes_t i = 0;
-      tiz_buffer_clear (ap_prc->p_sample_buf_);
-      while (i < a_samples_per_channel)
+      return err;
+    }
+
+  return 0;
+}
+
+static int
+set_sw_params (ar_prc_t * ap_prc)
+{
+  snd_pcm_sw_params_t * p_params = NULL;
+  int err = 0;
+
+  assert (ap_prc);
+  assert (ap_prc->period_size_ > 0);
+
+  snd_pcm_sw_params_alloca (&p_params);
+
+  /* Start the transfer once the buffer is full (as far as whole periods go),
+     and wake up when at least one period can be written */
+  if ((err = snd_pcm_sw_params_current (ap_prc->p_pcm_, p_params)) < 0
+      || (err = snd_pcm_sw_params_set_start_threshold (
+            ap_prc->p_pcm_, p_params,
+            (ap_prc->buffer_size_ / ap_prc->period_size_)
+              * ap_prc->period_size_))
+           < 0
+      || (err = snd_pcm_sw_params_set_avail_min (ap_prc->p_pcm_, p_params,
+                                                 ap_prc->period_size_))
+           < 0
+      || (err = snd_pcm_sw_params (ap_prc->p_pcm_, p_params)) < 0)
+    {
+      return err;
+    }
+
+  return 0;
+}
+
+static OMX_ERRORTYPE
+configure_alsa_pcm (ar_prc_t * ap_prc, const snd_pcm_format_t a_format)
+{
+  OMX_TIZONIA_AUDIO_CONFIG_RENDERERBUFFERINGTYPE buffering;
+  snd_pcm_access_t access[] = {SND_PCM_ACCESS_MMAP_INTERLEAVED,
+                               SND_PCM_ACCESS_RW_INTERLEAVED};
+  unsigned int buffer_time[2];
+  unsigned int period_time[2];
+  size_t i = 0;
+  size_t j = 0;
+  int err = 0;
+
+  assert (ap_prc);
+
+  TIZ_INIT_OMX_PORT_STRUCT (buffering, ARATELIA_AUDIO_RENDERER_PORT_INDEX);
+  tiz_check_omx (tiz_api_GetConfig (
+    tiz_get_krn (handleOf (ap_prc)), handleOf (ap_prc),
+    OMX_TizoniaIndexConfigAudioRendererBuffering, &buffering));
+
+  /* First try with the requested buffer and period times; if the device
+     doesn't accept them, fall back to the defaults */
+  buffer_time[0] = buffering.nBufferTime > 0
+                     ? buffering.nBufferTime
+                     : ARATELIA_AUDIO_RENDERER_DEFAULT_BUFFER_TIME_US;
+  period_time[0] = buffering.nPeriodTime > 0
+                     ? buffering.nPeriodTime
+                     : buffer_time[0] / ARATELIA_AUDIO_RENDERER_PERIODS_PER_BUFFER;
+  buffer_time[1] = ARATELIA_AUDIO_RENDERER_DEFAULT_BUFFER_TIME_US;
+  period_time[1] = ARATELIA_AUDIO_RENDERER_DEFAULT_BUFFER_TIME_US
+                   / ARATELIA_AUDIO_RENDERER_PERIODS_PER_BUFFER;
+
+  /* Prefer mmap access, so that samples can be written directly into alsa's
+     ring buffer, but fall back to read/write access if the device does not
+     support it. */
+  for (i = mmap_access_enabled (ap_prc) ? 0 : 1; i < 2; ++i)
+    {
+      for (j = 0; j < 2; ++j)
         {
-          int j = 0;
-          while (j < ap_prc->num_channels_supported_)
+          if (0 == (err = set_hw_params (ap_prc, a_format, access[i],
+                                         buffer_time[j], period_time[j])))
             {
-              if (a_sample_size
-                  != tiz_buffer_push (ap_prc->p_sample_buf_,
-                                      p_hdr_buf + (a_step * i), a_sample_size))
-                {
-                  TIZ_ERROR (handleOf (ap_prc),
-                             "Unable to copy all sample data into the buffer");
-                  /* Early return */
-                  return OMX_ErrorInsufficientResources;
-                }
-              j += 1;
+              goto negotiated;
             }
-          i += 1;
+          TIZ_NOTICE (handleOf (ap_prc),
+                      "Unable to configure the pcm with access [%s] "
+                      "buffer time [%u us] period time [%u us] : %s",
+                      i == 0 ? "MMAP_INTERLEAVED" : "RW_INTERLEAVED",
+                      buffer_time[j], period_time[j], snd_strerror (err));
         }
-      *app_buffer = tiz_buffer_get (ap_prc->p_sample_buf_);
-      TIZ_DEBUG (
-        handleOf (ap_prc),
-        "a_samples_per_channel [%u] tiz_buffer [%p] avail [%d] offset [%d]",
-        a_samples_per_channel, *app_buffer,
-        tiz_buffer_available (ap_prc->p_sample_buf_),
-        tiz_buffer_offset (ap_prc->p_sample_buf_));
     }
-  else
+
+  TIZ_ERROR (handleOf (ap_prc),
+             "[OMX_ErrorInsufficientResources] : "
+             "Unable to configure the alsa pcm (%s)",
+             snd_strerror (err));
+  return OMX_ErrorInsufficientResources;
+
+negotiated:
+  ap_prc->mmap_access_ = (SND_PCM_ACCESS_MMAP_INTERLEAVED == access[i]);
+  bail_on_snd_pcm_error (set_sw_params (ap_prc));
+
+  TIZ_NOTICE (handleOf (ap_prc),
+              "ALSA pcm access : [%s] buffer size : [%lu frames] "
+              "period size : [%lu frames]",
+              ap_prc->mmap_access_ ? "MMAP_INTERLEAVED" : "RW_INTERLEAVED",
+              ap_prc->buffer_size_, ap_prc->period_size_);
+
+  return OMX_ErrorNone;
+}
+
+static void
+set_rt_priority (ar_prc_t * ap_prc, const bool a_enable)
+{
+  assert (ap_prc);
+  /* Short periods leave very little slack to the component's thread; running
+     it with real-time priority keeps other processes from delaying it. */
+  if (ap_prc->rt_priority_ > 0)
     {
-      *app_buffer = p_hdr_buf;
+      (void) tiz_thread_set_rt_priority (a_enable ? ap_prc->rt_priority_ : 0);
     }
-  return OMX_ErrorNone;
 }
 
 static OMX_ERRORTYPE
 render_buffer (ar_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
-  unsigned long int sample_size = 0;
   unsigned long int step = 0;
   snd_pcm_uframes_t samples_per_channel = 0;
 
   assert (ap_prc);
   assert (ap_hdr);
 
-  sample_size = ap_prc->pcmmode_.nBitPerSample / 8;
-  step = sample_size * ap_prc->pcmmode_.nChannels;
+  step = (ap_prc->pcmmode_.nBitPerSample / 8) * ap_prc->pcmmode_.nChannels;
   assert (ap_hdr->nFilledLen > 0);
   samples_per_channel = ap_hdr->nFilledLen / step;
 
-  adjust_gain (ap_prc, ap_hdr, samples_per_channel);
-  swap_byte_order (ap_prc, ap_hdr);
-
   while (samples_per_channel > 0 && OMX_ErrorNone == rc)
     {
-      const void * p_buffer = NULL;
-      snd_pcm_sframes_t err = 0;
+      const OMX_U8 * p_src = ap_hdr->pBuffer + ap_hdr->nOffset;
+      snd_pcm_sframes_t err = snd_pcm_avail_update (ap_prc->p_pcm_);
 
-      tiz_check_omx (arrange_samples_buffer (ap_prc, ap_hdr, sample_size, step,
-                                             samples_per_channel, &p_buffer));
-
-      err = snd_pcm_writei (ap_prc->p_pcm_, p_buffer, samples_per_channel);
+      if (0 == err)
+        {
+          /* alsa buffers are full */
+          start_pcm_if_prepared (ap_prc);
+          err = -EAGAIN;
+        }
+      else if (err > 0)
+        {
+          const snd_pcm_uframes_t frames
+            = MIN (samples_per_channel, (snd_pcm_uframes_t) err);
+          err = ap_prc->mmap_access_
+                  ? write_frames_mmap (ap_prc, p_src, frames)
+                  : write_frames_rw (ap_prc, p_src, frames);
+        }
 
       if (-EAGAIN == err)
         {
-          /* got -EAGAIN, alsa buffers are full */
           rc = OMX_ErrorNoMore;
         }
+      else if (-ENOMEM == err)
+        {
+          rc = OMX_ErrorInsufficientResources;
+        }
       else if (err < 0)
         {
-          /* This should handle -EINTR (interrupted system call), -EPIPE
-           * (overrun or underrun) and -ESTRPIPE (stream is suspended) */
-          err = snd_pcm_recover (ap_prc->p_pcm_, (int) err, 0);
-          if (err < 0)
-            {
-              TIZ_ERROR (handleOf (ap_prc), "snd_pcm_recover error: %s",
-                         snd_strerror ((int) err));
-              rc = OMX_ErrorUnderflow;
-            }
+          rc = recover_pcm (ap_prc, err);
         }
       else
         {
+          analyse_loudness (ap_prc, p_src, err);
+          ap_prc->frames_written_ += err;
           ap_hdr->nOffset += err * step;
           ap_hdr->nFilledLen -= err * step;
           samples_per_channel -= err;
@@ -958,6 +1273,9 @@ buffer_emptied (ar_prc_t * ap_prc)
       /* Record the fact that EOS shown up. We'll signal it to the client on a
          timer event */
       ap_prc->nflags_ = ap_prc->p_inhdr_->nFlags;
+      /* Make sure that a short stream is played out even if it didn't fill
+         the alsa buffer */
+      start_pcm_if_prepared (ap_prc);
       tiz_check_omx (start_eos_timer (ap_prc));
     }
 
@@ -1007,21 +1325,31 @@ ar_prc_ctor (void * ap_prc, va_list * app)
   p_prc->swap_byte_order_ = false;
   p_prc->num_channels_supported_ = 0;
   p_prc->p_sample_buf_ = NULL;
+  p_prc->sample_buf_size_ = 0;
+  p_prc->mmap_access_ = false;
+  p_prc->buffer_size_ = 0;
+  p_prc->period_size_ = 0;
+  p_prc->rt_priority_ = 0;
   p_prc->descriptor_count_ = 0;
   p_prc->p_fds_ = NULL;
   p_prc->p_ev_io_ = NULL;
-  p_prc->p_vol_ramp_timer_ = NULL;
   p_prc->p_eos_timer_ = NULL;
   p_prc->p_inhdr_ = NULL;
   p_prc->port_disabled_ = false;
   p_prc->awaiting_io_ev_ = false;
   p_prc->nflags_ = 0;
   p_prc->gain_ = ARATELIA_AUDIO_RENDERER_DEFAULT_GAIN_VALUE;
+  p_prc->gain_factor_ = tiz_dsp_db_to_gain (p_prc->gain_);
   p_prc->volume_ = ARATELIA_AUDIO_RENDERER_DEFAULT_VOLUME_VALUE;
-  p_prc->ramp_enabled_ = false;
-  p_prc->ramp_step_ = 0;
-  p_prc->ramp_step_count_ = ARATELIA_AUDIO_RENDERER_DEFAULT_RAMP_STEP_COUNT;
-  p_prc->ramp_volume_ = 0;
+  p_prc->muted_ = false;
+  p_prc->sw_volume_ = false;
+  tiz_dsp_fader_init (&(p_prc->fader_), p_prc->gain_factor_);
+  p_prc->loudness_factor_ = 1.0f;
+  p_prc->analyse_ = false;
+  p_prc->p_loudness_ = NULL;
+  p_prc->origin_ = 0;
+  p_prc->pending_origin_ = 0;
+  p_prc->frames_written_ = 0;
   return p_prc;
 }
 
@@ -1043,11 +1371,10 @@ ar_prc_allocate_resources (void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
 
   assert (p_prc);
 
-  tiz_check_omx (tiz_buffer_init (
-    &p_prc->p_sample_buf_, ARATELIA_AUDIO_RENDERER_PORT_MIN_BUF_SIZE * 2));
-
   snd_lib_error_set_handler (alsa_error_handler);
 
+  p_prc->rt_priority_ = get_rt_priority (p_prc);
+
   if (!p_prc->p_pcm_)
     {
       char * p_device = get_alsa_device (p_prc);
@@ -1074,13 +1401,6 @@ ar_prc_allocate_resources (void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
         = tiz_mem_alloc (sizeof (struct pollfd) * p_prc->descriptor_count_);
       tiz_check_null_ret_oom (p_prc->p_fds_);
 
-      /* This is to generate volume ramps when needed */
-      if (p_prc->ramp_enabled_)
-        {
-          tiz_check_omx (
-            tiz_srv_timer_watcher_init (p_prc, &(p_prc->p_vol_ramp_timer_)));
-        }
-
       /* This is to produce accurate EOS flag events */
       tiz_check_omx (
         tiz_srv_timer_watcher_init (p_prc, &(p_prc->p_eos_timer_)));
@@ -1097,6 +1417,8 @@ ar_prc_prepare_to_transfer (void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
   ar_prc_t * p_prc = ap_prc;
   assert (p_prc);
   p_prc->nflags_ = 0;
+  p_prc->origin_ = 0;
+  p_prc->frames_written_ = 0;
 
   if (p_prc->p_pcm_)
     {
@@ -1115,13 +1437,9 @@ ar_prc_prepare_to_transfer (void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
       tiz_check_omx (retrieve_alsa_pcm_format_and_num_channels (
         p_prc, &snd_pcm_format, &p_prc->num_channels_supported_));
 
-      /* This sets the hardware and software parameters in a convenient way. */
-      bail_on_snd_pcm_error (snd_pcm_set_params (
-        p_prc->p_pcm_, snd_pcm_format, SND_PCM_ACCESS_RW_INTERLEAVED,
-        (unsigned int) p_prc->num_channels_supported_,
-        p_prc->pcmmode_.nSamplingRate, 0, /* allow alsa-lib resampling */
-        100000                            /* overall latency in us */
-        ));
+      /* Negotiate the hardware and software parameters */
+      tiz_check_omx (configure_alsa_pcm (p_prc, snd_pcm_format));
+      set_rt_priority (p_prc, true);
 
       bail_on_snd_pcm_error (snd_pcm_poll_descriptors (
         p_prc->p_pcm_, p_prc->p_fds_, p_prc->descriptor_count_));
@@ -1156,9 +1474,8 @@ ar_prc_transfer_and_process (void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
   ar_prc_t * p_prc = ap_prc;
   assert (p_prc);
   log_alsa_pcm_state (p_prc);
-  prepare_volume_ramp (p_prc);
-  tiz_check_omx (start_volume_ramp (p_prc));
-  tiz_check_omx (apply_ramp_step (p_prc));
+  /* The ring buffer starts empty, so fade in to avoid a click */
+  fade_in (p_prc);
   return OMX_ErrorNone;
 }
 
@@ -1166,7 +1483,7 @@ static OMX_ERRORTYPE
 ar_prc_stop_and_return (void * ap_prc)
 {
   log_alsa_pcm_state (ap_prc);
-  stop_volume_ramp (ap_prc);
+  set_rt_priority (ap_prc, false);
   stop_eos_timer (ap_prc);
   return do_flush (ap_prc);
 }
@@ -1180,12 +1497,6 @@ ar_prc_deallocate_resources (void * ap_prc)
   tiz_srv_timer_watcher_destroy (p_prc, p_prc->p_eos_timer_);
   p_prc->p_eos_timer_ = NULL;
 
-  if (p_prc->ramp_enabled_)
-    {
-      tiz_srv_timer_watcher_destroy (p_prc, p_prc->p_vol_ramp_timer_);
-      p_prc->p_vol_ramp_timer_ = NULL;
-    }
-
   p_prc->descriptor_count_ = 0;
   tiz_mem_free (p_prc->p_fds_);
   p_prc->p_fds_ = NULL;
@@ -1202,8 +1513,9 @@ ar_prc_deallocate_resources (void * ap_prc)
       p_prc->p_hw_params_ = NULL;
     }
 
-  tiz_buffer_destroy (p_prc->p_sample_buf_);
+  tiz_mem_free (p_prc->p_sample_buf_);
   p_prc->p_sample_buf_ = NULL;
+  p_prc->sample_buf_size_ = 0;
 
   tiz_mem_free (p_prc->p_pcm_name_);
   p_prc->p_pcm_name_ = NULL;
@@ -1211,6 +1523,8 @@ ar_prc_deallocate_resources (void * ap_prc)
   tiz_mem_free (p_prc->p_mixer_name_);
   p_prc->p_mixer_name_ = NULL;
 
+  stop_loudness_analysis (p_prc);
+
   return OMX_ErrorNone;
 }
 
@@ -1264,10 +1578,6 @@ ar_prc_timer_ready (void * ap_prc, tiz_event_timer_t * ap_ev_timer,
       tiz_srv_issue_event ((OMX_PTR) ap_prc, OMX_EventBufferFlag, 0,
                            p_prc->nflags_, NULL);
     }
-  else if (ap_ev_timer == p_prc->p_vol_ramp_timer_)
-    {
-      rc = apply_ramp_step (ap_prc);
-    }
   else
     {
       assert (0);
@@ -1285,12 +1595,17 @@ ar_prc_pause (const void * ap_prc)
   log_alsa_pcm_state (p_prc);
   stop_io_watcher (p_prc);
   stop_eos_timer (p_prc);
-  if (snd_pcm_hw_params_can_pause (p_prc->p_hw_params_))
+  if (SND_PCM_STATE_RUNNING != snd_pcm_state (p_prc->p_pcm_))
+    {
+      /* Nothing is playing yet; whatever is queued stays put */
+    }
+  else if (snd_pcm_hw_params_can_pause (p_prc->p_hw_params_))
     {
       bail_on_snd_pcm_error (snd_pcm_pause (p_prc->p_pcm_, pause));
     }
   else
     {
+      p_prc->frames_written_ -= queued_frames (p_prc);
       bail_on_snd_pcm_error (snd_pcm_drop (p_prc->p_pcm_));
     }
   return rc;
@@ -1304,13 +1619,15 @@ ar_prc_resume (const void * ap_prc)
   assert (p_prc);
   start_eos_timer (p_prc);
   log_alsa_pcm_state (p_prc);
-  if (snd_pcm_hw_params_can_pause (p_prc->p_hw_params_))
+  if (SND_PCM_STATE_PAUSED == snd_pcm_state (p_prc->p_pcm_))
     {
       bail_on_snd_pcm_error (snd_pcm_pause (p_prc->p_pcm_, resume));
     }
-  else
+  else if (SND_PCM_STATE_PREPARED != snd_pcm_state (p_prc->p_pcm_))
     {
+      /* The samples were dropped on pause, so fade in from silence */
       bail_on_snd_pcm_error (snd_pcm_prepare (p_prc->p_pcm_));
+      fade_in (p_prc);
     }
   tiz_check_omx (start_io_watcher (p_prc));
   return OMX_ErrorNone;
@@ -1320,6 +1637,11 @@ static OMX_ERRORTYPE
 ar_prc_port_flush (const void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
 {
   ar_prc_t * p_prc = (ar_prc_t *) ap_prc;
+  /* A flush means a seek or a stream change; a partial measurement would be
+     meaningless */
+  stop_loudness_analysis (p_prc);
+  /* Whatever comes next starts from silence */
+  fade_in (p_prc);
   return do_flush (p_prc);
 }
 
@@ -1329,7 +1651,6 @@ ar_prc_port_disable (const void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
   ar_prc_t * p_prc = (ar_prc_t *) ap_prc;
   assert (p_prc);
   log_alsa_pcm_state (p_prc);
-  stop_volume_ramp (p_prc);
   p_prc->port_disabled_ = true;
   if (p_prc->p_pcm_)
     {
@@ -1386,8 +1707,6 @@ ar_prc_config_change (void * ap_prc, OMX_U32 a_pid, OMX_INDEXTYPE a_config_idx)
               && volume.sVolume.nValue
                    >= ARATELIA_AUDIO_RENDERER_MIN_VOLUME_VALUE)
             {
-              /* TODO: Volume should be done by adjusting the gain, not ALSA's
-               * master volume! */
               set_volume (p_prc, volume.sVolume.nValue);
             }
         }
@@ -1398,17 +1717,149 @@ ar_prc_config_change (void * ap_prc, OMX_U32 a_pid, OMX_INDEXTYPE a_config_idx)
           tiz_check_omx (tiz_api_GetConfig (tiz_get_krn (handleOf (p_prc)),
                                             handleOf (p_prc),
                                             OMX_IndexConfigAudioMute, &mute));
-          /* TODO: Volume should be done by adjusting the gain, not ALSA's
-           * master volume! */
           TIZ_TRACE (handleOf (p_prc),
                      "[OMX_IndexConfigAudioMute] : bMute = [%s]",
                      (mute.bMute == OMX_FALSE ? "FALSE" : "TRUE"));
           toggle_mute (p_prc, mute.bMute == OMX_TRUE ? true : false);
         }
+      else if (OMX_TizoniaIndexConfigAudioLoudness == a_config_idx)
+        {
+          OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE loudness;
+          TIZ_INIT_OMX_PORT_STRUCT (loudness,
+                                    ARATELIA_AUDIO_RENDERER_PORT_INDEX);
+          tiz_check_omx (tiz_api_GetConfig (
+            tiz_get_krn (handleOf (p_prc)), handleOf (p_prc),
+            OMX_TizoniaIndexConfigAudioLoudness, &loudness));
+          p_prc->loudness_factor_
+            = loudness_factor (loudness.nGain, loudness.nPeak);
+          TIZ_TRACE (handleOf (p_prc),
+                     "[OMX_TizoniaIndexConfigAudioLoudness] : nGain = [%d] "
+                     "nPeak = [%d] bAnalyse = [%s] factor = [%f]",
+                     (int) loudness.nGain, (int) loudness.nPeak,
+                     (loudness.bAnalyse == OMX_FALSE ? "FALSE" : "TRUE"),
+                     p_prc->loudness_factor_);
+          if (fader_applies (p_prc))
+            {
+              fade_to_target_gain (p_prc, ARATELIA_AUDIO_RENDERER_FADE_TIME_MS);
+            }
+          stop_loudness_analysis (p_prc);
+          p_prc->analyse_ = (loudness.bAnalyse == OMX_TRUE);
+        }
+      else if (OMX_IndexConfigTimePosition == a_config_idx)
+        {
+          /* The stream has been repositioned; the next frame written is the
+             first one at the new position */
+          p_prc->origin_ = p_prc->pending_origin_;
+          p_prc->frames_written_ = 0;
+          TIZ_TRACE (handleOf (p_prc),
+                     "[OMX_IndexConfigTimePosition] : origin = [%lld] us",
+                     (long long) p_prc->origin_);
+        }
+    }
+  return rc;
+}
+
+/*
+ * from tiz_api
+ */
+
+static OMX_ERRORTYPE
+ar_prc_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                  OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  const ar_prc_t * p_prc = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (p_prc);
+  assert (ap_struct);
+
+  if (OMX_IndexConfigTimeRenderingDelay == a_index)
+    {
+      /* Report the time it will take for a sample written now to be heard */
+      OMX_TIME_CONFIG_RENDERINGDELAYTYPE * p_delay = ap_struct;
+      snd_pcm_sframes_t delay = 0;
+      p_delay->nRenderingDelay = 0;
+      if (p_prc->p_pcm_ && p_prc->pcmmode_.nSamplingRate > 0
+          && 0 == snd_pcm_delay (p_prc->p_pcm_, &delay) && delay > 0)
+        {
+          p_delay->nRenderingDelay
+            = (OMX_TICKS) delay * 1000000 / p_prc->pcmmode_.nSamplingRate;
+        }
+      TIZ_TRACE (ap_hdl, "[OMX_IndexConfigTimeRenderingDelay] : %ld frames",
+                 (long) delay);
     }
+  else if (OMX_IndexConfigTimePosition == a_index)
+    {
+      /* Report the media time of the sample being heard: the last position
+         set, plus the frames played since */
+      OMX_TIME_CONFIG_TIMESTAMPTYPE * p_position = ap_struct;
+      const OMX_S64 frames = p_prc->frames_written_ - queued_frames (p_prc);
+      p_position->nTimestamp = p_prc->origin_;
+      if (p_prc->pcmmode_.nSamplingRate > 0 && frames > 0)
+        {
+          p_position->nTimestamp
+            += (OMX_TICKS) frames * 1000000 / p_prc->pcmmode_.nSamplingRate;
+        }
+      TIZ_TRACE (ap_hdl, "[OMX_IndexConfigTimePosition] : %lld us",
+                 (long long) p_position->nTimestamp);
+    }
+  else if (OMX_TizoniaIndexConfigAudioLoudness == a_index)
+    {
+      /* Report the measurements taken so far; the kernel has already filled
+         in the settings */
+      OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE * p_loudness = ap_struct;
+      p_loudness->nLoudness = 0;
+      p_loudness->nTruePeak = 0;
+      p_loudness->nMeasured = 0;
+      if (p_prc->p_loudness_ && p_prc->pcmmode_.nSamplingRate > 0)
+        {
+          const float lufs = tiz_dsp_loudness_integrated (p_prc->p_loudness_);
+          const float peak = tiz_dsp_loudness_true_peak (p_prc->p_loudness_);
+          if (lufs > -HUGE_VALF && peak > 0.0f)
+            {
+              p_loudness->nLoudness = (OMX_S32) lroundf (lufs * 100.0f);
+              p_loudness->nTruePeak
+                = (OMX_S32) lroundf (2000.0f * log10f (peak));
+              p_loudness->nMeasured
+                = (OMX_U32) (tiz_dsp_loudness_frames (p_prc->p_loudness_)
+                             * 1000 / p_prc->pcmmode_.nSamplingRate);
+            }
+        }
+      TIZ_TRACE (ap_hdl,
+                 "[OMX_TizoniaIndexConfigAudioLoudness] : %d LUFS/100 "
+                 "(%u ms)",
+                 (int) p_loudness->nLoudness,
+                 (unsigned int) p_loudness->nMeasured);
+    }
+  else
+    {
+      rc = super_GetConfig (typeOf (ap_obj, "arprc"), ap_obj, ap_hdl, a_index,
+                            ap_struct);
+    }
+
   return rc;
 }
 
+static OMX_ERRORTYPE
+ar_prc_SetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                  OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  ar_prc_t * p_prc = (ar_prc_t *) ap_obj;
+
+  assert (p_prc);
+  assert (ap_struct);
+
+  if (OMX_IndexConfigTimePosition == a_index)
+    {
+      /* Picked up by config_change, in the processor's thread */
+      p_prc->pending_origin_
+        = ((OMX_TIME_CONFIG_TIMESTAMPTYPE *) ap_struct)->nTimestamp;
+    }
+
+  return super_SetConfig (typeOf (ap_obj, "arprc"), ap_obj, ap_hdl, a_index,
+                          ap_struct);
+}
+
 /*
  * ar_prc_class
  */
@@ -1483,6 +1934,10 @@ ar_prc_init (void * ap_tos, void * ap_hdl)
      tiz_prc_port_enable, ar_prc_port_enable,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_config_change, ar_prc_config_change,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_GetConfig, ar_prc_GetConfig,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_SetConfig, ar_prc_SetConfig,
      /* TIZ_CLASS_COMMENT: stop value */
      0);
 
@@ -39,6 +39,7 @@ extern "C" {
 
 #include <OMX_Core.h>
 
+#include <tizplatform.h>
 #include <tizprc_decls.h>
 
 typedef struct ar_prc ar_prc_t;
@@ -53,22 +54,32 @@ struct ar_prc
   char * p_mixer_name_;
   bool swap_byte_order_;
   unsigned int num_channels_supported_;
-  tiz_buffer_t * p_sample_buf_;
+  OMX_U8 * p_sample_buf_;
+  size_t sample_buf_size_;
+  bool mmap_access_;
+  snd_pcm_uframes_t buffer_size_;
+  snd_pcm_uframes_t period_size_;
+  OMX_S32 rt_priority_;
   int descriptor_count_;
   struct pollfd * p_fds_;
   tiz_event_io_t * p_ev_io_;
-  tiz_event_timer_t * p_vol_ramp_timer_;
   tiz_event_timer_t * p_eos_timer_;
   OMX_BUFFERHEADERTYPE * p_inhdr_;
   bool port_disabled_;
   bool awaiting_io_ev_;
   OMX_U32 nflags_;
-  float gain_;
+  float gain_;        /* in dB */
+  float gain_factor_; /* linear, derived from gain_ */
   long volume_;
-  bool ramp_enabled_;
-  long ramp_step_;
-  long ramp_step_count_;
-  long ramp_volume_;
+  bool muted_;
+  bool sw_volume_;      /* volume_ is applied by the fader, not the mixer */
+  tiz_dsp_fader_t fader_;
+  float loudness_factor_; /* linear, loudness normalisation */
+  bool analyse_;           /* measure the loudness of the current stream */
+  tiz_dsp_loudness_t * p_loudness_;
+  OMX_TICKS origin_;         /* media time of the stream's first frame */
+  OMX_TICKS pending_origin_; /* set by the client, applied in config_change */
+  OMX_S64 frames_written_;   /* to alsa, since origin_ */
 };
 
 typedef struct ar_prc_class ar_prc_class_t;
@@ -31,7 +31,12 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <endian.h>
+#include <math.h>
+
+#include <OMX_TizoniaExt.h>
 
 #include <tizplatform.h>
 
@@ -225,32 +230,195 @@ buffer_emptied (pulsear_prc_t * ap_prc)
   return release_header (ap_prc);
 }
 
+static bool
+is_native_byte_order (const OMX_ENDIANTYPE a_endian)
+{
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+  return OMX_EndianLittle == a_endian;
+#else
+  return OMX_EndianBig == a_endian;
+#endif
+}
+
+/* The software gain stage handles 16-bit and float samples */
+static inline bool
+fader_active (const pulsear_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  return (24 != ap_prc->pcmmode_.nBitPerSample
+          && !tiz_dsp_fader_is_unity (&(ap_prc->fader_)));
+}
+
+static void
+swap_samples (const pulsear_prc_t * ap_prc, OMX_U8 * ap_samples,
+              const size_t a_nsamples)
+{
+  if (16 == ap_prc->pcmmode_.nBitPerSample)
+    {
+      tiz_dsp_bswap16 (ap_samples, a_nsamples);
+    }
+  else
+    {
+      tiz_dsp_bswap32 (ap_samples, a_nsamples);
+    }
+}
+
+/* Applies the software gain stage, in place, to the data that is about to
+   be written to the stream. */
+static void
+apply_fader (pulsear_prc_t * ap_prc, void * ap_data, const size_t a_nbytes)
+{
+  const size_t nchannels = ap_prc->pcmmode_.nChannels;
+  const size_t nframes
+    = a_nbytes / ((ap_prc->pcmmode_.nBitPerSample / 8) * nchannels);
+  const bool native = is_native_byte_order (ap_prc->pcmmode_.eEndian);
+
+  assert (ap_prc);
+  assert (ap_data);
+
+  if (!native)
+    {
+      swap_samples (ap_prc, ap_data, nframes * nchannels);
+    }
+  if (16 == ap_prc->pcmmode_.nBitPerSample)
+    {
+      tiz_dsp_fader_s16 (&(ap_prc->fader_), (int16_t *) ap_data, nchannels,
+                         nframes);
+    }
+  else
+    {
+      tiz_dsp_fader_f32 (&(ap_prc->fader_), (float *) ap_data, nchannels,
+                         nframes);
+    }
+  if (!native)
+    {
+      swap_samples (ap_prc, ap_data, nframes * nchannels);
+    }
+}
+
+static void
+stop_loudness_analysis (pulsear_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  tiz_dsp_loudness_destroy (ap_prc->p_loudness_);
+  ap_prc->p_loudness_ = NULL;
+  ap_prc->analyse_ = false;
+}
+
+/* Measures the frames about to be written, before the gain stage. The meter
+   is created with the first frames of the stream, when the pcm mode is
+   known. */
+static void
+analyse_loudness (pulsear_prc_t * ap_prc, const OMX_U8 * ap_src,
+                  const size_t a_nbytes)
+{
+  size_t nframes = 0;
+  assert (ap_prc);
+  if (!ap_prc->analyse_ || 24 == ap_prc->pcmmode_.nBitPerSample
+      || !is_native_byte_order (ap_prc->pcmmode_.eEndian))
+    {
+      return;
+    }
+
+  if (!ap_prc->p_loudness_
+      && OMX_ErrorNone
+           != tiz_dsp_loudness_init (&(ap_prc->p_loudness_),
+                                     ap_prc->pcmmode_.nSamplingRate,
+                                     ap_prc->pcmmode_.nChannels))
+    {
+      TIZ_NOTICE (handleOf (ap_prc), "Unable to measure the loudness");
+      stop_loudness_analysis (ap_prc);
+      return;
+    }
+
+  nframes = a_nbytes / ((ap_prc->pcmmode_.nBitPerSample / 8)
+                        * ap_prc->pcmmode_.nChannels);
+  if (16 == ap_prc->pcmmode_.nBitPerSample)
+    {
+      tiz_dsp_loudness_s16 (ap_prc->p_loudness_, (const int16_t *) ap_src,
+                            nframes);
+    }
+  else
+    {
+      tiz_dsp_loudness_f32 (ap_prc->p_loudness_, (const float *) ap_src,
+                            nframes);
+    }
+}
+
+/* Copies up to a_nbytes from the header straight into the server's
+   memory block, applying the gain stage on the way, and commits them to the
+   stream. Pulseaudio mainloop lock must have been acquired before calling
+   this function. */
+static int
+write_to_stream (pulsear_prc_t * ap_prc, OMX_BUFFERHEADERTYPE * ap_hdr,
+                 const size_t a_nbytes)
+{
+  void * p_data = NULL;
+  size_t nbytes = a_nbytes;
+  int result = 0;
+
+  assert (ap_prc);
+  assert (ap_hdr);
+
+  if ((result = pa_stream_begin_write (ap_prc->p_pa_stream_, &p_data, &nbytes))
+        < 0
+      || !p_data)
+    {
+      return result < 0 ? result : -1;
+    }
+
+  /* The server may hand over a smaller block than requested */
+  nbytes = MIN (nbytes, a_nbytes);
+  analyse_loudness (ap_prc, ap_hdr->pBuffer + ap_hdr->nOffset, nbytes);
+  memcpy (p_data, ap_hdr->pBuffer + ap_hdr->nOffset, nbytes);
+  if (fader_active (ap_prc))
+    {
+      apply_fader (ap_prc, p_data, nbytes);
+    }
+
+  /* No copy takes place here, as the data is already in the block obtained
+     with pa_stream_begin_write */
+  if ((result = pa_stream_write (ap_prc->p_pa_stream_, p_data, nbytes, NULL,
+                                 0, PA_SEEK_RELATIVE))
+      < 0)
+    {
+      (void) pa_stream_cancel_write (ap_prc->p_pa_stream_);
+      return result;
+    }
+
+  ap_hdr->nFilledLen -= nbytes;
+  ap_hdr->nOffset += nbytes;
+  ap_prc->pa_nbytes_ -= nbytes;
+  return nbytes;
+}
+
 static OMX_ERRORTYPE
 render_pcm_data (pulsear_prc_t * ap_prc)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   OMX_BUFFERHEADERTYPE * p_hdr = NULL;
   assert (ap_prc);
+  assert (ap_prc->p_pa_loop_);
+  assert (ap_prc->p_pa_context_);
 
-  while ((p_hdr = get_header (ap_prc)) && ap_prc->pa_nbytes_ > 0)
+  /* Fill as much of the stream's writable space as the available buffers
+     allow, under a single acquisition of the mainloop lock */
+  pa_threaded_mainloop_lock (ap_prc->p_pa_loop_);
+  while (OMX_ErrorNone == rc && (p_hdr = get_header (ap_prc))
+         && ap_prc->pa_nbytes_ > 0)
     {
       if (p_hdr->nFilledLen > 0)
         {
-          const int bytes_to_write
-            = MIN (ap_prc->pa_nbytes_, p_hdr->nFilledLen);
-          assert (ap_prc->p_pa_loop_);
-          assert (ap_prc->p_pa_context_);
-
-          pa_threaded_mainloop_lock (ap_prc->p_pa_loop_);
-          int result = pa_stream_write (
-            ap_prc->p_pa_stream_, p_hdr->pBuffer + p_hdr->nOffset,
-            bytes_to_write, NULL, 0, PA_SEEK_RELATIVE);
-          /* TODO : Check return code */
-          (void) result;
-          pa_threaded_mainloop_unlock (ap_prc->p_pa_loop_);
-          p_hdr->nFilledLen -= bytes_to_write;
-          p_hdr->nOffset += bytes_to_write;
-          ap_prc->pa_nbytes_ -= bytes_to_write;
+          const int result = write_to_stream (
+            ap_prc, p_hdr, MIN (ap_prc->pa_nbytes_, p_hdr->nFilledLen));
+          if (result <= 0)
+            {
+              TIZ_ERROR (handleOf (ap_prc), "Unable to write to stream : %s",
+                         result < 0 ? pa_strerror (-result) : "no space");
+              /* Wait for the next write request */
+              ap_prc->pa_nbytes_ = 0;
+              break;
+            }
         }
 
       if (0 == p_hdr->nFilledLen)
@@ -259,6 +427,7 @@ render_pcm_data (pulsear_prc_t * ap_prc)
           p_hdr = NULL;
         }
     }
+  pa_threaded_mainloop_unlock (ap_prc->p_pa_loop_);
 
   return rc;
 }
@@ -580,6 +749,55 @@ init_pulseaudio_sample_spec (pulsear_prc_t * ap_prc, pa_sample_spec * ap_spec)
   return rc;
 }
 
+static pa_usec_t
+get_buffer_time_usec (const char * ap_key)
+{
+  const char * p_value
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION, ap_key);
+  return p_value ? (pa_usec_t) MAX (0, atoi (p_value)) : 0;
+}
+
+/* Target length and minimum request come from the configuration file, in
+   microseconds; anything else is left to the server */
+static pa_stream_flags_t
+init_pulseaudio_buffer_attr (pulsear_prc_t * ap_prc,
+                             const pa_sample_spec * ap_spec,
+                             pa_buffer_attr * ap_attr)
+{
+  pa_stream_flags_t flags = PA_STREAM_NOFLAGS;
+  const pa_usec_t tlength = get_buffer_time_usec (
+    "OMX.Aratelia.audio_renderer.pulseaudio.pcm.tlength_us");
+  const pa_usec_t minreq = get_buffer_time_usec (
+    "OMX.Aratelia.audio_renderer.pulseaudio.pcm.minreq_us");
+
+  assert (ap_prc);
+  assert (ap_spec);
+  assert (ap_attr);
+
+  ap_attr->maxlength = (uint32_t) -1;
+  ap_attr->tlength = (uint32_t) -1;
+  ap_attr->prebuf = (uint32_t) -1;
+  ap_attr->minreq = (uint32_t) -1;
+  ap_attr->fragsize = (uint32_t) -1;
+
+  if (tlength > 0)
+    {
+      ap_attr->tlength = pa_usec_to_bytes (tlength, ap_spec);
+      /* Make the overall latency, not just the client-side buffer, match
+         the requested target length */
+      flags |= PA_STREAM_ADJUST_LATENCY;
+    }
+  if (minreq > 0)
+    {
+      ap_attr->minreq = pa_usec_to_bytes (minreq, ap_spec);
+    }
+
+  TIZ_NOTICE (handleOf (ap_prc), "tlength [%u] minreq [%u] (bytes)",
+              ap_attr->tlength, ap_attr->minreq);
+
+  return flags;
+}
+
 /* Pulseaudio mainloop lock must have been acquired before calling this
    function */
 static int
@@ -602,6 +820,8 @@ init_pulseaudio_stream (pulsear_prc_t * ap_prc)
 
   {
     pa_sample_spec spec;
+    pa_buffer_attr attr;
+    pa_stream_flags_t flags = PA_STREAM_NOFLAGS;
     switch (pa_context_get_state (ap_prc->p_pa_context_))
       {
         case PA_CONTEXT_UNCONNECTED:
@@ -621,6 +841,7 @@ init_pulseaudio_stream (pulsear_prc_t * ap_prc)
     goto_end_on_pa_error (await_pulseaudio_context_connection (ap_prc));
 
     goto_end_on_pa_error (init_pulseaudio_sample_spec (ap_prc, &spec));
+    flags = init_pulseaudio_buffer_attr (ap_prc, &spec, &attr);
 
     ap_prc->p_pa_stream_ = pa_stream_new (
       ap_prc->p_pa_context_, ARATELIA_PCM_RENDERER_PULSEAUDIO_STREAM_NAME,
@@ -639,8 +860,8 @@ init_pulseaudio_stream (pulsear_prc_t * ap_prc)
       ARATELIA_PCM_RENDERER_PULSEAUDIO_SINK_NAME, /* Name of the sink to
                                                        connect to, or NULL for
                                                        default */
-      NULL,   /* Buffering attributes, or NULL for default */
-      0,      /* Additional flags, or 0 for default */
+      &attr,  /* Buffering attributes */
+      flags,  /* Additional flags, or 0 for default */
       NULL,   /* Initial volume, or NULL for default */
       NULL)); /* Synchronize this stream with the specified one, or NULL for
                    a standalone stream  */
@@ -878,81 +1099,47 @@ set_volume (pulsear_prc_t * ap_prc, const long a_volume)
     }
 }
 
+static inline size_t
+ms_to_frames (const pulsear_prc_t * ap_prc, const unsigned int a_ms)
+{
+  assert (ap_prc);
+  return (size_t) ap_prc->pcmmode_.nSamplingRate * a_ms / 1000;
+}
+
 static void
-prepare_volume_ramp (pulsear_prc_t * ap_prc)
+fade_in (pulsear_prc_t * ap_prc)
 {
   assert (ap_prc);
-  pa_volume_t vol = ARATELIA_PCM_RENDERER_DEFAULT_VOLUME_VALUE;
   (void) pa_cvolume_init (&(ap_prc->pa_vol_));
   ap_prc->pa_vol_.channels = ap_prc->pcmmode_.nChannels;
-  (void) pa_cvolume_set (&(ap_prc->pa_vol_), ap_prc->pa_vol_.channels, vol);
+  (void) pa_cvolume_set (&(ap_prc->pa_vol_), ap_prc->pa_vol_.channels,
+                         ARATELIA_PCM_RENDERER_DEFAULT_VOLUME_VALUE);
 
   TIZ_DEBUG (handleOf (ap_prc), "pa_vol_.channels[%d]",
              ap_prc->pa_vol_.channels);
 
-  if (ap_prc->ramp_enabled_)
-    {
-      ap_prc->ramp_volume_ = ARATELIA_PCM_RENDERER_DEFAULT_VOLUME_VALUE;
-      set_volume (ap_prc, ap_prc->ramp_volume_);
-      ap_prc->ramp_volume_ = ARATELIA_PCM_RENDERER_DEFAULT_VOLUME_VALUE;
-      ap_prc->ramp_step_count_ = ARATELIA_PCM_RENDERER_DEFAULT_RAMP_STEP_COUNT;
-      ap_prc->ramp_step_
-        = (double) ap_prc->ramp_volume_ / (double) ap_prc->ramp_step_count_;
-      TIZ_TRACE (handleOf (ap_prc), "ramp_step_ = [%d] ramp_step_count_ = [%d]",
-                 ap_prc->ramp_step_, ap_prc->ramp_step_count_);
-    }
-}
-
-static OMX_ERRORTYPE
-start_volume_ramp (pulsear_prc_t * ap_prc)
-{
-  assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
-    {
-      if (ap_prc->p_ev_timer_)
-        {
-          ap_prc->ramp_volume_ = 0;
-          TIZ_TRACE (handleOf (ap_prc), "ramp_volume_ = [%d]",
-                     ap_prc->ramp_volume_);
-          tiz_check_omx (tiz_srv_timer_watcher_start (
-            ap_prc, ap_prc->p_ev_timer_, 0.2, 0.2));
-        }
-    }
-  return OMX_ErrorNone;
-}
-
-static void
-stop_volume_ramp (pulsear_prc_t * ap_prc)
-{
-  assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
-    {
-      if (ap_prc->p_ev_timer_)
-        {
-          (void) tiz_srv_timer_watcher_stop (ap_prc, ap_prc->p_ev_timer_);
-        }
-    }
+  /* A short, sample-accurate fade from silence avoids the click of a stream
+     that starts mid-waveform */
+  tiz_dsp_fader_init (&(ap_prc->fader_), 0.0f);
+  tiz_dsp_fader_ramp (
+    &(ap_prc->fader_), ap_prc->loudness_factor_,
+    ms_to_frames (ap_prc, ARATELIA_PCM_RENDERER_FADE_TIME_MS));
 }
 
-static OMX_ERRORTYPE
-apply_ramp_step (pulsear_prc_t * ap_prc)
+/* Converts a normalisation gain into a linear factor, reduced where needed
+   so that the stream's peak doesn't clip. Both values are in millibels. The
+   server-side volume stays untouched; the factor is the target of the
+   software gain stage. */
+static float
+loudness_factor (const OMX_S32 a_gain_mb, const OMX_S32 a_peak_mb)
 {
-  assert (ap_prc);
-  if (ap_prc->ramp_enabled_)
+  const float peak = tiz_dsp_db_to_gain ((float) a_peak_mb / 100.0f);
+  float factor = tiz_dsp_db_to_gain ((float) a_gain_mb / 100.0f);
+  if (peak > 0.0f && peak * factor > 1.0f)
     {
-      if (ap_prc->ramp_step_count_-- > 0)
-        {
-          ap_prc->ramp_volume_ += ap_prc->ramp_step_;
-          TIZ_TRACE (handleOf (ap_prc), "ramp_volume_ = [%d]",
-                     ap_prc->ramp_volume_);
-          set_volume (ap_prc, ap_prc->ramp_volume_);
-        }
-      else
-        {
-          stop_volume_ramp (ap_prc);
-        }
+      factor = 1.0f / peak;
     }
-  return OMX_ErrorNone;
+  return factor;
 }
 
 /*
@@ -973,14 +1160,13 @@ pulsear_prc_ctor (void * ap_prc, va_list * app)
   p_prc->p_pa_stream_ = NULL;
   p_prc->pa_stream_state_ = PA_STREAM_UNCONNECTED;
   p_prc->pa_nbytes_ = 0;
-  p_prc->p_ev_timer_ = NULL;
   p_prc->gain_ = ARATELIA_PCM_RENDERER_DEFAULT_GAIN_VALUE;
   p_prc->volume_ = ARATELIA_PCM_RENDERER_DEFAULT_VOLUME_VALUE;
   p_prc->pending_volume_ = 0;
-  p_prc->ramp_enabled_ = false;
-  p_prc->ramp_step_ = 0;
-  p_prc->ramp_step_count_ = ARATELIA_PCM_RENDERER_DEFAULT_RAMP_STEP_COUNT;
-  p_prc->ramp_volume_ = 0;
+  tiz_dsp_fader_init (&(p_prc->fader_), 1.0f);
+  p_prc->loudness_factor_ = 1.0f;
+  p_prc->analyse_ = false;
+  p_prc->p_loudness_ = NULL;
   return p_prc;
 }
 
@@ -1001,12 +1187,11 @@ pulsear_prc_allocate_resources (void * ap_prc, OMX_U32 a_pid)
   pulsear_prc_t * p_prc = ap_prc;
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   assert (p_prc);
-  /* If the timer event has already been initialised, we assume the whole
+  /* If the mainloop has already been created, we assume the whole
      component has already been initialised. */
-  if (!(p_prc->p_ev_timer_))
+  if (!(p_prc->p_pa_loop_))
     {
       set_volume (ap_prc, p_prc->volume_);
-      tiz_check_omx (tiz_srv_timer_watcher_init (p_prc, &(p_prc->p_ev_timer_)));
       rc = init_pulseaudio (ap_prc);
     }
   return rc;
@@ -1019,13 +1204,8 @@ pulsear_prc_deallocate_resources (void * ap_prc)
   assert (p_prc);
   TIZ_TRACE (handleOf (p_prc), "port disabled ? [%s]",
              p_prc->port_disabled_ ? "YES" : "NO");
-  if (p_prc->p_ev_timer_)
-    {
-      (void) tiz_srv_timer_watcher_stop (p_prc, p_prc->p_ev_timer_);
-      tiz_srv_timer_watcher_destroy (p_prc, p_prc->p_ev_timer_);
-      p_prc->p_ev_timer_ = NULL;
-    }
   deinit_pulseaudio (ap_prc);
+  stop_loudness_analysis (p_prc);
   return OMX_ErrorNone;
 }
 
@@ -1034,9 +1214,6 @@ pulsear_prc_prepare_to_transfer (void * ap_prc, OMX_U32 a_pid)
 {
   pulsear_prc_t * p_prc = ap_prc;
   assert (p_prc);
-  p_prc->ramp_step_ = 0;
-  p_prc->ramp_step_count_ = ARATELIA_PCM_RENDERER_DEFAULT_RAMP_STEP_COUNT;
-  p_prc->ramp_volume_ = 0;
   return OMX_ErrorNone;
 }
 
@@ -1046,9 +1223,7 @@ pulsear_prc_transfer_and_process (void * ap_prc, OMX_U32 a_pid)
   pulsear_prc_t * p_prc = ap_prc;
   assert (ap_prc);
   p_prc->stopped_ = false;
-  prepare_volume_ramp (p_prc);
-  tiz_check_omx (start_volume_ramp (p_prc));
-  tiz_check_omx (apply_ramp_step (p_prc));
+  fade_in (p_prc);
   return OMX_ErrorNone;
 }
 
@@ -1058,7 +1233,6 @@ pulsear_prc_stop_and_return (void * ap_prc)
   pulsear_prc_t * p_prc = ap_prc;
   assert (ap_prc);
   p_prc->stopped_ = true;
-  stop_volume_ramp (ap_prc);
   return do_flush (ap_prc);
 }
 
@@ -1079,22 +1253,6 @@ pulsear_prc_buffers_ready (const void * ap_prc)
   return rc;
 }
 
-static OMX_ERRORTYPE
-pulsear_prc_timer_ready (void * ap_prc, tiz_event_timer_t * ap_ev_timer,
-                         void * ap_arg, const uint32_t a_id)
-{
-  pulsear_prc_t * p_prc = (pulsear_prc_t *) ap_prc;
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  assert (p_prc);
-  TIZ_TRACE (handleOf (ap_prc), "Received timer event");
-  tiz_check_omx (apply_ramp_step (ap_prc));
-  if (ready_to_process (p_prc))
-    {
-      rc = render_pcm_data (p_prc);
-    }
-  return rc;
-}
-
 static OMX_ERRORTYPE
 pulsear_prc_pause (const void * ap_prc)
 {
@@ -1102,7 +1260,6 @@ pulsear_prc_pause (const void * ap_prc)
   assert (p_prc);
 
   p_prc->paused_ = true;
-  stop_volume_ramp (p_prc);
 
   if (p_prc->p_pa_loop_ && p_prc->p_pa_context_ && p_prc->p_pa_stream_)
     {
@@ -1157,6 +1314,9 @@ pulsear_prc_resume (const void * ap_prc)
 static OMX_ERRORTYPE
 pulsear_prc_port_flush (const void * ap_obj, OMX_U32 TIZ_UNUSED (a_pid))
 {
+  /* A flush means a seek or a stream change; a partial measurement would be
+     meaningless */
+  stop_loudness_analysis ((pulsear_prc_t *) ap_obj);
   return do_flush ((pulsear_prc_t *) ap_obj);
 }
 
@@ -1170,7 +1330,6 @@ pulsear_prc_port_disable (const void * ap_prc, OMX_U32 TIZ_UNUSED (a_pid))
   if (!p_prc->port_disabled_)
     {
       p_prc->port_disabled_ = true;
-      stop_volume_ramp (p_prc);
       if (p_prc->p_pa_loop_ && p_prc->p_pa_stream_
           && PA_STREAM_READY == p_prc->pa_stream_state_)
         {
@@ -1253,7 +1412,79 @@ pulsear_prc_config_change (void * ap_obj, OMX_U32 a_pid,
                      (mute.bMute == OMX_FALSE ? "FALSE" : "TRUE"));
           toggle_mute (p_prc, mute.bMute == OMX_TRUE ? true : false);
         }
+      else if (OMX_TizoniaIndexConfigAudioLoudness == a_config_idx)
+        {
+          OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE loudness;
+          TIZ_INIT_OMX_PORT_STRUCT (loudness, ARATELIA_PCM_RENDERER_PORT_INDEX);
+          tiz_check_omx (tiz_api_GetConfig (
+            tiz_get_krn (handleOf (p_prc)), handleOf (p_prc),
+            OMX_TizoniaIndexConfigAudioLoudness, &loudness));
+          p_prc->loudness_factor_
+            = loudness_factor (loudness.nGain, loudness.nPeak);
+          TIZ_TRACE (handleOf (p_prc),
+                     "[OMX_TizoniaIndexConfigAudioLoudness] : nGain = [%d] "
+                     "nPeak = [%d] bAnalyse = [%s] factor = [%f]",
+                     (int) loudness.nGain, (int) loudness.nPeak,
+                     (loudness.bAnalyse == OMX_FALSE ? "FALSE" : "TRUE"),
+                     p_prc->loudness_factor_);
+          tiz_dsp_fader_ramp (
+            &(p_prc->fader_), p_prc->loudness_factor_,
+            ms_to_frames (p_prc, ARATELIA_PCM_RENDERER_FADE_TIME_MS));
+          stop_loudness_analysis (p_prc);
+          p_prc->analyse_ = (loudness.bAnalyse == OMX_TRUE);
+        }
+    }
+  return rc;
+}
+
+/*
+ * from tiz_api
+ */
+
+static OMX_ERRORTYPE
+pulsear_prc_GetConfig (const void * ap_obj, OMX_HANDLETYPE ap_hdl,
+                       OMX_INDEXTYPE a_index, OMX_PTR ap_struct)
+{
+  const pulsear_prc_t * p_prc = ap_obj;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (p_prc);
+  assert (ap_struct);
+
+  if (OMX_TizoniaIndexConfigAudioLoudness == a_index)
+    {
+      /* Report the measurements taken so far; the kernel has already filled
+         in the settings */
+      OMX_TIZONIA_AUDIO_CONFIG_LOUDNESSTYPE * p_loudness = ap_struct;
+      p_loudness->nLoudness = 0;
+      p_loudness->nTruePeak = 0;
+      p_loudness->nMeasured = 0;
+      if (p_prc->p_loudness_ && p_prc->pcmmode_.nSamplingRate > 0)
+        {
+          const float lufs = tiz_dsp_loudness_integrated (p_prc->p_loudness_);
+          const float peak = tiz_dsp_loudness_true_peak (p_prc->p_loudness_);
+          if (lufs > -HUGE_VALF && peak > 0.0f)
+            {
+              p_loudness->nLoudness = (OMX_S32) lroundf (lufs * 100.0f);
+              p_loudness->nTruePeak
+                = (OMX_S32) lroundf (2000.0f * log10f (peak));
+              p_loudness->nMeasured
+                = (OMX_U32) (tiz_dsp_loudness_frames (p_prc->p_loudness_)
+                             * 1000 / p_prc->pcmmode_.nSamplingRate);
+            }
+        }
+      TIZ_TRACE (ap_hdl,
+                 "[OMX_TizoniaIndexConfigAudioLoudness] : %d LUFS/100 "
+                 "(%u ms)",
+                 (int) p_loudness->nLoudness,
+                 (unsigned int) p_loudness->nMeasured);
+    }
+  else
+    {
+      rc = super_GetConfig (typeOf (ap_obj, "pulsearprc"), ap_obj, ap_hdl,
+                            a_index, ap_struct);
     }
+
   return rc;
 }
 
@@ -1315,8 +1546,6 @@ pulsear_prc_init (void * ap_tos, void * ap_hdl)
      /* TIZ_CLASS_COMMENT: */
      tiz_srv_stop_and_return, pulsear_prc_stop_and_return,
      /* TIZ_CLASS_COMMENT: */
-     tiz_srv_timer_ready, pulsear_prc_timer_ready,
-     /* TIZ_CLASS_COMMENT: */
      tiz_prc_buffers_ready, pulsear_prc_buffers_ready,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_pause, pulsear_prc_pause,
@@ -1330,6 +1559,8 @@ pulsear_prc_init (void * ap_tos, void * ap_hdl)
      tiz_prc_port_enable, pulsear_prc_port_enable,
      /* TIZ_CLASS_COMMENT: */
      tiz_prc_config_change, pulsear_prc_config_change,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_api_GetConfig, pulsear_prc_GetConfig,
      /* TIZ_CLASS_COMMENT: stop value */
      0);
 
@@ -45,6 +45,7 @@ extern "C" {
 
 #include <OMX_Core.h>
 
+#include <tizplatform.h>
 #include <tizprc_decls.h>
 
 typedef struct pulsear_prc pulsear_prc_t;
@@ -63,14 +64,13 @@ struct pulsear_prc
   struct pa_cvolume pa_vol_;
   pa_stream_state_t pa_stream_state_;
   size_t pa_nbytes_;
-  tiz_event_timer_t *p_ev_timer_;
   float gain_;
   long volume_;
   long pending_volume_;
-  bool ramp_enabled_;
-  long ramp_step_;
-  long ramp_step_count_;
-  long ramp_volume_;
+  tiz_dsp_fader_t fader_;
+  float loudness_factor_; /* linear, loudness normalisation */
+  bool analyse_;           /* measure the loudness of the current stream */
+  tiz_dsp_loudness_t * p_loudness_;
 };
 
 typedef struct pulsear_prc_class pulsear_prc_class_t;
@@ -0,0 +1,649 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   resamplerprc.c
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Sample rate converter - processor class implementation
+ *
+ * Input samples are converted to float in blocks, remixed if the output
+ * port's channel count differs, run through a polyphase windowed-sinc filter
+ * (see tiz_dsp_resampler_process) and converted to the output port's sample
+ * size, with dither when reducing to 16 or 24 bits. Streams that already
+ * match the output port's rate, channel count and sample size are copied
+ * as they are.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <string.h>
+#include <strings.h>
+
+#include <tizplatform.h>
+
+#include <tizkernel.h>
+
+#include "resampler.h"
+#include "resamplerprc.h"
+#include "resamplerprc_decls.h"
+
+#ifdef TIZ_LOG_CATEGORY_NAME
+#undef TIZ_LOG_CATEGORY_NAME
+#define TIZ_LOG_CATEGORY_NAME "tiz.resampler.prc"
+#endif
+
+/* Forward declarations */
+static OMX_ERRORTYPE
+resampler_prc_deallocate_resources (void *);
+
+static tiz_dsp_resampler_quality_t
+get_quality (void)
+{
+  const char * p_quality
+    = tiz_rcfile_get_value (TIZ_RCFILE_PLUGINS_DATA_SECTION,
+                            "OMX.Aratelia.audio_processor.resampler.quality");
+  if (p_quality && 0 == strcasecmp (p_quality, "low"))
+    {
+      return TIZ_DSP_RESAMPLER_QUALITY_LOW;
+    }
+  else if (p_quality && 0 == strcasecmp (p_quality, "high"))
+    {
+      return TIZ_DSP_RESAMPLER_QUALITY_HIGH;
+    }
+  return TIZ_DSP_RESAMPLER_QUALITY_MEDIUM;
+}
+
+static inline size_t
+frame_size (const OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode)
+{
+  assert (ap_pcmmode);
+  return (ap_pcmmode->nBitPerSample / 8) * ap_pcmmode->nChannels;
+}
+
+static bool
+is_supported_format (const OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode)
+{
+  assert (ap_pcmmode);
+  return (OMX_NumericalDataSigned == ap_pcmmode->eNumData
+          && OMX_EndianLittle == ap_pcmmode->eEndian
+          && OMX_TRUE == ap_pcmmode->bInterleaved
+          && (16 == ap_pcmmode->nBitPerSample
+              || 24 == ap_pcmmode->nBitPerSample
+              || 32 == ap_pcmmode->nBitPerSample)
+          && ap_pcmmode->nChannels > 0
+          && ap_pcmmode->nChannels <= ARATELIA_RESAMPLER_MAX_CHANNELS
+          && ap_pcmmode->nSamplingRate > 0);
+}
+
+/* Number of input frames of silence needed to flush the filter's history */
+static size_t
+drain_length (const resampler_prc_t * ap_prc)
+{
+  size_t delay = 0;
+  assert (ap_prc);
+  delay = tiz_dsp_resampler_delay (ap_prc->p_rs_);
+  return delay > 0 ? (delay * ap_prc->in_pcmmode_.nSamplingRate)
+                         / ap_prc->out_pcmmode_.nSamplingRate
+                       + 1
+                   : 0;
+}
+
+static inline OMX_BUFFERHEADERTYPE *
+get_in_hdr (resampler_prc_t * ap_prc)
+{
+  return tiz_filter_prc_get_header (ap_prc,
+                                    ARATELIA_RESAMPLER_INPUT_PORT_INDEX);
+}
+
+static inline OMX_BUFFERHEADERTYPE *
+get_out_hdr (resampler_prc_t * ap_prc)
+{
+  return tiz_filter_prc_get_header (ap_prc,
+                                    ARATELIA_RESAMPLER_OUTPUT_PORT_INDEX);
+}
+
+static OMX_ERRORTYPE
+release_in_hdr (resampler_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_in = get_in_hdr (ap_prc);
+  assert (ap_prc);
+  if (p_in)
+    {
+      if ((p_in->nFlags & OMX_BUFFERFLAG_EOS) > 0)
+        {
+          TIZ_TRACE (handleOf (ap_prc), "EOS flag received");
+          /* Remember the EOS flag, and push the filter's tail out before
+             propagating it */
+          tiz_filter_prc_update_eos_flag (ap_prc, true);
+          tiz_util_reset_eos_flag (p_in);
+          ap_prc->drain_frames_ = drain_length (ap_prc);
+          ap_prc->draining_ = ap_prc->drain_frames_ > 0;
+        }
+      TIZ_TRACE (handleOf (ap_prc), "Releasing IN HEADER [%p]", p_in);
+      tiz_filter_prc_release_header (ap_prc,
+                                     ARATELIA_RESAMPLER_INPUT_PORT_INDEX);
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+release_out_hdr (resampler_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_out = get_out_hdr (ap_prc);
+  assert (ap_prc);
+  if (p_out)
+    {
+      if (tiz_filter_prc_is_eos (ap_prc) && !ap_prc->draining_)
+        {
+          TIZ_TRACE (handleOf (ap_prc), "Propagating EOS flag");
+          tiz_util_set_eos_flag (p_out);
+          /* Get ready for the next stream */
+          tiz_filter_prc_update_eos_flag (ap_prc, false);
+          tiz_dsp_resampler_reset (ap_prc->p_rs_);
+        }
+      TIZ_TRACE (handleOf (ap_prc),
+                 "Releasing OUT HEADER [%p] nFilledLen [%d] nAllocLen [%d]",
+                 p_out, p_out->nFilledLen, p_out->nAllocLen);
+      tiz_filter_prc_release_header (ap_prc,
+                                     ARATELIA_RESAMPLER_OUTPUT_PORT_INDEX);
+    }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+retrieve_pcm_mode (resampler_prc_t * ap_prc, const OMX_U32 a_pid,
+                   OMX_AUDIO_PARAM_PCMMODETYPE * ap_pcmmode)
+{
+  assert (ap_prc);
+  assert (ap_pcmmode);
+  TIZ_INIT_OMX_PORT_STRUCT (*ap_pcmmode, a_pid);
+  tiz_check_omx (tiz_api_GetParameter (tiz_get_krn (handleOf (ap_prc)),
+                                       handleOf (ap_prc),
+                                       OMX_IndexParamAudioPcm, ap_pcmmode));
+  if (!is_supported_format (ap_pcmmode))
+    {
+      TIZ_ERROR (handleOf (ap_prc),
+                 "[OMX_ErrorUnsupportedSetting] : PORT [%u] : "
+                 "unsupported pcm format (%u bits, %u channels, %u Hz)",
+                 a_pid, ap_pcmmode->nBitPerSample, ap_pcmmode->nChannels,
+                 ap_pcmmode->nSamplingRate);
+      return OMX_ErrorUnsupportedSetting;
+    }
+  return OMX_ErrorNone;
+}
+
+static void
+destroy_resampler (resampler_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  tiz_dsp_resampler_destroy (ap_prc->p_rs_);
+  ap_prc->p_rs_ = NULL;
+  tiz_mem_free (ap_prc->p_in_f32_);
+  ap_prc->p_in_f32_ = NULL;
+  tiz_mem_free (ap_prc->p_out_f32_);
+  ap_prc->p_out_f32_ = NULL;
+  tiz_mem_free (ap_prc->p_remix_f32_);
+  ap_prc->p_remix_f32_ = NULL;
+}
+
+static OMX_ERRORTYPE
+create_resampler (resampler_prc_t * ap_prc)
+{
+  const size_t block_size = ARATELIA_RESAMPLER_BLOCK_FRAMES
+                            * ARATELIA_RESAMPLER_MAX_CHANNELS * sizeof (float);
+  OMX_AUDIO_PARAM_PCMMODETYPE * p_in = NULL;
+  OMX_AUDIO_PARAM_PCMMODETYPE * p_out = NULL;
+
+  assert (ap_prc);
+
+  destroy_resampler (ap_prc);
+
+  p_in = &(ap_prc->in_pcmmode_);
+  p_out = &(ap_prc->out_pcmmode_);
+  tiz_check_omx (
+    retrieve_pcm_mode (ap_prc, ARATELIA_RESAMPLER_INPUT_PORT_INDEX, p_in));
+  tiz_check_omx (
+    retrieve_pcm_mode (ap_prc, ARATELIA_RESAMPLER_OUTPUT_PORT_INDEX, p_out));
+
+  /* The player keeps the converter in the graph for streams that the device
+     plays as they are; those go through untouched */
+  ap_prc->passthrough_ = (p_in->nSamplingRate == p_out->nSamplingRate
+                          && p_in->nChannels == p_out->nChannels
+                          && p_in->nBitPerSample == p_out->nBitPerSample);
+
+  TIZ_NOTICE (handleOf (ap_prc),
+              "%u Hz %u ch %u bits -> %u Hz %u ch %u bits (quality %d)%s",
+              p_in->nSamplingRate, p_in->nChannels, p_in->nBitPerSample,
+              p_out->nSamplingRate, p_out->nChannels, p_out->nBitPerSample,
+              ap_prc->quality_, ap_prc->passthrough_ ? " (passthrough)" : "");
+
+  /* Channels are remixed before the conversion, so the filter runs on the
+     output's channel count */
+  tiz_check_omx (tiz_dsp_resampler_init (
+    &(ap_prc->p_rs_), p_in->nSamplingRate, p_out->nSamplingRate,
+    p_out->nChannels, ap_prc->quality_));
+
+  ap_prc->p_in_f32_ = tiz_mem_alloc (block_size);
+  ap_prc->p_out_f32_ = tiz_mem_alloc (block_size);
+  ap_prc->p_remix_f32_ = tiz_mem_alloc (block_size);
+  if (!ap_prc->p_in_f32_ || !ap_prc->p_out_f32_ || !ap_prc->p_remix_f32_)
+    {
+      destroy_resampler (ap_prc);
+      return OMX_ErrorInsufficientResources;
+    }
+  return OMX_ErrorNone;
+}
+
+/* Converts (and remixes) a_nframes input frames into the filter's input
+   block */
+static void
+read_input_frames (resampler_prc_t * ap_prc, const OMX_U8 * ap_src,
+                   const size_t a_nframes)
+{
+  const OMX_AUDIO_PARAM_PCMMODETYPE * p_in = &(ap_prc->in_pcmmode_);
+  const size_t in_channels = p_in->nChannels;
+  const size_t out_channels = ap_prc->out_pcmmode_.nChannels;
+  const size_t nsamples = a_nframes * in_channels;
+  float * p_dst = in_channels == out_channels ? ap_prc->p_in_f32_
+                                              : ap_prc->p_remix_f32_;
+
+  switch (p_in->nBitPerSample)
+    {
+      case 16:
+        tiz_dsp_s16_to_f32 (p_dst, (const int16_t *) ap_src, nsamples);
+        break;
+      case 24:
+        tiz_dsp_s24_to_f32 (p_dst, ap_src, nsamples);
+        break;
+      default:
+        tiz_dsp_s32_to_f32 (p_dst, (const int32_t *) ap_src, nsamples);
+        break;
+    };
+
+  if (in_channels != out_channels)
+    {
+      tiz_dsp_remix_f32 (ap_prc->p_in_f32_, out_channels, p_dst, in_channels,
+                         a_nframes);
+    }
+}
+
+static void
+write_output_frames (resampler_prc_t * ap_prc, OMX_U8 * ap_dst,
+                     const size_t a_nframes)
+{
+  const OMX_AUDIO_PARAM_PCMMODETYPE * p_out = &(ap_prc->out_pcmmode_);
+  const size_t nsamples = a_nframes * p_out->nChannels;
+
+  switch (p_out->nBitPerSample)
+    {
+      case 16:
+        tiz_dsp_f32_to_s16 ((int16_t *) ap_dst, ap_prc->p_out_f32_, nsamples,
+                            &(ap_prc->dither_));
+        break;
+      case 24:
+        tiz_dsp_f32_to_s24 (ap_dst, ap_prc->p_out_f32_, nsamples,
+                            &(ap_prc->dither_));
+        break;
+      default:
+        tiz_dsp_f32_to_s32 ((int32_t *) ap_dst, ap_prc->p_out_f32_, nsamples);
+        break;
+    };
+}
+
+/* Copies whole frames, without the float round trip or the dither */
+static OMX_ERRORTYPE
+copy_buffer (resampler_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_in = get_in_hdr (ap_prc);
+  OMX_BUFFERHEADERTYPE * p_out = get_out_hdr (ap_prc);
+  const size_t out_frame_size = frame_size (&(ap_prc->out_pcmmode_));
+  size_t len = 0;
+
+  assert (ap_prc);
+
+  if (!p_in || !p_out)
+    {
+      return OMX_ErrorNotReady;
+    }
+
+  len = MIN (p_in->nFilledLen,
+             ((p_out->nAllocLen - p_out->nOffset - p_out->nFilledLen)
+              / out_frame_size)
+               * out_frame_size);
+  if (len > 0)
+    {
+      memcpy (p_out->pBuffer + p_out->nOffset + p_out->nFilledLen,
+              p_in->pBuffer + p_in->nOffset, len);
+      p_out->nFilledLen += len;
+      p_in->nOffset += len;
+      p_in->nFilledLen -= len;
+    }
+
+  if (p_in->nFilledLen < out_frame_size)
+    {
+      p_in->nFilledLen = 0;
+      (void) release_in_hdr (ap_prc);
+      /* There is no filter history to push out */
+      ap_prc->draining_ = false;
+    }
+
+  if (p_out->nAllocLen - p_out->nOffset - p_out->nFilledLen < out_frame_size
+      || tiz_filter_prc_is_eos (ap_prc))
+    {
+      (void) release_out_hdr (ap_prc);
+    }
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+transform_buffer (resampler_prc_t * ap_prc)
+{
+  OMX_BUFFERHEADERTYPE * p_in = get_in_hdr (ap_prc);
+  OMX_BUFFERHEADERTYPE * p_out = get_out_hdr (ap_prc);
+  const size_t in_frame_size = frame_size (&(ap_prc->in_pcmmode_));
+  const size_t out_frame_size = frame_size (&(ap_prc->out_pcmmode_));
+  size_t avail = 0;
+  size_t room = 0;
+  size_t consumed = 0;
+  size_t produced = 0;
+  bool released = false;
+
+  assert (ap_prc);
+  assert (ap_prc->p_rs_);
+
+  if (ap_prc->passthrough_)
+    {
+      return copy_buffer (ap_prc);
+    }
+
+  if (!p_out)
+    {
+      return OMX_ErrorNotReady;
+    }
+
+  if (ap_prc->draining_)
+    {
+      /* The stream has ended: feed silence until the filter's tail is out */
+      avail = MIN (ap_prc->drain_frames_, ARATELIA_RESAMPLER_BLOCK_FRAMES);
+      memset (ap_prc->p_in_f32_, 0,
+              avail * ap_prc->out_pcmmode_.nChannels * sizeof (float));
+    }
+  else if (p_in)
+    {
+      avail = MIN (p_in->nFilledLen / in_frame_size,
+                   ARATELIA_RESAMPLER_BLOCK_FRAMES);
+      read_input_frames (ap_prc, p_in->pBuffer + p_in->nOffset, avail);
+    }
+
+  room = (p_out->nAllocLen - p_out->nOffset - p_out->nFilledLen)
+         / out_frame_size;
+  consumed = avail;
+  produced = tiz_dsp_resampler_process (
+    ap_prc->p_rs_, avail > 0 ? ap_prc->p_in_f32_ : NULL, &consumed,
+    ap_prc->p_out_f32_, MIN (room, ARATELIA_RESAMPLER_BLOCK_FRAMES));
+
+  if (produced > 0)
+    {
+      write_output_frames (
+        ap_prc, p_out->pBuffer + p_out->nOffset + p_out->nFilledLen, produced);
+      p_out->nFilledLen += produced * out_frame_size;
+      room -= produced;
+    }
+
+  if (ap_prc->draining_)
+    {
+      ap_prc->drain_frames_ -= consumed;
+      ap_prc->draining_ = ap_prc->drain_frames_ > 0;
+    }
+  else if (p_in)
+    {
+      p_in->nOffset += consumed * in_frame_size;
+      p_in->nFilledLen -= consumed * in_frame_size;
+      if (p_in->nFilledLen < in_frame_size)
+        {
+          p_in->nFilledLen = 0;
+          (void) release_in_hdr (ap_prc);
+          /* Returning the header is progress too: an empty buffer that
+           * only carries EOS is what starts the drain */
+          released = true;
+        }
+    }
+
+  if (room == 0 || (tiz_filter_prc_is_eos (ap_prc) && !ap_prc->draining_))
+    {
+      (void) release_out_hdr (ap_prc);
+      released = true;
+    }
+
+  return (consumed > 0 || produced > 0 || released) ? OMX_ErrorNone
+                                                     : OMX_ErrorNotReady;
+}
+
+static void
+reset_stream_parameters (resampler_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  ap_prc->draining_ = false;
+  ap_prc->drain_frames_ = 0;
+  tiz_filter_prc_update_eos_flag (ap_prc, false);
+  if (ap_prc->p_rs_)
+    {
+      tiz_dsp_resampler_reset (ap_prc->p_rs_);
+    }
+}
+
+/*
+ * resamplerprc
+ */
+
+static void *
+resampler_prc_ctor (void * ap_obj, va_list * app)
+{
+  resampler_prc_t * p_prc
+    = super_ctor (typeOf (ap_obj, "resamplerprc"), ap_obj, app);
+  assert (p_prc);
+  p_prc->p_rs_ = NULL;
+  p_prc->quality_ = get_quality ();
+  p_prc->p_in_f32_ = NULL;
+  p_prc->p_out_f32_ = NULL;
+  p_prc->p_remix_f32_ = NULL;
+  p_prc->dither_ = 1;
+  p_prc->passthrough_ = false;
+  reset_stream_parameters (p_prc);
+  return p_prc;
+}
+
+static void *
+resampler_prc_dtor (void * ap_obj)
+{
+  (void) resampler_prc_deallocate_resources (ap_obj);
+  return super_dtor (typeOf (ap_obj, "resamplerprc"), ap_obj);
+}
+
+/*
+ * from tizsrv class
+ */
+
+static OMX_ERRORTYPE
+resampler_prc_allocate_resources (void * ap_obj, OMX_U32 a_pid)
+{
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+resampler_prc_deallocate_resources (void * ap_obj)
+{
+  destroy_resampler (ap_obj);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+resampler_prc_prepare_to_transfer (void * ap_obj, OMX_U32 a_pid)
+{
+  /* The ports' pcm settings are final at this point */
+  tiz_check_omx (create_resampler (ap_obj));
+  reset_stream_parameters (ap_obj);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+resampler_prc_transfer_and_process (void * ap_obj, OMX_U32 a_pid)
+{
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+resampler_prc_stop_and_return (void * ap_obj)
+{
+  return tiz_filter_prc_release_all_headers (ap_obj);
+}
+
+/*
+ * from tizprc class
+ */
+
+static OMX_ERRORTYPE
+resampler_prc_buffers_ready (const void * ap_prc)
+{
+  resampler_prc_t * p_prc = (resampler_prc_t *) ap_prc;
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+
+  assert (ap_prc);
+
+  if (!p_prc->p_rs_)
+    {
+      return OMX_ErrorNone;
+    }
+
+  while (OMX_ErrorNone == rc)
+    {
+      rc = transform_buffer (p_prc);
+    }
+  if (OMX_ErrorNotReady == rc)
+    {
+      rc = OMX_ErrorNone;
+    }
+
+  return rc;
+}
+
+static OMX_ERRORTYPE
+resampler_prc_port_flush (const void * ap_prc, OMX_U32 a_pid)
+{
+  resampler_prc_t * p_prc = (resampler_prc_t *) ap_prc;
+  if (OMX_ALL == a_pid || ARATELIA_RESAMPLER_INPUT_PORT_INDEX == a_pid)
+    {
+      /* A flush means a discontinuity (e.g. a seek), so drop the history */
+      reset_stream_parameters (p_prc);
+    }
+  return tiz_filter_prc_release_header (p_prc, a_pid);
+}
+
+static OMX_ERRORTYPE
+resampler_prc_port_enable (const void * ap_prc, OMX_U32 a_pid)
+{
+  resampler_prc_t * p_prc = (resampler_prc_t *) ap_prc;
+  /* The port's settings may have been changed while disabled */
+  return resampler_prc_prepare_to_transfer (p_prc, OMX_ALL);
+}
+
+static OMX_ERRORTYPE
+resampler_prc_port_disable (const void * ap_prc, OMX_U32 a_pid)
+{
+  resampler_prc_t * p_prc = (resampler_prc_t *) ap_prc;
+  (void) resampler_prc_deallocate_resources (p_prc);
+  return tiz_filter_prc_release_header (p_prc, a_pid);
+}
+
+/*
+ * resampler_prc_class
+ */
+
+static void *
+resampler_prc_class_ctor (void * ap_obj, va_list * app)
+{
+  /* NOTE: Class methods might be added in the future. None for now. */
+  return super_ctor (typeOf (ap_obj, "resamplerprc_class"), ap_obj, app);
+}
+
+/*
+ * initialization
+ */
+
+void *
+resampler_prc_class_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizfilterprc = tiz_get_type (ap_hdl, "tizfilterprc");
+  void * resamplerprc_class = factory_new
+    /* TIZ_CLASS_COMMENT: class type, class name, parent, size */
+    (classOf (tizfilterprc), "resamplerprc_class", classOf (tizfilterprc),
+     sizeof (resampler_prc_class_t),
+     /* TIZ_CLASS_COMMENT: */
+     ap_tos, ap_hdl,
+     /* TIZ_CLASS_COMMENT: class constructor */
+     ctor, resampler_prc_class_ctor,
+     /* TIZ_CLASS_COMMENT: stop value*/
+     0);
+  return resamplerprc_class;
+}
+
+void *
+resampler_prc_init (void * ap_tos, void * ap_hdl)
+{
+  void * tizfilterprc = tiz_get_type (ap_hdl, "tizfilterprc");
+  void * resamplerprc_class = tiz_get_type (ap_hdl, "resamplerprc_class");
+  TIZ_LOG_CLASS (resamplerprc_class);
+  void * resamplerprc = factory_new
+    /* TIZ_CLASS_COMMENT: class type, class name, parent, size */
+    (resamplerprc_class, "resamplerprc", tizfilterprc, sizeof (resampler_prc_t),
+     /* TIZ_CLASS_COMMENT: */
+     ap_tos, ap_hdl,
+     /* TIZ_CLASS_COMMENT: class constructor */
+     ctor, resampler_prc_ctor,
+     /* TIZ_CLASS_COMMENT: class destructor */
+     dtor, resampler_prc_dtor,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_allocate_resources, resampler_prc_allocate_resources,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_deallocate_resources, resampler_prc_deallocate_resources,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_prepare_to_transfer, resampler_prc_prepare_to_transfer,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_transfer_and_process, resampler_prc_transfer_and_process,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_srv_stop_and_return, resampler_prc_stop_and_return,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_buffers_ready, resampler_prc_buffers_ready,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_flush, resampler_prc_port_flush,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_enable, resampler_prc_port_enable,
+     /* TIZ_CLASS_COMMENT: */
+     tiz_prc_port_disable, resampler_prc_port_disable,
+     /* TIZ_CLASS_COMMENT: stop value */
+     0);
+
+  return resamplerprc;
+}
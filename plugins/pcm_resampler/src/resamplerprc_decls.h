@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2011-2018 Aratelia Limited - Juan A. Rubio
+ *
+ * This file is part of Tizonia
+ *
+ * Tizonia is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Tizonia is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Tizonia.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file   resamplerprc_decls.h
+ * @author Juan A. Rubio <juan.rubio@aratelia.com>
+ *
+ * @brief  Tizonia - Sample rate converter - processor class decls
+ *
+ *
+ */
+
+#ifndef RESAMPLERPRC_DECLS_H
+#define RESAMPLERPRC_DECLS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include <tizplatform.h>
+
+#include <tizfilterprc.h>
+#include <tizfilterprc_decls.h>
+
+typedef struct resampler_prc resampler_prc_t;
+struct resampler_prc
+{
+  /* Object */
+  const tiz_filter_prc_t _;
+  tiz_dsp_resampler_t * p_rs_;
+  tiz_dsp_resampler_quality_t quality_;
+  OMX_AUDIO_PARAM_PCMMODETYPE in_pcmmode_;
+  OMX_AUDIO_PARAM_PCMMODETYPE out_pcmmode_;
+  float * p_in_f32_;
+  float * p_out_f32_;
+  float * p_remix_f32_;
+  uint32_t dither_;
+  size_t drain_frames_;
+  bool draining_;
+  bool passthrough_;
+};
+
+typedef struct resampler_prc_class resampler_prc_class_t;
+struct resampler_prc_class
+{
+  /* Class */
+  const tiz_filter_prc_class_t _;
+  /* NOTE: Class methods might be added in the future */
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RESAMPLERPRC_DECLS_H */
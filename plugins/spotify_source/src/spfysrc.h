@@ -53,6 +53,7 @@ extern "C" {
 #define ARATELIA_SPOTIFY_SOURCE_DEFAULT_CACHE_SECONDS 6
 #define ARATELIA_SPOTIFY_SOURCE_MIN_CACHE_SECONDS 7
 #define ARATELIA_SPOTIFY_SOURCE_MAX_CACHE_SECONDS 12
+#define ARATELIA_SPOTIFY_SOURCE_DEFAULT_PREFETCH_SECONDS 10
 
 #ifdef __cplusplus
 }
@@ -577,6 +577,24 @@ end:
   return rc;
 }
 
+static void
+obtain_prefetch_seconds (spfysrc_prc_t * ap_prc)
+{
+  const char * p_seconds = NULL;
+  assert (ap_prc);
+
+  ap_prc->prefetch_seconds_ = ARATELIA_SPOTIFY_SOURCE_DEFAULT_PREFETCH_SECONDS;
+  p_seconds = tiz_rcfile_get_value (
+    TIZ_RCFILE_PLUGINS_DATA_SECTION,
+    "OMX.Aratelia.audio_source.spotify.prefetch_seconds");
+  if (p_seconds)
+    {
+      ap_prc->prefetch_seconds_ = MAX (0, atoi (p_seconds));
+    }
+  TIZ_TRACE (handleOf (ap_prc), "Pre-fetch seconds [%d]",
+             ap_prc->prefetch_seconds_);
+}
+
 static OMX_ERRORTYPE
 allocate_temp_data_store (spfysrc_prc_t * ap_prc)
 {
@@ -802,6 +820,60 @@ process_spotify_session_events (spfysrc_prc_t * ap_prc)
   return rc;
 }
 
+static void
+release_next_track (spfysrc_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  if (ap_prc->p_sp_next_link_)
+    {
+      sp_link_release (ap_prc->p_sp_next_link_);
+      ap_prc->p_sp_next_link_ = NULL;
+    }
+  ap_prc->played_ms_ = 0;
+  ap_prc->prefetch_done_ = false;
+}
+
+/**
+ * Asks libspotify to load the next track in the queue into its cache, once the
+ * current track is close to its end, so that the track change doesn't have to
+ * wait for the network. This is the counterpart of the http source's
+ * look-ahead transfer.
+ */
+static void
+prefetch_next_track (spfysrc_prc_t * ap_prc)
+{
+  assert (ap_prc);
+
+  if (ap_prc->prefetch_seconds_ > 0 && ap_prc->p_sp_track_
+      && !ap_prc->prefetch_done_
+      && sp_track_duration (ap_prc->p_sp_track_) - ap_prc->played_ms_
+           <= ap_prc->prefetch_seconds_ * 1000)
+    {
+      /* Peek at the next item in the queue */
+      const bool need_url_removed = false;
+      const char * p_next_url
+        = tiz_spotify_get_next_uri (ap_prc->p_spfy_web_, need_url_removed);
+      sp_link * p_link
+        = p_next_url ? sp_link_create_from_string (p_next_url) : NULL;
+      (void) tiz_spotify_get_prev_uri (ap_prc->p_spfy_web_, need_url_removed);
+
+      ap_prc->prefetch_done_ = true;
+      if (p_link)
+        {
+          sp_track * p_track = sp_link_as_track (p_link);
+          if (p_track)
+            {
+              sp_error error
+                = sp_session_player_prefetch (ap_prc->p_sp_session_, p_track);
+              TIZ_DEBUG (handleOf (ap_prc), "Pre-fetching next track : [%s]",
+                         sp_error_message (error));
+            }
+          /* The link keeps the track alive until the track changes */
+          ap_prc->p_sp_next_link_ = p_link;
+        }
+    }
+}
+
 /**
  * Called on various events to start playback if it hasn't been started already.
  *
@@ -869,6 +941,7 @@ start_playback (spfysrc_prc_t * ap_prc)
               sp_link_release (ap_prc->p_sp_link_);
             }
           ap_prc->p_sp_track_ = p_track;
+          release_next_track (ap_prc);
           sp_track_availability avail
             = sp_track_get_availability (ap_prc->p_sp_session_, p_track);
           if (SP_TRACK_AVAILABILITY_AVAILABLE == avail)
@@ -1039,6 +1112,12 @@ music_delivery_handler (OMX_PTR ap_prc, tiz_event_pluggable_t * ap_event)
              OMX_ErrorFormatNotDetected event */
           send_port_auto_detect_events (p_prc);
         }
+      if (p_data->format.sample_rate > 0)
+        {
+          p_prc->played_ms_ += ((int64_t) p_data->num_frames * 1000)
+                               / p_data->format.sample_rate;
+          prefetch_next_track (p_prc);
+        }
       tiz_mem_free (p_data->p_frames);
       tiz_mem_free (ap_event->p_data);
     }
@@ -1332,6 +1411,10 @@ spfysrc_prc_ctor (void * ap_obj, va_list * app)
 
   p_prc->p_sp_track_ = NULL;
   p_prc->p_sp_link_ = NULL;
+  p_prc->p_sp_next_link_ = NULL;
+  p_prc->played_ms_ = 0;
+  p_prc->prefetch_seconds_ = 0;
+  p_prc->prefetch_done_ = false;
   p_prc->p_spfy_web_ = NULL;
   p_prc->keep_processing_sp_events_ = false;
   p_prc->next_timeout_ = 0;
@@ -1372,6 +1455,7 @@ spfysrc_prc_allocate_resources (void * ap_prc, OMX_U32 a_pid)
 
   tiz_check_omx (enqueue_playlist_items (p_prc));
   tiz_check_omx (obtain_next_url (p_prc, 1));
+  obtain_prefetch_seconds (p_prc);
 
   /* Create a spotify session */
   p_prc->sp_config_.cache_location
@@ -1418,6 +1502,7 @@ spfysrc_prc_deallocate_resources (void * ap_prc)
       p_prc->p_session_timer_ = NULL;
     }
 
+  release_next_track (p_prc);
   (void) sp_session_release (p_prc->p_sp_session_);
   p_prc->p_sp_session_ = NULL;
   tiz_mem_free ((void *) p_prc->sp_config_.cache_location);
@@ -76,6 +76,11 @@ struct spfysrc_prc
   sp_session_callbacks sp_cbacks_;             /* The session callbacks */
   sp_track * p_sp_track_;          /* Handle to the current track */
   sp_link * p_sp_link_;            /* Handle to the current track link */
+  sp_link * p_sp_next_link_;       /* Handle to the pre-fetched track link */
+  int played_ms_;                  /* Audio delivered of the current track */
+  int prefetch_seconds_;           /* Pre-fetch the next track this long
+                                    * before the current one ends (0: never) */
+  bool prefetch_done_;             /* The next track has been pre-fetched */
   tiz_spotify_t * p_spfy_web_;     /* Tizonia's Spotify web api object */
   bool keep_processing_sp_events_; /* callback called from libspotify thread to
                                     * ask us to reiterate the main loop */
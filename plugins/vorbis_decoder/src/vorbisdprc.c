@@ -174,18 +174,6 @@ store_data (vorbisd_prc_t * ap_prc, const OMX_U8 * ap_data, OMX_U32 a_nbytes)
   return a_nbytes - nbytes_to_copy;
 }
 
-static inline void
-write_frame_float_ilv (float * to, const float * from, const int channels)
-{
-  int i = 0;
-  assert (to);
-  assert (from);
-  for (i = 0; i < channels; ++i)
-    {
-      to[i] = from[i];
-    }
-}
-
 static OMX_ERRORTYPE
 update_pcm_mode (vorbisd_prc_t * ap_prc, const OMX_U32 a_samplerate,
                  const OMX_U32 a_channels)
@@ -343,23 +331,15 @@ fishsound_decoded_callback (FishSound * ap_fsound, float * app_pcm[],
     }
 
   {
-    /* write decoded PCM samples */
-    size_t i = 0;
+    /* write decoded PCM samples; these are already interleaved, in the
+       output format */
     size_t frame_len = sizeof (float) * p_prc->fsinfo_.channels;
     size_t frames_alloc = ((p_out->nAllocLen - p_out->nOffset) / frame_len);
     size_t frames_to_write = (frames > frames_alloc) ? frames_alloc : frames;
     size_t bytes_to_write = frames_to_write * frame_len;
     assert (p_out);
 
-    for (i = 0; i < frames_to_write; ++i)
-      {
-        size_t frame_offset = i * frame_len;
-        size_t float_offset = i * p_prc->fsinfo_.channels;
-        float * out
-          = (float *) (p_out->pBuffer + p_out->nOffset + frame_offset);
-        write_frame_float_ilv (out, ((float *) app_pcm) + float_offset,
-                               p_prc->fsinfo_.channels);
-      }
+    memcpy (p_out->pBuffer + p_out->nOffset, app_pcm, bytes_to_write);
     p_out->nFilledLen += bytes_to_write;
     p_out->nOffset += bytes_to_write;
 
@@ -541,20 +521,28 @@ transform_buffer (vorbisd_prc_t * ap_prc)
 }
 
 static void
-reset_stream_parameters (vorbisd_prc_t * ap_prc)
+reset_decoder_state (vorbisd_prc_t * ap_prc)
 {
   assert (ap_prc);
-  ap_prc->started_ = false;
   if (ap_prc->p_fsnd_)
     {
       fish_sound_reset (ap_prc->p_fsnd_);
     }
-  tiz_mem_set (&(ap_prc->fsinfo_), 0, sizeof (FishSoundInfo));
   if (ap_prc->p_store_)
     {
       tiz_mem_set (ap_prc->p_store_, 0, ap_prc->store_size_);
       ap_prc->store_offset_ = 0;
     }
+  tiz_filter_prc_update_eos_flag (ap_prc, false);
+}
+
+static void
+reset_stream_parameters (vorbisd_prc_t * ap_prc)
+{
+  assert (ap_prc);
+  ap_prc->started_ = false;
+  reset_decoder_state (ap_prc);
+  tiz_mem_set (&(ap_prc->fsinfo_), 0, sizeof (FishSoundInfo));
 }
 
 static inline OMX_ERRORTYPE
@@ -563,7 +551,9 @@ do_flush (vorbisd_prc_t * ap_prc, OMX_U32 a_pid)
   assert (ap_prc);
   if (OMX_ALL == a_pid || ARATELIA_VORBIS_DECODER_INPUT_PORT_INDEX == a_pid)
     {
-      reset_stream_parameters (ap_prc);
+      /* Same stream, new position (e.g. after a seek): the headers already
+         decoded still apply */
+      reset_decoder_state (ap_prc);
     }
   /* Release any buffers held  */
   return tiz_filter_prc_release_header (ap_prc, a_pid);